@@ -0,0 +1,547 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#pragma once
+
+// Mixed-radix (2/3/4/5) split-complex FFT engine shared by the vDSP DFT and FFT entry points.
+//
+// Transforms use the Stockham autosort formulation: every stage reads one buffer and writes the other, so no bit-reversal
+// pass is needed, and the innermost loop walks the contiguous "stride" dimension with a single twiddle factor. That loop
+// is where the SIMD butterflies run; the first stage (stride 1) falls back to the scalar butterflies.
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FFT_HAS_SSE2 1
+#endif
+
+namespace FFT {
+
+// Table of the roots of unity exp(2*pi*i*k/size) for k in [0, size).
+// A transform of any length dividing size reads the table with a stride of size/length.
+template <typename T>
+struct TwiddleTable {
+    explicit TwiddleTable(size_t tableSize) : size(tableSize), cosines(tableSize), sines(tableSize) {
+        for (size_t k = 0; k < tableSize; ++k) {
+            double angle = 2.0 * M_PI * static_cast<double>(k) / static_cast<double>(tableSize);
+            cosines[k] = static_cast<T>(cos(angle));
+            sines[k] = static_cast<T>(sin(angle));
+        }
+    }
+
+    size_t size;
+    std::vector<T> cosines;
+    std::vector<T> sines;
+};
+
+// Splits length into the radices supported by the butterflies, preferring radix-4 stages.
+// Returns false if length has a prime factor other than 2, 3 or 5.
+inline bool Factorize(size_t length, std::vector<unsigned>& radices) {
+    radices.clear();
+    if (length == 0) {
+        return false;
+    }
+
+    while (length % 4 == 0) {
+        radices.push_back(4);
+        length /= 4;
+    }
+    if (length % 2 == 0) {
+        radices.push_back(2);
+        length /= 2;
+    }
+    while (length % 3 == 0) {
+        radices.push_back(3);
+        length /= 3;
+    }
+    while (length % 5 == 0) {
+        radices.push_back(5);
+        length /= 5;
+    }
+
+    return length == 1;
+}
+
+// Precomputed state for complex transforms of a single length. Real transforms of length 2 * n use a plan with
+// length n and a twiddle table of size 2 * n.
+template <typename T>
+struct Plan {
+    Plan(size_t complexLength, size_t tableSize) : length(complexLength), table(tableSize ? tableSize : 1) {
+        valid = Factorize(complexLength, radices);
+    }
+
+    size_t length;
+    bool valid;
+    std::vector<unsigned> radices;
+    TwiddleTable<T> table;
+};
+
+// Vector abstraction used by the butterflies. ScalarOps is the portable fallback; the SSE2 variants process 4 floats or
+// 2 doubles per operation.
+template <typename T>
+struct ScalarOps {
+    typedef T V;
+    static const size_t width = 1;
+    static V load(const T* p) {
+        return *p;
+    }
+    static void store(T* p, V v) {
+        *p = v;
+    }
+    static V splat(T x) {
+        return x;
+    }
+    static V add(V a, V b) {
+        return a + b;
+    }
+    static V sub(V a, V b) {
+        return a - b;
+    }
+    static V mul(V a, V b) {
+        return a * b;
+    }
+};
+
+template <typename T>
+struct SimdOps : ScalarOps<T> {};
+
+#ifdef FFT_HAS_SSE2
+template <>
+struct SimdOps<float> {
+    typedef __m128 V;
+    static const size_t width = 4;
+    static V load(const float* p) {
+        return _mm_loadu_ps(p);
+    }
+    static void store(float* p, V v) {
+        _mm_storeu_ps(p, v);
+    }
+    static V splat(float x) {
+        return _mm_set1_ps(x);
+    }
+    static V add(V a, V b) {
+        return _mm_add_ps(a, b);
+    }
+    static V sub(V a, V b) {
+        return _mm_sub_ps(a, b);
+    }
+    static V mul(V a, V b) {
+        return _mm_mul_ps(a, b);
+    }
+};
+
+template <>
+struct SimdOps<double> {
+    typedef __m128d V;
+    static const size_t width = 2;
+    static V load(const double* p) {
+        return _mm_loadu_pd(p);
+    }
+    static void store(double* p, V v) {
+        _mm_storeu_pd(p, v);
+    }
+    static V splat(double x) {
+        return _mm_set1_pd(x);
+    }
+    static V add(V a, V b) {
+        return _mm_add_pd(a, b);
+    }
+    static V sub(V a, V b) {
+        return _mm_sub_pd(a, b);
+    }
+    static V mul(V a, V b) {
+        return _mm_mul_pd(a, b);
+    }
+};
+#endif
+
+// Multiplies (re, im) by -i for forward transforms and by +i for inverse transforms.
+template <typename Ops, bool Inverse>
+inline void RotateQuarter(typename Ops::V& re, typename Ops::V& im) {
+    typename Ops::V zero = Ops::splat(0);
+    typename Ops::V t = re;
+    if (Inverse) {
+        re = Ops::sub(zero, im);
+        im = t;
+    } else {
+        re = im;
+        im = Ops::sub(zero, t);
+    }
+}
+
+// In-register DFTs of size 2, 3, 4 and 5. Inputs are consumed, outputs are written to (br, bi).
+template <typename T, typename Ops, bool Inverse, unsigned Radix>
+struct SmallDFT;
+
+template <typename T, typename Ops, bool Inverse>
+struct SmallDFT<T, Ops, Inverse, 2> {
+    typedef typename Ops::V V;
+    static void Run(V* ar, V* ai, V* br, V* bi) {
+        br[0] = Ops::add(ar[0], ar[1]);
+        bi[0] = Ops::add(ai[0], ai[1]);
+        br[1] = Ops::sub(ar[0], ar[1]);
+        bi[1] = Ops::sub(ai[0], ai[1]);
+    }
+};
+
+template <typename T, typename Ops, bool Inverse>
+struct SmallDFT<T, Ops, Inverse, 3> {
+    typedef typename Ops::V V;
+    static void Run(V* ar, V* ai, V* br, V* bi) {
+        const V half = Ops::splat(static_cast<T>(0.5));
+        const V sin60 = Ops::splat(static_cast<T>(0.86602540378443864676));
+
+        V sumr = Ops::add(ar[1], ar[2]);
+        V sumi = Ops::add(ai[1], ai[2]);
+        V difr = Ops::mul(sin60, Ops::sub(ar[1], ar[2]));
+        V difi = Ops::mul(sin60, Ops::sub(ai[1], ai[2]));
+        V midr = Ops::sub(ar[0], Ops::mul(half, sumr));
+        V midi = Ops::sub(ai[0], Ops::mul(half, sumi));
+
+        RotateQuarter<Ops, Inverse>(difr, difi);
+
+        br[0] = Ops::add(ar[0], sumr);
+        bi[0] = Ops::add(ai[0], sumi);
+        br[1] = Ops::add(midr, difr);
+        bi[1] = Ops::add(midi, difi);
+        br[2] = Ops::sub(midr, difr);
+        bi[2] = Ops::sub(midi, difi);
+    }
+};
+
+template <typename T, typename Ops, bool Inverse>
+struct SmallDFT<T, Ops, Inverse, 4> {
+    typedef typename Ops::V V;
+    static void Run(V* ar, V* ai, V* br, V* bi) {
+        V s02r = Ops::add(ar[0], ar[2]);
+        V s02i = Ops::add(ai[0], ai[2]);
+        V d02r = Ops::sub(ar[0], ar[2]);
+        V d02i = Ops::sub(ai[0], ai[2]);
+        V s13r = Ops::add(ar[1], ar[3]);
+        V s13i = Ops::add(ai[1], ai[3]);
+        V d13r = Ops::sub(ar[1], ar[3]);
+        V d13i = Ops::sub(ai[1], ai[3]);
+
+        RotateQuarter<Ops, Inverse>(d13r, d13i);
+
+        br[0] = Ops::add(s02r, s13r);
+        bi[0] = Ops::add(s02i, s13i);
+        br[1] = Ops::add(d02r, d13r);
+        bi[1] = Ops::add(d02i, d13i);
+        br[2] = Ops::sub(s02r, s13r);
+        bi[2] = Ops::sub(s02i, s13i);
+        br[3] = Ops::sub(d02r, d13r);
+        bi[3] = Ops::sub(d02i, d13i);
+    }
+};
+
+template <typename T, typename Ops, bool Inverse>
+struct SmallDFT<T, Ops, Inverse, 5> {
+    typedef typename Ops::V V;
+    static void Run(V* ar, V* ai, V* br, V* bi) {
+        const V c1 = Ops::splat(static_cast<T>(0.30901699437494742410));
+        const V c2 = Ops::splat(static_cast<T>(-0.80901699437494742410));
+        const V s1 = Ops::splat(static_cast<T>(0.95105651629515357212));
+        const V s2 = Ops::splat(static_cast<T>(0.58778525229247312917));
+
+        V t1r = Ops::add(ar[1], ar[4]);
+        V t1i = Ops::add(ai[1], ai[4]);
+        V t2r = Ops::add(ar[2], ar[3]);
+        V t2i = Ops::add(ai[2], ai[3]);
+        V t3r = Ops::sub(ar[1], ar[4]);
+        V t3i = Ops::sub(ai[1], ai[4]);
+        V t4r = Ops::sub(ar[2], ar[3]);
+        V t4i = Ops::sub(ai[2], ai[3]);
+
+        V m1r = Ops::add(ar[0], Ops::add(Ops::mul(c1, t1r), Ops::mul(c2, t2r)));
+        V m1i = Ops::add(ai[0], Ops::add(Ops::mul(c1, t1i), Ops::mul(c2, t2i)));
+        V m2r = Ops::add(ar[0], Ops::add(Ops::mul(c2, t1r), Ops::mul(c1, t2r)));
+        V m2i = Ops::add(ai[0], Ops::add(Ops::mul(c2, t1i), Ops::mul(c1, t2i)));
+
+        V n1r = Ops::add(Ops::mul(s1, t3r), Ops::mul(s2, t4r));
+        V n1i = Ops::add(Ops::mul(s1, t3i), Ops::mul(s2, t4i));
+        V n2r = Ops::sub(Ops::mul(s2, t3r), Ops::mul(s1, t4r));
+        V n2i = Ops::sub(Ops::mul(s2, t3i), Ops::mul(s1, t4i));
+
+        RotateQuarter<Ops, Inverse>(n1r, n1i);
+        RotateQuarter<Ops, Inverse>(n2r, n2i);
+
+        br[0] = Ops::add(ar[0], Ops::add(t1r, t2r));
+        bi[0] = Ops::add(ai[0], Ops::add(t1i, t2i));
+        br[1] = Ops::add(m1r, n1r);
+        bi[1] = Ops::add(m1i, n1i);
+        br[4] = Ops::sub(m1r, n1r);
+        bi[4] = Ops::sub(m1i, n1i);
+        br[2] = Ops::add(m2r, n2r);
+        bi[2] = Ops::add(m2i, n2i);
+        br[3] = Ops::sub(m2r, n2r);
+        bi[3] = Ops::sub(m2i, n2i);
+    }
+};
+
+// Runs one radix-Radix butterfly on Ops::width consecutive values of the stride dimension.
+// Input element r is read at offset r * inputSpan, output element t is written at offset t * outputSpan and multiplied by
+// the twiddle (wr[t], wi[t]) for t >= 1.
+template <typename T, typename Ops, bool Inverse, unsigned Radix>
+inline void Butterfly(const T* inR,
+                      const T* inI,
+                      size_t inputSpan,
+                      T* outR,
+                      T* outI,
+                      size_t outputSpan,
+                      const typename Ops::V* wr,
+                      const typename Ops::V* wi) {
+    typedef typename Ops::V V;
+    V ar[Radix], ai[Radix], br[Radix], bi[Radix];
+    for (unsigned r = 0; r < Radix; ++r) {
+        ar[r] = Ops::load(inR + r * inputSpan);
+        ai[r] = Ops::load(inI + r * inputSpan);
+    }
+
+    SmallDFT<T, Ops, Inverse, Radix>::Run(ar, ai, br, bi);
+
+    Ops::store(outR, br[0]);
+    Ops::store(outI, bi[0]);
+    for (unsigned t = 1; t < Radix; ++t) {
+        Ops::store(outR + t * outputSpan, Ops::sub(Ops::mul(br[t], wr[t]), Ops::mul(bi[t], wi[t])));
+        Ops::store(outI + t * outputSpan, Ops::add(Ops::mul(br[t], wi[t]), Ops::mul(bi[t], wr[t])));
+    }
+}
+
+// One Stockham stage: sub-transform length `length`, already-processed stride `stride`.
+template <typename T, bool Inverse, unsigned Radix>
+void Stage(const TwiddleTable<T>& table, size_t length, size_t stride, const T* srcR, const T* srcI, T* dstR, T* dstI) {
+    typedef SimdOps<T> Wide;
+    typedef ScalarOps<T> Narrow;
+
+    const size_t m = length / Radix;
+    const size_t step = table.size / length;
+
+    for (size_t j = 0; j < m; ++j) {
+        typename Wide::V wideR[Radix], wideI[Radix];
+        typename Narrow::V narrowR[Radix], narrowI[Radix];
+        for (unsigned t = 1; t < Radix; ++t) {
+            size_t index = j * t * step;
+            T c = table.cosines[index];
+            T s = Inverse ? table.sines[index] : -table.sines[index];
+            wideR[t] = Wide::splat(c);
+            wideI[t] = Wide::splat(s);
+            narrowR[t] = c;
+            narrowI[t] = s;
+        }
+
+        const T* inR = srcR + stride * j;
+        const T* inI = srcI + stride * j;
+        T* outR = dstR + stride * Radix * j;
+        T* outI = dstI + stride * Radix * j;
+
+        size_t q = 0;
+        if (Wide::width > 1) {
+            for (; q + Wide::width <= stride; q += Wide::width) {
+                Butterfly<T, Wide, Inverse, Radix>(inR + q, inI + q, stride * m, outR + q, outI + q, stride, wideR, wideI);
+            }
+        }
+        for (; q < stride; ++q) {
+            Butterfly<T, Narrow, Inverse, Radix>(inR + q, inI + q, stride * m, outR + q, outI + q, stride, narrowR, narrowI);
+        }
+    }
+}
+
+template <typename T, bool Inverse>
+void RunStage(
+    unsigned radix, const TwiddleTable<T>& table, size_t length, size_t stride, const T* srcR, const T* srcI, T* dstR, T* dstI) {
+    switch (radix) {
+        case 2:
+            Stage<T, Inverse, 2>(table, length, stride, srcR, srcI, dstR, dstI);
+            break;
+        case 3:
+            Stage<T, Inverse, 3>(table, length, stride, srcR, srcI, dstR, dstI);
+            break;
+        case 4:
+            Stage<T, Inverse, 4>(table, length, stride, srcR, srcI, dstR, dstI);
+            break;
+        case 5:
+            Stage<T, Inverse, 5>(table, length, stride, srcR, srcI, dstR, dstI);
+            break;
+    }
+}
+
+// Unnormalized complex transform of `length` contiguous split-complex values, exp(-2*pi*i*k*n/length) for the forward
+// direction and exp(+2*pi*i*k*n/length) for the inverse. table.size must be a multiple of length. Input and output may
+// alias.
+template <typename T>
+void Complex(const TwiddleTable<T>& table,
+             const std::vector<unsigned>& radices,
+             size_t length,
+             const T* inR,
+             const T* inI,
+             T* outR,
+             T* outI,
+             bool inverse) {
+    if (length == 0) {
+        return;
+    }
+
+    const size_t stages = radices.size();
+    if (stages == 0) {
+        outR[0] = inR[0];
+        outI[0] = inI[0];
+        return;
+    }
+
+    std::vector<T> scratch(2 * length);
+    T* scratchR = &scratch[0];
+    T* scratchI = scratchR + length;
+
+    // Ping-pong between the output and the scratch buffer so that the last stage lands in the output.
+    T* bufR[2] = { outR, scratchR };
+    T* bufI[2] = { outI, scratchI };
+    size_t target = (stages % 2 == 1) ? 0 : 1;
+
+    const T* srcR = inR;
+    const T* srcI = inI;
+    if (target == 0 && (inR == outR || inI == outI)) {
+        memcpy(scratchR, inR, length * sizeof(T));
+        memcpy(scratchI, inI, length * sizeof(T));
+        srcR = scratchR;
+        srcI = scratchI;
+    }
+
+    size_t subLength = length;
+    size_t stride = 1;
+    for (size_t s = 0; s < stages; ++s) {
+        unsigned radix = radices[s];
+        if (inverse) {
+            RunStage<T, true>(radix, table, subLength, stride, srcR, srcI, bufR[target], bufI[target]);
+        } else {
+            RunStage<T, false>(radix, table, subLength, stride, srcR, srcI, bufR[target], bufI[target]);
+        }
+
+        srcR = bufR[target];
+        srcI = bufI[target];
+        target ^= 1;
+        subLength /= radix;
+        stride *= radix;
+    }
+}
+
+// Forward real transform of 2 * half real samples packed as (even, odd) pairs in (inR, inI).
+// Produces 2 * X[k] for k in [0, half) in the vDSP packed layout: outI[0] holds 2 * X[half] (the Nyquist term).
+// table.size must be a multiple of 2 * half.
+template <typename T>
+void RealForward(const TwiddleTable<T>& table,
+                 const std::vector<unsigned>& halfRadices,
+                 size_t half,
+                 const T* inR,
+                 const T* inI,
+                 T* outR,
+                 T* outI) {
+    if (half == 0) {
+        return;
+    }
+
+    Complex(table, halfRadices, half, inR, inI, outR, outI, false);
+
+    const size_t step = table.size / (2 * half);
+    T dc = outR[0];
+    T nyquist = outI[0];
+    outR[0] = 2 * (dc + nyquist);
+    outI[0] = 2 * (dc - nyquist);
+
+    // Bins k and half - k are combined together so the split can be done in place.
+    for (size_t k = 1; k <= half / 2; ++k) {
+        size_t mirror = half - k;
+        T zr = outR[k], zi = outI[k];
+        T cr = outR[mirror], ci = -outI[mirror];
+
+        // E = Z[k] + conj(Z[half-k]); D = Z[k] - conj(Z[half-k]); 2X[k] = E - i * W^k * D, W = exp(-2*pi*i/(2*half))
+        T er = zr + cr, ei = zi + ci;
+        T dr = zr - cr, di = zi - ci;
+        T wr = table.cosines[k * step], wi = -table.sines[k * step];
+        T pr = dr * wr - di * wi;
+        T pi = dr * wi + di * wr;
+
+        T xr = er + pi;
+        T xi = ei - pr;
+
+        if (mirror != k) {
+            // Same expression evaluated for the mirrored bin.
+            T mer = cr, mei = -ci;
+            T mcr = zr, mci = -zi;
+            T fer = mer + mcr, fei = mei + mci;
+            T fdr = mer - mcr, fdi = mei - mci;
+            T mwr = table.cosines[mirror * step], mwi = -table.sines[mirror * step];
+            T mpr = fdr * mwr - fdi * mwi;
+            T mpi = fdr * mwi + fdi * mwr;
+            outR[mirror] = fer + mpi;
+            outI[mirror] = fei - mpr;
+        }
+
+        outR[k] = xr;
+        outI[k] = xi;
+    }
+}
+
+// Inverse of RealForward's packing: takes the half-spectrum X[k] for k in [0, half) with inI[0] holding X[half], and
+// produces sum_k X[k] * exp(+2*pi*i*k*n/(2*half)) over the full Hermitian spectrum, packed as (even, odd) pairs.
+template <typename T>
+void RealInverse(const TwiddleTable<T>& table,
+                 const std::vector<unsigned>& halfRadices,
+                 size_t half,
+                 const T* inR,
+                 const T* inI,
+                 T* outR,
+                 T* outI) {
+    if (half == 0) {
+        return;
+    }
+
+    const size_t step = table.size / (2 * half);
+    T dc = inR[0];
+    T nyquist = inI[0];
+
+    std::vector<T> packed(2 * half);
+    T* zR = &packed[0];
+    T* zI = zR + half;
+
+    zR[0] = dc + nyquist;
+    zI[0] = dc - nyquist;
+
+    // Z'[k] = (X[k] + conj(X[half-k])) + i * W^-k * (X[k] - conj(X[half-k]))
+    for (size_t k = 1; k < half; ++k) {
+        size_t mirror = half - k;
+        T xr = inR[k], xi = inI[k];
+        T cr = inR[mirror], ci = -inI[mirror];
+
+        T er = xr + cr, ei = xi + ci;
+        T dr = xr - cr, di = xi - ci;
+        T wr = table.cosines[k * step], wi = table.sines[k * step];
+        T pr = dr * wr - di * wi;
+        T pi = dr * wi + di * wr;
+
+        zR[k] = er - pi;
+        zI[k] = ei + pr;
+    }
+
+    Complex(table, halfRadices, half, zR, zI, outR, outI, true);
+}
+
+} // namespace FFT
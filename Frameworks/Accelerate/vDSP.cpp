@@ -20,9 +20,16 @@
 #include <cmath>
 #include <algorithm>
 #include "Accelerate\vDSP.h"
+#include "FFTEngine.h"
+#include "vDSPKernels.h"
 
 
 void vDSP_vabs(const float* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Length N) {
+    if (IA == 1 && IC == 1) {
+        vDSPKernels::Get().f.abs(A, C, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         C[i*IC] = abs(A[i*IA]);
     }
@@ -30,6 +37,11 @@ void vDSP_vabs(const float* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Le
 
 
 void vDSP_vabsD(const double* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDSP_Length N) {
+    if (IA == 1 && IC == 1) {
+        vDSPKernels::Get().d.abs(A, C, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         C[i*IC] = abs(A[i*IA]);
     }
@@ -72,6 +84,11 @@ void vDSP_vnabsD(const double* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDS
 
 
 void vDSP_vneg(const float* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Length N) {
+    if (IA == 1 && IC == 1) {
+        vDSPKernels::Get().f.neg(A, C, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         C[i*IC] = -A[i*IA];
     }
@@ -79,6 +96,11 @@ void vDSP_vneg(const float* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Le
 
 
 void vDSP_vnegD(const double* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDSP_Length N) {
+    if (IA == 1 && IC == 1) {
+        vDSPKernels::Get().d.neg(A, C, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         C[i*IC] = -A[i*IA];
     }
@@ -278,6 +300,11 @@ void vDSP_vgenD(const double* A, const double* B, double* C, vDSP_Stride IC, vDS
 
 
 void vDSP_vsq(const float* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Length N) {
+    if (IA == 1 && IC == 1) {
+        vDSPKernels::Get().f.mul(A, A, C, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         C[i*IC] = A[i*IA] * A[i*IA];
     }
@@ -285,6 +312,11 @@ void vDSP_vsq(const float* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Len
 
 
 void vDSP_vsqD(const double* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDSP_Length N) {
+    if (IA == 1 && IC == 1) {
+        vDSPKernels::Get().d.mul(A, A, C, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         C[i*IC] = A[i*IA] * A[i*IA];
     }
@@ -351,6 +383,11 @@ void vDSP_vfracD(const double* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDS
 void vDSP_vclip(const float* A, vDSP_Stride IA, const float* B, const float* C, float* D, vDSP_Stride ID, vDSP_Length N) {
     float b = *B;
     float c = *C;
+    if (IA == 1 && ID == 1) {
+        vDSPKernels::Get().f.clip(A, b, c, D, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         D[i*ID] = (A[i*IA] < b) ? b : ((A[i*IA] > c) ? c : A[i*IA]);
     }
@@ -360,6 +397,11 @@ void vDSP_vclip(const float* A, vDSP_Stride IA, const float* B, const float* C,
 void vDSP_vclipD(const double* A, vDSP_Stride IA, const double* B, const double* C, double* D, vDSP_Stride ID, vDSP_Length N) {
     double b = *B;
     double c = *C;
+    if (IA == 1 && ID == 1) {
+        vDSPKernels::Get().d.clip(A, b, c, D, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         D[i*ID] = (A[i*IA] < b) ? b : ((A[i*IA] > c) ? c : A[i*IA]);
     }
@@ -672,6 +714,11 @@ void vDSP_vdbconD(const double *A, vDSP_Stride IA, const double *B, double *C, v
 
 void vDSP_vsadd(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N) {
     float b = *B;
+    if (IA == 1 && IC == 1) {
+        vDSPKernels::Get().f.scalarAdd(A, b, C, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         C[i*IC] = A[i*IA] + b;
     }
@@ -680,6 +727,11 @@ void vDSP_vsadd(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_S
 
 void vDSP_vsaddD(const double *A, vDSP_Stride IA, const double *B, double *C, vDSP_Stride IC, vDSP_Length N) {
     double b = *B;
+    if (IA == 1 && IC == 1) {
+        vDSPKernels::Get().d.scalarAdd(A, b, C, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         C[i*IC] = A[i*IA] + b;
     }
@@ -696,6 +748,11 @@ void vDSP_vsaddi(const int *A, vDSP_Stride IA, const int *B, int *C, vDSP_Stride
 
 void vDSP_vsmul(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N) {
     float b = *B;
+    if (IA == 1 && IC == 1) {
+        vDSPKernels::Get().f.scalarMul(A, b, C, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         C[i*IC] = A[i*IA] * b;
     }
@@ -704,6 +761,11 @@ void vDSP_vsmul(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_S
 
 void vDSP_vsmulD(const double *A, vDSP_Stride IA, const double *B, double *C, vDSP_Stride IC, vDSP_Length N) {
     double b = *B;
+    if (IA == 1 && IC == 1) {
+        vDSPKernels::Get().d.scalarMul(A, b, C, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         C[i*IC] = A[i*IA] * b;
     }
@@ -733,6 +795,11 @@ void vDSP_zvzsmlD(const DSPDoubleSplitComplex *A, vDSP_Stride IA, const DSPDoubl
 
 
 void vDSP_vadd(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N) {
+    if (IA == 1 && IB == 1 && IC == 1) {
+        vDSPKernels::Get().f.add(A, B, C, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         C[i*IC] = A[i*IA] + B[i*IB];
     }
@@ -740,6 +807,11 @@ void vDSP_vadd(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, f
 
 
 void vDSP_vaddD(const double *A, vDSP_Stride IA, const double *B, vDSP_Stride IB, double *C, vDSP_Stride IC, vDSP_Length N) {
+    if (IA == 1 && IB == 1 && IC == 1) {
+        vDSPKernels::Get().d.add(A, B, C, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         C[i*IC] = A[i*IA] + B[i*IB];
     }
@@ -764,6 +836,11 @@ void vDSP_vasmD(const double *A, vDSP_Stride IA, const double *B, vDSP_Stride IB
 
 
 void vDSP_vmul(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N) {
+    if (IA == 1 && IB == 1 && IC == 1) {
+        vDSPKernels::Get().f.mul(A, B, C, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         C[i*IC] = A[i*IA] * B[i*IB];
     }
@@ -771,6 +848,11 @@ void vDSP_vmul(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, f
 
 
 void vDSP_vmulD(const double *A, vDSP_Stride IA, const double *B, vDSP_Stride IB, double *C, vDSP_Stride IC, vDSP_Length N) {
+    if (IA == 1 && IB == 1 && IC == 1) {
+        vDSPKernels::Get().d.mul(A, B, C, N);
+        return;
+    }
+
     for (vDSP_Length i = 0; i < N; ++i) {
         C[i*IC] = A[i*IA] * B[i*IB];
     }
@@ -778,7 +860,12 @@ void vDSP_vmulD(const double *A, vDSP_Stride IA, const double *B, vDSP_Stride IB
 
 
 void vDSP_maxv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N) {
-    float c = FLT_MIN;
+    if (IA == 1) {
+        *C = vDSPKernels::Get().f.max(A, N);
+        return;
+    }
+
+    float c = -INFINITY;
     for (vDSP_Length i = 0; i < N; ++i) {
         if (c < A[i*IA]) {
             c = A[i*IA];
@@ -789,7 +876,12 @@ void vDSP_maxv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N) {
 
 
 void vDSP_maxvD(const double *A, vDSP_Stride IA, double *C, vDSP_Length N) {
-    double c = DBL_MIN;
+    if (IA == 1) {
+        *C = vDSPKernels::Get().d.max(A, N);
+        return;
+    }
+
+    double c = -INFINITY;
     for (vDSP_Length i = 0; i < N; ++i) {
         if (c < A[i*IA]) {
             c = A[i*IA];
@@ -804,9 +896,13 @@ void vDSP_measqv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N) {
     float t;
     if (N > 0) {
         float scale = 1.0f / sqrtf(static_cast<float>(N));
-        for (vDSP_Length i = 0; i < N; ++i) {
-            t = A[i*IA] * scale;
-            c += t*t;
+        if (IA == 1) {
+            c = vDSPKernels::Get().f.sumOfSquares(A, scale, N);
+        } else {
+            for (vDSP_Length i = 0; i < N; ++i) {
+                t = A[i*IA] * scale;
+                c += t*t;
+            }
         }
 
         *C = c;
@@ -821,9 +917,13 @@ void vDSP_measqvD(const double *A, vDSP_Stride IA, double *C, vDSP_Length N) {
     double t;
     if (N > 0) {
         double scale = 1.0 / sqrt(N);
-        for (vDSP_Length i = 0; i < N; ++i) {
-            t = A[i*IA] * scale;
-            c += t*t;
+        if (IA == 1) {
+            c = vDSPKernels::Get().d.sumOfSquares(A, scale, N);
+        } else {
+            for (vDSP_Length i = 0; i < N; ++i) {
+                t = A[i*IA] * scale;
+                c += t*t;
+            }
         }
 
         *C = c;
@@ -838,17 +938,25 @@ void vDSP_rmsqv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N) {
     float t;
     if (N > 0) {
         float max = FP_ZERO;
-        for (vDSP_Length i = 0; i < N; ++i) {
-            float val = fabs(A[i*IA]);
-            if (val > max) {
-                max = val;
+        if (IA == 1) {
+            max = vDSPKernels::Get().f.maxMagnitude(A, N);
+        } else {
+            for (vDSP_Length i = 0; i < N; ++i) {
+                float val = fabs(A[i*IA]);
+                if (val > max) {
+                    max = val;
+                }
             }
         }
         if (max > 0) {
             float scale = 1.0f / (max * sqrtf(static_cast<float>(N)));
-            for (vDSP_Length i = 0; i < N; ++i) {
-                t = A[i*IA] * scale;
-                c += t*t;
+            if (IA == 1) {
+                c = vDSPKernels::Get().f.sumOfSquares(A, scale, N);
+            } else {
+                for (vDSP_Length i = 0; i < N; ++i) {
+                    t = A[i*IA] * scale;
+                    c += t*t;
+                }
             }
             c = sqrt(c) * max;
         }
@@ -865,17 +973,25 @@ void vDSP_rmsqvD(const double *A, vDSP_Stride IA, double *C, vDSP_Length N) {
     double t;
     if (N > 0) {
         double max = FP_ZERO;
-        for (vDSP_Length i = 0; i < N; ++i) {
-            double val = fabs(A[i*IA]);
-            if (val > max) {
-                max = val;
+        if (IA == 1) {
+            max = vDSPKernels::Get().d.maxMagnitude(A, N);
+        } else {
+            for (vDSP_Length i = 0; i < N; ++i) {
+                double val = fabs(A[i*IA]);
+                if (val > max) {
+                    max = val;
+                }
             }
         }
         if (max > 0) {
             double scale = 1.0 / (max * sqrt(N));
-            for (vDSP_Length i = 0; i < N; ++i) {
-                t = A[i*IA] * scale;
-                c += t*t;
+            if (IA == 1) {
+                c = vDSPKernels::Get().d.sumOfSquares(A, scale, N);
+            } else {
+                for (vDSP_Length i = 0; i < N; ++i) {
+                    t = A[i*IA] * scale;
+                    c += t*t;
+                }
             }
             c = sqrt(c) * max;
         }
@@ -932,289 +1048,301 @@ static inline int isValidDFTLength(vDSP_Length length, unsigned int minLength) {
 }
 
 
-//Creates a setup object to be used for complex-to-complex single-precision DFT/IDFT computation
-vDSP_DFT_Setup vDSP_DFT_zop_CreateSetup(vDSP_DFT_Setup __Previous, vDSP_Length __Length, vDSP_DFT_Direction __Direction) {
-    vDSP_DFT_Setup DFTObject;
-    if (!__Previous) {
-        DFTObject = new vDSP_DFT_SetupStruct;
-    } else {
-        DFTObject = __Previous;
-    }
-
-    if (!DFTObject || __Length <= 0 || (__Direction != vDSP_DFT_FORWARD && __Direction != vDSP_DFT_INVERSE)) {
+//Shared implementation of the DFT setup creation for both precisions. The setup owns an FFT plan holding the
+//factorization of the transform length and its twiddle factors; real-to-complex setups plan a half-length complex
+//transform. When a previous setup is passed in it is reused, and its plan is kept if it already matches.
+template <typename T, typename SetupStruct>
+static SetupStruct* createDFTSetup(SetupStruct* previous,
+                                   vDSP_Length length,
+                                   vDSP_DFT_Direction direction,
+                                   vDSP_DFT_TransformType type,
+                                   unsigned int minLength) {
+    if (length <= 0 || (direction != vDSP_DFT_FORWARD && direction != vDSP_DFT_INVERSE)) {
         return nullptr;
     }
 
     //Check for length requirements - Power of Two (or) Power of Two multiplied by 3, 5, or 15
-    if (!isValidDFTLength(__Length, 8)) {
+    if (!isValidDFTLength(length, minLength)) {
         return nullptr;
     }
 
-    DFTObject->transformLength = __Length;
-    DFTObject->transformDirection = __Direction;
-    DFTObject->transformType = ZOP;
-    return DFTObject;
+    SetupStruct* setup = previous;
+    if (!setup) {
+        setup = new SetupStruct;
+        setup->transformPlan = nullptr;
+    }
+
+    size_t complexLength = (type == ZOP) ? length : length / 2;
+    FFT::Plan<T>* plan = static_cast<FFT::Plan<T>*>(setup->transformPlan);
+    if (!plan || plan->length != complexLength || plan->table.size != length) {
+        delete plan;
+        setup->transformPlan = new FFT::Plan<T>(complexLength, length);
+    }
+
+    setup->transformLength = length;
+    setup->transformDirection = direction;
+    setup->transformType = type;
+    return setup;
 }
 
 
-//Creates a setup object to be used for complex-to-complex double-precision DFT/IDFT computation
-vDSP_DFT_SetupD vDSP_DFT_zop_CreateSetupD(vDSP_DFT_SetupD __Previous, vDSP_Length __Length, vDSP_DFT_Direction __Direction) {
-    vDSP_DFT_SetupD DFTDObject;
-    if (!__Previous) {
-        DFTDObject = new vDSP_DFT_SetupStructD;
-    } else {
-        DFTDObject = __Previous;
+//Shared implementation of the DFT execution for both precisions
+template <typename T, typename SetupStruct>
+static void executeDFT(const SetupStruct* setup, const T* Ir, const T* Ii, T* Or, T* Oi) {
+    if (!setup || !setup->transformPlan) {
+        return;
     }
 
-    if (!DFTDObject || __Length <= 0 || (__Direction != vDSP_DFT_FORWARD && __Direction != vDSP_DFT_INVERSE)) {
-        return nullptr;
+    const FFT::Plan<T>* plan = static_cast<const FFT::Plan<T>*>(setup->transformPlan);
+    if (setup->transformType == ZOP) {
+        FFT::Complex(plan->table, plan->radices, plan->length, Ir, Ii, Or, Oi, setup->transformDirection == vDSP_DFT_INVERSE);
+    } else if (setup->transformType == ZROP) {
+        //Even samples are in Ir and odd samples in Ii. Forward results are scaled by 2 and the Nyquist term is
+        //returned in Oi[0]; the inverse reads the Nyquist term from Ii[0] in the same way.
+        if (setup->transformDirection == vDSP_DFT_FORWARD) {
+            FFT::RealForward(plan->table, plan->radices, plan->length, Ir, Ii, Or, Oi);
+        } else {
+            FFT::RealInverse(plan->table, plan->radices, plan->length, Ir, Ii, Or, Oi);
+        }
     }
+}
 
-    //Check for length requirements - Power of Two (or) Power of Two multiplied by 3, 5, or 15
-    if (!isValidDFTLength(__Length, 8)) {
-        return nullptr;
+
+//Shared implementation of the DFT setup destruction for both precisions
+template <typename T, typename SetupStruct>
+static void destroyDFTSetup(SetupStruct* setup) {
+    if (setup) {
+        delete static_cast<FFT::Plan<T>*>(setup->transformPlan);
+        delete setup;
     }
+}
+
+
+//Creates a setup object to be used for complex-to-complex single-precision DFT/IDFT computation
+vDSP_DFT_Setup vDSP_DFT_zop_CreateSetup(vDSP_DFT_Setup __Previous, vDSP_Length __Length, vDSP_DFT_Direction __Direction) {
+    return createDFTSetup<float>(__Previous, __Length, __Direction, ZOP, 8);
+}
 
-    DFTDObject->transformLength = __Length;
-    DFTDObject->transformDirection = __Direction;
-    DFTDObject->transformType = ZOP;
-    return DFTDObject;
+
+//Creates a setup object to be used for complex-to-complex double-precision DFT/IDFT computation
+vDSP_DFT_SetupD vDSP_DFT_zop_CreateSetupD(vDSP_DFT_SetupD __Previous, vDSP_Length __Length, vDSP_DFT_Direction __Direction) {
+    return createDFTSetup<double>(__Previous, __Length, __Direction, ZOP, 8);
 }
 
 
 //Creates a setup object to be used for real-to-complex (complex-to-real) single-precision DFT (IDFT) computation
 vDSP_DFT_Setup vDSP_DFT_zrop_CreateSetup(vDSP_DFT_Setup __Previous, vDSP_Length __Length, vDSP_DFT_Direction __Direction) {
-    vDSP_DFT_Setup DFTObject;
-    if (!__Previous) {
-        DFTObject = new vDSP_DFT_SetupStruct;
-    } else {
-        DFTObject = __Previous;
-    }
+    return createDFTSetup<float>(__Previous, __Length, __Direction, ZROP, 16);
+}
 
-    if (!DFTObject || __Length <= 0 || (__Direction != vDSP_DFT_FORWARD && __Direction != vDSP_DFT_INVERSE)) {
-        return nullptr;
-    }
 
-    //Check for length requirements - Power of Two (or) Power of Two multiplied by 3, 5, or 15
-    if (!isValidDFTLength(__Length, 16)) {
-        return nullptr;
-    }
+//Creates a setup object to be used for real-to-complex (complex-to-real) double-precision DFT (IDFT) computation
+vDSP_DFT_SetupD vDSP_DFT_zrop_CreateSetupD(vDSP_DFT_SetupD __Previous, vDSP_Length __Length, vDSP_DFT_Direction __Direction) {
+    return createDFTSetup<double>(__Previous, __Length, __Direction, ZROP, 16);
+}
+
 
-    DFTObject->transformLength = __Length;
-    DFTObject->transformDirection = __Direction;
-    DFTObject->transformType = ZROP;
-    return DFTObject;
+//Computes the single-precision DFT for a vector
+void vDSP_DFT_Execute(const struct vDSP_DFT_SetupStruct *__Setup, const float *__Ir, const float *__Ii, float *__Or, float *__Oi) {
+    executeDFT(__Setup, __Ir, __Ii, __Or, __Oi);
 }
 
 
-//Creates a setup object to be used for real-to-complex (complex-to-real) double-precision DFT (IDFT) computation
-vDSP_DFT_SetupD vDSP_DFT_zrop_CreateSetupD(vDSP_DFT_SetupD __Previous, vDSP_Length __Length, vDSP_DFT_Direction __Direction) {
-    vDSP_DFT_SetupD DFTDObject;
-    if (!__Previous) {
-        DFTDObject = new vDSP_DFT_SetupStructD;
-    } else {
-        DFTDObject = __Previous;
+//Computes the double-precision DFT for a vector
+void vDSP_DFT_ExecuteD(const struct vDSP_DFT_SetupStructD *__Setup, const double *__Ir, const double *__Ii, double *__Or, double *__Oi) {
+    executeDFT(__Setup, __Ir, __Ii, __Or, __Oi);
+}
+
+
+//Releases a single-precision setup object
+void vDSP_DFT_DestroySetup(vDSP_DFT_Setup __Setup) {
+    destroyDFTSetup<float>(__Setup);
+}
+
+
+//Releases a double-precision setup object
+void vDSP_DFT_DestroySetupD(vDSP_DFT_SetupD __Setup) {
+    destroyDFTSetup<double>(__Setup);
+}
+
+
+//FFT setup objects hold one twiddle table sized for the largest transform they support, (1, 3 or 5) * 2^Log2n.
+//Every smaller power-of-two transform reads the same table with a stride, so only the factorizations are per length.
+template <typename T>
+struct FFTSetupImpl {
+    FFTSetupImpl(vDSP_Length log2n, size_t factor) : maxLog2n(log2n), table(factor << log2n), radices(log2n + 1) {
+        for (vDSP_Length i = 0; i <= log2n; ++i) {
+            FFT::Factorize(static_cast<size_t>(1) << i, radices[i]);
+        }
     }
 
-    if (!DFTDObject || __Length <= 0 || (__Direction != vDSP_DFT_FORWARD && __Direction != vDSP_DFT_INVERSE)) {
-        return nullptr;
+    vDSP_Length maxLog2n;
+    FFT::TwiddleTable<T> table;
+    std::vector<std::vector<unsigned>> radices;
+};
+
+struct OpaqueFFTSetup : FFTSetupImpl<float> {
+    OpaqueFFTSetup(vDSP_Length log2n, size_t factor) : FFTSetupImpl<float>(log2n, factor) {
     }
+};
 
-    //Check for length requirements - Power of Two (or) Power of Two multiplied by 3, 5, or 15
-    if (!isValidDFTLength(__Length, 16)) {
+struct OpaqueFFTSetupD : FFTSetupImpl<double> {
+    OpaqueFFTSetupD(vDSP_Length log2n, size_t factor) : FFTSetupImpl<double>(log2n, factor) {
+    }
+};
+
+
+template <typename Setup>
+static Setup* createFFTSetup(vDSP_Length log2n, FFTRadix radix) {
+    static const size_t factors[] = { 1, 3, 5 };
+    if (radix < kFFTRadix2 || radix > kFFTRadix5 || log2n >= sizeof(size_t) * 8 - 3) {
         return nullptr;
     }
 
-    DFTDObject->transformLength = __Length;
-    DFTDObject->transformDirection = __Direction;
-    DFTDObject->transformType = ZROP;
-    return DFTDObject;
+    return new Setup(log2n, factors[radix]);
 }
 
 
-//Computes the single-precision DFT for a vector
-void vDSP_DFT_Execute(const struct vDSP_DFT_SetupStruct *__Setup, const float *__Ir, const float *__Ii, float *__Or, float *__Oi) {
-    if (!__Setup) {
-        return;
+//Copies a strided split-complex vector into (or out of) contiguous scratch storage when the stride is not 1
+template <typename T, typename SplitComplex>
+static void gatherSplit(const SplitComplex* source, vDSP_Stride stride, T* real, T* imag, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        real[i] = source->realp[i * stride];
+        imag[i] = source->imagp[i * stride];
     }
+}
 
-    int length = __Setup->transformLength;
-    int direction = __Setup->transformDirection;
-    float scale;
-    float kscale;
-    float real;
-    float imaginary;
-
-    if (__Setup->transformType == ZOP) {
-        scale = 2 * static_cast<float>(M_PI) * direction / length;
-        for (int k = 0; k < length; k++) {
-            real = 0;
-            imaginary = 0;
-            kscale = k * scale;
-            for (int n = 0; n < length; n++) {
-                real += (__Ir[n] * cos(n * kscale)) + (__Ii[n] * sin(n * kscale));
-                imaginary += (__Ii[n] * cos(n * kscale)) - (__Ir[n] * sin(n * kscale));
-            }
 
-            __Or[k] = real;
-            __Oi[k] = imaginary;
-        }
-    } else if (__Setup->transformType == ZROP) {
-        if (direction == vDSP_DFT_FORWARD) {
-            float* realInput = new float[length];
-            for (int i = 0; i < length / 2; i++) {
-                realInput[2 * i + 0] = __Ir[i];
-                realInput[2 * i + 1] = __Ii[i];
-            }
+template <typename T, typename SplitComplex>
+static void scatterSplit(const T* real, const T* imag, const SplitComplex* dest, vDSP_Stride stride, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        dest->realp[i * stride] = real[i];
+        dest->imagp[i * stride] = imag[i];
+    }
+}
 
-            scale = 2 * static_cast<float>(M_PI) / length;
-            for (int k = 0; k < length / 2; k++) {
-                real = 0;
-                imaginary = 0;
-                kscale = k * scale;
-                for (int n = 0; n < length; n++) {
-                    real += realInput[n] * cos(n * kscale);
-
-                    //Block added to match Apple's special case for the first imaginary output
-                    if (k == 0) {
-                        imaginary += realInput[n] * cos(static_cast<float>(M_PI) * n);
-                    } else {
-                        imaginary -= realInput[n] * sin(n * kscale);
-                    }
-                }
 
-                __Or[k] = real * 2;
-                __Oi[k] = imaginary * 2;
-            }
+//Shared implementation of the out-of-place split-complex FFTs (complex and real). The in-place variants pass the same
+//vector as input and output.
+template <typename T, typename SplitComplex>
+static void executeFFT(const FFTSetupImpl<T>* setup,
+                       const SplitComplex* A,
+                       vDSP_Stride IA,
+                       const SplitComplex* C,
+                       vDSP_Stride IC,
+                       vDSP_Length log2N,
+                       FFTDirection direction,
+                       bool realTransform) {
+    if (!setup || !A || !C || log2N > setup->maxLog2n || (direction != kFFTDirection_Forward && direction != kFFTDirection_Inverse)) {
+        return;
+    }
 
-            delete realInput;
-        } else if (direction == vDSP_DFT_INVERSE) {
-            float* realOutput = new float[length];
-            scale = 2 * static_cast<float>(M_PI) / length;
-            for (int k = 0; k < length; k++) {
-                real = 0;
-                kscale = k * scale;
-                for (int n = 0; n < length; n++) {
-                    real += (__Ir[n] * cos(n * kscale)) - (__Ii[n] * sin(n * kscale));
-                }
+    //A real transform of 2^Log2N samples runs as a complex transform of half that length
+    if (realTransform && log2N == 0) {
+        return;
+    }
+    vDSP_Length complexLog2N = realTransform ? log2N - 1 : log2N;
+    size_t count = static_cast<size_t>(1) << complexLog2N;
+
+    std::vector<T> scratch;
+    const T* inR = A->realp;
+    const T* inI = A->imagp;
+    T* outR = C->realp;
+    T* outI = C->imagp;
+    if (IA != 1 || IC != 1) {
+        scratch.resize(2 * count);
+        gatherSplit(A, IA, &scratch[0], &scratch[count], count);
+        inR = outR = &scratch[0];
+        inI = outI = &scratch[count];
+    }
+
+    const std::vector<unsigned>& radices = setup->radices[complexLog2N];
+    if (!realTransform) {
+        FFT::Complex(setup->table, radices, count, inR, inI, outR, outI, direction == kFFTDirection_Inverse);
+    } else if (direction == kFFTDirection_Forward) {
+        FFT::RealForward(setup->table, radices, count, inR, inI, outR, outI);
+    } else {
+        FFT::RealInverse(setup->table, radices, count, inR, inI, outR, outI);
+    }
 
-                realOutput[k] = real;
-            }
+    if (IA != 1 || IC != 1) {
+        scatterSplit(outR, outI, C, IC, count);
+    }
+}
 
-            for (int i = 0; i < length / 2; i++) {
-                __Or[i] = realOutput[2 * i + 0];
-                __Oi[i] = realOutput[2 * i + 1];
 
-                //Block added to match iOS behavior
-                __Or[i] -= __Ir[length / 2];
-                __Oi[i] += __Ir[length / 2];
-            }
+//Creates a single-precision setup object for FFTs of up to 2^__Log2n elements (times 3 or 5 for the larger radices)
+FFTSetup vDSP_create_fftsetup(vDSP_Length __Log2n, FFTRadix __Radix) {
+    return createFFTSetup<OpaqueFFTSetup>(__Log2n, __Radix);
+}
 
-            delete realOutput;
-        }
-    }
+
+//Creates a double-precision setup object for FFTs of up to 2^__Log2n elements (times 3 or 5 for the larger radices)
+FFTSetupD vDSP_create_fftsetupD(vDSP_Length __Log2n, FFTRadix __Radix) {
+    return createFFTSetup<OpaqueFFTSetupD>(__Log2n, __Radix);
 }
 
 
-//Computes the double-precision DFT for a vector
-void vDSP_DFT_ExecuteD(const struct vDSP_DFT_SetupStructD *__Setup, const double *__Ir, const double *__Ii, double *__Or, double *__Oi) {
-    if (!__Setup) {
-        return;
-    }
+//Releases a single-precision FFT setup object
+void vDSP_destroy_fftsetup(FFTSetup __setup) {
+    delete __setup;
+}
 
-    int length = __Setup->transformLength;
-    int direction = __Setup->transformDirection;
-    double scale;
-    double kscale;
-    double real;
-    double imaginary;
-
-    if (__Setup->transformType == ZOP) {
-        scale = 2 * M_PI * direction / length;
-        for (int k = 0; k < length; k++) {
-            real = 0;
-            imaginary = 0;
-            kscale = k * scale;
-            for (int n = 0; n < length; n++) {
-                real += (__Ir[n] * cos(n * kscale)) + (__Ii[n] * sin(n * kscale));
-                imaginary += (__Ii[n] * cos(n * kscale)) - (__Ir[n] * sin(n * kscale));
-            }
 
-            __Or[k] = real;
-            __Oi[k] = imaginary;
-        }
-    } else if (__Setup->transformType == ZROP) {
-        if (direction == vDSP_DFT_FORWARD) {
-            double* realInput = new double[length];
-            for (int i = 0; i < length / 2; i++) {
-                realInput[2 * i + 0] = __Ir[i];
-                realInput[2 * i + 1] = __Ii[i];
-            }
+//Releases a double-precision FFT setup object
+void vDSP_destroy_fftsetupD(FFTSetupD __setup) {
+    delete __setup;
+}
 
-            scale = 2 * M_PI / length;
-            for (int k = 0; k < length / 2; k++) {
-                real = 0;
-                imaginary = 0;
-                kscale = k * scale;
-                for (int n = 0; n < length; n++) {
-                    real += realInput[n] * cos(n * kscale);
-
-                    //Block added to match Apple's special case for the first imaginary output
-                    if (k == 0) {
-                        imaginary += realInput[n] * cos(M_PI * n);
-                    } else {
-                        imaginary -= realInput[n] * sin(n * kscale);
-                    }
-                }
 
-                __Or[k] = real * 2;
-                __Oi[k] = imaginary * 2;
-            }
+//Computes an in-place single-precision complex FFT of 2^__Log2N elements
+void vDSP_fft_zip(FFTSetup __Setup, const DSPSplitComplex *__C, vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction) {
+    executeFFT<float>(__Setup, __C, __IC, __C, __IC, __Log2N, __Direction, false);
+}
 
-            delete realInput;
-        } else if (direction == vDSP_DFT_INVERSE) {
-            double* realOutput = new double[length];
-            scale = 2 * M_PI / length;
-            for (int k = 0; k < length; k++) {
-                real = 0;
-                kscale = k * scale;
-                for (int n = 0; n < length; n++) {
-                    real += (__Ir[n] * cos(n * kscale)) - (__Ii[n] * sin(n * kscale));
-                }
 
-                realOutput[k] = real;
-            }
+//Computes an in-place double-precision complex FFT of 2^__Log2N elements
+void vDSP_fft_zipD(FFTSetupD __Setup, const DSPDoubleSplitComplex *__C, vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction) {
+    executeFFT<double>(__Setup, __C, __IC, __C, __IC, __Log2N, __Direction, false);
+}
 
-            for (int i = 0; i < length / 2; i++) {
-                __Or[i] = realOutput[2 * i + 0];
-                __Oi[i] = realOutput[2 * i + 1];
 
-                //Block added to match iOS behavior
-                __Or[i] -= __Ir[length / 2];
-                __Oi[i] += __Ir[length / 2];
-            }
+//Computes an out-of-place single-precision complex FFT of 2^__Log2N elements
+void vDSP_fft_zop(FFTSetup __Setup, const DSPSplitComplex *__A, vDSP_Stride __IA, const DSPSplitComplex *__C, vDSP_Stride __IC,
+                  vDSP_Length __Log2N, FFTDirection __Direction) {
+    executeFFT<float>(__Setup, __A, __IA, __C, __IC, __Log2N, __Direction, false);
+}
 
-            delete realOutput;
-        }
-    }
+
+//Computes an out-of-place double-precision complex FFT of 2^__Log2N elements
+void vDSP_fft_zopD(FFTSetupD __Setup, const DSPDoubleSplitComplex *__A, vDSP_Stride __IA, const DSPDoubleSplitComplex *__C,
+                   vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction) {
+    executeFFT<double>(__Setup, __A, __IA, __C, __IC, __Log2N, __Direction, false);
 }
 
 
-//Releases a single-precision setup object
-void vDSP_DFT_DestroySetup(vDSP_DFT_Setup __Setup) {
-    if (__Setup) {
-        delete __Setup;
-    }
+//Computes an in-place single-precision real FFT of 2^__Log2N elements stored as even/odd pairs (see vDSP_ctoz).
+//Forward results are scaled by 2 with the Nyquist term packed into imagp[0].
+void vDSP_fft_zrip(FFTSetup __Setup, const DSPSplitComplex *__C, vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction) {
+    executeFFT<float>(__Setup, __C, __IC, __C, __IC, __Log2N, __Direction, true);
+}
+
 
-    return;
+//Computes an in-place double-precision real FFT of 2^__Log2N elements stored as even/odd pairs (see vDSP_ctozD)
+void vDSP_fft_zripD(FFTSetupD __Setup, const DSPDoubleSplitComplex *__C, vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction) {
+    executeFFT<double>(__Setup, __C, __IC, __C, __IC, __Log2N, __Direction, true);
 }
 
 
-//Releases a double-precision setup object
-void vDSP_DFT_DestroySetupD(vDSP_DFT_SetupD __Setup) {
-    if (__Setup) {
-        delete __Setup;
-    }
+//Computes an out-of-place single-precision real FFT of 2^__Log2N elements stored as even/odd pairs
+void vDSP_fft_zrop(FFTSetup __Setup, const DSPSplitComplex *__A, vDSP_Stride __IA, const DSPSplitComplex *__C, vDSP_Stride __IC,
+                   vDSP_Length __Log2N, FFTDirection __Direction) {
+    executeFFT<float>(__Setup, __A, __IA, __C, __IC, __Log2N, __Direction, true);
+}
+
 
-    return;
-}
\ No newline at end of file
+//Computes an out-of-place double-precision real FFT of 2^__Log2N elements stored as even/odd pairs
+void vDSP_fft_zropD(FFTSetupD __Setup, const DSPDoubleSplitComplex *__A, vDSP_Stride __IA, const DSPDoubleSplitComplex *__C,
+                    vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction) {
+    executeFFT<double>(__Setup, __A, __IA, __C, __IC, __Log2N, __Direction, true);
+}
@@ -0,0 +1,275 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+// Scalar, SSE2 and NEON kernels, and the runtime selection between them and the AVX2 kernels.
+
+#include "vDSPKernelsImpl.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define VDSP_KERNELS_X86 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(_M_ARM) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define VDSP_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace vDSPKernels {
+
+void InitializeScalar(Table& table) {
+    table.name = "Scalar";
+    Kernels<float, ScalarOps<float>>::fill(table.f);
+    Kernels<double, ScalarOps<double>>::fill(table.d);
+}
+
+#ifdef VDSP_KERNELS_X86
+namespace {
+
+struct SSE2Float {
+    typedef __m128 V;
+    static const size_t width = 4;
+    static V load(const float* p) {
+        return _mm_loadu_ps(p);
+    }
+    static void store(float* p, V v) {
+        _mm_storeu_ps(p, v);
+    }
+    static V splat(float x) {
+        return _mm_set1_ps(x);
+    }
+    static V add(V a, V b) {
+        return _mm_add_ps(a, b);
+    }
+    static V sub(V a, V b) {
+        return _mm_sub_ps(a, b);
+    }
+    static V mul(V a, V b) {
+        return _mm_mul_ps(a, b);
+    }
+    static V max(V a, V b) {
+        return _mm_max_ps(a, b);
+    }
+    static V min(V a, V b) {
+        return _mm_min_ps(a, b);
+    }
+    static V abs(V a) {
+        return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+    }
+    static V neg(V a) {
+        return _mm_xor_ps(_mm_set1_ps(-0.0f), a);
+    }
+    static float reduceMax(V a) {
+        V m = _mm_max_ps(a, _mm_movehl_ps(a, a));
+        m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+        return _mm_cvtss_f32(m);
+    }
+    static float reduceAdd(V a) {
+        V s = _mm_add_ps(a, _mm_movehl_ps(a, a));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+        return _mm_cvtss_f32(s);
+    }
+};
+
+struct SSE2Double {
+    typedef __m128d V;
+    static const size_t width = 2;
+    static V load(const double* p) {
+        return _mm_loadu_pd(p);
+    }
+    static void store(double* p, V v) {
+        _mm_storeu_pd(p, v);
+    }
+    static V splat(double x) {
+        return _mm_set1_pd(x);
+    }
+    static V add(V a, V b) {
+        return _mm_add_pd(a, b);
+    }
+    static V sub(V a, V b) {
+        return _mm_sub_pd(a, b);
+    }
+    static V mul(V a, V b) {
+        return _mm_mul_pd(a, b);
+    }
+    static V max(V a, V b) {
+        return _mm_max_pd(a, b);
+    }
+    static V min(V a, V b) {
+        return _mm_min_pd(a, b);
+    }
+    static V abs(V a) {
+        return _mm_andnot_pd(_mm_set1_pd(-0.0), a);
+    }
+    static V neg(V a) {
+        return _mm_xor_pd(_mm_set1_pd(-0.0), a);
+    }
+    static double reduceMax(V a) {
+        return _mm_cvtsd_f64(_mm_max_sd(a, _mm_unpackhi_pd(a, a)));
+    }
+    static double reduceAdd(V a) {
+        return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a)));
+    }
+};
+
+void cpuid(int info[4], int leaf) {
+#ifdef _MSC_VER
+    __cpuidex(info, leaf, 0);
+#else
+    unsigned int a = 0, b = 0, c = 0, d = 0;
+    __cpuid_count(leaf, 0, a, b, c, d);
+    info[0] = a;
+    info[1] = b;
+    info[2] = c;
+    info[3] = d;
+#endif
+}
+
+unsigned long long xgetbv0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+bool cpuHasSSE2() {
+    int info[4];
+    cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+}
+
+// AVX2 needs both the CPU bit and the OS saving the YMM registers on context switches (OSXSAVE + XCR0 bits 1 and 2).
+bool cpuHasAVX2() {
+    int info[4];
+    cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    cpuid(info, 1);
+    const int osxsave = 1 << 27;
+    const int avx = 1 << 28;
+    if ((info[2] & osxsave) == 0 || (info[2] & avx) == 0 || (xgetbv0() & 0x6) != 0x6) {
+        return false;
+    }
+
+    cpuid(info, 7);
+    return (info[1] & (1 << 5)) != 0;
+}
+
+} // anonymous namespace
+
+void InitializeSSE2(Table& table) {
+    table.name = "SSE2";
+    Kernels<float, SSE2Float>::fill(table.f);
+    Kernels<double, SSE2Double>::fill(table.d);
+}
+#endif
+
+#ifdef VDSP_KERNELS_NEON
+namespace {
+
+// NEON max/min return NaN when either operand is NaN; compare-and-select keeps the scalar semantics instead.
+struct NEONFloat {
+    typedef float32x4_t V;
+    static const size_t width = 4;
+    static V load(const float* p) {
+        return vld1q_f32(p);
+    }
+    static void store(float* p, V v) {
+        vst1q_f32(p, v);
+    }
+    static V splat(float x) {
+        return vdupq_n_f32(x);
+    }
+    static V add(V a, V b) {
+        return vaddq_f32(a, b);
+    }
+    static V sub(V a, V b) {
+        return vsubq_f32(a, b);
+    }
+    static V mul(V a, V b) {
+        return vmulq_f32(a, b);
+    }
+    static V max(V a, V b) {
+        return vbslq_f32(vcgtq_f32(a, b), a, b);
+    }
+    static V min(V a, V b) {
+        return vbslq_f32(vcltq_f32(a, b), a, b);
+    }
+    static V abs(V a) {
+        return vabsq_f32(a);
+    }
+    static V neg(V a) {
+        return vnegq_f32(a);
+    }
+    static float reduceMax(V a) {
+        float32x2_t m = vpmax_f32(vget_low_f32(a), vget_high_f32(a));
+        m = vpmax_f32(m, m);
+        return vget_lane_f32(m, 0);
+    }
+    static float reduceAdd(V a) {
+        float32x2_t s = vadd_f32(vget_low_f32(a), vget_high_f32(a));
+        s = vpadd_f32(s, s);
+        return vget_lane_f32(s, 0);
+    }
+};
+
+} // anonymous namespace
+
+// 32-bit NEON has no double precision vectors, so the double kernels stay scalar.
+void InitializeNEON(Table& table) {
+    table.name = "NEON";
+    Kernels<float, NEONFloat>::fill(table.f);
+    Kernels<double, ScalarOps<double>>::fill(table.d);
+}
+#endif
+
+namespace {
+
+Table createTable() {
+    Table table;
+    InitializeScalar(table);
+
+#if defined(VDSP_KERNELS_X86)
+    if (cpuHasAVX2()) {
+        InitializeAVX2(table);
+    } else if (cpuHasSSE2()) {
+        InitializeSSE2(table);
+    }
+#elif defined(VDSP_KERNELS_NEON)
+    InitializeNEON(table);
+#endif
+
+    return table;
+}
+
+} // anonymous namespace
+
+const Table& Get() {
+    static const Table table = createTable();
+    return table;
+}
+
+} // namespace vDSPKernels
@@ -0,0 +1,62 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#pragma once
+
+// Unit-stride element-wise kernels used by vDSP.cpp.
+//
+// The vDSP entry points keep their generic strided loops and call into this table when every stride is 1. The table is
+// filled once, on first use, with the widest implementation the CPU supports (AVX2, SSE2 or NEON, with a portable
+// scalar fallback).
+
+#include <cstddef>
+
+namespace vDSPKernels {
+
+template <typename T>
+struct Functions {
+    void (*add)(const T* a, const T* b, T* c, size_t n);
+    void (*mul)(const T* a, const T* b, T* c, size_t n);
+    void (*scalarAdd)(const T* a, T s, T* c, size_t n);
+    void (*scalarMul)(const T* a, T s, T* c, size_t n);
+    void (*clip)(const T* a, T low, T high, T* c, size_t n);
+    void (*abs)(const T* a, T* c, size_t n);
+    void (*neg)(const T* a, T* c, size_t n);
+    T (*max)(const T* a, size_t n);
+    T (*maxMagnitude)(const T* a, size_t n);
+    T (*sumOfSquares)(const T* a, T scale, size_t n); // sum of (a[i] * scale)^2
+};
+
+struct Table {
+    const char* name;
+    Functions<float> f;
+    Functions<double> d;
+};
+
+// Returns the kernels selected for the running CPU.
+const Table& Get();
+
+// Per instruction set initializers, each defined in the translation unit compiled for that instruction set.
+void InitializeScalar(Table& table);
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+void InitializeSSE2(Table& table);
+void InitializeAVX2(Table& table);
+#endif
+#if defined(_M_ARM) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+void InitializeNEON(Table& table);
+#endif
+
+} // namespace vDSPKernels
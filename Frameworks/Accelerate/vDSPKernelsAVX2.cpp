@@ -0,0 +1,141 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+// AVX2 kernels. This file is built with AVX2 code generation (/arch:AVX2) and must only be entered through the table
+// set up by vDSPKernels::Get(), after the CPU has been checked for AVX2 support.
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include <immintrin.h>
+#include "vDSPKernelsImpl.h"
+
+namespace vDSPKernels {
+namespace {
+
+struct AVX2Float {
+    typedef __m256 V;
+    static const size_t width = 8;
+    static V load(const float* p) {
+        return _mm256_loadu_ps(p);
+    }
+    static void store(float* p, V v) {
+        _mm256_storeu_ps(p, v);
+    }
+    static V splat(float x) {
+        return _mm256_set1_ps(x);
+    }
+    static V add(V a, V b) {
+        return _mm256_add_ps(a, b);
+    }
+    static V sub(V a, V b) {
+        return _mm256_sub_ps(a, b);
+    }
+    static V mul(V a, V b) {
+        return _mm256_mul_ps(a, b);
+    }
+    static V max(V a, V b) {
+        return _mm256_max_ps(a, b);
+    }
+    static V min(V a, V b) {
+        return _mm256_min_ps(a, b);
+    }
+    static V abs(V a) {
+        return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+    }
+    static V neg(V a) {
+        return _mm256_xor_ps(_mm256_set1_ps(-0.0f), a);
+    }
+    static float reduceMax(V a) {
+        __m128 m = _mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+        m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+        m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+        return _mm_cvtss_f32(m);
+    }
+    static float reduceAdd(V a) {
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+        return _mm_cvtss_f32(s);
+    }
+};
+
+struct AVX2Double {
+    typedef __m256d V;
+    static const size_t width = 4;
+    static V load(const double* p) {
+        return _mm256_loadu_pd(p);
+    }
+    static void store(double* p, V v) {
+        _mm256_storeu_pd(p, v);
+    }
+    static V splat(double x) {
+        return _mm256_set1_pd(x);
+    }
+    static V add(V a, V b) {
+        return _mm256_add_pd(a, b);
+    }
+    static V sub(V a, V b) {
+        return _mm256_sub_pd(a, b);
+    }
+    static V mul(V a, V b) {
+        return _mm256_mul_pd(a, b);
+    }
+    static V max(V a, V b) {
+        return _mm256_max_pd(a, b);
+    }
+    static V min(V a, V b) {
+        return _mm256_min_pd(a, b);
+    }
+    static V abs(V a) {
+        return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a);
+    }
+    static V neg(V a) {
+        return _mm256_xor_pd(_mm256_set1_pd(-0.0), a);
+    }
+    static double reduceMax(V a) {
+        __m128d m = _mm_max_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+        return _mm_cvtsd_f64(_mm_max_sd(m, _mm_unpackhi_pd(m, m)));
+    }
+    static double reduceAdd(V a) {
+        __m128d s = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+    }
+};
+
+} // anonymous namespace
+
+void InitializeAVX2(Table& table) {
+    table.name = "AVX2";
+    Kernels<float, AVX2Float>::fill(table.f);
+    Kernels<double, AVX2Double>::fill(table.d);
+}
+
+} // namespace vDSPKernels
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
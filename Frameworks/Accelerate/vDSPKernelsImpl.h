@@ -0,0 +1,222 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#pragma once
+
+// Kernel bodies shared by every instruction set. Each vDSPKernels*.cpp file defines an Ops type for its vector
+// registers and instantiates these templates with it.
+//
+// Everything here has internal linkage on purpose: the AVX2 translation unit is compiled with AVX2 code generation, and
+// sharing an inline function with the other units would let the linker pick the AVX2 copy for callers that run on
+// CPUs without it. For the same reason the scalar tails use ScalarOps rather than <cmath> helpers.
+
+#include <cmath>
+#include "vDSPKernels.h"
+
+namespace vDSPKernels {
+namespace {
+
+// An Ops type provides: typedef V, static const size_t width, and the static functions load, store, splat, add, sub,
+// mul, max(a, b) = a > b ? a : b, min(a, b) = a < b ? a : b, abs, neg, reduceMax and reduceAdd.
+template <typename T>
+struct ScalarOps {
+    typedef T V;
+    static const size_t width = 1;
+    static V load(const T* p) {
+        return *p;
+    }
+    static void store(T* p, V v) {
+        *p = v;
+    }
+    static V splat(T x) {
+        return x;
+    }
+    static V add(V a, V b) {
+        return a + b;
+    }
+    static V sub(V a, V b) {
+        return a - b;
+    }
+    static V mul(V a, V b) {
+        return a * b;
+    }
+    static V max(V a, V b) {
+        return a > b ? a : b;
+    }
+    static V min(V a, V b) {
+        return a < b ? a : b;
+    }
+    static V abs(V a) {
+        return (a == 0) ? static_cast<T>(0) : ((a < 0) ? -a : a);
+    }
+    static V neg(V a) {
+        return -a;
+    }
+    static T reduceMax(V a) {
+        return a;
+    }
+    static T reduceAdd(V a) {
+        return a;
+    }
+};
+
+template <typename T, typename Ops>
+struct Kernels {
+    typedef typename Ops::V V;
+    typedef ScalarOps<T> Tail;
+
+    static void add(const T* a, const T* b, T* c, size_t n) {
+        size_t i = 0;
+        for (; i + Ops::width <= n; i += Ops::width) {
+            Ops::store(c + i, Ops::add(Ops::load(a + i), Ops::load(b + i)));
+        }
+        for (; i < n; ++i) {
+            c[i] = a[i] + b[i];
+        }
+    }
+
+    static void mul(const T* a, const T* b, T* c, size_t n) {
+        size_t i = 0;
+        for (; i + Ops::width <= n; i += Ops::width) {
+            Ops::store(c + i, Ops::mul(Ops::load(a + i), Ops::load(b + i)));
+        }
+        for (; i < n; ++i) {
+            c[i] = a[i] * b[i];
+        }
+    }
+
+    static void scalarAdd(const T* a, T s, T* c, size_t n) {
+        const V vs = Ops::splat(s);
+        size_t i = 0;
+        for (; i + Ops::width <= n; i += Ops::width) {
+            Ops::store(c + i, Ops::add(Ops::load(a + i), vs));
+        }
+        for (; i < n; ++i) {
+            c[i] = a[i] + s;
+        }
+    }
+
+    static void scalarMul(const T* a, T s, T* c, size_t n) {
+        const V vs = Ops::splat(s);
+        size_t i = 0;
+        for (; i + Ops::width <= n; i += Ops::width) {
+            Ops::store(c + i, Ops::mul(Ops::load(a + i), vs));
+        }
+        for (; i < n; ++i) {
+            c[i] = a[i] * s;
+        }
+    }
+
+    // Matches the scalar (a < low) ? low : ((a > high) ? high : a), including passing NaNs through.
+    static void clip(const T* a, T low, T high, T* c, size_t n) {
+        const V vlow = Ops::splat(low);
+        const V vhigh = Ops::splat(high);
+        size_t i = 0;
+        for (; i + Ops::width <= n; i += Ops::width) {
+            Ops::store(c + i, Ops::max(vlow, Ops::min(vhigh, Ops::load(a + i))));
+        }
+        for (; i < n; ++i) {
+            c[i] = Tail::max(low, Tail::min(high, a[i]));
+        }
+    }
+
+    static void abs(const T* a, T* c, size_t n) {
+        size_t i = 0;
+        for (; i + Ops::width <= n; i += Ops::width) {
+            Ops::store(c + i, Ops::abs(Ops::load(a + i)));
+        }
+        for (; i < n; ++i) {
+            c[i] = Tail::abs(a[i]);
+        }
+    }
+
+    static void neg(const T* a, T* c, size_t n) {
+        size_t i = 0;
+        for (; i + Ops::width <= n; i += Ops::width) {
+            Ops::store(c + i, Ops::neg(Ops::load(a + i)));
+        }
+        for (; i < n; ++i) {
+            c[i] = -a[i];
+        }
+    }
+
+    // NaNs are skipped: max(x, acc) keeps acc when x is unordered.
+    static T max(const T* a, size_t n) {
+        const T lowest = -static_cast<T>(INFINITY);
+        V acc0 = Ops::splat(lowest);
+        V acc1 = acc0;
+        size_t i = 0;
+        for (; i + 2 * Ops::width <= n; i += 2 * Ops::width) {
+            acc0 = Ops::max(Ops::load(a + i), acc0);
+            acc1 = Ops::max(Ops::load(a + i + Ops::width), acc1);
+        }
+        T result = Ops::reduceMax(Ops::max(acc0, acc1));
+        for (; i < n; ++i) {
+            result = Tail::max(a[i], result);
+        }
+        return result;
+    }
+
+    static T maxMagnitude(const T* a, size_t n) {
+        V acc0 = Ops::splat(0);
+        V acc1 = acc0;
+        size_t i = 0;
+        for (; i + 2 * Ops::width <= n; i += 2 * Ops::width) {
+            acc0 = Ops::max(Ops::abs(Ops::load(a + i)), acc0);
+            acc1 = Ops::max(Ops::abs(Ops::load(a + i + Ops::width)), acc1);
+        }
+        T result = Ops::reduceMax(Ops::max(acc0, acc1));
+        for (; i < n; ++i) {
+            result = Tail::max(Tail::abs(a[i]), result);
+        }
+        return result;
+    }
+
+    static T sumOfSquares(const T* a, T scale, size_t n) {
+        const V vscale = Ops::splat(scale);
+        V acc0 = Ops::splat(0);
+        V acc1 = acc0;
+        size_t i = 0;
+        for (; i + 2 * Ops::width <= n; i += 2 * Ops::width) {
+            V t0 = Ops::mul(Ops::load(a + i), vscale);
+            V t1 = Ops::mul(Ops::load(a + i + Ops::width), vscale);
+            acc0 = Ops::add(acc0, Ops::mul(t0, t0));
+            acc1 = Ops::add(acc1, Ops::mul(t1, t1));
+        }
+        T result = Ops::reduceAdd(Ops::add(acc0, acc1));
+        for (; i < n; ++i) {
+            T t = a[i] * scale;
+            result += t * t;
+        }
+        return result;
+    }
+
+    static void fill(Functions<T>& functions) {
+        functions.add = &Kernels::add;
+        functions.mul = &Kernels::mul;
+        functions.scalarAdd = &Kernels::scalarAdd;
+        functions.scalarMul = &Kernels::scalarMul;
+        functions.clip = &Kernels::clip;
+        functions.abs = &Kernels::abs;
+        functions.neg = &Kernels::neg;
+        functions.max = &Kernels::max;
+        functions.maxMagnitude = &Kernels::maxMagnitude;
+        functions.sumOfSquares = &Kernels::sumOfSquares;
+    }
+};
+
+} // anonymous namespace
+} // namespace vDSPKernels
@@ -16,21 +16,31 @@
 //******************************************************************************
 
 #include <new>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
 #include "Accelerate\vImage.h"
 
-/**
-@Status Interoperable
-*/
+namespace {
 
-vImage_Error vImageBoxConvolve_ARGB8888(const vImage_Buffer* src,
-                                        const vImage_Buffer* dest,
-                                        void* tempBuffer,
-                                        vImagePixelCount srcOffsetToROI_X,
-                                        vImagePixelCount srcOffsetToROI_Y,
-                                        uint32_t kernel_height,
-                                        uint32_t kernel_width,
-                                        const Pixel_8888 backgroundColor,
-                                        vImage_Flags flags) {
+//  Convolutions are computed per tile of destination rows. Images smaller than this many pixels, or with fewer rows
+//  per tile than kMinRowsPerTile, are not worth handing to other threads.
+const size_t kMinPixelsToTile = 256 * 256;
+const size_t kMinRowsPerTile = 16;
+
+enum class KernelShape { Box, Tent };
+
+//  Validation shared by all of the ARGB8888 convolutions.
+vImage_Error validateConvolution(const vImage_Buffer* src,
+                                 const vImage_Buffer* dest,
+                                 vImagePixelCount srcOffsetToROI_X,
+                                 vImagePixelCount srcOffsetToROI_Y,
+                                 uint32_t kernel_height,
+                                 uint32_t kernel_width,
+                                 vImage_Flags flags) {
     if (src == nullptr || dest == nullptr || src->data == nullptr || dest->data == nullptr) {
         return kvImageNullPointerArgument;
     } else if (!(kernel_height & kernel_width & 1)) {
@@ -41,8 +51,8 @@ vImage_Error vImageBoxConvolve_ARGB8888(const vImage_Buffer* src,
         return kvImageInvalidOffset_Y;
     } else if ((srcOffsetToROI_Y + dest->height > src->height) || (srcOffsetToROI_X + dest->width > src->width)) {
         return kvImageRoiLargerThanInputBuffer;
-    } else if (!(flags & kvImageCopyInPlace) && !(flags & kvImageBackgroundColorFill) &&
-               !(flags & kvImageEdgeExtend) && !(flags & kvImageTruncateKernel)) {
+    } else if (!(flags & kvImageCopyInPlace) && !(flags & kvImageBackgroundColorFill) && !(flags & kvImageEdgeExtend) &&
+               !(flags & kvImageTruncateKernel)) {
         return kvImageInvalidEdgeStyle;
     }
 
@@ -51,796 +61,590 @@ vImage_Error vImageBoxConvolve_ARGB8888(const vImage_Buffer* src,
     //  Caveat: We return kvImageInvalidParameter for height, width, srcOffsetToROI_X, and srcOffsetToROI_Y >=2^31
     //  For 32 bit OS, we don't expect size >= 2^31. Hence it is not supported in current release.
     //  TODO for 64-bit
-    if (src->height > maxVal || src->width > maxVal || dest->height > maxVal || dest->width > maxVal
-        || srcOffsetToROI_X > maxVal || srcOffsetToROI_Y > maxVal || kernel_height> maxVal || kernel_width > maxVal) {
+    if (src->height > maxVal || src->width > maxVal || dest->height > maxVal || dest->width > maxVal || srcOffsetToROI_X > maxVal ||
+        srcOffsetToROI_Y > maxVal || kernel_height > maxVal || kernel_width > maxVal) {
         return kvImageInvalidParameter;
     }
-    
-    int KW_d2 = kernel_width / 2;
-    int KH_d2 = kernel_height / 2;
 
-    //  The following 4 variable denote the location of the first and last pixel to have the kernel
-    //  completely overlapping with source image
-    uint32_t start_i = 0;
-    uint32_t start_j = 0;
-    uint32_t end_i = dest->height - 1;
-    uint32_t end_j = dest->width - 1;
+    return kvImageNoError;
+}
 
-    if (static_cast<int>(srcOffsetToROI_Y) < KH_d2) {
-        start_i = KH_d2 - srcOffsetToROI_Y;
+//  Returns the single edge style the convolution runs with, in the order of precedence the flags have always had.
+vImage_Flags edgeStyle(vImage_Flags flags) {
+    if (flags & kvImageCopyInPlace) {
+        return kvImageCopyInPlace;
+    } else if (flags & kvImageTruncateKernel) {
+        return kvImageTruncateKernel;
+    } else if (flags & kvImageBackgroundColorFill) {
+        return kvImageBackgroundColorFill;
     }
+    return kvImageEdgeExtend;
+}
 
-    if (static_cast<int>(srcOffsetToROI_X) < KW_d2) {
-        start_j = KW_d2 - srcOffsetToROI_X;
-    }
+long clampIndex(long index, long length) {
+    return index < 0 ? 0 : (index >= length ? length - 1 : index);
+}
 
-    if (src->height < (srcOffsetToROI_Y + dest->height + KH_d2)) {
-        end_i = src->height - srcOffsetToROI_Y - KH_d2 - 1;
-    }
+uint8_t roundToPixel(double value) {
+    return value >= 255.0 ? 255 : (value <= 0.0 ? 0 : static_cast<uint8_t>(value + 0.5));
+}
 
-    if (src->width < (srcOffsetToROI_X + dest->width + KW_d2)) {
-        end_j = src->width - srcOffsetToROI_X - KW_d2 - 1;
+//  Weight of tap d (-radius <= d <= radius) of a one dimensional kernel
+uint64_t tapWeight(long d, long radius, KernelShape shape) {
+    return shape == KernelShape::Box ? 1 : static_cast<uint64_t>(radius + 1 - std::abs(d));
+}
+
+//  Sum of the weights of taps first..last of a one dimensional kernel, in O(1).
+uint64_t tapWeights(long first, long last, long radius, KernelShape shape) {
+    if (first > last) {
+        return 0;
+    } else if (shape == KernelShape::Box) {
+        return static_cast<uint64_t>(last - first + 1);
     }
 
-    //  The following two variable denote the no of rows required for temporary storage for first pass
-    //  above and below the RoI
-    int top = KH_d2 - start_i;
-    int below = end_i + 1 + KH_d2 - dest->height;
+    //  Weights of taps 0..n of a tent: (radius + 1) + radius + ... + (radius + 1 - n)
+    auto fromCenter = [radius](long n) -> uint64_t {
+        return n < 0 ? 0 : static_cast<uint64_t>((n + 1) * (radius + 1) - n * (n + 1) / 2);
+    };
 
-    //  returns the size of temporary buffer data
-    if (flags & kvImageGetTempBufferSize) {
-        return (dest->height + (top + below) * dest->width) * sizeof(Pixel_8888_s);
+    if (first >= 0) {
+        return fromCenter(last) - fromCenter(first - 1);
+    } else if (last <= 0) {
+        return fromCenter(-first) - fromCenter(-last - 1);
     }
+    return fromCenter(last) + fromCenter(-first) - (radius + 1);
+}
 
-    //  Pointer to access the temporary buffer data.
-    Pixel_8888_s* temp_buf;
-    bool tempBuffer_flag = 0;
-    if (tempBuffer == nullptr) {
-        temp_buf = new(std::nothrow) Pixel_8888_s[(dest->height + (top + below) * dest->width)];
-        if (temp_buf == nullptr) {
-            return kvImageMemoryAllocationError;
+//  Slides a box or tent window of the given radius along in, which holds count + 2 * radius samples, and writes the count
+//  weighted sums to out. A box keeps one running sum; a tent keeps its running total along with the sums of its left and
+//  right halves (radius + 1 samples each), which is all it needs to move one sample along. Either way the cost per
+//  output is constant whatever the radius.
+template <typename Acc, typename In, typename Out>
+void slideWindow(const In* in, size_t inStride, Out* out, size_t outStride, size_t count, long radius, KernelShape shape) {
+    const size_t width = 2 * radius + 1;
+    if (shape == KernelShape::Box) {
+        Acc sum = 0;
+        for (size_t k = 0; k < width; ++k) {
+            sum += in[k * inStride];
         }
-        tempBuffer_flag = 1;
-    } else {
-        temp_buf = static_cast<Pixel_8888_s*>(tempBuffer);
+        out[0] = static_cast<Out>(sum);
+        for (size_t j = 1; j < count; ++j) {
+            sum += in[(j + width - 1) * inStride];
+            sum -= in[(j - 1) * inStride];
+            out[j * outStride] = static_cast<Out>(sum);
+        }
+        return;
     }
 
-    uint32_t sum[4] = { 0 };
-    uint32_t src_i;
-    uint32_t src_j;
-    Pixel_8888_s* src_buf = static_cast<Pixel_8888_s*>(src->data);
-    Pixel_8888_s* dest_buf = static_cast<Pixel_8888_s*>(dest->data);
-    size_t src_rowstride = src->rowBytes / sizeof(Pixel_8888);
-    size_t dest_rowstride = dest->rowBytes / sizeof(Pixel_8888);
+    Acc total = 0;
+    Acc left = 0;
+    Acc right = 0;
+    for (long k = 0; k <= 2 * radius; ++k) {
+        total += static_cast<Acc>(tapWeight(k - radius, radius, shape)) * in[k * inStride];
+    }
+    for (long k = 0; k <= radius; ++k) {
+        left += in[k * inStride];
+        right += in[(k + radius) * inStride];
+    }
 
-    //  This block deals with code for flag kvImageCopyInPlace, which require the pixel to be copied as is 
-    //  from source image when the kernel does not overlap with the image data
-    if (flags & kvImageCopyInPlace) {
-        bool sum_flag = 0;
-
-        //  First pass (horizontal)
-        for (uint32_t i = 0; i < dest->height; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X;
-            sum_flag = 0;
-            sum[0] = 0;
-            sum[1] = 0;
-            sum[2] = 0;
-            sum[3] = 0;
-
-            for (uint32_t j = 0; j < dest->width; ++j, src_j++) {
-
-                //  Copying the pixel data as is from source for no kernel overlap section
-                if (j < start_j || j > end_j) {
-                    dest_buf[i * dest_rowstride + j] = src_buf[src_i * src_rowstride + src_j];
-                } else {
-                    if (sum_flag == 0) {
-                        sum_flag = 1;
-                        for (int k = -KW_d2; k <= KW_d2; ++k) {
-                            sum[0] += src_buf[src_i * src_rowstride + src_j + k].val[0];
-                            sum[1] += src_buf[src_i * src_rowstride + src_j + k].val[1];
-                            sum[2] += src_buf[src_i * src_rowstride + src_j + k].val[2];
-                            sum[3] += src_buf[src_i * src_rowstride + src_j + k].val[3];
-                        }
-                    } else {
-                        sum[0] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0]
-                            + src_buf[src_i * src_rowstride + src_j + KW_d2].val[0];
-                        sum[1] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1]
-                            + src_buf[src_i * src_rowstride + src_j + KW_d2].val[1];
-                        sum[2] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2]
-                            + src_buf[src_i * src_rowstride + src_j + KW_d2].val[2];
-                        sum[3] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3]
-                            + src_buf[src_i * src_rowstride + src_j + KW_d2].val[3];
-                    }
+    out[0] = static_cast<Out>(total);
+    for (size_t j = 1; j < count; ++j) {
+        right += in[(j + 2 * radius) * inStride];
+        right -= in[(j + radius - 1) * inStride];
+        total += right;
+        total -= left;
+        left += in[(j + radius) * inStride];
+        left -= in[(j - 1) * inStride];
+        out[j * outStride] = static_cast<Out>(total);
+    }
+}
 
-                    dest_buf[i * dest_rowstride + j].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                }
-            }
+//  Splits the destination rows into tiles and runs work(firstRow, endRow, tileIndex) for each of them, the first tile on
+//  the calling thread and the rest on worker threads.
+template <typename Work>
+void runTiles(size_t rows, size_t tileCount, size_t rowsPerTile, const Work& work) {
+    std::vector<std::thread> workers;
+    workers.reserve(tileCount - 1);
+    for (size_t tile = 1; tile < tileCount; ++tile) {
+        size_t first = tile * rowsPerTile;
+        size_t end = std::min(rows, first + rowsPerTile);
+        if (first >= end) {
+            break;
         }
+        workers.emplace_back([&work, first, end, tile]() { work(first, end, tile); });
+    }
 
-        //  first pass above("top") the RoI
-        for (int i = start_i - KH_d2; i < 0; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X;
-            sum_flag = 0;
-            sum[0] = 0;
-            sum[1] = 0;
-            sum[2] = 0;
-            sum[3] = 0;
-
-            for (uint32_t j = 0; j < dest->width; ++j, src_j++) {
-
-                //  Copying the pixel data as is from source for no kernel overlap section
-                if (j < start_j || j > end_j) {
-                    temp_buf[(top + i)*dest_rowstride] = src_buf[src_i * src_rowstride + src_j];
-                } else {
-                    if (sum_flag == 0) {
-                        sum_flag = 1;
-                        for (int k = -KW_d2; k <= KW_d2; ++k) {
-                            sum[0] += src_buf[src_i * src_rowstride + src_j + k].val[0];
-                            sum[1] += src_buf[src_i * src_rowstride + src_j + k].val[1];
-                            sum[2] += src_buf[src_i * src_rowstride + src_j + k].val[2];
-                            sum[3] += src_buf[src_i * src_rowstride + src_j + k].val[3];
-                        }
-                    } else {
-                        sum[0] = sum[0] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0]
-                            + src_buf[src_i * src_rowstride + src_j + KW_d2].val[0];
-                        sum[1] = sum[1] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1]
-                            + src_buf[src_i * src_rowstride + src_j + KW_d2].val[1];
-                        sum[2] = sum[2] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2]
-                            + src_buf[src_i * src_rowstride + src_j + KW_d2].val[2];
-                        sum[3] = sum[3] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3]
-                            + src_buf[src_i * src_rowstride + src_j + KW_d2].val[3];
-                    }
+    work(0, std::min(rows, rowsPerTile), 0);
 
-                    temp_buf[(top + i) * dest_rowstride + j].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                }
-            }
-        }
-
-        //  first pass below the RoI
-        for (uint32_t i = dest->height; i <= end_i + KH_d2; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X;
-            sum_flag = 0;
-            sum[0] = 0;
-            sum[1] = 0;
-            sum[2] = 0;
-            sum[3] = 0;
-
-            for (uint32_t j = 0; j < dest->width; ++j, src_j++) {
-
-                //  Copying the pixel data as is from source for no kernel overlap section
-                if (j < start_j || j > end_j) {
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j] = src_buf[src_i * src_rowstride + src_j];
-                } else {
-                    if (sum_flag == 0) {
-                        sum_flag = 1;
-                        for (int k = -KW_d2; k <= KW_d2; ++k) {
-                            sum[0] += src_buf[src_i * src_rowstride + src_j + k].val[0];
-                            sum[1] += src_buf[src_i * src_rowstride + src_j + k].val[1];
-                            sum[2] += src_buf[src_i * src_rowstride + src_j + k].val[2];
-                            sum[3] += src_buf[src_i * src_rowstride + src_j + k].val[3];
-                        }
-                    } else {
-                        sum[0] = sum[0] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0]
-                            + src_buf[src_i * src_rowstride + src_j + KW_d2].val[0];
-                        sum[1] = sum[1] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1]
-                            + src_buf[src_i * src_rowstride + src_j + KW_d2].val[1];
-                        sum[2] = sum[2] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2]
-                            + src_buf[src_i * src_rowstride + src_j + KW_d2].val[2];
-                        sum[3] = sum[3] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3]
-                            + src_buf[src_i * src_rowstride + src_j + KW_d2].val[3];
-                    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
 
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[0]
-                        = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[1]
-                        = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[2]
-                        = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[3]
-                        = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                }
-            }
-        }
+size_t tileCountFor(const vImage_Buffer* dest, vImage_Flags flags) {
+    if ((flags & kvImageDoNotTile) || dest->width * dest->height < kMinPixelsToTile) {
+        return 1;
+    }
 
-        //  Second pass (vertical)
-        for (uint32_t j = start_j; j <= end_j; ++j) {
-            sum_flag = 0;
-            sum[0] = 0;
-            sum[1] = 0;
-            sum[2] = 0;
-            sum[3] = 0;
-
-            for (int i = start_i; i <= static_cast<int>(end_i); ++i) {
-                if (sum_flag == 0) {
-                    sum_flag = 1;
-                    for (int k = -KH_d2; k <= KH_d2; ++k) {
-                        if (i + k < 0) {
-                            sum[0] += temp_buf[(top + (i + k)) * dest_rowstride + j].val[0];
-                            sum[1] += temp_buf[(top + (i + k)) * dest_rowstride + j].val[1];
-                            sum[2] += temp_buf[(top + (i + k)) * dest_rowstride + j].val[2];
-                            sum[3] += temp_buf[(top + (i + k)) * dest_rowstride + j].val[3];
-                        } else {
-                            sum[0] += dest_buf[(i + k) * dest_rowstride + j].val[0];
-                            sum[1] += dest_buf[(i + k) * dest_rowstride + j].val[1];
-                            sum[2] += dest_buf[(i + k) * dest_rowstride + j].val[2];
-                            sum[3] += dest_buf[(i + k) * dest_rowstride + j].val[3];
-                        }
-                    }
-                } else {
-                    if (i - KH_d2 - 1 < 0) {
-                        sum[0] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[0];
-                        sum[1] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[1];
-                        sum[2] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[2];
-                        sum[3] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[3];
-                    } else {
-                        sum[0] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[0];
-                        sum[1] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[1];
-                        sum[2] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[2];
-                        sum[3] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[3];
-                    }
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min<size_t>(threads, dest->height / kMinRowsPerTile));
+}
 
-                    if (i + KH_d2 >= static_cast<int>(dest->height)) {
-                        sum[0] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[0];
-                        sum[1] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[1];
-                        sum[2] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[2];
-                        sum[3] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[3];
-                    } else {
-                        sum[0] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[0];
-                        sum[1] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[1];
-                        sum[2] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[2];
-                        sum[3] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[3];
-                    }
-                }
+size_t alignedSize(size_t bytes) {
+    return (bytes + 7) & ~static_cast<size_t>(7);
+}
 
-                temp_buf[(top + below) * dest_rowstride + i - start_i].val[0]
-                    = sum[0] > (255 * kernel_height) ? 255 : sum[0] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i - start_i].val[1]
-                    = sum[1] > (255 * kernel_height) ? 255 : sum[1] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i - start_i].val[2]
-                    = sum[2] > (255 * kernel_height) ? 255 : sum[2] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i - start_i].val[3]
-                    = sum[3] > (255 * kernel_height) ? 255 : sum[3] / kernel_height;
-            }
+//  Describes how a box or tent convolution lays out its scratch memory, which either comes from the caller's
+//  tempBuffer or is allocated for the call:
+//      invNormX       1 / (sum of the weights applied to each destination column), one double per column
+//      per tile:
+//          line       one source row with its edge pixels filled in, width + 2 * radiusX pixels
+//          rows       ring of the horizontal sums of the last 2 * radiusY + 2 source rows, each width * 4
+//          sums       running vertical sums, 3 * width * 4
+struct SeparablePlan {
+    long radiusX;
+    long radiusY;
+    size_t tileCount;
+    size_t rowsPerTile;
+    size_t invNormBytes;
+    size_t lineBytes;
+    size_t rowsBytes;
+    size_t sumsBytes;
+
+    SeparablePlan(const vImage_Buffer* dest, uint32_t kernel_height, uint32_t kernel_width, vImage_Flags flags)
+        : radiusX(kernel_width / 2), radiusY(kernel_height / 2) {
+        tileCount = tileCountFor(dest, flags);
+        rowsPerTile = (dest->height + tileCount - 1) / tileCount;
+        invNormBytes = alignedSize(dest->width * sizeof(double));
+        lineBytes = alignedSize((dest->width + 2 * radiusX) * sizeof(Pixel_8888_s));
+        rowsBytes = alignedSize(ringRows() * dest->width * 4 * sizeof(uint32_t));
+        sumsBytes = alignedSize(3 * dest->width * 4 * sizeof(uint64_t));
+    }
 
-            for (uint32_t i = start_i; i <= end_i; ++i) {
-                dest_buf[i * dest_rowstride + j] = temp_buf[(top + below) * dest_rowstride + i - start_i];
-            }
-        }
+    //  The vertical window needs the 2 * radiusY + 1 rows it covers plus the row it is about to drop.
+    size_t ringRows() const {
+        return 2 * radiusY + 2;
+    }
 
-        for (uint32_t i = 0; i < start_i; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X + start_j;
-            for (uint32_t j = start_j; j <= end_j; ++j, src_j++) {
-                dest_buf[i * dest_rowstride + j] = src_buf[src_i * src_rowstride + src_j];
-            }
-        }
+    size_t tileBytes() const {
+        return lineBytes + rowsBytes + sumsBytes;
+    }
 
-        for (uint32_t i = end_i + 1; i < dest->height; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X + start_j;
-            for (uint32_t j = start_j; j <= end_j; ++j, src_j++) {
-                dest_buf[i * dest_rowstride + j] = src_buf[src_i * src_rowstride + src_j];
-            }
+    //  The extra 8 bytes let an unaligned tempBuffer be rounded up to 8 byte alignment.
+    size_t tempBufferSize() const {
+        return invNormBytes + tileCount * tileBytes() + 8;
+    }
+};
+
+//  Arguments of one box or tent convolution, in signed pixel units.
+struct SeparableJob {
+    const Pixel_8888_s* src;
+    size_t srcRowStride;
+    long srcWidth;
+    long srcHeight;
+    Pixel_8888_s* dest;
+    size_t destRowStride;
+    long width;
+    long height;
+    long offsetX;
+    long offsetY;
+    long radiusX;
+    long radiusY;
+    KernelShape shape;
+    vImage_Flags edge;
+    Pixel_8888_s background;
+    bool leaveAlphaUnchanged;
+    const double* invNormX;
+};
+
+//  First pass: the weighted horizontal sums of source row srcRow for every destination column.
+void horizontalPass(const SeparableJob& job, long srcRow, Pixel_8888_s* line, uint32_t* out) {
+    const long lineLength = job.width + 2 * job.radiusX;
+    const long firstColumn = job.offsetX - job.radiusX;
+    const Pixel_8888_s* row = job.src + srcRow * job.srcRowStride;
+    const Pixel_8888_s zero = { { 0, 0, 0, 0 } };
+
+    for (long t = 0; t < lineLength; ++t) {
+        long column = firstColumn + t;
+        if (column >= 0 && column < job.srcWidth) {
+            line[t] = row[column];
+        } else if (job.edge == kvImageBackgroundColorFill) {
+            line[t] = job.background;
+        } else if (job.edge == kvImageTruncateKernel) {
+            line[t] = zero;
+        } else {
+            line[t] = row[clampIndex(column, job.srcWidth)];
         }
     }
 
-    //  This block deals with code for flag kvImageTruncateKernel, which require the kernel to be truncated 
-    //  when it does not overlap with the image data
-    else if (flags & kvImageTruncateKernel) {
-        uint32_t divisor;
-
-        //  First pass (horizontal)
-        for (int i = static_cast<int>(start_i) - KH_d2; i <= static_cast<int>(end_i) + KH_d2; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X;
-            sum[0] = 0;
-            sum[1] = 0;
-            sum[2] = 0;
-            sum[3] = 0;
-            divisor = kernel_width - start_j;
-
-            for (int k = start_j - KW_d2; k <= KW_d2; ++k) {
-                sum[0] += src_buf[src_i * src_rowstride + src_j + k].val[0];
-                sum[1] += src_buf[src_i * src_rowstride + src_j + k].val[1];
-                sum[2] += src_buf[src_i * src_rowstride + src_j + k].val[2];
-                sum[3] += src_buf[src_i * src_rowstride + src_j + k].val[3];
-            }
-
-            if (i<0) {
-                temp_buf[(top + i) * dest_rowstride].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-                temp_buf[(top + i) * dest_rowstride].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-                temp_buf[(top + i) * dest_rowstride].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-                temp_buf[(top + i) * dest_rowstride].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
-            } else if (i >= static_cast<int>(dest->height)) {
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
-            } else {
-                dest_buf[i * dest_rowstride].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-                dest_buf[i * dest_rowstride].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-                dest_buf[i * dest_rowstride].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-                dest_buf[i * dest_rowstride].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
-            }
-
-            src_j++;
-
-            for (uint32_t j = 1; j < dest->width; ++j, src_j++) {
-                if (j <= start_j) {
-                    divisor++;
-                    sum[0] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[0];
-                    sum[1] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[1];
-                    sum[2] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[2];
-                    sum[3] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[3];
-                } else if (j <= end_j) {
-                    sum[0] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[0]
-                        - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0];
-                    sum[1] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[1]
-                        - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1];
-                    sum[2] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[2]
-                        - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2];
-                    sum[3] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[3]
-                        - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3];
-                } else {
-                    divisor--;
-                    sum[0] -= src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0];
-                    sum[1] -= src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1];
-                    sum[2] -= src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2];
-                    sum[3] -= src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3];
-                }
+    const uint8_t* samples = line[0].val;
+    for (int c = 0; c < 4; ++c) {
+        slideWindow<uint32_t>(samples + c, 4, out + c, 4, job.width, job.radiusX, job.shape);
+    }
+}
 
-                if (i < 0) {
-                    temp_buf[(top + i) * dest_rowstride + j].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-                    temp_buf[(top + i) * dest_rowstride + j].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-                    temp_buf[(top + i) * dest_rowstride + j].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-                    temp_buf[(top + i) * dest_rowstride + j].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
-                } else if (i >= static_cast<int>(dest->height)) {
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[0]
-                        = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[1]
-                        = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[2]
-                        = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[3]
-                        = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
-                } else {
-                    dest_buf[i * dest_rowstride + j].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-                    dest_buf[i * dest_rowstride + j].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-                    dest_buf[i * dest_rowstride + j].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-                    dest_buf[i * dest_rowstride + j].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
-                }
-            }
+//  Convolves destination rows [firstRow, endRow) using the tile's share of the scratch memory.
+void separableTile(const SeparableJob& job, long firstRow, long endRow, uint8_t* scratch, const SeparablePlan& plan) {
+    Pixel_8888_s* line = reinterpret_cast<Pixel_8888_s*>(scratch);
+    uint32_t* rows = reinterpret_cast<uint32_t*>(scratch + plan.lineBytes);
+    uint64_t* sums = reinterpret_cast<uint64_t*>(scratch + plan.lineBytes + plan.rowsBytes);
+
+    const size_t rowLength = job.width * 4;
+    const long ringRows = static_cast<long>(plan.ringRows());
+    const uint64_t rowWeightX = tapWeights(-job.radiusX, job.radiusX, job.radiusX, job.shape);
+
+    //  First pass for row s of the tile's window, counted from radiusY rows above firstRow. Rows above and below the
+    //  source are replaced according to the edge style.
+    auto horizontalRow = [&](long s) -> const uint32_t* {
+        long srcRow = job.offsetY + firstRow - job.radiusY + s;
+        uint32_t* out = rows + (s % ringRows) * rowLength;
+        if (srcRow >= 0 && srcRow < job.srcHeight) {
+            horizontalPass(job, srcRow, line, out);
+        } else if (job.edge == kvImageBackgroundColorFill) {
+            for (size_t k = 0; k < rowLength; ++k) {
+                out[k] = static_cast<uint32_t>(job.background.val[k & 3] * rowWeightX);
+            }
+        } else if (job.edge == kvImageTruncateKernel) {
+            std::fill(out, out + rowLength, 0);
+        } else {
+            horizontalPass(job, clampIndex(srcRow, job.srcHeight), line, out);
         }
-
-        //  Second pass (vertical)
-        for (uint32_t j = 0; j < dest->width; ++j) {
-            sum[0] = 0;
-            sum[1] = 0;
-            sum[2] = 0;
-            sum[3] = 0;
-            divisor = kernel_height - start_i;
-
-            for (int k = start_i - KH_d2; k < 0; ++k) {
-                sum[0] += temp_buf[(top + k) * dest_rowstride + j].val[0];
-                sum[1] += temp_buf[(top + k) * dest_rowstride + j].val[1];
-                sum[2] += temp_buf[(top + k) * dest_rowstride + j].val[2];
-                sum[3] += temp_buf[(top + k) * dest_rowstride + j].val[3];
-            }
-
-            for (int k = 0; k <= KH_d2; ++k) {
-                sum[0] += dest_buf[k * dest_rowstride + j].val[0];
-                sum[1] += dest_buf[k * dest_rowstride + j].val[1];
-                sum[2] += dest_buf[k * dest_rowstride + j].val[2];
-                sum[3] += dest_buf[k * dest_rowstride + j].val[3];
+        return out;
+    };
+    auto row = [&](long s) -> const uint32_t* { return rows + (s % ringRows) * rowLength; };
+
+    //  Second pass, sliding down all columns at once so the rows are read in order. This is slideWindow with a
+    //  separate sum per column and channel; each source row goes through the first pass just before the window
+    //  reaches it.
+    const long radius = job.radiusY;
+    uint64_t* total = sums;
+    uint64_t* left = sums + rowLength;
+    uint64_t* right = sums + 2 * rowLength;
+    std::fill(sums, sums + 3 * rowLength, 0);
+
+    for (long k = 0; k <= 2 * radius; ++k) {
+        const uint32_t* in = horizontalRow(k);
+        uint64_t weight = tapWeight(k - radius, radius, job.shape);
+        for (size_t n = 0; n < rowLength; ++n) {
+            total[n] += weight * in[n];
+        }
+    }
+    if (job.shape == KernelShape::Tent) {
+        for (long k = 0; k <= radius; ++k) {
+            const uint32_t* inLeft = row(k);
+            const uint32_t* inRight = row(k + radius);
+            for (size_t n = 0; n < rowLength; ++n) {
+                left[n] += inLeft[n];
+                right[n] += inRight[n];
             }
+        }
+    }
 
-            temp_buf[(top + below) * dest_rowstride].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-            temp_buf[(top + below) * dest_rowstride].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-            temp_buf[(top + below) * dest_rowstride].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-            temp_buf[(top + below) * dest_rowstride].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
-
-            for (int i = 1; i < static_cast<int>(dest->height); ++i) {
-                if (i > static_cast<int>(start_i)) {
-                    divisor--;
-                    if (i - KH_d2 - 1 < 0) {
-                        sum[0] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[0];
-                        sum[1] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[1];
-                        sum[2] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[2];
-                        sum[3] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[3];
-                    } else {
-                        sum[0] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[0];
-                        sum[1] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[1];
-                        sum[2] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[2];
-                        sum[3] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[3];
-                    }
+    for (long i = firstRow; i < endRow; ++i) {
+        long s = i - firstRow;
+        if (s > 0) {
+            const uint32_t* incoming = horizontalRow(s + 2 * radius);
+            if (job.shape == KernelShape::Box) {
+                const uint32_t* outgoing = row(s - 1);
+                for (size_t n = 0; n < rowLength; ++n) {
+                    total[n] += incoming[n];
+                    total[n] -= outgoing[n];
                 }
-
-                if (i <= static_cast<int>(end_i)) {
-                    divisor++;
-                    if (i + KH_d2 >= static_cast<int>(dest->height)) {
-                        sum[0] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[0];
-                        sum[1] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[1];
-                        sum[2] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[2];
-                        sum[3] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[3];
-                    } else {
-                        sum[0] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[0];
-                        sum[1] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[1];
-                        sum[2] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[2];
-                        sum[3] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[3];
-                    }
+            } else {
+                const uint32_t* rightOut = row(s + radius - 1);
+                const uint32_t* leftIn = row(s + radius);
+                const uint32_t* leftOut = row(s - 1);
+                for (size_t n = 0; n < rowLength; ++n) {
+                    right[n] += incoming[n];
+                    right[n] -= rightOut[n];
+                    total[n] += right[n];
+                    total[n] -= left[n];
+                    left[n] += leftIn[n];
+                    left[n] -= leftOut[n];
                 }
-
-                temp_buf[(top + below) * dest_rowstride + i].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-                temp_buf[(top + below) * dest_rowstride + i].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-                temp_buf[(top + below) * dest_rowstride + i].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-                temp_buf[(top + below) * dest_rowstride + i].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
-            }
-
-            for (uint32_t i = 0; i < dest->height; ++i) {
-                dest_buf[i * dest_rowstride + j] = temp_buf[(top + below) * dest_rowstride + i];
             }
         }
-    }
 
-    //  This block deals with code for flag kvImageBackgroundColorFill, which requires all pixels outside image to be  
-    //  set to the parameter backgroundColor
-    else if (flags & kvImageBackgroundColorFill) {
-        
-        if (backgroundColor == nullptr) {
-            return kvImageNullPointerArgument;
+        //  Normalize and write out the row
+        long srcRow = job.offsetY + i;
+        double invNormY;
+        if (job.edge == kvImageTruncateKernel) {
+            long first = std::max(-radius, -srcRow);
+            long last = std::min(radius, job.srcHeight - 1 - srcRow);
+            invNormY = 1.0 / static_cast<double>(tapWeights(first, last, radius, job.shape));
+        } else {
+            invNormY = 1.0 / static_cast<double>(tapWeights(-radius, radius, radius, job.shape));
         }
 
-        //  First pass (horizontal)
-        for (int i = static_cast<int>(start_i) - KH_d2; i <= static_cast<int>(end_i) + KH_d2; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X;
-            sum[0] = backgroundColor[0] * start_j;
-            sum[1] = backgroundColor[1] * start_j;
-            sum[2] = backgroundColor[2] * start_j;
-            sum[3] = backgroundColor[3] * start_j;
-
-            for (int k = start_j - KW_d2; k <= KW_d2; ++k) {
-                sum[0] += src_buf[src_i * src_rowstride + src_j + k].val[0];
-                sum[1] += src_buf[src_i * src_rowstride + src_j + k].val[1];
-                sum[2] += src_buf[src_i * src_rowstride + src_j + k].val[2];
-                sum[3] += src_buf[src_i * src_rowstride + src_j + k].val[3];
+        const Pixel_8888_s* srcPixels = job.src + srcRow * job.srcRowStride + job.offsetX;
+        Pixel_8888_s* destPixels = job.dest + i * job.destRowStride;
+        const bool rowFits = srcRow - radius >= 0 && srcRow + radius < job.srcHeight;
+        for (long j = 0; j < job.width; ++j) {
+            long srcColumn = job.offsetX + j;
+            if (job.edge == kvImageCopyInPlace &&
+                (!rowFits || srcColumn - job.radiusX < 0 || srcColumn + job.radiusX >= job.srcWidth)) {
+                destPixels[j] = srcPixels[j];
+                continue;
             }
 
-            if (i<0) {
-                temp_buf[(top + i) * dest_rowstride].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                temp_buf[(top + i) * dest_rowstride].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                temp_buf[(top + i) * dest_rowstride].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                temp_buf[(top + i) * dest_rowstride].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-            } else if (i >= static_cast<int>(dest->height)) {
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[0]
-                    = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[1]
-                    = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[2]
-                    = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[3]
-                    = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-            } else {
-                dest_buf[i * dest_rowstride].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                dest_buf[i * dest_rowstride].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                dest_buf[i * dest_rowstride].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                dest_buf[i * dest_rowstride].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
+            double scale = job.invNormX[j] * invNormY;
+            const uint64_t* pixelSums = total + j * 4;
+            for (int c = 0; c < 4; ++c) {
+                destPixels[j].val[c] = roundToPixel(static_cast<double>(pixelSums[c]) * scale);
             }
-
-            src_j++;
-
-            for (uint32_t j = 1; j < dest->width; ++j, src_j++) {
-                if (j <= start_j) {
-                    sum[0] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[0] - backgroundColor[0];
-                    sum[1] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[1] - backgroundColor[1];
-                    sum[2] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[2] - backgroundColor[2];
-                    sum[3] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[3] - backgroundColor[3];
-                } else if (j <= end_j) {
-                    sum[0] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[0]
-                        - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0];
-                    sum[1] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[1]
-                        - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1];
-                    sum[2] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[2]
-                        - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2];
-                    sum[3] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[3]
-                        - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3];
-                } else {
-                    sum[0] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0] + backgroundColor[0];
-                    sum[1] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1] + backgroundColor[1];
-                    sum[2] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2] + backgroundColor[2];
-                    sum[3] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3] + backgroundColor[3];
-                }
-
-                if (i < 0) {
-                    temp_buf[(top + i) * dest_rowstride + j].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                } else if (i >= static_cast<int>(dest->height)) {
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[0]
-                        = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[1]
-                        = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[2]
-                        = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[3]
-                        = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                } else {
-                    dest_buf[i * dest_rowstride + j].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                }
+            if (job.leaveAlphaUnchanged) {
+                destPixels[j].val[0] = srcPixels[j].val[0];
             }
         }
+    }
+}
 
-        //  Second pass (vertical)
-        for (uint32_t j = 0; j < dest->width; ++j) {
-            sum[0] = backgroundColor[0] * start_i;
-            sum[1] = backgroundColor[1] * start_i;
-            sum[2] = backgroundColor[2] * start_i;
-            sum[3] = backgroundColor[3] * start_i;
-
-            for (int k = start_i - KH_d2; k < 0; ++k) {
-                sum[0] += temp_buf[(top + k) * dest_rowstride + j].val[0];
-                sum[1] += temp_buf[(top + k) * dest_rowstride + j].val[1];
-                sum[2] += temp_buf[(top + k) * dest_rowstride + j].val[2];
-                sum[3] += temp_buf[(top + k) * dest_rowstride + j].val[3];
-            }
+//  Shared implementation of vImageBoxConvolve_ARGB8888 and vImageTentConvolve_ARGB8888. Both kernels are separable,
+//  so each destination pixel is a horizontal pass over source rows followed by a vertical pass over those sums, and
+//  both passes slide their windows in constant time per pixel. The horizontal sums are kept at full precision and the
+//  result is rounded once.
+vImage_Error separableConvolve(const vImage_Buffer* src,
+                               const vImage_Buffer* dest,
+                               void* tempBuffer,
+                               vImagePixelCount srcOffsetToROI_X,
+                               vImagePixelCount srcOffsetToROI_Y,
+                               uint32_t kernel_height,
+                               uint32_t kernel_width,
+                               const Pixel_8888 backgroundColor,
+                               vImage_Flags flags,
+                               KernelShape shape) {
+    vImage_Error error =
+        validateConvolution(src, dest, srcOffsetToROI_X, srcOffsetToROI_Y, kernel_height, kernel_width, flags);
+    if (error != kvImageNoError) {
+        return error;
+    }
 
-            for (int k = 0; k <= KH_d2; ++k) {
-                sum[0] += dest_buf[k * dest_rowstride + j].val[0];
-                sum[1] += dest_buf[k * dest_rowstride + j].val[1];
-                sum[2] += dest_buf[k * dest_rowstride + j].val[2];
-                sum[3] += dest_buf[k * dest_rowstride + j].val[3];
-            }
+    const vImage_Flags edge = edgeStyle(flags);
+    SeparablePlan plan(dest, kernel_height, kernel_width, flags);
 
-            temp_buf[(top + below) * dest_rowstride].val[0] = sum[0] > (255 * kernel_height) ? 255 : sum[0] / kernel_height;
-            temp_buf[(top + below) * dest_rowstride].val[1] = sum[1] > (255 * kernel_height) ? 255 : sum[1] / kernel_height;
-            temp_buf[(top + below) * dest_rowstride].val[2] = sum[2] > (255 * kernel_height) ? 255 : sum[2] / kernel_height;
-            temp_buf[(top + below) * dest_rowstride].val[3] = sum[3] > (255 * kernel_height) ? 255 : sum[3] / kernel_height;
-
-            for (int i = 1; i < static_cast<int>(dest->height); ++i) {
-                if (i <= static_cast<int>(start_i)) {
-                    sum[0] -= backgroundColor[0];
-                    sum[1] -= backgroundColor[1];
-                    sum[2] -= backgroundColor[2];
-                    sum[3] -= backgroundColor[3];
-                } else if (i <= KH_d2) {
-                    sum[0] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[0];
-                    sum[1] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[1];
-                    sum[2] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[2];
-                    sum[3] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[3];
-                } else {
-                    sum[0] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[0];
-                    sum[1] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[1];
-                    sum[2] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[2];
-                    sum[3] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[3];
-                }
+    //  returns the size of temporary buffer data
+    if (flags & kvImageGetTempBufferSize) {
+        return plan.tempBufferSize();
+    }
 
-                if (i > static_cast<int>(end_i)) {
-                    sum[0] += backgroundColor[0];
-                    sum[1] += backgroundColor[1];
-                    sum[2] += backgroundColor[2];
-                    sum[3] += backgroundColor[3];
-                } else if (i >= static_cast<int>(dest->height) - KH_d2) {
-                    sum[0] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[0];
-                    sum[1] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[1];
-                    sum[2] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[2];
-                    sum[3] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[3];
-                } else {
-                    sum[0] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[0];
-                    sum[1] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[1];
-                    sum[2] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[2];
-                    sum[3] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[3];
-                }
+    if (edge == kvImageBackgroundColorFill && backgroundColor == nullptr) {
+        return kvImageNullPointerArgument;
+    } else if (dest->width == 0 || dest->height == 0) {
+        return kvImageNoError;
+    }
 
-                temp_buf[(top + below) * dest_rowstride + i].val[0] = sum[0] > (255 * kernel_height) ? 255 : sum[0] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i].val[1] = sum[1] > (255 * kernel_height) ? 255 : sum[1] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i].val[2] = sum[2] > (255 * kernel_height) ? 255 : sum[2] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i].val[3] = sum[3] > (255 * kernel_height) ? 255 : sum[3] / kernel_height;
-            }
+    std::unique_ptr<uint8_t[]> allocated;
+    uint8_t* scratch = static_cast<uint8_t*>(tempBuffer);
+    if (scratch == nullptr) {
+        allocated.reset(new (std::nothrow) uint8_t[plan.tempBufferSize()]);
+        if (!allocated) {
+            return kvImageMemoryAllocationError;
+        }
+        scratch = allocated.get();
+    }
+    scratch += (8 - reinterpret_cast<uintptr_t>(scratch) % 8) % 8;
+
+    SeparableJob job;
+    job.src = static_cast<const Pixel_8888_s*>(src->data);
+    job.srcRowStride = src->rowBytes / sizeof(Pixel_8888);
+    job.srcWidth = static_cast<long>(src->width);
+    job.srcHeight = static_cast<long>(src->height);
+    job.dest = static_cast<Pixel_8888_s*>(dest->data);
+    job.destRowStride = dest->rowBytes / sizeof(Pixel_8888);
+    job.width = static_cast<long>(dest->width);
+    job.height = static_cast<long>(dest->height);
+    job.offsetX = static_cast<long>(srcOffsetToROI_X);
+    job.offsetY = static_cast<long>(srcOffsetToROI_Y);
+    job.radiusX = plan.radiusX;
+    job.radiusY = plan.radiusY;
+    job.shape = shape;
+    job.edge = edge;
+    job.leaveAlphaUnchanged = (flags & kvImageLeaveAlphaUnchanged) != 0;
+    for (int c = 0; c < 4; ++c) {
+        job.background.val[c] = backgroundColor ? backgroundColor[c] : 0;
+    }
 
-            for (uint32_t i = 0; i < dest->height; ++i) {
-                dest_buf[i * dest_rowstride + j] = temp_buf[(top + below) * dest_rowstride + i];
-            }
+    //  Truncated kernels are renormalized by the weights that actually landed on the image.
+    double* invNormX = reinterpret_cast<double*>(scratch);
+    for (long j = 0; j < job.width; ++j) {
+        long srcColumn = job.offsetX + j;
+        long first = -job.radiusX;
+        long last = job.radiusX;
+        if (edge == kvImageTruncateKernel) {
+            first = std::max(first, -srcColumn);
+            last = std::min(last, job.srcWidth - 1 - srcColumn);
         }
+        invNormX[j] = 1.0 / static_cast<double>(tapWeights(first, last, job.radiusX, shape));
     }
+    job.invNormX = invNormX;
 
-    //  This block deals with code for flag kvImageEdgeExtend, which requires all pixels outside image to be  
-    //  replicated by the edges of the image outwards.
-    else if (flags & kvImageEdgeExtend) {
-
-        //  For storing the first and the last pixel if the image is to be extended
-        Pixel_8888_s first_pixel;
-        Pixel_8888_s last_pixel;
-
-        //  First pass (horizontal)
-        for (int i = static_cast<int>(start_i) - KH_d2; i <= static_cast<int>(end_i) + KH_d2; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X;
-            first_pixel = src_buf[src_i * src_rowstride + src_j + (start_j - KW_d2)];
-            last_pixel = src_buf[src_i * src_rowstride + src_j + end_j + KW_d2];
-            sum[0] = first_pixel.val[0] * start_j;
-            sum[1] = first_pixel.val[1] * start_j;
-            sum[2] = first_pixel.val[2] * start_j;
-            sum[3] = first_pixel.val[3] * start_j;
-
-            for (int k = start_j - KW_d2; k <= KW_d2; ++k) {
-                sum[0] += src_buf[src_i * src_rowstride + src_j + k].val[0];
-                sum[1] += src_buf[src_i * src_rowstride + src_j + k].val[1];
-                sum[2] += src_buf[src_i * src_rowstride + src_j + k].val[2];
-                sum[3] += src_buf[src_i * src_rowstride + src_j + k].val[3];
-            }
+    uint8_t* tiles = scratch + plan.invNormBytes;
+    runTiles(dest->height, plan.tileCount, plan.rowsPerTile, [&](size_t firstRow, size_t endRow, size_t tile) {
+        separableTile(job, static_cast<long>(firstRow), static_cast<long>(endRow), tiles + tile * plan.tileBytes(), plan);
+    });
 
-            if (i<0) {
-                temp_buf[(top + i) * dest_rowstride].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                temp_buf[(top + i) * dest_rowstride].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                temp_buf[(top + i) * dest_rowstride].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                temp_buf[(top + i) * dest_rowstride].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-            } else if (i >= static_cast<int>(dest->height)) {
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[0]
-                    = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[1]
-                    = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[2]
-                    = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[3]
-                    = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-            } else {
-                dest_buf[i * dest_rowstride].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                dest_buf[i * dest_rowstride].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                dest_buf[i * dest_rowstride].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                dest_buf[i * dest_rowstride].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-            }
+    return kvImageNoError;
+}
 
-            src_j++;
-
-            for (uint32_t j = 1; j < dest->width; ++j, src_j++) {
-                if (j <= start_j) {
-                    sum[0] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[0] - first_pixel.val[0];
-                    sum[1] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[1] - first_pixel.val[1];
-                    sum[2] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[2] - first_pixel.val[2];
-                    sum[3] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[3] - first_pixel.val[3];
-                } else if (j <= end_j) {
-                    sum[0] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[0]
-                        - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0];
-                    sum[1] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[1]
-                        - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1];
-                    sum[2] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[2]
-                        - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2];
-                    sum[3] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[3]
-                       - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3];
-                } else {
-                    sum[0] += last_pixel.val[0] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0];
-                    sum[1] += last_pixel.val[1] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1];
-                    sum[2] += last_pixel.val[2] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2];
-                    sum[3] += last_pixel.val[3] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3];
-                }
+} // anonymous namespace
 
-                if (i < 0) {
-                    temp_buf[(top + i) * dest_rowstride + j].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                } else if (i >= static_cast<int>(dest->height)) {
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[0]
-                        = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[1]
-                        = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[2]
-                        = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[3]
-                        = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                } else {
-                    dest_buf[i * dest_rowstride + j].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                }
-            }
-        }
+/**
+@Status Interoperable
+*/
+vImage_Error vImageBoxConvolve_ARGB8888(const vImage_Buffer* src,
+                                        const vImage_Buffer* dest,
+                                        void* tempBuffer,
+                                        vImagePixelCount srcOffsetToROI_X,
+                                        vImagePixelCount srcOffsetToROI_Y,
+                                        uint32_t kernel_height,
+                                        uint32_t kernel_width,
+                                        const Pixel_8888 backgroundColor,
+                                        vImage_Flags flags) {
+    return separableConvolve(src,
+                             dest,
+                             tempBuffer,
+                             srcOffsetToROI_X,
+                             srcOffsetToROI_Y,
+                             kernel_height,
+                             kernel_width,
+                             backgroundColor,
+                             flags,
+                             KernelShape::Box);
+}
 
-        //  Second pass (vertical)
-        for (uint32_t j = 0; j < dest->width; ++j) {
-            if (top > 0) {
-                first_pixel = temp_buf[j];
-            } else {
-                first_pixel = dest_buf[j];
-            }
 
-            if (below > 0) {
-                last_pixel = temp_buf[(top + below - 1) * dest_rowstride + j];
-            } else {
-                last_pixel = dest_buf[(dest->height - 1) * dest_rowstride + j];
-            }
+/**
+@Status Interoperable
+*/
+vImage_Error vImageTentConvolve_ARGB8888(const vImage_Buffer* src,
+                                         const vImage_Buffer* dest,
+                                         void* tempBuffer,
+                                         vImagePixelCount srcOffsetToROI_X,
+                                         vImagePixelCount srcOffsetToROI_Y,
+                                         uint32_t kernel_height,
+                                         uint32_t kernel_width,
+                                         const Pixel_8888 backgroundColor,
+                                         vImage_Flags flags) {
+    return separableConvolve(src,
+                             dest,
+                             tempBuffer,
+                             srcOffsetToROI_X,
+                             srcOffsetToROI_Y,
+                             kernel_height,
+                             kernel_width,
+                             backgroundColor,
+                             flags,
+                             KernelShape::Tent);
+}
 
-            sum[0] = first_pixel.val[0] * start_i;
-            sum[1] = first_pixel.val[1] * start_i;
-            sum[2] = first_pixel.val[2] * start_i;
-            sum[3] = first_pixel.val[3] * start_i;
 
-            for (int k = start_i - KH_d2; k < 0; ++k) {
-                sum[0] += temp_buf[(top + k) * dest_rowstride + j].val[0];
-                sum[1] += temp_buf[(top + k) * dest_rowstride + j].val[1];
-                sum[2] += temp_buf[(top + k) * dest_rowstride + j].val[2];
-                sum[3] += temp_buf[(top + k) * dest_rowstride + j].val[3];
-            }
+/**
+@Status Interoperable
+@Notes No temporary buffer is needed; kvImageGetTempBufferSize returns 0
+*/
+vImage_Error vImageConvolve_ARGB8888(const vImage_Buffer* src,
+                                     const vImage_Buffer* dest,
+                                     void* tempBuffer,
+                                     vImagePixelCount srcOffsetToROI_X,
+                                     vImagePixelCount srcOffsetToROI_Y,
+                                     const int16_t* kernel,
+                                     uint32_t kernel_height,
+                                     uint32_t kernel_width,
+                                     int32_t divisor,
+                                     const Pixel_8888 backgroundColor,
+                                     vImage_Flags flags) {
+    vImage_Error error =
+        validateConvolution(src, dest, srcOffsetToROI_X, srcOffsetToROI_Y, kernel_height, kernel_width, flags);
+    if (error != kvImageNoError) {
+        return error;
+    } else if (kernel == nullptr) {
+        return kvImageNullPointerArgument;
+    } else if (flags & kvImageGetTempBufferSize) {
+        return 0;
+    }
 
-            for (int k = 0; k <= KH_d2; ++k) {
-                sum[0] += dest_buf[k * dest_rowstride + j].val[0];
-                sum[1] += dest_buf[k * dest_rowstride + j].val[1];
-                sum[2] += dest_buf[k * dest_rowstride + j].val[2];
-                sum[3] += dest_buf[k * dest_rowstride + j].val[3];
-            }
+    const vImage_Flags edge = edgeStyle(flags);
+    if (edge == kvImageBackgroundColorFill && backgroundColor == nullptr) {
+        return kvImageNullPointerArgument;
+    }
 
-            temp_buf[(top + below) * dest_rowstride].val[0] = sum[0] > (255 * kernel_height) ? 255 : sum[0] / kernel_height;
-            temp_buf[(top + below) * dest_rowstride].val[1] = sum[1] > (255 * kernel_height) ? 255 : sum[1] / kernel_height;
-            temp_buf[(top + below) * dest_rowstride].val[2] = sum[2] > (255 * kernel_height) ? 255 : sum[2] / kernel_height;
-            temp_buf[(top + below) * dest_rowstride].val[3] = sum[3] > (255 * kernel_height) ? 255 : sum[3] / kernel_height;
-
-            for (int i = 1; i < static_cast<int>(dest->height); ++i) {
-                if (i <= static_cast<int>(start_i)) {
-                    sum[0] -= first_pixel.val[0];
-                    sum[1] -= first_pixel.val[1];
-                    sum[2] -= first_pixel.val[2];
-                    sum[3] -= first_pixel.val[3];
-                } else if (i <= KH_d2) {
-                    sum[0] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[0];
-                    sum[1] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[1];
-                    sum[2] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[2];
-                    sum[3] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[3];
-                } else {
-                    sum[0] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[0];
-                    sum[1] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[1];
-                    sum[2] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[2];
-                    sum[3] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[3];
+    const Pixel_8888_s* src_buf = static_cast<const Pixel_8888_s*>(src->data);
+    Pixel_8888_s* dest_buf = static_cast<Pixel_8888_s*>(dest->data);
+    const size_t src_rowstride = src->rowBytes / sizeof(Pixel_8888);
+    const size_t dest_rowstride = dest->rowBytes / sizeof(Pixel_8888);
+    const long srcWidth = static_cast<long>(src->width);
+    const long srcHeight = static_cast<long>(src->height);
+    const long offsetX = static_cast<long>(srcOffsetToROI_X);
+    const long offsetY = static_cast<long>(srcOffsetToROI_Y);
+    const long KW_d2 = kernel_width / 2;
+    const long KH_d2 = kernel_height / 2;
+    const bool leaveAlphaUnchanged = (flags & kvImageLeaveAlphaUnchanged) != 0;
+    const double scale = 1.0 / (divisor == 0 ? 1 : divisor);
+
+    int64_t kernelSum = 0;
+    for (uint32_t k = 0; k < kernel_height * kernel_width; ++k) {
+        kernelSum += kernel[k];
+    }
+
+    //  A general kernel is not separable, so every output pixel visits the whole window. Pixels whose window lies
+    //  inside the source skip the edge handling.
+    auto convolveRows = [&](size_t firstRow, size_t endRow, size_t) {
+        for (long i = static_cast<long>(firstRow); i < static_cast<long>(endRow); ++i) {
+            long src_i = offsetY + i;
+            bool rowFits = src_i - KH_d2 >= 0 && src_i + KH_d2 < srcHeight;
+            for (long j = 0; j < static_cast<long>(dest->width); ++j) {
+                long src_j = offsetX + j;
+                const Pixel_8888_s& center = src_buf[src_i * src_rowstride + src_j];
+                bool fits = rowFits && src_j - KW_d2 >= 0 && src_j + KW_d2 < srcWidth;
+                Pixel_8888_s& out = dest_buf[i * dest_rowstride + j];
+
+                if (!fits && edge == kvImageCopyInPlace) {
+                    out = center;
+                    continue;
                 }
 
-                if (i > static_cast<int>(end_i)) {
-                    sum[0] += last_pixel.val[0];
-                    sum[1] += last_pixel.val[1];
-                    sum[2] += last_pixel.val[2];
-                    sum[3] += last_pixel.val[3];
-                } else if (i >= static_cast<int>(dest->height) - KH_d2) {
-                    sum[0] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[0];
-                    sum[1] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[1];
-                    sum[2] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[2];
-                    sum[3] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[3];
-                } else {
-                    sum[0] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[0];
-                    sum[1] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[1];
-                    sum[2] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[2];
-                    sum[3] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[3];
+                int64_t sum[4] = { 0 };
+                int64_t usedWeight = 0;
+                const int16_t* weight = kernel;
+                for (long y = src_i - KH_d2; y <= src_i + KH_d2; ++y) {
+                    for (long x = src_j - KW_d2; x <= src_j + KW_d2; ++x, ++weight) {
+                        const uint8_t* sample;
+                        if (fits || (y >= 0 && y < srcHeight && x >= 0 && x < srcWidth)) {
+                            sample = src_buf[y * src_rowstride + x].val;
+                        } else if (edge == kvImageBackgroundColorFill) {
+                            sample = backgroundColor;
+                        } else if (edge == kvImageTruncateKernel) {
+                            continue;
+                        } else {
+                            sample = src_buf[clampIndex(y, srcHeight) * src_rowstride + clampIndex(x, srcWidth)].val;
+                        }
+
+                        usedWeight += *weight;
+                        sum[0] += *weight * sample[0];
+                        sum[1] += *weight * sample[1];
+                        sum[2] += *weight * sample[2];
+                        sum[3] += *weight * sample[3];
+                    }
                 }
 
-                temp_buf[(top + below) * dest_rowstride + i].val[0] = sum[0] > (255 * kernel_height) ? 255 : sum[0] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i].val[1] = sum[1] > (255 * kernel_height) ? 255 : sum[1] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i].val[2] = sum[2] > (255 * kernel_height) ? 255 : sum[2] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i].val[3] = sum[3] > (255 * kernel_height) ? 255 : sum[3] / kernel_height;
-            }
+                //  Truncated kernels are rescaled to the weight of the whole kernel
+                double pixelScale = scale;
+                if (edge == kvImageTruncateKernel && usedWeight != 0 && usedWeight != kernelSum) {
+                    pixelScale *= static_cast<double>(kernelSum) / static_cast<double>(usedWeight);
+                }
 
-            for (uint32_t i = 0; i < dest->height; ++i) {
-                dest_buf[i * dest_rowstride + j] = temp_buf[(top + below) * dest_rowstride + i];
+                for (int c = 0; c < 4; ++c) {
+                    out.val[c] = roundToPixel(static_cast<double>(sum[c]) * pixelScale);
+                }
+                if (leaveAlphaUnchanged) {
+                    out.val[0] = center.val[0];
+                }
             }
         }
-    } else {
-        return kvImageUnknownFlagsBit;
-    }
+    };
 
-    //  Deallocating the temporary buffer
-    if (tempBuffer_flag == 1) {
-        delete[] temp_buf;
-    }
+    size_t tileCount = tileCountFor(dest, flags);
+    runTiles(dest->height, tileCount, (dest->height + tileCount - 1) / tileCount, convolveRows);
 
     return kvImageNoError;
 }
@@ -38,8 +38,6 @@ static const wchar_t* TAG = L"CGContext";
 int contextCount = 0;
 static IWLazyClassLookup _LazyUIImage("UIImage"), _LazyUIScreen("UIScreen");
 
-EbrLock _cairoLock = EBRLOCK_INITIALIZE;
-
 @interface CGNSContext : _CGLifetimeBridgingType
 @end
 
@@ -49,6 +49,25 @@ static IWLazyIvarLookup<float> _LazyUIFontHorizontalScale(_LazyUIFont, "_horizon
 static IWLazyIvarLookup<void*> _LazyUIFontHandle(_LazyUIFont, "_font");
 static IWLazyIvarLookup<void*> _LazyUISizingFontHandle(_LazyUIFont, "_sizingFont");
 
+// Drawing calls hold the destination image's drawing lock (LOCK_CAIRO), so contexts rendering into different images run
+// in parallel. Images read as sources, masks and patterns may be in use by several contexts at once, and taking a
+// surface reference can create or discard the surface lazily, so those references go through one short-lived lock.
+// It is only ever taken innermost, never while waiting for a drawing lock.
+static EbrLock _surfaceReferenceLock = EBRLOCK_INITIALIZE;
+
+static cairo_surface_t* _LockCairoSurface(CGImageRef img) {
+    EbrLockEnter(_surfaceReferenceLock);
+    cairo_surface_t* surface = img->Backing()->LockCairoSurface();
+    EbrLockLeave(_surfaceReferenceLock);
+    return surface;
+}
+
+static void _ReleaseCairoSurface(CGImageRef img) {
+    EbrLockEnter(_surfaceReferenceLock);
+    img->Backing()->ReleaseCairoSurface();
+    EbrLockLeave(_surfaceReferenceLock);
+}
+
 CGContextCairo::CGContextCairo(CGContextRef base, CGImageRef destinationImage)
     : CGContextImpl(base, destinationImage), _drawContext(0), _filter(CAIRO_FILTER_BILINEAR) {
 }
@@ -62,7 +81,7 @@ void CGContextCairo::ObtainLock() {
         return;
 
     LOCK_CAIRO();
-    _drawContext = cairo_create(_imgDest->Backing()->LockCairoSurface());
+    _drawContext = cairo_create(_LockCairoSurface(_imgDest));
     UNLOCK_CAIRO();
     // cairo_set_antialias(_drawContext, CAIRO_ANTIALIAS_NONE);
 }
@@ -72,7 +91,7 @@ void CGContextCairo::ReleaseLock() {
         LOCK_CAIRO();
         cairo_destroy(_drawContext);
         UNLOCK_CAIRO();
-        _imgDest->Backing()->ReleaseCairoSurface();
+        _ReleaseCairoSurface(_imgDest);
         _drawContext = NULL;
     }
 }
@@ -92,6 +111,7 @@ void CGContextCairo::Clear(float r, float g, float b, float a) {
     rct.size.width = float(_imgDest->Backing()->Width());
     rct.size.height = float(_imgDest->Backing()->Height());
 
+    LOCK_CAIRO();
     cairo_save(_drawContext);
     cairo_new_path(_drawContext);
     cairo_rectangle(_drawContext, rct.origin.x, rct.origin.y, rct.size.width, rct.size.height);
@@ -100,6 +120,7 @@ void CGContextCairo::Clear(float r, float g, float b, float a) {
     cairo_fill(_drawContext);
 
     cairo_restore(_drawContext);
+    UNLOCK_CAIRO();
 }
 
 void CGContextCairo::DrawImage(CGImageRef img, CGRect src, CGRect dest, bool tiled) {
@@ -135,7 +156,9 @@ void CGContextCairo::DrawImage(CGImageRef img, CGRect src, CGRect dest, bool til
         cairo_translate(_drawContext, dest.origin.x, dest.origin.y);
 
         float r, g, b, a;
+        EbrLockEnter(_surfaceReferenceLock);
         img->Backing()->GetPixel(int(src.origin.x), int(src.origin.y), r, g, b, a);
+        EbrLockLeave(_surfaceReferenceLock);
         cairo_set_source_rgba(_drawContext, r, g, b, a);
         cairo_pattern_t* pattern = cairo_get_source(_drawContext);
         _assignAndResetFilter(pattern);
@@ -153,7 +176,7 @@ void CGContextCairo::DrawImage(CGImageRef img, CGRect src, CGRect dest, bool til
         cairo_save(_drawContext);
 
         cairo_matrix_t srcMatrix;
-        cairo_pattern_t* p = cairo_pattern_create_for_surface(img->Backing()->LockCairoSurface());
+        cairo_pattern_t* p = cairo_pattern_create_for_surface(_LockCairoSurface(img));
         _assignAndResetFilter(p);
 
         if (tiled) {
@@ -194,8 +217,8 @@ void CGContextCairo::DrawImage(CGImageRef img, CGRect src, CGRect dest, bool til
         if (curState->_imgMask == NULL) {
             cairo_paint(_drawContext);
         } else {
-            cairo_mask_surface(_drawContext, curState->_imgMask->Backing()->LockCairoSurface(), 0.0, 0.0);
-            curState->_imgMask->Backing()->ReleaseCairoSurface();
+            cairo_mask_surface(_drawContext, _LockCairoSurface(curState->_imgMask), 0.0, 0.0);
+            _ReleaseCairoSurface(curState->_imgMask);
         }
 
         cairo_pattern_destroy(p);
@@ -205,7 +228,7 @@ void CGContextCairo::DrawImage(CGImageRef img, CGRect src, CGRect dest, bool til
         cairo_append_path(_drawContext, curPath);
         cairo_path_destroy(curPath);
 
-        img->Backing()->ReleaseCairoSurface();
+        _ReleaseCairoSurface(img);
     }
     UNLOCK_CAIRO();
 }
@@ -678,8 +701,8 @@ void CGContextCairo::CGContextFillRect(CGRect rct) {
     if (curState->_imgMask == NULL) {
         cairo_fill(_drawContext);
     } else {
-        cairo_mask_surface(_drawContext, curState->_imgMask->Backing()->LockCairoSurface(), 0.0, 0.0);
-        curState->_imgMask->Backing()->ReleaseCairoSurface();
+        cairo_mask_surface(_drawContext, _LockCairoSurface(curState->_imgMask), 0.0, 0.0);
+        _ReleaseCairoSurface(curState->_imgMask);
     }
 
     cairo_restore(_drawContext);
@@ -839,7 +862,7 @@ void CGContextCairo::setFillColorSource() {
             patTrans = [(CGPattern*)curState->curFillColorObject getPatternTransform];
         }
 
-        cairo_pattern_t* p = cairo_pattern_create_for_surface(pattern->Backing()->LockCairoSurface());
+        cairo_pattern_t* p = cairo_pattern_create_for_surface(_LockCairoSurface(pattern));
         cairo_pattern_set_extend(p, CAIRO_EXTEND_REPEAT);
 
         cairo_matrix_t m = { 0 };
@@ -858,7 +881,7 @@ void CGContextCairo::setFillColorSource() {
         cairo_set_source(_drawContext, p);
         cairo_pattern_destroy(p);
 
-        pattern->Backing()->ReleaseCairoSurface();
+        _ReleaseCairoSurface(pattern);
         CGImageRelease(pattern);
     }
 }
@@ -1215,8 +1238,8 @@ void CGContextCairo::CGContextDrawLinearGradient(CGGradientRef gradient, CGPoint
 
     cairo_set_source(_drawContext, pattern);
     if (curState->_imgMask != NULL) {
-        cairo_mask_surface(_drawContext, curState->_imgMask->Backing()->LockCairoSurface(), 0.0, 0.0);
-        curState->_imgMask->Backing()->ReleaseCairoSurface();
+        cairo_mask_surface(_drawContext, _LockCairoSurface(curState->_imgMask), 0.0, 0.0);
+        _ReleaseCairoSurface(curState->_imgMask);
     } else {
         cairo_paint(_drawContext);
     }
@@ -1256,8 +1279,8 @@ void CGContextCairo::CGContextDrawRadialGradient(
 
     cairo_set_source(_drawContext, pattern);
     if (curState->_imgMask != NULL) {
-        cairo_mask_surface(_drawContext, curState->_imgMask->Backing()->LockCairoSurface(), 0.0, 0.0);
-        curState->_imgMask->Backing()->ReleaseCairoSurface();
+        cairo_mask_surface(_drawContext, _LockCairoSurface(curState->_imgMask), 0.0, 0.0);
+        _ReleaseCairoSurface(curState->_imgMask);
     } else {
         cairo_paint(_drawContext);
     }
@@ -1484,7 +1507,11 @@ void CGContextCairo::CGContextClipToRect(CGRect rect) {
 
 void CGContextCairo::CGContextBeginTransparencyLayer(id auxInfo) {
     //  [To future blamb, next time you comment this out, make a note as to why]
+    ObtainLock();
+
+    LOCK_CAIRO();
     cairo_push_group(_drawContext);
+    UNLOCK_CAIRO();
 }
 
 void CGContextCairo::CGContextEndTransparencyLayer() {
@@ -20,69 +20,243 @@
 #include "CoreTextInternal.h"
 #include "CGPathInternal.h"
 
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
 @implementation _CTFrameSetter : NSObject
 - (void)dealloc {
     [super dealloc];
 }
 @end
 
-static id _createFrame(_CTFrameSetter* frameSetter, CGRect frameSize, CGSize* sizeOut, bool createFrame) {
-    _CTFrame* ret = nil;
+static const size_t c_defaultLineLayoutCacheCapacity = 256;
 
-    if (createFrame) {
-        ret = [_CTFrame alloc];
-        ret->_frameSetter = [frameSetter retain];
-        ret->_frameRect = frameSize;
+namespace {
+struct LineLayout {
+    CFRange range;
+    float width;
+    float ascent;
+    float height;
+};
 
-        ret->_lines.attach([NSMutableArray new]);
+struct FrameLayout {
+    std::vector<LineLayout> lines;
+    CGSize size;
+};
+
+//  Line breaks for recently laid out (attributed string, width) pairs, least recently used first out. Sizing a label and
+//  then drawing it, or sizing the same cell content while scrolling, lays out identical input again and again.
+class LineLayoutCache {
+public:
+    std::shared_ptr<const FrameLayout> find(NSUInteger contentHash, CGFloat width, NSAttributedString* string) {
+        std::lock_guard<std::mutex> lock(_lock);
+        auto found = _find(contentHash, width, string);
+        if (found == _entries.end()) {
+            _statistics.misses++;
+            return nullptr;
+        }
+
+        _statistics.hits++;
+        _entries.splice(_entries.begin(), _entries, found);
+        return found->layout;
+    }
+
+    void insert(NSUInteger contentHash, CGFloat width, NSAttributedString* string, const std::shared_ptr<const FrameLayout>& layout) {
+        std::lock_guard<std::mutex> lock(_lock);
+        if (_statistics.capacity == 0 || _find(contentHash, width, string) != _entries.end()) {
+            return;
+        }
+
+        _entries.emplace_front();
+        Entry& entry = _entries.front();
+        entry.contentHash = contentHash;
+        entry.width = width;
+        entry.string.attach([string copy]);
+        entry.layout = layout;
+        _index.emplace(contentHash, _entries.begin());
+        _trim();
+    }
+
+    void setCapacity(size_t capacity) {
+        std::lock_guard<std::mutex> lock(_lock);
+        _statistics.capacity = capacity;
+        _trim();
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(_lock);
+        _index.clear();
+        _entries.clear();
+        size_t capacity = _statistics.capacity;
+        _statistics = {};
+        _statistics.capacity = capacity;
+    }
+
+    _CTFramesetterCacheStatistics statistics() {
+        std::lock_guard<std::mutex> lock(_lock);
+        _CTFramesetterCacheStatistics ret = _statistics;
+        ret.count = _entries.size();
+        return ret;
+    }
+
+private:
+    struct Entry {
+        NSUInteger contentHash;
+        CGFloat width;
+        StrongId<NSAttributedString> string;
+        std::shared_ptr<const FrameLayout> layout;
+    };
+
+    std::list<Entry>::iterator _find(NSUInteger contentHash, CGFloat width, NSAttributedString* string) {
+        auto candidates = _index.equal_range(contentHash);
+        for (auto candidate = candidates.first; candidate != candidates.second; ++candidate) {
+            Entry& entry = *candidate->second;
+            if (entry.width == width && [entry.string isEqualToAttributedString:string]) {
+                return candidate->second;
+            }
+        }
+        return _entries.end();
+    }
+
+    void _trim() {
+        while (_entries.size() > _statistics.capacity) {
+            auto candidates = _index.equal_range(_entries.back().contentHash);
+            for (auto candidate = candidates.first; candidate != candidates.second; ++candidate) {
+                if (candidate->second == std::prev(_entries.end())) {
+                    _index.erase(candidate);
+                    break;
+                }
+            }
+            _entries.pop_back();
+            _statistics.evictions++;
+        }
+    }
+
+    std::mutex _lock;
+    std::list<Entry> _entries;
+    std::unordered_multimap<NSUInteger, std::list<Entry>::iterator> _index;
+    _CTFramesetterCacheStatistics _statistics = { 0, 0, 0, 0, c_defaultLineLayoutCacheCapacity };
+};
+}
+
+static LineLayoutCache& _lineLayoutCache() {
+    static LineLayoutCache s_cache;
+    return s_cache;
+}
+
+//  Hashes the characters and attribute runs, consistently with -[NSAttributedString isEqualToAttributedString:]
+static NSUInteger _hashContent(_CTTypesetter* typesetter) {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint64_t value) {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+
+    for (CFIndex i = 0; i < typesetter->_charactersLen; i++) {
+        mix(typesetter->_characters[i]);
     }
 
-    sizeOut->width = 0;
-    sizeOut->height = 0;
+    NSRange range;
+    for (NSUInteger index = 0; index < (NSUInteger)typesetter->_charactersLen; index += range.length) {
+        NSDictionary* attributes = [typesetter->_attributedString attributesAtIndex:index effectiveRange:&range];
+        if (range.length == 0) {
+            break;
+        }
 
-    float y = frameSize.size.height; //[font ascender];
+        //  Summed, as the order dictionaries enumerate in isn't part of their equality
+        NSUInteger attributesHash = 0;
+        for (id key in attributes) {
+            attributesHash += [key hash] * 31 + [[attributes objectForKey:key] hash];
+        }
+
+        mix(range.location);
+        mix(range.length);
+        mix(attributesHash);
+    }
+
+    return (NSUInteger)hash;
+}
+
+static std::shared_ptr<const FrameLayout> _layoutLines(_CTFrameSetter* frameSetter, CGFloat width, NSMutableArray* lines) {
+    std::shared_ptr<FrameLayout> ret = std::make_shared<FrameLayout>();
+    ret->size = CGSizeZero;
+
+    CTTypesetterRef typesetter = (CTTypesetterRef)(_CTTypesetter*)frameSetter->_typesetter;
     CFIndex curIdx = 0;
-    NSString* string = [frameSetter->_typesetter->_attributedString string];
-    CFIndex stringRange = [string length];
 
     for (;;) {
-        CFIndex pos = CTTypesetterSuggestLineBreakWithOffset((CTTypesetterRef)(_CTTypesetter*)frameSetter->_typesetter,
-                                                             curIdx,
-                                                             frameSize.size.width,
-                                                             0.0f);
+        CFIndex pos = CTTypesetterSuggestLineBreakWithOffset(typesetter, curIdx, width, 0.0f);
         if (pos == curIdx)
             break;
 
-        CFRange lineRange;
-        lineRange.location = curIdx;
-        lineRange.length = pos - curIdx;
+        LineLayout lineLayout;
+        lineLayout.range.location = curIdx;
+        lineLayout.range.length = pos - curIdx;
 
-        CTLineRef line = CTTypesetterCreateLineWithOffset((CTTypesetterRef)(_CTTypesetter*)frameSetter->_typesetter, lineRange, 0.0f);
+        CTLineRef line = CTTypesetterCreateLineWithOffset(typesetter, lineLayout.range, 0.0f);
 
         float ascent = 0.0f, descent = 0.0f, leading = 0.0f;
-        float width = CTLineGetTypographicBounds(line, &ascent, &descent, &leading);
-        float lineHeight = ascent - descent + leading;
+        lineLayout.width = CTLineGetTypographicBounds(line, &ascent, &descent, &leading);
+        lineLayout.ascent = ascent;
+        lineLayout.height = ascent - descent + leading;
+        ret->lines.push_back(lineLayout);
 
-        if (ret) {
-            CGPoint lineOrigin;
-            lineOrigin.x = 0.0f;
-            lineOrigin.y = y - ascent;
-            [ret->_lines addObject:(id)line];
-            ret->_lineOrigins.push_back(lineOrigin);
-        }
+        [lines addObject:(id)line];
         [line release];
 
         curIdx = pos;
-        if (width > sizeOut->width) {
-            sizeOut->width = width;
+        if (lineLayout.width > ret->size.width) {
+            ret->size.width = lineLayout.width;
         }
 
-        sizeOut->height += lineHeight;
+        ret->size.height += lineLayout.height;
+    }
+
+    return ret;
+}
+
+static id _createFrame(_CTFrameSetter* frameSetter, CGRect frameSize, CGSize* sizeOut, bool createFrame) {
+    _CTFrame* ret = nil;
 
-        y -= lineHeight;
+    if (createFrame) {
+        ret = [_CTFrame alloc];
+        ret->_frameSetter = [frameSetter retain];
+        ret->_frameRect = frameSize;
+
+        ret->_lines.attach([NSMutableArray new]);
+    }
+
+    NSAttributedString* string = frameSetter->_typesetter->_attributedString;
+    std::shared_ptr<const FrameLayout> layout = _lineLayoutCache().find(frameSetter->_contentHash, frameSize.size.width, string);
+    if (layout) {
+        if (ret) {
+            for (const LineLayout& lineLayout : layout->lines) {
+                CTLineRef line =
+                    CTTypesetterCreateLineWithOffset((CTTypesetterRef)(_CTTypesetter*)frameSetter->_typesetter, lineLayout.range, 0.0f);
+                [ret->_lines addObject:(id)line];
+                [line release];
+            }
+        }
+    } else {
+        layout = _layoutLines(frameSetter, frameSize.size.width, ret ? (NSMutableArray*)ret->_lines : nil);
+        _lineLayoutCache().insert(frameSetter->_contentHash, frameSize.size.width, string, layout);
     }
 
+    *sizeOut = layout->size;
+
     if (ret) {
+        float y = frameSize.size.height; //[font ascender];
+        for (const LineLayout& lineLayout : layout->lines) {
+            CGPoint lineOrigin;
+            lineOrigin.x = 0.0f;
+            lineOrigin.y = y - lineLayout.ascent;
+            ret->_lineOrigins.push_back(lineOrigin);
+
+            y -= lineLayout.height;
+        }
+
         ret->_totalSize = *sizeOut;
     }
 
@@ -95,6 +269,7 @@ static id _createFrame(_CTFrameSetter* frameSetter, CGRect frameSize, CGSize* si
 CTFramesetterRef CTFramesetterCreateWithAttributedString(CFAttributedStringRef string) {
     _CTFrameSetter* ret = [_CTFrameSetter alloc];
     ret->_typesetter = (_CTTypesetter*)CTTypesetterCreateWithAttributedString(string);
+    ret->_contentHash = _hashContent(ret->_typesetter);
     return (CTFramesetterRef)ret;
 }
 
@@ -145,3 +320,16 @@ CFTypeID CTFramesetterGetTypeID() {
     UNIMPLEMENTED();
     return StubReturn();
 }
+
+// Private/exported functions
+void _CTFramesetterGetCacheStatistics(_CTFramesetterCacheStatistics* statistics) {
+    *statistics = _lineLayoutCache().statistics();
+}
+
+void _CTFramesetterSetCacheCapacity(size_t capacity) {
+    _lineLayoutCache().setCapacity(capacity);
+}
+
+void _CTFramesetterResetCache() {
+    _lineLayoutCache().reset();
+}
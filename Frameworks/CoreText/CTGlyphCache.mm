@@ -0,0 +1,182 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#import "CoreTextInternal.h"
+#import "CGFontInternal.h"
+#import "UIFontInternal.h"
+
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+extern "C" {
+#include <ft2build.h>
+#include FT_FREETYPE_H
+}
+
+#include "LoggingNative.h"
+
+static const wchar_t* TAG = L"CTGlyphCache";
+
+static IWLazyClassLookup _LazyUIFont("UIFont");
+static IWLazyIvarLookup<float> _LazyUIFontHorizontalScale(_LazyUIFont, "_horizontalScale");
+
+//  Sizing faces are shared between UIFonts and never freed, so a face pointer names the same face for the life of the
+//  process. Character to glyph index lookups belong to the face; advances and line metrics belong to one pixel size of
+//  it (a strike).
+static const uint32_t c_pageSize = 256;
+static const uint32_t c_pageCount = 256;
+static const size_t c_maxStrikesPerFace = 32;
+static const uint32_t c_unknownGlyphIndex = UINT_MAX;
+static const int32_t c_unknownAdvance = INT_MIN;
+
+//  A table indexed by 16-bit characters or glyph indices; pages are allocated as they are first touched.
+template <typename T, T empty>
+class GlyphPagedTable {
+public:
+    bool covers(uint32_t index) const {
+        return index < c_pageSize * c_pageCount;
+    }
+
+    T& operator[](uint32_t index) {
+        std::unique_ptr<T[]>& page = _pages[index / c_pageSize];
+        if (!page) {
+            page.reset(new T[c_pageSize]);
+            std::fill(page.get(), page.get() + c_pageSize, empty);
+        }
+        return page[index % c_pageSize];
+    }
+
+private:
+    std::unique_ptr<T[]> _pages[c_pageCount];
+};
+
+struct GlyphStrike {
+    _CTGlyphLineMetrics lineMetrics;
+    GlyphPagedTable<int32_t, c_unknownAdvance> advances;
+};
+
+struct GlyphFace {
+    std::mutex lock;
+    GlyphPagedTable<uint32_t, c_unknownGlyphIndex> glyphIndices;
+    std::unordered_map<uint64_t, std::unique_ptr<GlyphStrike>> strikes;
+};
+
+//  Takes the FreeType lock and sizes the face the first time a lookup misses, and releases it when the lookup is done.
+class SizedFaceLock {
+public:
+    SizedFaceLock(id font, FT_Face face) : _font(font), _face(face), _locked(false) {
+    }
+
+    ~SizedFaceLock() {
+        if (_locked) {
+            _CGFontUnlock();
+        }
+    }
+
+    FT_Face acquire() {
+        if (!_locked) {
+            _CGFontLock();
+            _locked = true;
+            CGFontSetFTFontSize(_font, _face, [_font pointSize]);
+        }
+        return _face;
+    }
+
+private:
+    id _font;
+    FT_Face _face;
+    bool _locked;
+};
+
+static GlyphFace& _faceForHandle(FT_Face handle) {
+    static std::mutex s_facesLock;
+    static std::unordered_map<FT_Face, std::unique_ptr<GlyphFace>> s_faces;
+
+    std::lock_guard<std::mutex> lock(s_facesLock);
+    std::unique_ptr<GlyphFace>& face = s_faces[handle];
+    if (!face) {
+        face.reset(new GlyphFace());
+    }
+    return *face;
+}
+
+//  The arguments CGFontSetFTFontSize passes to FT_Set_Char_Size, which fix the pixel size of the face
+static uint64_t _strikeKeyForFont(id font) {
+    uint64_t charSize = (uint32_t)(FT_F26Dot6)([font pointSize] * 64.0f);
+    uint64_t horizontalResolution = (uint16_t)(FT_UInt)(72.f * _LazyUIFontHorizontalScale.member(font));
+    return (charSize << 32) | (horizontalResolution << 16) | 72;
+}
+
+void _CTGlyphCacheGetAdvancesForCharacters(
+    id font, const WORD* characters, CFIndex count, int32_t* advances, _CTGlyphLineMetrics* lineMetrics) {
+    FT_Face handle = (FT_Face)[font _sizingFontHandle];
+    if (!handle) {
+        std::fill(advances, advances + count, 0);
+        if (lineMetrics) {
+            *lineMetrics = { 0, 0 };
+        }
+        return;
+    }
+
+    GlyphFace& face = _faceForHandle(handle);
+    SizedFaceLock sizedFace(font, handle);
+    std::lock_guard<std::mutex> lock(face.lock);
+
+    uint64_t strikeKey = _strikeKeyForFont(font);
+    auto found = face.strikes.find(strikeKey);
+    if (found == face.strikes.end()) {
+        //  Fonts animated through many sizes would otherwise grow the cache without bound
+        if (face.strikes.size() >= c_maxStrikesPerFace) {
+            face.strikes.clear();
+        }
+
+        FT_Face sized = sizedFace.acquire();
+        std::unique_ptr<GlyphStrike> strike(new GlyphStrike());
+        strike->lineMetrics.ascender = sized->size->metrics.ascender;
+        strike->lineMetrics.descender = sized->size->metrics.descender;
+        found = face.strikes.emplace(strikeKey, std::move(strike)).first;
+    }
+
+    GlyphStrike& strike = *found->second;
+    if (lineMetrics) {
+        *lineMetrics = strike.lineMetrics;
+    }
+
+    for (CFIndex i = 0; i < count; i++) {
+        uint32_t& glyphIndex = face.glyphIndices[characters[i]];
+        if (glyphIndex == c_unknownGlyphIndex) {
+            glyphIndex = FT_Get_Char_Index(sizedFace.acquire(), characters[i]);
+        }
+
+        //  Glyph indices past 16 bits are rare enough to measure every time
+        int32_t uncachedAdvance = c_unknownAdvance;
+        int32_t& advance = strike.advances.covers(glyphIndex) ? strike.advances[glyphIndex] : uncachedAdvance;
+        if (advance == c_unknownAdvance) {
+            FT_Face sized = sizedFace.acquire();
+            if (FT_Load_Glyph(sized, glyphIndex, FT_LOAD_NO_HINTING) == 0) {
+                advance = sized->glyph->advance.x;
+            } else {
+                TraceWarning(TAG, L"Glyph %d not found", characters[i]);
+                advance = 0;
+            }
+        }
+
+        advances[i] = advance;
+    }
+}
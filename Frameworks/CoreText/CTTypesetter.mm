@@ -47,6 +47,7 @@ static IWLazyClassLookup _LazyUIFont("UIFont");
 
 static const float c_spacing = 1.0f;
 static const float default_system_font_size = 15.0f;
+static const CFIndex c_measureChunkLength = 256;
 
 @implementation _CTTypesetter
 - (instancetype)initWithAttributedString:(NSAttributedString*)str {
@@ -105,10 +106,25 @@ static CFIndex _DoWrap(CTTypesetterRef ts, CFRange range, WidthFinderFunc widthF
     lineStart = curIndex;
 
     NSRange curAttributeRange = { 0 };
-    FT_Face curFace;
-    float curFontHeight = 0.0f;
+    UIFont* curFont = nil;
     float maxWidth = FLT_MAX;
 
+    //  Attribute runs seen while measuring, so building the line's runs doesn't look them up again
+    std::vector<std::pair<NSRange, NSDictionary*>> seenAttributes;
+
+    //  Advances of the characters from advancesStart on, measured through the glyph cache a chunk at a time so a long
+    //  run that breaks early isn't measured to its end on every line
+    std::vector<int32_t> advances;
+    CFIndex advancesStart = 0;
+    _CTGlyphLineMetrics lineMetrics;
+    auto measureFrom = [&](CFIndex index) {
+        CFIndex end = std::min((CFIndex)(curAttributeRange.location + curAttributeRange.length), (CFIndex)count);
+        end = std::min(end, index + c_measureChunkLength);
+        advancesStart = index;
+        advances.resize(end - index);
+        _CTGlyphCacheGetAdvancesForCharacters(curFont, chars + index, end - index, advances.data(), &lineMetrics);
+    };
+
     //  Lookup each glyph
     while (curIndex < count) {
         glyphOrigins.push_back(CGPointMake(((float)penX) / 64.0f, 0.0f));
@@ -137,52 +153,40 @@ static CFIndex _DoWrap(CTTypesetterRef ts, CFRange range, WidthFinderFunc widthF
             break;
         }
 
-        FT_Vector advance;
-
-        advance.x = 0;
-        advance.y = 0;
+        FT_Pos advance = 0;
 
         //  Have we reached a new attribute range?
         if (curIndex < curAttributeRange.location || curIndex >= (curAttributeRange.location + curAttributeRange.length)) {
             //  Grab and set the new font
             NSDictionary* attribs = [typeSetter->_attributedString attributesAtIndex:curIndex effectiveRange:&curAttributeRange];
-            UIFont* font = [attribs objectForKey:(NSString*)kCTFontAttributeName];
-            if (font == nil) {
-                font = [_LazyUIFont systemFontOfSize:default_system_font_size];
+            seenAttributes.emplace_back(curAttributeRange, attribs);
+            curFont = [attribs objectForKey:(NSString*)kCTFontAttributeName];
+            if (curFont == nil) {
+                curFont = [_LazyUIFont systemFontOfSize:default_system_font_size];
             }
-            curFace = (FT_Face)[font _sizingFontHandle];
-            CGFontSetFTFontSize(font, curFace, [font pointSize]);
+            measureFrom(curIndex);
 
-            float fontHeight = ((float)(curFace->size->metrics.ascender - curFace->size->metrics.descender)) * c_spacing / 64.0f;
+            float fontHeight = ((float)(lineMetrics.ascender - lineMetrics.descender)) * c_spacing / 64.0f;
             float curX = ((float)penX) / 64.0f;
             float width = widthFunc(widthParam, curIndex, curX, fontHeight);
 
             maxWidth = curX + width;
+        } else if (curIndex >= advancesStart + (CFIndex)advances.size()) {
+            measureFrom(curIndex);
         }
 
         //  Grab the width of the current character
-        FT_Error error;
-
         if (curChar != 13) {
-            FT_UInt index = FT_Get_Char_Index(curFace, curChar);
-
-            error = FT_Load_Glyph(curFace, index, FT_LOAD_NO_HINTING);
-            FT_GlyphSlot slot = curFace->glyph;
-
-            if (error == 0) {
-                advance.x = slot->advance.x;
-            } else {
-                TraceWarning(TAG, L"Glyph %d not found", curChar);
-            }
+            advance = advances[curIndex - advancesStart];
 
             if (curChar == ' ') {
                 //  Soft linebreak possibility
                 lastPossibleBreakPos = curIndex;
                 lastPossibleBreakWidth = penX;
             }
-            penX += advance.x;
+            penX += advance;
 
-            glyphAdvance.width = ((float)advance.x) / 64.0f;
+            glyphAdvance.width = ((float)advance) / 64.0f;
         }
 
         float curWidth;
@@ -200,7 +204,7 @@ static CFIndex _DoWrap(CTTypesetterRef ts, CFRange range, WidthFinderFunc widthF
             } else {
                 if (lineStart != curIndex) {
                     //  Back out the last character
-                    penX -= advance.x;
+                    penX -= advance;
                 }
                 lineWidth = ((float)penX) / 64.0f;
                 break;
@@ -227,9 +231,17 @@ static CFIndex _DoWrap(CTTypesetterRef ts, CFRange range, WidthFinderFunc widthF
         float leading = 0.0f;
         NSRange curRange;
         unsigned glyphIdx = 0;
+        unsigned seenIdx = 0;
 
         while (curIdx < lineRange.location + lineRange.length) {
-            id attribs = [typeSetter->_attributedString attributesAtIndex:curIdx effectiveRange:&curRange];
+            id attribs;
+            if (seenIdx < seenAttributes.size() && NSLocationInRange(curIdx, seenAttributes[seenIdx].first)) {
+                curRange = seenAttributes[seenIdx].first;
+                attribs = seenAttributes[seenIdx].second;
+                seenIdx++;
+            } else {
+                attribs = [typeSetter->_attributedString attributesAtIndex:curIdx effectiveRange:&curRange];
+            }
             int fragmentLen = curRange.location + curRange.length - curIdx;
 
             NSRange runRange;
@@ -128,12 +128,21 @@ public:
     }
 };
 
+static CALayerPassStatistics _passStatistics;
+
 static void GetNeededLayouts(CAPrivateInfo* state, NodeList<CAPrivateInfo>* list, bool doAlwaysLayers) {
     CAPrivateInfo* cur = state;
+    _passStatistics.layoutNodesVisited++;
     if (cur->needsLayout || (doAlwaysLayers && cur->alwaysLayout && !cur->didLayout)) {
         list->AddNode(cur);
     }
 
+    //  Only subtrees flagged as dirty are searched; layers are only found through their ancestors' flags
+    if (!cur->descendantNeedsLayout) {
+        return;
+    }
+    cur->descendantNeedsLayout = FALSE;
+
     cur = cur->lastChild;
     while (cur) {
         GetNeededLayouts(cur, list, doAlwaysLayers);
@@ -144,6 +153,7 @@ static void GetNeededLayouts(CAPrivateInfo* state, NodeList<CAPrivateInfo>* list
 void DoLayerLayouts(CALayer* window, bool doAlwaysLayers) {
     NodeList<CAPrivateInfo> list;
     for (;;) {
+        _passStatistics.layoutPasses++;
         GetNeededLayouts(window->priv, &list, doAlwaysLayers);
 
         if (list.curPos == list.count) {
@@ -153,6 +163,7 @@ void DoLayerLayouts(CALayer* window, bool doAlwaysLayers) {
             list.items[list.curPos]->needsLayout = FALSE;
             list.items[list.curPos]->didLayout = TRUE;
             [list.items[list.curPos]->self layoutSublayers];
+            _passStatistics.layoutsPerformed++;
             list.curPos++;
         }
     }
@@ -164,10 +175,16 @@ void DoLayerLayouts(CALayer* window, bool doAlwaysLayers) {
 
 static void GetNeededDisplays(CAPrivateInfo* state, NodeList<CAPrivateInfo>* list) {
     CAPrivateInfo* cur = state;
+    _passStatistics.displayNodesVisited++;
     if (cur->needsDisplay || cur->hasNewContents) {
         list->AddNode(cur);
     }
 
+    if (!cur->descendantNeedsDisplay) {
+        return;
+    }
+    cur->descendantNeedsDisplay = FALSE;
+
     cur = cur->lastChild;
     while (cur) {
         GetNeededDisplays(cur, list);
@@ -177,7 +194,9 @@ static void GetNeededDisplays(CAPrivateInfo* state, NodeList<CAPrivateInfo>* lis
 
 static void DoDisplayList(CALayer* layer) {
     NodeList<CAPrivateInfo> list;
+    _passStatistics.displayPasses++;
     GetNeededDisplays(layer->priv, &list);
+    _passStatistics.displaysPerformed += list.count;
 
     while (list.curPos < list.count) {
         CAPrivateInfo* cur = list.items[list.curPos];
@@ -329,6 +348,42 @@ CAPrivateInfo::~CAPrivateInfo() {
     _presentationNode = NULL;
 }
 
+void CAPrivateInfo::markNeedsLayout() {
+    needsLayout = TRUE;
+    for (CAPrivateInfo* cur = parent; cur && !cur->descendantNeedsLayout; cur = cur->parent) {
+        cur->descendantNeedsLayout = TRUE;
+    }
+}
+
+void CAPrivateInfo::markNeedsDisplay() {
+    needsDisplay = TRUE;
+    for (CAPrivateInfo* cur = parent; cur && !cur->descendantNeedsDisplay; cur = cur->parent) {
+        cur->descendantNeedsDisplay = TRUE;
+    }
+}
+
+void CAPrivateInfo::markHasNewContents() {
+    hasNewContents = TRUE;
+    for (CAPrivateInfo* cur = parent; cur && !cur->descendantNeedsDisplay; cur = cur->parent) {
+        cur->descendantNeedsDisplay = TRUE;
+    }
+}
+
+//  Called after the layer is inserted into a new parent, so that work marked while it was detached is found by
+//  the passes run on its new tree
+void CAPrivateInfo::propagateDirtyToAncestors() {
+    if (needsLayout || descendantNeedsLayout) {
+        for (CAPrivateInfo* cur = parent; cur && !cur->descendantNeedsLayout; cur = cur->parent) {
+            cur->descendantNeedsLayout = TRUE;
+        }
+    }
+    if (needsDisplay || hasNewContents || descendantNeedsDisplay) {
+        for (CAPrivateInfo* cur = parent; cur && !cur->descendantNeedsDisplay; cur = cur->parent) {
+            cur->descendantNeedsDisplay = TRUE;
+        }
+    }
+}
+
 class LockingBufferInterface : public DisplayTextureLocking {
 public:
     void* LockWritableBitmapTexture(DisplayTexture* tex, int* stride) {
@@ -378,12 +433,20 @@ CGContextRef CreateLayerContentsBitmapContext32(int width, int height) {
     return priv;
 }
 
++ (CALayerPassStatistics)_passStatistics {
+    return _passStatistics;
+}
+
++ (void)_resetPassStatistics {
+    memset(&_passStatistics, 0, sizeof(_passStatistics));
+}
+
 /**
  @Status Interoperable
 */
 - (void)setNeedsDisplay {
     if (priv->needsDisplay == FALSE) {
-        priv->needsDisplay = TRUE;
+        priv->markNeedsDisplay();
     }
 
     GetCACompositor()->DisplayTreeChanged();
@@ -485,7 +548,7 @@ CGContextRef CreateLayerContentsBitmapContext32(int width, int height) {
     }
     priv->_textureOverride = GetCACompositor()->CreateDisplayTextureForElement(element);
     [self setContentsGravity:kCAGravityResize];
-    priv->needsDisplay = TRUE;
+    priv->markNeedsDisplay();
 }
 
 /**
@@ -676,7 +739,7 @@ CGContextRef CreateLayerContentsBitmapContext32(int width, int height) {
     }
 
     //  To signal that we need our context converted into a texture and sent to NativeUI (checked in UIApplication.cpp)
-    priv->hasNewContents = TRUE;
+    priv->markHasNewContents();
 }
 
 static void doRecursiveAction(CALayer* layer, NSString* actionName) {
@@ -755,6 +818,7 @@ static void doRecursiveAction(CALayer* layer, NSString* actionName) {
 
     CALayer* sublayer = (CALayer*)subLayerAddr;
     sublayer->priv->superlayer = self;
+    sublayer->priv->propagateDirtyToAncestors();
 
     [CATransaction _addSublayerToLayer:self sublayer:sublayer];
 }
@@ -829,6 +893,7 @@ static void doRecursiveAction(CALayer* layer, NSString* actionName) {
 
     CALayer* sublayer = (CALayer*)subLayerAddr;
     sublayer->priv->superlayer = self;
+    sublayer->priv->propagateDirtyToAncestors();
 
     if (insertBefore != nil) {
         [CATransaction _addSublayerToLayer:self sublayer:sublayer before:insertBefore];
@@ -850,15 +915,18 @@ static void doRecursiveAction(CALayer* layer, NSString* actionName) {
     [self _setShouldLayout];
     [newLayer _setShouldLayout];
 
-    [oldLayer retain];
+    //  The reference held for oldLayer as a sublayer is handed over to newLayer
     [newLayer retain];
+    [newLayer removeFromSuperlayer];
 
     priv->replaceChild(oldLayer, newLayer);
+    oldLayer->priv->superlayer = nil;
+    newLayer->priv->superlayer = self;
+    newLayer->priv->propagateDirtyToAncestors();
 
     [CATransaction _replaceInLayer:self sublayer:oldLayer withSublayer:newLayer];
 
     [oldLayer release];
-    [newLayer release];
 }
 
 - (void)exchangeSublayer:(CALayer*)layer1 withLayer:(CALayer*)layer2 {
@@ -1408,7 +1476,7 @@ static void doRecursiveAction(CALayer* layer, NSString* actionName) {
         priv->ownsContents = FALSE;
     }
 
-    priv->needsDisplay = TRUE;
+    priv->markNeedsDisplay();
 
     if (oldContents) {
         CGImageRelease(oldContents);
@@ -1448,7 +1516,7 @@ static void doRecursiveAction(CALayer* layer, NSString* actionName) {
         if (priv->contents) {
             CGImageRelease(priv->contents);
             priv->contents = NULL;
-            priv->needsDisplay = TRUE;
+            priv->markNeedsDisplay();
         }
         if (priv->savedContext) {
             CGContextRelease(priv->savedContext);
@@ -1460,7 +1528,7 @@ static void doRecursiveAction(CALayer* layer, NSString* actionName) {
                                       NULL,
                                       CGSizeMake(0, 0),
                                       0.0f);
-    priv->needsDisplay = TRUE;
+    priv->markNeedsDisplay();
 
     GetCACompositor()->DisplayTreeChanged();
 }
@@ -2253,7 +2321,7 @@ static void doRecursiveAction(CALayer* layer, NSString* actionName) {
     priv->maskLayer = [mask retain];
     [oldLayer release];
     [mask removeFromSuperlayer];
-    priv->hasNewContents = TRUE;
+    priv->markHasNewContents();
 }
 
 /**
@@ -2352,7 +2420,7 @@ static void doRecursiveAction(CALayer* layer, NSString* actionName) {
  @Status Interoperable
 */
 - (void)setNeedsLayout {
-    priv->needsLayout = TRUE;
+    priv->markNeedsLayout();
     GetCACompositor()->DisplayTreeChanged();
 }
 
@@ -276,6 +276,9 @@ public:
     virtual int Lseek(off_t pos, int whence);
     virtual int Truncate(off_t size);
     virtual int Dup();
+
+    virtual void* Mmap(void* addr, size_t size, uint32_t prot, uint32_t flags, uint32_t offset);
+    virtual int Munmap(void* addr, size_t size);
 };
 
 EbrIOFile::EbrIOFile() {
@@ -703,6 +706,32 @@ int EbrFd2Host(int fd) {
     return _openFiles[fd]->HostFd();
 }
 
+//  Only read-only mappings of the whole file's mapping object are supported; addr, prot and flags are ignored.  The
+//  view stays valid after the file is closed.
+void* EbrIOFile::Mmap(void* addr, size_t size, uint32_t prot, uint32_t flags, uint32_t offset) {
+    if (hMapping == INVALID_HANDLE_VALUE) {
+        HANDLE mapping = CreateFileMappingFromApp((HANDLE)_get_osfhandle(filefd), NULL, PAGE_READONLY, 0, NULL);
+        if (mapping == NULL) {
+            return NULL;
+        }
+        hMapping = mapping;
+    }
+
+    return MapViewOfFileFromApp(hMapping, FILE_MAP_READ, offset, size);
+}
+
+int EbrIOFile::Munmap(void* addr, size_t size) {
+    return UnmapViewOfFile(addr) ? 0 : -1;
+}
+
+void* EbrMmap(int fd, size_t size, uint32_t offset) {
+    return _openFiles[fd]->Mmap(NULL, size, 0, 0, offset);
+}
+
+int EbrMunmap(void* addr, size_t size) {
+    return UnmapViewOfFile(addr) ? 0 : -1;
+}
+
 int EbrIOFile::Stat(struct stat* ret) {
     return fstat(filefd, ret);
 }
@@ -340,6 +340,8 @@ static idretaintype(WSDDisplayRequest) _screenActive;
             if ([windows count] > 0) {
                 int windowCount = [windows count];
 
+                //  Counters read through +[CALayer _passStatistics] describe the most recent frame
+                [CALayer _resetPassStatistics];
                 for (int i = 0; i < windowCount; i++) {
                     id window = [windows objectAtIndex:i];
                     id windowLayer = [window layer];
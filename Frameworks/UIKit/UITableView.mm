@@ -25,10 +25,12 @@
 #include "Foundation/NSRunLoop.h"
 
 #include "LinkedList.h"
+#include "RowHeightIndex.h"
 
 #include "UIViewInternal.h"
 
 #include <algorithm>
+#include <map>
 #include <memory>
 
 typedef id idweak;
@@ -283,6 +285,11 @@ public:
     TableViewHeaderFooter* _header;
     TableViewHeaderFooter* _footer;
 
+    //  Every row is represented by its height; a TableViewRow is only created for rows that are on screen or still
+    //  own a cell, keyed by row index.
+    RowHeightIndex _rowHeights;
+    std::map<int, TableViewRow*> _rows;
+
     TableViewSection(id parent, int sectionIndex) : TableViewNode(parent) {
         _yPos = 0;
         _sectionHeight = 0;
@@ -301,21 +308,43 @@ public:
     }
 
     int rowCount() {
-        return childCount;
+        return _rowHeights.count();
+    }
+
+    float rowsYPos() {
+        return _yPos + _header->_height;
+    }
+
+    float rowYPos(int idx) {
+        return rowsYPos() + _rowHeights.offsetOf(idx);
     }
-    void calcRowHeights();
 
     TableViewRow* rowAtIndex(int idx) {
-        return (TableViewRow*)childAtIndex(idx);
+        auto it = _rows.find(idx);
+        return it != _rows.end() ? it->second : NULL;
     }
+
+    TableViewRow* materializeRow(int idx);
+    void insertRow(int idx);
+    void removeRow(int idx);
+    void removeAllRows();
+    void releaseUnusedRows();
+    void shiftRows(int fromIdx, int delta);
+
+    void loadRowHeight(int idx);
+    void loadRowHeights(int count);
+    bool resolveRowHeights(CGRect& rect);
+    void showVisibleRows(CGRect& rect, BOOL animated);
 };
 
 class TableViewRow : public TableViewNode {
 public:
     ReusableCell* _reusable;
+    TableViewSection* _section;
     int _rowIndex;
 
-    TableViewRow(id parent, int index) : TableViewNode(parent) {
+    TableViewRow(id parent, TableViewSection* section, int index) : TableViewNode(parent) {
+        _section = section;
         _rowIndex = index;
         _reusable = NULL;
     }
@@ -326,14 +355,14 @@ public:
     }
 
     int getSectionIndex() {
-        if (this->parent == NULL)
+        if (_section == NULL)
             return 0;
-        return ((TableViewSection*)parent)->_sectionIndex;
+        return _section->_sectionIndex;
     }
     int getSectionCount() {
-        if (this->parent == NULL)
+        if (_section == NULL)
             return 0;
-        return ((TableViewSection*)parent)->childCount;
+        return _section->rowCount();
     }
 
     virtual void nodeVisible() {
@@ -498,25 +527,180 @@ TableViewRow::~TableViewRow() {
     }
 }
 
-void TableViewSection::calcRowHeights() {
-    int curRowIdx = 0;
+//  Without tableView:heightForRowAtIndexPath: every row has the default height. With it, heights are requested for every
+//  row as sections are loaded, unless an estimate is available, in which case rows start at their estimated height and
+//  are measured as they scroll into view.
+static bool hasDelegateRowHeights(UITableView* table) {
+    return [table->tablePriv->_delegate respondsToSelector:@selector(tableView:heightForRowAtIndexPath:)];
+}
 
-    LLTREE_FOREACH(curNode, (TableViewNode*)this) {
-        TableViewRow* curRow = (TableViewRow*)curNode;
-        id index = [NSIndexPath indexPathForRow:curRowIdx inSection:_sectionIndex];
-        float cellHeight = _parent->tablePriv->_defaultRowHeight;
+static bool hasEstimatedRowHeights(UITableView* table) {
+    return table->tablePriv->_estimatedRowHeight > 0.0f ||
+           [table->tablePriv->_delegate respondsToSelector:@selector(tableView:estimatedHeightForRowAtIndexPath:)];
+}
 
-        if ([_parent->tablePriv->_delegate respondsToSelector:@selector(tableView:heightForRowAtIndexPath:)]) {
-            cellHeight = [_parent->tablePriv->_delegate tableView:_parent heightForRowAtIndexPath:index];
+static float estimatedRowHeight(UITableView* table, NSIndexPath* index) {
+    if ([table->tablePriv->_delegate respondsToSelector:@selector(tableView:estimatedHeightForRowAtIndexPath:)]) {
+        return [table->tablePriv->_delegate tableView:table estimatedHeightForRowAtIndexPath:index];
+    }
+    return table->tablePriv->_estimatedRowHeight;
+}
+
+void TableViewSection::loadRowHeight(int idx) {
+    if (!hasDelegateRowHeights(_parent)) {
+        _rowHeights.setHeight(idx, _parent->tablePriv->_defaultRowHeight, true);
+        return;
+    }
+
+    NSIndexPath* index = [NSIndexPath indexPathForRow:idx inSection:_sectionIndex];
+    if (hasEstimatedRowHeights(_parent)) {
+        _rowHeights.setHeight(idx, estimatedRowHeight(_parent, index), false);
+    } else {
+        _rowHeights.setHeight(idx, [_parent->tablePriv->_delegate tableView:_parent heightForRowAtIndexPath:index], true);
+    }
+}
+
+void TableViewSection::loadRowHeights(int count) {
+    if (!hasDelegateRowHeights(_parent)) {
+        _rowHeights.reset(count, _parent->tablePriv->_defaultRowHeight, true);
+    } else if (hasEstimatedRowHeights(_parent) &&
+               ![_parent->tablePriv->_delegate respondsToSelector:@selector(tableView:estimatedHeightForRowAtIndexPath:)]) {
+        _rowHeights.reset(count, _parent->tablePriv->_estimatedRowHeight, false);
+    } else {
+        _rowHeights.reset(count, 0.0f, false);
+        for (int i = 0; i < count; i++) {
+            loadRowHeight(i);
         }
+    }
 
+    for (auto& entry : _rows) {
+        TableViewRow* curRow = entry.second;
         curRow->_oldHeight = curRow->_height;
-        curRow->_height = cellHeight;
-        curRow->_rowIndex = curRowIdx;
+        curRow->_height = _rowHeights.height(entry.first);
+    }
+}
 
-        curRowIdx++;
+//  Measures the rows with estimated heights that lie in rect, returning true if any height changed. Positions
+//  after a changed row are stale until calcCellPositions runs again.
+bool TableViewSection::resolveRowHeights(CGRect& rect) {
+    if (_rowHeights.unresolvedCount() == 0) {
+        return false;
     }
+
+    bool changed = false;
+    float bottom = rect.origin.y + rect.size.height;
+    float rowsY = rowsYPos();
+
+    for (int idx = _rowHeights.rowAtOffset(rect.origin.y - rowsY); idx < rowCount(); idx++) {
+        if (rowsY + _rowHeights.offsetOf(idx) > bottom) {
+            break;
+        }
+        if (_rowHeights.isResolved(idx)) {
+            continue;
+        }
+
+        NSIndexPath* index = [NSIndexPath indexPathForRow:idx inSection:_sectionIndex];
+        float cellHeight = [_parent->tablePriv->_delegate tableView:_parent heightForRowAtIndexPath:index];
+        if (cellHeight != _rowHeights.height(idx)) {
+            changed = true;
+        }
+        _rowHeights.setHeight(idx, cellHeight, true);
+    }
+
+    return changed;
 }
+
+TableViewRow* TableViewSection::materializeRow(int idx) {
+    TableViewRow*& curRow = _rows[idx];
+    if (curRow == NULL) {
+        curRow = new TableViewRow(_parent, this, idx);
+        curRow->_yPos = curRow->_oldYPos = rowYPos(idx);
+        curRow->_height = curRow->_oldHeight = _rowHeights.height(idx);
+        curRow->_yValid = true;
+    }
+    return curRow;
+}
+
+void TableViewSection::shiftRows(int fromIdx, int delta) {
+    std::map<int, TableViewRow*> shifted;
+    for (auto it = _rows.lower_bound(fromIdx); it != _rows.end();) {
+        shifted[it->first + delta] = it->second;
+        it = _rows.erase(it);
+    }
+    _rows.insert(shifted.begin(), shifted.end());
+}
+
+void TableViewSection::insertRow(int idx) {
+    shiftRows(idx, 1);
+    _rowHeights.insert(idx, 0.0f, true);
+    loadRowHeight(idx);
+}
+
+void TableViewSection::removeRow(int idx) {
+    auto it = _rows.find(idx);
+    if (it != _rows.end()) {
+        TableViewRow* curRow = it->second;
+        if (curRow->_view != nil) {
+            [curRow->_view removeFromSuperview];
+            curRow->_view = nil;
+        }
+        _rows.erase(it);
+        delete curRow;
+    }
+    shiftRows(idx + 1, -1);
+    _rowHeights.remove(idx);
+}
+
+void TableViewSection::removeAllRows() {
+    for (auto& entry : _rows) {
+        TableViewRow* curRow = entry.second;
+        if (curRow->_view != nil) {
+            [(UIView*)curRow->_view removeFromSuperview];
+            curRow->_view = nil;
+        }
+        delete curRow;
+    }
+    _rows.clear();
+}
+
+//  Drops rows that no longer hold a cell; they are recreated from their index if they come back into view
+void TableViewSection::releaseUnusedRows() {
+    for (auto it = _rows.begin(); it != _rows.end();) {
+        TableViewRow* curRow = it->second;
+        if (curRow->_view == nil && curRow->_reusable == NULL && curRow->_visibleComponent == NULL) {
+            it = _rows.erase(it);
+            delete curRow;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TableViewSection::showVisibleRows(CGRect& rect, BOOL animated) {
+    int firstIdx = 0;
+    int endIdx = 0;
+
+    if (rowCount() > 0) {
+        float bottom = rect.origin.y + rect.size.height;
+        float rowsY = rowsYPos();
+
+        firstIdx = _rowHeights.rowAtOffset(rect.origin.y - rowsY);
+        for (endIdx = firstIdx; endIdx < rowCount(); endIdx++) {
+            if (rowsY + _rowHeights.offsetOf(endIdx) > bottom) {
+                break;
+            }
+            materializeRow(endIdx)->addIfVisible(rect, animated);
+        }
+    }
+
+    //  Rows outside the visible range may still be on screen while they animate away from their old position
+    for (auto& entry : _rows) {
+        if (entry.first < firstIdx || entry.first >= endIdx) {
+            entry.second->addIfVisible(rect, animated);
+        }
+    }
+}
+
 int UITableViewPriv::sectionCount() {
     return _rootNode->childCount;
 }
@@ -635,6 +819,7 @@ static void initInternal(UITableView* self) {
     priv->_dataSource = nil;
 
     priv->_defaultRowHeight = 50.0f;
+    priv->_estimatedRowHeight = 0.0f;
     priv->_defaultSectionHeaderHeight = 22.0f;
     priv->_footerYPos = 0.f;
     priv->_reusableCellNibs = [NSMutableDictionary new];
@@ -842,6 +1027,8 @@ static void initInternal(UITableView* self) {
     [super layoutIfNeeded];
 }
 
+static void calcCellPositions(UITableView* self);
+
 static void showVisibleCells(UITableView* self, BOOL animated = FALSE) {
     auto priv = self->tablePriv;
     priv->_isEnumerating++;
@@ -878,6 +1065,23 @@ static void showVisibleCells(UITableView* self, BOOL animated = FALSE) {
     id delegate = priv->_delegate;
     id dataSource = priv->_dataSource;
 
+    //  Measure rows with estimated heights that are about to be shown; each change moves the rows below it, so repeat
+    //  until the visible rows are stable
+    for (;;) {
+        bool changed = false;
+        LLTREE_FOREACH(curNode, priv->_rootNode) {
+            TableViewSection* curSection = (TableViewSection*)curNode;
+
+            if (curSection->isSectionVisible(visibleRect) && curSection->resolveRowHeights(visibleRect)) {
+                changed = true;
+            }
+        }
+        if (!changed) {
+            break;
+        }
+        calcCellPositions(self);
+    }
+
     priv->_visibleComponents->MarkReusable(visibleRect, animated);
 
     LLTREE_FOREACH(curNode, priv->_rootNode) {
@@ -885,15 +1089,10 @@ static void showVisibleCells(UITableView* self, BOOL animated = FALSE) {
 
         if (curSection->isSectionVisible(visibleRect)) {
             curSection->_header->addIfVisible(visibleRect);
-
-            LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-                TableViewRow* curRow = (TableViewRow*)curRowNode;
-
-                curRow->addIfVisible(visibleRect, animated);
-            }
-
+            curSection->showVisibleRows(visibleRect, animated);
             curSection->_footer->addIfVisible(visibleRect);
         }
+        curSection->releaseUnusedRows();
     }
 
     if (priv->_footerView != nil) {
@@ -931,19 +1130,20 @@ static void calcCellPositions(UITableView* self) {
         curSection->_header->_yPos = y;
         y += curSection->_header->_height;
 
-        int curIndex = 0;
-
-        //  Grab rows
-        LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-            TableViewRow* curRow = (TableViewRow*)curRowNode;
+        //  Only rows that exist as nodes need their position; the rest are found through the section's row heights
+        for (auto& entry : curSection->_rows) {
+            int curIndex = entry.first;
+            TableViewRow* curRow = entry.second;
+            float rowY = y + curSection->_rowHeights.offsetOf(curIndex);
 
             if (curRow->_yValid) {
                 curRow->_oldYPos = curRow->_yPos;
             } else {
-                curRow->_oldYPos = y;
+                curRow->_oldYPos = rowY;
             }
-            curRow->_yPos = y;
+            curRow->_yPos = rowY;
             curRow->_yValid = true;
+            curRow->_height = curSection->_rowHeights.height(curIndex);
 
             if (curRow->_view) {
                 if (curRow->_rowIndex != curIndex) {
@@ -957,11 +1157,9 @@ static void calcCellPositions(UITableView* self) {
                 }
             }
             curRow->_rowIndex = curIndex;
-
-            y += curRow->_height;
-
-            curIndex++;
         }
+        y += curSection->_rowHeights.totalHeight();
+
         curSection->_footer->_yPos = y;
         y += curSection->_footer->_height;
 
@@ -1000,8 +1198,8 @@ static void calcCellPositions(UITableView* self) {
     LLTREE_FOREACH(curNode, tablePriv->_rootNode) {
         TableViewSection* curSection = (TableViewSection*)curNode;
 
-        LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-            TableViewRow* curRow = (TableViewRow*)curRowNode;
+        for (auto& entry : curSection->_rows) {
+            TableViewRow* curRow = entry.second;
 
             if (curRow->_yPos + curRow->_height < scrollPoint.y || curRow->_yPos > scrollPoint.y + bounds.size.height) {
             } else {
@@ -1030,8 +1228,8 @@ static void calcCellPositions(UITableView* self) {
     LLTREE_FOREACH(curNode, tablePriv->_rootNode) {
         TableViewSection* curSection = (TableViewSection*)curNode;
 
-        LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-            TableViewRow* curRow = (TableViewRow*)curRowNode;
+        for (auto& entry : curSection->_rows) {
+            TableViewRow* curRow = entry.second;
 
             if (curRow->_yPos + curRow->_height < scrollPoint.y || curRow->_yPos > scrollPoint.y + bounds.size.height) {
             } else {
@@ -1055,17 +1253,16 @@ static void calcCellPositions(UITableView* self) {
     LLTREE_FOREACH(curNode, tablePriv->_rootNode) {
         TableViewSection* curSection = (TableViewSection*)curNode;
 
-        int curRowIndex = 0;
-        LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-            TableViewRow* curRow = (TableViewRow*)curRowNode;
+        if (curSection->rowCount() > 0) {
+            float rowsY = curSection->rowsYPos();
+            int curRowIndex = curSection->_rowHeights.rowAtOffset(point.y - rowsY);
+            float rowY = rowsY + curSection->_rowHeights.offsetOf(curRowIndex);
 
-            if (curRow->_yPos + curRow->_height > point.y && curRow->_yPos <= point.y) {
+            if (rowY + curSection->_rowHeights.height(curRowIndex) > point.y && rowY <= point.y) {
                 id index = [NSIndexPath indexPathForRow:curRowIndex inSection:curSectionIndex];
 
                 return index;
             }
-
-            curRowIndex++;
         }
 
         curSectionIndex++;
@@ -1083,16 +1280,18 @@ static void calcCellPositions(UITableView* self) {
     LLTREE_FOREACH(curNode, tablePriv->_rootNode) {
         TableViewSection* curSection = (TableViewSection*)curNode;
 
-        int curRowIndex = 0;
-        LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-            TableViewRow* curRow = (TableViewRow*)curRowNode;
+        float rowsY = curSection->rowsYPos();
+        int curRowIndex = curSection->_rowHeights.rowAtOffset(rect.origin.y - rowsY);
+        for (; curRowIndex < curSection->rowCount(); curRowIndex++) {
+            float rowY = rowsY + curSection->_rowHeights.offsetOf(curRowIndex);
+            if (rowY > rect.origin.y + rect.size.height) {
+                break;
+            }
 
-            if (curRow->_yPos + curRow->_height > rect.origin.y && curRow->_yPos <= rect.origin.y + rect.size.height) {
+            if (rowY + curSection->_rowHeights.height(curRowIndex) > rect.origin.y) {
                 id index = [NSIndexPath indexPathForRow:curRowIndex inSection:curSectionIndex];
                 [ret addObject:index];
             }
-
-            curRowIndex++;
         }
 
         curSectionIndex++;
@@ -1139,7 +1338,14 @@ static void calcCellPositions(UITableView* self) {
         }
 
         //  Reload the row
-        TableViewRow* curRow = tablePriv->sectionAtIndex(section)->rowAtIndex(row);
+        TableViewSection* curSection = tablePriv->sectionAtIndex(section);
+        curSection->loadRowHeight(row);
+
+        //  Rows without a node have no cell to replace; they are created when they scroll into view
+        TableViewRow* curRow = curSection->rowAtIndex(row);
+        if (curRow == NULL) {
+            continue;
+        }
 
         if (curRow->_view != nil) {
             [curRow->_view setAlpha:0.0f];
@@ -1151,15 +1357,10 @@ static void calcCellPositions(UITableView* self) {
             tablePriv->removeReusableCell(curRow->_reusable);
             curRow->_reusable = NULL;
         }
-        float cellHeight = tablePriv->_defaultRowHeight;
-
-        if ([tablePriv->_delegate respondsToSelector:@selector(tableView:heightForRowAtIndexPath:)]) {
-            cellHeight = [tablePriv->_delegate tableView:self heightForRowAtIndexPath:path];
-        }
 
         curRow->_animation = animationType;
         curRow->_oldHeight = curRow->_height;
-        curRow->_height = cellHeight;
+        curRow->_height = curSection->_rowHeights.height(row);
     }
 
     calcCellPositions(self);
@@ -1178,7 +1379,7 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
     if (changedWidth) {
         LLTREE_FOREACH(curNode, priv->_rootNode) {
             TableViewSection* curSection = (TableViewSection*)curNode;
-            curSection->calcRowHeights();
+            curSection->loadRowHeights(curSection->rowCount());
         }
     }
 
@@ -1236,8 +1437,8 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
     LLTREE_FOREACH(curNode, tablePriv->_rootNode) {
         TableViewSection* curSection = (TableViewSection*)curNode;
 
-        LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-            TableViewRow* curRow = (TableViewRow*)curRowNode;
+        for (auto& entry : curSection->_rows) {
+            TableViewRow* curRow = entry.second;
 
             if (curRow->_view != nil) {
                 if (curRow->_reusable == NULL) {
@@ -1248,9 +1449,8 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
                 [curRow->_view removeFromSuperview];
                 curRow->_view = nil;
             }
-            curSection->removeChild(curRow);
-            delete curRow;
         }
+        curSection->removeAllRows();
 
         tablePriv->_rootNode->removeChild(curSection);
         delete curSection;
@@ -1315,12 +1515,7 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
             curSection->_header = new TableViewHeaderFooter(self, curSection, headerString, headerHeight, true);
 
             //  Grab rows
-            for (int j = 0; j < numRows; j++) {
-                TableViewRow* newRow = new TableViewRow(self, j);
-                curSection->addChildAfter(newRow, NULL);
-            }
-
-            curSection->calcRowHeights();
+            curSection->loadRowHeights(numRows);
 
             float footerHeight = 0.0f;
             id footerString = nil;
@@ -1474,6 +1669,21 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
     return tablePriv->_defaultRowHeight;
 }
 
+/**
+ @Status Interoperable
+ @Notes When an estimate is set, tableView:heightForRowAtIndexPath: is only called for rows as they come into view
+*/
+- (void)setEstimatedRowHeight:(CGFloat)estimatedRowHeight {
+    tablePriv->_estimatedRowHeight = estimatedRowHeight;
+}
+
+/**
+ @Status Interoperable
+*/
+- (CGFloat)estimatedRowHeight {
+    return tablePriv->_estimatedRowHeight;
+}
+
 /**
  @Status Stub
 */
@@ -1770,7 +1980,8 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
         return nil;
     }
 
-    return tablePriv->sectionAtIndex(section)->rowAtIndex(row)->_view;
+    TableViewRow* curRow = tablePriv->sectionAtIndex(section)->rowAtIndex(row);
+    return curRow != NULL ? (UITableViewCell*)curRow->_view : nil;
 }
 
 /**
@@ -1787,10 +1998,11 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
 
     CGRect bounds;
     bounds = [self bounds];
+    TableViewSection* curSection = tablePriv->sectionAtIndex(section);
     ret.origin.x = 0.0f;
-    ret.origin.y = tablePriv->sectionAtIndex(section)->rowAtIndex(row)->_yPos;
+    ret.origin.y = curSection->rowYPos(row);
     ret.size.width = bounds.size.width;
-    ret.size.height = tablePriv->sectionAtIndex(section)->rowAtIndex(row)->_height;
+    ret.size.height = curSection->_rowHeights.height(row);
 
     return ret;
 }
@@ -1817,12 +2029,7 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
     y += tablePriv->sectionAtIndex(section)->_header->_height;
 
     //  Grab rows
-    TableViewSection* curSection = tablePriv->sectionAtIndex(section);
-    LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-        TableViewRow* curRow = (TableViewRow*)curRowNode;
-
-        y += curRow->_height;
-    }
+    y += tablePriv->sectionAtIndex(section)->_rowHeights.totalHeight();
 
     y += tablePriv->sectionAtIndex(section)->_footer->_height;
 
@@ -1844,37 +2051,23 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
         [self reloadData];
     }
 
-    unsigned count = [paths count];
-
-    for (unsigned i = 0; i < count; i++) {
-        NSIndexPath* path = [paths objectAtIndex:i];
+    //  Index paths refer to positions after the insertion, so insert in ascending order
+    std::vector<std::pair<int, int>> rows;
+    for (NSIndexPath* path in paths) {
+        rows.emplace_back([path section], [path row]);
+    }
+    std::sort(rows.begin(), rows.end());
 
-        int section = [path section];
-        int row = [path row];
+    for (const auto& path : rows) {
+        int section = path.first;
+        int row = path.second;
 
         if (section >= tablePriv->sectionCount() || row > tablePriv->sectionAtIndex(section)->rowCount()) {
             assert(0);
         }
 
-        TableViewSection* curSection = tablePriv->sectionAtIndex(section);
-        TableViewNode* insertAfter = NULL;
-        if (row < tablePriv->sectionAtIndex(section)->rowCount()) {
-            insertAfter = curSection->childAtIndex(row);
-        }
-
-        float cellHeight = tablePriv->_defaultRowHeight;
-
-        if ([tablePriv->_delegate respondsToSelector:@selector(tableView:heightForRowAtIndexPath:)]) {
-            cellHeight = [tablePriv->_delegate tableView:self heightForRowAtIndexPath:path];
-        }
-
         //  Insert the row
-        TableViewRow* newRow = new TableViewRow(self, i);
-        curSection->addChildAfter(newRow, insertAfter);
-
-        newRow->_height = cellHeight;
-        newRow->_view = nil;
-        newRow->_yPos = -1;
+        tablePriv->sectionAtIndex(section)->insertRow(row);
     }
 
     calcCellPositions(self);
@@ -1903,7 +2096,7 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
     int maxCells = 0;
 
     LLTREE_FOREACH(curNode, (TableViewNode*)tablePriv->_rootNode) {
-        maxCells += curNode->childCount;
+        maxCells += ((TableViewSection*)curNode)->_rows.size();
     }
     cleanupHelper->_numCellsToBeRemoved = 0;
     cleanupHelper->_cellsToBeRemoved = (id*)IwMalloc(sizeof(id) * maxCells);
@@ -1924,11 +2117,9 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
         TableViewSection* curSection = tablePriv->sectionAtIndex(section);
         int newRowCount = [tablePriv->_dataSource tableView:self numberOfRowsInSection:section];
 
-        int curIdx = 0;
-
-        LLTREE_FOREACH(curNode, (TableViewNode*)curSection) {
+        for (auto it = curSection->_rows.begin(); it != curSection->_rows.end();) {
             //  Reload the rows
-            TableViewRow* curRow = (TableViewRow*)curNode;
+            TableViewRow* curRow = it->second;
 
             if (curRow->_view != nil) {
                 [curRow->_view setAlpha:0.0f];
@@ -1941,41 +2132,16 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
                 curRow->_reusable = NULL;
             }
 
-            if (curIdx < newRowCount) {
-                float cellHeight = tablePriv->_defaultRowHeight;
-
-                if ([tablePriv->_delegate respondsToSelector:@selector(tableView:heightForRowAtIndexPath:)]) {
-                    id path = [NSIndexPath indexPathForRow:curIdx inSection:section];
-                    cellHeight = [tablePriv->_delegate tableView:self heightForRowAtIndexPath:path];
-                }
-
+            if (it->first < newRowCount) {
                 curRow->_animation = animationType;
-                curRow->_oldHeight = curRow->_height;
-                curRow->_height = cellHeight;
+                ++it;
             } else {
-                curSection->removeChild(curRow);
+                it = curSection->_rows.erase(it);
                 delete curRow;
             }
-            curIdx++;
         }
 
-        //  Add any extra new rows needed
-        while (curIdx < newRowCount) {
-            TableViewRow* newRow = new TableViewRow(self, curIdx);
-            float cellHeight = tablePriv->_defaultRowHeight;
-
-            if ([tablePriv->_delegate respondsToSelector:@selector(tableView:heightForRowAtIndexPath:)]) {
-                id path = [NSIndexPath indexPathForRow:curIdx inSection:section];
-                cellHeight = [tablePriv->_delegate tableView:self heightForRowAtIndexPath:path];
-            }
-
-            newRow->_animation = animationType;
-            newRow->_height = cellHeight;
-            newRow->_oldHeight = newRow->_height;
-
-            curSection->addChildAfter(newRow, NULL);
-            curIdx++;
-        }
+        curSection->loadRowHeights(newRowCount);
 
         idx = [sections indexGreaterThanIndex:idx];
     }
@@ -1993,14 +2159,9 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
  @Notes animation parameter not supported
 */
 - (void)deleteRowsAtIndexPaths:(NSArray*)paths withRowAnimation:(UITableViewRowAnimation)animate {
-    int count = [paths count];
-
-    auto rows = std::make_unique<TableViewRow* []>(count);
-    int numRows = 0;
-
-    for (int i = 0; i < count; i++) {
-        NSIndexPath* path = [paths objectAtIndex:i];
-
+    //  Index paths refer to positions before the deletion, so delete in descending order
+    std::vector<std::pair<int, int>> rows;
+    for (NSIndexPath* path in paths) {
         int section = [path section];
         int row = [path row];
 
@@ -2009,23 +2170,14 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
             return;
         }
 
-        //  Delete the row
-        TableViewRow* itemRow = tablePriv->sectionAtIndex(section)->rowAtIndex(row);
-        rows[numRows++] = itemRow;
+        rows.emplace_back(section, row);
     }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
 
-    for (int i = 0; i < numRows; i++) {
+    for (auto it = rows.rbegin(); it != rows.rend(); ++it) {
         //  Delete the row
-        TableViewRow* curRow = rows[i];
-
-        if (curRow->_view != nil) {
-            [curRow->_view removeFromSuperview];
-            curRow->_view = nil;
-        }
-
-        TableViewSection* section = (TableViewSection*)curRow->parent;
-        section->removeChild(curRow);
-        delete curRow;
+        tablePriv->sectionAtIndex(it->first)->removeRow(it->second);
     }
 
     calcCellPositions(self);
@@ -2051,15 +2203,7 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
         TableViewSection* curSection = tablePriv->sectionAtIndex(section);
 
         //  Delete the section
-        LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-            TableViewRow* curRow = (TableViewRow*)curRowNode;
-
-            if (curRow->_view != nil) {
-                [curRow->_view removeFromSuperview];
-                curRow->_view = nil;
-            }
-            delete curRow;
-        }
+        curSection->removeAllRows();
 
         tablePriv->_rootNode->removeChild(curSection);
         delete curSection;
@@ -2217,16 +2361,7 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
     LLTREE_FOREACH(curNode, tablePriv->_rootNode) {
         TableViewSection* curSection = (TableViewSection*)curNode;
 
-        LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-            TableViewRow* curRow = (TableViewRow*)curRowNode;
-
-            if (curRow->_view != nil) {
-                [(UIView*)curRow->_view removeFromSuperview];
-                curRow->_view = nil;
-            }
-            delete curRow;
-        }
-
+        curSection->removeAllRows();
         delete curSection;
     }
 
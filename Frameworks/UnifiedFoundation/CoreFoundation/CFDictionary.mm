@@ -1,28 +1,18 @@
-/* The MIT License
-
-Copyright (c) 2008, 2009, 2011 by Attractive Chaos <attractor@live.co.uk>
-Copyright (c) 2015 Microsoft Corporation. All rights reserved.
-
-Permission is hereby granted, free of charge, to any person obtaining
-a copy of this software and associated documentation files (the
-"Software"), to deal in the Software without restriction, including
-without limitation the rights to use, copy, modify, merge, publish,
-distribute, sublicense, and/or sell copies of the Software, and to
-permit persons to whom the Software is furnished to do so, subject to
-the following conditions:
-
-The above copyright notice and this permission notice shall be
-included in all copies or substantial portions of the Software.
-
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
-EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
-MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
-NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
-BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
-ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
-CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-SOFTWARE.
-*/
+//******************************************************************************
+//
+// Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
 
 #include "Starboard.h"
 
@@ -33,6 +23,7 @@ SOFTWARE.
 #include "CFDictionaryInternal.h"
 
 #include <sys/stat.h>
+#include <algorithm>
 #include <new>
 
 class __CFDictionary;
@@ -97,674 +88,378 @@ const CFDictionaryValueCallBacks kNSTypeDictionaryValueCallBacks = {
 };
 
 struct dictIterator {
-    khiter_t kIt;
-    cf_dict_array* arr;
-    int curIndex;
+    uint32_t entry;
 };
 
-static kh_inline kh_cf_dictionary_t* kh_init_cf_dictionary(void) {
-    return (kh_cf_dictionary_t*)kcalloc(1, sizeof(kh_cf_dictionary_t));
-}
-static kh_inline void kh_init_ptr_cf_dictionary(kh_cf_dictionary_t* h) {
-    memset(h, 0, sizeof(kh_cf_dictionary_t));
-}
-static kh_inline void kh_destroy_cf_dictionary(kh_cf_dictionary_t* h) {
-    if (h) {
-        kfree((void*)h->keys);
-        kfree(h->flags);
-        kfree((void*)h->vals);
-        kfree(h);
-    }
-}
-static kh_inline void kh_destroy_ptr_cf_dictionary(kh_cf_dictionary_t* h) {
-    if (h) {
-        kfree((void*)h->keys);
-        kfree(h->flags);
-        kfree((void*)h->vals);
-    }
-}
-static kh_inline void kh_clear_cf_dictionary(kh_cf_dictionary_t* h) {
-    if (h && h->flags) {
-        memset(h->flags, 0xaa, __ac_fsize(h->n_buckets) * sizeof(khint32_t));
-        h->size = h->n_occupied = 0;
-    }
-}
-static kh_inline khint_t kh_get_cf_dictionary(const kh_cf_dictionary_t* h, khint32_t key) {
-    if (h->n_buckets) {
-        khint_t k, i, last, mask, step = 0;
-        mask = h->n_buckets - 1;
-        k = kh_int_hash_func(key);
-        i = k & mask;
-        last = i;
-        while (!__ac_isempty(h->flags, i) && (__ac_isdel(h->flags, i) || !kh_int_hash_equal(h->keys[i], key))) {
-            i = (i + (++step)) & mask;
-            if (i == last)
-                return h->n_buckets;
-        }
-        return __ac_iseither(h->flags, i) ? h->n_buckets : i;
-    } else
-        return 0;
-}
-static kh_inline int kh_resize_cf_dictionary(kh_cf_dictionary_t* h, khint_t new_n_buckets) { /* This function uses 0.25*n_buckets bytes of
-                                                                                                working space instead of
-                                                                                                [sizeof(key_t+val_t)+.25]*n_buckets. */
-    khint32_t* new_flags = 0;
-    khint_t j = 1;
-    {
-        kroundup32(new_n_buckets);
-        if (new_n_buckets < 4)
-            new_n_buckets = 4;
-
-        if (h->size >= (khint_t)(new_n_buckets * __ac_HASH_UPPER + 0.5)) {
-            j = 0; /* requested size is too small */
-        } else { /* hash table size to be changed (shrink or expand); rehash */
-            new_flags = (khint32_t*)kmalloc(__ac_fsize(new_n_buckets) * sizeof(khint32_t));
-            if (!new_flags)
-                return -1;
-            memset(new_flags, 0xaa, __ac_fsize(new_n_buckets) * sizeof(khint32_t));
-            if (h->n_buckets < new_n_buckets) { /* expand */
-                khint32_t* new_keys = (khint32_t*)krealloc((void*)h->keys, new_n_buckets * sizeof(khint32_t));
-
-                if (!new_keys)
-                    return -1;
-                h->keys = new_keys;
-
-                if (1) {
-                    cf_dict_array* new_vals = (cf_dict_array*)krealloc((void*)h->vals, new_n_buckets * sizeof(cf_dict_array));
-                    if (!new_vals)
-                        return -1;
-                    h->vals = new_vals;
-                }
-            } /* otherwise shrink */
-        }
-    }
-    if (j) { /* rehashing is needed */
-        for (j = 0; j != h->n_buckets; ++j) {
-            if (__ac_iseither(h->flags, j) == 0) {
-                khint32_t key = h->keys[j];
-                cf_dict_array val;
-                khint_t new_mask;
-                new_mask = new_n_buckets - 1;
-                if (1)
-                    val = h->vals[j];
-                __ac_set_isdel_true(h->flags, j);
-                while (1) { /* kick-out process; sort of like in Cuckoo hashing */
-                    khint_t k, i, step = 0;
-                    k = kh_int_hash_func(key);
-                    i = k & new_mask;
-                    while (!__ac_isempty(new_flags, i))
-                        i = (i + (++step)) & new_mask;
-                    __ac_set_isempty_false(new_flags, i);
-                    if (i < h->n_buckets && __ac_iseither(h->flags, i) == 0) { /* kick out the existing element */
-                        {
-                            khint32_t tmp = h->keys[i];
-                            h->keys[i] = key;
-                            key = tmp;
-                        }
-                        if (1) {
-                            cf_dict_array tmp = h->vals[i];
-                            h->vals[i] = val;
-                            val = tmp;
-                        }
-                        __ac_set_isdel_true(h->flags, i); /* mark it as deleted in the old hash table */
-                    } else { /* write the element and jump out of the loop */
-                        h->keys[i] = key;
-                        if (1)
-                            h->vals[i] = val;
-                        break;
-                    }
-                }
-            }
-        }
-        if (h->n_buckets > new_n_buckets) { /* shrink the hash table */
-            h->keys = (khint32_t*)krealloc((void*)h->keys, new_n_buckets * sizeof(khint32_t));
-            if (1)
-                h->vals = (cf_dict_array*)krealloc((void*)h->vals, new_n_buckets * sizeof(cf_dict_array));
-        }
-        kfree(h->flags); /* free the working space */
-        h->flags = new_flags;
-        h->n_buckets = new_n_buckets;
-        h->n_occupied = h->size;
-        h->upper_bound = (khint_t)(h->n_buckets * __ac_HASH_UPPER + 0.5);
-    }
-    return 0;
-}
-
-static kh_inline khint_t kh_put_cf_dictionary(kh_cf_dictionary_t* h, khint32_t key, int* ret) {
-    khint_t x;
-
-    if (h->n_occupied >= h->upper_bound) { /* update the hash table */
-        if (h->n_buckets > (h->size << 1)) {
-            if (kh_resize_cf_dictionary(h, h->n_buckets - 1) < 0) { /* clear "deleted" elements */
-                *ret = -1;
-                return h->n_buckets;
-            }
-        } else if (kh_resize_cf_dictionary(h, h->n_buckets + 1) < 0) { /* expand the hash table */
-            *ret = -1;
-            return h->n_buckets;
-        }
-    } /* TODO: to implement automatically shrinking; resize() already support
-         shrinking */
-    {
-        khint_t k, i, site, last, mask = h->n_buckets - 1, step = 0;
-        x = site = h->n_buckets;
-        k = kh_int_hash_func(key);
-        i = k & mask;
-        if (__ac_isempty(h->flags, i)) {
-            x = i; /* for speed up */
-        } else {
-            last = i;
-            while (!__ac_isempty(h->flags, i) && (__ac_isdel(h->flags, i) || !kh_int_hash_equal(h->keys[i], key))) {
-                if (__ac_isdel(h->flags, i))
-                    site = i;
-                i = (i + (++step)) & mask;
-                if (i == last) {
-                    x = site;
-                    break;
-                }
-            }
-            if (x == h->n_buckets) {
-                if (__ac_isempty(h->flags, i) && site != h->n_buckets) {
-                    x = site;
-                } else
-                    x = i;
-            }
-        }
-    }
+//  At most three quarters of the slots are ever used, counting holes left by removed pairs.
+static const uint32_t c_minimumSlotCount = 8;
 
-    if (__ac_isempty(h->flags, x)) { /* not present at all */
-        h->keys[x] = key;
-        __ac_set_isboth_false(h->flags, x);
-        ++h->size;
-        ++h->n_occupied;
-        *ret = 1;
-    } else if (__ac_isdel(h->flags, x)) { /* deleted */
-        h->keys[x] = key;
-        __ac_set_isboth_false(h->flags, x);
-        ++h->size;
-        *ret = 2;
-    } else
-        *ret = 0; /* Don't touch h->keys[x] if present and not deleted */
+static inline uint32_t _entryCapacityForSlots(uint32_t slotCount) {
+    return slotCount - slotCount / 4;
+}
 
-    return x;
+static inline uint32_t _probeDistance(uint32_t hash, uint32_t slot, uint32_t mask) {
+    return (slot - (hash & mask)) & mask;
 }
 
-static kh_inline void kh_del_cf_dictionary(kh_cf_dictionary_t* h, khint_t x) {
-    if (x != h->n_buckets && !__ac_iseither(h->flags, x)) {
-        __ac_set_isdel_true(h->flags, x);
-        --h->size;
+EbrDictionary::EbrDictionary(const CFDictionaryKeyCallBacks* keyCallbacks, const CFDictionaryValueCallBacks* valueCallbacks)
+    : allocator(NULL), _entries(NULL), _slots(NULL), _slotMask(0), _entryCount(0), _entryCapacity(0), _numKeys(0) {
+    if (keyCallbacks) {
+        this->keyCallbacks = *keyCallbacks;
+    } else {
+        memset(&this->keyCallbacks, 0, sizeof(this->keyCallbacks));
+    }
+    if (valueCallbacks) {
+        this->valueCallbacks = *valueCallbacks;
+    } else {
+        memset(&this->valueCallbacks, 0, sizeof(this->valueCallbacks));
     }
-}
 
-EbrDictionary::EbrDictionary() {
-    kh_init_ptr(cf_dictionary, this);
+    _objectKeys = this->keyCallbacks.hash == CFNSHash && this->keyCallbacks.equal == CFNSEqual;
 }
 
 EbrDictionary::~EbrDictionary() {
-    kh_destroy_ptr(cf_dictionary, this);
+    IwFree(_entries);
+    IwFree(_slots);
 }
 
-void EbrDictionary::setObjectKey(const void* key, const void* object, bool retain) {
-    assert(key != 0);
-
-    //  Call retain function on object
-    if (retain)
-        object = retainVal(object);
-
-    //  Get key hash
-    uint32_t keyHash = getHash(key);
-
-    //  Find array for key
-    cf_dict_array* arr;
-    khiter_t k = kh_get(cf_dictionary, this, keyHash);
-    if (k != kh_end(this) && (arr = &kh_value(this, k))) {
-        //  Existing array - value already exists?
-        arr->setObjectForKey(object, key, this, retain);
+inline uint32_t EbrDictionary::_hash(const void* key) {
+    if (_objectKeys) {
+        return (uint32_t)CFNSHash(key);
+    } else if (keyCallbacks.hash != 0) {
+        return (uint32_t)keyCallbacks.hash(key);
     } else {
-        //  New array
-        cf_dict_array arr, *arrPtr;
-        int ret;
-
-        k = kh_put(cf_dictionary, this, keyHash, &ret);
-        arrPtr = &kh_value(this, k);
-        memset(arrPtr, 0, sizeof(cf_dict_array));
-        arrPtr->setObjectForKey(object, key, this, retain);
+        return (uint32_t)(uintptr_t)key;
     }
 }
 
-bool EbrDictionary::objectForKey(const void* key, const void*& ret) {
-    if (key == 0) {
-        assert(0);
+inline bool EbrDictionary::_isEqual(const void* key1, const void* key2) {
+    if (key1 == key2) {
+        return true;
+    } else if (_objectKeys) {
+        return CFNSEqual(key1, key2) != 0;
+    } else if (keyCallbacks.equal != 0) {
+        return keyCallbacks.equal(key1, key2) != 0;
+    } else {
+        return false;
     }
+}
 
-    //  Get key hash
-    uint32_t keyHash = getHash(key);
-
-    //  Find array for key
-    cf_dict_array* arr;
-    khiter_t k = kh_get(cf_dictionary, this, keyHash);
-    if (k != kh_end(this) && (arr = &kh_value(this, k))) {
-        bool retVal = arr->objectForKey(key, &ret, this);
-
-        return retVal;
+inline const void* EbrDictionary::retainKey(const void* key) {
+    if (keyCallbacks.retain != 0) {
+        if (keyCallbacks.retain == CFNSRetain) {
+            key = CFNSRetain(allocator, key);
+        } else {
+            key = keyCallbacks.retain(allocator, key);
+        }
     }
 
-    return false;
+    return key;
 }
 
-void EbrDictionary::removeKey(const void* key) {
-    assert(key != 0);
-
-    //  Get key hash
-    uint32_t keyHash = getHash(key);
-
-    //  Find array for key
-    cf_dict_array* arr;
-    khiter_t k = kh_get(cf_dictionary, this, keyHash);
-    if (k != kh_end(this) && (arr = &kh_value(this, k))) {
-        bool empty = arr->removeObjectForKey(key, this);
-        if (empty) {
-            arr->destroy();
-            kh_del(cf_dictionary, this, k);
+inline void EbrDictionary::releaseKey(const void* key) {
+    if (keyCallbacks.release != 0) {
+        if (keyCallbacks.release == CFNSRelease) {
+            CFNSRelease(allocator, key);
+        } else {
+            keyCallbacks.release(allocator, key);
         }
     }
 }
 
-void EbrDictionary::removeAllValues() {
-    int count = getCount();
-    const void** values = (const void**)IwMalloc(sizeof(void*) * count);
-    const void** keys = (const void**)IwMalloc(sizeof(const void*) * count);
-
-    getKeysAndValues(keys, values);
-    khiter_t k;
-    for (k = kh_begin(this); k != kh_end(this); ++k) {
-        if (kh_exist(this, k)) {
-            cf_dict_array* arr = &kh_value(this, k);
-            arr->destroy();
+inline const void* EbrDictionary::retainVal(const void* val) {
+    if (valueCallbacks.retain != 0) {
+        if (valueCallbacks.retain == CFNSRetain) {
+            val = CFNSRetain(allocator, val);
+        } else {
+            val = valueCallbacks.retain(allocator, val);
         }
     }
-    kh_clear(cf_dictionary, this);
-    numKeys = 0;
-
-    for (int i = 0; i < count; i++) {
-        releaseKey(keys[i]);
-        releaseVal(values[i]);
-    }
-
-    IwFree(keys);
-    IwFree(values);
-}
 
-void EbrDictionary::initIterator(struct dictIterator* iter) {
-    assert(sizeof(struct dictIterator) <= 5 * sizeof(const void*));
-    iter->kIt = -1;
-    iter->arr = NULL;
+    return val;
 }
 
-bool EbrDictionary::getNextKey(struct dictIterator* iter, const void*& keyRet) {
-    if (iter->kIt == kh_end(this))
-        return false;
-
-    if (iter->arr == NULL) {
-        for (;;) {
-            iter->kIt++;
-            if (iter->kIt == kh_end(this)) {
-                return false;
-            }
-
-            if (kh_exist(this, iter->kIt)) {
-                iter->arr = &kh_value(this, iter->kIt);
-                break;
-            }
+inline void EbrDictionary::releaseVal(const void* val) {
+    if (valueCallbacks.release != 0) {
+        if (valueCallbacks.release == CFNSRelease) {
+            CFNSRelease(allocator, val);
+        } else {
+            valueCallbacks.release(allocator, val);
         }
-        iter->curIndex = 0;
     }
-
-    keyRet = iter->arr->keyAtIndex(iter->curIndex);
-    iter->curIndex++;
-
-    if (iter->curIndex >= iter->arr->count()) {
-        iter->arr = NULL;
-    }
-
-    return true;
 }
 
-bool EbrDictionary::getNextValue(struct dictIterator* iter, const void*& valueRet) {
-    if (iter->kIt == kh_end(this))
+//  Robin Hood ordering keeps every run sorted by probe distance, so the search stops at the first slot whose pair is
+//  closer to its home than the key would be.
+bool EbrDictionary::_find(const void* key, uint32_t hash, uint32_t& slot) {
+    if (_slots == NULL) {
         return false;
-
-    if (iter->arr == NULL) {
-        for (;;) {
-            iter->kIt++;
-            if (iter->kIt == kh_end(this)) {
-                return false;
-            }
-
-            if (kh_exist(this, iter->kIt)) {
-                iter->arr = &kh_value(this, iter->kIt);
-                break;
-            }
-        }
-        iter->curIndex = 0;
     }
 
-    valueRet = iter->arr->valueAtIndex(iter->curIndex);
-    iter->curIndex++;
-
-    if (iter->curIndex >= iter->arr->count()) {
-        iter->arr = NULL;
+    uint32_t position = hash & _slotMask;
+    for (uint32_t distance = 0;; distance++) {
+        const EbrDictionarySlot& current = _slots[position];
+        if (current.entry == 0 || _probeDistance(current.hash, position, _slotMask) < distance) {
+            return false;
+        }
+        if (current.hash == hash && _isEqual(key, _entries[current.entry - 1].key)) {
+            slot = position;
+            return true;
+        }
+        position = (position + 1) & _slotMask;
     }
-
-    return true;
 }
 
-void EbrDictionary::getKeysAndValues(const void** keys, const void** values) {
-    uint32_t numValues = 0;
+void EbrDictionary::_insertSlot(uint32_t hash, uint32_t entry) {
+    EbrDictionarySlot carried = { hash, entry };
+    uint32_t position = hash & _slotMask;
+    for (uint32_t distance = 0;; distance++) {
+        EbrDictionarySlot& current = _slots[position];
+        if (current.entry == 0) {
+            current = carried;
+            return;
+        }
 
-    //  Grab all keys and values
-    khiter_t k;
-    for (k = kh_begin(this); k != kh_end(this); ++k) {
-        if (kh_exist(this, k)) {
-            cf_dict_array* arr = &kh_value(this, k);
-            int count = arr->count();
-            for (int i = 0; i < count; i++) {
-                assert(numValues <= numKeys);
-                if (keys)
-                    keys[numValues] = arr->keyAtIndex(i);
-                if (values)
-                    values[numValues] = arr->valueAtIndex(i);
-
-                numValues++;
-            }
+        uint32_t currentDistance = _probeDistance(current.hash, position, _slotMask);
+        if (currentDistance < distance) {
+            std::swap(current, carried);
+            distance = currentDistance;
         }
+        position = (position + 1) & _slotMask;
     }
-
-    assert(numValues == numKeys);
 }
 
-uint32_t EbrDictionary::getCount() {
-    return numKeys;
+//  Shifts the rest of the run back by one, so no tombstones are needed in the slot table.
+void EbrDictionary::_removeSlot(uint32_t slot) {
+    uint32_t next = (slot + 1) & _slotMask;
+    while (_slots[next].entry != 0 && _probeDistance(_slots[next].hash, next, _slotMask) != 0) {
+        _slots[slot] = _slots[next];
+        slot = next;
+        next = (next + 1) & _slotMask;
+    }
+    _slots[slot].entry = 0;
 }
 
-class __CFDictionary : public EbrDictionary {
-private:
-    CFDictionaryKeyCallBacks keyCallbacks;
-    CFDictionaryValueCallBacks valueCallbacks;
-    CFAllocatorRef allocator;
-
-public:
-    __CFDictionary(const CFDictionaryKeyCallBacks* k, const CFDictionaryValueCallBacks* v) {
-        if (k) {
-            keyCallbacks = *k;
-        } else
-            memset(&keyCallbacks, 0, sizeof(keyCallbacks));
-        if (v) {
-            valueCallbacks = *v;
-        } else
-            memset(&valueCallbacks, 0, sizeof(valueCallbacks));
+//  Compacts the entries, dropping holes, and indexes them again in a slot table of the given size.
+void EbrDictionary::_rebuild(uint32_t slotCount) {
+    uint32_t live = 0;
+    for (uint32_t i = 0; i < _entryCount; i++) {
+        if (_entries[i].key != NULL) {
+            _entries[live++] = _entries[i];
+        }
     }
+    _entryCount = live;
 
-    ~__CFDictionary() {
+    if (slotCount - 1 != _slotMask || _slots == NULL) {
+        IwFree(_slots);
+        _slots = (EbrDictionarySlot*)IwCalloc(slotCount, sizeof(EbrDictionarySlot));
+        _slotMask = slotCount - 1;
+        _entryCapacity = _entryCapacityForSlots(slotCount);
+        _entries = (EbrDictionaryEntry*)IwRealloc(_entries, _entryCapacity * sizeof(EbrDictionaryEntry));
+    } else {
+        memset(_slots, 0, slotCount * sizeof(EbrDictionarySlot));
     }
 
-    void copyFrom(__CFDictionary* dict) {
-        kh_resize(cf_dictionary, this, dict->n_buckets);
-        khiter_t k;
-        for (k = kh_begin(dict); k != kh_end(dict); ++k) {
-            if (kh_exist(dict, k)) {
-                cf_dict_array* arr = &kh_value(dict, k);
-                int count = arr->count();
-                for (int i = 0; i < count; i++) {
-                    const void* key = arr->keyAtIndex(i);
-                    const void* val = arr->valueAtIndex(i);
-                    setObjectKey(key, val);
-                }
-            }
-        }
+    for (uint32_t i = 0; i < _entryCount; i++) {
+        _insertSlot(_entries[i].hash, i + 1);
     }
+}
 
-    uint32_t getHash(const void* key) {
-        if (keyCallbacks.hash != 0) {
-            if (keyCallbacks.hash == kNSTypeDictionaryKeyCallBacks.hash) {
-                return CFNSHash(key);
-            } else {
-                return keyCallbacks.hash(key);
-            }
-        } else {
-            return (uint32_t)key;
-        }
+void EbrDictionary::reserve(uint32_t count) {
+    uint32_t slotCount = c_minimumSlotCount;
+    while (_entryCapacityForSlots(slotCount) < count) {
+        slotCount *= 2;
     }
 
-    bool isEqual(const void* val1, const void* val2) {
-        if (keyCallbacks.equal != 0) {
-            if (keyCallbacks.equal == kNSTypeDictionaryKeyCallBacks.equal) {
-                return CFNSEqual(val1, val2) != 0;
-            } else {
-                return (keyCallbacks.equal(val1, val2)) != 0;
-            }
-        } else {
-            return val1 == val2;
-        }
+    if (slotCount > _slotMask + 1 || _slots == NULL) {
+        _rebuild(slotCount);
     }
+}
 
-    const void* retainKey(const void* key) {
-        if (keyCallbacks.retain != 0) {
-            if (keyCallbacks.retain == kNSTypeDictionaryKeyCallBacks.retain) {
-                key = keyCallbacks.retain(allocator, key);
-            } else {
-                key = keyCallbacks.retain(allocator, key);
-            }
+void EbrDictionary::_insert(const void* key, const void* object, uint32_t hash) {
+    if (_entryCount == _entryCapacity) {
+        uint32_t slotCount = _slots ? _slotMask + 1 : c_minimumSlotCount;
+        //  Only grow if compacting would not free up a good part of the entries
+        if (_numKeys >= _entryCapacity / 2) {
+            slotCount *= 2;
         }
-
-        return key;
+        _rebuild(slotCount);
     }
 
-    const void* releaseKey(const void* key) {
-        if (keyCallbacks.release != 0) {
-            if (keyCallbacks.release == kNSTypeDictionaryKeyCallBacks.release) {
-                CFNSRelease(allocator, key);
-            } else {
-                keyCallbacks.release(allocator, key);
-            }
-        }
+    EbrDictionaryEntry& entry = _entries[_entryCount];
+    entry.key = key;
+    entry.value = object;
+    entry.hash = hash;
+    _entryCount++;
+    _numKeys++;
 
-        return key;
-    }
+    _insertSlot(hash, _entryCount);
+}
 
-    const void* releaseVal(const void* val) {
-        if (valueCallbacks.release != 0) {
-            if (valueCallbacks.release == kCFTypeDictionaryValueCallBacks.release) {
-                CFNSRelease(allocator, val);
-            } else {
-                valueCallbacks.release(allocator, val);
-            }
-        }
+void EbrDictionary::setObjectKey(const void* key, const void* object, bool retain) {
+    assert(key != 0);
 
-        return val;
+    //  Call retain function on object
+    if (retain) {
+        object = retainVal(object);
     }
 
-    const void* retainVal(const void* val) {
-        if (valueCallbacks.retain != 0) {
-            if (valueCallbacks.retain == kCFTypeDictionaryValueCallBacks.retain) {
-                val = (void*)CFNSRetain(allocator, val);
-            } else {
-                val = valueCallbacks.retain(allocator, val);
-            }
-        }
-
-        return val;
+    uint32_t keyHash = _hash(key);
+    uint32_t slot;
+    if (_find(key, keyHash, slot)) {
+        //  Key already exists - keep its position and swap in the new value
+        EbrDictionaryEntry& entry = _entries[_slots[slot].entry - 1];
+        const void* oldValue = entry.value;
+        entry.value = object;
+        releaseVal(oldValue);
+        return;
     }
-};
-
-cf_dict_array::cf_dict_array() {
-    hasItem = false;
-    manyItems = NULL;
-}
 
-void cf_dict_array::destroy() {
-    if (manyItems) {
-        delete manyItems;
-        manyItems = NULL;
-        hasItem = false;
+    if (retain) {
+        key = retainKey(key);
     }
+    _insert(key, object, keyHash);
 }
 
-int cf_dict_array::count() {
-    if (!manyItems) {
-        if (hasItem)
-            return 1;
+bool EbrDictionary::objectForKey(const void* key, const void*& ret) {
+    assert(key != 0);
 
-        return 0;
+    uint32_t slot;
+    if (_find(key, _hash(key), slot)) {
+        ret = _entries[_slots[slot].entry - 1].value;
+        return true;
     }
 
-    return manyItems->size();
+    return false;
 }
 
-const void* cf_dict_array::keyAtIndex(int idx) {
-    if (!manyItems) {
-        assert(idx == 0 && hasItem == true);
-        return singleKey;
+void EbrDictionary::removeKey(const void* key) {
+    assert(key != 0);
+
+    uint32_t slot;
+    if (!_find(key, _hash(key), slot)) {
+        return;
     }
 
-    return (manyItems->begin() + idx)->first;
-}
+    uint32_t index = _slots[slot].entry - 1;
+    const void* objKey = _entries[index].key;
+    const void* objVal = _entries[index].value;
 
-const void* cf_dict_array::valueAtIndex(int idx) {
-    if (!manyItems) {
-        assert(idx == 0 && hasItem == true);
-        return singleValue;
+    _removeSlot(slot);
+    _entries[index].key = NULL;
+    _entries[index].value = NULL;
+    _numKeys--;
+
+    //  Trailing holes can be reused right away
+    while (_entryCount > 0 && _entries[_entryCount - 1].key == NULL) {
+        _entryCount--;
     }
 
-    return (manyItems->begin() + idx)->second;
+    //  Released last, since that can call back into this dictionary
+    releaseKey(objKey);
+    releaseVal(objVal);
 }
 
-void cf_dict_array::setObjectForKey(const void* object, const void* key, ICFDict* dict, bool retain) {
-    if (manyItems) {
-        cf_array::iterator curKey = manyItems->begin();
-
-        while (curKey != manyItems->end()) {
-            if (dict->isEqual(key, curKey->first)) {
-                break;
-            }
-
-            curKey++;
+void EbrDictionary::removeAllValues() {
+    EbrDictionaryEntry* entries = _entries;
+    uint32_t entryCount = _entryCount;
+
+    IwFree(_slots);
+    _entries = NULL;
+    _slots = NULL;
+    _slotMask = 0;
+    _entryCount = 0;
+    _entryCapacity = 0;
+    _numKeys = 0;
+
+    for (uint32_t i = 0; i < entryCount; i++) {
+        if (entries[i].key != NULL) {
+            releaseKey(entries[i].key);
+            releaseVal(entries[i].value);
         }
+    }
 
-        if (curKey != manyItems->end()) {
-            //  Key already exists - release existing value and set new value
-            dict->releaseVal(curKey->second);
-            curKey->second = object;
-        } else {
-            //  Key doesn't exist, just a hash collision - add to the array
-            if (retain) {
-                key = dict->retainKey(key);
-            }
-            manyItems->push_back(cf_dictpair(key, object));
-            dict->numKeys++;
-        }
-    } else {
-        if (hasItem) {
-            if (dict->isEqual(key, singleKey)) {
-                //  Same key, switch objects
-                dict->releaseVal(singleValue);
-                singleValue = object;
-            } else {
-                //  Multiple keys on same hash
-                if (retain) {
-                    key = dict->retainKey(key);
-                }
-                manyItems = new cf_array();
-
-                manyItems->push_back(cf_dictpair(key, object));
-                manyItems->push_back(cf_dictpair(singleKey, singleValue));
-                dict->numKeys++;
-            }
-        } else {
-            //  Adding item
-            if (retain) {
-                key = dict->retainKey(key);
-            }
+    IwFree(entries);
+}
 
-            singleKey = key;
-            singleValue = object;
-            dict->numKeys++;
+void EbrDictionary::initIterator(struct dictIterator* iter) {
+    static_assert(sizeof(struct dictIterator) <= 5 * sizeof(const void*), "dictIterator must fit in NSFastEnumerationState");
+    iter->entry = 0;
+}
 
-            hasItem = true;
+bool EbrDictionary::getNextKey(struct dictIterator* iter, const void*& keyRet) {
+    while (iter->entry < _entryCount) {
+        const EbrDictionaryEntry& entry = _entries[iter->entry++];
+        if (entry.key != NULL) {
+            keyRet = entry.key;
+            return true;
         }
     }
+
+    return false;
 }
 
-bool cf_dict_array::objectForKey(const void* key, const void** retVal, ICFDict* dict) {
-    if (manyItems) {
-        //  Found array
-        cf_array::iterator curKey = manyItems->begin();
+bool EbrDictionary::getNextValue(struct dictIterator* iter, const void*& valueRet) {
+    while (iter->entry < _entryCount) {
+        const EbrDictionaryEntry& entry = _entries[iter->entry++];
+        if (entry.key != NULL) {
+            valueRet = entry.value;
+            return true;
+        }
+    }
 
-        while (curKey != manyItems->end()) {
-            if (dict->isEqual(key, curKey->first)) {
-                //  Found key
-                *retVal = (void*)curKey->second;
-                return true;
-            }
+    return false;
+}
 
-            curKey++;
-        }
+void EbrDictionary::getKeysAndValues(const void** keys, const void** values) {
+    uint32_t numValues = 0;
 
-        return false;
-    } else {
-        assert(hasItem == true);
+    for (uint32_t i = 0; i < _entryCount; i++) {
+        if (_entries[i].key != NULL) {
+            if (keys)
+                keys[numValues] = _entries[i].key;
+            if (values)
+                values[numValues] = _entries[i].value;
 
-        if (dict->isEqual(key, singleKey)) {
-            //  Found key
-            *retVal = (void*)singleValue;
-            return true;
+            numValues++;
         }
-
-        return false;
     }
-}
-
-bool cf_dict_array::removeObjectForKey(const void* key, ICFDict* dict) {
-    if (manyItems) {
-        //  Found array
-        cf_array::iterator curKey = manyItems->begin();
 
-        while (curKey != manyItems->end()) {
-            if (dict->isEqual(key, curKey->first)) {
-                const void* objKey = curKey->first;
-                const void* objVal = curKey->second;
-                bool isEmpty = false;
+    assert(numValues == _numKeys);
+}
 
-                manyItems->erase(curKey);
-                if (manyItems->empty()) {
-                    isEmpty = true;
-                }
+uint32_t EbrDictionary::getCount() {
+    return _numKeys;
+}
 
-                dict->releaseKey(objKey);
-                dict->releaseVal(objVal);
+class __CFDictionary : public EbrDictionary {
+public:
+    __CFDictionary(const CFDictionaryKeyCallBacks* k, const CFDictionaryValueCallBacks* v) : EbrDictionary(k, v) {
+    }
 
-                dict->numKeys--;
+    ~__CFDictionary() {
+    }
 
-                return isEmpty;
+    void copyFrom(__CFDictionary* dict) {
+        reserve(dict->_numKeys);
+
+        //  Copying into an empty dictionary that hashes keys the same way can reuse the stored hashes, and needs no
+        //  lookups since the keys are already unique.
+        bool reuseHashes = _numKeys == 0 && keyCallbacks.hash == dict->keyCallbacks.hash && keyCallbacks.equal == dict->keyCallbacks.equal;
+        for (uint32_t i = 0; i < dict->_entryCount; i++) {
+            const EbrDictionaryEntry& entry = dict->_entries[i];
+            if (entry.key == NULL) {
+                continue;
             }
 
-            curKey++;
-        }
-
-        return false;
-    } else {
-        assert(hasItem == true);
-        if (dict->isEqual(key, singleKey)) {
-            //  Found key
-            dict->releaseKey(singleKey);
-            dict->releaseVal(singleValue);
-            dict->numKeys--;
-            return true; //  We are empty
+            if (reuseHashes) {
+                _insert(retainKey(entry.key), retainVal(entry.value), entry.hash);
+            } else {
+                setObjectKey(entry.key, entry.value);
+            }
         }
-
-        return false;
     }
-}
+};
 
 /**
  @Status Interoperable
@@ -805,6 +500,7 @@ CFDictionaryRef CFDictionaryCreate(void* allocator,
                                    CFDictionaryValueCallBacks* valueCallbacks) {
     NSDictionary* ret = [NSDictionary alloc];
     ret->dict = new (ret->_dictSpace) __CFDictionary(keyCallbacks, valueCallbacks);
+    ret->dict->reserve(count);
 
     for (unsigned i = 0; i < count; i++) {
         ((NSDictionary*)(ret))->dict->setObjectKey(keys[i], values[i]);
@@ -824,10 +520,20 @@ void CFDictionaryAddValue(CFMutableDictionaryRef dict, const void* key, const vo
     }
 }
 
+//  NSDictionary subclasses that don't call -[NSDictionary init] have no storage of their own; the read-only calls below
+//  are forwarded to their methods instead.
+static inline bool _CFDictionaryHasStorage(CFDictionaryRef dict) {
+    return ((NSDictionary*)(dict))->dict != NULL;
+}
+
 /**
  @Status Interoperable
 */
 Boolean CFDictionaryContainsKey(CFDictionaryRef dict, const void* key) {
+    if (!_CFDictionaryHasStorage(dict)) {
+        return [(NSDictionary*)dict objectForKey:(id)key] != nil;
+    }
+
     const void* ret;
 
     return ((NSDictionary*)(dict))->dict->objectForKey(key, ret);
@@ -844,6 +550,10 @@ void CFDictionaryRemoveValue(CFMutableDictionaryRef dict, const void* key) {
  @Status Interoperable
 */
 CFIndex CFDictionaryGetCount(CFDictionaryRef dict) {
+    if (!_CFDictionaryHasStorage(dict)) {
+        return [(NSDictionary*)dict count];
+    }
+
     return ((NSDictionary*)(dict))->dict->getCount();
 }
 
@@ -865,6 +575,10 @@ const void* CFDictionaryGetValue(CFDictionaryRef dict, const void* key) {
         return 0;
     }
 
+    if (!_CFDictionaryHasStorage(dict)) {
+        return [(NSDictionary*)dict objectForKey:(id)key];
+    }
+
     const void* ret = nil;
 
     ((NSDictionary*)(dict))->dict->objectForKey(key, ret);
@@ -876,6 +590,14 @@ const void* CFDictionaryGetValue(CFDictionaryRef dict, const void* key) {
  @Status Interoperable
 */
 Boolean CFDictionaryGetValueIfPresent(CFDictionaryRef dict, const void* key, const void** valRet) {
+    if (!_CFDictionaryHasStorage(dict)) {
+        id value = [(NSDictionary*)dict objectForKey:(id)key];
+        if (value != nil && valRet) {
+            *valRet = value;
+        }
+        return value != nil;
+    }
+
     const void* ret;
 
     if (((NSDictionary*)(dict))->dict->objectForKey(key, ret)) {
@@ -908,6 +630,11 @@ void CFDictionaryApplyFunction(CFDictionaryRef dict, CFDictionaryApplierFunction
  @Status Interoperable
 */
 void CFDictionaryGetKeysAndValues(CFDictionaryRef dict, const void** pKeys, const void** pValues) {
+    if (!_CFDictionaryHasStorage(dict)) {
+        [(NSDictionary*)dict getObjects:(id*)pValues andKeys:(id*)pKeys];
+        return;
+    }
+
     ((NSDictionary*)(dict))->dict->getKeysAndValues((const void**)pKeys, pValues);
 }
 
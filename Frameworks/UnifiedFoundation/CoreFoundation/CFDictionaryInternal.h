@@ -16,54 +16,29 @@
 
 #pragma once
 
-#include "Hash.h"
-#include <vector>
+#include "CoreFoundation/CFDictionary.h"
 
-typedef std::pair<const void*, const void*> cf_dictpair;
-typedef std::vector<cf_dictpair> cf_array;
-
-class ICFDict {
-public:
-    uint32_t numKeys;
-    ICFDict() : numKeys(0) {
-    }
-
-    virtual uint32_t getHash(const void* key) = 0;
-    virtual bool isEqual(const void* val1, const void* val2) = 0;
-    virtual const void* retainKey(const void* key) = 0;
-    virtual const void* releaseKey(const void* key) = 0;
-    virtual const void* releaseVal(const void* val) = 0;
-    virtual const void* retainVal(const void* val) = 0;
+//  Key/value pairs live in a dense array in insertion order, with the hash stored next to them; removed pairs leave a
+//  hole until the array is compacted. A power-of-two slot table indexes the pairs using Robin Hood linear probing, so
+//  a lookup scans a short run of slots and compares keys only on a full hash match.
+struct EbrDictionaryEntry {
+    const void* key; //  NULL for a removed pair
+    const void* value;
+    uint32_t hash;
 };
 
-class cf_dict_array {
-private:
-    const void* singleKey;
-    const void* singleValue;
-    bool hasItem;
-    cf_array* manyItems;
-
-public:
-    cf_dict_array();
-    void destroy();
-    int count();
-    const void* keyAtIndex(int idx);
-    const void* valueAtIndex(int idx);
-    bool objectForKey(const void* key, const void** retVal, ICFDict* dict);
-    void setObjectForKey(const void* object, const void* key, ICFDict* dict, bool retain);
-    bool removeObjectForKey(const void* key, ICFDict* dict);
+struct EbrDictionarySlot {
+    uint32_t hash;
+    uint32_t entry; //  Index into the entries plus one; 0 for an empty slot
 };
 
 struct dictIterator;
-#include "khash.h"
 
-KHASH_DECLARE(cf_dictionary, khint32_t, cf_dict_array);
-typedef khash_t(cf_dictionary) cf_dictionary;
-
-class EbrDictionary : public cf_dictionary, public ICFDict {
+class EbrDictionary {
 public:
-    EbrDictionary();
+    EbrDictionary(const CFDictionaryKeyCallBacks* keyCallbacks, const CFDictionaryValueCallBacks* valueCallbacks);
     ~EbrDictionary();
+    void reserve(uint32_t count);
     void setObjectKey(const void* key, const void* object, bool retain = true);
     bool objectForKey(const void* key, const void*& ret);
     void removeKey(const void* key);
@@ -73,6 +48,33 @@ public:
     bool getNextValue(struct dictIterator* iter, const void*& valueRet);
     void getKeysAndValues(const void** keys, const void** values);
     uint32_t getCount();
+
+protected:
+    CFDictionaryKeyCallBacks keyCallbacks;
+    CFDictionaryValueCallBacks valueCallbacks;
+    CFAllocatorRef allocator;
+
+    EbrDictionaryEntry* _entries;
+    EbrDictionarySlot* _slots;
+    uint32_t _slotMask;
+    uint32_t _entryCount; //  Including holes
+    uint32_t _entryCapacity;
+    uint32_t _numKeys;
+
+    //  Set when the key callbacks are the NSObject ones, which are then called directly
+    bool _objectKeys;
+
+    const void* retainKey(const void* key);
+    void releaseKey(const void* key);
+    const void* retainVal(const void* val);
+    void releaseVal(const void* val);
+    uint32_t _hash(const void* key);
+    bool _isEqual(const void* key1, const void* key2);
+    bool _find(const void* key, uint32_t hash, uint32_t& slot);
+    void _insert(const void* key, const void* object, uint32_t hash);
+    void _insertSlot(uint32_t hash, uint32_t entry);
+    void _removeSlot(uint32_t slot);
+    void _rebuild(uint32_t slotCount);
 };
 
 int CFNSDescriptorCompare(id obj1, id obj2, void* descriptors);
@@ -33,6 +33,7 @@
 #include "Foundation/NSIndexSet.h"
 #include "Foundation/NSNull.h"
 #include "NSArrayInternal.h"
+#include "NSPropertyListSerializationInternal.h"
 #include "VAListHelper.h"
 #include "LoggingNative.h"
 
@@ -149,19 +150,12 @@ static NSArray* _initWithObjects(NSArray* array, const std::vector<id>& flatArgs
  @Status Interoperable
 */
 - (NSArray*)initWithContentsOfFile:(NSString*)filename {
-    const char* file = (char*)[filename UTF8String];
-
-    NSData* data = [NSData dataWithContentsOfFile:filename];
-
-    if (data == nil) {
+    id arrayData = [NSPropertyListSerialization _propertyListWithContentsOfFile:filename mutabilityOption:NSPropertyListImmutable];
+    if (arrayData == nil) {
         [self release];
         return nil;
     }
 
-    char* pData = (char*)[data bytes];
-
-    id arrayData =
-        [NSPropertyListSerialization propertyListFromData:data mutabilityOption:NSPropertyListImmutable format:0 errorDescription:0];
     if (![arrayData isKindOfClass:[NSArray class]]) {
         arrayData = [arrayData objectForKey:@"$objects"];
         if (![(id)arrayData isKindOfClass:[NSArray class]]) {
@@ -22,6 +22,7 @@
 #import <Foundation/NSBundle.h>
 #import <Foundation/NSString.h>
 #import <Foundation/NSPropertyListSerialization.h>
+#import "NSPropertyListSerializationInternal.h"
 #import <Foundation/NSData.h>
 #import <Foundation/NSMutableDictionary.h>
 #import <Foundation/NSMutableArray.h>
@@ -734,23 +735,21 @@ static NSArray* findFilesDirectory(NSBundle* self, NSString* bundlePath, NSStrin
         scanBundle(self, _bundlePath);
         logPerf("Assets scanned");
 
-        NSData* data = nil;
+        id infoDictionary = nil;
 
-        if (data == nil) {
+        if (infoDictionary == nil) {
             NSString* nextPath = [path stringByAppendingPathComponent:@"Info.plist"];
-            data = [NSData dataWithContentsOfFile:nextPath];
+            infoDictionary = [NSPropertyListSerialization _propertyListWithContentsOfFile:nextPath mutabilityOption:NSPropertyListImmutable];
             path = nextPath;
         }
-        if (data == nil) {
+        if (infoDictionary == nil) {
             NSString* nextPath = [path stringByAppendingPathComponent:@"Contents/Info.plist"];
-            data = [NSData dataWithContentsOfFile:nextPath];
+            infoDictionary = [NSPropertyListSerialization _propertyListWithContentsOfFile:nextPath mutabilityOption:NSPropertyListImmutable];
             path = nextPath;
         }
 
-        if ([data length] > 0) {
-            _infoDictionary = [
-                [NSPropertyListSerialization propertyListFromData:data mutabilityOption:NSPropertyListImmutable format:0 errorDescription:0]
-                retain];
+        if (infoDictionary != nil) {
+            _infoDictionary = [infoDictionary retain];
 
             //  Find localized sttrings
             NSString* stringPath = [self pathForResource:@"Localizable" ofType:@"strings"];
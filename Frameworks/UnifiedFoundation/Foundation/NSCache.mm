@@ -14,49 +14,476 @@
 //
 //******************************************************************************
 
-#import <StubReturn.h>
+#include "Starboard.h"
 #import <Foundation/NSCache.h>
+#import <Foundation/NSDiscardableContent.h>
+#import <Foundation/NSNotificationCenter.h>
+#import <Foundation/NSString.h>
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+// Posted by UIApplication when the system reports high memory usage. Foundation cannot link against the UIKit
+// constant, so the name is repeated here.
+static NSString* const _NSCacheMemoryWarningNotification = @"UIApplicationDidReceiveMemoryWarningNotification";
+
+struct NSCacheEntry {
+    id key;
+    id object;
+    NSUInteger hash;
+    NSUInteger cost;
+    bool discardable;
+
+    // Position in the shard's recency list and the cache-wide stamp of the last access
+    NSCacheEntry* prev = nullptr;
+    NSCacheEntry* next = nullptr;
+    uint64_t stamp = 0;
+};
+
+struct NSCacheKey {
+    NSUInteger hash;
+    id key;
+};
+
+struct NSCacheKeyHash {
+    size_t operator()(const NSCacheKey& key) const {
+        return key.hash;
+    }
+};
+
+struct NSCacheKeyEqual {
+    bool operator()(const NSCacheKey& left, const NSCacheKey& right) const {
+        return left.hash == right.hash && (left.key == right.key || [left.key isEqual:right.key]);
+    }
+};
+
+// Keys are spread over shards by hash, each with its own lock, table and recency list, so threads working on different
+// keys rarely contend. Each list is in exact least-recently-used order. Across shards, entries are ordered by a stamp
+// that every insertion and lookup takes from a cache-wide clock, so no two accesses share a stamp and eviction always
+// picks the least recently used entry whichever shards they live in.
+struct NSCacheShard {
+    std::mutex lock;
+    std::unordered_map<NSCacheKey, NSCacheEntry*, NSCacheKeyHash, NSCacheKeyEqual> entries;
+    NSCacheEntry* oldest = nullptr;
+    NSCacheEntry* newest = nullptr;
+
+    void unlink(NSCacheEntry* entry) {
+        (entry->prev ? entry->prev->next : oldest) = entry->next;
+        (entry->next ? entry->next->prev : newest) = entry->prev;
+        entry->prev = entry->next = nullptr;
+    }
+
+    void append(NSCacheEntry* entry) {
+        entry->prev = newest;
+        entry->next = nullptr;
+        (newest ? newest->next : oldest) = entry;
+        newest = entry;
+    }
+
+    void remove(NSCacheEntry* entry) {
+        entries.erase({ entry->hash, entry->key });
+        unlink(entry);
+    }
+};
+
+static const size_t c_shardCount = 16;
+
+struct NSCachePriv {
+    NSCacheShard shards[c_shardCount];
+
+    std::atomic<uint64_t> clock{ 0 };
+    std::atomic<NSUInteger> totalCost{ 0 };
+    std::atomic<NSUInteger> count{ 0 };
+
+    std::atomic<NSUInteger> countLimit{ 0 };
+    std::atomic<NSUInteger> totalCostLimit{ 0 };
+    std::atomic<bool> evictsObjectsWithDiscardedContent{ true };
+
+    // Serializes eviction passes, so that concurrent insertions do not evict more than needed between them.
+    std::mutex evictionLock;
+
+    std::mutex propertyLock;
+    NSString* name = nil;
+    id<NSCacheDelegate> delegate = nil;
+
+    NSCacheShard& shardFor(NSUInteger hash) {
+        // Mix the high bits in; many hash functions leave the low ones poorly distributed
+        return shards[(hash ^ (hash >> 7) ^ (hash >> 17)) % c_shardCount];
+    }
+
+    bool overLimit() const {
+        NSUInteger maxCount = countLimit.load(std::memory_order_relaxed);
+        NSUInteger maxCost = totalCostLimit.load(std::memory_order_relaxed);
+        return (maxCount != 0 && count.load(std::memory_order_relaxed) > maxCount) ||
+               (maxCost != 0 && totalCost.load(std::memory_order_relaxed) > maxCost);
+    }
+
+    void accountRemoved(NSCacheEntry* entry) {
+        count.fetch_sub(1, std::memory_order_relaxed);
+        totalCost.fetch_sub(entry->cost, std::memory_order_relaxed);
+    }
+};
+
+@implementation NSCache {
+    NSCachePriv* priv;
+}
 
-@implementation NSCache
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
+*/
+- (instancetype)init {
+    if (self = [super init]) {
+        priv = new NSCachePriv();
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(_didReceiveMemoryWarning:)
+                                                     name:_NSCacheMemoryWarningNotification
+                                                   object:nil];
+    }
+
+    return self;
+}
+
+/**
+ @Status Interoperable
+*/
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+
+    for (NSCacheShard& shard : priv->shards) {
+        for (NSCacheEntry* entry = shard.oldest; entry != nullptr;) {
+            NSCacheEntry* next = entry->next;
+            [entry->key release];
+            [entry->object release];
+            delete entry;
+            entry = next;
+        }
+    }
+
+    [priv->name release];
+    delete priv;
+
+    [super dealloc];
+}
+
+- (id<NSCacheDelegate>)_delegate {
+    std::lock_guard<std::mutex> lock(priv->propertyLock);
+    return [[priv->delegate retain] autorelease];
+}
+
+// Tells the delegate about an entry that has already been taken out of the cache, then frees it. When the cache itself
+// chose to evict the entry, discardable content is also asked to discard itself. Must be called with no shard locked,
+// since the delegate may call back into the cache.
+- (void)_finishEvicting:(NSCacheEntry*)entry delegate:(id<NSCacheDelegate>)delegate discard:(bool)discard {
+    if ([delegate respondsToSelector:@selector(cache:willEvictObject:)]) {
+        [delegate cache:self willEvictObject:entry->object];
+    }
+
+    if (discard && entry->discardable) {
+        [entry->object discardContentIfPossible];
+    }
+
+    [entry->key release];
+    [entry->object release];
+    delete entry;
+}
+
+// Evicts least recently used entries until the cache is back within its limits.
+- (void)_evictToLimits {
+    if (!priv->overLimit()) {
+        return;
+    }
+
+    std::vector<NSCacheEntry*> victims;
+    {
+        std::lock_guard<std::mutex> evictionLock(priv->evictionLock);
+        while (priv->overLimit()) {
+            // Find the shard whose least recently used entry is the oldest
+            NSCacheShard* victimShard = nullptr;
+            uint64_t victimStamp = UINT64_MAX;
+            for (NSCacheShard& shard : priv->shards) {
+                std::lock_guard<std::mutex> lock(shard.lock);
+                if (shard.oldest && shard.oldest->stamp < victimStamp) {
+                    victimShard = &shard;
+                    victimStamp = shard.oldest->stamp;
+                }
+            }
+
+            if (victimShard == nullptr) {
+                break;
+            }
+
+            std::lock_guard<std::mutex> lock(victimShard->lock);
+            NSCacheEntry* victim = victimShard->oldest;
+            if (victim != nullptr) {
+                victimShard->remove(victim);
+                priv->accountRemoved(victim);
+                victims.push_back(victim);
+            }
+        }
+    }
+
+    id<NSCacheDelegate> delegate = [self _delegate];
+    for (NSCacheEntry* victim : victims) {
+        [self _finishEvicting:victim delegate:delegate discard:true];
+    }
+}
+
+/**
+ @Status Interoperable
 */
 - (id)objectForKey:(id)key {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (key == nil) {
+        return nil;
+    }
+
+    NSUInteger hash = [key hash];
+    NSCacheShard& shard = priv->shardFor(hash);
+    id object = nil;
+    bool discardable = false;
+
+    {
+        std::lock_guard<std::mutex> lock(shard.lock);
+        auto found = shard.entries.find({ hash, key });
+        if (found == shard.entries.end()) {
+            return nil;
+        }
+
+        NSCacheEntry* entry = found->second;
+        entry->stamp = priv->clock.fetch_add(1, std::memory_order_relaxed) + 1;
+        shard.unlink(entry);
+        shard.append(entry);
+
+        object = [entry->object retain];
+        discardable = entry->discardable;
+    }
+
+    if (discardable && priv->evictsObjectsWithDiscardedContent.load(std::memory_order_relaxed) && [object isContentDiscarded]) {
+        [self _removeObject:object forKey:key];
+        [object release];
+        return nil;
+    }
+
+    return [object autorelease];
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 - (void)setObject:(id)obj forKey:(id)key {
-    UNIMPLEMENTED();
+    [self setObject:obj forKey:key cost:0];
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
+ @Notes The limits are enforced as soon as an insertion exceeds them, evicting least recently used objects first.
 */
 - (void)setObject:(id)obj forKey:(id)key cost:(NSUInteger)num {
-    UNIMPLEMENTED();
+    if (obj == nil) {
+        [self removeObjectForKey:key];
+        return;
+    }
+    if (key == nil) {
+        return;
+    }
+
+    NSUInteger hash = [key hash];
+    NSCacheShard& shard = priv->shardFor(hash);
+    bool discardable = [obj conformsToProtocol:@protocol(NSDiscardableContent)];
+    id replaced = nil;
+
+    {
+        std::lock_guard<std::mutex> lock(shard.lock);
+        uint64_t stamp = priv->clock.fetch_add(1, std::memory_order_relaxed) + 1;
+
+        auto found = shard.entries.find({ hash, key });
+        if (found != shard.entries.end()) {
+            NSCacheEntry* entry = found->second;
+            replaced = entry->object;
+            entry->object = [obj retain];
+            entry->discardable = discardable;
+            priv->totalCost.fetch_add(num - entry->cost, std::memory_order_relaxed);
+            entry->cost = num;
+            entry->stamp = stamp;
+            shard.unlink(entry);
+            shard.append(entry);
+        } else {
+            NSCacheEntry* entry = new NSCacheEntry();
+            entry->key = [key retain];
+            entry->object = [obj retain];
+            entry->hash = hash;
+            entry->cost = num;
+            entry->discardable = discardable;
+            entry->stamp = stamp;
+            shard.entries.emplace(NSCacheKey{ hash, entry->key }, entry);
+            shard.append(entry);
+
+            priv->count.fetch_add(1, std::memory_order_relaxed);
+            priv->totalCost.fetch_add(num, std::memory_order_relaxed);
+        }
+    }
+
+    [replaced release];
+    [self _evictToLimits];
+}
+
+// Removes key only if it still maps to object.
+- (void)_removeObject:(id)object forKey:(id)key {
+    NSUInteger hash = [key hash];
+    NSCacheShard& shard = priv->shardFor(hash);
+    NSCacheEntry* entry = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(shard.lock);
+        auto found = shard.entries.find({ hash, key });
+        if (found == shard.entries.end() || found->second->object != object) {
+            return;
+        }
+        entry = found->second;
+        shard.remove(entry);
+        priv->accountRemoved(entry);
+    }
+
+    [self _finishEvicting:entry delegate:[self _delegate] discard:false];
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 - (void)removeObjectForKey:(id)key {
-    UNIMPLEMENTED();
+    if (key == nil) {
+        return;
+    }
+
+    NSUInteger hash = [key hash];
+    NSCacheShard& shard = priv->shardFor(hash);
+    NSCacheEntry* entry = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(shard.lock);
+        auto found = shard.entries.find({ hash, key });
+        if (found == shard.entries.end()) {
+            return;
+        }
+        entry = found->second;
+        shard.remove(entry);
+        priv->accountRemoved(entry);
+    }
+
+    [self _finishEvicting:entry delegate:[self _delegate] discard:false];
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 - (void)removeAllObjects {
-    UNIMPLEMENTED();
+    [self _removeAllObjectsDiscardingContent:false];
+}
+
+- (void)_removeAllObjectsDiscardingContent:(bool)discard {
+    std::vector<NSCacheEntry*> removed;
+
+    for (NSCacheShard& shard : priv->shards) {
+        std::lock_guard<std::mutex> lock(shard.lock);
+        for (NSCacheEntry* entry = shard.oldest; entry != nullptr; entry = entry->next) {
+            removed.push_back(entry);
+            priv->accountRemoved(entry);
+        }
+        shard.entries.clear();
+        shard.oldest = shard.newest = nullptr;
+    }
+
+    id<NSCacheDelegate> delegate = [self _delegate];
+    for (NSCacheEntry* entry : removed) {
+        [self _finishEvicting:entry delegate:delegate discard:discard];
+    }
+}
+
+- (void)_didReceiveMemoryWarning:(NSNotification*)notification {
+    [self _removeAllObjectsDiscardingContent:true];
+}
+
+/**
+ @Status Interoperable
+*/
+- (NSUInteger)countLimit {
+    return priv->countLimit.load(std::memory_order_relaxed);
+}
+
+/**
+ @Status Interoperable
+*/
+- (void)setCountLimit:(NSUInteger)limit {
+    priv->countLimit.store(limit, std::memory_order_relaxed);
+    [self _evictToLimits];
+}
+
+/**
+ @Status Interoperable
+*/
+- (NSUInteger)totalCostLimit {
+    return priv->totalCostLimit.load(std::memory_order_relaxed);
+}
+
+/**
+ @Status Interoperable
+*/
+- (void)setTotalCostLimit:(NSUInteger)limit {
+    priv->totalCostLimit.store(limit, std::memory_order_relaxed);
+    [self _evictToLimits];
+}
+
+/**
+ @Status Interoperable
+*/
+- (BOOL)evictsObjectsWithDiscardedContent {
+    return priv->evictsObjectsWithDiscardedContent.load(std::memory_order_relaxed);
+}
+
+/**
+ @Status Interoperable
+*/
+- (void)setEvictsObjectsWithDiscardedContent:(BOOL)evicts {
+    priv->evictsObjectsWithDiscardedContent.store(evicts != NO, std::memory_order_relaxed);
+}
+
+/**
+ @Status Interoperable
+*/
+- (NSString*)name {
+    std::lock_guard<std::mutex> lock(priv->propertyLock);
+    return [[priv->name retain] autorelease];
+}
+
+/**
+ @Status Interoperable
+*/
+- (void)setName:(NSString*)name {
+    NSString* copy = [name copy];
+    NSString* old;
+    {
+        std::lock_guard<std::mutex> lock(priv->propertyLock);
+        old = priv->name;
+        priv->name = copy;
+    }
+    [old release];
+}
+
+/**
+ @Status Interoperable
+*/
+- (id<NSCacheDelegate>)delegate {
+    return [self _delegate];
+}
+
+/**
+ @Status Interoperable
+*/
+- (void)setDelegate:(id<NSCacheDelegate>)delegate {
+    std::lock_guard<std::mutex> lock(priv->propertyLock);
+    priv->delegate = delegate;
 }
 
 @end
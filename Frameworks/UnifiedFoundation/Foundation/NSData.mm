@@ -20,157 +20,125 @@
 #include <string>
 #include "Foundation/NSMutableData.h"
 #include "Foundation/NSError.h"
-#include "Foundation/NSScanner.h"
 #include "Foundation/NSString.h"
 #include "Foundation/NSMutableArray.h"
 #include "Foundation/NSValue.h"
-#include <UWP/WindowsStorageStreams.h>
-#include <UWP/WindowsSecurityCryptography.h>
 
 #include <COMIncludes.h>
 #include "ErrorHandling.h"
-#include "RawBuffer.h"
-#include <wrl\wrappers\corewrappers.h>
-#include <windows.security.cryptography.h>
-#include <windows.storage.streams.h>
 #include <COMIncludes_End.h>
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
-#include "StringHelpers.h"
+#include "NSDataKernels.h"
 #include "LoggingNative.h"
 
 static const wchar_t* TAG = L"NSData";
 
-using namespace Microsoft::WRL;
-using namespace ABI::Windows::Security::Cryptography;
-using namespace ABI::Windows::Storage::Streams;
-using namespace Windows::Foundation;
-
 // TODO: BUG 192601: Enable ARC on this file once the code gen error is fixed
 
-@implementation NSData
+// Returns the characters, without a terminator, in a buffer to release with IwFree
+static char* _encodeBase64(NSData* data, NSDataBase64EncodingOptions options, size_t* encodedLength) {
+    size_t lineLength = 0;
+    if (options & NSDataBase64Encoding64CharacterLineLength) {
+        lineLength = 64;
+    } else if (options & NSDataBase64Encoding76CharacterLineLength) {
+        lineLength = 76;
+    }
 
-/**
- @Status Interoperable
-*/
-- (NSString*)base64EncodedStringWithOptions:(NSDataBase64EncodingOptions)options {
-    ComPtr<IBuffer> wrlBuffer;
-    IBuffer* rawBuffer = nullptr;
-    HRESULT result;
+    // CRLF unless only one of the two is asked for
+    const char* separator = "\r\n";
+    bool useCR = (options & NSDataBase64EncodingEndLineWithCarriageReturn) != 0;
+    bool useLF = (options & NSDataBase64EncodingEndLineWithLineFeed) != 0;
+    if (useCR && !useLF) {
+        separator = "\r";
+    } else if (!useCR && useLF) {
+        separator = "\n";
+    }
+    size_t separatorLength = strlen(separator);
+
+    size_t length = [data length];
+    *encodedLength = NSDataKernels::Base64EncodedLength(length, lineLength, separatorLength);
+    char* characters = (char*)IwMalloc(std::max<size_t>(*encodedLength, 1));
+    if (characters == nullptr) {
+        return nullptr;
+    }
 
-    result = BufferFromRawData(&rawBuffer, _bytes, _length);
+    NSDataKernels::Base64Encode((const uint8_t*)[data bytes], length, lineLength, separator, separatorLength, characters);
+    return characters;
+}
 
-    if (FAILED(result)) {
+static id _initWithBase64(NSData* self, const char* characters, size_t length, NSDataBase64DecodingOptions options) {
+    uint8_t* bytes = (uint8_t*)IwMalloc(std::max<size_t>(NSDataKernels::Base64DecodedMaximumLength(length), 1));
+    size_t decodedLength = 0;
+    bool ignoreUnknownCharacters = (options & NSDataBase64DecodingIgnoreUnknownCharacters) != 0;
+    if (bytes == nullptr || !NSDataKernels::Base64Decode(characters, length, ignoreUnknownCharacters, bytes, &decodedLength)) {
+        IwFree(bytes);
+        [self release];
         return nil;
     }
 
-    wrlBuffer.Attach(rawBuffer);
-
-    ComPtr<ICryptographicBufferStatics> cryptographicBufferStatics;
-    RETURN_NULL_IF_FAILED(
-        GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Security_Cryptography_CryptographicBuffer).Get(),
-                             &cryptographicBufferStatics));
-
-    Wrappers::HString encodedString;
-    RETURN_NULL_IF_FAILED(cryptographicBufferStatics->EncodeToBase64String(wrlBuffer.Get(), encodedString.GetAddressOf()));
-
-    unsigned int rawLength;
-    const wchar_t* rawEncodedString = WindowsGetStringRawBuffer(encodedString.Get(), &rawLength);
-
-    NSString* nsEncodedString =
-        [[NSString alloc] initWithBytes:rawEncodedString length:(rawLength * sizeof(wchar_t)) encoding:NSUnicodeStringEncoding];
-
-    // Do any necessary post-processing for options
-    // If line length specified, place a newline character (/r, /n, or /r/n every (specified number) characters)
-    if ((options & NSDataBase64Encoding64CharacterLineLength) || (options & NSDataBase64Encoding76CharacterLineLength)) {
-        size_t lineLength = (options & NSDataBase64Encoding64CharacterLineLength) ? 64 : 76;
-        // Calculate number of times to insert newlines
-        // Since no newline is needed at the end if stringLength is evenly divisible by lineLength,
-        // subtract 1 from stringLength when dividing
-        size_t stringLength = [nsEncodedString length];
-        size_t newLineCount = (stringLength != 0) ? ((stringLength - 1) / lineLength) : 0;
-
-        if (newLineCount > 0) {
-            NSDataBase64EncodingOptions useCR = options & NSDataBase64EncodingEndLineWithCarriageReturn;
-            NSDataBase64EncodingOptions useLF = options & NSDataBase64EncodingEndLineWithLineFeed;
-
-            StrongId<NSString> newLineChar;
-            if (useCR && !useLF) {
-                newLineChar = @"\r";
-            } else if (!useCR && useLF) {
-                newLineChar = @"\n";
-            } else {
-                // Use CRLF by default, but can also be manually specified
-                newLineChar = @"\r\n";
-            }
+    return [self initWithBytesNoCopy:bytes length:decodedLength freeWhenDone:TRUE];
+}
 
-            NSMutableString* mutableEncodedString = [NSMutableString stringWithString:nsEncodedString];
+// Below this, NSDataReadingMappedIfSafe reads the file instead; a mapping costs a view and whole pages for a few bytes
+static const size_t c_minimumMappedIfSafeLength = 64 * 1024;
 
-            // Add new line every (lineLength) chars
-            // Iterate backwards to avoid compensating for changes in length
-            for (size_t i = newLineCount; i > 0; i--) {
-                [mutableEncodedString insertString:newLineChar atIndex:(i * lineLength)];
-            }
+@interface NSData () {
+    // The file view _bytes points into, if the data was mapped
+    void* _mapping;
+    size_t _mappingSize;
 
-            return [NSString stringWithString:mutableEncodedString];
-        }
+    // The data that owns the bytes of a slice made by subdataWithRange:
+    NSData* _owner;
+}
+@end
+
+static bool _shouldMapFile(NSData* data, NSDataReadingOptions options, size_t length) {
+    // Mutable data writes through mutableBytes, which a read-only view can't take
+    if ([data isKindOfClass:[NSMutableData class]]) {
+        return false;
     }
 
-    // If line length not specified, or newLineCount <= 0, none of the other options matter, just return nsEncodedString
-    return [nsEncodedString autorelease];
+    if (options & NSDataReadingMappedAlways) {
+        return true;
+    }
+    return (options & NSDataReadingMappedIfSafe) && length >= c_minimumMappedIfSafeLength;
 }
 
+@implementation NSData
+
 /**
  @Status Interoperable
 */
-- (instancetype)initWithBase64EncodedString:(NSString*)base64String options:(NSDataBase64DecodingOptions)options {
-    StrongId<NSString> stringToUse = base64String;
-
-    // Create a clean version of the string if IgnoreUnknownCharacters is specified
-    if (options & NSDataBase64DecodingIgnoreUnknownCharacters) {
-        NSMutableString* cleanedString = [NSMutableString stringWithCapacity:[base64String length]];
-        StrongId<NSScanner> scanner = [NSScanner scannerWithString:base64String];
-        StrongId<NSCharacterSet> base64AllowedCharacters =
-            [NSCharacterSet characterSetWithCharactersInString:@"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/="];
-
-        while (![scanner isAtEnd]) {
-            NSString* buf;
-            if ([scanner scanCharactersFromSet:base64AllowedCharacters intoString:&buf]) {
-                [cleanedString appendString:buf];
-            } else {
-                [scanner setScanLocation:[scanner scanLocation] + 1];
-            }
-        }
-
-        stringToUse = cleanedString;
-    }
-
-    if ([stringToUse length] == 0) {
-        return [self initWithBytes:"" length:0];
+- (NSString*)base64EncodedStringWithOptions:(NSDataBase64EncodingOptions)options {
+    size_t length;
+    char* characters = _encodeBase64(self, options, &length);
+    if (characters == nullptr) {
+        return nil;
     }
 
-    ComPtr<ICryptographicBufferStatics> cryptographicBufferStatics;
-    RETURN_NULL_IF_FAILED(
-        GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Security_Cryptography_CryptographicBuffer).Get(),
-                             &cryptographicBufferStatics));
-
-    Wrappers::HString wrlBase64String = Strings::NarrowToWide<HSTRING>(stringToUse);
-
-    ComPtr<IBuffer> wrlBuffer;
-    RETURN_NULL_IF_FAILED(cryptographicBufferStatics->DecodeFromBase64String(wrlBase64String.Get(), wrlBuffer.GetAddressOf()));
-
-    ComPtr<IBufferByteAccess> bufferAccess;
-    RETURN_NULL_IF_FAILED(wrlBuffer.As(&bufferAccess));
+    NSString* ret = [[NSString alloc] initWithBytes:characters length:length encoding:NSASCIIStringEncoding];
+    IwFree(characters);
+    return [ret autorelease];
+}
 
-    uint8_t* rawBuffer;
-    RETURN_NULL_IF_FAILED(bufferAccess->Buffer(&rawBuffer));
+/**
+ @Status Interoperable
+*/
+- (instancetype)initWithBase64EncodedString:(NSString*)base64String options:(NSDataBase64DecodingOptions)options {
+    const char* characters = [base64String UTF8String];
+    size_t length = characters ? strlen(characters) : 0;
 
-    unsigned int bufferLength;
-    RETURN_NULL_IF_FAILED(wrlBuffer->get_Length(&bufferLength));
+    // A UTF-8 string is never shorter than the UTF-16 one, unless it stopped at an embedded NUL
+    if (length < [base64String length]) {
+        NSData* data = [base64String dataUsingEncoding:NSUTF8StringEncoding];
+        return _initWithBase64(self, (const char*)[data bytes], [data length], options);
+    }
 
-    return [self initWithBytes:rawBuffer length:bufferLength];
+    return _initWithBase64(self, characters, length, options);
 }
 
 /**
@@ -312,12 +280,10 @@ using namespace Windows::Foundation;
 }
 
 /**
- @Status Caveat
- @Notes File is not mapped; defers to initWithContentsOfFile:
+ @Status Interoperable
 */
 - (instancetype)initWithContentsOfMappedFile:(NSString*)filename {
-    TraceVerbose(TAG, L"Not actually mapping file ...");
-    return [self initWithContentsOfFile:filename];
+    return [self initWithContentsOfFile:filename options:NSDataReadingMappedAlways error:nullptr];
 }
 
 /**
@@ -404,8 +370,7 @@ using namespace Windows::Foundation;
 }
 
 /**
- @Status Caveat
- @Notes File is not mapped; defers to initWithContentsOfFile:
+ @Status Interoperable
 */
 + (instancetype)dataWithContentsOfMappedFile:(NSString*)filename {
     return [[[self alloc] initWithContentsOfMappedFile:filename] autorelease];
@@ -413,7 +378,8 @@ using namespace Windows::Foundation;
 
 /**
  @Status Caveat
- @Notes options parameter not supported
+ @Notes NSDataReadingUncached is not supported. NSDataReadingMappedIfSafe maps files of 64KB or more;
+        NSMutableData always reads the file.
 */
 - (instancetype)initWithContentsOfFile:(NSString*)filename options:(NSDataReadingOptions)options error:(NSError**)error {
     _bytes = nullptr;
@@ -438,6 +404,20 @@ using namespace Windows::Foundation;
         size_t length = EbrFtell(fpIn);
         EbrFseek(fpIn, 0, SEEK_SET);
 
+        if (length && _shouldMapFile(self, options, length)) {
+            // The view stays valid after the file is closed
+            _mapping = EbrMmap(EbrFileno(fpIn), length, 0);
+            if (_mapping) {
+                _mappingSize = length;
+                _bytes = (uint8_t*)_mapping;
+                _length = length;
+                _freeWhenDone = FALSE;
+                return self;
+            }
+
+            TraceVerbose(TAG, L"NSData couldn't map %hs, reading it instead", fname);
+        }
+
         if (length) {
             _bytes = (uint8_t*)IwMalloc(length);
             if (!_bytes) {
@@ -467,9 +447,7 @@ using namespace Windows::Foundation;
  @Status Interoperable
 */
 - (instancetype)initWithBase64EncodedData:(NSData*)base64Data options:(NSDataBase64DecodingOptions)options {
-    StrongId<NSString> base64String = [[[NSString alloc] initWithData:base64Data encoding:NSUTF8StringEncoding] autorelease];
-    auto ret = [self initWithBase64EncodedString:base64String options:options];
-    return ret;
+    return _initWithBase64(self, (const char*)[base64Data bytes], [base64Data length], options);
 }
 
 /**
@@ -490,25 +468,70 @@ using namespace Windows::Foundation;
 }
 
 /**
- @Status Stub
+ @Status Interoperable
+ @Notes The bytes are always contiguous, so the block is called once
 */
 - (void)enumerateByteRangesUsingBlock:(void (^)(const void* bytes, NSRange byteRange, BOOL* stop))block {
-    UNIMPLEMENTED();
+    if (_length == 0) {
+        return;
+    }
+
+    BOOL stop = NO;
+    block([self bytes], NSMakeRange(0, _length), &stop);
 }
 
 /**
- @Status Stub
+ @Status Interoperable
 */
 - (NSRange)rangeOfData:(NSData*)dataToFind options:(NSDataSearchOptions)mask range:(NSRange)searchRange {
-    UNIMPLEMENTED();
-    return NSMakeRange(0, 0);
+    if (dataToFind == nil) {
+        [NSException raise:NSInvalidArgumentException format:@"dataToFind is nil"];
+    }
+    if (searchRange.location > _length || searchRange.length > _length - searchRange.location) {
+        [NSException raise:NSRangeException
+                    format:@"range is out of bounds - range.location = %d, range.length = %d, Data length = %d",
+                           searchRange.location,
+                           searchRange.length,
+                           _length];
+    }
+
+    size_t needleLength = [dataToFind length];
+    if (needleLength == 0 || needleLength > searchRange.length) {
+        return NSMakeRange(NSNotFound, 0);
+    }
+
+    const uint8_t* haystack = _bytes + searchRange.location;
+    const uint8_t* needle = (const uint8_t*)[dataToFind bytes];
+    bool backwards = (mask & NSDataSearchBackwards) != 0;
+
+    size_t found;
+    if (mask & NSDataSearchAnchored) {
+        // Anchored at the end of the range when searching backwards
+        size_t offset = backwards ? searchRange.length - needleLength : 0;
+        found = memcmp(haystack + offset, needle, needleLength) == 0 ? offset : NSDataKernels::c_notFound;
+    } else if (backwards) {
+        found = NSDataKernels::Get().findLast(haystack, searchRange.length, needle, needleLength);
+    } else {
+        found = NSDataKernels::Get().find(haystack, searchRange.length, needle, needleLength);
+    }
+
+    if (found == NSDataKernels::c_notFound) {
+        return NSMakeRange(NSNotFound, 0);
+    }
+    return NSMakeRange(searchRange.location + found, needleLength);
 }
 
 /**
  @Status Interoperable
 */
 - (NSData*)base64EncodedDataWithOptions:(NSDataBase64EncodingOptions)options {
-    return [[self base64EncodedStringWithOptions:options] dataUsingEncoding:NSUTF8StringEncoding];
+    size_t length;
+    char* characters = _encodeBase64(self, options, &length);
+    if (characters == nullptr) {
+        return nil;
+    }
+
+    return [NSData dataWithBytesNoCopy:characters length:length freeWhenDone:TRUE];
 }
 
 /**
@@ -572,7 +595,25 @@ using namespace Windows::Foundation;
  @Status Interoperable
 */
 - (instancetype)subdataWithRange:(NSRange)range {
-    return [NSData dataWithBytes:_bytes + range.location length:range.length];
+    if (range.location > _length || range.length > _length - range.location) {
+        [NSException raise:NSRangeException
+                    format:@"range is out of bounds - range.location = %d, range.length = %d, Data length = %d",
+                           range.location,
+                           range.length,
+                           _length];
+    }
+
+    // Immutable data that owns its bytes shares them with the slice, which keeps the owner alive. Mutable data can
+    // change under the slice, and bytes the data doesn't own may go away while the slice is still around, so those
+    // are copied.
+    NSData* owner = _owner ? _owner : self;
+    if ([self isKindOfClass:[NSMutableData class]] || !(owner->_freeWhenDone || owner->_mapping)) {
+        return [NSData dataWithBytes:_bytes + range.location length:range.length];
+    }
+
+    NSData* ret = [[NSData alloc] initWithBytesNoCopy:_bytes + range.location length:range.length freeWhenDone:FALSE];
+    ret->_owner = [owner retain];
+    return [ret autorelease];
 }
 
 /**
@@ -679,6 +720,12 @@ using namespace Windows::Foundation;
         _bytes = nullptr;
     }
 
+    if (_mapping) {
+        EbrMunmap(_mapping, _mappingSize);
+        _mapping = nullptr;
+    }
+
+    [_owner release];
     [super dealloc];
 }
 
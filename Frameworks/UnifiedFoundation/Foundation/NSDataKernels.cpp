@@ -0,0 +1,246 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+// Scalar and SSE2 kernels, the runtime selection between them and the SSSE3 and AVX2 kernels, and the base64 framing
+// (line breaks, padding, unknown characters) around the table.
+
+#include "NSDataKernelsImpl.h"
+
+#include <vector>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define NSDATA_KERNELS_X86 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace NSDataKernels {
+
+void InitializeScalar(Table& table) {
+    table.name = "Scalar";
+    table.encodeBase64 = encodeBase64Scalar;
+    table.decodeBase64 = decodeBase64Scalar;
+    table.find = findScalar;
+    table.findLast = findLastScalar;
+}
+
+#ifdef NSDATA_KERNELS_X86
+namespace {
+
+struct SSE2Bytes {
+    typedef __m128i V;
+    static const size_t width = 16;
+    static V load(const uint8_t* p) {
+        return _mm_loadu_si128((const __m128i*)p);
+    }
+    static V splat(uint8_t x) {
+        return _mm_set1_epi8((char)x);
+    }
+    static unsigned matches(V a, V x, V b, V y) {
+        return (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, x), _mm_cmpeq_epi8(b, y)));
+    }
+};
+
+void cpuid(int info[4], int leaf) {
+#ifdef _MSC_VER
+    __cpuidex(info, leaf, 0);
+#else
+    unsigned int a = 0, b = 0, c = 0, d = 0;
+    __cpuid_count(leaf, 0, a, b, c, d);
+    info[0] = a;
+    info[1] = b;
+    info[2] = c;
+    info[3] = d;
+#endif
+}
+
+unsigned long long xgetbv0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+bool cpuHasSSE2() {
+    int info[4];
+    cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+}
+
+bool cpuHasSSSE3() {
+    int info[4];
+    cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+}
+
+// AVX2 needs both the CPU bit and the OS saving the YMM registers on context switches (OSXSAVE + XCR0 bits 1 and 2).
+bool cpuHasAVX2() {
+    int info[4];
+    cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    cpuid(info, 1);
+    const int osxsave = 1 << 27;
+    const int avx = 1 << 28;
+    if ((info[2] & osxsave) == 0 || (info[2] & avx) == 0 || (xgetbv0() & 0x6) != 0x6) {
+        return false;
+    }
+
+    cpuid(info, 7);
+    return (info[1] & (1 << 5)) != 0;
+}
+
+} // anonymous namespace
+
+// SSE2 has no byte shuffle, so base64 stays scalar at this level.
+void InitializeSSE2(Table& table) {
+    table.name = "SSE2";
+    table.find = Search<SSE2Bytes>::find;
+    table.findLast = Search<SSE2Bytes>::findLast;
+}
+#endif
+
+namespace {
+
+Table createTable() {
+    Table table;
+    InitializeScalar(table);
+
+#if defined(NSDATA_KERNELS_X86)
+    if (cpuHasAVX2()) {
+        InitializeAVX2(table);
+    } else if (cpuHasSSSE3()) {
+        InitializeSSE2(table);
+        InitializeSSSE3(table);
+    } else if (cpuHasSSE2()) {
+        InitializeSSE2(table);
+    }
+#endif
+
+    return table;
+}
+
+} // anonymous namespace
+
+const Table& Get() {
+    static const Table table = createTable();
+    return table;
+}
+
+size_t Base64EncodedLength(size_t length, size_t lineLength, size_t separatorLength) {
+    size_t encodedLength = (length + 2) / 3 * 4;
+    if (lineLength == 0 || encodedLength == 0) {
+        return encodedLength;
+    }
+    return encodedLength + (encodedLength - 1) / lineLength * separatorLength;
+}
+
+void Base64Encode(const uint8_t* in, size_t length, size_t lineLength, const char* separator, size_t separatorLength, char* out) {
+    const Table& kernels = Get();
+
+    // Whole lines go straight from the kernel into place; without line breaks the input is a single line
+    size_t lineBytes = lineLength == 0 ? length - length % 3 : lineLength / 4 * 3;
+    while (lineBytes != 0 && length >= lineBytes) {
+        kernels.encodeBase64(in, lineBytes, out);
+        in += lineBytes;
+        length -= lineBytes;
+        out += lineBytes / 3 * 4;
+
+        if (length != 0 && lineLength != 0) {
+            memcpy(out, separator, separatorLength);
+            out += separatorLength;
+        }
+    }
+
+    // The last line, which may end in padding
+    size_t wholeBytes = length - length % 3;
+    kernels.encodeBase64(in, wholeBytes, out);
+    in += wholeBytes;
+    out += wholeBytes / 3 * 4;
+
+    if (length % 3 != 0) {
+        uint8_t tail[3] = { in[0], length % 3 == 2 ? in[1] : (uint8_t)0, 0 };
+        char quantum[4];
+        encodeBase64Scalar(tail, 3, quantum);
+        out[0] = quantum[0];
+        out[1] = quantum[1];
+        out[2] = length % 3 == 2 ? quantum[2] : '=';
+        out[3] = '=';
+    }
+}
+
+size_t Base64DecodedMaximumLength(size_t length) {
+    return length / 4 * 3;
+}
+
+bool Base64Decode(const char* in, size_t length, bool ignoreUnknownCharacters, uint8_t* out, size_t* decodedLength) {
+    *decodedLength = 0;
+
+    // Keep only the alphabet and padding
+    std::vector<char> filtered;
+    if (ignoreUnknownCharacters) {
+        filtered.reserve(length);
+        for (size_t i = 0; i < length; i++) {
+            if (c_base64Values[(uint8_t)in[i]] != 255 || in[i] == '=') {
+                filtered.push_back(in[i]);
+            }
+        }
+        in = filtered.data();
+        length = filtered.size();
+    }
+
+    if (length % 4 != 0) {
+        return false;
+    }
+    if (length == 0) {
+        return true;
+    }
+
+    // Padding only in the last quantum, which is decoded on its own
+    size_t padding = in[length - 1] == '=' ? (in[length - 2] == '=' ? 2 : 1) : 0;
+    size_t wholeLength = length - 4;
+    if (!Get().decodeBase64(in, wholeLength, out)) {
+        return false;
+    }
+    out += wholeLength / 4 * 3;
+
+    char quantum[4] = { in[wholeLength], in[wholeLength + 1], 'A', 'A' };
+    if (padding < 2) {
+        quantum[2] = in[wholeLength + 2];
+    }
+    if (padding < 1) {
+        quantum[3] = in[wholeLength + 3];
+    }
+    uint8_t bytes[3];
+    if (!decodeBase64Scalar(quantum, 4, bytes)) {
+        return false;
+    }
+    memcpy(out, bytes, 3 - padding);
+
+    *decodedLength = wholeLength / 4 * 3 + 3 - padding;
+    return true;
+}
+
+} // namespace NSDataKernels
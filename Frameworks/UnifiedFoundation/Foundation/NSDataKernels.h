@@ -0,0 +1,74 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#pragma once
+
+// Base64 and byte search kernels used by NSData.mm.
+//
+// The table is filled once, on first use, with the widest implementation the CPU supports (AVX2, SSSE3 or SSE2, with a
+// portable scalar fallback). NSData goes through the helpers at the bottom, which handle line breaks, padding and
+// unknown characters around the table's block functions.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace NSDataKernels {
+
+static const size_t c_notFound = static_cast<size_t>(-1);
+
+struct Table {
+    const char* name;
+
+    // Encodes length bytes, a multiple of 3, into length / 3 * 4 characters.
+    void (*encodeBase64)(const uint8_t* in, size_t length, char* out);
+
+    // Decodes length characters, a multiple of 4 without padding, into length / 4 * 3 bytes. Returns false if a
+    // character is outside the base64 alphabet; out is then partly written.
+    bool (*decodeBase64)(const char* in, size_t length, uint8_t* out);
+
+    // Offset of the first or last occurrence of needle in haystack, or c_notFound. needleLength is at least 1.
+    size_t (*find)(const uint8_t* haystack, size_t haystackLength, const uint8_t* needle, size_t needleLength);
+    size_t (*findLast)(const uint8_t* haystack, size_t haystackLength, const uint8_t* needle, size_t needleLength);
+};
+
+// Returns the kernels selected for the running CPU.
+const Table& Get();
+
+// Per instruction set initializers, each defined in the translation unit compiled for that instruction set.
+void InitializeScalar(Table& table);
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+void InitializeSSE2(Table& table);
+void InitializeSSSE3(Table& table);
+void InitializeAVX2(Table& table);
+#endif
+
+// Number of characters Base64Encode writes. lineLength is 0 for a single line, or the number of characters after which
+// the separator is inserted (a multiple of 4).
+size_t Base64EncodedLength(size_t length, size_t lineLength, size_t separatorLength);
+
+// Writes Base64EncodedLength(length, lineLength, separatorLength) characters to out, with padding and without a
+// terminator.
+void Base64Encode(const uint8_t* in, size_t length, size_t lineLength, const char* separator, size_t separatorLength, char* out);
+
+// The most bytes Base64Decode can write for length characters.
+size_t Base64DecodedMaximumLength(size_t length);
+
+// Decodes padded base64 into out and sets decodedLength. Unless ignoreUnknownCharacters is set, anything outside the
+// alphabet (line breaks included) makes the input invalid; with it, such characters are skipped. Returns false for
+// invalid input.
+bool Base64Decode(const char* in, size_t length, bool ignoreUnknownCharacters, uint8_t* out, size_t* decodedLength);
+
+} // namespace NSDataKernels
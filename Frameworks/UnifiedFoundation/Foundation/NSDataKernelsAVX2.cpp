@@ -0,0 +1,146 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+// AVX2 kernels, the SSSE3 base64 steps on both 128-bit lanes at once. This file is built with AVX2 code generation
+// (/arch:AVX2) and must only be entered through the table set up by NSDataKernels::Get(), after the CPU has been checked
+// for AVX2 support.
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include <immintrin.h>
+#include "NSDataKernelsImpl.h"
+
+namespace NSDataKernels {
+namespace {
+
+// Byte shuffles work within each 128-bit lane, so their tables are repeated in both
+__m256i bothLanes(__m128i x) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(x), x, 1);
+}
+
+// 24 bytes, 12 per lane, to 32 sextets; see base64Sextets in NSDataKernelsSSSE3.cpp
+__m256i base64Sextets(__m256i in) {
+    in = _mm256_shuffle_epi8(in, bothLanes(_mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1)));
+    __m256i high = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+    __m256i low = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+    return _mm256_or_si256(high, low);
+}
+
+__m256i base64Characters(__m256i sextets) {
+    __m256i range = _mm256_subs_epu8(sextets, _mm256_set1_epi8(51));
+    __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), sextets);
+    range = _mm256_or_si256(range, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+
+    const __m256i offsets = bothLanes(_mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0));
+    return _mm256_add_epi8(sextets, _mm256_shuffle_epi8(offsets, range));
+}
+
+bool base64Values(__m256i in, __m256i* values) {
+    const __m256i lowClasses =
+        bothLanes(_mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A));
+    const __m256i highClasses =
+        bothLanes(_mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10));
+    const __m256i offsets = bothLanes(_mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0));
+
+    __m256i highNibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), _mm256_set1_epi8(0x0F));
+    __m256i lowNibbles = _mm256_and_si256(in, _mm256_set1_epi8(0x0F));
+    __m256i classes = _mm256_and_si256(_mm256_shuffle_epi8(lowClasses, lowNibbles), _mm256_shuffle_epi8(highClasses, highNibbles));
+    if (_mm256_movemask_epi8(_mm256_cmpgt_epi8(classes, _mm256_setzero_si256())) != 0) {
+        return false;
+    }
+
+    __m256i slashes = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/'));
+    *values = _mm256_add_epi8(in, _mm256_shuffle_epi8(offsets, _mm256_add_epi8(slashes, highNibbles)));
+    return true;
+}
+
+// Packs 32 sextets into 24 bytes at the start of the register
+__m256i base64Pack(__m256i values) {
+    __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    __m256i lanes = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+    lanes = _mm256_shuffle_epi8(lanes, bothLanes(_mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1)));
+    return _mm256_permutevar8x32_epi32(lanes, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+}
+
+void encodeBase64AVX2(const uint8_t* in, size_t length, char* out) {
+    // Each step reads 28 bytes (16 for each lane, overlapping) and consumes 24
+    while (length >= 28) {
+        __m256i bytes = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)in)), _mm_loadu_si128((const __m128i*)(in + 12)), 1);
+        _mm256_storeu_si256((__m256i*)out, base64Characters(base64Sextets(bytes)));
+        in += 24;
+        length -= 24;
+        out += 32;
+    }
+    encodeBase64Scalar(in, length, out);
+}
+
+bool decodeBase64AVX2(const char* in, size_t length, uint8_t* out) {
+    // Each step writes 32 bytes and produces 24, so it stops while there is still room for the extra 8
+    while (length >= 44) {
+        __m256i values;
+        if (!base64Values(_mm256_loadu_si256((const __m256i*)in), &values)) {
+            return false;
+        }
+        _mm256_storeu_si256((__m256i*)out, base64Pack(values));
+        in += 32;
+        length -= 32;
+        out += 24;
+    }
+    return decodeBase64Scalar(in, length, out);
+}
+
+struct AVX2Bytes {
+    typedef __m256i V;
+    static const size_t width = 32;
+    static V load(const uint8_t* p) {
+        return _mm256_loadu_si256((const __m256i*)p);
+    }
+    static V splat(uint8_t x) {
+        return _mm256_set1_epi8((char)x);
+    }
+    static unsigned matches(V a, V x, V b, V y) {
+        return (unsigned)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, x), _mm256_cmpeq_epi8(b, y)));
+    }
+};
+
+} // anonymous namespace
+
+void InitializeAVX2(Table& table) {
+    table.name = "AVX2";
+    table.encodeBase64 = encodeBase64AVX2;
+    table.decodeBase64 = decodeBase64AVX2;
+    table.find = Search<AVX2Bytes>::find;
+    table.findLast = Search<AVX2Bytes>::findLast;
+}
+
+} // namespace NSDataKernels
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
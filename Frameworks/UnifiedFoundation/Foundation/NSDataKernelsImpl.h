@@ -0,0 +1,204 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#pragma once
+
+// Scalar kernels, which the vector kernels also use for their tails, and the search shared by every instruction set.
+//
+// Everything here has internal linkage on purpose: the AVX2 and SSSE3 translation units are compiled for those
+// instruction sets, and sharing an inline function with the other units would let the linker pick a copy that doesn't
+// run on every CPU.
+
+#include <cstring>
+#include "NSDataKernels.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace NSDataKernels {
+namespace {
+
+const char c_base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Sextet for each character, 255 for characters outside the alphabet
+const uint8_t c_base64Values[256] = {
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 62,  255, 255, 255, 63,
+    52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  255, 255, 255, 255, 255, 255,
+    255, 0,   1,   2,   3,   4,   5,   6,   7,   8,   9,   10,  11,  12,  13,  14,
+    15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  255, 255, 255, 255, 255,
+    255, 26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,
+    41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51,  255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+};
+
+void encodeBase64Scalar(const uint8_t* in, size_t length, char* out) {
+    for (size_t i = 0; i + 3 <= length; i += 3) {
+        uint32_t bits = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+        *out++ = c_base64Alphabet[bits >> 18];
+        *out++ = c_base64Alphabet[(bits >> 12) & 0x3F];
+        *out++ = c_base64Alphabet[(bits >> 6) & 0x3F];
+        *out++ = c_base64Alphabet[bits & 0x3F];
+    }
+}
+
+bool decodeBase64Scalar(const char* in, size_t length, uint8_t* out) {
+    for (size_t i = 0; i + 4 <= length; i += 4) {
+        uint32_t a = c_base64Values[(uint8_t)in[i]];
+        uint32_t b = c_base64Values[(uint8_t)in[i + 1]];
+        uint32_t c = c_base64Values[(uint8_t)in[i + 2]];
+        uint32_t d = c_base64Values[(uint8_t)in[i + 3]];
+        if ((a | b | c | d) & 0x80) {
+            return false;
+        }
+
+        uint32_t bits = (a << 18) | (b << 12) | (c << 6) | d;
+        *out++ = (uint8_t)(bits >> 16);
+        *out++ = (uint8_t)(bits >> 8);
+        *out++ = (uint8_t)bits;
+    }
+    return true;
+}
+
+unsigned lowestBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+unsigned highestBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return index;
+#else
+    return 31 - __builtin_clz(mask);
+#endif
+}
+
+// The first and last bytes have already been compared
+bool matchesAt(const uint8_t* candidate, const uint8_t* needle, size_t needleLength) {
+    return needleLength <= 2 || memcmp(candidate + 1, needle + 1, needleLength - 2) == 0;
+}
+
+size_t findScalar(const uint8_t* haystack, size_t haystackLength, const uint8_t* needle, size_t needleLength) {
+    if (needleLength > haystackLength) {
+        return c_notFound;
+    }
+
+    const uint8_t* end = haystack + (haystackLength - needleLength) + 1;
+    for (const uint8_t* p = haystack; p < end; p++) {
+        p = (const uint8_t*)memchr(p, needle[0], end - p);
+        if (p == nullptr) {
+            break;
+        }
+        if (p[needleLength - 1] == needle[needleLength - 1] && matchesAt(p, needle, needleLength)) {
+            return p - haystack;
+        }
+    }
+    return c_notFound;
+}
+
+size_t findLastScalar(const uint8_t* haystack, size_t haystackLength, const uint8_t* needle, size_t needleLength) {
+    if (needleLength > haystackLength) {
+        return c_notFound;
+    }
+
+    for (size_t i = haystackLength - needleLength + 1; i > 0; i--) {
+        const uint8_t* p = haystack + i - 1;
+        if (p[0] == needle[0] && p[needleLength - 1] == needle[needleLength - 1] && matchesAt(p, needle, needleLength)) {
+            return i - 1;
+        }
+    }
+    return c_notFound;
+}
+
+// Compares a block of candidate positions at once: the first needle byte against the block starting at the candidate,
+// and the last needle byte against the block needleLength - 1 further on. Only positions where both match are checked
+// in full, which skips nearly every position on real data.
+//
+// An Ops type provides: typedef V, static const size_t width (at most 32), and the static functions load(const
+// uint8_t*), splat(uint8_t), and matches(a, x, b, y), a mask with bit i set where a[i] == x and b[i] == y.
+template <typename Ops>
+struct Search {
+    typedef typename Ops::V V;
+
+    static size_t find(const uint8_t* haystack, size_t haystackLength, const uint8_t* needle, size_t needleLength) {
+        if (needleLength > haystackLength) {
+            return c_notFound;
+        }
+
+        const size_t candidates = haystackLength - needleLength + 1;
+        const V first = Ops::splat(needle[0]);
+        const V last = Ops::splat(needle[needleLength - 1]);
+
+        size_t i = 0;
+        for (; i + Ops::width <= candidates; i += Ops::width) {
+            unsigned mask = Ops::matches(Ops::load(haystack + i), first, Ops::load(haystack + i + needleLength - 1), last);
+            while (mask != 0) {
+                size_t candidate = i + lowestBit(mask);
+                if (matchesAt(haystack + candidate, needle, needleLength)) {
+                    return candidate;
+                }
+                mask &= mask - 1;
+            }
+        }
+
+        size_t found = findScalar(haystack + i, haystackLength - i, needle, needleLength);
+        return found == c_notFound ? c_notFound : i + found;
+    }
+
+    static size_t findLast(const uint8_t* haystack, size_t haystackLength, const uint8_t* needle, size_t needleLength) {
+        if (needleLength > haystackLength) {
+            return c_notFound;
+        }
+
+        const V first = Ops::splat(needle[0]);
+        const V last = Ops::splat(needle[needleLength - 1]);
+
+        // Blocks of candidates [end - width, end), moving down
+        size_t end = haystackLength - needleLength + 1;
+        for (; end >= Ops::width; end -= Ops::width) {
+            size_t start = end - Ops::width;
+            unsigned mask = Ops::matches(Ops::load(haystack + start), first, Ops::load(haystack + start + needleLength - 1), last);
+            while (mask != 0) {
+                unsigned bit = highestBit(mask);
+                if (matchesAt(haystack + start + bit, needle, needleLength)) {
+                    return start + bit;
+                }
+                mask &= ~(1u << bit);
+            }
+        }
+
+        return findLastScalar(haystack, end + needleLength - 1, needle, needleLength);
+    }
+};
+
+} // anonymous namespace
+} // namespace NSDataKernels
@@ -0,0 +1,128 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+// SSSE3 base64 kernels, 12 bytes to 16 characters at a time. This file is built with SSSE3 code generation and must only
+// be entered through the table set up by NSDataKernels::Get(), after the CPU has been checked for SSSE3 support.
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("ssse3"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+#endif
+
+#include <tmmintrin.h>
+#include "NSDataKernelsImpl.h"
+
+namespace NSDataKernels {
+namespace {
+
+// Spreads 12 bytes into 16 sextets, one per byte. Each 32-bit lane takes three input bytes; the shuffle places them so
+// that two multiplies shift all four sextets of the lane into position at once.
+__m128i base64Sextets(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    __m128i high = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+    __m128i low = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(high, low);
+}
+
+// Maps sextets to characters by adding the offset of their range of the alphabet, looked up with a byte shuffle
+__m128i base64Characters(__m128i sextets) {
+    // 0..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12; then 0..25 -> 13
+    __m128i range = _mm_subs_epu8(sextets, _mm_set1_epi8(51));
+    __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), sextets);
+    range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+
+    const __m128i offsets = _mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(sextets, _mm_shuffle_epi8(offsets, range));
+}
+
+// Maps 16 characters to sextets, or returns false if any is outside the alphabet. The low and high nibble lookups give
+// each character class a bit; only valid characters have no bit in common.
+bool base64Values(__m128i in, __m128i* values) {
+    const __m128i lowClasses =
+        _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i highClasses =
+        _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i offsets = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+
+    __m128i highNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0F));
+    __m128i lowNibbles = _mm_and_si128(in, _mm_set1_epi8(0x0F));
+    __m128i classes = _mm_and_si128(_mm_shuffle_epi8(lowClasses, lowNibbles), _mm_shuffle_epi8(highClasses, highNibbles));
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(classes, _mm_setzero_si128())) != 0) {
+        return false;
+    }
+
+    // '/' shares its high nibble with '+', so it gets the offset one slot down
+    __m128i slashes = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+    *values = _mm_add_epi8(in, _mm_shuffle_epi8(offsets, _mm_add_epi8(slashes, highNibbles)));
+    return true;
+}
+
+// Packs 16 sextets into 12 bytes at the start of the register
+__m128i base64Pack(__m128i values) {
+    __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    __m128i lanes = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(lanes, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+void encodeBase64SSSE3(const uint8_t* in, size_t length, char* out) {
+    // Each step reads 16 bytes and consumes 12
+    while (length >= 16) {
+        __m128i characters = base64Characters(base64Sextets(_mm_loadu_si128((const __m128i*)in)));
+        _mm_storeu_si128((__m128i*)out, characters);
+        in += 12;
+        length -= 12;
+        out += 16;
+    }
+    encodeBase64Scalar(in, length, out);
+}
+
+bool decodeBase64SSSE3(const char* in, size_t length, uint8_t* out) {
+    // Each step writes 16 bytes and produces 12, so it stops while there is still room for the extra 4
+    while (length >= 24) {
+        __m128i values;
+        if (!base64Values(_mm_loadu_si128((const __m128i*)in), &values)) {
+            return false;
+        }
+        _mm_storeu_si128((__m128i*)out, base64Pack(values));
+        in += 16;
+        length -= 16;
+        out += 12;
+    }
+    return decodeBase64Scalar(in, length, out);
+}
+
+} // anonymous namespace
+
+void InitializeSSSE3(Table& table) {
+    table.name = "SSSE3";
+    table.encodeBase64 = encodeBase64SSSE3;
+    table.decodeBase64 = decodeBase64SSSE3;
+}
+
+} // namespace NSDataKernels
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -25,6 +25,7 @@
 #include "Foundation/NSEnumerator.h"
 #include "Foundation/NSMutableArray.h"
 #include "Foundation/NSKeyedArchiver.h"
+#include "NSPropertyListSerializationInternal.h"
 #include "LoggingNative.h"
 
 static const wchar_t* TAG = L"NSDictionary";
@@ -350,18 +351,10 @@ static int _NSDict_SortedKeysHelper(id key1, id key2, void* context) {
         return nil;
     }
 
-    const char* file = (const char*)[filename UTF8String];
-    id data = [NSData dataWithContentsOfFile:[NSString stringWithCString:file]];
-
-    NSDictionary* deserializedDict = nil;
-    if (data) {
-        deserializedDict = [NSPropertyListSerialization
-            propertyListFromData:data
-                mutabilityOption:[self isKindOfClass:[NSMutableDictionary class]] ? NSPropertyListMutableContainersAndLeaves :
-                                                                                    NSPropertyListImmutable
-                          format:0
-                errorDescription:0];
-    }
+    NSDictionary* deserializedDict = [NSPropertyListSerialization
+        _propertyListWithContentsOfFile:filename
+                       mutabilityOption:[self isKindOfClass:[NSMutableDictionary class]] ? NSPropertyListMutableContainersAndLeaves :
+                                                                                           NSPropertyListImmutable];
 
     if (deserializedDict && [deserializedDict isKindOfClass:[NSDictionary class]]) {
         //  Steal its dictionary
@@ -844,10 +837,12 @@ static int _NSDict_SortedKeysHelper(id key1, id key2, void* context) {
     NSInteger i;
 
     for (i = 0; (key = [state nextObject]) != nil; i++) {
-        id value = [self objectForKey:key];
-
-        objects[i] = value;
-        keys[i] = key;
+        if (objects) {
+            objects[i] = [self objectForKey:key];
+        }
+        if (keys) {
+            keys[i] = key;
+        }
     }
 }
 
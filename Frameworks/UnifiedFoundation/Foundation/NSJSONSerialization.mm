@@ -17,218 +17,863 @@
 #import <Foundation/Foundation.h>
 #import <Foundation/FoundationErrors.h>
 #include "Starboard.h"
-#include "StubReturn.h"
 
-#include <COMIncludes.h>
-#include <wrl\client.h>
-#include <wrl\wrappers\corewrappers.h>
-#include <windows.foundation.collections.h>
-#include <windows.data.json.h>
-#include <COMIncludes_End.h>
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
 
-#include "StringHelpers.h"
-#include "WRLHelpers.h"
+@interface NSNumber (JSONInternal)
+- (BOOL)_isBool;
+@end
 
-using namespace ABI::Windows::Foundation::Collections;
-using namespace ABI::Windows::Data::Json;
-using namespace Microsoft::WRL;
-using namespace Windows::Foundation;
+namespace {
 
-#define NSJSONTYPENAMELENGTH 20
+// Nesting deeper than this is rejected when reading; releasing a deeper object graph could exhaust the stack.
+const size_t c_maxDepth = 512;
 
-@implementation NSJSONSerialization
+// Bytes read from an NSInputStream at a time, and written to an NSOutputStream at a time.
+const size_t c_streamChunkSize = 64 * 1024;
 
-// Helper to convert between NSJSon object model and winRT object model.
-// Specifically converts between base foundation types like Dictionary/Array and
-// coverts to a Windows::Data::Json::IJsonValue object.
-ComPtr<IJsonValue> _NSJSONToWDJJsonValue(id object, BOOL isTop) {
-    ComPtr<IJsonValue> ret;
+NSError* _invalidJSONError() {
+    return [NSError errorWithDomain:NSCocoaErrorDomain
+                               code:NSPropertyListReadCorruptError
+                           userInfo:@{ NSDebugDescriptionKey : @"Invalid JSON string." }];
+}
 
-    ComPtr<IJsonValueStatics> jsonValueStatics;
-    THROW_NS_IF_FAILED(GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Data_Json_JsonValue).Get(), &jsonValueStatics));
+// Single-pass UTF-8 JSON parser that builds Foundation objects as it goes. Input may be fed in arbitrary chunks: a token
+// that is split between chunks is carried over in a small buffer, everything else is decoded straight from the chunk.
+// Containers are assembled on an explicit value stack, so nesting depth does not consume the machine stack.
+class JSONReader {
+public:
+    explicit JSONReader(NSJSONReadingOptions options)
+        : _options(options), _state(State::Value), _token(Token::None), _escape(false), _bomMatched(0), _root(nil) {
+        memset(_keyCache, 0, sizeof(_keyCache));
+    }
 
-    if ([object isKindOfClass:[NSDictionary class]]) {
-        ComPtr<IJsonObject> jsonObject;
-        THROW_NS_IF_FAILED(ActivateInstance(Wrappers::HStringReference(RuntimeClass_Windows_Data_Json_JsonObject).Get(), &jsonObject));
-        THROW_NS_IF_FAILED(jsonObject.As(&ret));
+    ~JSONReader() {
+        for (id value : _values) {
+            [value release];
+        }
+        for (KeyCacheEntry& entry : _keyCache) {
+            [entry.key release];
+        }
+        [_root release];
+    }
 
-        for (id key in(NSDictionary*)object) {
-            id value = [(NSDictionary*)object objectForKey:key];
-            ComPtr<IJsonValue> jsonValue = _NSJSONToWDJJsonValue(value, NO);
+    // Returns false once the input is known to be invalid; no more input should be fed after that.
+    bool parse(const uint8_t* bytes, size_t length) {
+        if (_state == State::Failed) {
+            return false;
+        }
 
-            auto wrlKey = Strings::NarrowToWide<HSTRING>(key);
-            THROW_NS_IF_FAILED(jsonObject->SetNamedValue(wrlKey.Get(), jsonValue.Get()));
+        size_t i = 0;
+        if (_state == State::Value && _frames.empty() && _bomMatched < 3) {
+            static const uint8_t bom[] = { 0xEF, 0xBB, 0xBF };
+            while (i < length && _bomMatched < 3 && bytes[i] == bom[_bomMatched]) {
+                i++;
+                _bomMatched++;
+            }
+            if (i < length && _bomMatched > 0 && _bomMatched < 3) {
+                return fail();
+            }
+            if (i < length) {
+                _bomMatched = 3;
+            }
+        }
+
+        if (_token != Token::None) {
+            i = continueToken(bytes, i, length);
+            if (_state == State::Failed) {
+                return false;
+            }
+        }
+
+        while (i < length) {
+            uint8_t c = bytes[i];
+            if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+                i++;
+                continue;
+            }
+
+            switch (_state) {
+                case State::Value:
+                case State::ArrayValueOrEnd:
+                    if (c == ']' && _state == State::ArrayValueOrEnd) {
+                        closeContainer();
+                        i++;
+                    } else {
+                        i = beginValue(bytes, i, length);
+                    }
+                    break;
+
+                case State::ObjectKeyOrEnd:
+                case State::ObjectKey:
+                    if (c == '}' && _state == State::ObjectKeyOrEnd) {
+                        closeContainer();
+                        i++;
+                    } else if (c == '"') {
+                        i = beginToken(Token::Key, bytes, i + 1, length);
+                    } else {
+                        return fail();
+                    }
+                    break;
+
+                case State::Colon:
+                    if (c != ':') {
+                        return fail();
+                    }
+                    _state = State::Value;
+                    i++;
+                    break;
+
+                case State::CommaOrEnd:
+                    if (c == ',') {
+                        _state = _frames.back().isObject ? State::ObjectKey : State::Value;
+                    } else if (c == (_frames.back().isObject ? '}' : ']')) {
+                        closeContainer();
+                    } else {
+                        return fail();
+                    }
+                    i++;
+                    break;
+
+                case State::Done:
+                case State::Failed:
+                    return fail();
+            }
+
+            if (_state == State::Failed) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Completes parsing at the end of the input. Returns the autoreleased top-level object, or nil with *error set.
+    id finish(NSError** error) {
+        // Numbers and literals have no terminator, so one may still be pending at the end of the input
+        if (_state != State::Failed && _token != Token::None) {
+            if (_token == Token::Number || _token == Token::Literal) {
+                completeToken(_partial.data(), _partial.size());
+            } else {
+                fail();
+            }
         }
-    } else if ([object isKindOfClass:[NSArray class]]) {
-        ComPtr<IJsonArray> array;
-        THROW_NS_IF_FAILED(ActivateInstance(Wrappers::HStringReference(RuntimeClass_Windows_Data_Json_JsonArray).Get(), &array));
-        THROW_NS_IF_FAILED(array.As(&ret));
-        for (id value in(NSArray*)object) {
-            ComPtr<IJsonValue> jsonValue = _NSJSONToWDJJsonValue(value, NO);
 
-            ComPtr<IVector<IJsonValue*>> jsonArray;
-            THROW_NS_IF_FAILED(ret.As(&jsonArray));
-            THROW_NS_IF_FAILED(jsonArray->Append(jsonValue.Get()));
+        if (_state != State::Done) {
+            *error = _invalidJSONError();
+            return nil;
         }
-    } else if ((!isTop) && [object isKindOfClass:[NSNumber class]]) {
-        if (strncmp(@encode(BOOL), [(NSNumber*)object objCType], NSJSONTYPENAMELENGTH)) {
-            // NSNumber represents a boolean
-            THROW_NS_IF_FAILED(jsonValueStatics->CreateBooleanValue([(NSNumber*)object boolValue], ret.GetAddressOf()));
+
+        if (!(_options & NSJSONReadingAllowFragments) && ![_root isKindOfClass:[NSArray class]] &&
+            ![_root isKindOfClass:[NSDictionary class]]) {
+            *error = [NSError errorWithDomain:NSCocoaErrorDomain
+                                         code:NSPropertyListReadCorruptError
+                                     userInfo:@{
+                                         NSDebugDescriptionKey :
+                                             @"JSON text did not start with array or object and option to allow fragments not set."
+                                     }];
+            return nil;
+        }
+
+        id root = _root;
+        _root = nil;
+        return [root autorelease];
+    }
+
+private:
+    enum class State { Value, ArrayValueOrEnd, ObjectKeyOrEnd, ObjectKey, Colon, CommaOrEnd, Done, Failed };
+    enum class Token { None, Key, String, Number, Literal };
+
+    struct Frame {
+        bool isObject;
+        size_t start;
+    };
+
+    // Object keys repeat heavily in API payloads; short ones are shared through a small direct-mapped cache.
+    static const size_t c_keyCacheSize = 256;
+    static const size_t c_maxCachedKeyLength = 32;
+
+    struct KeyCacheEntry {
+        uint32_t hash;
+        uint32_t length;
+        NSString* key;
+        uint8_t bytes[c_maxCachedKeyLength];
+    };
+
+    bool fail() {
+        _state = State::Failed;
+        return false;
+    }
+
+    size_t beginValue(const uint8_t* bytes, size_t i, size_t length) {
+        uint8_t c = bytes[i];
+        switch (c) {
+            case '{':
+            case '[':
+                if (_frames.size() >= c_maxDepth) {
+                    fail();
+                    return length;
+                }
+                _frames.push_back({ c == '{', _values.size() });
+                _state = (c == '{') ? State::ObjectKeyOrEnd : State::ArrayValueOrEnd;
+                return i + 1;
+
+            case '"':
+                return beginToken(Token::String, bytes, i + 1, length);
+
+            case 't':
+            case 'f':
+            case 'n':
+                return beginToken(Token::Literal, bytes, i, length);
+
+            default:
+                if (c == '-' || (c >= '0' && c <= '9')) {
+                    return beginToken(Token::Number, bytes, i, length);
+                }
+                fail();
+                return length;
+        }
+    }
+
+    size_t beginToken(Token token, const uint8_t* bytes, size_t start, size_t length) {
+        _token = token;
+        _escape = false;
+        _partial.clear();
+        return continueToken(bytes, start, length);
+    }
+
+    // Scans for the end of the current token. A complete token is decoded in place; an incomplete one is saved until
+    // the next chunk.
+    size_t continueToken(const uint8_t* bytes, size_t start, size_t length) {
+        size_t end = start;
+        bool complete = false;
+
+        if (_token == Token::Key || _token == Token::String) {
+            bool escape = _escape;
+            for (; end < length; end++) {
+                uint8_t c = bytes[end];
+                if (escape) {
+                    escape = false;
+                } else if (c == '\\') {
+                    escape = true;
+                } else if (c == '"') {
+                    complete = true;
+                    break;
+                }
+            }
+            _escape = escape;
         } else {
-            THROW_NS_IF_FAILED(jsonValueStatics->CreateNumberValue([(NSNumber*)object doubleValue], ret.GetAddressOf()));
+            for (; end < length; end++) {
+                uint8_t c = bytes[end];
+                bool inToken = (_token == Token::Number) ? ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')
+                                                         : (c >= 'a' && c <= 'z');
+                if (!inToken) {
+                    complete = true;
+                    break;
+                }
+            }
         }
-    } else if ((!isTop) && [object isKindOfClass:[NSString class]]) {
-        THROW_NS_IF_FAILED(jsonValueStatics->CreateStringValue(Strings::NarrowToWide<HSTRING>(object).Get(), ret.GetAddressOf()));
-    } else {
-        // Top level object must be one of NSDictionary or NSArray
-        if (isTop) {
-            THROW_NS_HR_MSG(E_INVALIDARG, "Invalid top-level type (%@) in JSON write", [object class]);
+
+        if (!complete) {
+            _partial.insert(_partial.end(), bytes + start, bytes + length);
+            return length;
+        }
+
+        bool quoted = (_token == Token::Key || _token == Token::String);
+
+        if (_partial.empty()) {
+            completeToken(bytes + start, end - start);
         } else {
-            THROW_NS_HR_MSG(E_INVALIDARG, "Invalid type (%@) in JSON write", [object class]);
+            _partial.insert(_partial.end(), bytes + start, bytes + end);
+            completeToken(_partial.data(), _partial.size());
         }
+
+        // Skip the closing quote of a string; numbers and literals end at the first byte that is not theirs
+        return quoted ? end + 1 : end;
     }
 
-    return ret;
-}
+    void completeToken(const uint8_t* bytes, size_t length) {
+        Token token = _token;
+        _token = Token::None;
+
+        id value = nil;
+        switch (token) {
+            case Token::Key:
+                value = decodeKey(bytes, length);
+                break;
+            case Token::String:
+                value = decodeString(bytes, length, (_options & NSJSONReadingMutableLeaves) != 0);
+                break;
+            case Token::Number:
+                value = decodeNumber(bytes, length);
+                break;
+            case Token::Literal:
+                value = decodeLiteral(bytes, length);
+                break;
+            case Token::None:
+                break;
+        }
 
-// Copies IJsonObject* (a mapping from string to WDJJsonValue*) to NSMutableDictionary
-id _WDJJsonObjectToNSJSON(const ComPtr<IJsonObject>& object, NSError** error) {
-    ComPtr<IMap<HSTRING, IJsonValue*>> map;
+        if (value == nil) {
+            fail();
+            return;
+        }
 
-    THROW_NS_IF_FAILED(object.As(&map));
-    NSMutableDictionary* ret = [NSMutableDictionary new];
+        if (token == Token::Key) {
+            _values.push_back(value);
+            _state = State::Colon;
+        } else {
+            addValue(value);
+        }
+    }
 
-    // clang-format off
-    HRESULT hr = WRLHelpers::ForEach(
-        map,
-        [&ret, &error](
-            const ComPtr<ABI::Windows::Foundation::Collections::IKeyValuePair<HSTRING, IJsonValue*>>& pair,
-            boolean* stop) {
-            
-            // Get V from KVP and then add to dictionary
-            ComPtr<IJsonValue> value;
-            RETURN_IF_FAILED(pair->get_Value(&value));
+    // Takes ownership of value
+    void addValue(id value) {
+        if (_frames.empty()) {
+            _root = value;
+            _state = State::Done;
+        } else {
+            _values.push_back(value);
+            _state = State::CommaOrEnd;
+        }
+    }
+
+    void closeContainer() {
+        Frame frame = _frames.back();
+        _frames.pop_back();
+
+        bool mutableContainers = (_options & NSJSONReadingMutableContainers) != 0;
+        id* values = _values.data() + frame.start;
+        size_t count = _values.size() - frame.start;
+        id container;
+
+        if (frame.isObject) {
+            size_t pairs = count / 2;
+            _keys.resize(pairs);
+            _objects.resize(pairs);
+            for (size_t i = 0; i < pairs; i++) {
+                _keys[i] = values[2 * i];
+                _objects[i] = values[2 * i + 1];
+            }
+
+            Class cls = mutableContainers ? [NSMutableDictionary class] : [NSDictionary class];
+            container = [[cls alloc] initWithObjectsTakeOwnership:_objects.data() forKeys:_keys.data() count:(unsigned)pairs];
+
+            // The dictionary copies its keys
+            for (size_t i = 0; i < pairs; i++) {
+                [_keys[i] release];
+            }
+        } else {
+            Class cls = mutableContainers ? [NSMutableArray class] : [NSArray class];
+            container = [[cls alloc] initWithObjectsTakeOwnership:values count:count];
+        }
 
-            Wrappers::HString key;
-            RETURN_IF_FAILED(pair->get_Key(key.GetAddressOf()));
+        _values.resize(frame.start);
+        addValue(container);
+    }
 
-            [ret setObject:_WDJJsonValueToNSJSON(value, error, YES) forKey:Strings::WideToNSString(key.Get())];
+    static uint32_t hashBytes(const uint8_t* bytes, size_t length) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
 
+    id decodeKey(const uint8_t* bytes, size_t length) {
+        if (length > c_maxCachedKeyLength) {
+            return decodeString(bytes, length, false);
+        }
 
-            if (*error != nil) {
-                ret = nil;
-                *stop = true;
+        uint32_t hash = hashBytes(bytes, length);
+        KeyCacheEntry& entry = _keyCache[hash % c_keyCacheSize];
+        if (entry.key != nil && entry.hash == hash && entry.length == length && memcmp(entry.bytes, bytes, length) == 0) {
+            return [entry.key retain];
+        }
+
+        id key = decodeString(bytes, length, false);
+        if (key != nil) {
+            [entry.key release];
+            entry.hash = hash;
+            entry.length = (uint32_t)length;
+            entry.key = [key retain];
+            memcpy(entry.bytes, bytes, length);
+        }
+        return key;
+    }
+
+    // Decodes the body of a string token (without its quotes) to UTF-16, validating escapes and UTF-8 along the way.
+    id decodeString(const uint8_t* bytes, size_t length, bool mutableLeaf) {
+        _characters.resize(length);
+        unichar* out = _characters.data();
+        const uint8_t* end = bytes + length;
+
+        while (bytes < end) {
+            uint8_t c = *bytes;
+            if (c >= 0x20 && c < 0x80 && c != '\\') {
+                *out++ = c;
+                bytes++;
+            } else if (c == '\\') {
+                if (end - bytes < 2) {
+                    return nil;
+                }
+                switch (bytes[1]) {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        *out++ = bytes[1];
+                        break;
+                    case 'b':
+                        *out++ = '\b';
+                        break;
+                    case 'f':
+                        *out++ = '\f';
+                        break;
+                    case 'n':
+                        *out++ = '\n';
+                        break;
+                    case 'r':
+                        *out++ = '\r';
+                        break;
+                    case 't':
+                        *out++ = '\t';
+                        break;
+                    case 'u': {
+                        if (end - bytes < 6) {
+                            return nil;
+                        }
+                        unichar unit = 0;
+                        for (int i = 2; i < 6; i++) {
+                            uint8_t h = bytes[i];
+                            int digit = (h >= '0' && h <= '9') ? h - '0' : (h >= 'a' && h <= 'f') ? h - 'a' + 10
+                                                                                                   : (h >= 'A' && h <= 'F') ? h - 'A' + 10 : -1;
+                            if (digit < 0) {
+                                return nil;
+                            }
+                            unit = (unit << 4) | digit;
+                        }
+                        // Surrogate pairs arrive as two escapes and are already UTF-16
+                        *out++ = unit;
+                        bytes += 4;
+                        break;
+                    }
+                    default:
+                        return nil;
+                }
+                bytes += 2;
+            } else if (c < 0x20) {
+                return nil;
+            } else {
+                uint32_t codePoint;
+                size_t extra;
+                if (c >= 0xC2 && c <= 0xDF) {
+                    codePoint = c & 0x1F;
+                    extra = 1;
+                } else if (c >= 0xE0 && c <= 0xEF) {
+                    codePoint = c & 0x0F;
+                    extra = 2;
+                } else if (c >= 0xF0 && c <= 0xF4) {
+                    codePoint = c & 0x07;
+                    extra = 3;
+                } else {
+                    return nil;
+                }
+                if ((size_t)(end - bytes) <= extra) {
+                    return nil;
+                }
+                for (size_t i = 1; i <= extra; i++) {
+                    if ((bytes[i] & 0xC0) != 0x80) {
+                        return nil;
+                    }
+                    codePoint = (codePoint << 6) | (bytes[i] & 0x3F);
+                }
+                // Reject overlong forms, UTF-16 surrogates and values past U+10FFFF
+                if ((extra == 2 && codePoint < 0x800) || (extra == 3 && (codePoint < 0x10000 || codePoint > 0x10FFFF)) ||
+                    (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+                    return nil;
+                }
+                if (codePoint >= 0x10000) {
+                    codePoint -= 0x10000;
+                    *out++ = (unichar)(0xD800 + (codePoint >> 10));
+                    *out++ = (unichar)(0xDC00 + (codePoint & 0x3FF));
+                } else {
+                    *out++ = (unichar)codePoint;
+                }
+                bytes += extra + 1;
             }
+        }
 
-            return S_OK;
-        });
-    // clang-format on
+        Class cls = mutableLeaf ? [NSMutableString class] : [NSString class];
+        return [[cls alloc] initWithCharacters:_characters.data() length:(DWORD)(out - _characters.data())];
+    }
 
-    // Written as a separate line to avoid warnings about unused returns from inner lambda macros. Not exactly sure why but
-    // this placates things.
-    THROW_NS_IF_FAILED(hr);
+    static id decodeNumber(const uint8_t* bytes, size_t length) {
+        // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+        size_t i = 0;
+        bool negative = (i < length && bytes[i] == '-');
+        if (negative) {
+            i++;
+        }
 
-    return ret;
-}
+        size_t intStart = i;
+        while (i < length && bytes[i] >= '0' && bytes[i] <= '9') {
+            i++;
+        }
+        size_t intDigits = i - intStart;
+        if (intDigits == 0 || (intDigits > 1 && bytes[intStart] == '0')) {
+            return nil;
+        }
 
-// Copies ComPtr<IJsonArray> (an array of WDJJsonValue*) to NSMutableArray
-id _WDJJsonArrayToNSJSON(const ComPtr<IJsonArray>& array, NSError** error) {
-    NSMutableArray* ret = [NSMutableArray new];
+        bool integral = true;
+        if (i < length && bytes[i] == '.') {
+            integral = false;
+            size_t fracStart = ++i;
+            while (i < length && bytes[i] >= '0' && bytes[i] <= '9') {
+                i++;
+            }
+            if (i == fracStart) {
+                return nil;
+            }
+        }
+        if (i < length && (bytes[i] == 'e' || bytes[i] == 'E')) {
+            integral = false;
+            i++;
+            if (i < length && (bytes[i] == '+' || bytes[i] == '-')) {
+                i++;
+            }
+            size_t expStart = i;
+            while (i < length && bytes[i] >= '0' && bytes[i] <= '9') {
+                i++;
+            }
+            if (i == expStart) {
+                return nil;
+            }
+        }
+        if (i != length) {
+            return nil;
+        }
 
-    ComPtr<IVector<IJsonValue*>> vector;
-    THROW_NS_IF_FAILED(array.As(&vector));
+        if (integral && intDigits <= 20) {
+            uint64_t magnitude = 0;
+            bool overflow = false;
+            for (size_t d = intStart; d < length; d++) {
+                uint64_t digit = bytes[d] - '0';
+                if (magnitude > (UINT64_MAX - digit) / 10) {
+                    overflow = true;
+                    break;
+                }
+                magnitude = magnitude * 10 + digit;
+            }
 
-    // clang-format off
-    THROW_NS_IF_FAILED(WRLHelpers::ForEach(
-        vector,
-        [&ret, &error](
-            const ComPtr<IJsonValue>& value,
-            boolean* stop) {
+            if (!overflow) {
+                if (!negative && magnitude <= (uint64_t)LLONG_MAX) {
+                    return [[NSNumber alloc] initWithLongLong:(long long)magnitude];
+                } else if (!negative) {
+                    return [[NSNumber alloc] initWithUnsignedLongLong:magnitude];
+                } else if (magnitude <= (uint64_t)LLONG_MAX + 1) {
+                    return [[NSNumber alloc] initWithLongLong:(long long)(0 - magnitude)];
+                }
+            }
+        }
 
-            [ret addObject:_WDJJsonValueToNSJSON(value, error, YES)];
-            if (*error != nil) {
-                ret = nil;
-                *stop = true;
+        char stackBuffer[64];
+        std::vector<char> heapBuffer;
+        char* text = stackBuffer;
+        if (length >= sizeof(stackBuffer)) {
+            heapBuffer.resize(length + 1);
+            text = heapBuffer.data();
+        }
+        memcpy(text, bytes, length);
+        text[length] = '\0';
+
+        return [[NSNumber alloc] initWithDouble:strtod(text, nullptr)];
+    }
+
+    static id decodeLiteral(const uint8_t* bytes, size_t length) {
+        if (length == 4 && memcmp(bytes, "true", 4) == 0) {
+            return (id)kCFBooleanTrue;
+        } else if (length == 5 && memcmp(bytes, "false", 5) == 0) {
+            return (id)kCFBooleanFalse;
+        } else if (length == 4 && memcmp(bytes, "null", 4) == 0) {
+            return [[NSNull null] retain];
+        }
+        return nil;
+    }
+
+    NSJSONReadingOptions _options;
+    State _state;
+    Token _token;
+    bool _escape;
+    int _bomMatched;
+    id _root;
+
+    std::vector<Frame> _frames;
+    std::vector<id> _values;
+    std::vector<uint8_t> _partial;
+    std::vector<unichar> _characters;
+    std::vector<id> _keys;
+    std::vector<id> _objects;
+    KeyCacheEntry _keyCache[c_keyCacheSize];
+};
+
+// Serializes Foundation objects as UTF-8 JSON into a buffer. With an output stream, the buffer is flushed to the
+// stream whenever it fills, so output of any size is written with a bounded amount of memory.
+class JSONWriter {
+public:
+    JSONWriter(NSJSONWritingOptions options, NSOutputStream* stream)
+        : _prettyPrinted((options & NSJSONWritingPrettyPrinted) != 0), _stream(stream), _written(0), _failed(false) {
+        _buffer.reserve(stream ? c_streamChunkSize : 256);
+    }
+
+    void writeTopLevel(id object) {
+        if (![object isKindOfClass:[NSDictionary class]] && ![object isKindOfClass:[NSArray class]]) {
+            THROW_NS_HR_MSG(E_INVALIDARG, "Invalid top-level type (%@) in JSON write", [object class]);
+        }
+        writeValue(object, 0);
+    }
+
+    // Writes out whatever is buffered. Returns false if the stream did not accept it.
+    bool flush() {
+        size_t offset = 0;
+        while (!_failed && offset < _buffer.size()) {
+            NSInteger count = [_stream write:_buffer.data() + offset maxLength:_buffer.size() - offset];
+            if (count <= 0) {
+                _failed = true;
+            } else {
+                offset += count;
             }
+        }
+        _written += offset;
+        _buffer.clear();
+        return !_failed;
+    }
 
-            return S_OK;
-        }));
-    // clang-format on
+    std::vector<uint8_t>& buffer() {
+        return _buffer;
+    }
 
-    return ret;
-}
+    NSInteger bytesWritten() const {
+        return _written;
+    }
+
+private:
+    void writeValue(id object, int depth) {
+        if ([object isKindOfClass:[NSString class]]) {
+            writeString(object);
+        } else if ([object isKindOfClass:[NSNumber class]]) {
+            writeNumber(object);
+        } else if ([object isKindOfClass:[NSNull class]]) {
+            append("null", 4);
+        } else if ([object isKindOfClass:[NSDictionary class]]) {
+            writeDictionary(object, depth);
+        } else if ([object isKindOfClass:[NSArray class]]) {
+            writeArray(object, depth);
+        } else {
+            THROW_NS_HR_MSG(E_INVALIDARG, "Invalid type (%@) in JSON write", [object class]);
+        }
 
-// Copies ComPtr<IJsonValue> to the appropriate foundation type
-id _WDJJsonValueToNSJSON(const ComPtr<IJsonValue>& value, NSError** error, BOOL allowFragment) {
-    JsonValueType valueType;
-    THROW_NS_IF_FAILED(value->get_ValueType(&valueType));
-
-    switch (valueType) {
-        case JsonValueType_Null:
-            return [NSNull null];
-        case JsonValueType_Boolean:
-            if (allowFragment) {
-                boolean boolValue = false;
-                THROW_NS_IF_FAILED(value->GetBoolean(&boolValue));
-                return [NSNumber numberWithBool:boolValue];
-            }
-        // drop through to error case if allowFragment is false
-        case JsonValueType_Number:
-            if (allowFragment) {
-                double doubleValue = 0;
-                THROW_NS_IF_FAILED(value->GetNumber(&doubleValue));
-                return [NSNumber numberWithDouble:doubleValue];
-            }
-        // drop through to error case if allowFragment is false
-        case JsonValueType_String:
-            if (allowFragment) {
-                Wrappers::HString string;
-                THROW_NS_IF_FAILED(value->GetString(string.GetAddressOf()));
-                return Strings::WideToNSString(string.Get());
+        if (_stream && _buffer.size() >= c_streamChunkSize) {
+            flush();
+        }
+    }
+
+    void writeDictionary(NSDictionary* dictionary, int depth) {
+        NSUInteger count = [dictionary count];
+        std::vector<id> keys(count);
+        std::vector<id> objects(count);
+        [dictionary getObjects:objects.data() andKeys:keys.data()];
+
+        append('{');
+        for (NSUInteger i = 0; i < count; i++) {
+            if (![keys[i] isKindOfClass:[NSString class]]) {
+                THROW_NS_HR_MSG(E_INVALIDARG, "Invalid key type (%@) in JSON write", [keys[i] class]);
+            }
+            if (i > 0) {
+                append(',');
+            }
+            newline(depth + 1);
+            writeString(keys[i]);
+            if (_prettyPrinted) {
+                append(" : ", 3);
             } else {
-                // error case - Fragment detected but NSJSONReadingAllowFragments option not specified.
-                *error = [NSError errorWithDomain:NSCocoaErrorDomain
-                                             code:NSPropertyListReadCorruptError
-                                         userInfo:@{
-                                             NSDebugDescriptionKey :
-                                                 @"JSON text did not start with array or object and option to allow fragments not set."
-                                         }];
+                append(':');
             }
-            break;
-        case JsonValueType_Array: {
-            // Recursively copy the contents of the array to a new NSMutableArray
-            ComPtr<IJsonArray> array;
-            THROW_NS_IF_FAILED(value->GetArray(&array));
-            return _WDJJsonArrayToNSJSON(array, error);
+            writeValue(objects[i], depth + 1);
         }
-        case JsonValueType_Object: {
-            // Recursively copy the contents of the dictionary to a new NSMutableDictionary
-            ComPtr<IJsonObject> object;
-            THROW_NS_IF_FAILED(value->GetObject(&object));
-            return _WDJJsonObjectToNSJSON(object, error);
+        newline(depth, count == 0);
+        append('}');
+    }
+
+    void writeArray(NSArray* array, int depth) {
+        append('[');
+        bool first = true;
+        for (id object in array) {
+            if (!first) {
+                append(',');
+            }
+            first = false;
+            newline(depth + 1);
+            writeValue(object, depth + 1);
         }
-        default:
-            *error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSPropertyListReadCorruptError userInfo:nil];
-            return [NSNull null];
+        newline(depth, first);
+        append(']');
     }
 
-    return [NSNull null];
-}
+    void writeString(NSString* string) {
+        NSUInteger length = [string length];
+        _characters.resize(length);
+        [string getCharacters:_characters.data() range:NSMakeRange(0, length)];
+
+        // Worst case is six bytes per UTF-16 unit (\u00XX), plus the quotes
+        size_t start = _buffer.size();
+        _buffer.resize(start + length * 6 + 2);
+        uint8_t* out = _buffer.data() + start;
+        static const char hex[] = "0123456789abcdef";
+
+        *out++ = '"';
+        for (NSUInteger i = 0; i < length; i++) {
+            unichar c = _characters[i];
+            if (c >= 0x20 && c < 0x80) {
+                if (c == '"' || c == '\\' || c == '/') {
+                    *out++ = '\\';
+                }
+                *out++ = (uint8_t)c;
+            } else if (c < 0x20) {
+                *out++ = '\\';
+                switch (c) {
+                    case '\b':
+                        *out++ = 'b';
+                        break;
+                    case '\f':
+                        *out++ = 'f';
+                        break;
+                    case '\n':
+                        *out++ = 'n';
+                        break;
+                    case '\r':
+                        *out++ = 'r';
+                        break;
+                    case '\t':
+                        *out++ = 't';
+                        break;
+                    default:
+                        *out++ = 'u';
+                        *out++ = '0';
+                        *out++ = '0';
+                        *out++ = hex[c >> 4];
+                        *out++ = hex[c & 0xF];
+                        break;
+                }
+            } else if (c < 0x800) {
+                *out++ = (uint8_t)(0xC0 | (c >> 6));
+                *out++ = (uint8_t)(0x80 | (c & 0x3F));
+            } else if (c >= 0xD800 && c <= 0xDBFF && i + 1 < length && _characters[i + 1] >= 0xDC00 && _characters[i + 1] <= 0xDFFF) {
+                uint32_t codePoint = 0x10000 + (((uint32_t)c - 0xD800) << 10) + (_characters[++i] - 0xDC00);
+                *out++ = (uint8_t)(0xF0 | (codePoint >> 18));
+                *out++ = (uint8_t)(0x80 | ((codePoint >> 12) & 0x3F));
+                *out++ = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+                *out++ = (uint8_t)(0x80 | (codePoint & 0x3F));
+            } else if (c >= 0xD800 && c <= 0xDFFF) {
+                // An unpaired surrogate has no UTF-8 form; keep it as an escape
+                *out++ = '\\';
+                *out++ = 'u';
+                *out++ = hex[c >> 12];
+                *out++ = hex[(c >> 8) & 0xF];
+                *out++ = hex[(c >> 4) & 0xF];
+                *out++ = hex[c & 0xF];
+            } else {
+                *out++ = (uint8_t)(0xE0 | (c >> 12));
+                *out++ = (uint8_t)(0x80 | ((c >> 6) & 0x3F));
+                *out++ = (uint8_t)(0x80 | (c & 0x3F));
+            }
+        }
+        *out++ = '"';
+
+        _buffer.resize(out - _buffer.data());
+    }
+
+    void writeNumber(NSNumber* number) {
+        char text[64];
+        int length = 0;
+        const char* type = [number objCType];
+
+        if ([number _isBool]) {
+            if ([number boolValue]) {
+                append("true", 4);
+            } else {
+                append("false", 5);
+            }
+            return;
+        } else if (type[0] == 'd' || type[0] == 'f') {
+            double value = [number doubleValue];
+            if (isnan(value) || isinf(value)) {
+                THROW_NS_HR_MSG(E_INVALIDARG, "Invalid number value (NaN or infinity) in JSON write");
+            }
+
+            // Use the shortest form that reads back as the same value
+            bool isFloat = (type[0] == 'f');
+            for (int precision = isFloat ? 7 : 15; precision <= 17; precision++) {
+                length = snprintf(text, sizeof(text), "%.*g", precision, value);
+                double parsed = strtod(text, nullptr);
+                if (isFloat ? ((float)parsed == (float)value) : (parsed == value)) {
+                    break;
+                }
+            }
+        } else if (isupper(type[0])) {
+            length = snprintf(text, sizeof(text), "%llu", [number unsignedLongLongValue]);
+        } else {
+            length = snprintf(text, sizeof(text), "%lld", [number longLongValue]);
+        }
+
+        append(text, length);
+    }
+
+    void newline(int depth, bool empty = false) {
+        if (_prettyPrinted) {
+            append('\n');
+            if (empty) {
+                append('\n');
+            }
+            _buffer.insert(_buffer.end(), depth * 2, ' ');
+        }
+    }
+
+    void append(char c) {
+        _buffer.push_back((uint8_t)c);
+    }
+
+    void append(const char* text, size_t length) {
+        _buffer.insert(_buffer.end(), text, text + length);
+    }
+
+    bool _prettyPrinted;
+    NSOutputStream* _stream;
+    NSInteger _written;
+    bool _failed;
+    std::vector<uint8_t> _buffer;
+    std::vector<unichar> _characters;
+};
+
+} // namespace
+
+@implementation NSJSONSerialization
 
 /**
- @Status Caveat
- @Notes Does not support NSJSONWritingPrettyPrinted
+ @Status Interoperable
 */
 + (NSData*)dataWithJSONObject:(id)obj options:(NSJSONWritingOptions)opt error:(NSError**)error {
-    NSError* internalError = nil;
-    // THROW_NS_IF_NULL(E_INVALIDARG, obj);
-
-    ComPtr<IJsonValue> jsonValue = _NSJSONToWDJJsonValue(obj, YES);
-    Wrappers::HString stringObject;
-
-    THROW_NS_IF_FAILED(jsonValue->Stringify(stringObject.GetAddressOf()));
+    JSONWriter writer(opt, nil);
+    writer.writeTopLevel(obj);
 
-    return [Strings::WideToNSString(stringObject.Get()) dataUsingEncoding:NSUTF8StringEncoding];
+    std::vector<uint8_t>& buffer = writer.buffer();
+    return [NSData dataWithBytes:buffer.data() length:buffer.size()];
 }
 
 /**
@@ -236,56 +881,75 @@ id _WDJJsonValueToNSJSON(const ComPtr<IJsonValue>& value, NSError** error, BOOL
  @Notes Only UTF8 encoding is supported
 */
 + (id)JSONObjectWithData:(NSData*)data options:(NSJSONReadingOptions)opt error:(NSError**)error {
+    THROW_NS_IF_NULL(E_INVALIDARG, data);
+
     NSError* internalError = nil;
+    JSONReader reader(opt);
+    reader.parse(static_cast<const uint8_t*>([data bytes]), [data length]);
+    id ret = reader.finish(&internalError);
 
-    THROW_NS_IF_NULL(E_INVALIDARG, data);
+    if (internalError && error) {
+        *error = internalError;
+    }
 
-    ComPtr<IJsonValueStatics> jsonValueStatics;
-    THROW_NS_IF_FAILED(GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Data_Json_JsonValue).Get(), &jsonValueStatics));
+    return ret;
+}
 
-    NSString* jsonString = [[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] autorelease];
+/**
+ @Status Caveat
+ @Notes Only UTF8 encoding is supported. The stream must already be open; it is read until it reports the end.
+*/
++ (id)JSONObjectWithStream:(NSInputStream*)stream options:(NSJSONReadingOptions)opt error:(NSError* _Nullable*)error {
+    THROW_NS_IF_NULL(E_INVALIDARG, stream);
 
-    boolean didParse = false;
-    ComPtr<IJsonValue> result;
-    THROW_NS_IF_FAILED(jsonValueStatics->TryParse(Strings::NarrowToWide<HSTRING>(jsonString).Get(), &result, &didParse));
+    NSError* internalError = nil;
+    JSONReader reader(opt);
+    std::vector<uint8_t> chunk(c_streamChunkSize);
+
+    for (;;) {
+        NSInteger count = [stream read:chunk.data() maxLength:chunk.size()];
+        if (count < 0) {
+            internalError = [NSError errorWithDomain:NSCocoaErrorDomain
+                                                code:NSFileReadUnknownError
+                                            userInfo:@{ NSDebugDescriptionKey : @"Unable to read from the stream." }];
+            break;
+        } else if (count == 0 || !reader.parse(chunk.data(), count)) {
+            break;
+        }
+    }
 
     id ret = nil;
-    if (didParse) {
-        ret = _WDJJsonValueToNSJSON(result, &internalError, (opt & NSJSONReadingAllowFragments));
-    } else {
-        internalError = [NSError errorWithDomain:NSCocoaErrorDomain
-                                            code:NSPropertyListReadCorruptError
-                                        userInfo:@{
-                                            NSDebugDescriptionKey : @"Invalid JSON string."
-                                        }];
+    if (!internalError) {
+        ret = reader.finish(&internalError);
     }
 
-    if (internalError) {
-        ret = nil;
-        if (error) {
-            *error = internalError;
-        }
+    if (internalError && error) {
+        *error = internalError;
     }
 
     return ret;
 }
 
 /**
- @Status Stub
- @Notes
-*/
-+ (id)JSONObjectWithStream:(NSInputStream*)stream options:(NSJSONReadingOptions)opt error:(NSError* _Nullable*)error {
-    UNIMPLEMENTED();
-    return StubReturn();
-}
-
-/**
- @Status Stub
- @Notes
+ @Status Interoperable
+ @Notes The stream must already be open.
 */
 + (NSInteger)writeJSONObject:(id)obj toStream:(NSOutputStream*)stream options:(NSJSONWritingOptions)opt error:(NSError* _Nullable*)error {
-    UNIMPLEMENTED();
-    return StubReturn();
+    THROW_NS_IF_NULL(E_INVALIDARG, stream);
+
+    JSONWriter writer(opt, stream);
+    writer.writeTopLevel(obj);
+
+    if (!writer.flush()) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSCocoaErrorDomain
+                                         code:NSFileWriteUnknownError
+                                     userInfo:@{ NSDebugDescriptionKey : @"Unable to write to the stream." }];
+        }
+        return 0;
+    }
+
+    return writer.bytesWritten();
 }
 
 // Returns true if the dictionary or array value is a valid JSON leaf
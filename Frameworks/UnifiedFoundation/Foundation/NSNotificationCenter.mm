@@ -17,8 +17,18 @@
 #include "Starboard.h"
 #import <Foundation/NSNotification.h>
 #import <Foundation/NSNotificationCenter.h>
+#import <Foundation/NSString.h>
 #include "LoggingNative.h"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 static const wchar_t* TAG = L"NSNotificationCenter";
 
 @interface NSNotificationReceiver : NSObject {
@@ -26,44 +36,304 @@ static const wchar_t* TAG = L"NSNotificationCenter";
     NSObject* object;
     void (^block)(NSNotification* block);
     SEL selector;
+    NSString* name;
     NSObject* notificationSender;
-    bool valid;
+    uint64_t sequence;
+    std::atomic<bool> valid;
 }
 @end
 
 @implementation NSNotificationReceiver
+- (void)dealloc {
+    // Posts that picked the receiver up before it was removed may still be running it, so the block and the placeholder
+    // observer live until the last snapshot holding the receiver goes away.
+    if (block) {
+        [block release];
+        [object release];
+    }
+    [name release];
+    [super dealloc];
+}
 @end
 
-NSNotificationCenter* defaultCenter;
+// Observers are indexed by (name, sender); a nil name or sender in a key matches any.
+struct NSNotificationObserverKey {
+    NSUInteger nameHash;
+    NSString* name;
+    id sender;
+};
 
-@implementation NSNotificationCenter {
-    NSMutableDictionary* observers;
-}
-static NSMutableArray* arrayForObservers(NSNotificationCenter* self, NSString* key, bool create = false) {
-    NSMutableArray* ret = [self->observers objectForKey:key];
-    if (ret) {
-        return ret;
+struct NSNotificationObserverKeyHash {
+    size_t operator()(const NSNotificationObserverKey& key) const {
+        return key.nameHash ^ ((uintptr_t)key.sender >> 4) * 31;
     }
+};
 
-    if (!create) {
-        return nil;
+struct NSNotificationObserverKeyEqual {
+    bool operator()(const NSNotificationObserverKey& left, const NSNotificationObserverKey& right) const {
+        return left.sender == right.sender && left.nameHash == right.nameHash &&
+               (left.name == right.name || (left.name && right.name && [left.name isEqualToString:right.name]));
     }
+};
+
+// Receivers for one key in registration order. The list owns the name its key points at.
+struct NSNotificationObserverList {
+    StrongId<NSString> name;
+    std::vector<StrongId<NSNotificationReceiver>> receivers;
+};
+
+typedef std::unordered_map<NSNotificationObserverKey,
+                           std::shared_ptr<NSNotificationObserverList>,
+                           NSNotificationObserverKeyHash,
+                           NSNotificationObserverKeyEqual>
+    NSNotificationObserverTable;
+
+// An immutable table; writers publish a modified copy. Posts take a reference for as long as they dispatch from it.
+struct NSNotificationObserverSnapshot {
+    std::atomic<size_t> references{ 1 };
+    NSNotificationObserverTable table;
+
+    void release() {
+        if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+};
+
+// Names are spread over shards so that posts of different names touch different cache lines and a change to one name
+// only copies that shard's table.
+//
+// Posts find the current snapshot without locking. A post counts itself into one of two reader counters, chosen by the
+// epoch, for just as long as it takes to load the snapshot and add a reference to it. A writer that swaps the snapshot
+// advances the epoch and waits for the counter that was current to drain before dropping its own reference, so no post
+// can be halfway through referencing a snapshot that is being freed. Dispatch itself happens outside that window, so
+// observers are free to add and remove observers.
+struct NSNotificationObserverShard {
+    std::atomic<NSNotificationObserverSnapshot*> snapshot{ nullptr };
+    std::atomic<uint32_t> epoch{ 0 };
+    std::atomic<uint32_t> readers[2];
+
+    NSNotificationObserverShard() {
+        readers[0] = 0;
+        readers[1] = 0;
+    }
+
+    ~NSNotificationObserverShard() {
+        if (NSNotificationObserverSnapshot* current = snapshot.load()) {
+            current->release();
+        }
+    }
+
+    NSNotificationObserverSnapshot* acquire() {
+        if (snapshot.load(std::memory_order_relaxed) == nullptr) {
+            return nullptr;
+        }
+
+        for (;;) {
+            uint32_t current = epoch.load();
+            readers[current & 1].fetch_add(1);
+            if (epoch.load() != current) {
+                readers[current & 1].fetch_sub(1);
+                continue;
+            }
+
+            NSNotificationObserverSnapshot* result = snapshot.load();
+            if (result) {
+                result->references.fetch_add(1, std::memory_order_relaxed);
+            }
+            readers[current & 1].fetch_sub(1);
+            return result;
+        }
+    }
+
+    // Must be called with the center's write lock held. Returns the snapshot that was replaced; releasing it can
+    // deallocate observer blocks, so callers do that after dropping the lock.
+    NSNotificationObserverSnapshot* publish(NSNotificationObserverTable&& table) {
+        NSNotificationObserverSnapshot* next = nullptr;
+        if (!table.empty()) {
+            next = new NSNotificationObserverSnapshot();
+            next->table = std::move(table);
+        }
+
+        NSNotificationObserverSnapshot* previous = snapshot.exchange(next);
+        uint32_t previousEpoch = epoch.fetch_add(1);
+        while (readers[previousEpoch & 1].load() != 0) {
+            std::this_thread::yield();
+        }
+        return previous;
+    }
+
+    // The current table, which only writers holding the center's write lock may read this way
+    NSNotificationObserverTable currentTable() const {
+        NSNotificationObserverSnapshot* current = snapshot.load();
+        return current ? current->table : NSNotificationObserverTable();
+    }
+};
+
+static const size_t c_shardCount = 16;
+
+struct NSNotificationCenterPriv {
+    // Observers registered for any name live in a shard of their own, past the named ones
+    NSNotificationObserverShard shards[c_shardCount + 1];
+
+    // Serializes changes; also guards everything below
+    std::mutex writeLock;
+    uint64_t nextSequence = 0;
+    std::unordered_map<id, std::vector<NSNotificationReceiver*>> observations;
+
+    size_t shardIndexFor(NSString* name, NSUInteger nameHash) const {
+        if (name == nil) {
+            return c_shardCount;
+        }
+        return (nameHash ^ (nameHash >> 7) ^ (nameHash >> 17)) % c_shardCount;
+    }
+
+    static void releaseSnapshots(const std::vector<NSNotificationObserverSnapshot*>& snapshots) {
+        for (NSNotificationObserverSnapshot* snapshot : snapshots) {
+            if (snapshot) {
+                snapshot->release();
+            }
+        }
+    }
+
+    void add(NSNotificationReceiver* receiver) {
+        NSNotificationObserverSnapshot* previous;
+        {
+            std::lock_guard<std::mutex> lock(writeLock);
+            receiver->sequence = nextSequence++;
+
+            NSUInteger nameHash = [receiver->name hash];
+            NSNotificationObserverShard& shard = shards[shardIndexFor(receiver->name, nameHash)];
+            NSNotificationObserverTable table = shard.currentTable();
+
+            NSNotificationObserverKey key = { nameHash, receiver->name, receiver->notificationSender };
+            auto found = table.find(key);
+            std::shared_ptr<NSNotificationObserverList> list(new NSNotificationObserverList());
+            if (found != table.end()) {
+                *list = *found->second;
+                table.erase(found);
+            } else {
+                list->name = receiver->name;
+            }
+            list->receivers.emplace_back(receiver);
+            key.name = list->name;
+            table.emplace(key, std::move(list));
+
+            previous = shard.publish(std::move(table));
+            observations[receiver->object].push_back(receiver);
+        }
+        releaseSnapshots({ previous });
+    }
+
+    void remove(id observer, NSString* name, id sender) {
+        std::vector<NSNotificationObserverSnapshot*> previous;
+        {
+            std::lock_guard<std::mutex> lock(writeLock);
+            auto found = observations.find(observer);
+            if (found == observations.end()) {
+                return;
+            }
+
+            std::vector<NSNotificationReceiver*> removed;
+            std::vector<NSNotificationReceiver*>& remaining = found->second;
+            auto firstRemoved = std::stable_partition(remaining.begin(), remaining.end(), [name, sender](NSNotificationReceiver* receiver) {
+                return (name != nil && ![name isEqualToString:receiver->name]) ||
+                       (sender != nil && receiver->notificationSender != sender);
+            });
+            removed.assign(firstRemoved, remaining.end());
+            remaining.erase(firstRemoved, remaining.end());
+            if (remaining.empty()) {
+                observations.erase(found);
+            }
+            if (removed.empty()) {
+                return;
+            }
+
+            // Posts that already hold a snapshot skip receivers that are no longer valid
+            std::vector<std::pair<size_t, NSNotificationReceiver*>> byShard;
+            for (NSNotificationReceiver* receiver : removed) {
+                receiver->valid = false;
+                byShard.emplace_back(shardIndexFor(receiver->name, [receiver->name hash]), receiver);
+            }
+            std::sort(byShard.begin(), byShard.end(), [](const std::pair<size_t, NSNotificationReceiver*>& left,
+                                                        const std::pair<size_t, NSNotificationReceiver*>& right) {
+                return left.first < right.first;
+            });
+
+            for (size_t i = 0; i < byShard.size();) {
+                size_t shardIndex = byShard[i].first;
+                NSNotificationObserverTable table = shards[shardIndex].currentTable();
+
+                // Lists are shared with older snapshots; each one touched is copied once and then edited in place
+                std::unordered_set<NSNotificationObserverList*> copied;
+                for (; i < byShard.size() && byShard[i].first == shardIndex; i++) {
+                    NSNotificationReceiver* receiver = byShard[i].second;
+                    auto list = table.find({ [receiver->name hash], receiver->name, receiver->notificationSender });
+                    if (list == table.end()) {
+                        continue;
+                    }
+
+                    if (copied.find(list->second.get()) == copied.end()) {
+                        list->second.reset(new NSNotificationObserverList(*list->second));
+                        copied.insert(list->second.get());
+                    }
+
+                    auto& receivers = list->second->receivers;
+                    receivers.erase(std::remove(receivers.begin(), receivers.end(), receiver), receivers.end());
+                    if (receivers.empty()) {
+                        copied.erase(list->second.get());
+                        table.erase(list);
+                    }
+                }
+
+                previous.push_back(shards[shardIndex].publish(std::move(table)));
+            }
+        }
+        releaseSnapshots(previous);
+    }
+};
+
+// Calls the receivers of up to four lists in registration order, merging on the sequence numbers they were added with
+static void _dispatchInRegistrationOrder(const NSNotificationObserverList** lists, size_t listCount, NSNotification* notification) {
+    size_t positions[4] = { 0, 0, 0, 0 };
+    for (;;) {
+        NSNotificationReceiver* next = nil;
+        size_t nextList = 0;
+        for (size_t i = 0; i < listCount; i++) {
+            if (positions[i] < lists[i]->receivers.size()) {
+                NSNotificationReceiver* candidate = lists[i]->receivers[positions[i]];
+                if (next == nil || candidate->sequence < next->sequence) {
+                    next = candidate;
+                    nextList = i;
+                }
+            }
+        }
+        if (next == nil) {
+            return;
+        }
+        positions[nextList]++;
+
+        if (!next->valid) {
+            continue;
+        }
 
-    ret = [NSMutableArray new];
-    [self->observers setObject:ret forKey:key];
-    [ret release];
+        if (!next->block) {
+            [next->object performSelector:next->selector withObject:notification];
+        } else {
+            next->block(notification);
+        }
+    }
+}
 
-    return ret;
+@implementation NSNotificationCenter {
+    NSNotificationCenterPriv* priv;
 }
 
 /**
  @Status Interoperable
 */
 + (NSNotificationCenter*)defaultCenter {
-    if (defaultCenter == nil) {
-        defaultCenter = [NSNotificationCenter new];
-    }
-
+    static NSNotificationCenter* defaultCenter = [NSNotificationCenter new];
     return defaultCenter;
 }
 
@@ -71,10 +341,17 @@ static NSMutableArray* arrayForObservers(NSNotificationCenter* self, NSString* k
  @Status Interoperable
 */
 - (instancetype)init {
-    observers = [[NSMutableDictionary alloc] init];
+    if (self = [super init]) {
+        priv = new NSNotificationCenterPriv();
+    }
     return self;
 }
 
+- (void)dealloc {
+    delete priv;
+    [super dealloc];
+}
+
 /**
  @Status Interoperable
 */
@@ -88,45 +365,42 @@ static NSMutableArray* arrayForObservers(NSNotificationCenter* self, NSString* k
 */
 - (void)postNotification:(NSNotification*)notification {
     NSString* name = [notification name];
+    NSObject* sender = [notification object];
+    NSUInteger nameHash = [name hash];
 
-    NSArray* arr = arrayForObservers(self, name);
-    if (arr == nil) {
-        return;
-    }
+    NSNotificationObserverSnapshot* named = name ? priv->shards[priv->shardIndexFor(name, nameHash)].acquire() : nullptr;
+    NSNotificationObserverSnapshot* anyName = priv->shards[c_shardCount].acquire();
 
-    NSObject* sender = [notification object];
-    int count = CFArrayGetCount((CFArrayRef)arr);
-    unsigned int numSendTo = 0;
-    id* sendTo = (id*)IwMalloc(count * sizeof(id));
-    for (unsigned int i = 0; i < count; i++) {
-        NSNotificationReceiver* observer = (NSNotificationReceiver*)CFArrayGetValueAtIndex((CFArrayRef)arr, i);
-        if (!observer->valid) {
-            continue;
-        }
-        if (observer->notificationSender != NULL && observer->notificationSender != sender) {
-            continue;
+    const NSNotificationObserverList* lists[4];
+    size_t listCount = 0;
+    auto collect = [&lists, &listCount](NSNotificationObserverSnapshot* snapshot, const NSNotificationObserverKey& key) {
+        auto found = snapshot->table.find(key);
+        if (found != snapshot->table.end()) {
+            lists[listCount++] = found->second.get();
         }
+    };
 
-        sendTo[numSendTo] = observer;
-        [sendTo[numSendTo++] retain];
+    if (named) {
+        collect(named, { nameHash, name, nil });
+        if (sender) {
+            collect(named, { nameHash, name, sender });
+        }
     }
-
-    for (unsigned int i = 0; i < numSendTo; i++) {
-        NSNotificationReceiver* observer = sendTo[i];
-
-        if (!observer->valid) {
-            [observer release];
-            continue;
+    if (anyName) {
+        collect(anyName, { 0, nil, nil });
+        if (sender) {
+            collect(anyName, { 0, nil, sender });
         }
+    }
 
-        if (!observer->block) {
-            [observer->object performSelector:observer->selector withObject:notification];
-        } else {
-            observer->block(notification);
-        }
-        [observer release];
+    _dispatchInRegistrationOrder(lists, listCount, notification);
+
+    if (named) {
+        named->release();
+    }
+    if (anyName) {
+        anyName->release();
     }
-    IwFree(sendTo);
 }
 
 /**
@@ -142,18 +416,15 @@ static NSMutableArray* arrayForObservers(NSNotificationCenter* self, NSString* k
  @Status Interoperable
 */
 - (void)addObserver:(id)observer selector:(SEL)selName name:(NSString*)name object:(id)object {
-    if (name == nil) {
-        return;
-    }
-
     NSNotificationReceiver* newObserver = [NSNotificationReceiver new];
 
     newObserver->object = observer;
     newObserver->selector = selName;
+    newObserver->name = [name copy];
     newObserver->notificationSender = object;
     newObserver->valid = true;
 
-    [arrayForObservers(self, name, true) addObject:newObserver];
+    priv->add(newObserver);
     [newObserver release];
 }
 
@@ -176,64 +447,28 @@ static NSMutableArray* arrayForObservers(NSNotificationCenter* self, NSString* k
     newObserver->object = [NSObject new]; //  Placeholder object for observer
     newObserver->block = [block copy];
     newObserver->selector = NULL;
+    newObserver->name = [name copy];
     newObserver->notificationSender = object;
     newObserver->valid = true;
 
-    [arrayForObservers(self, name, true) addObject:newObserver];
+    id<NSObject> placeholder = newObserver->object;
+    priv->add(newObserver);
     [newObserver release];
 
-    return newObserver->object;
+    return placeholder;
 }
 
 /**
  @Status Interoperable
 */
 - (void)removeObserver:(id)observer name:(NSString*)name object:(id)object {
-    id arr = arrayForObservers(self, name);
-    if (arr == nil) {
-        return;
-    }
-
-    int numItems = CFArrayGetCount((CFArrayRef)arr);
-
-    for (int i = numItems - 1; i >= 0; i--) {
-        NSNotificationReceiver* curObserver = (NSNotificationReceiver*)CFArrayGetValueAtIndex((CFArrayRef)arr, i);
-
-        if (!curObserver->valid) {
-            continue;
-        }
-        if (curObserver->object != observer) {
-            continue;
-        }
-        if (object != nil && curObserver->notificationSender != object) {
-            continue;
-        }
-
-        curObserver->valid = false;
-        if (curObserver->block) {
-            [curObserver->block release];
-            [curObserver->object release];
-            curObserver->block = nil;
-            curObserver->object = nil;
-        }
-
-        // Remove the object *after* freeing its block and object
-        CFArrayRemoveValueAtIndex((CFArrayRef)arr, i);
-    }
-
-    if (CFArrayGetCount((CFArrayRef)arr) == 0) {
-        [observers setObject:nil forKey:name];
-    }
+    priv->remove(observer, name, object);
 }
 
 /**
  @Status Interoperable
 */
 - (void)removeObserver:(id)observer {
-    NSArray* copiedAllKeys = [[observers allKeys] copy];
-    for (NSString* curName in copiedAllKeys) {
-        [self removeObserver:observer name:curName object:nil];
-    }
-    [copiedAllKeys release];
+    priv->remove(observer, nil, nil);
 }
 @end
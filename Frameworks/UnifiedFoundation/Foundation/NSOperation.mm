@@ -22,6 +22,7 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #include "Foundation/NSOperation.h"
 #include "Foundation/NSString.h"
 #include "Foundation/NSMutableArray.h"
+#include "NSOperationInternal.h"
 #include "LoggingNative.h"
 
 static const wchar_t* TAG = L"NSOperation";
@@ -29,6 +30,8 @@ static const wchar_t* TAG = L"NSOperation";
 #if __cplusplus
 #include <pthread.h>
 #include <string.h>
+#include <atomic>
+#include <vector>
 struct NSOperationPriv {
     NSOperationQueuePriority priority;
     id dependencies;
@@ -41,8 +44,22 @@ struct NSOperationPriv {
     int cancelled : 1;
     int finished : 1;
 
-    NSOperationPriv() {
-        memset(this, 0, sizeof(NSOperationPriv));
+    // Dependency graph, built when the operation is handed to a queue. dependents are the operations waiting on this
+    // one and are released once it finishes. pendingDependencies counts the unfinished dependencies, plus one while
+    // _whenReady: is still registering, and readyHandler is taken by whoever brings it to zero (or by cancel).
+    std::vector<StrongId<NSOperation>> dependents;
+    std::atomic<int> pendingDependencies;
+    void (^readyHandler)(void);
+
+    NSOperationPriv()
+        : priority(NSOperationQueuePriorityNormal),
+          dependencies(nil),
+          completionBlock(nil),
+          executing(0),
+          cancelled(0),
+          finished(0),
+          pendingDependencies(0),
+          readyHandler(nil) {
         pthread_cond_init(&finishCondition, 0);
 
         pthread_mutexattr_t attr;
@@ -65,6 +82,10 @@ struct NSOperationPriv;
 @interface NSOperation () {
     struct NSOperationPriv* priv;
 }
+- (BOOL)_addDependent:(NSOperation*)dependent;
+- (BOOL)_removeDependent:(NSOperation*)dependent;
+- (void)_dependencyFinished;
+- (void)_becomeReady;
 @end
 
 @implementation NSOperation
@@ -99,10 +120,12 @@ struct NSOperationPriv;
  @Status Interoperable
 */
 - (void)addDependency:(id)operation {
+    pthread_mutex_lock(&priv->finishLock);
     if (priv->dependencies == nil) {
         priv->dependencies = [[NSMutableArray alloc] init];
     }
     [priv->dependencies addObject:operation];
+    pthread_mutex_unlock(&priv->finishLock);
 }
 
 /**
@@ -147,7 +170,6 @@ struct NSOperationPriv;
  @Status Interoperable
 */
 - (BOOL)isReady {
-    //  Note, check dependencies when we get them
     int count = [priv->dependencies count];
 
     for (int i = 0; i < count; i++) {
@@ -238,8 +260,10 @@ struct NSOperationPriv;
         block();
     }
 
+    std::vector<StrongId<NSOperation>> dependents;
     if (newValue == 1) {
         pthread_cond_broadcast(&priv->finishCondition);
+        dependents.swap(priv->dependents);
     }
 
     pthread_mutex_unlock(&priv->finishLock);
@@ -252,6 +276,85 @@ struct NSOperationPriv;
         [priv->completionBlock release];
         priv->completionBlock = nil;
     }
+
+    // Dependents are released after the completion block so that work done there is visible to them.
+    for (auto& dependent : dependents) {
+        [dependent _dependencyFinished];
+    }
+}
+
+// Registers dependent to be told when this operation finishes. Returns NO if it already has, in which case there is
+// nothing to wait for.
+- (BOOL)_addDependent:(NSOperation*)dependent {
+    BOOL added = NO;
+
+    pthread_mutex_lock(&priv->finishLock);
+    if (!priv->finished) {
+        priv->dependents.emplace_back(dependent);
+        added = YES;
+    }
+    pthread_mutex_unlock(&priv->finishLock);
+
+    return added;
+}
+
+// Undoes _addDependent:. Returns YES if dependent was still waiting on this operation.
+- (BOOL)_removeDependent:(NSOperation*)dependent {
+    BOOL removed = NO;
+
+    pthread_mutex_lock(&priv->finishLock);
+    for (auto it = priv->dependents.begin(); it != priv->dependents.end(); ++it) {
+        if (*it == dependent) {
+            priv->dependents.erase(it);
+            removed = YES;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&priv->finishLock);
+
+    return removed;
+}
+
+- (void)_dependencyFinished {
+    if (priv->pendingDependencies.fetch_sub(1) == 1) {
+        [self _becomeReady];
+    }
+}
+
+- (void)_becomeReady {
+    pthread_mutex_lock(&priv->finishLock);
+    void (^handler)(void) = priv->readyHandler;
+    priv->readyHandler = nil;
+    pthread_mutex_unlock(&priv->finishLock);
+
+    if (handler) {
+        handler();
+        [handler release];
+    }
+}
+
+- (void)_whenReady:(void (^)(void))handler {
+    pthread_mutex_lock(&priv->finishLock);
+    assert(priv->readyHandler == nil);
+    priv->readyHandler = [handler copy];
+    priv->pendingDependencies = 1;
+    NSArray* dependencies = [[priv->dependencies copy] autorelease];
+    pthread_mutex_unlock(&priv->finishLock);
+
+    // Count the dependency before registering with it: once registered it may finish and call _dependencyFinished at
+    // any time, and that must never see the count short of the dependencies still to come.
+    for (NSOperation* dependency in dependencies) {
+        ++priv->pendingDependencies;
+        if (![dependency _addDependent:self]) {
+            [self _dependencyFinished];
+        }
+    }
+
+    if (priv->cancelled) {
+        [self _becomeReady];
+    }
+
+    [self _dependencyFinished];
 }
 
 /**
@@ -264,6 +367,9 @@ struct NSOperationPriv;
         priv->cancelled = 1;
         [self didChangeValueForKey:@"isCancelled"];
         pthread_mutex_unlock(&priv->finishLock);
+
+        // A cancelled operation no longer waits for its dependencies; if it is queued, let the queue finish it now.
+        [self _becomeReady];
     }
 }
 
@@ -278,7 +384,7 @@ struct NSOperationPriv;
 */
 - (void)waitUntilFinished {
     pthread_mutex_lock(&priv->finishLock);
-    if (![self isFinished]) {
+    while (![self isFinished]) {
         pthread_cond_wait(&priv->finishCondition, &priv->finishLock);
     }
     pthread_mutex_unlock(&priv->finishLock);
@@ -296,16 +402,26 @@ struct NSOperationPriv;
 */
 - (void)dealloc {
     assert(!priv->completionBlock);
+    [priv->dependencies release];
+    [priv->readyHandler release];
     delete priv;
     [super dealloc];
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 - (void)removeDependency:(NSOperation*)operation {
-    UNIMPLEMENTED();
+    [[operation retain] autorelease];
+
+    pthread_mutex_lock(&priv->finishLock);
+    [priv->dependencies removeObject:operation];
+    pthread_mutex_unlock(&priv->finishLock);
+
+    // If this operation is queued and was still waiting on operation, stop waiting.
+    if ([operation _removeDependent:self]) {
+        [self _dependencyFinished];
+    }
 }
 
 @end
@@ -19,281 +19,357 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 
 #include "Starboard.h"
 #include "Foundation/NSOperation.h"
+#include "Foundation/NSBlockOperation.h"
 #include "Foundation/NSMutableArray.h"
-#include "Platform/EbrPlatform.h"
 #include "Foundation/NSString.h"
+#include "Foundation/NSNumber.h"
 #include "Foundation/NSOperationQueue.h"
 #include "Foundation/NSThread.h"
 #include "Foundation/NSAutoreleasePool.h"
-#include "Foundation/NSLock.h"
+#include "NSOperationInternal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// An operation that is ready to run, tagged with the order it was added to the queue.
+struct NSOperationJob {
+    StrongId<NSOperation> operation;
+    uint64_t sequence;
+};
 
-#include <time.h>
-#include "LoggingNative.h"
+// Each worker owns a deque of ready operations per priority. A worker takes from the front of its own deques, in the
+// order the operations became ready, and steals from the back of the others' when it runs dry. Operations released by
+// a finishing dependency are pushed to the worker that finished it, so fan-out work stays local until someone steals it.
+// The deques belong to the queue rather than the thread: a worker slot can be idle while its deque still holds work.
+struct NSOperationWorker {
+    std::mutex lock;
+    std::deque<NSOperationJob> jobs[NSOperationQueuePriority_Count];
 
-static const wchar_t* TAG = L"NSOperationQueue";
+    // Guarded by the queue lock.
+    bool running = false;
+};
 
-typedef void* gpointer;
+static const unsigned c_maxWorkers = 64;
 
-struct NSAtomicListNode {
-    struct NSAtomicListNode* next;
-    StrongId<NSObject> elt;
-};
-typedef struct NSAtomicListNode* NSAtomicListRef;
+// How long a worker with nothing to do stays parked before its thread exits.
+static const std::chrono::milliseconds c_workerIdleTimeout(250);
 
 struct NSOperationQueuePriv {
-    NSAtomicListRef myQueues[NSOperationQueuePriority_Count];
-
-    id _thread;
-    EbrLock _threadRunningLock;
+    // Guards everything below except the worker deques and the atomics.
+    std::mutex lock;
+    std::condition_variable workAvailable;
+    std::condition_variable allWorkDone;
+
+    // Slots are created up to the concurrency limit and never destroyed, so they can be read without the lock below
+    // workerCount.
+    std::unique_ptr<NSOperationWorker> workers[c_maxWorkers];
+    std::atomic<unsigned> workerCount{ 0 };
+    std::atomic<unsigned> nextWorker{ 0 };
+
+    // Jobs sitting in worker deques. Only incremented under the lock, so a worker that checks it before parking cannot
+    // miss a wakeup. The worker locks nest inside the queue lock, never the other way around.
+    std::atomic<size_t> readyCount{ 0 };
+    unsigned runningWorkers = 0;
+    unsigned parkedWorkers = 0;
+    // Wakeups handed to parked workers and not yet consumed, so that each new job wakes a different worker.
+    unsigned wakeups = 0;
+
+    // Every operation added and not yet finished, in the order added. This backs operations and operationCount, and
+    // waitUntilAllOperationsAreFinished waits for it to drain.
+    std::map<uint64_t, StrongId<NSOperation>> pending;
+    uint64_t nextSequence = 0;
+
+    NSInteger maxConcurrentOperationCount = NSOperationQueueDefaultMaxConcurrentOperationCount;
+    std::atomic<bool> isSuspended{ false };
+    bool isMainQueue = false;
+    id _name = nil;
+};
 
-    DWORD _maxConcurrentOperationCount;
-    id workAvailable;
-    id suspendedCondition;
-    id allWorkDone;
-    id curOperation;
-    BOOL isSuspended;
+// The queue and worker slot the current thread is working for, if any.
+thread_local static NSOperationQueue* s_currentQueue = nil;
+thread_local static unsigned s_currentWorker = 0;
 
-    void* queues[NSOperationQueuePriority_Count];
-    id _name;
+static id _mainQueue;
 
-    NSOperationQueuePriv() {
-        memset(this, 0, sizeof(NSOperationQueuePriv));
+static unsigned _priorityIndex(NSOperation* op) {
+    NSOperationQueuePriority priority = [op queuePriority];
+    if (priority > NSOperationQueuePriorityNormal) {
+        return 0;
+    } else if (priority < NSOperationQueuePriorityNormal) {
+        return 2;
     }
-};
-
-extern pthread_key_t g_currentDispatchQueue;
-
-static inline gpointer CompareExchangePointer(volatile gpointer* dest, gpointer exch, gpointer comp) {
-    return (gpointer)EbrCompareExchange((volatile int*)dest, (long)exch, (long)comp);
+    return 1;
 }
 
-NSAtomicListRef NSAtomicListSteal(NSAtomicListRef* listPtr) {
-    NSAtomicListRef ret;
-    do {
-        ret = *listPtr;
-    } while (CompareExchangePointer((void**)listPtr, NULL, ret) != ret);
-    return ret;
-}
+static unsigned _workerLimit(const NSOperationQueuePriv* priv) {
+    if (priv->isMainQueue) {
+        return 0;
+    }
 
-void NSAtomicListReverse(NSAtomicListRef* listPtr) {
-    struct NSAtomicListNode* cur = *listPtr;
-    struct NSAtomicListNode* prev = NULL;
-    struct NSAtomicListNode* next = NULL;
+    NSInteger limit = priv->maxConcurrentOperationCount;
+    if (limit == NSOperationQueueDefaultMaxConcurrentOperationCount) {
+        limit = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return static_cast<unsigned>(std::min<NSInteger>(std::max<NSInteger>(limit, 0), c_maxWorkers));
+}
 
-    if (!cur) {
+// Makes sure there are at least count worker slots (and always one, for the main queue and for a limit of zero to
+// queue into). Called with the queue lock held.
+static void _createWorkers(NSOperationQueuePriv* priv, unsigned count) {
+    count = std::max(count, 1u);
+    unsigned existing = priv->workerCount.load(std::memory_order_relaxed);
+    if (count <= existing) {
         return;
     }
 
-    do {
-        next = cur->next;
-        cur->next = prev;
-
-        if (next) {
-            prev = cur;
-            cur = next;
-        }
-    } while (next);
-
-    *listPtr = cur;
+    for (unsigned i = existing; i < count; i++) {
+        priv->workers[i].reset(new NSOperationWorker());
+    }
+    priv->workerCount.store(count, std::memory_order_release);
 }
 
-NSObject* NSAtomicListPop(NSAtomicListRef* listPtr) {
-    struct NSAtomicListNode* node = *listPtr;
-    if (!node) {
-        return NULL;
+// Wakes or starts enough workers to pick up newly ready jobs. The slots of any workers that need a thread are
+// appended to toStart, to be started once the lock is dropped. Called with the queue lock held.
+static void _scheduleWorkers(NSOperationQueuePriv* priv, size_t jobs, std::vector<unsigned>& toStart) {
+    if (priv->isSuspended) {
+        return;
     }
 
-    *listPtr = node->next;
-
-    NSObject* elt = [[node->elt retain] autorelease];
-    delete node;
-    return elt;
+    unsigned limit = _workerLimit(priv);
+    unsigned count = priv->workerCount.load(std::memory_order_relaxed);
+    for (; jobs > 0; jobs--) {
+        if (priv->parkedWorkers > priv->wakeups) {
+            priv->wakeups++;
+            priv->workAvailable.notify_one();
+        } else if (priv->runningWorkers < limit) {
+            for (unsigned i = 0; i < count; i++) {
+                if (!priv->workers[i]->running) {
+                    priv->workers[i]->running = true;
+                    priv->runningWorkers++;
+                    toStart.push_back(i);
+                    break;
+                }
+            }
+        } else {
+            break;
+        }
+    }
 }
 
-NSObject* NSAtomicListPeek(NSAtomicListRef* listPtr) {
-    struct NSAtomicListNode* node = *listPtr;
-    if (!node) {
-        return NULL;
+static bool _popJob(NSOperationWorker* worker, bool steal, NSOperationJob& job) {
+    std::lock_guard<std::mutex> lock(worker->lock);
+    for (auto& jobs : worker->jobs) {
+        if (!jobs.empty()) {
+            if (steal) {
+                job = std::move(jobs.back());
+                jobs.pop_back();
+            } else {
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            return true;
+        }
     }
-
-    return node->elt;
+    return false;
 }
 
-void NSAtomicListInsert(NSAtomicListRef* listPtr, NSObject* elt) {
-    struct NSAtomicListNode* node = new NSAtomicListNode();
-    node->elt = elt;
+// Takes the next job for the worker in slot index: its own work first, then work stolen from the other slots.
+// Priorities are only honoured within a deque; a worker finishes its own low priority work before stealing.
+static bool _takeJob(NSOperationQueuePriv* priv, unsigned index, NSOperationJob& job) {
+    if (priv->isSuspended || priv->readyCount.load() == 0) {
+        return false;
+    }
 
-    do {
-        node->next = *listPtr;
-    } while (CompareExchangePointer((void**)listPtr, node, node->next) != node->next);
+    unsigned count = priv->workerCount.load(std::memory_order_acquire);
+    for (unsigned i = 0; i < count; i++) {
+        if (_popJob(priv->workers[(index + i) % count].get(), i != 0, job)) {
+            priv->readyCount--;
+            return true;
+        }
+    }
+    return false;
 }
 
-static id _mainQueue;
-
 @interface NSOperationQueue () {
     struct NSOperationQueuePriv* priv;
 }
 @end
 
 @implementation NSOperationQueue
-static void ClearList(NSAtomicListRef* listPtr) {
-    for (int i = 0; i < NSOperationQueuePriority_Count; i++) {
-        while (NSAtomicListPop(&listPtr[i])) {
-            ;
-        }
+
+- (void)_startWorkers:(const std::vector<unsigned>&)slots {
+    for (unsigned slot : slots) {
+        NSThread* thread = [[NSThread alloc] initWithTarget:self
+                                                   selector:@selector(_workThread:)
+                                                     object:[NSNumber numberWithUnsignedInt:slot]];
+        [thread start];
+        [thread release];
     }
 }
 
-static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sourceListPtr, id* curOperation) {
-    StrongId<NSObject> op = NSAtomicListPop(listPtr);
-    if (op == nil) {
-        *listPtr = NSAtomicListSteal(sourceListPtr);
-        // source lists are in LIFO order, but we want to execute operations in the order they were enqueued
-        // so we reverse the list before we do anything with it
-        NSAtomicListReverse(listPtr);
-        op = NSAtomicListPop(listPtr);
-    }
+- (void)_enqueueOperation:(NSOperation*)op sequence:(uint64_t)sequence {
+    NSOperationJob job{ op, sequence };
+    unsigned count = priv->workerCount.load(std::memory_order_acquire);
+    unsigned slot = (s_currentQueue == self) ? s_currentWorker : (priv->nextWorker++ % count);
 
-    if (op != nil) {
-        if ([op isReady]) {
-            *curOperation = op;
-            [op start];
-            *curOperation = nil;
-        } else {
-            NSAtomicListInsert(sourceListPtr, op);
-            return FALSE;
+    NSOperationWorker* worker = priv->workers[slot].get();
+    unsigned priority = _priorityIndex(op);
+
+    std::vector<unsigned> toStart;
+    {
+        // The count goes up before the push so that it never drops below the number of queued jobs.
+        std::lock_guard<std::mutex> lock(priv->lock);
+        priv->readyCount++;
+        {
+            std::lock_guard<std::mutex> workerLock(worker->lock);
+            worker->jobs[priority].emplace_back(std::move(job));
         }
+        _scheduleWorkers(priv, 1, toStart);
     }
+    [self _startWorkers:toStart];
 
-    return op != nil;
+    if (priv->isMainQueue) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self _doMainWork];
+        });
+    }
 }
 
-- (id)_workThread {
-    BOOL stop = FALSE;
+// Runs job and retires it. Returns NO if the worker in slot index should exit because the concurrency limit has
+// dropped below the number of running workers.
+- (BOOL)_runJob:(NSOperationJob&)job worker:(unsigned)index {
+    NSAutoreleasePool* pool = [NSAutoreleasePool new];
+    [job.operation start];
+    [pool release];
 
-    while (!stop) {
-        [self _doMainWork];
-        EbrLockEnter(priv->_threadRunningLock);
-        if (![self hasMoreWork]) {
-            stop = TRUE;
-            priv->_thread = nil;
-        }
-        EbrLockLeave(priv->_threadRunningLock);
+    StrongId<NSOperation> finished;
+    job.operation = nil;
+
+    std::lock_guard<std::mutex> lock(priv->lock);
+    auto it = priv->pending.find(job.sequence);
+    if (it != priv->pending.end()) {
+        finished = std::move(it->second);
+        priv->pending.erase(it);
+    }
+    if (priv->pending.empty()) {
+        priv->allWorkDone.notify_all();
     }
-    [priv->allWorkDone signal];
 
-    return self;
+    if (!priv->isMainQueue && priv->runningWorkers > _workerLimit(priv)) {
+        priv->workers[index]->running = false;
+        priv->runningWorkers--;
+        return NO;
+    }
+    return YES;
 }
 
-- (id)_doMainWork {
-    memset(priv->myQueues, 0, sizeof(priv->myQueues));
+- (void)_workThread:(NSNumber*)slot {
+    unsigned index = [slot unsignedIntValue];
+    s_currentQueue = self;
+    s_currentWorker = index;
 
-    BOOL didWork;
+    NSOperationJob job;
+    for (;;) {
+        if (_takeJob(priv, index, job)) {
+            if (![self _runJob:job worker:index]) {
+                break;
+            }
+            continue;
+        }
 
-    id innerPool = [[NSAutoreleasePool alloc] init];
+        std::unique_lock<std::mutex> lock(priv->lock);
+        if (priv->readyCount > 0 && !priv->isSuspended) {
+            continue;
+        }
 
-    do {
-        didWork = FALSE;
+        bool woken = false;
+        if (priv->runningWorkers <= _workerLimit(priv)) {
+            priv->parkedWorkers++;
+            woken = priv->workAvailable.wait_for(lock, c_workerIdleTimeout, [self] { return priv->wakeups > 0; });
+            priv->parkedWorkers--;
+        }
 
-        for (int i = 0; i < NSOperationQueuePriority_Count; i++) {
-            if (RunOperationFromLists(&priv->myQueues[i], (NSAtomicListRef*)(&priv->queues[i]), &priv->curOperation)) {
-                didWork = TRUE;
-            }
+        if (woken) {
+            priv->wakeups--;
+            continue;
         }
-    } while (didWork);
 
-    [innerPool release];
+        priv->workers[index]->running = false;
+        priv->runningWorkers--;
+        break;
+    }
 
-    return self;
+    s_currentQueue = nil;
 }
 
-/**
- @Status Interoperable
-*/
-- (BOOL)hasMoreWork {
-    if (priv->curOperation != nil) {
-        return TRUE;
-    }
-
-    for (int i = 0; i < NSOperationQueuePriority_Count; i++) {
-        if (priv->queues[i] != NULL) {
-            return TRUE;
-        }
+// The main queue has no workers of its own: its operations run on the main thread, from the main dispatch queue and
+// from the run loop.
+- (id)_doMainWork {
+    NSOperationJob job;
+    while (_takeJob(priv, 0, job)) {
+        [self _runJob:job worker:0];
     }
 
-    return FALSE;
+    return self;
 }
 
 /**
  @Status Interoperable
 */
 - (id)init {
-    priv = new NSOperationQueuePriv();
+    if (self = [super init]) {
+        priv = new NSOperationQueuePriv();
 
-    priv->_maxConcurrentOperationCount = 1;
-    priv->workAvailable = [[NSCondition alloc] init];
-    priv->suspendedCondition = [[NSCondition alloc] init];
-    priv->allWorkDone = [[NSCondition alloc] init];
-    priv->isSuspended = 0;
-    EbrLockInit(&priv->_threadRunningLock);
+        std::lock_guard<std::mutex> lock(priv->lock);
+        _createWorkers(priv, _workerLimit(priv));
+    }
 
     return self;
 }
 
 - (id)_initMainThread {
-    priv = new NSOperationQueuePriv();
+    if (self = [super init]) {
+        priv = new NSOperationQueuePriv();
+        priv->isMainQueue = true;
+        priv->maxConcurrentOperationCount = 1;
 
-    priv->_maxConcurrentOperationCount = 1;
-    priv->workAvailable = [[NSCondition alloc] init];
-    priv->suspendedCondition = [[NSCondition alloc] init];
-    priv->allWorkDone = [[NSCondition alloc] init];
-    priv->isSuspended = 0;
-    EbrLockInit(&priv->_threadRunningLock);
+        std::lock_guard<std::mutex> lock(priv->lock);
+        _createWorkers(priv, 1);
+    }
 
     return self;
 }
 
 /**
  @Status Interoperable
+ @Notes Operations run once their last dependency finishes; dependencies added after this call are not waited for.
 */
-- (void)addOperation:(id)op {
-    /*
-    //  Add any dependencies
-    id dependencies = [op dependencies];
-    int count = [dependencies count];
-    for ( int i = 0; i < count; i ++ ) {
-    id curDep = [dependencies objectAtIndex:i];
-    [self addOperation:curDep];
-    }
-    */
-
-    unsigned priority = 1;
-    if ([op queuePriority] < NSOperationQueuePriorityNormal) {
-        priority = 2;
-    } else if ([op queuePriority] > NSOperationQueuePriorityNormal) {
-        priority = 0;
+- (void)addOperation:(NSOperation*)op {
+    uint64_t sequence;
+    {
+        std::lock_guard<std::mutex> lock(priv->lock);
+        sequence = priv->nextSequence++;
+        priv->pending.emplace(sequence, op);
     }
 
-    NSAtomicListInsert((NSAtomicListRef*)(&priv->queues[priority]), op);
-    [priv->workAvailable signal];
-
-    EbrLockEnter(priv->_threadRunningLock);
-    if (priv->_thread == nil) {
-        priv->_thread = [[NSThread alloc] initWithTarget:self selector:@selector(_workThread) object:nil];
-        [priv->_thread start];
-        [priv->_thread release];
-    }
-    EbrLockLeave(priv->_threadRunningLock);
+    [op _whenReady:^{
+        [self _enqueueOperation:op sequence:sequence];
+    }];
 }
 
 /**
  @Status Interoperable
 */
 - (void)addOperationWithBlock:(void (^)())block {
-    id op = [NSOperation new];
-    [op setCompletionBlock:block];
-    [self addOperation:op];
-    [op release];
+    [self addOperation:[NSBlockOperation blockOperationWithBlock:block]];
 }
 
 /**
@@ -312,19 +388,29 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
 }
 
 /**
- @Status Stub
+ @Status Interoperable
 */
 - (void)setMaxConcurrentOperationCount:(NSInteger)count {
-    UNIMPLEMENTED();
-    priv->_maxConcurrentOperationCount = count;
+    if (priv->isMainQueue) {
+        return;
+    }
+
+    std::vector<unsigned> toStart;
+    {
+        std::lock_guard<std::mutex> lock(priv->lock);
+        priv->maxConcurrentOperationCount = count;
+        _createWorkers(priv, _workerLimit(priv));
+        _scheduleWorkers(priv, priv->readyCount, toStart);
+    }
+    [self _startWorkers:toStart];
 }
 
 /**
- @Status Stub
+ @Status Interoperable
 */
 - (NSInteger)maxConcurrentOperationCount {
-    UNIMPLEMENTED();
-    return priv->_maxConcurrentOperationCount;
+    std::lock_guard<std::mutex> lock(priv->lock);
+    return priv->maxConcurrentOperationCount;
 }
 
 /**
@@ -333,31 +419,9 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
 - (id)operations {
     id ret = [NSMutableArray array];
 
-    TraceVerbose(TAG, L"Should lock queue for this");
-    id cur = priv->curOperation;
-    if (cur != nil) {
-        [ret addObject:cur];
-    }
-
-    for (int i = 0; i < NSOperationQueuePriority_Count; i++) {
-        if (priv->queues[i] != NULL) {
-            NSAtomicListNode* curNode = (NSAtomicListNode*)priv->queues[i];
-
-            while (curNode != NULL) {
-                id node = (id)(DWORD)curNode->elt;
-                [ret addObject:node];
-                curNode = curNode->next;
-            }
-        }
-        if (priv->myQueues[i] != NULL) {
-            NSAtomicListNode* curNode = (NSAtomicListNode*)priv->myQueues[i];
-
-            while (curNode != NULL) {
-                id node = (id)(DWORD)curNode->elt;
-                [ret addObject:node];
-                curNode = curNode->next;
-            }
-        }
+    std::lock_guard<std::mutex> lock(priv->lock);
+    for (auto& entry : priv->pending) {
+        [ret addObject:entry.second];
     }
 
     return ret;
@@ -366,65 +430,25 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
 /**
  @Status Interoperable
 */
-- (unsigned)operationCount {
-    DWORD ret = 0;
-
-    id cur = priv->curOperation;
-    if (cur != nil) {
-        ret++;
-    }
-    for (int i = 0; i < NSOperationQueuePriority_Count; i++) {
-        if (priv->queues[i] != NULL) {
-            NSAtomicListNode* curNode = (NSAtomicListNode*)priv->queues[i];
-
-            while (curNode != NULL) {
-                ret++;
-                curNode = curNode->next;
-            }
-        }
-        if (priv->myQueues[i] != NULL) {
-            NSAtomicListNode* curNode = (NSAtomicListNode*)priv->myQueues[i];
-
-            while (curNode != NULL) {
-                ret++;
-                curNode = curNode->next;
-            }
-        }
-    }
-
-    return ret;
+- (NSUInteger)operationCount {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    return priv->pending.size();
 }
 
 /**
  @Status Interoperable
 */
 - (void)cancelAllOperations {
-    TraceVerbose(TAG, L"Should lock queue for this");
-
-    id cur = priv->curOperation;
-    if (cur != nil) {
-        [cur cancel];
-    }
-
-    for (int i = 0; i < NSOperationQueuePriority_Count; i++) {
-        if (priv->queues[i] != NULL) {
-            NSAtomicListNode* curNode = (NSAtomicListNode*)priv->queues[i];
-
-            while (curNode != NULL) {
-                id node = (id)(DWORD)curNode->elt;
-                [node cancel];
-                curNode = curNode->next;
-            }
+    std::vector<StrongId<NSOperation>> operations;
+    {
+        std::lock_guard<std::mutex> lock(priv->lock);
+        for (auto& entry : priv->pending) {
+            operations.emplace_back(entry.second);
         }
-        if (priv->myQueues[i] != NULL) {
-            NSAtomicListNode* curNode = (NSAtomicListNode*)priv->myQueues[i];
+    }
 
-            while (curNode != NULL) {
-                id node = (id)(DWORD)curNode->elt;
-                [node cancel];
-                curNode = curNode->next;
-            }
-        }
+    for (auto& op : operations) {
+        [op cancel];
     }
 }
 
@@ -432,16 +456,8 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
  @Status Interoperable
 */
 - (void)waitUntilAllOperationsAreFinished {
-    BOOL isWorking;
-
-    [priv->workAvailable lock];
-    isWorking = [self hasMoreWork];
-
-    if (isWorking) {
-        [priv->allWorkDone wait];
-        isWorking = [self hasMoreWork];
-    }
-    [priv->workAvailable unlock];
+    std::unique_lock<std::mutex> lock(priv->lock);
+    priv->allWorkDone.wait(lock, [self] { return priv->pending.empty(); });
 }
 
 /**
@@ -459,34 +475,40 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
  @Status Interoperable
 */
 - (BOOL)isSuspended {
-    [priv->suspendedCondition lock];
-    int ret = priv->isSuspended;
-    [priv->suspendedCondition unlock];
-
-    return ret;
+    return priv->isSuspended;
 }
 
 /**
  @Status Interoperable
 */
 - (id)resume {
-    [priv->suspendedCondition lock];
-    if (priv->isSuspended) {
-        priv->isSuspended = FALSE;
-        [priv->suspendedCondition broadcast];
+    std::vector<unsigned> toStart;
+    {
+        std::lock_guard<std::mutex> lock(priv->lock);
+        if (!priv->isSuspended) {
+            return self;
+        }
+        priv->isSuspended = false;
+        _scheduleWorkers(priv, priv->readyCount, toStart);
+    }
+    [self _startWorkers:toStart];
+
+    if (priv->isMainQueue) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self _doMainWork];
+        });
     }
-    [priv->suspendedCondition unlock];
 
     return self;
 }
 
 /**
  @Status Interoperable
+ @Notes Operations that are already running are not affected.
 */
 - (id)suspend {
-    [priv->suspendedCondition lock];
-    priv->isSuspended = TRUE;
-    [priv->suspendedCondition unlock];
+    std::lock_guard<std::mutex> lock(priv->lock);
+    priv->isSuspended = true;
 
     return self;
 }
@@ -528,10 +550,7 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
  @Status Interoperable
 */
 - (void)dealloc {
-    [priv->workAvailable release];
-    [priv->suspendedCondition release];
-    [priv->allWorkDone release];
-    EbrLockDestroy(priv->_threadRunningLock);
+    [priv->_name release];
     delete priv;
 
     [super dealloc];
@@ -555,13 +574,15 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
  @Status Interoperable
 */
 + (id)currentQueue {
+    if (s_currentQueue != nil) {
+        return s_currentQueue;
+    }
+
     if ([NSThread isMainThread]) {
         return [self mainQueue];
     }
 
-    assert(0);
-
-    return self;
+    return nil;
 }
 
 @end
@@ -19,7 +19,7 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #include "NSSSLHandler.h"
 #include "NSOutputStream_socket.h"
 #include "NSSelectInputSource.h"
-#include "NSSelectSet.h"
+#include "NSSelectBackend.h"
 #include "NSStreamInternal.h"
 #include "NSRunLoop+Internal.h"
 #include "LoggingNative.h"
@@ -27,15 +27,7 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 static const wchar_t* TAG = L"NSOutputStream_socket";
 
 static BOOL socketHasSpaceAvailable(id socket) {
-    NSSelectSet* selectSet = [[[NSSelectSet alloc] init] autorelease];
-    NSSelectSet* outputSet;
-
-    [selectSet addObjectForWrite:socket];
-    if ([selectSet waitForSelectWithOutputSet:&outputSet beforeDate:[NSDate date]] == nil) {
-        return [outputSet containsObjectForWrite:socket];
-    }
-
-    return NO;
+    return (NSSelectPollDescriptor([socket descriptor], NSSelectWriteEvent, 0) & NSSelectWriteEvent) != 0;
 }
 
 @implementation NSOutputStream_socket
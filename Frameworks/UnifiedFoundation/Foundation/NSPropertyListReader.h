@@ -14,78 +14,25 @@
 //
 //******************************************************************************
 
+// Reads binary (bplist00) property lists. The trailer and offset table are validated once when the list is opened, and
+// every object is bounds-checked as it is decoded, so malformed input produces nil rather than reading out of range.
+//
+// By default the whole object graph is decoded up front. In lazy mode, immutable arrays and dictionaries are returned as
+// proxies that decode each element the first time it is asked for, and long ASCII strings and data refer to the
+// property list's bytes instead of copying them; the bytes (or the file mapping) live as long as any of those objects.
 struct NSPropertyListReaderA {
 #define MAGIC "bplist"
 #define FORMAT "00"
-#define TRAILER_SIZE (sizeof(uint8_t) * 2 + sizeof(uint64_t) * 3)
+#define TRAILER_SIZE (sizeof(uint8_t) * 6 + sizeof(uint8_t) * 2 + sizeof(uint64_t) * 3)
 
     idt(NSData) _data;
+    const char* _mappedPath;
     CFOptionFlags _flags;
+    bool _lazy;
 
-    uint8_t _trailerOffsetIntSize;
-    uint8_t _trailerOffsetRefSize;
-    uint64_t _trailerNumObjects;
-    uint64_t _trailerTopObject;
-    uint64_t _trailerOffsetTableOffset;
-
-    uint8_t* _dataBytes;
-    unsigned _length;
-
-    uint64_t _readIntOfSize(size_t size, uint64_t* offsetPtr);
-    double _readFloatOfSize(size_t size, uint64_t* offsetPtr);
-    void _readHeader();
-
-    static uint64_t ReadSizedInt(const uint8_t* ptr, unsigned length, uint64_t offset, uint8_t size) {
-        assert(ptr != NULL && size >= 1 && size <= 8 && offset + size <= length);
-
-        uint64_t result = 0;
-        const uint8_t* byte = ptr + offset;
-
-        do {
-            result = (result << 8) | *byte++;
-        } while (--size);
-
-        return result;
+    NSPropertyListReaderA() : _data(nil), _mappedPath(nullptr), _flags(0), _lazy(false) {
     }
 
-    static BOOL ReadSelfSizedInt(const uint8_t* ptr, unsigned length, uint64_t offset, uint64_t* outValue, size_t* outSize) {
-        uint32_t size;
-        int64_t value;
-
-        assert(ptr != NULL && offset < length);
-
-        size = 1 << (ptr[offset] & 0x0F);
-        if (size > 8) {
-            // Maximum allowable size in this implementation is 1<<3 = 8 bytes.
-            // This also happens to be the biggest NSNumber can handle.
-            return FALSE;
-        }
-
-        if (offset + 1 + size > length) {
-            // Out of range.
-            return FALSE;
-        }
-
-        value = ReadSizedInt(ptr, length, offset + 1, size);
-
-        if (outValue) {
-            *outValue = value;
-        }
-
-        if (outSize) {
-            *outSize = size + 1; // +1 for tag byte.
-        }
-
-        return TRUE;
-    }
-
-    static idt(NSDictionary) ExtractUID(const uint8_t* ptr, unsigned length, uint64_t offset);
-
-    int readLongLength(uint64_t* offset);
-    id _readObjectAtOffset(uint64_t* offset);
-
-    id _readInlineObjectAtOffset(uint64_t* offset);
-
     id read();
 
     idt(NSData) data() {
@@ -96,7 +43,17 @@ struct NSPropertyListReaderA {
         _data = data;
     }
 
+    // Reads the file at path through a read-only mapping of it instead of a copy.
+    void initWithMappedFile(const char* path) {
+        _mappedPath = path;
+    }
+
     void setMutabilityFlags(CFOptionFlags flags) {
         _flags = flags;
     }
-};
\ No newline at end of file
+
+    // Ignored when mutable containers are requested.
+    void setLazy(bool lazy) {
+        _lazy = lazy;
+    }
+};
@@ -1,5 +1,6 @@
 /* Copyright (c) 2007 Michael Ash
 Copyright (c) 2007 Jens Ayton (uid decoding)
+Copyright (c) 2016 Microsoft Corporation. All rights reserved.
 
 Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
 documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
@@ -21,200 +22,744 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #include "Foundation/NSNumber.h"
 #include "Foundation/NSNull.h"
 #include "Foundation/NSData.h"
+#include "Foundation/NSDate.h"
+#include "Foundation/NSException.h"
+#include "Foundation/NSMutableData.h"
+#include "Foundation/NSMutableString.h"
 #include "Foundation/NSMutableDictionary.h"
 #include "Foundation/NSMutableArray.h"
+#include "Platform/EbrPlatform.h"
 #include "LoggingNative.h"
 
-static const wchar_t* TAG = L"NSPropertyListReader";
+#include <mutex>
+#include <objc/runtime.h>
 
-void NSPropertyListReaderA::_readHeader() {
-    uint64_t trailerStart = (uint64_t)([_data length] - TRAILER_SIZE);
+static const wchar_t* TAG = L"NSPropertyListReader";
 
-    _trailerOffsetIntSize = (uint8_t)_readIntOfSize(sizeof(_trailerOffsetIntSize), &trailerStart);
-    _trailerOffsetRefSize = (uint8_t)_readIntOfSize(sizeof(_trailerOffsetRefSize), &trailerStart);
-    _trailerNumObjects = _readIntOfSize(sizeof(_trailerNumObjects), &trailerStart);
-    _trailerTopObject = _readIntOfSize(sizeof(_trailerTopObject), &trailerStart);
-    _trailerOffsetTableOffset = _readIntOfSize(sizeof(_trailerOffsetTableOffset), &trailerStart);
+// Deeper nesting than this is treated as malformed (it can only come from a reference cycle in practice).
+static const unsigned c_maxDecodeDepth = 512;
+
+// In lazy mode, ASCII strings at least this long refer to the property list's bytes rather than copying them. Shorter
+// strings, which are mostly dictionary keys, are copied so that hashing and comparing them stays cheap.
+static const uint64_t c_minNoCopyStringLength = 32;
+
+namespace {
+enum BinaryPropertyListType : uint8_t {
+    kTypeSimple = 0x0, // null, false, true
+    kTypeInt = 0x1,
+    kTypeReal = 0x2,
+    kTypeDate = 0x3,
+    kTypeData = 0x4,
+    kTypeASCIIString = 0x5,
+    kTypeUnicodeString = 0x6,
+    kTypeUID = 0x8,
+    kTypeArray = 0xA,
+    kTypeDictionary = 0xD,
+};
+
+inline uint64_t ReadBigEndian(const uint8_t* ptr, unsigned size) {
+    switch (size) {
+        case 1:
+            return ptr[0];
+        case 2:
+            return ((uint64_t)ptr[0] << 8) | ptr[1];
+        case 4: {
+            uint32_t value;
+            memcpy(&value, ptr, sizeof(value));
+            return __builtin_bswap32(value);
+        }
+        case 8: {
+            uint64_t value;
+            memcpy(&value, ptr, sizeof(value));
+            return __builtin_bswap64(value);
+        }
+        default: {
+            uint64_t value = 0;
+            for (unsigned i = 0; i < size; i++) {
+                value = (value << 8) | ptr[i];
+            }
+            return value;
+        }
+    }
 }
 
-uint64_t NSPropertyListReaderA::_readIntOfSize(size_t size, uint64_t* offsetPtr) {
-    uint64_t ret = 0;
-    const uint8_t* ptr = (const uint8_t*)(_dataBytes + *offsetPtr);
-    size_t i;
-    for (i = 0; i < size; i++) {
-        ret <<= 8;
-        ret |= *ptr;
-        ptr++;
+// One object's marker, decoded. For ints, reals, dates and UIDs, count is the size of the value in bytes; for
+// everything else it is the number of bytes, characters, elements or key/value pairs. payload is the offset of the
+// first byte after the marker and any length that follows it.
+struct BinaryPropertyListObject {
+    uint8_t type;
+    uint8_t info;
+    uint64_t count;
+    uint64_t payload;
+};
+
+// A validated view of the bytes of a binary property list.
+class BinaryPropertyListView {
+public:
+    BinaryPropertyListView() : _bytes(nullptr), _length(0), _offsetSize(0), _refSize(0), _objectCount(0), _topObject(0), _offsetTable(0) {
     }
 
-    *offsetPtr += size;
+    // Checks the header, the trailer and every entry of the offset table, so that objectAt only has to check the
+    // object it is reading.
+    bool open(const uint8_t* bytes, uint64_t length) {
+        const uint64_t headerSize = strlen(MAGIC FORMAT);
+        if (length < headerSize + TRAILER_SIZE || memcmp(bytes, MAGIC FORMAT, headerSize) != 0) {
+            return false;
+        }
 
-    return ret;
-}
+        const uint8_t* trailer = bytes + length - TRAILER_SIZE;
+        uint8_t offsetSize = trailer[6];
+        uint8_t refSize = trailer[7];
+        uint64_t objectCount = ReadBigEndian(trailer + 8, 8);
+        uint64_t topObject = ReadBigEndian(trailer + 16, 8);
+        uint64_t offsetTable = ReadBigEndian(trailer + 24, 8);
+
+        if (offsetSize < 1 || offsetSize > 8 || refSize < 1 || refSize > 8) {
+            return false;
+        }
+        if (objectCount == 0 || topObject >= objectCount) {
+            return false;
+        }
+        if (refSize < 8 && ((objectCount - 1) >> (refSize * 8)) != 0) {
+            return false;
+        }
+        if (offsetTable <= headerSize || offsetTable > length - TRAILER_SIZE ||
+            objectCount > (length - TRAILER_SIZE - offsetTable) / offsetSize) {
+            return false;
+        }
 
-NSDictionary* NSPropertyListReaderA::ExtractUID(const uint8_t* ptr, unsigned length, uint64_t offset) {
-    /*        UIDs are used by Cocoa's key-value coder.
-    When writing other plist formats, they are expanded to dictionaries of
-    the form <dict><key>CF$UID</key><integer>value</integer></dict>, so we
-    do the same here on reading. This results in plists identical to what
-    running plutil -convert xml1 gives us. However, this is not the same
-    result as [Core]Foundation's plist parser, which extracts them as un-
-    introspectable CF objects. In fact, it even seems to convert the CF$UID
-    dictionaries from XML plists on the fly.
-    */
+        const uint8_t* entry = bytes + offsetTable;
+        for (uint64_t i = 0; i < objectCount; i++, entry += offsetSize) {
+            uint64_t offset = ReadBigEndian(entry, offsetSize);
+            if (offset < headerSize || offset >= offsetTable) {
+                return false;
+            }
+        }
 
-    uint64_t value;
+        _bytes = bytes;
+        _length = length;
+        _offsetSize = offsetSize;
+        _refSize = refSize;
+        _objectCount = objectCount;
+        _topObject = topObject;
+        _offsetTable = offsetTable;
+        return true;
+    }
 
-    if (!ReadSelfSizedInt(ptr, length, offset, &value, NULL)) {
-        return 0;
+    const uint8_t* bytes() const {
+        return _bytes;
     }
 
-    NSNumber* num = [[NSNumber alloc] initWithLongLong:value];
-    NSDictionary* ret = [[NSDictionary alloc] initWithObject:num forKey:@"CF$UID"];
-    [num release];
+    uint64_t topObject() const {
+        return _topObject;
+    }
 
-    return ret;
+    // Decodes the marker of object number ref, checking that the object lies entirely before the offset table.
+    bool objectAt(uint64_t ref, BinaryPropertyListObject* object) const {
+        if (ref >= _objectCount) {
+            return false;
+        }
+
+        uint64_t offset = ReadBigEndian(_bytes + _offsetTable + ref * _offsetSize, _offsetSize);
+        uint8_t marker = _bytes[offset];
+        uint64_t payload = offset + 1;
+        uint64_t count = 0;
+        uint64_t unitSize = 1;
+
+        object->type = marker >> 4;
+        object->info = marker & 0x0F;
+
+        switch (object->type) {
+            case kTypeSimple:
+                if (object->info != 0x0 && object->info != 0x8 && object->info != 0x9) {
+                    return false;
+                }
+                break;
+
+            case kTypeInt:
+                if (object->info > 4) {
+                    return false;
+                }
+                count = 1ULL << object->info;
+                break;
+
+            case kTypeReal:
+                if (object->info != 2 && object->info != 3) {
+                    return false;
+                }
+                count = 1ULL << object->info;
+                break;
+
+            case kTypeDate:
+                if (object->info != 3) {
+                    return false;
+                }
+                count = 8;
+                break;
+
+            case kTypeUID:
+                count = object->info + 1;
+                break;
+
+            case kTypeData:
+            case kTypeASCIIString:
+            case kTypeUnicodeString:
+            case kTypeArray:
+            case kTypeDictionary:
+                if (object->type == kTypeUnicodeString) {
+                    unitSize = 2;
+                } else if (object->type == kTypeArray) {
+                    unitSize = _refSize;
+                } else if (object->type == kTypeDictionary) {
+                    unitSize = 2 * _refSize;
+                }
+
+                count = object->info;
+                if (count == 0x0F) {
+                    // The length follows as an int object
+                    if (payload >= _offsetTable || (_bytes[payload] >> 4) != kTypeInt || (_bytes[payload] & 0x0F) > 3) {
+                        return false;
+                    }
+                    unsigned lengthSize = 1 << (_bytes[payload] & 0x0F);
+                    if (lengthSize > _offsetTable - payload - 1) {
+                        return false;
+                    }
+                    count = ReadBigEndian(_bytes + payload + 1, lengthSize);
+                    payload += 1 + lengthSize;
+                }
+                break;
+
+            default:
+                return false;
+        }
+
+        if (count > (_offsetTable - payload) / unitSize) {
+            return false;
+        }
+
+        object->count = count;
+        object->payload = payload;
+        return true;
+    }
+
+    // The index-th object reference stored in an array or dictionary; a dictionary's keys come before its values.
+    uint64_t refAt(const BinaryPropertyListObject& container, uint64_t index) const {
+        return ReadBigEndian(_bytes + container.payload + index * _refSize, _refSize);
+    }
+
+    uint64_t readInt(const BinaryPropertyListObject& object) const {
+        // 16-byte ints only ever hold values that fit in their low 8 bytes
+        return object.count == 16 ? ReadBigEndian(_bytes + object.payload + 8, 8) : ReadBigEndian(_bytes + object.payload, object.count);
+    }
+
+    double readReal(const BinaryPropertyListObject& object) const {
+        uint64_t bits = ReadBigEndian(_bytes + object.payload, object.count);
+        if (object.count == 4) {
+            uint32_t bits32 = (uint32_t)bits;
+            float value;
+            memcpy(&value, &bits32, sizeof(value));
+            return value;
+        }
+
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+private:
+    const uint8_t* _bytes;
+    uint64_t _length;
+    uint8_t _offsetSize;
+    uint8_t _refSize;
+    uint64_t _objectCount;
+    uint64_t _topObject;
+    uint64_t _offsetTable;
+};
+}
+
+// The bytes of one property list and the view over them. Lazy containers and no-copy strings keep it alive.
+@interface _NSBinaryPropertyList : NSObject {
+@public
+    BinaryPropertyListView _view;
+
+    //  Serializes lazy decoding across every container of this property list
+    std::mutex _decodeLock;
+
+@private
+    StrongId<NSData> _data;
+    void* _mapping;
+    size_t _mappingSize;
+}
+- (instancetype)initWithData:(NSData*)data;
+- (instancetype)initWithContentsOfMappedFile:(const char*)path;
+@end
+
+@implementation _NSBinaryPropertyList
+
+- (instancetype)initWithData:(NSData*)data {
+    _data = data;
+    if (!_view.open((const uint8_t*)[data bytes], [data length])) {
+        TraceVerbose(TAG, L"Not a valid binary property list");
+        [self release];
+        return nil;
+    }
+
+    return self;
 }
 
-double NSPropertyListReaderA::_readFloatOfSize(size_t size, uint64_t* offsetPtr) {
-    uint64_t val = _readIntOfSize(size, offsetPtr);
+- (instancetype)initWithContentsOfMappedFile:(const char*)path {
+    EbrFile* fp = EbrFopen(path, "rb");
+    if (fp == nullptr) {
+        TraceVerbose(TAG, L"Couldn't open %hs", path);
+        [self release];
+        return nil;
+    }
+
+    EbrFseek(fp, 0, SEEK_END);
+    size_t length = EbrFtell(fp);
+    EbrFseek(fp, 0, SEEK_SET);
 
-    if (size == 4) {
-        uint32_t val32 = (uint32_t)val;
-        return *(float*)&val32;
+    if (length > 0) {
+        _mapping = EbrMmap(EbrFileno(fp), length, 0);
+        _mappingSize = length;
+    }
+    EbrFclose(fp);
+
+    if (_mapping == nullptr) {
+        TraceVerbose(TAG, L"Couldn't map %hs", path);
+        [self release];
+        return nil;
+    }
+
+    if (!_view.open((const uint8_t*)_mapping, _mappingSize)) {
+        TraceVerbose(TAG, L"%hs is not a valid binary property list", path);
+        [self release];
+        return nil;
     }
-    if (size == 8) {
-        return *(double*)&val;
+
+    return self;
+}
+
+- (void)dealloc {
+    if (_mapping != nullptr) {
+        EbrMunmap(_mapping, _mappingSize);
     }
 
-    assert(0);
-    return 0.0;
+    [super dealloc];
 }
 
-int NSPropertyListReaderA::readLongLength(uint64_t* offset) {
-    const uint8_t* ptr = (const uint8_t*)_dataBytes;
-    uint8_t marker = ptr[*offset];
+@end
 
-    (*offset)++;
+static char _backingBytesKey;
 
-    uint8_t topNibble = marker >> 4;
-    uint8_t botNibble = marker & 0x0F;
+// Ties the lifetime of the property list's bytes to an object that refers to them without a copy.
+static void _retainBackingBytes(id object, _NSBinaryPropertyList* plist) {
+    objc_setAssociatedObject(object, &_backingBytesKey, plist, OBJC_ASSOCIATION_RETAIN);
+}
 
-    if (topNibble == 0x1) {
-        return (int)_readIntOfSize(1 << botNibble, offset);
+static void _releaseObjects(id* objects, uint64_t count) {
+    for (uint64_t i = 0; i < count; i++) {
+        [objects[i] release];
     }
-    if (topNibble == 0x2) {
-        size_t size = 1 << botNibble;
-        uint64_t val = _readIntOfSize(size, offset);
+}
 
-        if (size == 4) {
-            return (int)*((float*)&val);
-        }
-        if (size == 8) {
-            return (int)*((double*)&val);
+static id _decodeObject(_NSBinaryPropertyList* plist, uint64_t ref, CFOptionFlags flags, bool lazy, unsigned depth);
+
+static void _raiseCorrupt() {
+    [NSException raise:NSInternalInconsistencyException format:@"Binary property list is corrupt"];
+}
+
+// Decodes one element of a lazy container, at most once. Elements are published with release semantics so that a
+// reader that sees a non-nil slot without taking the lock also sees the object fully initialized.
+static id _lazyElement(_NSBinaryPropertyList* plist, id* slot, uint64_t ref) {
+    id object = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if (object != nil) {
+        return object;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(plist->_decodeLock);
+        object = *slot;
+        if (object == nil) {
+            object = _decodeObject(plist, ref, 0, true, 0);
+            __atomic_store_n(slot, object, __ATOMIC_RELEASE);
         }
-        return 0;
     }
 
-    assert(0);
-    return 0;
+    if (object == nil) {
+        _raiseCorrupt();
+    }
+    return object;
+}
+
+// An immutable array whose elements are decoded from the property list the first time they are asked for.
+@interface _NSBinaryPropertyListArray : NSArray {
+    _NSBinaryPropertyList* _plist;
+    BinaryPropertyListObject _object;
+    id* _objects;
+}
+- (instancetype)_initWithPropertyList:(_NSBinaryPropertyList*)plist object:(const BinaryPropertyListObject&)object;
+@end
+
+@implementation _NSBinaryPropertyListArray
+
+- (instancetype)_initWithPropertyList:(_NSBinaryPropertyList*)plist object:(const BinaryPropertyListObject&)object {
+    _plist = [plist retain];
+    _object = object;
+    _objects = (id*)IwCalloc((size_t)object.count, sizeof(id));
+    return self;
 }
 
-id NSPropertyListReaderA::_readObjectAtOffset(uint64_t* offset) {
-    const uint8_t* ptr = (const uint8_t*)_dataBytes;
-    uint8_t marker = ptr[*offset];
+- (NSUInteger)count {
+    return (NSUInteger)_object.count;
+}
+
+- (id)objectAtIndex:(NSUInteger)index {
+    if (index >= _object.count) {
+        TraceCritical(TAG, L"objectAtIndex: index > count (%d > %d), throwing exception", index, (int)_object.count);
+        [NSException raise:@"Array out of bounds" format:@""];
+        return nil;
+    }
 
-    (*offset)++;
+    return _lazyElement(_plist, &_objects[index], _plist->_view.refAt(_object, index));
+}
 
-    if (marker == 0x00) {
-        return [NSNull new];
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState*)state objects:(id*)stackBuf count:(NSUInteger)maxCount {
+    if (state->state >= _object.count) {
+        return 0;
     }
 
-    if (marker == 0x08) {
-        return (id)kCFBooleanFalse;
+    for (uint64_t i = 0; i < _object.count; i++) {
+        _lazyElement(_plist, &_objects[i], _plist->_view.refAt(_object, i));
     }
-    if (marker == 0x09) {
-        return (id)kCFBooleanTrue;
+
+    state->itemsPtr = _objects;
+    state->state = _object.count;
+    state->mutationsPtr = reinterpret_cast<unsigned long*>(self);
+    return (NSUInteger)_object.count;
+}
+
+- (instancetype)copyWithZone:(NSZone*)zone {
+    return [self retain];
+}
+
+- (void)dealloc {
+    for (uint64_t i = 0; i < _object.count; i++) {
+        [_objects[i] release];
+    }
+    IwFree(_objects);
+    [_plist release];
+
+    [super dealloc];
+}
+
+@end
+
+// An immutable dictionary whose keys are decoded and hashed on the first lookup, and whose values are decoded the first
+// time each is asked for. It has no CFDictionary storage; CFDictionary calls on it are forwarded to these methods.
+@interface _NSBinaryPropertyListDictionary : NSDictionary {
+    _NSBinaryPropertyList* _plist;
+    BinaryPropertyListObject _object;
+    id* _keys;
+    id* _values;
+
+    //  Open-addressed table of key index + 1, built along with _keys
+    uint32_t* _slots;
+    uint32_t _slotMask;
+}
+- (instancetype)_initWithPropertyList:(_NSBinaryPropertyList*)plist object:(const BinaryPropertyListObject&)object;
+@end
+
+@implementation _NSBinaryPropertyListDictionary
+
+- (instancetype)_initWithPropertyList:(_NSBinaryPropertyList*)plist object:(const BinaryPropertyListObject&)object {
+    _plist = [plist retain];
+    _object = object;
+    return self;
+}
+
+- (void)_loadKeys {
+    if (__atomic_load_n(&_slots, __ATOMIC_ACQUIRE) != nullptr) {
+        return;
     }
 
-    uint8_t topNibble = marker >> 4;
-    uint8_t botNibble = marker & 0x0F;
+    if (![self _decodeKeys]) {
+        _raiseCorrupt();
+    }
+}
 
-    if (topNibble == 0x1) {
-        return [[NSNumber alloc] initWithLongLong:(_readIntOfSize(1 << botNibble, offset))];
+- (BOOL)_decodeKeys {
+    std::lock_guard<std::mutex> lock(_plist->_decodeLock);
+    if (_slots != nullptr) {
+        return YES;
     }
-    if (topNibble == 0x2) {
-        size_t size = 1 << botNibble;
-        uint64_t val = _readIntOfSize(size, offset);
 
-        if (size == 4) {
-            uint32_t val32 = (uint32_t)val;
-            return [[NSNumber alloc] initWithFloat:*(float*)&val32];
+    uint64_t count = _object.count;
+    id* keys = (id*)IwCalloc((size_t)count, sizeof(id));
+    for (uint64_t i = 0; i < count; i++) {
+        keys[i] = _decodeObject(_plist, _plist->_view.refAt(_object, i), 0, true, 0);
+        if (keys[i] == nil) {
+            _releaseObjects(keys, i);
+            IwFree(keys);
+            return NO;
         }
-        if (size == 8) {
-            return [[NSNumber alloc] initWithDouble:*(double*)&val];
+    }
+
+    uint32_t slotCount = 2;
+    while (slotCount < count * 2) {
+        slotCount *= 2;
+    }
+    uint32_t* slots = (uint32_t*)IwCalloc(slotCount, sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t slot = (uint32_t)[keys[i] hash] & (slotCount - 1);
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & (slotCount - 1);
         }
-        return [[NSNumber alloc] initWithDouble:0.0];
+        slots[slot] = i + 1;
     }
-    if (topNibble == 0x3) {
-        return [[NSDate alloc] initWithTimeIntervalSinceReferenceDate:_readFloatOfSize(8, offset)];
+
+    _keys = keys;
+    _values = (id*)IwCalloc((size_t)count, sizeof(id));
+    _slotMask = slotCount - 1;
+    __atomic_store_n(&_slots, slots, __ATOMIC_RELEASE);
+    return YES;
+}
+
+- (id)_valueAtIndex:(uint64_t)index {
+    return _lazyElement(_plist, &_values[index], _plist->_view.refAt(_object, _object.count + index));
+}
+
+- (unsigned)count {
+    return (unsigned)_object.count;
+}
+
+- (id)objectForKey:(id)key {
+    if (key == nil) {
+        TraceWarning(TAG, L"Warning: objectForKey called with nil");
+        return nil;
     }
 
-    if (topNibble == 0x4 || topNibble == 0x5 || topNibble == 0x6 || topNibble == 0x8 || topNibble == 0xA || topNibble == 0xD) {
-        size_t length = 0;
-        if (botNibble != 0xF) {
-            length = botNibble;
-        } else {
-            length = readLongLength(offset);
+    [self _loadKeys];
+
+    uint32_t slot = (uint32_t)[key hash] & _slotMask;
+    for (uint32_t index; (index = _slots[slot]) != 0; slot = (slot + 1) & _slotMask) {
+        id candidate = _keys[index - 1];
+        if (candidate == key || [candidate isEqual:key]) {
+            return [self _valueAtIndex:index - 1];
         }
+    }
+
+    return nil;
+}
+
+- (void)getObjects:(id*)objects andKeys:(id*)keys {
+    [self _loadKeys];
 
-        if (topNibble == 0x4) {
-            return [[NSData alloc] initWithBytes:_dataBytes + *offset length:length];
+    for (uint64_t i = 0; i < _object.count; i++) {
+        if (objects) {
+            objects[i] = [self _valueAtIndex:i];
         }
-        if (topNibble == 0x5) {
-            return [[NSString alloc] initWithBytes:_dataBytes + *offset length:length encoding:NSASCIIStringEncoding];
+        if (keys) {
+            keys[i] = _keys[i];
         }
-        if (topNibble == 0x6) {
-            return [[NSString alloc] initWithBytes:_dataBytes + *offset length:(length * 2) encoding:NSUTF16BigEndianStringEncoding];
+    }
+}
+
+- (NSEnumerator*)keyEnumerator {
+    [self _loadKeys];
+    return [[NSArray arrayWithObjects:_keys count:(NSUInteger)_object.count] objectEnumerator];
+}
+
+- (NSEnumerator*)objectEnumerator {
+    [self _loadKeys];
+    for (uint64_t i = 0; i < _object.count; i++) {
+        [self _valueAtIndex:i];
+    }
+    return [[NSArray arrayWithObjects:_values count:(NSUInteger)_object.count] objectEnumerator];
+}
+
+- (unsigned)countByEnumeratingWithState:(NSFastEnumerationState*)state objects:(id*)stackBuf count:(unsigned)maxCount {
+    if (state->state >= _object.count) {
+        return 0;
+    }
+
+    [self _loadKeys];
+    state->itemsPtr = _keys;
+    state->state = _object.count;
+    state->mutationsPtr = reinterpret_cast<unsigned long*>(self);
+    return (unsigned)_object.count;
+}
+
+- (instancetype)copyWithZone:(NSZone*)zone {
+    return [self retain];
+}
+
+- (void)dealloc {
+    if (_slots != nullptr) {
+        for (uint64_t i = 0; i < _object.count; i++) {
+            [_keys[i] release];
+            [_values[i] release];
         }
-        if (topNibble == 0x8) {
-            return ExtractUID(_dataBytes, _length, (*offset) - 1);
+        IwFree(_keys);
+        IwFree(_values);
+        IwFree(_slots);
+    }
+    [_plist release];
+
+    [super dealloc];
+}
+
+@end
+
+/*        UIDs are used by Cocoa's key-value coder.
+When writing other plist formats, they are expanded to dictionaries of
+the form <dict><key>CF$UID</key><integer>value</integer></dict>, so we
+do the same here on reading. This results in plists identical to what
+running plutil -convert xml1 gives us. However, this is not the same
+result as [Core]Foundation's plist parser, which extracts them as un-
+introspectable CF objects. In fact, it even seems to convert the CF$UID
+dictionaries from XML plists on the fly.
+*/
+static id _decodeUID(uint64_t value) {
+    NSNumber* num = [[NSNumber alloc] initWithLongLong:value];
+    NSDictionary* ret = [[NSDictionary alloc] initWithObject:num forKey:@"CF$UID"];
+    [num release];
+
+    return ret;
+}
+
+// Returns the object numbered ref with a +1 reference, or nil if it (or, when not lazy, anything it contains) is
+// malformed.
+static id _decodeObject(_NSBinaryPropertyList* plist, uint64_t ref, CFOptionFlags flags, bool lazy, unsigned depth) {
+    const BinaryPropertyListView& view = plist->_view;
+    BinaryPropertyListObject object;
+
+    if (depth > c_maxDecodeDepth || !view.objectAt(ref, &object)) {
+        return nil;
+    }
+
+    const uint8_t* payload = view.bytes() + object.payload;
+    bool mutableContainers = (flags & (kCFPropertyListMutableContainers | kCFPropertyListMutableContainersAndLeaves)) != 0;
+    bool mutableLeaves = (flags & kCFPropertyListMutableContainersAndLeaves) != 0;
+
+    switch (object.type) {
+        case kTypeSimple:
+            if (object.info == 0x8) {
+                return (id)kCFBooleanFalse;
+            }
+            if (object.info == 0x9) {
+                return (id)kCFBooleanTrue;
+            }
+            return [NSNull new];
+
+        case kTypeInt:
+            if (object.count == 16) {
+                return [[NSNumber alloc] initWithUnsignedLongLong:view.readInt(object)];
+            }
+            return [[NSNumber alloc] initWithLongLong:(int64_t)view.readInt(object)];
+
+        case kTypeReal:
+            if (object.count == 4) {
+                return [[NSNumber alloc] initWithFloat:(float)view.readReal(object)];
+            }
+            return [[NSNumber alloc] initWithDouble:view.readReal(object)];
+
+        case kTypeDate:
+            return [[NSDate alloc] initWithTimeIntervalSinceReferenceDate:view.readReal(object)];
+
+        case kTypeData:
+            if (mutableLeaves) {
+                return [[NSMutableData alloc] initWithBytes:payload length:(NSUInteger)object.count];
+            }
+            if (lazy) {
+                NSData* data = [[NSData alloc] initWithBytesNoCopy:(void*)payload length:(NSUInteger)object.count freeWhenDone:NO];
+                _retainBackingBytes(data, plist);
+                return data;
+            }
+            return [[NSData alloc] initWithBytes:payload length:(NSUInteger)object.count];
+
+        case kTypeASCIIString:
+            if (mutableLeaves) {
+                return [[NSMutableString alloc] initWithBytes:payload length:(NSUInteger)object.count encoding:NSASCIIStringEncoding];
+            }
+            if (lazy && object.count >= c_minNoCopyStringLength) {
+                NSString* string = [[NSString alloc] initWithBytesNoCopy:(char*)payload
+                                                                  length:(unsigned)object.count
+                                                                encoding:NSASCIIStringEncoding
+                                                            freeWhenDone:NO];
+                _retainBackingBytes(string, plist);
+                return string;
+            }
+            return [[NSString alloc] initWithBytes:payload length:(NSUInteger)object.count encoding:NSASCIIStringEncoding];
+
+        case kTypeUnicodeString: {
+            NSString* string = mutableLeaves ? [NSMutableString alloc] : [NSString alloc];
+            return [string initWithBytes:payload length:(NSUInteger)object.count * 2 encoding:NSUTF16BigEndianStringEncoding];
         }
 
-        if (topNibble == 0xA) {
-            NSArray* result;
-            id* objs = (id*)IwMalloc(length * sizeof(id));
-            uint64_t i;
-            for (i = 0; i < length; i++) {
-                objs[i] = _readInlineObjectAtOffset(offset);
+        case kTypeUID:
+            return _decodeUID(view.readInt(object));
+
+        case kTypeArray: {
+            if (lazy && !mutableContainers) {
+                return [[_NSBinaryPropertyListArray alloc] _initWithPropertyList:plist object:object];
+            }
+
+            id* objs = (id*)IwMalloc((size_t)object.count * sizeof(id));
+            for (uint64_t i = 0; i < object.count; i++) {
+                objs[i] = _decodeObject(plist, view.refAt(object, i), flags, false, depth + 1);
+                if (objs[i] == nil) {
+                    _releaseObjects(objs, i);
+                    IwFree(objs);
+                    return nil;
+                }
             }
 
-            if ((_flags & kCFPropertyListMutableContainers) || (_flags & kCFPropertyListMutableContainersAndLeaves)) {
-                result = [[NSMutableArray alloc] initWithObjectsTakeOwnership:objs count:length];
+            NSArray* result;
+            if (mutableContainers) {
+                result = [[NSMutableArray alloc] initWithObjectsTakeOwnership:objs count:(NSUInteger)object.count];
             } else {
-                result = [[NSArray alloc] initWithObjectsTakeOwnership:objs count:length];
+                result = [[NSArray alloc] initWithObjectsTakeOwnership:objs count:(NSUInteger)object.count];
             }
 
             IwFree(objs);
             return result;
         }
 
-        if (topNibble == 0xD) {
-            id result;
-            id* keys = (id*)IwMalloc(length * sizeof(id));
-            id* objs = (id*)IwMalloc(length * sizeof(id));
-            uint64_t i;
-            for (i = 0; i < length; i++) {
-                keys[i] = _readInlineObjectAtOffset(offset);
+        case kTypeDictionary: {
+            if (lazy && !mutableContainers) {
+                return [[_NSBinaryPropertyListDictionary alloc] _initWithPropertyList:plist object:object];
             }
-            for (i = 0; i < length; i++) {
-                objs[i] = _readInlineObjectAtOffset(offset);
+
+            // Keys are always immutable
+            id* keys = (id*)IwMalloc((size_t)object.count * sizeof(id));
+            id* objs = (id*)IwMalloc((size_t)object.count * sizeof(id));
+            uint64_t keyCount = 0;
+            uint64_t objCount = 0;
+            bool valid = true;
+
+            for (; valid && keyCount < object.count; keyCount++) {
+                keys[keyCount] = _decodeObject(plist, view.refAt(object, keyCount), 0, false, depth + 1);
+                valid = keys[keyCount] != nil;
+            }
+            for (; valid && objCount < object.count; objCount++) {
+                objs[objCount] = _decodeObject(plist, view.refAt(object, object.count + objCount), flags, false, depth + 1);
+                valid = objs[objCount] != nil;
             }
 
-            if ((_flags & kCFPropertyListMutableContainers) || (_flags & kCFPropertyListMutableContainersAndLeaves)) {
-                result = [[NSMutableDictionary alloc] initWithObjectsTakeOwnership:objs forKeys:keys count:length];
+            if (!valid) {
+                _releaseObjects(keys, keyCount);
+                _releaseObjects(objs, objCount);
+                IwFree(keys);
+                IwFree(objs);
+                return nil;
+            }
+
+            id result;
+            if (mutableContainers) {
+                result = [[NSMutableDictionary alloc] initWithObjectsTakeOwnership:objs forKeys:keys count:(unsigned)object.count];
             } else {
-                result = [[NSDictionary alloc] initWithObjectsTakeOwnership:objs forKeys:keys count:length];
+                result = [[NSDictionary alloc] initWithObjectsTakeOwnership:objs forKeys:keys count:(unsigned)object.count];
             }
 
             IwFree(keys);
@@ -223,45 +768,32 @@ id NSPropertyListReaderA::_readObjectAtOffset(uint64_t* offset) {
         }
     }
 
-    assert(0);
-    return 0;
-}
-
-id NSPropertyListReaderA::_readInlineObjectAtOffset(uint64_t* offset) {
-    // first read the offset table index out of the file
-    uint64_t objOffset = _readIntOfSize(_trailerOffsetRefSize, offset);
-
-    // then transform the index into an offset in the file which points to
-    // that offset table entry
-    objOffset = _trailerOffsetTableOffset + objOffset * _trailerOffsetIntSize;
-
-    // lastly read the offset stored at that entry
-    objOffset = _readIntOfSize(_trailerOffsetIntSize, &objOffset);
-
-    // and read the object stored there
-    return _readObjectAtOffset(&objOffset);
+    return nil;
 }
 
 id NSPropertyListReaderA::read() {
-    id result = NULL;
-    _dataBytes = (uint8_t*)[_data bytes];
-    _length = [_data length];
-
-    if ([_data length] < TRAILER_SIZE) {
-        return nil;
+    bool mutableContainers = (_flags & (kCFPropertyListMutableContainers | kCFPropertyListMutableContainersAndLeaves)) != 0;
+    bool lazy = _lazy && !mutableContainers;
+
+    _NSBinaryPropertyList* plist;
+    if (_mappedPath != nullptr) {
+        plist = [[_NSBinaryPropertyList alloc] initWithContentsOfMappedFile:_mappedPath];
+    } else {
+        // Lazy objects outlive this call, so they must not see later changes to mutable data
+        NSData* data = lazy ? [[_data copy] autorelease] : _data;
+        plist = [[_NSBinaryPropertyList alloc] initWithData:data];
     }
-    if (memcmp((void*)[_data bytes], "bplist", 6) != 0) {
-        TraceVerbose(TAG, L"Not a plist file");
+
+    if (plist == nil) {
         return nil;
     }
 
-    TraceVerbose(TAG, L"got %d bytes", _length);
-
-    //@try
-    _readHeader();
+    id result = _decodeObject(plist, plist->_view.topObject(), _flags, lazy, 0);
+    [plist release];
 
-    uint64_t offset = _trailerTopObject + strlen(MAGIC FORMAT);
-    result = _readObjectAtOffset(&offset);
+    if (result == nil) {
+        TraceVerbose(TAG, L"Binary property list is corrupt");
+    }
 
     return [result autorelease];
-}
\ No newline at end of file
+}
@@ -30,6 +30,7 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #include "Foundation/NSKeyedArchiver.h"
 #include "NSPropertyListReader.h"
 #include "NSPropertyListWriter_binary.h"
+#include "NSPropertyListSerializationInternal.h"
 
 #import "NSXMLPropertyList.h"
 #include "LoggingNative.h"
@@ -42,7 +43,7 @@ void printContents(int level, id obj);
 
 /**
  @Status Caveat
- @Notes mutability option not supported. Only binary, XML and text strings format supported.
+ @Notes mutability option only supported for binary property lists. Only binary, XML and text strings format supported.
 */
 + (id)propertyListFromData:(NSData*)data
           mutabilityOption:(unsigned)mutability
@@ -94,6 +95,7 @@ void printContents(int level, id obj);
         */
         NSPropertyListReaderA read;
         read.init(data);
+        read.setMutabilityFlags(mutability);
         id ret = read.read();
 
         if (ret == nil) {
@@ -122,7 +124,7 @@ void printContents(int level, id obj);
 
 /**
  @Status Caveat
- @Notes mutability option not supported. Only binary, XML and text strings format supported.
+ @Notes mutability option only supported for binary property lists. Only binary, XML and text strings format supported.
 */
 + (id)propertyListWithData:(NSData*)data options:(unsigned)options format:(NSPropertyListFormat*)formatOut error:(NSError**)error {
     // [TODO] Not that this uses a different error format than ours. Below takes a string, we return an NSError.
@@ -207,4 +209,27 @@ return [NSPropertyListWriter_xml dataWithPropertyList:plist];
     return StubReturn();
 }
 
++ (id)_propertyListWithContentsOfFile:(NSString*)path mutabilityOption:(NSPropertyListMutabilityOptions)mutability {
+    if (path == nil) {
+        return nil;
+    }
+
+    NSPropertyListReaderA read;
+    read.initWithMappedFile([path UTF8String]);
+    read.setMutabilityFlags(mutability);
+    read.setLazy(true);
+    id ret = read.read();
+    if (ret != nil) {
+        return ret;
+    }
+
+    // Not a binary property list (or not one that could be mapped)
+    NSData* data = [NSData dataWithContentsOfFile:path];
+    if (data == nil) {
+        return nil;
+    }
+
+    return [self propertyListFromData:data mutabilityOption:mutability format:nullptr errorDescription:nullptr];
+}
+
 @end
@@ -28,6 +28,10 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #include "sys/timespec.h"
 #include "LoggingNative.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
 static const wchar_t* TAG = L"NSRunLoopState";
 
 int (*UIEventTimedMultipleWaitCallback)(EbrEvent* events, int numEvents, double timeout, SocketWait* sockets) = EbrEventTimedMultipleWait;
@@ -119,9 +123,57 @@ bool GetMainDispatchTimerTimeout(double* val) {
     }
 }
 
+//  The timers in a mode, in a min-heap on fire time. Heap entries go stale when their timer is removed or rescheduled; stale
+//  entries, and invalidated timers, are dropped when they reach the top, or all at once when stale entries pile up.
+struct NSRunLoopTimerQueue {
+    struct Entry {
+        double fireTime;
+        uint64_t sequence;
+        NSTimer* timer;
+    };
+
+    //  The std heap functions keep the greatest element on top, so order by which fires later
+    static bool firesLater(const Entry& left, const Entry& right) {
+        return (left.fireTime > right.fireTime) || (left.fireTime == right.fireTime && left.sequence > right.sequence);
+    }
+
+    std::vector<Entry> heap;
+
+    //  The timers in this mode, retained, each mapped to the sequence number of its live heap entry
+    std::unordered_map<NSTimer*, uint64_t> timers;
+    uint64_t nextSequence = 0;
+
+    bool isLive(const Entry& entry) const {
+        auto found = timers.find(entry.timer);
+        return found != timers.end() && found->second == entry.sequence;
+    }
+
+    void schedule(NSTimer* timer) {
+        uint64_t sequence = nextSequence++;
+        timers[timer] = sequence;
+        heap.push_back({ [timer _fireTime], sequence, timer });
+        std::push_heap(heap.begin(), heap.end(), firesLater);
+        compactIfStale();
+    }
+
+    Entry pop() {
+        std::pop_heap(heap.begin(), heap.end(), firesLater);
+        Entry ret = heap.back();
+        heap.pop_back();
+        return ret;
+    }
+
+    void compactIfStale() {
+        if (heap.size() > 2 * timers.size() + 64) {
+            heap.erase(std::remove_if(heap.begin(), heap.end(), [this](const Entry& entry) { return !isLive(entry); }), heap.end());
+            std::make_heap(heap.begin(), heap.end(), firesLater);
+        }
+    }
+};
+
 @implementation NSRunLoopState
 - (NSObject*)init {
-    _timers = [NSMutableArray new];
+    _timerQueue = new NSRunLoopTimerQueue();
     _observers = [NSMutableArray new];
     _cancelSource = (NSInputSource*)[NSRunLoopSource new];
     [self addInputSource:_cancelSource];
@@ -130,9 +182,11 @@ bool GetMainDispatchTimerTimeout(double* val) {
 }
 
 - (void)dealloc {
-    for (NSTimer* curtimer in _timers) {
-        [curtimer _removedFromMode:self];
+    for (auto& timer : _timerQueue->timers) {
+        [timer.first _removedFromMode:self];
+        [timer.first release];
     }
+    delete _timerQueue;
     [_cancelSource release];
     for (int i = 0; i < _numWaitSignals; i++) {
         [_waitSignalObjects[i] release];
@@ -140,7 +194,6 @@ bool GetMainDispatchTimerTimeout(double* val) {
     for (int i = 0; i < _numWaitSockets; i++) {
         [_waitSocketObjects[i] release];
     }
-    [_timers release];
 
     if (_builtWakeupSockets) {
         closesocket(_wakeupSockets[0]);
@@ -156,12 +209,17 @@ bool GetMainDispatchTimerTimeout(double* val) {
 }
 
 - (void)addTimer:(NSTimer*)timer {
-    [_timers addObject:timer];
+    if (_timerQueue->timers.find(timer) != _timerQueue->timers.end()) {
+        return;
+    }
+
+    [timer retain];
     [timer _addedToMode:self];
+    _timerQueue->schedule(timer);
 }
 
 - (BOOL)containsTimer:(NSTimer*)timer {
-    return [_timers containsObject:timer];
+    return _timerQueue->timers.find(timer) != _timerQueue->timers.end();
 }
 
 - (void)addObserver:(NSTimer*)observer {
@@ -174,7 +232,43 @@ bool GetMainDispatchTimerTimeout(double* val) {
 
 - (void)removeTimer:(NSTimer*)timer {
     [timer _removedFromMode:self];
-    [_timers removeObject:timer];
+
+    auto found = _timerQueue->timers.find(timer);
+    if (found != _timerQueue->timers.end()) {
+        _timerQueue->timers.erase(found);
+        _timerQueue->compactIfStale();
+        [timer release];
+    }
+}
+
+- (void)_timerFireDateChanged:(NSTimer*)timer {
+    //  Reinserting leaves the old entry stale, so a timer moved earlier isn't held back by its old position
+    if (_timerQueue->timers.find(timer) != _timerQueue->timers.end()) {
+        _timerQueue->schedule(timer);
+    }
+}
+
+//  Drops stale entries and invalid timers off the top of the heap, and returns the timer that fires next
+- (NSTimer*)_nextTimer {
+    while (!_timerQueue->heap.empty()) {
+        const NSRunLoopTimerQueue::Entry& top = _timerQueue->heap.front();
+        NSTimer* timer = top.timer;
+
+        if (!_timerQueue->isLive(top)) {
+            _timerQueue->pop();
+        } else if (![timer isValid]) {
+            _timerQueue->pop();
+            [self removeTimer:timer];
+        } else if (top.fireTime != [timer _fireTime]) {
+            //  Fired by hand, or rescheduled without going through -setFireDate:
+            _timerQueue->pop();
+            _timerQueue->schedule(timer);
+        } else {
+            return timer;
+        }
+    }
+
+    return nil;
 }
 
 - (void)changingIntoMode:(NSString*)mode {
@@ -206,34 +300,27 @@ bool GetMainDispatchTimerTimeout(double* val) {
         return NO;
     }
 
-    NSDate* now = [NSDate date];
-    int i, count = [_timers count];
-    NSTimer* fireTimer = nil;
-
-    for (i = 0; i < count; i++) {
-        NSTimer* check = [_timers objectAtIndex:i];
-
-        if ([check isValid] && [now compare:[check fireDate]] != -1) {
-            id object = [[_timers objectAtIndex:i] retain];
-            [_timers removeObjectAtIndex:i];
-            [_timers insertObject:object atIndex:[_timers count]];
-            [object release];
-            fireTimer = check;
-            break;
-        }
+    NSTimer* fireTimer = [self _nextTimer];
+    if (fireTimer != nil && [fireTimer _fireTime] > [NSDate timeIntervalSinceReferenceDate]) {
+        fireTimer = nil;
     }
 
     if (fireTimer != nil) {
+        NSRunLoopTimerQueue::Entry fired = _timerQueue->pop();
+
+        [fireTimer retain];
         [fireTimer fire];
-    }
 
-    count = [_timers count];
-    while (--count >= 0) {
-        NSTimer* timer = [_timers objectAtIndex:count];
-        if (![timer isValid]) {
-            [timer _removedFromMode:self];
-            [_timers removeObjectAtIndex:count];
+        //  Unless the timer was removed or rescheduled while firing, put a repeating timer back in at its next fire date
+        //  and drop one that is done
+        if (_timerQueue->isLive(fired)) {
+            if ([fireTimer isValid]) {
+                _timerQueue->schedule(fireTimer);
+            } else {
+                [self removeTimer:fireTimer];
+            }
         }
+        [fireTimer release];
     }
 
     if (fireTimer == nil) {
@@ -247,22 +334,10 @@ bool GetMainDispatchTimerTimeout(double* val) {
 
 - (NSDate*)limitDateForMode:(NSString*)mode {
     NSDate* limit = nil;
-    int count;
 
-    count = [_timers count];
-    while (--count >= 0) {
-        NSTimer* timer = [_timers objectAtIndex:count];
-
-        if (![timer isValid]) {
-            [timer _removedFromMode:self];
-            [_timers removeObjectAtIndex:count];
-        } else {
-            if (limit == nil) {
-                limit = [timer fireDate];
-            } else {
-                limit = [limit earlierDate:[timer fireDate]];
-            }
-        }
+    NSTimer* nextTimer = [self _nextTimer];
+    if (nextTimer != nil) {
+        limit = [NSDate dateWithTimeIntervalSinceReferenceDate:[nextTimer _fireTime]];
     }
 
     if (limit == nil) {
@@ -348,18 +423,22 @@ bool GetMainDispatchTimerTimeout(double* val) {
 }
 
 - (void)invalidateTimerWithDelayedPerform:(NSDelayedPerform*)delayed {
-    int count = [_timers count];
-
-    while (--count >= 0) {
-        NSTimer* timer = [_timers objectAtIndex:count];
-        NSObject* check = [timer userInfo];
+    //  Invalidating releases the timer's target, which may add or remove timers
+    std::vector<NSTimer*> matches;
+    for (auto& timer : _timerQueue->timers) {
+        NSObject* check = [timer.first userInfo];
 
         if ([check isKindOfClass:[NSDelayedPerform class]]) {
             if ([check isEqualToPerform:delayed]) {
-                [timer invalidate];
+                matches.push_back([timer.first retain]);
             }
         }
     }
+
+    for (NSTimer* timer : matches) {
+        [timer invalidate];
+        [timer release];
+    }
 }
 
 - (void)acceptInputForMode:(NSString*)mode beforeDate:(NSDate*)date {
@@ -0,0 +1,50 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+//  Event masks are built from NSSelectReadEvent, NSSelectWriteEvent and NSSelectExceptEvent.
+struct NSSelectReadiness {
+    int descriptor;
+    unsigned events;
+};
+
+//  Waits for readiness on a set of descriptors that is kept across waits, so a wait costs time in the number of ready
+//  descriptors (epoll) or registered descriptors (poll) rather than in the largest descriptor value.
+class NSSelectBackend {
+public:
+    virtual ~NSSelectBackend() {
+    }
+
+    //  Registers, changes or (with an empty mask) removes interest in a descriptor.
+    virtual bool setInterest(int descriptor, unsigned events) = 0;
+
+    //  Waits up to timeoutMs (negative waits forever) and replaces the contents of ready with the descriptors that
+    //  became ready. Returns the number of ready descriptors, 0 on timeout or -1 on error.
+    virtual int wait(int timeoutMs, std::vector<NSSelectReadiness>& ready) = 0;
+
+    virtual size_t count() const = 0;
+
+    //  epoll where it is available, poll everywhere else.
+    static std::unique_ptr<NSSelectBackend> create();
+    static std::unique_ptr<NSSelectBackend> createPollBackend();
+};
+
+//  Checks one descriptor without registering it anywhere; returns the events that are ready.
+unsigned NSSelectPollDescriptor(int descriptor, unsigned events, int timeoutMs);
@@ -0,0 +1,269 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#define NSSELECT_EPOLL
+#elif defined(WIN32) || defined(WINPHONE) || defined(__OBJC__)
+#include <WinSock2.h>
+#define NSSELECT_WINSOCK
+#else
+#include <poll.h>
+#include <errno.h>
+#endif
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "Starboard.h"
+#include "NSSelectBackend.h"
+#include "NSSelectInputSource.h"
+#include "LoggingNative.h"
+
+static const wchar_t* TAG = L"NSSelectBackend";
+
+#ifdef NSSELECT_WINSOCK
+typedef WSAPOLLFD NSPollDescriptor;
+#define nsPoll(fds, count, timeout) WSAPoll(fds, (ULONG)(count), timeout)
+//  WSAPoll rejects POLLPRI; out-of-band data is reported as POLLRDBAND
+static const short c_pollExceptEvents = POLLRDBAND;
+#else
+typedef struct pollfd NSPollDescriptor;
+#define nsPoll(fds, count, timeout) poll(fds, (nfds_t)(count), timeout)
+static const short c_pollExceptEvents = POLLPRI;
+#endif
+
+//  Errors and hangups wake readers and writers alike, the way select() reports them; a failed connect also shows up
+//  in the exception set.
+static short _pollEventsForMask(unsigned events) {
+    short result = 0;
+    if (events & NSSelectReadEvent) {
+#ifdef NSSELECT_WINSOCK
+        result |= POLLRDNORM;
+#else
+        result |= POLLIN;
+#endif
+    }
+    if (events & NSSelectWriteEvent) {
+        result |= POLLOUT;
+    }
+    if (events & NSSelectExceptEvent) {
+        result |= c_pollExceptEvents;
+    }
+    return result;
+}
+
+static unsigned _maskForPollEvents(short revents, unsigned interest) {
+    unsigned result = 0;
+    if (revents & (POLLIN | POLLRDNORM | POLLHUP | POLLERR)) {
+        result |= NSSelectReadEvent;
+    }
+    if (revents & (POLLOUT | POLLERR)) {
+        result |= NSSelectWriteEvent;
+    }
+    if (revents & (c_pollExceptEvents | POLLERR)) {
+        result |= NSSelectExceptEvent;
+    }
+    return result & interest;
+}
+
+//  Keeps the pollfd array between waits; a descriptor's slot is found through a map, and removal swaps the last slot in.
+class NSPollSelectBackend : public NSSelectBackend {
+public:
+    bool setInterest(int descriptor, unsigned events) override {
+        auto found = _slots.find(descriptor);
+        if (events == 0) {
+            if (found != _slots.end()) {
+                size_t slot = found->second;
+                _slots.erase(found);
+                if (slot != _descriptors.size() - 1) {
+                    _descriptors[slot] = _descriptors.back();
+                    _interest[slot] = _interest.back();
+                    _slots[(int)_descriptors[slot].fd] = slot;
+                }
+                _descriptors.pop_back();
+                _interest.pop_back();
+            }
+            return true;
+        }
+
+        if (found != _slots.end()) {
+            _descriptors[found->second].events = _pollEventsForMask(events);
+            _interest[found->second] = events;
+            return true;
+        }
+
+        NSPollDescriptor pollDescriptor = {};
+        pollDescriptor.fd = descriptor;
+        pollDescriptor.events = _pollEventsForMask(events);
+        _slots[descriptor] = _descriptors.size();
+        _descriptors.push_back(pollDescriptor);
+        _interest.push_back(events);
+        return true;
+    }
+
+    int wait(int timeoutMs, std::vector<NSSelectReadiness>& ready) override {
+        ready.clear();
+        int readyCount = nsPoll(_descriptors.data(), _descriptors.size(), timeoutMs);
+        if (readyCount <= 0) {
+            return readyCount < 0 ? -1 : 0;
+        }
+
+        for (size_t i = 0; i < _descriptors.size() && (int)ready.size() < readyCount; i++) {
+            if (_descriptors[i].revents != 0) {
+                unsigned events = _maskForPollEvents(_descriptors[i].revents, _interest[i]);
+                if (events != 0) {
+                    ready.push_back({ (int)_descriptors[i].fd, events });
+                }
+            }
+        }
+        return (int)ready.size();
+    }
+
+    size_t count() const override {
+        return _descriptors.size();
+    }
+
+private:
+    std::vector<NSPollDescriptor> _descriptors;
+    std::vector<unsigned> _interest;
+    std::unordered_map<int, size_t> _slots;
+};
+
+#ifdef NSSELECT_EPOLL
+static const size_t c_maxEventsPerWait = 4096;
+
+//  Level triggered, so descriptors that did not fit in one wait are reported again by the next.
+class NSEpollSelectBackend : public NSSelectBackend {
+public:
+    explicit NSEpollSelectBackend(int epollDescriptor) : _epoll(epollDescriptor) {
+    }
+
+    ~NSEpollSelectBackend() override {
+        close(_epoll);
+    }
+
+    bool setInterest(int descriptor, unsigned events) override {
+        auto found = _interest.find(descriptor);
+        if (events == 0) {
+            if (found != _interest.end()) {
+                _interest.erase(found);
+                //  The descriptor may already have been closed, which removed it from the set
+                epoll_ctl(_epoll, EPOLL_CTL_DEL, descriptor, nullptr);
+            }
+            return true;
+        }
+
+        struct epoll_event event = {};
+        event.events = _epollEventsForMask(events);
+        event.data.fd = descriptor;
+        int op = (found == _interest.end()) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+        if (epoll_ctl(_epoll, op, descriptor, &event) != 0) {
+            TraceError(TAG, L"epoll_ctl(%d) failed for descriptor %d: %d", op, descriptor, errno);
+            return false;
+        }
+        _interest[descriptor] = events;
+        return true;
+    }
+
+    int wait(int timeoutMs, std::vector<NSSelectReadiness>& ready) override {
+        ready.clear();
+        _events.resize(std::max<size_t>(1, std::min(_interest.size(), c_maxEventsPerWait)));
+        int readyCount = epoll_wait(_epoll, _events.data(), (int)_events.size(), timeoutMs);
+        if (readyCount <= 0) {
+            return readyCount < 0 ? -1 : 0;
+        }
+
+        for (int i = 0; i < readyCount; i++) {
+            auto found = _interest.find(_events[i].data.fd);
+            if (found == _interest.end()) {
+                continue;
+            }
+
+            unsigned events = _maskForEpollEvents(_events[i].events, found->second);
+            if (events != 0) {
+                ready.push_back({ _events[i].data.fd, events });
+            }
+        }
+        return (int)ready.size();
+    }
+
+    size_t count() const override {
+        return _interest.size();
+    }
+
+private:
+    static uint32_t _epollEventsForMask(unsigned events) {
+        uint32_t result = 0;
+        if (events & NSSelectReadEvent) {
+            result |= EPOLLIN | EPOLLRDHUP;
+        }
+        if (events & NSSelectWriteEvent) {
+            result |= EPOLLOUT;
+        }
+        if (events & NSSelectExceptEvent) {
+            result |= EPOLLPRI;
+        }
+        return result;
+    }
+
+    static unsigned _maskForEpollEvents(uint32_t revents, unsigned interest) {
+        unsigned result = 0;
+        if (revents & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            result |= NSSelectReadEvent;
+        }
+        if (revents & (EPOLLOUT | EPOLLERR)) {
+            result |= NSSelectWriteEvent;
+        }
+        if (revents & (EPOLLPRI | EPOLLERR)) {
+            result |= NSSelectExceptEvent;
+        }
+        return result & interest;
+    }
+
+    int _epoll;
+    std::unordered_map<int, unsigned> _interest;
+    std::vector<struct epoll_event> _events;
+};
+#endif
+
+std::unique_ptr<NSSelectBackend> NSSelectBackend::create() {
+#ifdef NSSELECT_EPOLL
+    int epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    if (epollDescriptor >= 0) {
+        return std::unique_ptr<NSSelectBackend>(new NSEpollSelectBackend(epollDescriptor));
+    }
+    TraceWarning(TAG, L"epoll_create1 failed (%d), falling back to poll", errno);
+#endif
+    return createPollBackend();
+}
+
+std::unique_ptr<NSSelectBackend> NSSelectBackend::createPollBackend() {
+    return std::unique_ptr<NSSelectBackend>(new NSPollSelectBackend());
+}
+
+unsigned NSSelectPollDescriptor(int descriptor, unsigned events, int timeoutMs) {
+    NSPollDescriptor pollDescriptor = {};
+    pollDescriptor.fd = descriptor;
+    pollDescriptor.events = _pollEventsForMask(events);
+    if (nsPoll(&pollDescriptor, 1, timeoutMs) <= 0) {
+        return 0;
+    }
+    return _maskForPollEvents(pollDescriptor.revents, events);
+}
@@ -18,266 +18,214 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #elif defined(WINPHONE) || defined(__OBJC__)
 #include <winsock2.h>
 #undef WIN32
-#else
-#include <sys/socket.h>
-#include <sys/select.h>
 #endif
 
 #include <errno.h>
+#include <math.h>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "Starboard.h"
 #include "NSSelectSet.h"
-#include "Foundation/NSMutableSet.h"
-#include "NSSocket.h"
+#include "NSSelectBackend.h"
+#include "NSSelectInputSource.h"
+#include "Foundation/NSDate.h"
 #include "LoggingNative.h"
 
 static const wchar_t* TAG = L"NSSelectSet";
 
-@implementation NSSelectSet
-typedef struct {
-    int max;
-    fd_set* fdset;
-} native_set;
+static const unsigned c_selectEvents[] = { NSSelectReadEvent, NSSelectWriteEvent, NSSelectExceptEvent };
+static const size_t c_selectEventCount = sizeof(c_selectEvents) / sizeof(c_selectEvents[0]);
+
+//  Longest single wait; longer waits are split so a backgrounded app gets a chance to block between them
+static const NSTimeInterval c_maximumWaitInterval = 1000000.0;
+
+struct NSSelectSetRegistration {
+    //  Indexed like c_selectEvents
+    StrongId<NSObject> objects[c_selectEventCount];
+    unsigned events = 0;
+};
+
+//  Registrations are keyed by descriptor and mirrored into the backend as they change, rather than being rebuilt from
+//  scratch for every wait. The backend is only created when the set is first waited on, so output sets never make one.
+struct NSSelectSetRegistrations {
+    std::unordered_map<int, NSSelectSetRegistration> descriptors;
+    std::unique_ptr<NSSelectBackend> backend;
+    std::vector<NSSelectReadiness> ready;
+
+    void add(id object, size_t eventIndex) {
+        int descriptor = [object descriptor];
+        NSSelectSetRegistration& registration = descriptors[descriptor];
+        registration.objects[eventIndex] = object;
+        update(descriptor, registration, registration.events | c_selectEvents[eventIndex]);
+    }
 
-static native_set* native_set_new(int max) {
-    native_set* result = (native_set*)IwCalloc(1, sizeof(native_set));
+    void remove(id object, size_t eventIndex) {
+        int descriptor = [object descriptor];
+        auto found = descriptors.find(descriptor);
+        if (found == descriptors.end() || !(found->second.events & c_selectEvents[eventIndex])) {
+            return;
+        }
 
-    result->max = FD_SETSIZE;
-    result->fdset = (fd_set*)IwCalloc(1, sizeof(fd_set));
+        found->second.objects[eventIndex] = nil;
+        update(descriptor, found->second, found->second.events & ~c_selectEvents[eventIndex]);
+        if (found->second.events == 0) {
+            descriptors.erase(found);
+        }
+    }
 
-    return result;
-}
+    bool contains(id object, size_t eventIndex) const {
+        auto found = descriptors.find([object descriptor]);
+        return found != descriptors.end() && (found->second.events & c_selectEvents[eventIndex]);
+    }
 
-static void native_set_free(native_set* set) {
-    IwFree(set->fdset);
-    IwFree(set);
-}
+    void update(int descriptor, NSSelectSetRegistration& registration, unsigned events) {
+        if (registration.events == events) {
+            return;
+        }
+        registration.events = events;
+        if (backend) {
+            backend->setInterest(descriptor, events);
+        }
+    }
 
-static void native_set_clear(native_set* set, int descriptor) {
-    FD_CLR(descriptor, set->fdset);
-}
+    NSSelectBackend* activeBackend() {
+        if (!backend) {
+            backend = NSSelectBackend::create();
+            for (auto& entry : descriptors) {
+                backend->setInterest(entry.first, entry.second.events);
+            }
+        }
+        return backend.get();
+    }
+};
 
-static void native_set_set(native_set* set, int descriptor) {
-    FD_SET(descriptor, set->fdset);
+@implementation NSSelectSet
+- (id)init {
+    if (self = [super init]) {
+        _registrations = new NSSelectSetRegistrations();
+    }
+    return self;
 }
 
-static BOOL native_set_is_set(native_set* native, int descriptor) {
-    // if(descriptor>native->max)
-    // return NO;
-
-    return FD_ISSET(descriptor, native->fdset);
+- (void)dealloc {
+    delete _registrations;
+    [super dealloc];
 }
 
-static int maxDescriptorInSet(id set) {
-    int result = -1;
-    id state = [set objectEnumerator];
-    id socket;
-
-    while ((socket = [state nextObject]) != nil) {
-        int check = [socket descriptor];
-
-        if (check > result)
-            result = check;
-    }
-
-    return result;
+- (id)addObjectForRead:(id)object {
+    _registrations->add(object, 0);
+    return self;
 }
 
-static int maxDescriptorInThreeSets(id set1, id set2, id set3) {
-    int check, result = maxDescriptorInSet(set1);
-
-    check = maxDescriptorInSet(set2);
-    if (check > result)
-        result = check;
-
-    check = maxDescriptorInSet(set3);
-    if (check > result)
-        result = check;
+- (id)addObjectForWrite:(id)object {
+    _registrations->add(object, 1);
+    return self;
+}
 
-    return result;
+- (id)addObjectForException:(id)object {
+    _registrations->add(object, 2);
+    return self;
 }
 
-static void transferSetToNative(id set, native_set* native) {
-    id state = [set objectEnumerator];
-    id socket;
+- (void)removeObjectForRead:(id)object {
+    _registrations->remove(object, 0);
+}
 
-    while ((socket = [state nextObject]) != nil)
-        native_set_set(native, [socket descriptor]);
+- (void)removeObjectForWrite:(id)object {
+    _registrations->remove(object, 1);
 }
 
-static void transferNativeToSetWithOriginals(native_set* sset, id set, id original, id cheater) {
-    unsigned int i;
+- (void)removeObjectForException:(id)object {
+    _registrations->remove(object, 2);
+}
 
-#if defined(WIN32) || defined(WINPHONE)
-    for (i = 0; i < sset->fdset->fd_count; i++) {
-        if (native_set_is_set(sset, sset->fdset->fd_array[i])) {
-            [cheater setDescriptor:sset->fdset->fd_array[i]];
-            [set addObject:[original member:cheater]];
+- (void)removeAllObjects {
+    if (_registrations->backend) {
+        for (auto& entry : _registrations->descriptors) {
+            _registrations->backend->setInterest(entry.first, 0);
         }
     }
-#else
-    for (i = 0; i < sset->max; i++) {
-        if (native_set_is_set(sset, i)) {
-            [cheater setDescriptor:i];
-            [set addObject:[original member:cheater]];
-        }
-    }
-#endif
+    _registrations->descriptors.clear();
 }
 
-- (id)init {
-    _readSet = [NSMutableSet new];
-    _writeSet = [NSMutableSet new];
-    _exceptionSet = [NSMutableSet new];
-    return self;
+- (BOOL)isEmpty {
+    return _registrations->descriptors.empty();
 }
 
-- (void)dealloc {
-    [_readSet release];
-    [_writeSet release];
-    [_exceptionSet release];
-    [super dealloc];
+- (NSUInteger)count {
+    return _registrations->descriptors.size();
 }
 
-- (id)addObjectForRead:(id)object {
-    [_readSet addObject:object];
-
-    return self;
+- (BOOL)containsObjectForRead:(id)object {
+    return _registrations->contains(object, 0);
 }
 
-- (id)addObjectForWrite:(id)object {
-    [_writeSet addObject:object];
-
-    return self;
+- (BOOL)containsObjectForWrite:(id)object {
+    return _registrations->contains(object, 1);
 }
 
-- (id)addObjectForException:(id)object {
-    [_exceptionSet addObject:object];
-
-    return self;
+- (BOOL)containsObjectForException:(id)object {
+    return _registrations->contains(object, 2);
 }
 
-- (BOOL)isEmpty {
-    return ([_readSet count] == 0) && ([_writeSet count] == 0) && ([_exceptionSet count] == 0);
-}
+- (id)waitForSelectWithOutputSet:(NSSelectSet**)outputSetX beforeDate:(NSDate*)beforeDate {
+    NSSelectSet* outputSet = [[[NSSelectSet alloc] init] autorelease];
+    *outputSetX = outputSet;
 
-- (id)waitForSelectWithOutputSet:(id*)outputSetX beforeDate:(id)beforeDate {
-    id result = nil;
-    id cheater = [NSSocket socketWithDescriptor:-1];
-    int maxDescriptor = maxDescriptorInThreeSets(_readSet, _writeSet, _exceptionSet);
-    native_set* activeRead = native_set_new(maxDescriptor);
-    native_set* activeWrite = native_set_new(maxDescriptor);
-    native_set* activeExcept = native_set_new(maxDescriptor);
-    struct __ws2_timeval timeval;
-    NSTimeInterval interval = 1.0;
+    //  WSAPoll refuses an empty set, and there is nothing to report anyway
+    if (_registrations->descriptors.empty()) {
+        return nil;
+    }
+
+    NSSelectBackend* backend = _registrations->activeBackend();
+    std::vector<NSSelectReadiness>& ready = _registrations->ready;
 
     int numFds = 0;
-    while (result == nil && numFds == 0 && interval > 0.0) {
+    NSTimeInterval interval = 1.0;
+    while (numFds == 0 && interval > 0.0) {
         EbrBlockIfBackground();
-        transferSetToNative(_readSet, activeRead);
-        transferSetToNative(_writeSet, activeWrite);
-        transferSetToNative(_exceptionSet, activeExcept);
 
-        interval = [beforeDate timeIntervalSinceNow];
-
-        if (interval > 1000000)
-            interval = 1000000;
-#ifdef ANDRID
-        if (interval < 10000)
+        interval = std::min([beforeDate timeIntervalSinceNow], c_maximumWaitInterval);
+        if (interval < 0) {
             interval = 0;
-#else
-        if (interval < 0)
-            interval = 0;
-#endif
-
-        timeval.tv_sec = (long)interval;
-        interval -= timeval.tv_sec;
-        timeval.tv_usec = (long)(interval * 1000000);
+        }
 
-        if ((numFds = select(maxDescriptor + 1, activeRead->fdset, activeWrite->fdset, activeExcept->fdset, &timeval)) < 0) {
+        if ((numFds = backend->wait((int)ceil(interval * 1000.0), ready)) < 0) {
 #if defined(WIN32) || defined(WINPHONE)
             DWORD err = WSAGetLastError();
             TraceError(TAG, L"Select error %d", err);
 #else
-            TraceError(TAG, L"Select error %d", errno);
-#endif
-            if (errno == EINTR) {
+            int err = errno;
+            TraceError(TAG, L"Select error %d", err);
+            if (err == EINTR) {
                 TraceVerbose(TAG, L"Interrupted, restarting");
-                fflush(stdout);
                 numFds = 0;
                 continue;
             }
-            /*
-            if(errno!=EINTR) {
-            //result=[NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
-            assert(0);
-            }
-            */
+#endif
             assert(0);
+            return nil;
         }
-
-        double nextInterval = [beforeDate timeIntervalSinceNow];
     }
 
-    if (result == nil) {
-        NSSelectSet* outputSet = [[[NSSelectSet alloc] init] autorelease];
-        if (numFds) {
-            /*
-            for(int i=0;i<activeRead->max;i++){
-            if(native_set_is_set(activeRead,i)){
-            TraceVerbose(TAG, L"%d is readable", i);
-            }
+    for (const NSSelectReadiness& readiness : ready) {
+        auto found = _registrations->descriptors.find(readiness.descriptor);
+        if (found == _registrations->descriptors.end()) {
+            continue;
+        }
+
+        for (size_t i = 0; i < c_selectEventCount; i++) {
+            if (readiness.events & c_selectEvents[i]) {
+                outputSet->_registrations->add(found->second.objects[i], i);
             }
-            */
-            transferNativeToSetWithOriginals(activeRead, outputSet->_readSet, _readSet, cheater);
-            transferNativeToSetWithOriginals(activeWrite, outputSet->_writeSet, _writeSet, cheater);
-            transferNativeToSetWithOriginals(activeExcept, outputSet->_exceptionSet, _exceptionSet, cheater);
         }
-        *outputSetX = outputSet;
     }
+    ready.clear();
 
-    native_set_free(activeRead);
-    native_set_free(activeWrite);
-    native_set_free(activeExcept);
-
-    return result;
+    return nil;
 }
 
-- (BOOL)containsObjectForRead:(id)object {
-    return [_readSet containsObject:object];
-}
-
-- (BOOL)containsObjectForWrite:(id)object {
-    return [_writeSet containsObject:object];
-}
-
-- (BOOL)containsObjectForException:(id)object {
-    return [_exceptionSet containsObject:object];
-}
-
-/*
--(void)removeObjectForRead:object {
-[_readSet removeObject:object];
-}
-
--(void)removeObjectForWrite:object {
-[_writeSet removeObject:object];
-}
-
--(void)removeObjectForException:object {
-[_exceptionSet removeObject:object];
-}
-
--(void)removeAllObjects {
-[_readSet removeAllObjects];
-[_writeSet removeAllObjects];
-[_exceptionSet removeAllObjects];
-}
-
--(void)waitInBackgroundInMode:(NSString *)mode {
-NSInvalidAbstractInvocation();
-}
-
-*/
-
 @end
@@ -25,6 +25,9 @@
 #include "unicode/unistr.h"
 #include <new>
 #include <assert.h>
+#include <algorithm>
+#include <mutex>
+#include <type_traits>
 
 #include "IcuHelper.h"
 
@@ -39,6 +42,8 @@ NSString* const NSCharacterConversionException = @"NSCharacterConversionExceptio
 enum NSStringType {
     NSUninitializedString = 0,
     NSConstructedString_Unicode = 0x7FFFFFFF,
+    //  Latin-1 bytes, one per UTF-16 code unit. The ICU form is only built when an operation needs it.
+    NSConstructedString_Compact = 0x7FFFFFFE,
     NSConstructedString_NoOwn = 0x20,
 };
 
@@ -69,36 +74,252 @@ struct ConstStrData {
     size_t len;
 };
 
-void UStringHolder::initWithString(NSString* str, int location, int length) {
-    static EbrLock _upgradeLock;
-    static bool _upgradeLockSet;
+static bool _isASCII(const char* bytes, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if ((uint8_t)bytes[i] >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    _destroyStr = NULL;
+//  FNV-1a over UTF-16 code units, so a compact string hashes the same as its Unicode form
+template <typename TUnit>
+static uint32_t _hashCodeUnits(const TUnit* units, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        uint16_t unit = (uint16_t)(typename std::make_unsigned<TUnit>::type)units[i];
+        hash = (hash ^ (unit & 0xFF)) * 16777619u;
+        hash = (hash ^ (unit >> 8)) * 16777619u;
+    }
+    return hash;
+}
 
-    if (!_upgradeLockSet) {
-        EbrLockInit(&_upgradeLock);
-        _upgradeLockSet = true;
+//  Compact strings keep their state and, unless they point at constant data, their bytes in a single allocation.
+static stringData* _compactStringDataCreate(const char* bytes, size_t length, bool isASCII, bool copyBytes) {
+    stringData* data = (stringData*)IwCalloc(1, sizeof(stringData) + (copyBytes ? length + 1 : 0));
+    if (copyBytes) {
+        char* storage = (char*)(data + 1);
+        memcpy(storage, bytes, length);
+        storage[length] = 0;
+        bytes = storage;
     }
 
-    if ([str class] == [CFConstantString class]) {
-        if (str->strType != NSConstructedString_Unicode) {
-            EbrLockEnter(_upgradeLock);
-            //  Contention case
-            if (str->strType == NSConstructedString_Unicode) {
-                EbrLockLeave(_upgradeLock);
-            } else {
-                ConstStrData* constStr = (ConstStrData*)str;
-                _str = new UnicodeString(UnicodeString::fromUTF8(StringPiece((const char*)constStr->c_str, constStr->len)));
-                str->u = new stringData();
-                str->u->ConstructedString.constructedStr = new _ConstructedStringData();
-                str->u->ConstructedString.constructedStr->str = _str;
-                str->u->ConstructedString._hashIsCached = FALSE;
-                str->u->ConstructedString._placementAllocated = FALSE;
-                str->strType = NSConstructedString_Unicode;
-                EbrLockLeave(_upgradeLock);
+    data->CompactString._bytes = bytes;
+    data->CompactString._length = length;
+    data->CompactString._isASCII = isASCII;
+    return data;
+}
+
+static void _compactStringDataFree(stringData* data) {
+    if (_ConstructedStringData* unicodeStr = data->CompactString._unicodeStr) {
+        delete unicodeStr->str;
+        delete unicodeStr;
+    }
+    IwFree(data);
+}
+
+//  Only plain immutable strings are stored compactly; mutable strings would convert on their first edit anyway.
+static bool _prefersCompactStorage(NSString* inst) {
+    return inst->strType == NSUninitializedString && object_getClass(inst) == [NSString class];
+}
+
+//  Stores ASCII bytes, or any bytes when they are known to be Latin-1, without going through ICU. Returns false when
+//  the string needs the Unicode representation instead.
+static bool _setToCompact(NSString* inst, const char* bytes, size_t length, bool isLatin1) {
+    if (!_prefersCompactStorage(inst) || length > UINT32_MAX) {
+        return false;
+    }
+
+    bool isASCII = _isASCII(bytes, length);
+    if (!isASCII && !isLatin1) {
+        return false;
+    }
+
+    inst->u = _compactStringDataCreate(bytes, length, isASCII, true);
+    inst->strType = NSConstructedString_Compact;
+    return true;
+}
+
+static bool _setToCompact(NSString* inst, const UChar* chars, int32_t length) {
+    if (!_prefersCompactStorage(inst)) {
+        return false;
+    }
+
+    bool isASCII = true;
+    for (int32_t i = 0; i < length; i++) {
+        if (chars[i] > 0xFF) {
+            return false;
+        }
+        isASCII = isASCII && chars[i] < 0x80;
+    }
+
+    stringData* data = (stringData*)IwCalloc(1, sizeof(stringData) + length + 1);
+    char* storage = (char*)(data + 1);
+    for (int32_t i = 0; i < length; i++) {
+        storage[i] = (char)chars[i];
+    }
+    data->CompactString._bytes = storage;
+    data->CompactString._length = length;
+    data->CompactString._isASCII = isASCII;
+
+    inst->u = data;
+    inst->strType = NSConstructedString_Compact;
+    return true;
+}
+
+static std::mutex _upgradeLock;
+
+//  A constant string starts out as the compiler laid it out, with its bytes and length where the string's storage
+//  pointer and type live. The first use converts it in place: ASCII literals point compact storage at their bytes,
+//  anything else is decoded as UTF-8.
+static void _upgradeConstantString(NSString* str) {
+    uint32_t type = __atomic_load_n(&str->strType, __ATOMIC_ACQUIRE);
+    if (type == NSConstructedString_Unicode || type == NSConstructedString_Compact) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_upgradeLock);
+    //  Contention case
+    type = __atomic_load_n(&str->strType, __ATOMIC_ACQUIRE);
+    if (type == NSConstructedString_Unicode || type == NSConstructedString_Compact) {
+        return;
+    }
+
+    ConstStrData* constStr = (ConstStrData*)str;
+    const char* bytes = constStr->c_str;
+    size_t length = constStr->len;
+
+    stringData* data;
+    if (length <= UINT32_MAX && _isASCII(bytes, length)) {
+        data = _compactStringDataCreate(bytes, length, true, false);
+        type = NSConstructedString_Compact;
+    } else {
+        data = new stringData();
+        data->ConstructedString.constructedStr = new _ConstructedStringData();
+        data->ConstructedString.constructedStr->str = new UnicodeString(UnicodeString::fromUTF8(StringPiece(bytes, length)));
+        data->ConstructedString._hashIsCached = FALSE;
+        data->ConstructedString._placementAllocated = FALSE;
+        type = NSConstructedString_Unicode;
+    }
+
+    str->u = data;
+    __atomic_store_n(&str->strType, type, __ATOMIC_RELEASE);
+}
+
+//  The Latin-1 bytes of a compact string. Constant strings are converted first, so ASCII literals qualify.
+static inline bool _compactBytes(NSString* str, const char** bytes, uint32_t* length) {
+    static Class s_constantStringClass = [CFConstantString class];
+    if (object_getClass(str) == s_constantStringClass) {
+        _upgradeConstantString(str);
+    }
+
+    if (str->strType != NSConstructedString_Compact) {
+        return false;
+    }
+
+    *bytes = str->u->CompactString._bytes;
+    *length = str->u->CompactString._length;
+    return true;
+}
+
+//  Builds the ICU form of a compact string the first time one is needed; racing threads keep whichever copy lands first.
+static _ConstructedStringData* _compactUnicodeData(NSString* str) {
+    _CompactStringType& compact = str->u->CompactString;
+    _ConstructedStringData* data = __atomic_load_n(&compact._unicodeStr, __ATOMIC_ACQUIRE);
+    if (data) {
+        return data;
+    }
+
+    _ConstructedStringData* created = new _ConstructedStringData();
+    created->str = new UnicodeString(compact._length, 0, 0);
+    UChar* buffer = created->str->getBuffer(compact._length);
+    for (uint32_t i = 0; i < compact._length; i++) {
+        buffer[i] = (uint8_t)compact._bytes[i];
+    }
+    created->str->releaseBuffer(compact._length);
+
+    if (__atomic_compare_exchange_n(&compact._unicodeStr, &data, created, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return created;
+    }
+
+    delete created->str;
+    delete created;
+    return data;
+}
+
+//  Cached hash of a compact or Unicode string, if there is one
+static inline bool _cachedHash(NSString* str, uint32_t* hash) {
+    switch (str->strType) {
+        case NSConstructedString_Compact:
+            if (__atomic_load_n(&str->u->CompactString._hashIsCached, __ATOMIC_ACQUIRE)) {
+                *hash = str->u->CompactString._hashCache;
+                return true;
+            }
+            break;
+
+        case NSConstructedString_Unicode:
+            if (__atomic_load_n(&str->u->ConstructedString._hashIsCached, __ATOMIC_ACQUIRE)) {
+                *hash = str->u->ConstructedString._hashCache;
+                return true;
             }
+            break;
+    }
+    return false;
+}
+
+static inline bool _cachedHashesDiffer(NSString* left, NSString* right) {
+    uint32_t leftHash, rightHash;
+    return _cachedHash(left, &leftHash) && _cachedHash(right, &rightHash) && leftHash != rightHash;
+}
+
+//  Literal equality without ICU, for when at least one side is compact. Returns false if it cannot decide.
+static bool _compactEquals(NSString* left, NSString* right, BOOL* equal) {
+    const char *leftBytes, *rightBytes;
+    uint32_t leftLength, rightLength;
+    bool leftCompact = _compactBytes(left, &leftBytes, &leftLength);
+    bool rightCompact = _compactBytes(right, &rightBytes, &rightLength);
+    if (!leftCompact && !rightCompact) {
+        return false;
+    }
+
+    if (leftCompact && rightCompact) {
+        *equal = leftLength == rightLength && memcmp(leftBytes, rightBytes, leftLength) == 0;
+        return true;
+    }
+
+    if (!leftCompact) {
+        std::swap(left, right);
+        std::swap(leftBytes, rightBytes);
+        std::swap(leftLength, rightLength);
+    }
+    if (right->strType != NSConstructedString_Unicode) {
+        return false;
+    }
+
+    const UnicodeString& other = *right->u->ConstructedString.constructedStr->str;
+    if ((uint32_t)other.length() != leftLength) {
+        *equal = FALSE;
+        return true;
+    }
+
+    const UChar* otherChars = other.getBuffer();
+    for (uint32_t i = 0; i < leftLength; i++) {
+        if (otherChars[i] != (uint8_t)leftBytes[i]) {
+            *equal = FALSE;
+            return true;
         }
     }
+    *equal = TRUE;
+    return true;
+}
+
+void UStringHolder::initWithString(NSString* str, int location, int length) {
+    _destroyStr = NULL;
+
+    if (object_getClass(str) == [CFConstantString class]) {
+        _upgradeConstantString(str);
+    }
 
     switch (str->strType) {
         case NSConstructedString_NoOwn:
@@ -131,6 +352,10 @@ void UStringHolder::initWithString(NSString* str, int location, int length) {
             _str = str->u->ConstructedString.constructedStr->str;
             break;
 
+        case NSConstructedString_Compact:
+            _str = _compactUnicodeData(str)->str;
+            break;
+
         default:
             assert(0);
             break;
@@ -200,28 +425,40 @@ inline unichar UStringHolder::getChar(int index) {
 
 void setToUnicode(NSString* inst, UnicodeString& str) {
     switch (inst->strType) {
-        case NSConstructedString_NoOwn:
-            switch (inst->u->NoOwnString._encoding) {
-                case NSUTF8StringEncoding: {
-                    UErrorCode status = U_ZERO_ERROR;
-                    UConverter* u8cnv = getUTF8Converter();
+        case NSConstructedString_NoOwn: {
+            //  Changing a string over borrowed bytes gives it its own Unicode copy; the borrowed buffer is never written
+            _ConstructedStringData* constructedStr = new _ConstructedStringData();
+            constructedStr->str = new UnicodeString(str);
 
-                    char* targetBegin = (char*)inst->u->NoOwnString._address;
-                    char* targetStart = targetBegin;
-                    char* targetEnd = targetStart + inst->u->NoOwnString._length;
-                    const UChar* sourceBegin = str.getBuffer();
-                    const UChar* sourceStart = sourceBegin;
-                    const UChar* sourceEnd = sourceStart + str.length();
+            if (inst->u->NoOwnString._freeWhenDone) {
+                IwFree(inst->u->NoOwnString._address);
+            }
+            delete inst->u;
 
-                    ucnv_fromUnicode(u8cnv, &targetStart, targetEnd, &sourceStart, sourceEnd, NULL, TRUE, &status);
-                } break;
+            inst->u = new stringData();
+            inst->u->ConstructedString.constructedStr = constructedStr;
+            inst->u->ConstructedString._hashIsCached = FALSE;
+            inst->u->ConstructedString._placementAllocated = FALSE;
+            inst->strType = NSConstructedString_Unicode;
+        } break;
 
-                default:
-                    assert(0);
-                    *((char*)0xBAADF00D) = 0;
-                    break;
+        case NSConstructedString_Compact: {
+            //  Changing a compact string moves it to the Unicode representation, keeping any ICU form already built
+            _ConstructedStringData* constructedStr = _compactUnicodeData(inst);
+            inst->u->CompactString._unicodeStr = NULL;
+            _compactStringDataFree(inst->u);
+
+            if (constructedStr->str != &str) {
+                constructedStr->str->setTo(str);
             }
 
+            inst->u = new stringData();
+            inst->u->ConstructedString.constructedStr = constructedStr;
+            inst->u->ConstructedString._hashIsCached = FALSE;
+            inst->u->ConstructedString._placementAllocated = FALSE;
+            inst->strType = NSConstructedString_Unicode;
+        } break;
+
         case NSConstructedString_Unicode:
             inst->u->ConstructedString._hashIsCached = FALSE;
 
@@ -231,6 +468,10 @@ void setToUnicode(NSString* inst, UnicodeString& str) {
             break;
 
         case NSUninitializedString:
+            if (_setToCompact(inst, str.getBuffer(), str.length())) {
+                break;
+            }
+
             inst->u = new stringData();
             if ([inst class] == [NSString class] || [inst class] == [NSMutableString class]) {
                 inst->u->ConstructedString.constructedStr = new _ConstructedStringData();
@@ -321,6 +562,10 @@ typedef NSUInteger NSStringCompareOptions;
  @Status Interoperable
 */
 - (instancetype)initWithCString:(const char*)cStr {
+    if (_setToCompact(self, cStr, strlen(cStr), false)) {
+        return self;
+    }
+
     UnicodeString str(cStr, strlen(cStr), US_INV);
 
     setToUnicode(self, str);
@@ -341,6 +586,10 @@ typedef NSUInteger NSStringCompareOptions;
  @Status Interoperable
 */
 - (instancetype)initWithCString:(const char*)cStr length:(DWORD)length {
+    if (_setToCompact(self, cStr, length, false)) {
+        return self;
+    }
+
     UnicodeString str(cStr, length, US_INV);
 
     setToUnicode(self, str);
@@ -351,6 +600,10 @@ typedef NSUInteger NSStringCompareOptions;
  @Status Interoperable
 */
 - (instancetype)initWithUTF8String:(const char*)utf8str {
+    if (_setToCompact(self, utf8str, strlen(utf8str), false)) {
+        return self;
+    }
+
     UnicodeString str = UnicodeString::fromUTF8(StringPiece(utf8str));
     setToUnicode(self, str);
 
@@ -383,6 +636,12 @@ typedef NSUInteger NSStringCompareOptions;
  @Status Interoperable
 */
 - (instancetype)initWithString:(NSString*)otherStr {
+    const char* bytes;
+    uint32_t length;
+    if (_compactBytes(otherStr, &bytes, &length) && _setToCompact(self, bytes, length, true)) {
+        return self;
+    }
+
     UStringHolder s1(otherStr);
     UnicodeString copy = s1.string();
 
@@ -529,6 +788,24 @@ typedef NSUInteger NSStringCompareOptions;
         length = [data length];
     }
 
+    switch (encoding) {
+        case NSUTF8StringEncoding:
+        case NSMacOSRomanStringEncoding:
+        case NSShiftJISStringEncoding:
+        case NSISOLatin2StringEncoding:
+        case NSASCIIStringEncoding:
+            if (_setToCompact(self, bytes, length, false)) {
+                return self;
+            }
+            break;
+
+        case NSISOLatin1StringEncoding:
+            if (_setToCompact(self, bytes, length, true)) {
+                return self;
+            }
+            break;
+    }
+
     UnicodeString uniStr;
 
     switch (encoding) {
@@ -614,6 +891,10 @@ typedef NSUInteger NSStringCompareOptions;
         case NSWindowsCP1252StringEncoding:
         case NSISOLatin1StringEncoding:
         case NSASCIIStringEncoding: {
+            if (_setToCompact(self, bytes, length, encoding == NSISOLatin1StringEncoding)) {
+                break;
+            }
+
             UnicodeString str(bytes, length, US_INV);
 
             setToUnicode(self, str);
@@ -621,6 +902,10 @@ typedef NSUInteger NSStringCompareOptions;
         }
 
         case NSUTF8StringEncoding: {
+            if (_setToCompact(self, bytes, length, false)) {
+                break;
+            }
+
             UnicodeString str(UnicodeString::fromUTF8(StringPiece((char*)bytes, length)));
             setToUnicode(self, str);
             break;
@@ -1036,6 +1321,13 @@ typedef NSUInteger NSStringCompareOptions;
         case NSShiftJISStringEncoding:
         case NSMacOSRomanStringEncoding:
         case NSUTF8StringEncoding: {
+            //  ASCII is the same in all of these, and compact storage is already NUL terminated
+            const char* compactBytes;
+            uint32_t compactLength;
+            if (_compactBytes(self, &compactBytes, &compactLength) && u->CompactString._isASCII) {
+                return compactBytes;
+            }
+
             UStringHolder s1(self);
 
             int len = s1.string().length();
@@ -1050,8 +1342,10 @@ typedef NSUInteger NSStringCompareOptions;
                 remainingRange:NULL];
 
             if ((object_getClass(self) == [NSString class] || object_getClass(self) == [CFConstantString class]) &&
-                strType == NSConstructedString_Unicode) {
-                if (u->ConstructedString.constructedStr->utf8String == NULL) {
+                (strType == NSConstructedString_Unicode || strType == NSConstructedString_Compact)) {
+                _ConstructedStringData* constructedStr =
+                    strType == NSConstructedString_Compact ? _compactUnicodeData(self) : u->ConstructedString.constructedStr;
+                if (constructedStr->utf8String == NULL) {
                     char* pData = (char*)IwMalloc(numBytes + 1);
                     [self getBytes:pData
                              maxLength:numBytes
@@ -1061,10 +1355,10 @@ typedef NSUInteger NSStringCompareOptions;
                                  range:NSMakeRange(0, len)
                         remainingRange:NULL];
                     pData[numBytes] = 0;
-                    u->ConstructedString.constructedStr->utf8String = pData;
+                    constructedStr->utf8String = pData;
                 }
 
-                return u->ConstructedString.constructedStr->utf8String;
+                return constructedStr->utf8String;
             } else {
                 char* pData = (char*)_conversionTempStr(numBytes + 1);
                 [self getBytes:pData
@@ -1142,6 +1436,12 @@ typedef NSUInteger NSStringCompareOptions;
         }
     }
 
+    const char* compactBytes;
+    uint32_t compactLength;
+    if (_compactBytes(self, &compactBytes, &compactLength) && u->CompactString._isASCII) {
+        return compactBytes;
+    }
+
     return (const char*)[self cStringUsingEncoding:NSUTF8StringEncoding];
 }
 
@@ -1304,6 +1604,16 @@ typedef NSUInteger NSStringCompareOptions;
  @Status Interoperable
 */
 - (void)getCharacters:(unsigned short*)dest range:(NSRange)range {
+    const char* bytes;
+    uint32_t length;
+    if (_compactBytes(self, &bytes, &length)) {
+        assert(range.location + range.length <= length);
+        for (NSUInteger i = 0; i < range.length; i++) {
+            dest[i] = (uint8_t)bytes[range.location + i];
+        }
+        return;
+    }
+
     UStringHolder s1(self, range.location, range.length);
 
     assert(range.length <= (DWORD)s1.string().length());
@@ -1438,6 +1748,13 @@ typedef NSUInteger NSStringCompareOptions;
  @Status Interoperable
 */
 - (UChar)characterAtIndex:(unsigned)index {
+    const char* bytes;
+    uint32_t length;
+    if (_compactBytes(self, &bytes, &length)) {
+        assert(index < length);
+        return (uint8_t)bytes[index];
+    }
+
     UStringHolder s1(self);
     DWORD len = s1.string().length();
     const UChar* chars = s1.string().getBuffer();
@@ -1673,6 +1990,12 @@ typedef NSUInteger NSStringCompareOptions;
  @Status Interoperable
 */
 - (unsigned)length {
+    const char* bytes;
+    uint32_t length;
+    if (_compactBytes(self, &bytes, &length)) {
+        return length;
+    }
+
     UStringHolder s1(self);
 
     return s1.string().length();
@@ -1694,11 +2017,13 @@ typedef NSUInteger NSStringCompareOptions;
 
     if (object_getClass(compStr) == [NSString class] || object_getClass(compStr) == [CFConstantString class] ||
         [compStr isKindOfClass:[NSString class]]) {
-        if (strType == NSConstructedString_Unicode && u->ConstructedString._hashIsCached == TRUE &&
-            compStr->strType == NSConstructedString_Unicode && compStr->u->ConstructedString._hashIsCached == TRUE) {
-            if (u->ConstructedString._hashCache != compStr->u->ConstructedString._hashCache) {
-                return FALSE;
-            }
+        if (_cachedHashesDiffer(self, compStr)) {
+            return FALSE;
+        }
+
+        BOOL equal;
+        if (_compactEquals(self, compStr, &equal)) {
+            return equal;
         }
 
         UStringHolder s1(self);
@@ -1788,6 +2113,18 @@ typedef NSUInteger NSStringCompareOptions;
     }
 
     if (options == 0) {
+        const char *bytes, *otherBytes;
+        uint32_t length, otherLength;
+        if (_compactBytes(self, &bytes, &length) && _compactBytes(compStrAddr, &otherBytes, &otherLength)) {
+            //  Latin-1 bytes order the same way as the UTF-16 code units they stand for
+            assert(range.location + range.length <= length);
+            int result = memcmp(bytes + range.location, otherBytes, std::min<NSUInteger>(range.length, otherLength));
+            if (result == 0) {
+                result = (range.length > otherLength) - (range.length < otherLength);
+            }
+            return (result > 0) - (result < 0);
+        }
+
         UStringHolder s1(self, range.location, range.length);
         UStringHolder s2(compStrAddr);
 
@@ -1923,11 +2260,13 @@ typedef NSUInteger NSStringCompareOptions;
 
     if (object_getClass(objAddr) == [NSString class] || object_getClass(objAddr) == [NSMutableString class] ||
         object_getClass(objAddr) == [CFConstantString class]) {
-        if (strType == NSConstructedString_Unicode && u->ConstructedString._hashIsCached == TRUE &&
-            objAddr->strType == NSConstructedString_Unicode && objAddr->u->ConstructedString._hashIsCached == TRUE) {
-            if (u->ConstructedString._hashCache != objAddr->u->ConstructedString._hashCache) {
-                return FALSE;
-            }
+        if (_cachedHashesDiffer(self, objAddr)) {
+            return FALSE;
+        }
+
+        BOOL equal;
+        if (_compactEquals(self, objAddr, &equal)) {
+            return equal;
         }
 
         UStringHolder s1(self);
@@ -2804,16 +3143,26 @@ static unichar PickWord(unichar c) {
  @Status Interoperable
 */
 - (unsigned)hash {
-    if (strType == NSConstructedString_Unicode && u->ConstructedString._hashIsCached) {
-        return u->ConstructedString._hashCache;
+    uint32_t hash;
+    if (_cachedHash(self, &hash)) {
+        return hash;
+    }
+
+    const char* bytes;
+    uint32_t length;
+    if (_compactBytes(self, &bytes, &length)) {
+        hash = _hashCodeUnits(bytes, length);
+        u->CompactString._hashCache = hash;
+        __atomic_store_n(&u->CompactString._hashIsCached, TRUE, __ATOMIC_RELEASE);
+        return hash;
     }
 
     UStringHolder s1(self);
 
-    DWORD hash = s1.string().hashCode();
+    hash = _hashCodeUnits(s1.string().getBuffer(), s1.string().length());
     if (strType == NSConstructedString_Unicode) {
-        u->ConstructedString._hashIsCached = TRUE;
         u->ConstructedString._hashCache = hash;
+        __atomic_store_n(&u->ConstructedString._hashIsCached, TRUE, __ATOMIC_RELEASE);
     }
 
     return hash;
@@ -3225,6 +3574,10 @@ const int s_oneByte = 16;
                 u->ConstructedString.constructedStr = NULL;
             }
             break;
+
+        case NSConstructedString_Compact:
+            _compactStringDataFree(u);
+            break;
     }
 
     [super dealloc];
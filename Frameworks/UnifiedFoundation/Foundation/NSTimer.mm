@@ -66,6 +66,10 @@ static const wchar_t* TAG = L"NSTimer";
     [_addedToModes removeObject:runLoopState];
 }
 
+- (double)_fireTime {
+    return _nextFireTime;
+}
+
 /**
  @Status Interoperable
 */
@@ -267,6 +271,10 @@ static const wchar_t* TAG = L"NSTimer";
 */
 - (void)setFireDate:(NSDate*)date {
     _nextFireTime = [date timeIntervalSinceReferenceDate];
+
+    for (CFIndex i = 0; i < CFArrayGetCount((CFArrayRef)_addedToModes); i++) {
+        [(NSRunLoopState*)CFArrayGetValueAtIndex((CFArrayRef)_addedToModes, i) _timerFireDateChanged:self];
+    }
 }
 
 /**
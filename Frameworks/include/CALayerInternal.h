@@ -84,12 +84,32 @@ public:
     BOOL didLayout;
     BOOL alwaysLayout;
 
+    //  Set when some layer below this one needs layout or display, so the layout and display passes only descend
+    //  into dirty subtrees.  A set bit implies the bit is also set on every ancestor.
+    BOOL descendantNeedsLayout;
+    BOOL descendantNeedsDisplay;
+
     CALayer* maskLayer;
 
     DisplayTexture* _textureOverride;
 
     CAPrivateInfo(CALayer* self, bool bPresentationLayer = false);
     ~CAPrivateInfo();
+
+    void markNeedsLayout();
+    void markNeedsDisplay();
+    void markHasNewContents();
+    void propagateDirtyToAncestors();
+};
+
+//  Work done by the layout and display passes since the counters were last reset
+struct CALayerPassStatistics {
+    unsigned layoutPasses;
+    unsigned layoutNodesVisited;
+    unsigned layoutsPerformed;
+    unsigned displayPasses;
+    unsigned displayNodesVisited;
+    unsigned displaysPerformed;
 };
 
 @interface CALayer (Internal)
@@ -121,6 +141,9 @@ public:
 
 - (CAPrivateInfo*)_priv;
 
++ (CALayerPassStatistics)_passStatistics;
++ (void)_resetPassStatistics;
+
 @end
 
 #endif /* _CALAYERPRIVATE_H_ */
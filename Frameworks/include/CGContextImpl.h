@@ -159,6 +159,7 @@ public:
     virtual CGSize CGFontDrawGlyphsToContext(WORD* glyphs, DWORD length, float x, float y);
 };
 
-#define LOCK_CAIRO() EbrLockEnter(_cairoLock);
-#define UNLOCK_CAIRO() EbrLockLeave(_cairoLock);
-extern EbrLock _cairoLock;
+// Taken around every use of the cairo state. The lock belongs to the destination image rather than the process, so
+// contexts drawing into different images render in parallel; see CGImageBacking::LockForDrawing.
+#define LOCK_CAIRO() _imgDest->Backing()->LockForDrawing();
+#define UNLOCK_CAIRO() _imgDest->Backing()->UnlockForDrawing();
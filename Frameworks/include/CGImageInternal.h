@@ -39,11 +39,26 @@ class CGImageBacking {
 protected:
     int _imageLocks;
     int _cairoLocks;
+    EbrLock _drawingLock;
 
 public:
     CGImageRef _parent;
 
+    CGImageBacking() : _drawingLock(EBRLOCK_INITIALIZE) {
+    }
+
     virtual ~CGImageBacking() {
+        if (_drawingLock != EBRLOCK_INITIALIZE) {
+            EbrLockDestroy(_drawingLock);
+        }
+    }
+
+    // Serializes the drawing contexts that render into this image. Recursive, and created on first use.
+    void LockForDrawing() {
+        EbrLockEnter(_drawingLock);
+    }
+    void UnlockForDrawing() {
+        EbrLockLeave(_drawingLock);
     }
 
     virtual CGImageRef Copy() = 0;
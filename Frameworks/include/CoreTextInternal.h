@@ -33,6 +33,7 @@
 @interface _CTFrameSetter : NSObject {
 @public
     idretaintype(_CTTypesetter) _typesetter;
+    NSUInteger _contentHash;
 }
 @end
 
@@ -116,4 +117,26 @@ struct _CTParagraphStyleProperties {
 typedef float (*WidthFinderFunc)(void* opaque, CFIndex idx, float offset, float height);
 
 CORETEXT_EXPORT CFIndex _CTTypesetterSuggestLineBreakWithOffsetAndCallback(
-    CTTypesetterRef ts, CFIndex index, double offset, WidthFinderFunc callback, void* opaque);
\ No newline at end of file
+    CTTypesetterRef ts, CFIndex index, double offset, WidthFinderFunc callback, void* opaque);
+
+// Counters for the cache of line breaks CTFramesetter keeps, keyed by attributed string content and frame width.
+struct _CTFramesetterCacheStatistics {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t count;
+    size_t capacity;
+};
+
+CORETEXT_EXPORT void _CTFramesetterGetCacheStatistics(_CTFramesetterCacheStatistics* statistics);
+CORETEXT_EXPORT void _CTFramesetterSetCacheCapacity(size_t capacity);
+CORETEXT_EXPORT void _CTFramesetterResetCache();
+// Shared cache of FreeType glyph metrics, keyed by (sizing face, pixel size, glyph index). Values are 26.6 fixed point, as
+// FreeType reports them. Safe to call from any thread.
+struct _CTGlyphLineMetrics {
+    int32_t ascender;
+    int32_t descender;
+};
+
+void _CTGlyphCacheGetAdvancesForCharacters(
+    id font, const WORD* characters, CFIndex count, int32_t* advances, _CTGlyphLineMetrics* lineMetrics);
@@ -161,6 +161,7 @@ public:
 
         withChild->prevSibling = prev;
         withChild->nextSibling = next;
+        withChild->parent = static_cast<T*>(this);
 
         if (prev)
             prev->nextSibling = withChild;
@@ -16,6 +16,7 @@
 #pragma once
 
 #import "NSInputSource.h"
+#import <Foundation/NSTimer.h>
 
 #define MAX_WAITSIGNALS 128
 #define MAX_WAITSOCKETS 128
@@ -31,7 +32,7 @@
     id _waitSocketObjects[MAX_WAITSOCKETS];
     int _numWaitSockets;
 
-    idt(NSMutableArray) _timers;
+    struct NSRunLoopTimerQueue* _timerQueue;
     idt(NSMutableArray) _observers;
     idt(NSInputSource) _cancelSource;
     int _starveCount;
@@ -48,6 +49,7 @@
 - (void)addObserver:(NSTimer*)observer;
 - (void)removeObserver:(NSObject*)observer;
 - (void)removeTimer:(NSTimer*)timer;
+- (void)_timerFireDateChanged:(NSTimer*)timer;
 - (void)changingIntoMode:(NSString*)mode;
 - (void)_notifyObservers:(uint32_t)mode;
 - (void)checkHighPriorityEvents;
@@ -59,3 +61,9 @@
 - (void)acceptInputForMode:(NSString*)mode beforeDate:(NSDate*)date;
 - (NSString*)description;
 @end
+
+@interface NSTimer (NSRunLoopState)
+- (void)_addedToMode:(NSRunLoopState*)runLoopState;
+- (void)_removedFromMode:(NSRunLoopState*)runLoopState;
+- (double)_fireTime;
+@end
@@ -14,14 +14,22 @@
 //
 //******************************************************************************
 
+#pragma once
+
+#import <Foundation/NSObject.h>
+
+@class NSDate;
+
+//  Objects added to a select set answer -descriptor; a set holds at most one object per descriptor. Registrations are
+//  kept between waits, so a set can be reused for every wait on the same sockets.
+FOUNDATION_EXPORT_CLASS
 @interface NSSelectSet : NSObject {
 @public
-    id _readSet;
-    id _writeSet;
-    id _exceptionSet;
+    struct NSSelectSetRegistrations* _registrations;
 }
 - (void)dealloc;
 - (BOOL)isEmpty;
+- (NSUInteger)count;
 - (BOOL)containsObjectForRead:(id)object;
 - (BOOL)containsObjectForWrite:(id)object;
 - (BOOL)containsObjectForException:(id)object;
@@ -29,5 +37,9 @@
 - (id)addObjectForRead:(id)object;
 - (id)addObjectForWrite:(id)object;
 - (id)addObjectForException:(id)object;
-- (id)waitForSelectWithOutputSet:(id*)outputSetX beforeDate:(id)beforeDate;
+- (void)removeObjectForRead:(id)object;
+- (void)removeObjectForWrite:(id)object;
+- (void)removeObjectForException:(id)object;
+- (void)removeAllObjects;
+- (id)waitForSelectWithOutputSet:(NSSelectSet**)outputSetX beforeDate:(NSDate*)beforeDate;
 @end
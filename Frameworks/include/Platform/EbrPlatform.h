@@ -114,6 +114,10 @@ IWPLATFORM_EXPORT int EbrLseek(int fd, off_t pos, int whence);
 IWPLATFORM_EXPORT int EbrTruncate(int fd, off_t size);
 IWPLATFORM_EXPORT int EbrDup(int fd);
 
+// Maps size bytes of fd, starting at offset, read-only. The mapping remains valid after fd is closed, until EbrMunmap.
+IWPLATFORM_EXPORT void* EbrMmap(int fd, size_t size, uint32_t offset);
+IWPLATFORM_EXPORT int EbrMunmap(void* addr, size_t size);
+
 IWPLATFORM_EXPORT bool EbrRename(const char* path1, const char* path2);
 IWPLATFORM_EXPORT bool EbrUnlink(const char* path);
 IWPLATFORM_EXPORT bool EbrMkdir(const char* path);
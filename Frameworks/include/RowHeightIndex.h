@@ -0,0 +1,164 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <vector>
+
+// Heights of a list of rows, with running offsets kept in a Fenwick tree so that the offset of a row and the row at an
+// offset are both found in O(log n), and a single height can be changed in O(log n).
+//
+// Inserting or removing rows only edits the height array; the tree is rebuilt in O(n) by the next query, so a batch of
+// edits pays for one rebuild. A height can be stored as an estimate, in which case isResolved() reports false until the
+// real height is set.
+class RowHeightIndex {
+public:
+    RowHeightIndex() : _treeValid(false), _unresolvedCount(0) {
+    }
+
+    int count() const {
+        return (int)_heights.size();
+    }
+
+    int unresolvedCount() const {
+        return _unresolvedCount;
+    }
+
+    void reset(int count, float height, bool resolved) {
+        _heights.assign(count, height);
+        _resolved.assign(count, resolved ? 1 : 0);
+        _unresolvedCount = resolved ? 0 : count;
+        _treeValid = false;
+    }
+
+    float height(int row) const {
+        assert(row >= 0 && row < count());
+        return _heights[row];
+    }
+
+    bool isResolved(int row) const {
+        assert(row >= 0 && row < count());
+        return _resolved[row] != 0;
+    }
+
+    void setHeight(int row, float height, bool resolved = true) {
+        assert(row >= 0 && row < count());
+        if (_treeValid) {
+            double delta = (double)height - _heights[row];
+            for (int i = row + 1; i <= count(); i += i & -i) {
+                _tree[i] += delta;
+            }
+        }
+        _heights[row] = height;
+        setResolved(row, resolved);
+    }
+
+    void insert(int row, float height, bool resolved) {
+        assert(row >= 0 && row <= count());
+        _heights.insert(_heights.begin() + row, height);
+        _resolved.insert(_resolved.begin() + row, resolved ? 1 : 0);
+        if (!resolved) {
+            _unresolvedCount++;
+        }
+        _treeValid = false;
+    }
+
+    void remove(int row) {
+        assert(row >= 0 && row < count());
+        if (!_resolved[row]) {
+            _unresolvedCount--;
+        }
+        _heights.erase(_heights.begin() + row);
+        _resolved.erase(_resolved.begin() + row);
+        _treeValid = false;
+    }
+
+    // Sum of the heights of the rows before row; offsetOf(count()) is the height of the whole list
+    float offsetOf(int row) const {
+        assert(row >= 0 && row <= count());
+        buildTree();
+
+        double offset = 0.0;
+        for (int i = row; i > 0; i -= i & -i) {
+            offset += _tree[i];
+        }
+        return (float)offset;
+    }
+
+    float totalHeight() const {
+        return offsetOf(count());
+    }
+
+    // The row whose extent contains offset. Offsets before the first row map to row 0 and offsets past the end map to
+    // the last row; rows of zero height are never returned unless every row at that offset is empty.
+    int rowAtOffset(float offset) const {
+        int rowCount = count();
+        if (rowCount == 0 || offset <= 0.0f) {
+            return 0;
+        }
+        buildTree();
+
+        int step = 1;
+        while (step * 2 <= rowCount) {
+            step *= 2;
+        }
+
+        // Find the number of rows that end at or before offset by descending the tree from its largest span
+        int pos = 0;
+        double remaining = offset;
+        for (; step > 0; step /= 2) {
+            if (pos + step <= rowCount && _tree[pos + step] <= remaining) {
+                pos += step;
+                remaining -= _tree[pos];
+            }
+        }
+
+        return pos < rowCount ? pos : rowCount - 1;
+    }
+
+private:
+    void setResolved(int row, bool resolved) {
+        if (_resolved[row] != (resolved ? 1 : 0)) {
+            _unresolvedCount += resolved ? -1 : 1;
+            _resolved[row] = resolved ? 1 : 0;
+        }
+    }
+
+    void buildTree() const {
+        if (_treeValid) {
+            return;
+        }
+
+        int rowCount = count();
+        _tree.assign(rowCount + 1, 0.0);
+        for (int i = 1; i <= rowCount; i++) {
+            _tree[i] += _heights[i - 1];
+            int next = i + (i & -i);
+            if (next <= rowCount) {
+                _tree[next] += _tree[i];
+            }
+        }
+        _treeValid = true;
+    }
+
+    std::vector<float> _heights;
+    std::vector<uint8_t> _resolved;
+    mutable std::vector<double> _tree;
+    mutable bool _treeValid;
+    int _unresolvedCount;
+};
@@ -68,6 +68,8 @@ typedef union {
 	struct dispatch_source_s *_ds;
 	struct dispatch_source_attr_s *_dsa;
 	struct dispatch_semaphore_s *_dsema;
+	struct dispatch_data_s *_ddata;
+	struct dispatch_io_s *_dchannel;
 } dispatch_object_t __attribute__((transparent_union));
 
 DISPATCH_INLINE dispatch_object_t as_do(dispatch_object_t do_)
@@ -84,6 +86,8 @@ typedef union {
 	struct dispatch_source_s *_ds;
 	struct dispatch_source_attr_s *_dsa;
 	struct dispatch_semaphore_s *_dsema;
+	struct dispatch_data_s *_ddata;
+	struct dispatch_io_s *_dchannel;
 } dispatch_object_t;
 
 DISPATCH_INLINE dispatch_object_t as_do(void* v)
@@ -57,6 +57,8 @@
 #include <dispatch/source.h>
 #include <dispatch/group.h>
 #include <dispatch/semaphore.h>
+#include <dispatch/data.h>
+#include <dispatch/io.h>
 #include <dispatch/once.h>
 #include <dispatch/interop.h>
 
@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) 2009-2011 Apple Inc. All rights reserved.
+ *
+ * @APPLE_APACHE_LICENSE_HEADER_START@
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @APPLE_APACHE_LICENSE_HEADER_END@
+ */
+
+#include "internal.h"
+
+// Dispatch data objects are dispatch objects with standard retain/release
+// memory management. A dispatch data object either points to a number of other
+// dispatch data objects or is a leaf data object. A leaf data object contains
+// a pointer to represented memory and a destructor for it. Composite objects
+// keep a flat array of ranges of leaves, so concatenation, subranges and
+// lookups never copy bytes and never walk a tree. Adjacent ranges of the same
+// leaf are merged, which keeps the common "split, then concat back" patterns of
+// dispatch I/O at a single record.
+
+static void _dispatch_data_dispose(dispatch_data_t dd);
+static size_t _dispatch_data_debug(dispatch_data_t dd, char* buf, size_t bufsiz);
+
+const struct dispatch_data_vtable_s _dispatch_data_vtable = {
+	/*.do_type    = */	DISPATCH_DATA_TYPE,
+	/*.do_kind    = */	"data",
+	/*.do_debug   = */	_dispatch_data_debug,
+	/*.do_invoke  = */	0,
+	/*.do_probe   = */	0,
+	/*.do_dispose = */	_dispatch_data_dispose,
+};
+
+struct dispatch_data_s _dispatch_data_empty = {
+	/*.do_vtable   = */	&_dispatch_data_vtable,
+	/*.do_next     = */	DISPATCH_OBJECT_LISTLESS,
+	/*.do_ref_cnt  = */	DISPATCH_OBJECT_GLOBAL_REFCNT,
+	/*.do_xref_cnt = */	DISPATCH_OBJECT_GLOBAL_REFCNT,
+};
+
+#ifdef __BLOCKS__
+const dispatch_block_t _dispatch_data_destructor_free = ^{
+	DISPATCH_CRASH("free destructor called");
+};
+#endif
+
+static dispatch_data_t
+_dispatch_data_alloc(size_t n)
+{
+	dispatch_data_t dd;
+
+	while (!(dd = calloc(1, sizeof(struct dispatch_data_s) + n * sizeof(dispatch_data_record_s)))) {
+		sleep(1);
+	}
+	dd->do_vtable = &_dispatch_data_vtable;
+	dd->do_next = DISPATCH_OBJECT_LISTLESS;
+	dd->do_ref_cnt = 1;
+	dd->do_xref_cnt = 1;
+	dd->do_targetq = dispatch_get_global_queue(0, 0);
+	return dd;
+}
+
+static void
+_dispatch_data_destroy_buffer(dispatch_queue_t queue, dispatch_function_t destructor, void *ctxt)
+{
+	if (queue) {
+		dispatch_async_f(queue, ctxt, destructor);
+	} else {
+		destructor(ctxt);
+	}
+}
+
+static dispatch_data_t
+_dispatch_data_create_leaf(const void *buffer, size_t size, dispatch_queue_t queue,
+	dispatch_function_t destructor, void *ctxt)
+{
+	dispatch_data_t dd;
+
+	if (!buffer || !size) {
+		// Empty data requested so return the singleton empty object. Call the
+		// destructor immediately to release any unused storage.
+		if (destructor) {
+			_dispatch_data_destroy_buffer(queue, destructor, ctxt);
+		}
+		return dispatch_data_empty;
+	}
+	if (!destructor) {
+		void *copy;
+
+		while (!(copy = malloc(size))) {
+			sleep(1);
+		}
+		memcpy(copy, buffer, size);
+		buffer = copy;
+		destructor = free;
+		ctxt = copy;
+		queue = NULL;
+	}
+	dd = _dispatch_data_alloc(0);
+	dd->size = size;
+	dd->buf = buffer;
+	dd->destructor = destructor;
+	dd->destructor_ctxt = ctxt;
+	if (queue) {
+		dispatch_retain(as_do(queue));
+		dd->destructor_queue = queue;
+	}
+	return dd;
+}
+
+#ifdef __BLOCKS__
+dispatch_data_t
+dispatch_data_create(const void *buffer, size_t size, dispatch_queue_t queue,
+	dispatch_block_t destructor)
+{
+	if (destructor == DISPATCH_DATA_DESTRUCTOR_DEFAULT) {
+		return _dispatch_data_create_leaf(buffer, size, NULL, NULL, NULL);
+	}
+	if (destructor == DISPATCH_DATA_DESTRUCTOR_FREE) {
+		return _dispatch_data_create_leaf(buffer, size, NULL, free, (void *)buffer);
+	}
+	return _dispatch_data_create_leaf(buffer, size, queue,
+		_dispatch_call_block_and_release, _dispatch_Block_copy(destructor));
+}
+#endif
+
+dispatch_data_t
+dispatch_data_create_f(const void *buffer, size_t size, dispatch_queue_t queue,
+	dispatch_function_t destructor)
+{
+	return _dispatch_data_create_leaf(buffer, size, queue, destructor, (void *)buffer);
+}
+
+dispatch_data_t
+_dispatch_data_create_with_buffer(void *buf, size_t size)
+{
+	return _dispatch_data_create_leaf(buf, size, NULL, free, buf);
+}
+
+static void
+_dispatch_data_dispose(dispatch_data_t dd)
+{
+	size_t i;
+
+	if (_dispatch_data_is_leaf(dd)) {
+		_dispatch_data_destroy_buffer(dd->destructor_queue, dd->destructor, dd->destructor_ctxt);
+		if (dd->destructor_queue) {
+			dispatch_release(as_do(dd->destructor_queue));
+		}
+	} else {
+		for (i = 0; i < dd->num_records; ++i) {
+			dispatch_release(as_do(dd->records[i].data_object));
+		}
+	}
+	_dispatch_dispose(as_do(dd));
+}
+
+static size_t
+_dispatch_data_debug(dispatch_data_t dd, char* buf, size_t bufsiz)
+{
+	size_t offset = 0;
+
+	offset += snprintf(&buf[offset], bufsiz - offset, "%s[%p] = { ", dx_kind(dd), dd);
+	offset += dispatch_object_debug_attr(as_do(dd), &buf[offset], bufsiz - offset);
+	if (_dispatch_data_is_leaf(dd)) {
+		offset += snprintf(&buf[offset], bufsiz - offset, "leaf, size = %zu, buf = %p }",
+			dd->size, dd->buf);
+	} else {
+		offset += snprintf(&buf[offset], bufsiz - offset, "composite, size = %zu, num_records = %zu }",
+			dd->size, dd->num_records);
+	}
+	return offset;
+}
+
+size_t
+dispatch_data_get_size(dispatch_data_t dd)
+{
+	return dd->size;
+}
+
+// Appends a range of a leaf to a composite object being built, merging it with
+// the previous record when the two are adjacent in the same leaf.
+static void
+_dispatch_data_append(dispatch_data_t dd, dispatch_data_t leaf, size_t from, size_t length)
+{
+	dispatch_data_record_s *r;
+
+	if (dd->num_records) {
+		r = &dd->records[dd->num_records - 1];
+		if (r->data_object == leaf && r->from + r->length == from) {
+			r->length += length;
+			dd->size += length;
+			return;
+		}
+	}
+	dispatch_retain(as_do(leaf));
+	r = &dd->records[dd->num_records++];
+	r->data_object = leaf;
+	r->from = from;
+	r->length = length;
+	dd->size += length;
+}
+
+// Appends the range [offset, offset + length) of any data object.
+static void
+_dispatch_data_append_range(dispatch_data_t dd, dispatch_data_t src, size_t offset, size_t length)
+{
+	size_t i, from, len;
+
+	if (_dispatch_data_is_leaf(src)) {
+		_dispatch_data_append(dd, src, offset, length);
+		return;
+	}
+	for (i = 0; i < src->num_records && length; ++i) {
+		len = src->records[i].length;
+		if (offset >= len) {
+			offset -= len;
+			continue;
+		}
+		from = src->records[i].from + offset;
+		len -= offset;
+		if (len > length) {
+			len = length;
+		}
+		_dispatch_data_append(dd, src->records[i].data_object, from, len);
+		offset = 0;
+		length -= len;
+	}
+}
+
+// A composite that ended up covering exactly one whole leaf is that leaf.
+static dispatch_data_t
+_dispatch_data_collapse(dispatch_data_t dd)
+{
+	dispatch_data_t leaf;
+
+	if (dd->num_records == 1) {
+		leaf = dd->records[0].data_object;
+		if (dd->records[0].from == 0 && dd->records[0].length == leaf->size) {
+			dispatch_retain(as_do(leaf));
+			dispatch_release(as_do(dd));
+			return leaf;
+		}
+	}
+	return dd;
+}
+
+#define _dispatch_data_num_records(dd) \
+	(_dispatch_data_is_leaf(dd) ? 1 : (dd)->num_records)
+
+dispatch_data_t
+dispatch_data_create_concat(dispatch_data_t dd1, dispatch_data_t dd2)
+{
+	dispatch_data_t dd;
+
+	if (!dd1->size) {
+		dispatch_retain(as_do(dd2));
+		return dd2;
+	}
+	if (!dd2->size) {
+		dispatch_retain(as_do(dd1));
+		return dd1;
+	}
+	dd = _dispatch_data_alloc(_dispatch_data_num_records(dd1) + _dispatch_data_num_records(dd2));
+	_dispatch_data_append_range(dd, dd1, 0, dd1->size);
+	_dispatch_data_append_range(dd, dd2, 0, dd2->size);
+	return _dispatch_data_collapse(dd);
+}
+
+dispatch_data_t
+dispatch_data_create_subrange(dispatch_data_t dd, size_t offset, size_t length)
+{
+	dispatch_data_t sub;
+	size_t i, n, skip, end;
+
+	if (offset >= dd->size || !length) {
+		return dispatch_data_empty;
+	}
+	if (length > dd->size - offset) {
+		length = dd->size - offset;
+	}
+	if (offset == 0 && length == dd->size) {
+		dispatch_retain(as_do(dd));
+		return dd;
+	}
+	n = 1;
+	if (!_dispatch_data_is_leaf(dd)) {
+		// count the records the range touches
+		n = 0;
+		skip = 0;
+		end = offset + length;
+		for (i = 0; i < dd->num_records && skip < end; ++i) {
+			if (skip + dd->records[i].length > offset) {
+				++n;
+			}
+			skip += dd->records[i].length;
+		}
+	}
+	sub = _dispatch_data_alloc(n);
+	_dispatch_data_append_range(sub, dd, offset, length);
+	return _dispatch_data_collapse(sub);
+}
+
+static bool
+_dispatch_data_copy_applier(void *ctxt, dispatch_data_t region DISPATCH_UNUSED,
+	size_t offset, const void *buffer, size_t size)
+{
+	memcpy((char *)ctxt + offset, buffer, size);
+	return true;
+}
+
+dispatch_data_t
+dispatch_data_create_map(dispatch_data_t dd, const void **buffer_ptr, size_t *size_ptr)
+{
+	const void *buffer = NULL;
+	void *copy;
+
+	if (!dd->size) {
+		dd = dispatch_data_empty;
+	} else if (_dispatch_data_is_leaf(dd)) {
+		dispatch_retain(as_do(dd));
+		buffer = dd->buf;
+	} else if (dd->num_records == 1) {
+		// a single range of a leaf is already contiguous
+		dispatch_retain(as_do(dd));
+		buffer = (const char *)dd->records[0].data_object->buf + dd->records[0].from;
+	} else {
+		while (!(copy = malloc(dd->size))) {
+			sleep(1);
+		}
+		dispatch_data_apply_f(dd, copy, _dispatch_data_copy_applier);
+		dd = _dispatch_data_create_with_buffer(copy, dd->size);
+		buffer = copy;
+	}
+	if (buffer_ptr) {
+		*buffer_ptr = buffer;
+	}
+	if (size_ptr) {
+		*size_ptr = dd->size;
+	}
+	return dd;
+}
+
+bool
+dispatch_data_apply_f(dispatch_data_t dd, void *ctxt, dispatch_data_applier_function_t applier)
+{
+	dispatch_data_record_s *r;
+	size_t i, offset = 0;
+
+	if (!dd->size) {
+		return true;
+	}
+	if (_dispatch_data_is_leaf(dd)) {
+		return applier(ctxt, dd, 0, dd->buf, dd->size);
+	}
+	for (i = 0; i < dd->num_records; ++i) {
+		r = &dd->records[i];
+		if (!applier(ctxt, r->data_object, offset,
+				(const char *)r->data_object->buf + r->from, r->length)) {
+			return false;
+		}
+		offset += r->length;
+	}
+	return true;
+}
+
+#ifdef __BLOCKS__
+static bool
+_dispatch_data_apply_block(void *ctxt, dispatch_data_t region, size_t offset,
+	const void *buffer, size_t size)
+{
+	dispatch_data_applier_t applier = ctxt;
+
+	return applier(region, offset, buffer, size);
+}
+
+bool
+dispatch_data_apply(dispatch_data_t dd, dispatch_data_applier_t applier)
+{
+	return dispatch_data_apply_f(dd, applier, _dispatch_data_apply_block);
+}
+#endif
+
+dispatch_data_t
+dispatch_data_copy_region(dispatch_data_t dd, size_t location, size_t *offset_ptr)
+{
+	dispatch_data_record_s *r;
+	size_t i, offset = 0;
+
+	if (location >= dd->size) {
+		*offset_ptr = dd->size;
+		return dispatch_data_empty;
+	}
+	if (_dispatch_data_is_leaf(dd)) {
+		*offset_ptr = 0;
+		dispatch_retain(as_do(dd));
+		return dd;
+	}
+	for (i = 0; i < dd->num_records; ++i) {
+		r = &dd->records[i];
+		if (location < offset + r->length) {
+			break;
+		}
+		offset += r->length;
+	}
+	*offset_ptr = offset;
+	return dispatch_data_create_subrange(r->data_object, r->from, r->length);
+}
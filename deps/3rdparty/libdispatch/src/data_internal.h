@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2009-2011 Apple Inc. All rights reserved.
+ *
+ * @APPLE_APACHE_LICENSE_HEADER_START@
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @APPLE_APACHE_LICENSE_HEADER_END@
+ */
+
+/*
+ * IMPORTANT: This header file describes INTERNAL interfaces to libdispatch
+ * which are subject to change in future releases of Mac OS X. Any applications
+ * relying on these interfaces WILL break.
+ */
+
+#ifndef __DISPATCH_DATA_INTERNAL__
+#define __DISPATCH_DATA_INTERNAL__
+
+struct dispatch_data_vtable_s {
+	DISPATCH_VTABLE_HEADER(dispatch_data_s);
+};
+
+// A range of bytes of a leaf object (one that owns a buffer). Composite
+// objects only ever reference leaves, so lookups never recurse.
+typedef struct dispatch_data_record_s {
+	dispatch_data_t data_object;
+	size_t from;
+	size_t length;
+} dispatch_data_record_s;
+
+struct dispatch_data_s {
+	DISPATCH_STRUCT_HEADER(dispatch_data_s, dispatch_data_vtable_s);
+	size_t size;
+	// leaf objects
+	const void *buf;
+	dispatch_function_t destructor;
+	void *destructor_ctxt;
+	dispatch_queue_t destructor_queue;
+	// composite objects; zero for leaves
+	size_t num_records;
+	dispatch_data_record_s records[];
+};
+
+#define _dispatch_data_is_leaf(dd) ((dd)->num_records == 0)
+
+extern const struct dispatch_data_vtable_s _dispatch_data_vtable;
+
+// Wraps a malloc()'d buffer without copying it; the buffer is freed with the
+// object. Never fails.
+dispatch_data_t _dispatch_data_create_with_buffer(void *buf, size_t size);
+
+#endif
@@ -45,6 +45,8 @@
 #include "dispatch/source.h"
 #include "dispatch/group.h"
 #include "dispatch/semaphore.h"
+#include "dispatch/data.h"
+#include "dispatch/io.h"
 #include "dispatch/once.h"
 #include "dispatch/interop.h"
 #include "dispatch/benchmark.h"
@@ -162,6 +164,8 @@ __private_extern__ struct _dispatch_hw_config_s {
 #include "queue_internal.h"
 #include "semaphore_internal.h"
 #include "source_internal.h"
+#include "data_internal.h"
+#include "io_internal.h"
 #include "interop_internal.h"
 
 #include "continuation_cache.h"
@@ -0,0 +1,1218 @@
+/*
+ * Copyright (c) 2009-2011 Apple Inc. All rights reserved.
+ *
+ * @APPLE_APACHE_LICENSE_HEADER_START@
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @APPLE_APACHE_LICENSE_HEADER_END@
+ */
+
+#include "internal.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#if TARGET_OS_WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// A channel owns a serial queue on which all of its state lives and all of its
+// I/O is issued. Reads and writes are kept in one FIFO with the barriers; the
+// first read and the first write that are not behind a barrier are active at
+// any time. An active operation is driven one chunk at a time by re-submitting
+// itself to the channel queue, so reads, writes, closes and the completion of
+// I/O handlers interleave. Data read is accumulated as dispatch data and handed
+// out as zero-copy subranges according to the channel's water marks; once an
+// operation has DISPATCH_IO_MAX_PENDING_SIZE bytes sitting in handlers that have
+// not returned yet, it stalls until they do.
+//
+// Regular files are read and written at explicit offsets. Other descriptors are
+// made non-blocking and wait on a read or write dispatch source when they
+// would block (except on Windows, see DISPATCH_IO_USE_SOURCES).
+
+typedef struct dispatch_io_delivery_s {
+	dispatch_io_op_t op;
+	dispatch_data_t data;
+	size_t size;
+	int err;
+	bool done;
+} *dispatch_io_delivery_t;
+
+typedef struct dispatch_io_cleanup_s {
+	dispatch_io_cleanup_function_t func;
+	void *ctxt;
+	int err;
+} *dispatch_io_cleanup_t;
+
+static void _dispatch_io_dispose(dispatch_io_t channel);
+static size_t _dispatch_io_debug(dispatch_io_t channel, char* buf, size_t bufsiz);
+static void _dispatch_io_schedule(dispatch_io_t channel);
+static void _dispatch_io_pump(dispatch_io_op_t op);
+static void _dispatch_io_pump_invoke(void *ctxt);
+
+const struct dispatch_io_vtable_s _dispatch_io_vtable = {
+	/*.do_type    = */	DISPATCH_IO_TYPE,
+	/*.do_kind    = */	"channel",
+	/*.do_debug   = */	_dispatch_io_debug,
+	/*.do_invoke  = */	0,
+	/*.do_probe   = */	0,
+	/*.do_dispose = */	_dispatch_io_dispose,
+};
+
+#if TARGET_OS_WIN32
+#define _dispatch_io_open_fd(path, oflag, mode)	_open((path), (oflag) | _O_BINARY, (mode))
+#define _dispatch_io_close_fd(fd)				_close(fd)
+#define _dispatch_io_seek(fd, off, whence)		_lseeki64((fd), (off), (whence))
+#else
+#define _dispatch_io_open_fd(path, oflag, mode)	open((path), (oflag), (mode))
+#define _dispatch_io_close_fd(fd)				close(fd)
+#define _dispatch_io_seek(fd, off, whence)		lseek((fd), (off_t)(off), (whence))
+#endif
+
+// Reads at an absolute offset, or at the current position if offset is -1
+static long
+_dispatch_io_read_fd(dispatch_fd_t fd, void *buf, size_t len, int64_t offset)
+{
+#if TARGET_OS_WIN32
+	if (offset != -1 && _lseeki64(fd, offset, SEEK_SET) == -1) {
+		return -1;
+	}
+	return _read(fd, buf, (unsigned int)len);
+#else
+	if (offset != -1) {
+		return (long)pread(fd, buf, len, (off_t)offset);
+	}
+	return (long)read(fd, buf, len);
+#endif
+}
+
+// Writes at an absolute offset, or at the current position if offset is -1
+static long
+_dispatch_io_write_fd(dispatch_fd_t fd, const void *buf, size_t len, int64_t offset)
+{
+#if TARGET_OS_WIN32
+	if (offset != -1 && _lseeki64(fd, offset, SEEK_SET) == -1) {
+		return -1;
+	}
+	return _write(fd, buf, (unsigned int)len);
+#else
+	if (offset != -1) {
+		return (long)pwrite(fd, buf, len, (off_t)offset);
+	}
+	return (long)write(fd, buf, len);
+#endif
+}
+
+// Takes control of the channel's descriptor
+static int
+_dispatch_io_init_fd(dispatch_io_t channel)
+{
+#if TARGET_OS_WIN32
+	struct _stat64 st;
+
+	if (_fstat64(channel->fd, &st) == -1) {
+		return errno;
+	}
+	channel->is_regular = (st.st_mode & _S_IFMT) == _S_IFREG;
+#else
+	struct stat st;
+
+	if (fstat(channel->fd, &st) == -1) {
+		return errno;
+	}
+	channel->is_regular = S_ISREG(st.st_mode);
+#endif
+	if (channel->type == DISPATCH_IO_RANDOM) {
+		channel->f_ptr = _dispatch_io_seek(channel->fd, 0, SEEK_CUR);
+		if (channel->f_ptr == -1) {
+			return ESPIPE;
+		}
+	}
+#if DISPATCH_IO_USE_SOURCES
+	if (!channel->is_regular) {
+		channel->fd_flags = fcntl(channel->fd, F_GETFL);
+		if (channel->fd_flags == -1) {
+			return errno;
+		}
+		if (!(channel->fd_flags & O_NONBLOCK)) {
+			(void)dispatch_assume_zero(fcntl(channel->fd, F_SETFL, channel->fd_flags | O_NONBLOCK));
+		}
+	}
+#endif
+	return 0;
+}
+
+static void
+_dispatch_io_call_cleanup(void *ctxt)
+{
+	dispatch_io_cleanup_t dc = ctxt;
+
+	dc->func(dc->ctxt, dc->err);
+	free(dc);
+}
+
+static void _dispatch_io_free(dispatch_io_t channel);
+
+// Hands the descriptor back (closing it if the channel opened it) and calls the
+// cleanup handler
+static void
+_dispatch_io_cleanup2(dispatch_io_t channel)
+{
+	dispatch_io_cleanup_t dc;
+
+	if (channel->fd != -1) {
+#if DISPATCH_IO_USE_SOURCES
+		if (!channel->is_regular && !(channel->fd_flags & O_NONBLOCK)) {
+			(void)fcntl(channel->fd, F_SETFL, channel->fd_flags);
+		}
+#endif
+		if (channel->owns_fd) {
+			(void)dispatch_assume_zero(_dispatch_io_close_fd(channel->fd));
+		}
+		channel->fd = -1;
+	}
+	if (channel->cleanup_func) {
+		while (!(dc = malloc(sizeof(*dc)))) {
+			sleep(1);
+		}
+		dc->func = channel->cleanup_func;
+		dc->ctxt = channel->cleanup_ctxt;
+		dc->err = channel->err;
+		dispatch_async_f(channel->cleanup_queue, dc, _dispatch_io_call_cleanup);
+		channel->cleanup_func = NULL;
+	}
+	if (channel->cleanup_queue) {
+		dispatch_release(as_do(channel->cleanup_queue));
+		channel->cleanup_queue = NULL;
+	}
+}
+
+#if DISPATCH_IO_USE_SOURCES
+// Cancel handler of the read and write sources; the descriptor must stay open
+// until both are unregistered
+static void
+_dispatch_io_source_canceled(void *ctxt)
+{
+	dispatch_io_t channel = ctxt;
+
+	if (--channel->sources_canceling) {
+		return;
+	}
+	_dispatch_io_cleanup2(channel);
+	if (channel->disposed) {
+		_dispatch_io_free(channel);
+	}
+}
+#endif
+
+// Closes the channel for good; runs once, on the channel queue
+static void
+_dispatch_io_cleanup(dispatch_io_t channel)
+{
+#if DISPATCH_IO_USE_SOURCES
+	unsigned long i;
+#endif
+
+	if (channel->cleaned_up) {
+		return;
+	}
+	channel->cleaned_up = true;
+	channel->closed = true;
+
+#if DISPATCH_IO_USE_SOURCES
+	for (i = 0; i < 2; ++i) {
+		if (channel->sources[i]) {
+			channel->sources_canceling++;
+		}
+	}
+	if (channel->sources_canceling) {
+		for (i = 0; i < 2; ++i) {
+			if (channel->sources[i]) {
+				dispatch_source_cancel(channel->sources[i]);
+				if (!channel->waiting[i]) {
+					// sources are kept suspended unless an operation waits on them
+					dispatch_resume(as_do(channel->sources[i]));
+				}
+				dispatch_release(as_do(channel->sources[i]));
+				channel->sources[i] = NULL;
+			}
+		}
+		return;
+	}
+#endif
+	_dispatch_io_cleanup2(channel);
+}
+
+static void
+_dispatch_io_maybe_cleanup(dispatch_io_t channel)
+{
+	if (channel->closed && channel->op_count == 0) {
+		_dispatch_io_cleanup(channel);
+	}
+}
+
+static void
+_dispatch_io_maybe_cleanup_invoke(void *ctxt)
+{
+	_dispatch_io_maybe_cleanup(ctxt);
+}
+
+static dispatch_io_t
+_dispatch_io_create(dispatch_io_type_t type, dispatch_queue_t queue,
+	void *ctxt, dispatch_io_cleanup_function_t cleanup_handler)
+{
+	dispatch_io_t channel;
+
+	if (type != DISPATCH_IO_STREAM && type != DISPATCH_IO_RANDOM) {
+		return NULL;
+	}
+	channel = calloc(1, sizeof(struct dispatch_io_s));
+	if (slowpath(!channel)) {
+		return NULL;
+	}
+	channel->do_vtable = &_dispatch_io_vtable;
+	channel->do_next = DISPATCH_OBJECT_LISTLESS;
+	channel->do_ref_cnt = 1;
+	channel->do_xref_cnt = 1;
+	channel->do_targetq = dispatch_get_global_queue(0, 0);
+	channel->queue = dispatch_queue_create("com.apple.libdispatch.io", NULL);
+	channel->type = type;
+	channel->fd = -1;
+	channel->high_water = SIZE_MAX;
+	if (cleanup_handler) {
+		channel->cleanup_queue = queue ? queue : dispatch_get_global_queue(0, 0);
+		dispatch_retain(as_do(channel->cleanup_queue));
+		channel->cleanup_func = cleanup_handler;
+		channel->cleanup_ctxt = ctxt;
+	}
+	return channel;
+}
+
+// A channel that failed to take control of its descriptor is closed right away
+// and reports the error to its cleanup handler.
+static void
+_dispatch_io_fail(dispatch_io_t channel, int err)
+{
+	channel->err = err;
+	channel->closed = true;
+	dispatch_async_f(channel->queue, channel, _dispatch_io_maybe_cleanup_invoke);
+}
+
+dispatch_io_t
+dispatch_io_create_f(dispatch_io_type_t type, dispatch_fd_t fd, dispatch_queue_t queue,
+	void *ctxt, dispatch_io_cleanup_function_t cleanup_handler)
+{
+	dispatch_io_t channel;
+	int err;
+
+	channel = _dispatch_io_create(type, queue, ctxt, cleanup_handler);
+	if (!channel) {
+		return NULL;
+	}
+	channel->fd = fd;
+	err = _dispatch_io_init_fd(channel);
+	if (err) {
+		channel->fd = -1;
+		_dispatch_io_fail(channel, err);
+	}
+	return channel;
+}
+
+dispatch_io_t
+dispatch_io_create_with_path_f(dispatch_io_type_t type, const char *path, int oflag,
+	mode_t mode, dispatch_queue_t queue, void *ctxt,
+	dispatch_io_cleanup_function_t cleanup_handler)
+{
+	dispatch_io_t channel;
+	size_t len;
+
+	channel = _dispatch_io_create(type, queue, ctxt, cleanup_handler);
+	if (!channel) {
+		return NULL;
+	}
+	len = strlen(path) + 1;
+	while (!(channel->path = malloc(len))) {
+		sleep(1);
+	}
+	memcpy(channel->path, path, len);
+	channel->oflag = oflag;
+	channel->mode = mode;
+	channel->owns_fd = true;
+	return channel;
+}
+
+#ifdef __BLOCKS__
+static void
+_dispatch_io_cleanup_block(void *ctxt, int err)
+{
+	void (^cleanup_handler)(int) = ctxt;
+
+	cleanup_handler(err);
+	Block_release(cleanup_handler);
+}
+
+dispatch_io_t
+dispatch_io_create(dispatch_io_type_t type, dispatch_fd_t fd, dispatch_queue_t queue,
+	void (^cleanup_handler)(int error))
+{
+	dispatch_io_t channel;
+
+	if (!cleanup_handler) {
+		return dispatch_io_create_f(type, fd, queue, NULL, NULL);
+	}
+	cleanup_handler = Block_copy(cleanup_handler);
+	channel = dispatch_io_create_f(type, fd, queue, cleanup_handler, _dispatch_io_cleanup_block);
+	if (!channel) {
+		Block_release(cleanup_handler);
+	}
+	return channel;
+}
+
+dispatch_io_t
+dispatch_io_create_with_path(dispatch_io_type_t type, const char *path, int oflag,
+	mode_t mode, dispatch_queue_t queue, void (^cleanup_handler)(int error))
+{
+	dispatch_io_t channel;
+
+	if (!cleanup_handler) {
+		return dispatch_io_create_with_path_f(type, path, oflag, mode, queue, NULL, NULL);
+	}
+	cleanup_handler = Block_copy(cleanup_handler);
+	channel = dispatch_io_create_with_path_f(type, path, oflag, mode, queue,
+		cleanup_handler, _dispatch_io_cleanup_block);
+	if (!channel) {
+		Block_release(cleanup_handler);
+	}
+	return channel;
+}
+#endif
+
+static void
+_dispatch_io_free(dispatch_io_t channel)
+{
+	free(channel->path);
+	dispatch_release(as_do(channel->queue));
+	_dispatch_dispose(as_do(channel));
+}
+
+static void
+_dispatch_io_dispose2(void *ctxt)
+{
+	dispatch_io_t channel = ctxt;
+
+	_dispatch_io_cleanup(channel);
+#if DISPATCH_IO_USE_SOURCES
+	if (channel->sources_canceling) {
+		// freed by _dispatch_io_source_canceled()
+		channel->disposed = true;
+		return;
+	}
+#endif
+	_dispatch_io_free(channel);
+}
+
+static void
+_dispatch_io_dispose(dispatch_io_t channel)
+{
+	// every operation holds a reference, so only the cleanup is left, and it
+	// must happen on the channel queue
+	dispatch_async_f(channel->queue, channel, _dispatch_io_dispose2);
+}
+
+static size_t
+_dispatch_io_debug(dispatch_io_t channel, char* buf, size_t bufsiz)
+{
+	size_t offset = 0;
+
+	offset += snprintf(&buf[offset], bufsiz - offset, "%s[%p] = { ", dx_kind(channel), channel);
+	offset += dispatch_object_debug_attr(as_do(channel), &buf[offset], bufsiz - offset);
+	offset += snprintf(&buf[offset], bufsiz - offset,
+		"type = %s, fd = %d, low_water = %zu, high_water = %zu, ops = %u%s }",
+		channel->type == DISPATCH_IO_RANDOM ? "random" : "stream", channel->fd,
+		channel->low_water, channel->high_water, channel->op_count,
+		channel->closed ? ", closed" : "");
+	return offset;
+}
+
+dispatch_fd_t
+dispatch_io_get_descriptor(dispatch_io_t channel)
+{
+	if (channel->closed) {
+		return -1;
+	}
+	return channel->fd;
+}
+
+static void
+_dispatch_io_set_high_water2(void *ctxt)
+{
+	dispatch_io_op_t op = ctxt;
+	dispatch_io_t channel = op->op_channel;
+
+	channel->high_water = op->op_length ? op->op_length : 1;
+	if (channel->low_water > channel->high_water) {
+		channel->low_water = channel->high_water;
+	}
+	free(op);
+}
+
+static void
+_dispatch_io_set_low_water2(void *ctxt)
+{
+	dispatch_io_op_t op = ctxt;
+	dispatch_io_t channel = op->op_channel;
+
+	channel->low_water = op->op_length;
+	if (channel->high_water < channel->low_water) {
+		channel->high_water = channel->low_water;
+	}
+	free(op);
+}
+
+// Policy changes are ordered with the operations submitted around them; the
+// operation structure merely carries the value to the channel queue.
+static void
+_dispatch_io_set_policy(dispatch_io_t channel, size_t value, dispatch_function_t func)
+{
+	dispatch_io_op_t op;
+
+	while (!(op = calloc(1, sizeof(struct dispatch_io_op_s)))) {
+		sleep(1);
+	}
+	op->op_channel = channel;
+	op->op_length = value;
+	dispatch_async_f(channel->queue, op, func);
+}
+
+void
+dispatch_io_set_high_water(dispatch_io_t channel, size_t high_water)
+{
+	_dispatch_io_set_policy(channel, high_water, _dispatch_io_set_high_water2);
+}
+
+void
+dispatch_io_set_low_water(dispatch_io_t channel, size_t low_water)
+{
+	_dispatch_io_set_policy(channel, low_water, _dispatch_io_set_low_water2);
+}
+
+static void
+_dispatch_io_op_free(dispatch_io_op_t op)
+{
+	dispatch_io_t channel = op->op_channel;
+
+	channel->op_count--;
+	_dispatch_io_maybe_cleanup(channel);
+	if (op->op_data) {
+		dispatch_release(as_do(op->op_data));
+	}
+	if (op->op_queue) {
+		dispatch_release(as_do(op->op_queue));
+	}
+	dispatch_release(as_do(channel));
+	free(op);
+}
+
+static void
+_dispatch_io_delivered(void *ctxt)
+{
+	dispatch_io_delivery_t d = ctxt;
+	dispatch_io_op_t op = d->op;
+
+	op->op_pending -= d->size;
+	if (d->done) {
+		_dispatch_io_op_free(op);
+	} else if (op->op_stalled && op->op_pending < DISPATCH_IO_MAX_PENDING_SIZE) {
+		op->op_stalled = false;
+		_dispatch_io_pump(op);
+	}
+	free(d);
+}
+
+static void
+_dispatch_io_deliver_invoke(void *ctxt)
+{
+	dispatch_io_delivery_t d = ctxt;
+	dispatch_io_op_t op = d->op;
+
+	op->op_func(op->op_ctxt, d->done, d->data, d->err);
+	if (d->data) {
+		dispatch_release(as_do(d->data));
+		d->data = NULL;
+	}
+	dispatch_async_f(op->op_channel->queue, d, _dispatch_io_delivered);
+}
+
+// Hands data (consumed) to the operation's handler; size is the number of bytes
+// accounted against DISPATCH_IO_MAX_PENDING_SIZE until the handler returns.
+static void
+_dispatch_io_deliver(dispatch_io_op_t op, dispatch_data_t data, size_t size, bool done, int err)
+{
+	dispatch_io_delivery_t d;
+
+	while (!(d = malloc(sizeof(*d)))) {
+		sleep(1);
+	}
+	d->op = op;
+	d->data = data;
+	d->size = size;
+	d->done = done;
+	d->err = err;
+	op->op_pending += size;
+	dispatch_async_f(op->op_queue, d, _dispatch_io_deliver_invoke);
+}
+
+// Splits the data read so far into deliveries of at most high_water bytes,
+// as long as at least low_water bytes (or, if final, anything) are left.
+static void
+_dispatch_io_deliver_reads(dispatch_io_op_t op, bool final, int err)
+{
+	dispatch_io_t channel = op->op_channel;
+	dispatch_data_t data = op->op_data, piece, rest;
+	size_t size = dispatch_data_get_size(data), len;
+	size_t low_water = channel->low_water ? channel->low_water : 1;
+
+	op->op_data = NULL;
+	while (size && (size >= low_water || final)) {
+		len = size < channel->high_water ? size : channel->high_water;
+		if (final && len == size) {
+			break;
+		}
+		piece = dispatch_data_create_subrange(data, 0, len);
+		rest = dispatch_data_create_subrange(data, len, size - len);
+		dispatch_release(as_do(data));
+		data = rest;
+		size -= len;
+		_dispatch_io_deliver(op, piece, len, false, 0);
+	}
+	if (final) {
+		_dispatch_io_deliver(op, data, size, true, err);
+	} else {
+		op->op_data = data;
+	}
+}
+
+// Completes an operation, active or not
+static void
+_dispatch_io_complete(dispatch_io_op_t op, int err)
+{
+	dispatch_io_t channel = op->op_channel;
+	dispatch_data_t data;
+	bool was_active = channel->active[op->op_kind] == op;
+
+	if (was_active) {
+		channel->active[op->op_kind] = NULL;
+	}
+	if (op->op_kind == DISPATCH_IO_READ) {
+		if (!op->op_data) {
+			op->op_data = dispatch_data_empty;
+		}
+		_dispatch_io_deliver_reads(op, true, err);
+	} else {
+		data = op->op_data;
+		op->op_data = NULL;
+		if (data && !dispatch_data_get_size(data)) {
+			dispatch_release(as_do(data));
+			data = NULL;
+		}
+		_dispatch_io_deliver(op, data, 0, true, err);
+	}
+	if (was_active) {
+		_dispatch_io_schedule(channel);
+	}
+}
+
+#if DISPATCH_IO_USE_SOURCES
+static void
+_dispatch_io_ready(dispatch_io_t channel, unsigned long kind)
+{
+	if (!channel->waiting[kind]) {
+		return;
+	}
+	channel->waiting[kind] = false;
+	dispatch_suspend(as_do(channel->sources[kind]));
+	if (channel->active[kind]) {
+		_dispatch_io_pump(channel->active[kind]);
+	}
+}
+
+static void
+_dispatch_io_read_ready(void *ctxt)
+{
+	_dispatch_io_ready(ctxt, DISPATCH_IO_READ);
+}
+
+static void
+_dispatch_io_write_ready(void *ctxt)
+{
+	_dispatch_io_ready(ctxt, DISPATCH_IO_WRITE);
+}
+
+// Parks the operation until its descriptor is readable (writable)
+static void
+_dispatch_io_wait(dispatch_io_op_t op)
+{
+	dispatch_io_t channel = op->op_channel;
+	unsigned long kind = op->op_kind;
+	dispatch_source_t ds = channel->sources[kind];
+
+	if (!ds) {
+		ds = dispatch_source_create(kind == DISPATCH_IO_READ ?
+			DISPATCH_SOURCE_TYPE_READ : DISPATCH_SOURCE_TYPE_WRITE,
+			(uintptr_t)channel->fd, 0, channel->queue);
+		if (slowpath(!ds)) {
+			_dispatch_io_complete(op, ENOMEM);
+			return;
+		}
+		dispatch_set_context(as_do(ds), channel);
+		dispatch_source_set_event_handler_f(ds, kind == DISPATCH_IO_READ ?
+			_dispatch_io_read_ready : _dispatch_io_write_ready);
+		dispatch_source_set_cancel_handler_f(ds, _dispatch_io_source_canceled);
+		channel->sources[kind] = ds;
+	}
+	channel->waiting[kind] = true;
+	dispatch_resume(as_do(ds));
+}
+#endif
+
+static void
+_dispatch_io_pump_read(dispatch_io_op_t op)
+{
+	dispatch_io_t channel = op->op_channel;
+	dispatch_data_t data, concat;
+	size_t len;
+	void *buf;
+	long n;
+
+	if (!op->op_length) {
+		_dispatch_io_complete(op, 0);
+		return;
+	}
+	len = op->op_length;
+	if (len > channel->high_water) {
+		len = channel->high_water;
+	}
+	if (len > DISPATCH_IO_MAX_CHUNK_SIZE) {
+		len = DISPATCH_IO_MAX_CHUNK_SIZE;
+	}
+	while (!(buf = malloc(len))) {
+		sleep(1);
+	}
+	do {
+		n = _dispatch_io_read_fd(channel->fd, buf, len, op->op_offset);
+	} while (n == -1 && errno == EINTR);
+
+	if (n <= 0) {
+		int err = n ? errno : 0;
+
+		free(buf);
+#if DISPATCH_IO_USE_SOURCES
+		if (err == EAGAIN) {
+			_dispatch_io_wait(op);
+			return;
+		}
+#endif
+		_dispatch_io_complete(op, err);
+		return;
+	}
+	if ((size_t)n < len / 2) {
+		// don't pin a mostly empty buffer for a short read
+		void *shrunk = realloc(buf, (size_t)n);
+		if (shrunk) {
+			buf = shrunk;
+		}
+	}
+	data = _dispatch_data_create_with_buffer(buf, (size_t)n);
+	if (op->op_data) {
+		concat = dispatch_data_create_concat(op->op_data, data);
+		dispatch_release(as_do(op->op_data));
+		dispatch_release(as_do(data));
+		data = concat;
+	}
+	op->op_data = data;
+	if (op->op_offset != -1) {
+		op->op_offset += n;
+	}
+	if (op->op_length != SIZE_MAX) {
+		op->op_length -= (size_t)n;
+		if (!op->op_length) {
+			_dispatch_io_complete(op, 0);
+			return;
+		}
+	}
+	_dispatch_io_deliver_reads(op, false, 0);
+	dispatch_async_f(channel->queue, op, _dispatch_io_pump_invoke);
+}
+
+static bool
+_dispatch_io_first_region(void *ctxt, dispatch_data_t region DISPATCH_UNUSED,
+	size_t offset DISPATCH_UNUSED, const void *buffer, size_t size)
+{
+	const void **region_ptr = ctxt;
+
+	region_ptr[0] = buffer;
+	region_ptr[1] = (const void *)(uintptr_t)size;
+	return false;
+}
+
+static void
+_dispatch_io_pump_write(dispatch_io_op_t op)
+{
+	dispatch_io_t channel = op->op_channel;
+	dispatch_data_t rest;
+	const void *region[2] = { NULL, NULL };
+	size_t size, len, low_water;
+	long n;
+
+	// write straight out of the first contiguous region of the data
+	dispatch_data_apply_f(op->op_data, region, _dispatch_io_first_region);
+	len = (size_t)(uintptr_t)region[1];
+	if (len > channel->high_water) {
+		len = channel->high_water;
+	}
+	if (len > DISPATCH_IO_MAX_CHUNK_SIZE) {
+		len = DISPATCH_IO_MAX_CHUNK_SIZE;
+	}
+	do {
+		n = _dispatch_io_write_fd(channel->fd, region[0], len, op->op_offset);
+	} while (n == -1 && errno == EINTR);
+
+	if (n < 0) {
+#if DISPATCH_IO_USE_SOURCES
+		if (errno == EAGAIN) {
+			_dispatch_io_wait(op);
+			return;
+		}
+#endif
+		_dispatch_io_complete(op, errno);
+		return;
+	}
+	size = dispatch_data_get_size(op->op_data);
+	rest = dispatch_data_create_subrange(op->op_data, (size_t)n, size - (size_t)n);
+	dispatch_release(as_do(op->op_data));
+	op->op_data = rest;
+	if (op->op_offset != -1) {
+		op->op_offset += n;
+	}
+	if (size == (size_t)n) {
+		_dispatch_io_complete(op, 0);
+		return;
+	}
+	op->op_processed += (size_t)n;
+	low_water = channel->low_water ? channel->low_water : 1;
+	if (op->op_processed >= low_water) {
+		// report progress with the data that is left
+		dispatch_retain(as_do(rest));
+		_dispatch_io_deliver(op, rest, op->op_processed, false, 0);
+		op->op_processed = 0;
+	}
+	dispatch_async_f(channel->queue, op, _dispatch_io_pump_invoke);
+}
+
+// Performs one chunk of an active operation; runs on the channel queue
+static void
+_dispatch_io_pump(dispatch_io_op_t op)
+{
+	dispatch_io_t channel = op->op_channel;
+
+	if (channel->active[op->op_kind] != op) {
+		return;
+	}
+#if DISPATCH_IO_USE_SOURCES
+	if (channel->waiting[op->op_kind]) {
+		return;
+	}
+#endif
+	if (channel->stopped) {
+		_dispatch_io_complete(op, ECANCELED);
+		return;
+	}
+	if (op->op_pending >= DISPATCH_IO_MAX_PENDING_SIZE) {
+		// resumed by _dispatch_io_delivered()
+		op->op_stalled = true;
+		return;
+	}
+	if (op->op_kind == DISPATCH_IO_READ) {
+		_dispatch_io_pump_read(op);
+	} else {
+		_dispatch_io_pump_write(op);
+	}
+}
+
+static void
+_dispatch_io_pump_invoke(void *ctxt)
+{
+	_dispatch_io_pump(ctxt);
+}
+
+static int
+_dispatch_io_open(dispatch_io_t channel)
+{
+	int err;
+
+	channel->fd = _dispatch_io_open_fd(channel->path, channel->oflag, channel->mode);
+	if (channel->fd == -1) {
+		return errno;
+	}
+	err = _dispatch_io_init_fd(channel);
+	if (err) {
+		(void)_dispatch_io_close_fd(channel->fd);
+		channel->fd = -1;
+	}
+	return err;
+}
+
+// Starts whatever may run: the first read and the first write ahead of any
+// barrier, then the barrier at the head once nothing is active.
+static void
+_dispatch_io_schedule(dispatch_io_t channel)
+{
+	dispatch_io_op_t op, next, prev;
+
+	for (;;) {
+		prev = NULL;
+		for (op = channel->ops_head; op && op->op_kind != DISPATCH_IO_BARRIER; op = next) {
+			next = op->op_next;
+			if (channel->active[op->op_kind]) {
+				prev = op;
+				continue;
+			}
+			if (prev) {
+				prev->op_next = next;
+			} else {
+				channel->ops_head = next;
+			}
+			if (channel->ops_tail == op) {
+				channel->ops_tail = prev;
+			}
+			op->op_next = NULL;
+			channel->active[op->op_kind] = op;
+			dispatch_async_f(channel->queue, op, _dispatch_io_pump_invoke);
+		}
+		op = channel->ops_head;
+		if (!op || op->op_kind != DISPATCH_IO_BARRIER ||
+				channel->active[DISPATCH_IO_READ] || channel->active[DISPATCH_IO_WRITE]) {
+			return;
+		}
+		channel->ops_head = op->op_next;
+		if (channel->ops_tail == op) {
+			channel->ops_tail = NULL;
+		}
+		op->op_barrier(op->op_ctxt);
+		_dispatch_io_op_free(op);
+	}
+}
+
+static void
+_dispatch_io_enqueue2(void *ctxt)
+{
+	dispatch_io_op_t op = ctxt;
+	dispatch_io_t channel = op->op_channel;
+
+	channel->op_count++;
+	if (op->op_kind != DISPATCH_IO_BARRIER) {
+		if (channel->fd == -1 && channel->path && !channel->closed) {
+			channel->err = _dispatch_io_open(channel);
+			if (channel->err) {
+				channel->closed = true;
+			}
+		}
+		if (channel->closed) {
+			_dispatch_io_complete(op, channel->err ? channel->err : ECANCELED);
+			return;
+		}
+		if (op->op_offset != -1) {
+			op->op_offset += channel->f_ptr;
+		}
+	}
+	if (channel->ops_tail) {
+		channel->ops_tail->op_next = op;
+	} else {
+		channel->ops_head = op;
+	}
+	channel->ops_tail = op;
+	_dispatch_io_schedule(channel);
+}
+
+static dispatch_io_op_t
+_dispatch_io_op_create(dispatch_io_t channel, unsigned long kind, dispatch_queue_t queue)
+{
+	dispatch_io_op_t op;
+
+	while (!(op = calloc(1, sizeof(struct dispatch_io_op_s)))) {
+		sleep(1);
+	}
+	dispatch_retain(as_do(channel));
+	op->op_channel = channel;
+	op->op_kind = kind;
+	op->op_offset = -1;
+	if (queue) {
+		// a private serial queue keeps the handler invocations ordered and
+		// non-reentrant even when the handler queue is concurrent
+		op->op_queue = dispatch_queue_create("com.apple.libdispatch.io.handler", NULL);
+		dispatch_set_target_queue(as_do(op->op_queue), queue);
+	}
+	return op;
+}
+
+
+static void
+_dispatch_io_op_enqueue(dispatch_io_op_t op)
+{
+	dispatch_async_f(op->op_channel->queue, op, _dispatch_io_enqueue2);
+}
+
+void
+dispatch_io_read_f(dispatch_io_t channel, off_t offset, size_t length,
+	dispatch_queue_t queue, void *ctxt, dispatch_io_handler_function_t io_handler)
+{
+	dispatch_io_op_t op = _dispatch_io_op_create(channel, DISPATCH_IO_READ, queue);
+
+	if (channel->type == DISPATCH_IO_RANDOM) {
+		op->op_offset = offset;
+	}
+	op->op_length = length;
+	op->op_func = io_handler;
+	op->op_ctxt = ctxt;
+	_dispatch_io_op_enqueue(op);
+}
+
+void
+dispatch_io_write_f(dispatch_io_t channel, off_t offset, dispatch_data_t data,
+	dispatch_queue_t queue, void *ctxt, dispatch_io_handler_function_t io_handler)
+{
+	dispatch_io_op_t op = _dispatch_io_op_create(channel, DISPATCH_IO_WRITE, queue);
+
+	if (channel->type == DISPATCH_IO_RANDOM) {
+		op->op_offset = offset;
+	}
+	dispatch_retain(as_do(data));
+	op->op_data = data;
+	op->op_func = io_handler;
+	op->op_ctxt = ctxt;
+	_dispatch_io_op_enqueue(op);
+}
+
+void
+dispatch_io_barrier_f(dispatch_io_t channel, void *ctxt, dispatch_function_t barrier)
+{
+	dispatch_io_op_t op = _dispatch_io_op_create(channel, DISPATCH_IO_BARRIER, NULL);
+
+	op->op_barrier = barrier;
+	op->op_ctxt = ctxt;
+	_dispatch_io_op_enqueue(op);
+}
+
+#ifdef __BLOCKS__
+static void
+_dispatch_io_call_handler_block(void *ctxt, bool done, dispatch_data_t data, int err)
+{
+	dispatch_io_handler_t io_handler = ctxt;
+
+	io_handler(done, data, err);
+	if (done) {
+		Block_release(io_handler);
+	}
+}
+
+void
+dispatch_io_read(dispatch_io_t channel, off_t offset, size_t length,
+	dispatch_queue_t queue, dispatch_io_handler_t io_handler)
+{
+	dispatch_io_read_f(channel, offset, length, queue,
+		Block_copy(io_handler), _dispatch_io_call_handler_block);
+}
+
+void
+dispatch_io_write(dispatch_io_t channel, off_t offset, dispatch_data_t data,
+	dispatch_queue_t queue, dispatch_io_handler_t io_handler)
+{
+	dispatch_io_write_f(channel, offset, data, queue,
+		Block_copy(io_handler), _dispatch_io_call_handler_block);
+}
+
+void
+dispatch_io_barrier(dispatch_io_t channel, dispatch_block_t barrier)
+{
+	dispatch_io_barrier_f(channel, _dispatch_Block_copy(barrier), _dispatch_call_block_and_release);
+}
+#endif
+
+static void
+_dispatch_io_close2(void *ctxt)
+{
+	dispatch_io_op_t close_op = ctxt, op, next;
+	dispatch_io_t channel = close_op->op_channel;
+	unsigned long i;
+
+	channel->closed = true;
+	if (close_op->op_length & DISPATCH_IO_STOP) {
+		channel->stopped = true;
+		// fail what has not started yet, barriers still run
+		op = channel->ops_head;
+		channel->ops_head = channel->ops_tail = NULL;
+		for (; op; op = next) {
+			next = op->op_next;
+			op->op_next = NULL;
+			if (op->op_kind == DISPATCH_IO_BARRIER) {
+				if (channel->ops_tail) {
+					channel->ops_tail->op_next = op;
+				} else {
+					channel->ops_head = op;
+				}
+				channel->ops_tail = op;
+			} else {
+				_dispatch_io_complete(op, ECANCELED);
+			}
+		}
+		// wake up active operations so that they notice
+		for (i = 0; i < 2; ++i) {
+			op = channel->active[i];
+			if (!op) {
+				continue;
+			}
+#if DISPATCH_IO_USE_SOURCES
+			if (channel->waiting[i]) {
+				_dispatch_io_ready(channel, i);
+				continue;
+			}
+#endif
+			if (op->op_stalled) {
+				op->op_stalled = false;
+				_dispatch_io_pump(op);
+			}
+		}
+		_dispatch_io_schedule(channel);
+	}
+	_dispatch_io_maybe_cleanup(channel);
+	dispatch_release(as_do(channel));
+	free(close_op);
+}
+
+void
+dispatch_io_close(dispatch_io_t channel, dispatch_io_close_flags_t flags)
+{
+	dispatch_io_op_t op;
+
+	while (!(op = calloc(1, sizeof(struct dispatch_io_op_s)))) {
+		sleep(1);
+	}
+	dispatch_retain(as_do(channel));
+	op->op_channel = channel;
+	op->op_length = flags;
+	dispatch_async_f(channel->queue, op, _dispatch_io_close2);
+}
+
+// dispatch_read()/dispatch_write() run a single operation on a private stream
+// channel; reads are accumulated and handed out in one piece.
+typedef struct dispatch_io_convenience_s {
+	dispatch_data_t data;
+	dispatch_io_convenience_function_t func;
+	void *ctxt;
+} *dispatch_io_convenience_t;
+
+static dispatch_io_convenience_t
+_dispatch_io_convenience_create(void *ctxt, dispatch_io_convenience_function_t handler)
+{
+	dispatch_io_convenience_t c;
+
+	while (!(c = calloc(1, sizeof(*c)))) {
+		sleep(1);
+	}
+	c->data = dispatch_data_empty;
+	c->func = handler;
+	c->ctxt = ctxt;
+	return c;
+}
+
+static void
+_dispatch_read_handler(void *ctxt, bool done, dispatch_data_t data, int err)
+{
+	dispatch_io_convenience_t c = ctxt;
+	dispatch_data_t concat;
+
+	if (data) {
+		concat = dispatch_data_create_concat(c->data, data);
+		dispatch_release(as_do(c->data));
+		c->data = concat;
+	}
+	if (done) {
+		c->func(c->ctxt, c->data, err);
+		dispatch_release(as_do(c->data));
+		free(c);
+	}
+}
+
+static void
+_dispatch_write_handler(void *ctxt, bool done, dispatch_data_t data, int err)
+{
+	dispatch_io_convenience_t c = ctxt;
+
+	if (done) {
+		c->func(c->ctxt, data, err);
+		free(c);
+	}
+}
+
+void
+dispatch_read_f(dispatch_fd_t fd, size_t length, dispatch_queue_t queue,
+	void *ctxt, dispatch_io_convenience_function_t handler)
+{
+	dispatch_io_t channel = dispatch_io_create_f(DISPATCH_IO_STREAM, fd, queue, NULL, NULL);
+
+	dispatch_io_set_low_water(channel, SIZE_MAX);
+	dispatch_io_read_f(channel, 0, length, queue,
+		_dispatch_io_convenience_create(ctxt, handler), _dispatch_read_handler);
+	dispatch_io_close(channel, 0);
+	dispatch_release(as_do(channel));
+}
+
+void
+dispatch_write_f(dispatch_fd_t fd, dispatch_data_t data, dispatch_queue_t queue,
+	void *ctxt, dispatch_io_convenience_function_t handler)
+{
+	dispatch_io_t channel = dispatch_io_create_f(DISPATCH_IO_STREAM, fd, queue, NULL, NULL);
+
+	dispatch_io_set_low_water(channel, SIZE_MAX);
+	dispatch_io_write_f(channel, 0, data, queue,
+		_dispatch_io_convenience_create(ctxt, handler), _dispatch_write_handler);
+	dispatch_io_close(channel, 0);
+	dispatch_release(as_do(channel));
+}
+
+#ifdef __BLOCKS__
+static void
+_dispatch_io_call_convenience_block(void *ctxt, dispatch_data_t data, int err)
+{
+	void (^handler)(dispatch_data_t, int) = ctxt;
+
+	handler(data, err);
+	Block_release(handler);
+}
+
+void
+dispatch_read(dispatch_fd_t fd, size_t length, dispatch_queue_t queue,
+	void (^handler)(dispatch_data_t data, int error))
+{
+	dispatch_read_f(fd, length, queue, Block_copy(handler), _dispatch_io_call_convenience_block);
+}
+
+void
+dispatch_write(dispatch_fd_t fd, dispatch_data_t data, dispatch_queue_t queue,
+	void (^handler)(dispatch_data_t data, int error))
+{
+	dispatch_write_f(fd, data, queue, Block_copy(handler), _dispatch_io_call_convenience_block);
+}
+#endif
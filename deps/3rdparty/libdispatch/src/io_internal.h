@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2009-2011 Apple Inc. All rights reserved.
+ *
+ * @APPLE_APACHE_LICENSE_HEADER_START@
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @APPLE_APACHE_LICENSE_HEADER_END@
+ */
+
+/*
+ * IMPORTANT: This header file describes INTERNAL interfaces to libdispatch
+ * which are subject to change in future releases of Mac OS X. Any applications
+ * relying on these interfaces WILL break.
+ */
+
+#ifndef __DISPATCH_IO_INTERNAL__
+#define __DISPATCH_IO_INTERNAL__
+
+// The kqueue emulation on Windows has no EVFILT_READ/EVFILT_WRITE, so stream
+// channels there perform blocking I/O on the channel queue instead of waiting
+// for read/write sources.
+#if TARGET_OS_WIN32
+#define DISPATCH_IO_USE_SOURCES 0
+#else
+#define DISPATCH_IO_USE_SOURCES 1
+#endif
+
+#define DISPATCH_IO_READ	0
+#define DISPATCH_IO_WRITE	1
+#define DISPATCH_IO_BARRIER	2
+
+// Largest single read or write issued for an operation
+#define DISPATCH_IO_MAX_CHUNK_SIZE		(1024 * 1024)
+// Bytes of an operation handed to its I/O handler but not yet returned from it
+// beyond which the channel stops reading ahead (or reporting progress)
+#define DISPATCH_IO_MAX_PENDING_SIZE	(8 * DISPATCH_IO_MAX_CHUNK_SIZE)
+
+struct dispatch_io_vtable_s {
+	DISPATCH_VTABLE_HEADER(dispatch_io_s);
+};
+
+typedef struct dispatch_io_op_s *dispatch_io_op_t;
+
+// All fields are owned by the channel queue, except op_queue, op_func and
+// op_ctxt which are immutable once the operation is enqueued.
+struct dispatch_io_op_s {
+	dispatch_io_op_t op_next;
+	dispatch_io_t op_channel;
+	unsigned long op_kind;
+	int64_t op_offset;			// absolute file offset, -1 for the current position
+	size_t op_length;			// reads: bytes left to read, SIZE_MAX until EOF
+	dispatch_data_t op_data;	// reads: not yet delivered, writes: not yet written
+	size_t op_processed;		// writes: bytes written since the last delivery
+	size_t op_pending;			// bytes delivered whose handler has not returned
+	dispatch_queue_t op_queue;	// serial, targets the handler queue
+	dispatch_io_handler_function_t op_func;
+	dispatch_function_t op_barrier;
+	void *op_ctxt;
+	bool op_stalled;
+};
+
+struct dispatch_io_s {
+	DISPATCH_STRUCT_HEADER(dispatch_io_s, dispatch_io_vtable_s);
+	dispatch_queue_t queue;		// serializes all of the channel state and I/O
+	dispatch_io_type_t type;
+	dispatch_fd_t fd;
+	int fd_flags;
+	int64_t f_ptr;
+	char *path;
+	int oflag;
+	mode_t mode;
+	size_t low_water;
+	size_t high_water;
+	int err;
+	unsigned int op_count;
+	dispatch_io_op_t ops_head;
+	dispatch_io_op_t ops_tail;
+	dispatch_io_op_t active[2];
+#if DISPATCH_IO_USE_SOURCES
+	dispatch_source_t sources[2];
+	bool waiting[2];
+	unsigned int sources_canceling;
+	bool disposed;
+#endif
+	dispatch_queue_t cleanup_queue;
+	dispatch_io_cleanup_function_t cleanup_func;
+	void *cleanup_ctxt;
+	bool is_regular;
+	bool owns_fd;
+	bool closed;
+	bool stopped;
+	bool cleaned_up;
+};
+
+extern const struct dispatch_io_vtable_s _dispatch_io_vtable;
+
+#endif
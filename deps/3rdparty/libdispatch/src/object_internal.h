@@ -32,6 +32,8 @@ enum {
 	_DISPATCH_QUEUE_TYPE			=    0x10000, // meta-type for queues
 	_DISPATCH_SOURCE_TYPE			=    0x20000, // meta-type for sources
 	_DISPATCH_SEMAPHORE_TYPE		=    0x30000, // meta-type for semaphores
+	_DISPATCH_DATA_TYPE				=    0x40000, // meta-type for data
+	_DISPATCH_IO_TYPE				=    0x50000, // meta-type for io channels
 	_DISPATCH_ATTR_TYPE				= 0x10000000, // meta-type for attribute structures
 	
 	DISPATCH_CONTINUATION_TYPE		= _DISPATCH_CONTINUATION_TYPE,
@@ -43,6 +45,10 @@ enum {
 	DISPATCH_QUEUE_MGR_TYPE			= 3 | _DISPATCH_QUEUE_TYPE,
 
 	DISPATCH_SEMAPHORE_TYPE			= _DISPATCH_SEMAPHORE_TYPE,
+
+	DISPATCH_DATA_TYPE				= _DISPATCH_DATA_TYPE,
+
+	DISPATCH_IO_TYPE				= _DISPATCH_IO_TYPE,
 	
 	DISPATCH_SOURCE_ATTR_TYPE		= _DISPATCH_SOURCE_TYPE | _DISPATCH_ATTR_TYPE,
 	
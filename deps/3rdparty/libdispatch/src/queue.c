@@ -153,6 +153,23 @@ struct dispatch_queue_attr_s {
 #endif
 };
 
+static const struct dispatch_queue_attr_vtable_s _dispatch_queue_attr_concurrent_vtable = {
+	/*.do_type    = */	DISPATCH_QUEUE_ATTR_TYPE,
+	/*.do_kind    = */	"queue-attr-concurrent",
+	/*.do_debug   = */	0,
+	/*.do_invoke  = */	0,
+	/*.do_probe   = */	0,
+	/*.do_dispose = */	0,
+};
+
+// DISPATCH_QUEUE_CONCURRENT; only its address is significant
+struct dispatch_queue_attr_s _dispatch_queue_attr_concurrent = {
+	/*.do_vtable   = */	&_dispatch_queue_attr_concurrent_vtable,
+	/*.do_next     = */	0,
+	/*.do_ref_cnt  = */	DISPATCH_OBJECT_GLOBAL_REFCNT,
+	/*.do_xref_cnt = */	DISPATCH_OBJECT_GLOBAL_REFCNT,
+};
+
 #if !TARGET_OS_WIN32
 static int _dispatch_pthread_sigmask(int how, sigset_t *set, sigset_t *oset);
 #endif
@@ -184,6 +201,31 @@ static const struct dispatch_queue_vtable_s _dispatch_queue_root_vtable = {
 
 #define MAX_THREAD_COUNT 255
 
+// Items a pool thread keeps in its local queue; it pushes any more to the
+// shared list of its root queue
+#define DISPATCH_WORKER_LOCAL_SIZE 64
+// Local items a pool thread runs in a row before it takes one from the shared
+// list, so that its own submissions cannot starve everybody else's
+#define DISPATCH_WORKER_LOCAL_BATCH 16
+// Times an idle pool thread looks for work before it parks
+#define DISPATCH_WORKER_SPIN_COUNT 1024
+
+typedef struct dispatch_worker_s *dispatch_worker_t;
+
+// A thread of a root queue's thread pool (not used with kernel workqueues).
+// Only the thread itself pushes to its local queue; it and the other threads
+// of the pool take from the front, under dw_lock.
+struct dispatch_worker_s {
+	dispatch_worker_t dw_next;
+	dispatch_queue_t dw_queue;
+	intptr_t dw_lock;
+	unsigned int dw_head;
+	unsigned int dw_count;
+	unsigned int dw_local_run;
+	bool dw_blocked;
+	struct dispatch_object_s *dw_items[DISPATCH_WORKER_LOCAL_SIZE];
+};
+
 struct dispatch_root_queue_context_s {
 #if HAVE_PTHREAD_WORKQUEUES
 	pthread_workqueue_t dgq_kworkqueue;
@@ -191,6 +233,14 @@ struct dispatch_root_queue_context_s {
 	intptr_t dgq_pending;
 	intptr_t dgq_thread_pool_size;
 	dispatch_semaphore_t dgq_thread_mediator;
+	intptr_t dgq_spinning;
+	intptr_t dgq_local_count;	// items in the local queues of the workers
+	intptr_t dgq_workers_lock;
+	dispatch_worker_t dgq_workers;
+	intptr_t dgq_threads_created;
+	intptr_t dgq_steals;
+	intptr_t dgq_parks;
+	intptr_t dgq_unparks;
 };
 
 static struct dispatch_root_queue_context_s _dispatch_root_queue_contexts[] = {
@@ -201,6 +251,14 @@ static struct dispatch_root_queue_context_s _dispatch_root_queue_contexts[] = {
 		/*.dgq_pending          = */	0,
 		/*.dgq_thread_pool_size = */	MAX_THREAD_COUNT,
 		/*.dgq_thread_mediator  = */	&_dispatch_thread_mediator[0],
+		/*.dgq_spinning         = */	0,
+		/*.dgq_local_count      = */	0,
+		/*.dgq_workers_lock     = */	0,
+		/*.dgq_workers          = */	NULL,
+		/*.dgq_threads_created  = */	0,
+		/*.dgq_steals           = */	0,
+		/*.dgq_parks            = */	0,
+		/*.dgq_unparks          = */	0,
 	},
 	{
 #if HAVE_PTHREAD_WORKQUEUES
@@ -209,6 +267,14 @@ static struct dispatch_root_queue_context_s _dispatch_root_queue_contexts[] = {
 		/*.dgq_pending          = */	0,
 		/*.dgq_thread_pool_size = */	MAX_THREAD_COUNT,
 		/*.dgq_thread_mediator  = */	&_dispatch_thread_mediator[1],
+		/*.dgq_spinning         = */	0,
+		/*.dgq_local_count      = */	0,
+		/*.dgq_workers_lock     = */	0,
+		/*.dgq_workers          = */	NULL,
+		/*.dgq_threads_created  = */	0,
+		/*.dgq_steals           = */	0,
+		/*.dgq_parks            = */	0,
+		/*.dgq_unparks          = */	0,
 	},
 	{
 #if HAVE_PTHREAD_WORKQUEUES
@@ -217,6 +283,14 @@ static struct dispatch_root_queue_context_s _dispatch_root_queue_contexts[] = {
 		/*.dgq_pending          = */	0,
 		/*.dgq_thread_pool_size = */	MAX_THREAD_COUNT,
 		/*.dgq_thread_mediator  = */	&_dispatch_thread_mediator[2],
+		/*.dgq_spinning         = */	0,
+		/*.dgq_local_count      = */	0,
+		/*.dgq_workers_lock     = */	0,
+		/*.dgq_workers          = */	NULL,
+		/*.dgq_threads_created  = */	0,
+		/*.dgq_steals           = */	0,
+		/*.dgq_parks            = */	0,
+		/*.dgq_unparks          = */	0,
 	},
 	{
 #if HAVE_PTHREAD_WORKQUEUES
@@ -225,6 +299,14 @@ static struct dispatch_root_queue_context_s _dispatch_root_queue_contexts[] = {
 		/*.dgq_pending          = */	0,
 		/*.dgq_thread_pool_size = */	MAX_THREAD_COUNT,
 		/*.dgq_thread_mediator  = */	&_dispatch_thread_mediator[3],
+		/*.dgq_spinning         = */	0,
+		/*.dgq_local_count      = */	0,
+		/*.dgq_workers_lock     = */	0,
+		/*.dgq_workers          = */	NULL,
+		/*.dgq_threads_created  = */	0,
+		/*.dgq_steals           = */	0,
+		/*.dgq_parks            = */	0,
+		/*.dgq_unparks          = */	0,
 	},
 	{
 #if HAVE_PTHREAD_WORKQUEUES
@@ -233,6 +315,14 @@ static struct dispatch_root_queue_context_s _dispatch_root_queue_contexts[] = {
 		/*.dgq_pending          = */	0,
 		/*.dgq_thread_pool_size = */	MAX_THREAD_COUNT,
 		/*.dgq_thread_mediator  = */	&_dispatch_thread_mediator[4],
+		/*.dgq_spinning         = */	0,
+		/*.dgq_local_count      = */	0,
+		/*.dgq_workers_lock     = */	0,
+		/*.dgq_workers          = */	NULL,
+		/*.dgq_threads_created  = */	0,
+		/*.dgq_steals           = */	0,
+		/*.dgq_parks            = */	0,
+		/*.dgq_unparks          = */	0,
 	},
 	{
 #if HAVE_PTHREAD_WORKQUEUES
@@ -241,6 +331,14 @@ static struct dispatch_root_queue_context_s _dispatch_root_queue_contexts[] = {
 		/*.dgq_pending          = */	0,
 		/*.dgq_thread_pool_size = */	MAX_THREAD_COUNT,
 		/*.dgq_thread_mediator  = */	&_dispatch_thread_mediator[5],
+		/*.dgq_spinning         = */	0,
+		/*.dgq_local_count      = */	0,
+		/*.dgq_workers_lock     = */	0,
+		/*.dgq_workers          = */	NULL,
+		/*.dgq_threads_created  = */	0,
+		/*.dgq_steals           = */	0,
+		/*.dgq_parks            = */	0,
+		/*.dgq_unparks          = */	0,
 	},
 };
 
@@ -376,6 +474,7 @@ static void _dispatch_queue_merge_stats(uint64_t start);
 
 static void *_dispatch_worker_thread(void *context);
 static void _dispatch_worker_thread2(void *context);
+static void _dispatch_root_queue_poke(dispatch_queue_t dq);
 
 malloc_zone_t *_dispatch_ccache_zone;
 
@@ -637,6 +736,15 @@ dispatch_queue_create(const char *label, dispatch_queue_attr_t attr)
 	_dispatch_queue_init(dq);
 	strcpy(dq->dq_label, label);
 
+	if (attr == DISPATCH_QUEUE_CONCURRENT) {
+		// Items are redirected to the root queue as they are drained, so the
+		// pool rather than the queue bounds the concurrency. Like the global
+		// queues, concurrent queues do not overcommit.
+		dq->dq_width = INTPTR_MAX;
+		dq->do_targetq = _dispatch_get_root_queue(0, false);
+		return dq;
+	}
+
 #ifndef DISPATCH_NO_LEGACY
 	if (slowpath(attr)) {
 		dq->do_targetq = _dispatch_get_root_queue(attr->qa_priority, attr->qa_flags & DISPATCH_QUEUE_OVERCOMMIT);
@@ -1047,6 +1155,7 @@ libdispatch_init(void)
 #if DISPATCH_PERF_MON
 	_dispatch_thread_key_init_np(dispatch_bcounter_key, NULL);
 #endif
+	_dispatch_thread_key_init_np(dispatch_worker_key, NULL);
 #else /* !HAVE_PTHREAD_KEY_INIT_NP */
 	_dispatch_thread_key_create(&dispatch_queue_key, _dispatch_queue_cleanup);
 	_dispatch_thread_key_create(&dispatch_sema4_key, (void (*)(void *))dispatch_release); // use the extern release
@@ -1055,6 +1164,7 @@ libdispatch_init(void)
 #ifdef DISPATCH_PERF_MON
 	_dispatch_thread_key_create(&dispatch_bcounter_key, NULL);
 #endif
+	_dispatch_thread_key_create(&dispatch_worker_key, NULL);
 #endif /* HAVE_PTHREAD_KEY_INIT_NP */
 
 	_dispatch_main_q.dq_manually_drained = pthread_self();
@@ -1258,12 +1368,13 @@ _dispatch_root_queues_init(void *context DISPATCH_UNUSED)
 #endif
 
 	for (i = 0; i < DISPATCH_ROOT_QUEUE_COUNT; i++) {
-// some software hangs if the non-overcommitting queues do not overcommit when threads block
-#if 0
+		// More running threads than CPUs only adds context switches. A thread
+		// that blocks gives up its place in the pool until it wakes up (see
+		// _dispatch_worker_block_begin), so only the overcommitting queues
+		// start threads beyond that regardless.
 		if (!(i & 1)) {
-			dispatch_root_queue_contexts[i].dgq_thread_pool_size = _dispatch_hw_config.cc_max_active;
+			_dispatch_root_queue_contexts[i].dgq_thread_pool_size = _dispatch_hw_config.cc_max_active;
 		}
-#endif
 #if HAVE_PTHREAD_WORKQUEUES
 		r = pthread_workqueue_attr_setqueuepriority_np(&pwq_attr, _dispatch_rootq2wq_pri(i));
 #if defined(__GNUC__)
@@ -1324,16 +1435,14 @@ _dispatch_root_queues_init(void *context DISPATCH_UNUSED)
 bool
 _dispatch_queue_wakeup_global(dispatch_queue_t dq)
 {
-	struct dispatch_root_queue_context_s *qc = dq->do_ctxt;
 #if HAVE_PTHREAD_WORKQUEUES
+	struct dispatch_root_queue_context_s *qc = dq->do_ctxt;
 	pthread_workitem_handle_t wh;
 #if !TARGET_OS_WIN32
 	unsigned int gen_cnt;
 #endif
-#endif
-	pthread_t pthr;
 	int r;
-	uintptr_t t_count;
+#endif
 
 	if (!dq->dq_items_tail) {
 		return false;
@@ -1365,15 +1474,35 @@ _dispatch_queue_wakeup_global(dispatch_queue_t dq)
 	}
 #endif
 
+	_dispatch_root_queue_poke(dq);
+
+out:
+	return false;
+}
+
+// Wakes up a parked thread of the root queue's thread pool, or starts a new
+// one if there is room, unless a thread is already looking for work.
+static void
+_dispatch_root_queue_poke(dispatch_queue_t dq)
+{
+	struct dispatch_root_queue_context_s *qc = dq->do_ctxt;
+	pthread_t pthr;
+	int r;
+	intptr_t t_count;
+
+	if (qc->dgq_spinning) {
+		return;
+	}
+
 	if (dispatch_semaphore_signal(qc->dgq_thread_mediator)) {
-		goto out;
+		return;
 	}
 
 	do {
 		t_count = qc->dgq_thread_pool_size;
-		if (!t_count) {
+		if (t_count <= 0) {
 			_dispatch_debug("The thread pool is full: %p", dq);
-			goto out;
+			return;
 		}
 	} while (!dispatch_atomic_cmpxchg(&qc->dgq_thread_pool_size, t_count, t_count - 1));
 
@@ -1391,9 +1520,7 @@ _dispatch_queue_wakeup_global(dispatch_queue_t dq)
 	(void)
 #endif
 	dispatch_assume_zero(r);
-
-out:
-	return false;
+	dispatch_atomic_inc(&qc->dgq_threads_created);
 }
 
 void
@@ -1470,13 +1597,18 @@ _dispatch_async_f_redirect2(void *_ctxt)
 	struct dispatch_continuation_s *dc = _ctxt;
 	struct dispatch_continuation_s *other_dc = dc->dc_data[1];
 	dispatch_queue_t old_dq, dq = dc->dc_data[0];
+	intptr_t running;
 
 	old_dq = _dispatch_thread_getspecific(dispatch_queue_key);
 	_dispatch_thread_setspecific(dispatch_queue_key, dq);
 	_dispatch_continuation_pop(as_do(other_dc));
 	_dispatch_thread_setspecific(dispatch_queue_key, old_dq);
 
-	if (dispatch_atomic_sub(&dq->dq_running, 2) == 0) {
+	// The drain stops once the queue is as wide as it may get. Wake it when
+	// the running count drops back under the width rather than waiting for
+	// every redirected item to finish, or the queue would run in bursts.
+	running = dispatch_atomic_sub(&dq->dq_running, 2);
+	if (running == 0 || (running < dq->dq_width && running + 2 >= dq->dq_width && dq->dq_items_tail)) {
 		_dispatch_wakeup(as_do(dq));
 	}
 	_dispatch_release(as_do(dq));
@@ -1578,12 +1710,221 @@ out:
 	_dispatch_thread_setspecific(dispatch_queue_key, old_dq);
 }
 
+static DISPATCH_INLINE void
+_dispatch_worker_lock(intptr_t *lock)
+{
+	while (!dispatch_atomic_cmpxchg(lock, 0, 1)) {
+		_dispatch_hardware_pause();
+	}
+}
+
+static DISPATCH_INLINE void
+_dispatch_worker_unlock(intptr_t *lock)
+{
+	(void)dispatch_atomic_xchg(lock, 0);
+}
+
+static struct dispatch_object_s *
+_dispatch_worker_local_pop(dispatch_worker_t dw)
+{
+	struct dispatch_root_queue_context_s *qc = dw->dw_queue->do_ctxt;
+	struct dispatch_object_s *item = NULL;
+
+	if (!dw->dw_count) {
+		return NULL;
+	}
+	_dispatch_worker_lock(&dw->dw_lock);
+	if (dw->dw_count) {
+		item = dw->dw_items[dw->dw_head];
+		dw->dw_head = (dw->dw_head + 1) % DISPATCH_WORKER_LOCAL_SIZE;
+		dw->dw_count--;
+	}
+	_dispatch_worker_unlock(&dw->dw_lock);
+	if (item) {
+		dispatch_atomic_dec(&qc->dgq_local_count);
+	}
+	return item;
+}
+
+bool
+_dispatch_worker_push(dispatch_queue_t dq, struct dispatch_object_s *obj)
+{
+	dispatch_worker_t dw = _dispatch_thread_getspecific(dispatch_worker_key);
+	struct dispatch_root_queue_context_s *qc = dq->do_ctxt;
+	intptr_t local_count;
+	bool pushed = false;
+
+	if (!dw || dw->dw_queue != dq || dw->dw_blocked) {
+		return false;
+	}
+	// counted first so that a thief never takes the count below zero
+	local_count = dispatch_atomic_inc(&qc->dgq_local_count);
+	_dispatch_worker_lock(&dw->dw_lock);
+	if (dw->dw_count < DISPATCH_WORKER_LOCAL_SIZE) {
+		dw->dw_items[(dw->dw_head + dw->dw_count) % DISPATCH_WORKER_LOCAL_SIZE] = obj;
+		dw->dw_count++;
+		pushed = true;
+	}
+	_dispatch_worker_unlock(&dw->dw_lock);
+	if (!pushed) {
+		dispatch_atomic_dec(&qc->dgq_local_count);
+		return false;
+	}
+	// This thread gets to the item once the current one returns. Bring in
+	// another thread to steal it meanwhile; it brings in the next one if
+	// there is more, as _dispatch_queue_concurrent_drain_one() does.
+	if (local_count == 1) {
+		_dispatch_root_queue_poke(dq);
+	}
+	return true;
+}
+
+static struct dispatch_object_s *
+_dispatch_worker_steal(dispatch_worker_t dw)
+{
+	dispatch_queue_t dq = dw->dw_queue;
+	struct dispatch_root_queue_context_s *qc = dq->do_ctxt;
+	struct dispatch_object_s *item = NULL;
+	dispatch_worker_t victim;
+
+	if (!qc->dgq_local_count) {
+		return NULL;
+	}
+	_dispatch_worker_lock(&qc->dgq_workers_lock);
+	for (victim = qc->dgq_workers; victim && !item; victim = victim->dw_next) {
+		if (victim != dw) {
+			item = _dispatch_worker_local_pop(victim);
+		}
+	}
+	_dispatch_worker_unlock(&qc->dgq_workers_lock);
+	if (item) {
+		dispatch_atomic_inc(&qc->dgq_steals);
+		if (qc->dgq_local_count) {
+			_dispatch_root_queue_poke(dq);
+		}
+	}
+	return item;
+}
+
+static struct dispatch_object_s *
+_dispatch_worker_next(dispatch_queue_t dq, dispatch_worker_t dw)
+{
+	struct dispatch_object_s *item;
+
+	if (!dw) {
+		return _dispatch_queue_concurrent_drain_one(dq);
+	}
+	if (dw->dw_local_run < DISPATCH_WORKER_LOCAL_BATCH && (item = _dispatch_worker_local_pop(dw))) {
+		dw->dw_local_run++;
+		return item;
+	}
+	dw->dw_local_run = 0;
+	if ((item = _dispatch_queue_concurrent_drain_one(dq))) {
+		return item;
+	}
+	if ((item = _dispatch_worker_local_pop(dw))) {
+		return item;
+	}
+	return _dispatch_worker_steal(dw);
+}
+
+// Called before a pool thread blocks: hands its local items back to the
+// shared list and lets the pool start another thread in its place.
+bool
+_dispatch_worker_block_begin(void)
+{
+	dispatch_worker_t dw = _dispatch_thread_getspecific(dispatch_worker_key);
+	struct dispatch_object_s *item, *head = NULL, *tail = NULL;
+	struct dispatch_root_queue_context_s *qc;
+
+	if (!dw || dw->dw_blocked) {
+		return false;
+	}
+	qc = dw->dw_queue->do_ctxt;
+	dw->dw_blocked = true;
+	while ((item = _dispatch_worker_local_pop(dw))) {
+		if (tail) {
+			tail->do_next = item;
+		} else {
+			head = item;
+		}
+		tail = item;
+	}
+	if (head) {
+		_dispatch_queue_push_list2(dw->dw_queue, as_do(head), as_do(tail));
+	}
+	dispatch_atomic_inc(&qc->dgq_thread_pool_size);
+	if (dw->dw_queue->dq_items_tail) {
+		_dispatch_root_queue_poke(dw->dw_queue);
+	}
+	return true;
+}
+
+void
+_dispatch_worker_block_end(void)
+{
+	dispatch_worker_t dw = _dispatch_thread_getspecific(dispatch_worker_key);
+	struct dispatch_root_queue_context_s *qc = dw->dw_queue->do_ctxt;
+
+	// the pool may be over its size until a thread goes idle and exits
+	dispatch_atomic_dec(&qc->dgq_thread_pool_size);
+	dw->dw_blocked = false;
+}
+
+// Looks for work for a little while before the thread parks, so that a burst
+// of submissions does not have to wake anybody up. One thread spins at a time.
+static bool
+_dispatch_worker_spin(dispatch_worker_t dw)
+{
+	dispatch_queue_t dq = dw->dw_queue;
+	struct dispatch_root_queue_context_s *qc = dq->do_ctxt;
+	unsigned int i;
+
+	if (!dispatch_atomic_cmpxchg(&qc->dgq_spinning, 0, 1)) {
+		return false;
+	}
+	for (i = 0; i < DISPATCH_WORKER_SPIN_COUNT; i++) {
+		if (dq->dq_items_tail || qc->dgq_local_count) {
+			break;
+		}
+		_dispatch_hardware_pause();
+		dispatch_atomic_barrier();
+	}
+	// look again: a push that saw this thread spinning did not poke anybody
+	(void)dispatch_atomic_xchg(&qc->dgq_spinning, 0);
+	return dq->dq_items_tail || qc->dgq_local_count;
+}
+
+// Waits to be poked; false once the thread should exit
+static bool
+_dispatch_worker_park(dispatch_worker_t dw)
+{
+	struct dispatch_root_queue_context_s *qc = dw->dw_queue->do_ctxt;
+	long r;
+
+	// threads started while others were blocked leave once idle
+	if (qc->dgq_thread_pool_size < 0) {
+		return false;
+	}
+	dispatch_atomic_inc(&qc->dgq_parks);
+	dw->dw_blocked = true;
+	// we use 65 seconds in case there are any timers that run once a minute
+	r = dispatch_semaphore_wait(qc->dgq_thread_mediator, dispatch_time(0, 65ull * NSEC_PER_SEC));
+	dw->dw_blocked = false;
+	if (r) {
+		return false;
+	}
+	dispatch_atomic_inc(&qc->dgq_unparks);
+	return true;
+}
+
 // 6618342 Contact the team that owns the Instrument DTrace probe before renaming this symbol
 void *
 _dispatch_worker_thread(void *context)
 {
 	dispatch_queue_t dq = context;
 	struct dispatch_root_queue_context_s *qc = dq->do_ctxt;
+	dispatch_worker_t dw, *dwp;
 
 #if !TARGET_OS_WIN32
 	sigset_t mask;
@@ -1596,14 +1937,33 @@ _dispatch_worker_thread(void *context)
 	(void)dispatch_assume_zero(r);
 #endif
 
+	while (!(dw = calloc(1ul, sizeof(struct dispatch_worker_s)))) {
+		sleep(1);
+	}
+	dw->dw_queue = dq;
+	_dispatch_worker_lock(&qc->dgq_workers_lock);
+	dw->dw_next = qc->dgq_workers;
+	qc->dgq_workers = dw;
+	_dispatch_worker_unlock(&qc->dgq_workers_lock);
+	_dispatch_thread_setspecific(dispatch_worker_key, dw);
+
 	do {
 		_dispatch_worker_thread2(context);
-		// we use 65 seconds in case there are any timers that run once a minute
-	} while (dispatch_semaphore_wait(qc->dgq_thread_mediator, dispatch_time(0, 65ull * NSEC_PER_SEC)) == 0);
+	} while (_dispatch_worker_spin(dw) || _dispatch_worker_park(dw));
+
+	_dispatch_thread_setspecific(dispatch_worker_key, NULL);
+	_dispatch_worker_lock(&qc->dgq_workers_lock);
+	dwp = &qc->dgq_workers;
+	while (*dwp != dw) {
+		dwp = &(*dwp)->dw_next;
+	}
+	*dwp = dw->dw_next;
+	_dispatch_worker_unlock(&qc->dgq_workers_lock);
+	free(dw);
 
 	dispatch_atomic_inc(&(qc->dgq_thread_pool_size));
-	if (dq->dq_items_tail) {
-		_dispatch_queue_wakeup_global(dq);
+	if (dq->dq_items_tail || qc->dgq_local_count) {
+		_dispatch_root_queue_poke(dq);
 	}
 
 	return NULL;
@@ -1616,6 +1976,7 @@ _dispatch_worker_thread2(void *context)
 	struct dispatch_object_s *item;
 	dispatch_queue_t dq = context;
 	struct dispatch_root_queue_context_s *qc = dq->do_ctxt;
+	dispatch_worker_t dw = _dispatch_thread_getspecific(dispatch_worker_key);
 #if DISPATCH_PERF_MON
 	uint64_t start;
 #endif
@@ -1636,7 +1997,7 @@ _dispatch_worker_thread2(void *context)
 #if DISPATCH_PERF_MON
 	start = _dispatch_absolute_time();
 #endif
-	while ((item = fastpath(_dispatch_queue_concurrent_drain_one(dq)))) {
+	while ((item = fastpath(_dispatch_worker_next(dq, dw)))) {
 		_dispatch_continuation_pop(as_do(item));
 	}
 #if DISPATCH_PERF_MON
@@ -1684,7 +2045,33 @@ _dispatch_queue_merge_stats(uint64_t start)
 size_t
 dispatch_queue_debug_attr(dispatch_queue_t dq, char* buf, size_t bufsiz)
 {
-	return snprintf(buf, bufsiz, "parent = %p ", dq->do_targetq);
+	struct dispatch_root_queue_context_s *qc;
+	size_t offset;
+
+	offset = snprintf(buf, bufsiz, "parent = %p, width = 0x%lx, running = 0x%lx ",
+			dq->do_targetq, (unsigned long)dq->dq_width, (unsigned long)dq->dq_running);
+	if (!dq->do_targetq) {
+		qc = dq->do_ctxt;
+		offset += snprintf(&buf[offset], bufsiz - offset, "threads = %lu, steals = %lu, parks = %lu, unparks = %lu ",
+				(unsigned long)qc->dgq_threads_created, (unsigned long)qc->dgq_steals,
+				(unsigned long)qc->dgq_parks, (unsigned long)qc->dgq_unparks);
+	}
+	return offset;
+}
+
+void
+dispatch_root_queue_get_stats(dispatch_queue_t dq, struct dispatch_root_queue_stats_s *stats)
+{
+	struct dispatch_root_queue_context_s *qc;
+
+	while (dq->do_targetq) {
+		dq = dq->do_targetq;
+	}
+	qc = dq->do_ctxt;
+	stats->drqs_threads_created = (uintptr_t)qc->dgq_threads_created;
+	stats->drqs_steals = (uintptr_t)qc->dgq_steals;
+	stats->drqs_parks = (uintptr_t)qc->dgq_parks;
+	stats->drqs_unparks = (uintptr_t)qc->dgq_unparks;
 }
 
 size_t
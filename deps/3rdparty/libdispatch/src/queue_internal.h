@@ -84,10 +84,14 @@ void _dispatch_queue_dispose(dispatch_queue_t dq);
 void _dispatch_queue_push_list_slow(dispatch_queue_t dq, struct dispatch_object_s *obj);
 void _dispatch_queue_serial_drain_till_empty(dispatch_queue_t dq);
 void _dispatch_force_cache_cleanup(void);
+bool _dispatch_worker_push(dispatch_queue_t dq, struct dispatch_object_s *obj);
+bool _dispatch_worker_block_begin(void);
+void _dispatch_worker_block_end(void);
 
+// Appends to the shared item list of the queue
 DISPATCH_INLINE
 static void
-_dispatch_queue_push_list(dispatch_queue_t dq, dispatch_object_t _head, dispatch_object_t _tail)
+_dispatch_queue_push_list2(dispatch_queue_t dq, dispatch_object_t _head, dispatch_object_t _tail)
 {
 	struct dispatch_object_s *prev, *head = _head._do, *tail = _tail._do;
 
@@ -102,6 +106,19 @@ _dispatch_queue_push_list(dispatch_queue_t dq, dispatch_object_t _head, dispatch
 	}
 }
 
+// Only root queues have no target queue. A thread of a root queue's thread
+// pool keeps single items it pushes to that queue in a local queue, which the
+// other threads of the pool steal from.
+DISPATCH_INLINE
+static void
+_dispatch_queue_push_list(dispatch_queue_t dq, dispatch_object_t _head, dispatch_object_t _tail)
+{
+	if (slowpath(!dq->do_targetq) && _head._do == _tail._do && _dispatch_worker_push(dq, _head._do)) {
+		return;
+	}
+	_dispatch_queue_push_list2(dq, _head, _tail);
+}
+
 #define _dispatch_queue_push(x, y) _dispatch_queue_push_list((x), (y), (y))
 
 #define DISPATCH_QUEUE_PRIORITY_COUNT 3
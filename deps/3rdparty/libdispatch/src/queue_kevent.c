@@ -222,6 +222,9 @@ _dispatch_mgr_invoke(dispatch_queue_t dq)
 	DWORD timeout = 0;
 
 	_dispatch_thread_setspecific(dispatch_queue_key, dq);
+	// the manager never returns to the thread pool; it neither takes a slot
+	// nor keeps the items it pushes for itself
+	(void)_dispatch_worker_block_begin();
 
 	for (;;) {
 		_dispatch_run_timers();
@@ -263,6 +266,9 @@ _dispatch_mgr_invoke(dispatch_queue_t dq)
 	int k_cnt, k_err, i, r;
 
 	_dispatch_thread_setspecific(dispatch_queue_key, dq);
+	// the manager never returns to the thread pool; it neither takes a slot
+	// nor keeps the items it pushes for itself
+	(void)_dispatch_worker_block_begin();
 
 	for (;;) {
 		_dispatch_run_timers();
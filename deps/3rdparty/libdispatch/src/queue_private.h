@@ -47,30 +47,6 @@ enum {
 
 #define DISPATCH_QUEUE_FLAGS_MASK	(DISPATCH_QUEUE_OVERCOMMIT)
 
-#ifdef __BLOCKS__
-__OSX_AVAILABLE_STARTING(__MAC_10_6,__IPHONE_4_0)
-DISPATCH_EXPORT DISPATCH_NONNULL_ALL DISPATCH_NOTHROW
-void
-dispatch_barrier_sync(dispatch_queue_t queue, dispatch_block_t block);
-#endif
-
-__OSX_AVAILABLE_STARTING(__MAC_10_6,__IPHONE_4_0)
-DISPATCH_EXPORT DISPATCH_NONNULL1 DISPATCH_NONNULL3 DISPATCH_NOTHROW
-void
-dispatch_barrier_sync_f(dispatch_queue_t dq, void *context, dispatch_function_t work);
-
-#ifdef __BLOCKS__
-__OSX_AVAILABLE_STARTING(__MAC_10_6,__IPHONE_4_0)
-DISPATCH_EXPORT DISPATCH_NONNULL_ALL DISPATCH_NOTHROW
-void
-dispatch_barrier_async(dispatch_queue_t queue, dispatch_block_t block);
-#endif
-
-__OSX_AVAILABLE_STARTING(__MAC_10_6,__IPHONE_4_0)
-DISPATCH_EXPORT DISPATCH_NONNULL1 DISPATCH_NONNULL3 DISPATCH_NOTHROW
-void
-dispatch_barrier_async_f(dispatch_queue_t dq, void *context, dispatch_function_t work);
-
 /*!
  * @function dispatch_queue_set_width
  *
@@ -97,6 +73,49 @@ DISPATCH_EXPORT DISPATCH_NONNULL_ALL DISPATCH_NOTHROW
 void
 dispatch_queue_set_width(dispatch_queue_t dq, long width);
 
+/*!
+ * @struct dispatch_root_queue_stats_s
+ *
+ * @abstract
+ * Counters of the thread pool of a global queue. They stay zero when the
+ * queue is serviced by kernel workqueues rather than by its own threads.
+ *
+ * @field drqs_threads_created
+ * Threads the pool has started.
+ *
+ * @field drqs_steals
+ * Items a thread took from the local queue of another thread of the pool.
+ *
+ * @field drqs_parks
+ * Times an idle thread went to sleep waiting for work.
+ *
+ * @field drqs_unparks
+ * Times a sleeping thread was woken up for work.
+ */
+struct dispatch_root_queue_stats_s {
+	uintptr_t drqs_threads_created;
+	uintptr_t drqs_steals;
+	uintptr_t drqs_parks;
+	uintptr_t drqs_unparks;
+};
+
+/*!
+ * @function dispatch_root_queue_get_stats
+ *
+ * @abstract
+ * Reads the thread pool counters of the global queue that a queue targets.
+ *
+ * @param queue
+ * A global queue, or a queue whose blocks run on one.
+ *
+ * @param stats
+ * Receives the counters.
+ */
+__OSX_AVAILABLE_STARTING(__MAC_10_7,__IPHONE_5_0)
+DISPATCH_EXPORT DISPATCH_NONNULL_ALL DISPATCH_NOTHROW
+void
+dispatch_root_queue_get_stats(dispatch_queue_t queue, struct dispatch_root_queue_stats_s *stats);
+
 __OSX_AVAILABLE_STARTING(__MAC_10_6,__IPHONE_4_0)
 extern const struct dispatch_queue_offsets_s {
 	// always add new fields at the end
@@ -180,9 +180,8 @@ _dispatch_semaphore_create_handle(HANDLE *s4)
 }
 #endif /* USE_WIN32_SEM */
 
-DISPATCH_NOINLINE
 static long
-_dispatch_semaphore_wait_slow(dispatch_semaphore_t dsema, dispatch_time_t timeout)
+_dispatch_semaphore_wait_slow2(dispatch_semaphore_t dsema, dispatch_time_t timeout)
 {
 #if USE_MACH_SEM
 	mach_timespec_t _timeout;
@@ -301,6 +300,21 @@ again:
 	goto again;
 }
 
+// A thread of a root queue's thread pool that blocks lets the pool start
+// another thread in its place until it wakes up again.
+DISPATCH_NOINLINE
+static long
+_dispatch_semaphore_wait_slow(dispatch_semaphore_t dsema, dispatch_time_t timeout)
+{
+	bool blocked = timeout != DISPATCH_TIME_NOW && _dispatch_worker_block_begin();
+	long ret = _dispatch_semaphore_wait_slow2(dsema, timeout);
+
+	if (blocked) {
+		_dispatch_worker_block_end();
+	}
+	return ret;
+}
+
 DISPATCH_NOINLINE
 void
 dispatch_group_enter(dispatch_group_t dg)
@@ -503,9 +517,8 @@ _dispatch_group_wake(dispatch_semaphore_t dsema)
 	return 0;
 }
 
-DISPATCH_NOINLINE
 static long
-_dispatch_group_wait_slow(dispatch_semaphore_t dsema, dispatch_time_t timeout)
+_dispatch_group_wait_slow2(dispatch_semaphore_t dsema, dispatch_time_t timeout)
 {
 #if USE_MACH_SEM
 	mach_timespec_t _timeout;
@@ -627,6 +640,19 @@ again:
 	goto again;
 }
 
+DISPATCH_NOINLINE
+static long
+_dispatch_group_wait_slow(dispatch_semaphore_t dsema, dispatch_time_t timeout)
+{
+	bool blocked = _dispatch_worker_block_begin();
+	long ret = _dispatch_group_wait_slow2(dsema, timeout);
+
+	if (blocked) {
+		_dispatch_worker_block_end();
+	}
+	return ret;
+}
+
 long
 dispatch_group_wait(dispatch_group_t dg, dispatch_time_t timeout)
 {
@@ -32,7 +32,7 @@ static const unsigned long dispatch_queue_key = __PTK_LIBDISPATCH_KEY0;
 static const unsigned long dispatch_sema4_key = __PTK_LIBDISPATCH_KEY1;
 static const unsigned long dispatch_cache_key = __PTK_LIBDISPATCH_KEY2;
 static const unsigned long dispatch_bcounter_key = __PTK_LIBDISPATCH_KEY3;
-//__PTK_LIBDISPATCH_KEY4
+static const unsigned long dispatch_worker_key = __PTK_LIBDISPATCH_KEY4;
 //__PTK_LIBDISPATCH_KEY5
 #else
 extern pthread_key_t dispatch_queue_key;
@@ -40,6 +40,7 @@ extern pthread_key_t dispatch_sema4_key;
 extern pthread_key_t dispatch_cache_key;
 extern pthread_key_t dispatch_bcounter_key;
 extern pthread_key_t dispatch_threaded_queue_key;
+extern pthread_key_t dispatch_worker_key;
 #endif
 
 #if USE_APPLE_TSD_OPTIMIZATIONS
@@ -0,0 +1,194 @@
+/*
+ * @APPLE_APACHE_LICENSE_HEADER_START@
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @APPLE_APACHE_LICENSE_HEADER_END@
+ */
+
+#include "config/config.h"
+
+#include <dispatch/dispatch.h>
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#include "dispatch_test.h"
+
+//
+// DISPATCH_QUEUE_CONCURRENT queues and the barrier API:
+// - items on a concurrent queue run at the same time,
+// - a barrier waits for the items submitted before it and holds back the
+//   items submitted after it (a reader/writer lock),
+// - throughput of a concurrent queue against a serial one.
+//
+
+#define LAPS 10000
+#define INTERVAL 100
+
+#define BENCH_ITEMS 20000
+#define BENCH_WORK 20000
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+}
+
+static volatile long arrived;
+static volatile long rendezvous;
+
+// Waits (up to five seconds) for the other item; only possible if both run at once
+static void
+meet(void *ctxt __attribute__((unused)))
+{
+	double deadline = now() + 5.0;
+
+	__sync_add_and_fetch(&arrived, 1);
+	while (arrived < 2 && now() < deadline) {
+		usleep(1000);
+	}
+	if (arrived >= 2) {
+		__sync_add_and_fetch(&rendezvous, 1);
+	}
+}
+
+static volatile long active_readers;
+static volatile long writer_active;
+static volatile long readers_done;
+static volatile long writers_done;
+static volatile long overlaps;
+static volatile long misordered;
+
+static void
+spin(long n)
+{
+	volatile long i;
+	for (i = 0; i < n; i++) {
+	}
+}
+
+static void
+reader(void *ctxt __attribute__((unused)))
+{
+	__sync_add_and_fetch(&active_readers, 1);
+	if (writer_active) {
+		__sync_add_and_fetch(&overlaps, 1);
+	}
+	spin(100);
+	__sync_add_and_fetch(&readers_done, 1);
+	__sync_sub_and_fetch(&active_readers, 1);
+}
+
+// ctxt is the number of readers submitted before this writer
+static void
+writer(void *ctxt)
+{
+	if (active_readers != 0 || writer_active) {
+		__sync_add_and_fetch(&overlaps, 1);
+	}
+	if (readers_done != (long)(intptr_t)ctxt) {
+		__sync_add_and_fetch(&misordered, 1);
+	}
+	writer_active = 1;
+	spin(1000);
+	writer_active = 0;
+	__sync_add_and_fetch(&writers_done, 1);
+}
+
+static void
+check_finished(void *ctxt __attribute__((unused)))
+{
+	test_long("readers finished before the barrier", readers_done, LAPS);
+	test_long("writers finished before the barrier", writers_done, LAPS / INTERVAL);
+	test_long("no reader or writer overlapped a writer", overlaps, 0);
+	test_long("writers saw exactly the readers submitted before them", misordered, 0);
+}
+
+static void
+work(void *ctxt)
+{
+	spin((long)(intptr_t)ctxt);
+}
+
+static double
+bench(dispatch_queue_t dq)
+{
+	dispatch_group_t group = dispatch_group_create();
+	double start = now();
+	long i;
+
+	for (i = 0; i < BENCH_ITEMS; i++) {
+		dispatch_group_async_f(group, dq, (void *)(intptr_t)BENCH_WORK, work);
+	}
+	dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+	dispatch_release(group);
+
+	return now() - start;
+}
+
+int
+main(void)
+{
+	dispatch_queue_t dq, serial;
+	dispatch_group_t group;
+	double serial_time, concurrent_time;
+	long i;
+
+	test_start("Dispatch Concurrent Queues");
+
+	dq = dispatch_queue_create("com.apple.libdispatch.test_concurrent", DISPATCH_QUEUE_CONCURRENT);
+	test_ptr_notnull("dispatch_queue_create(DISPATCH_QUEUE_CONCURRENT)", dq);
+
+	// two items that can only finish by meeting each other
+	group = dispatch_group_create();
+	dispatch_group_async_f(group, dq, NULL, meet);
+	dispatch_group_async_f(group, dq, NULL, meet);
+	dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+	dispatch_release(group);
+	test_long("items ran concurrently", rendezvous, 2);
+
+	// readers with a barrier writer every INTERVAL readers
+	for (i = 0; i < LAPS; i++) {
+		if (i % INTERVAL == 0 && i != 0) {
+			dispatch_barrier_async_f(dq, (void *)(intptr_t)i, writer);
+		}
+		if (i % 2) {
+			dispatch_async_f(dq, NULL, reader);
+		} else {
+			dispatch_sync_f(dq, NULL, reader);
+		}
+	}
+	dispatch_barrier_async_f(dq, (void *)(intptr_t)LAPS, writer);
+	dispatch_barrier_sync_f(dq, NULL, check_finished);
+
+	// the same independent items on a serial and on a concurrent queue
+	serial = dispatch_queue_create("com.apple.libdispatch.test_concurrent.serial", DISPATCH_QUEUE_SERIAL);
+	serial_time = bench(serial);
+	concurrent_time = bench(dq);
+	printf("%d items of %d iterations:\n", BENCH_ITEMS, BENCH_WORK);
+	printf("\tserial queue:     %8.1f ms (%10.0f items/s)\n", serial_time * 1000.0, BENCH_ITEMS / serial_time);
+	printf("\tconcurrent queue: %8.1f ms (%10.0f items/s)\n", concurrent_time * 1000.0, BENCH_ITEMS / concurrent_time);
+	printf("\tspeedup:          %8.2fx\n", serial_time / concurrent_time);
+
+	dispatch_release(serial);
+	dispatch_release(dq);
+
+	test_stop();
+
+	return 0;
+}
@@ -0,0 +1,178 @@
+/*
+ * @APPLE_APACHE_LICENSE_HEADER_START@
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @APPLE_APACHE_LICENSE_HEADER_END@
+ */
+
+#include "config/config.h"
+
+#include <dispatch/dispatch.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dispatch_test.h"
+
+//
+// Dispatch data objects:
+// - the default destructor copies, other destructors run on the last release,
+// - concatenation and subranges share the bytes of their sources,
+// - mapping is free for a contiguous object and flattens a sparse one.
+//
+
+#define BUF_SIZE 4096
+
+static long destructed;
+
+static void
+destructor(void *buffer)
+{
+	free(buffer);
+	destructed++;
+}
+
+static long regions;
+static size_t region_bytes;
+
+static bool
+count_region(void *ctxt __attribute__((unused)), dispatch_data_t region __attribute__((unused)),
+	size_t offset, const void *buffer __attribute__((unused)), size_t size)
+{
+	if (offset != region_bytes) {
+		return false;
+	}
+	regions++;
+	region_bytes += size;
+	return true;
+}
+
+static bool
+stop_at_first(void *ctxt, dispatch_data_t region __attribute__((unused)),
+	size_t offset __attribute__((unused)), const void *buffer, size_t size __attribute__((unused)))
+{
+	*(const void **)ctxt = buffer;
+	return false;
+}
+
+static void
+count_regions(dispatch_data_t data)
+{
+	regions = 0;
+	region_bytes = 0;
+	dispatch_data_apply_f(data, NULL, count_region);
+}
+
+int
+main(void)
+{
+	dispatch_data_t data, copy, head, tail, whole, sub, map, concat, region;
+	unsigned char *buf, *other;
+	const void *ptr;
+	size_t size, offset, i;
+	bool ok;
+
+	test_start("Dispatch Data");
+
+	buf = malloc(BUF_SIZE);
+	other = malloc(BUF_SIZE);
+	for (i = 0; i < BUF_SIZE; i++) {
+		buf[i] = (unsigned char)i;
+		other[i] = (unsigned char)~i;
+	}
+
+	// the empty object
+	test_long("dispatch_data_empty size", dispatch_data_get_size(dispatch_data_empty), 0);
+	data = dispatch_data_create_f(NULL, 0, NULL, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+	test_ptr("empty buffer gives dispatch_data_empty", data, dispatch_data_empty);
+
+	// the default destructor copies
+	copy = dispatch_data_create_f(buf, BUF_SIZE, NULL, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+	map = dispatch_data_create_map(copy, &ptr, &size);
+	test_long("copy size", size, BUF_SIZE);
+	test_long("copy has its own bytes", ptr != buf, 1);
+	test_long("copy bytes", memcmp(ptr, buf, BUF_SIZE), 0);
+	test_ptr("mapping a leaf returns the leaf", map, copy);
+	dispatch_release(map);
+	dispatch_release(copy);
+
+	// a destructor owns the buffer until the last reference is gone
+	data = dispatch_data_create_f(buf, BUF_SIZE, NULL, destructor);
+	head = dispatch_data_create_subrange(data, 0, BUF_SIZE / 2);
+	tail = dispatch_data_create_subrange(data, BUF_SIZE / 2, BUF_SIZE);
+	test_long("subrange clamped to the end", dispatch_data_get_size(tail), BUF_SIZE / 2);
+	sub = dispatch_data_create_subrange(data, 0, BUF_SIZE);
+	test_ptr("full subrange is the object itself", sub, data);
+	dispatch_release(sub);
+	dispatch_release(data);
+
+	// subranges share the bytes
+	map = dispatch_data_create_map(tail, &ptr, &size);
+	test_ptr("subrange maps in place", ptr, buf + BUF_SIZE / 2);
+	test_long("subrange map size", size, BUF_SIZE / 2);
+	dispatch_release(map);
+
+	// concatenating the halves back merges them into the original object
+	whole = dispatch_data_create_concat(head, tail);
+	test_ptr("adjacent halves concat back to the original object", whole, data);
+	dispatch_release(head);
+	dispatch_release(tail);
+
+	// concatenation of different buffers does not copy
+	copy = dispatch_data_create_f(other, BUF_SIZE, NULL, destructor);
+	concat = dispatch_data_create_concat(whole, copy);
+	test_long("concat size", dispatch_data_get_size(concat), 2 * BUF_SIZE);
+	count_regions(concat);
+	test_long("concat regions", regions, 2);
+	test_long("concat region bytes", region_bytes, 2 * BUF_SIZE);
+	ptr = NULL;
+	ok = dispatch_data_apply_f(concat, (void *)&ptr, stop_at_first);
+	test_long("apply stopped early", ok, 0);
+	test_ptr("first region is the first buffer", ptr, buf);
+
+	// a subrange spanning both buffers
+	sub = dispatch_data_create_subrange(concat, BUF_SIZE - 16, 32);
+	count_regions(sub);
+	test_long("spanning subrange regions", regions, 2);
+	test_long("spanning subrange size", region_bytes, 32);
+	region = dispatch_data_copy_region(sub, 20, &offset);
+	test_long("copy_region offset", offset, 16);
+	test_long("copy_region size", dispatch_data_get_size(region), 16);
+	dispatch_release(region);
+
+	// mapping a sparse object flattens it
+	map = dispatch_data_create_map(sub, &ptr, &size);
+	test_long("flattened size", size, 32);
+	test_long("flattened head", memcmp(ptr, buf + BUF_SIZE - 16, 16), 0);
+	test_long("flattened tail", memcmp((const char *)ptr + 16, other, 16), 0);
+	dispatch_release(map);
+	dispatch_release(sub);
+
+	// concat with empty
+	data = dispatch_data_create_concat(dispatch_data_empty, concat);
+	test_ptr("concat with empty is the other object", data, concat);
+	dispatch_release(data);
+
+	test_long("buffers still alive", destructed, 0);
+	dispatch_release(copy);
+	dispatch_release(whole);
+	test_long("buffers alive while referenced by a concatenation", destructed, 0);
+	dispatch_release(concat);
+	test_long("buffers destroyed with the last reference", destructed, 2);
+
+	test_stop();
+
+	return 0;
+}
@@ -0,0 +1,520 @@
+/*
+ * @APPLE_APACHE_LICENSE_HEADER_START@
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @APPLE_APACHE_LICENSE_HEADER_END@
+ */
+
+#include "config/config.h"
+
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <dispatch/dispatch.h>
+
+#include "dispatch_test.h"
+
+//
+// Dispatch I/O channels:
+// - a stream channel reads a multi-gigabyte (sparse) file end to end in
+//   pieces bounded by the high and low water marks,
+// - a random access channel reads at an offset and writes then reads back
+//   through a barrier,
+// - a pair of stream channels moves data through a pipe,
+// - closing with DISPATCH_IO_STOP cancels what is left,
+// - dispatch_read_f/dispatch_write_f.
+//
+
+#define FILE_SIZE	((off_t)3 << 30)
+#define NUM_MARKS	3
+#define MARK_SIZE	8
+#define MARK_OFFSET(i)	((off_t)(i) * ((off_t)1 << 30) + 4093)
+
+#define HIGH_WATER	(1024 * 1024)
+#define LOW_WATER	(64 * 1024)
+
+#define PIPE_SIZE	(4 * 1024 * 1024 + 17)
+
+static const char marks[NUM_MARKS][MARK_SIZE + 1] = {
+	"mark-one", "mark-two", "markthre",
+};
+
+static dispatch_semaphore_t done_sema;
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+}
+
+static void
+wait_done(const char *desc)
+{
+	long res = dispatch_semaphore_wait(done_sema,
+		dispatch_time(DISPATCH_TIME_NOW, 600 * NSEC_PER_SEC));
+	test_long(desc, res, 0);
+}
+
+static void
+signal_done(void *ctxt __attribute__((unused)))
+{
+	dispatch_semaphore_signal(done_sema);
+}
+
+static void
+cleanup_handler(void *ctxt, int error)
+{
+	test_errno("cleanup handler error", error, 0);
+	if (ctxt) {
+		close((int)(intptr_t)ctxt);
+	}
+	dispatch_semaphore_signal(done_sema);
+}
+
+static int failed_error;
+
+static void
+failed_cleanup_handler(void *ctxt __attribute__((unused)), int error)
+{
+	failed_error = error;
+	dispatch_semaphore_signal(done_sema);
+}
+
+static unsigned char
+pattern(size_t offset)
+{
+	return (unsigned char)(offset * 7 + offset / 251);
+}
+
+static dispatch_data_t
+create_pattern(size_t offset, size_t size)
+{
+	unsigned char *buf = malloc(size);
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		buf[i] = pattern(offset + i);
+	}
+	return dispatch_data_create_f(buf, size, NULL, free);
+}
+
+struct pattern_check {
+	size_t base;
+	size_t bad;
+};
+
+static bool
+check_pattern_region(void *ctxt, dispatch_data_t region __attribute__((unused)),
+	size_t offset, const void *buffer, size_t size)
+{
+	struct pattern_check *pc = ctxt;
+	const unsigned char *p = buffer;
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		if (p[i] != pattern(pc->base + offset + i)) {
+			pc->bad++;
+		}
+	}
+	return true;
+}
+
+static size_t
+check_pattern(dispatch_data_t data, size_t base)
+{
+	struct pattern_check pc = { base, 0 };
+
+	dispatch_data_apply_f(data, &pc, check_pattern_region);
+	return pc.bad;
+}
+
+// Streaming a large file
+
+static struct {
+	off_t position;
+	size_t deliveries;
+	size_t max_size;
+	size_t small;
+	size_t mark_bytes;
+	size_t bad_bytes;
+	int error;
+	bool done;
+} stream;
+
+static bool
+stream_region(void *ctxt __attribute__((unused)),
+	dispatch_data_t region __attribute__((unused)),
+	size_t offset, const void *buffer, size_t size)
+{
+	off_t start = stream.position + (off_t)offset, end = start + (off_t)size;
+	const char *p = buffer;
+	off_t m, o;
+	int i;
+
+	for (i = 0; i < NUM_MARKS; i++) {
+		m = MARK_OFFSET(i);
+		for (o = m > start ? m : start; o < m + MARK_SIZE && o < end; o++) {
+			if (p[o - start] == marks[i][o - m]) {
+				stream.mark_bytes++;
+			} else {
+				stream.bad_bytes++;
+			}
+		}
+	}
+	return true;
+}
+
+static void
+stream_handler(void *ctxt __attribute__((unused)), bool done,
+	dispatch_data_t data, int error)
+{
+	size_t size = data ? dispatch_data_get_size(data) : 0;
+
+	if (size) {
+		stream.deliveries++;
+		if (size > stream.max_size) {
+			stream.max_size = size;
+		}
+		if (size < LOW_WATER && !done) {
+			stream.small++;
+		}
+		dispatch_data_apply_f(data, NULL, stream_region);
+		stream.position += (off_t)size;
+	}
+	if (done) {
+		stream.error = error;
+		stream.done = true;
+		dispatch_semaphore_signal(done_sema);
+	}
+}
+
+static void
+test_stream(const char *path)
+{
+	dispatch_queue_t q = dispatch_get_global_queue(0, 0);
+	dispatch_io_t channel;
+	double start, elapsed;
+
+	channel = dispatch_io_create_with_path_f(DISPATCH_IO_STREAM, path,
+		O_RDONLY, 0, q, NULL, cleanup_handler);
+	test_ptr_notnull("dispatch_io_create_with_path_f", channel);
+	test_long("descriptor before the first read", dispatch_io_get_descriptor(channel), -1);
+	dispatch_io_set_high_water(channel, HIGH_WATER);
+	dispatch_io_set_low_water(channel, LOW_WATER);
+
+	start = now();
+	dispatch_io_read_f(channel, 0, SIZE_MAX, q, NULL, stream_handler);
+	wait_done("stream read finished");
+	elapsed = now() - start;
+
+	test_long("stream read done", stream.done, 1);
+	test_errno("stream read error", stream.error, 0);
+	test_long("stream read bytes (MB)", (long)(stream.position >> 20),
+		(long)(FILE_SIZE >> 20));
+	test_long("stream read bytes", (long)(stream.position - FILE_SIZE), 0);
+	test_long_less_than("largest delivery within the high water mark",
+		(long)stream.max_size, HIGH_WATER + 1);
+	test_long("deliveries below the low water mark", (long)stream.small, 0);
+	test_long("marker bytes", (long)stream.mark_bytes, NUM_MARKS * MARK_SIZE);
+	test_long("corrupt marker bytes", (long)stream.bad_bytes, 0);
+	printf("\t%zu deliveries, %.1f MB/s\n", stream.deliveries,
+		(double)(FILE_SIZE >> 20) / elapsed);
+
+	dispatch_io_close(channel, 0);
+	dispatch_release(channel);
+	wait_done("stream cleanup handler");
+}
+
+// Random access
+
+static struct {
+	dispatch_data_t data;
+	size_t progress;
+	int error;
+} op;
+
+static void
+collect_handler(void *ctxt __attribute__((unused)), bool done,
+	dispatch_data_t data, int error)
+{
+	dispatch_data_t concat;
+
+	if (data && dispatch_data_get_size(data)) {
+		concat = dispatch_data_create_concat(op.data, data);
+		dispatch_release(op.data);
+		op.data = concat;
+	}
+	if (done) {
+		op.error = error;
+		dispatch_semaphore_signal(done_sema);
+	}
+}
+
+static void
+write_handler(void *ctxt __attribute__((unused)), bool done,
+	dispatch_data_t data, int error)
+{
+	if (!done) {
+		op.progress++;
+		return;
+	}
+	op.error = error;
+	test_ptr_null("nothing left to write", data);
+	dispatch_semaphore_signal(done_sema);
+}
+
+static void
+reset_op(void)
+{
+	if (op.data) {
+		dispatch_release(op.data);
+	}
+	op.data = dispatch_data_empty;
+	op.progress = 0;
+	op.error = -1;
+}
+
+static void
+test_random(const char *path, const char *scratch)
+{
+	dispatch_queue_t q = dispatch_get_global_queue(0, 0);
+	dispatch_data_t data, part, concat, map;
+	dispatch_io_t channel;
+	const void *buf;
+	size_t size, offset;
+	int fd;
+
+	// read a marker at an offset of a channel created from a descriptor
+	fd = open(path, O_RDONLY);
+	test_errno("open", fd == -1 ? errno : 0, 0);
+	channel = dispatch_io_create_f(DISPATCH_IO_RANDOM, fd, q,
+		(void *)(intptr_t)fd, cleanup_handler);
+	test_ptr_notnull("dispatch_io_create_f", channel);
+	test_long("dispatch_io_get_descriptor", dispatch_io_get_descriptor(channel), fd);
+
+	reset_op();
+	dispatch_io_read_f(channel, MARK_OFFSET(NUM_MARKS - 1), MARK_SIZE, q, NULL,
+		collect_handler);
+	wait_done("random read finished");
+	test_errno("random read error", op.error, 0);
+	map = dispatch_data_create_map(op.data, &buf, &size);
+	test_long("random read size", (long)size, MARK_SIZE);
+	test_long("random read marker", memcmp(buf, marks[NUM_MARKS - 1], MARK_SIZE), 0);
+	dispatch_release(map);
+
+	// reading past the end is not an error
+	reset_op();
+	dispatch_io_read_f(channel, FILE_SIZE - 4, 16, q, NULL, collect_handler);
+	wait_done("read past the end finished");
+	test_errno("read past the end error", op.error, 0);
+	test_long("read past the end size", (long)dispatch_data_get_size(op.data), 4);
+
+	dispatch_io_close(channel, 0);
+	dispatch_release(channel);
+	wait_done("random cleanup handler");
+
+	// write a data object built from several buffers, then read it back
+	channel = dispatch_io_create_with_path_f(DISPATCH_IO_RANDOM, scratch,
+		O_RDWR | O_CREAT | O_TRUNC, 0600, q, NULL, cleanup_handler);
+	test_ptr_notnull("dispatch_io_create_with_path_f", channel);
+	dispatch_io_set_high_water(channel, HIGH_WATER);
+	data = dispatch_data_empty;
+	for (offset = 0; offset < PIPE_SIZE; offset += size) {
+		size = PIPE_SIZE - offset < 1000003 ? PIPE_SIZE - offset : 1000003;
+		part = create_pattern(offset, size);
+		concat = dispatch_data_create_concat(data, part);
+		dispatch_release(part);
+		dispatch_release(data);
+		data = concat;
+	}
+
+	reset_op();
+	dispatch_io_write_f(channel, 0, data, q, NULL, write_handler);
+	dispatch_release(data);
+	dispatch_io_barrier_f(channel, NULL, signal_done);
+	wait_done("random write finished");
+	wait_done("barrier after the write");
+	test_errno("random write error", op.error, 0);
+	test_long("random write reported progress", op.progress > 0, 1);
+
+	reset_op();
+	dispatch_io_read_f(channel, 0, SIZE_MAX, q, NULL, collect_handler);
+	wait_done("read back finished");
+	test_errno("read back error", op.error, 0);
+	test_long("read back size", (long)dispatch_data_get_size(op.data), PIPE_SIZE);
+	test_long("read back corrupt bytes", (long)check_pattern(op.data, 0), 0);
+
+	// nothing runs once the channel is stopped
+	dispatch_io_close(channel, DISPATCH_IO_STOP);
+	reset_op();
+	dispatch_io_read_f(channel, 0, SIZE_MAX, q, NULL, collect_handler);
+	dispatch_release(channel);
+	wait_done("read after stop finished");
+	wait_done("scratch cleanup handler");
+	test_errno("read after stop error", op.error, ECANCELED);
+}
+
+// Streaming through a pipe
+
+static void
+pipe_write_handler(void *ctxt __attribute__((unused)), bool done,
+	dispatch_data_t data __attribute__((unused)), int error)
+{
+	if (done) {
+		test_errno("pipe write error", error, 0);
+	}
+}
+
+static void
+test_pipe(void)
+{
+	dispatch_queue_t q = dispatch_get_global_queue(0, 0);
+	dispatch_io_t reader, writer, channel;
+	dispatch_data_t data;
+	int fds[2], res;
+
+	res = pipe(fds);
+	test_errno("pipe", res == -1 ? errno : 0, 0);
+
+	reader = dispatch_io_create_f(DISPATCH_IO_STREAM, fds[0], q,
+		(void *)(intptr_t)fds[0], cleanup_handler);
+	writer = dispatch_io_create_f(DISPATCH_IO_STREAM, fds[1], q,
+		(void *)(intptr_t)fds[1], cleanup_handler);
+	test_ptr_notnull("pipe reader", reader);
+	test_ptr_notnull("pipe writer", writer);
+
+	// a pipe cannot be read at an offset
+	channel = dispatch_io_create_f(DISPATCH_IO_RANDOM, fds[0], q, NULL,
+		failed_cleanup_handler);
+	test_ptr_notnull("random access channel on a pipe", channel);
+	test_long("descriptor of a failed channel", dispatch_io_get_descriptor(channel), -1);
+	wait_done("failed channel cleanup handler");
+	test_errno("random access on a pipe", failed_error, ESPIPE);
+	dispatch_release(channel);
+
+	reset_op();
+	dispatch_io_read_f(reader, 0, SIZE_MAX, q, NULL, collect_handler);
+
+	// the writer's cleanup handler closes the write end, ending the read
+	data = create_pattern(0, PIPE_SIZE);
+	dispatch_io_write_f(writer, 0, data, q, NULL, pipe_write_handler);
+	dispatch_release(data);
+	dispatch_io_close(writer, 0);
+	dispatch_release(writer);
+
+	wait_done("pipe read finished");
+	wait_done("pipe writer cleanup handler");
+	test_errno("pipe read error", op.error, 0);
+	test_long("pipe read size", (long)dispatch_data_get_size(op.data), PIPE_SIZE);
+	test_long("pipe corrupt bytes", (long)check_pattern(op.data, 0), 0);
+
+	dispatch_io_close(reader, 0);
+	dispatch_release(reader);
+	wait_done("pipe reader cleanup handler");
+}
+
+// Convenience functions
+
+static void
+convenience_handler(void *ctxt __attribute__((unused)), dispatch_data_t data,
+	int error)
+{
+	if (op.data) {
+		dispatch_release(op.data);
+	}
+	// the write handler gets NULL once everything was written
+	if (!data) {
+		data = dispatch_data_empty;
+	}
+	dispatch_retain(data);
+	op.data = data;
+	op.error = error;
+	dispatch_semaphore_signal(done_sema);
+}
+
+static void
+test_convenience(const char *scratch)
+{
+	dispatch_queue_t q = dispatch_get_global_queue(0, 0);
+	dispatch_data_t data;
+	int fd;
+
+	fd = open(scratch, O_RDWR | O_TRUNC);
+	test_errno("open", fd == -1 ? errno : 0, 0);
+
+	data = create_pattern(0, PIPE_SIZE);
+	dispatch_write_f(fd, data, q, NULL, convenience_handler);
+	dispatch_release(data);
+	wait_done("dispatch_write_f finished");
+	test_errno("dispatch_write_f error", op.error, 0);
+	test_long("dispatch_write_f left nothing", (long)dispatch_data_get_size(op.data), 0);
+
+	lseek(fd, 0, SEEK_SET);
+	dispatch_read_f(fd, SIZE_MAX, q, NULL, convenience_handler);
+	wait_done("dispatch_read_f finished");
+	test_errno("dispatch_read_f error", op.error, 0);
+	test_long("dispatch_read_f size", (long)dispatch_data_get_size(op.data), PIPE_SIZE);
+	test_long("dispatch_read_f corrupt bytes", (long)check_pattern(op.data, 0), 0);
+
+	close(fd);
+}
+
+int
+main(void)
+{
+	char path[] = "/tmp/dispatch_io.XXXXXX";
+	char scratch[] = "/tmp/dispatch_io_scratch.XXXXXX";
+	ssize_t written;
+	int fd, i;
+
+	test_start("Dispatch I/O");
+
+	done_sema = dispatch_semaphore_create(0);
+
+	// a sparse file: only the markers take up disk space
+	fd = mkstemp(path);
+	test_errno("mkstemp", fd == -1 ? errno : 0, 0);
+	test_errno("ftruncate", ftruncate(fd, FILE_SIZE) == -1 ? errno : 0, 0);
+	for (i = 0; i < NUM_MARKS; i++) {
+		written = pwrite(fd, marks[i], MARK_SIZE, MARK_OFFSET(i));
+		test_long("marker written", (long)written, MARK_SIZE);
+	}
+	close(fd);
+	fd = mkstemp(scratch);
+	test_errno("mkstemp", fd == -1 ? errno : 0, 0);
+	close(fd);
+
+	test_stream(path);
+	test_random(path, scratch);
+	test_pipe();
+	test_convenience(scratch);
+
+	reset_op();
+	unlink(path);
+	unlink(scratch);
+	dispatch_release(done_sema);
+
+	test_stop();
+
+	return 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * @APPLE_APACHE_LICENSE_HEADER_START@
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @APPLE_APACHE_LICENSE_HEADER_END@
+ */
+
+#include "config/config.h"
+
+#include <dispatch/dispatch.h>
+#define	__DISPATCH_INDIRECT__
+#include "src/queue_private.h"
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#include "dispatch_test.h"
+
+//
+// The thread pool of the global queues:
+// - a burst of items does not start more threads than there are CPUs,
+// - items submitted from within an item (kept in the thread's local queue)
+//   all run, and idle threads steal them,
+// - a thread blocked in a dispatch wait lets another one take its place, so
+//   that more blocked items than CPUs cannot deadlock the pool,
+// - idle threads park.
+// The counters stay zero where the global queues use kernel workqueues.
+//
+
+#define BURST_ITEMS 100000
+#define FANOUT_ITEMS 10000
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+}
+
+static volatile long executed;
+
+static void
+count(void *ctxt __attribute__((unused)))
+{
+	__sync_add_and_fetch(&executed, 1);
+}
+
+static void
+fanout(void *ctxt)
+{
+	dispatch_group_t group = ctxt;
+	dispatch_queue_t q = dispatch_get_global_queue(0, 0);
+	long i;
+
+	for (i = 0; i < FANOUT_ITEMS; i++) {
+		dispatch_group_async_f(group, q, NULL, count);
+	}
+}
+
+static dispatch_semaphore_t gate;
+static long blockers;
+
+static void
+blocker(void *ctxt __attribute__((unused)))
+{
+	dispatch_semaphore_wait(gate, DISPATCH_TIME_FOREVER);
+	__sync_add_and_fetch(&executed, 1);
+}
+
+static void
+opener(void *ctxt __attribute__((unused)))
+{
+	long i;
+
+	for (i = 0; i < blockers; i++) {
+		dispatch_semaphore_signal(gate);
+	}
+	__sync_add_and_fetch(&executed, 1);
+}
+
+static void
+print_stats(const char *desc, struct dispatch_root_queue_stats_s *stats)
+{
+	printf("\t%s: %lu threads created, %lu steals, %lu parks, %lu unparks\n", desc,
+		(unsigned long)stats->drqs_threads_created, (unsigned long)stats->drqs_steals,
+		(unsigned long)stats->drqs_parks, (unsigned long)stats->drqs_unparks);
+}
+
+int
+main(void)
+{
+	dispatch_queue_t q = dispatch_get_global_queue(0, 0);
+	struct dispatch_root_queue_stats_s before, after;
+	dispatch_group_t group;
+	long i, ncpu, res;
+	double start;
+
+	test_start("Dispatch Thread Pool");
+
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpu < 1) {
+		ncpu = 1;
+	}
+
+	// a burst from outside the pool
+	dispatch_root_queue_get_stats(q, &before);
+	group = dispatch_group_create();
+	executed = 0;
+	start = now();
+	for (i = 0; i < BURST_ITEMS; i++) {
+		dispatch_group_async_f(group, q, NULL, count);
+	}
+	res = dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, 60 * NSEC_PER_SEC));
+	test_long("burst finished", res, 0);
+	test_long("burst items", executed, BURST_ITEMS);
+	printf("\t%d items in %.1f ms\n", BURST_ITEMS, (now() - start) * 1000.0);
+	dispatch_root_queue_get_stats(q, &after);
+	print_stats("burst", &after);
+	test_long_less_than("threads started for the burst",
+		(long)(after.drqs_threads_created - before.drqs_threads_created), ncpu + 1);
+
+	// idle threads park rather than exit
+	usleep(100000);
+	dispatch_root_queue_get_stats(q, &after);
+	if (after.drqs_threads_created) {
+		test_long("idle threads parked", after.drqs_parks > before.drqs_parks, 1);
+	}
+
+	// items submitted by an item of the pool
+	executed = 0;
+	start = now();
+	dispatch_group_async_f(group, q, group, fanout);
+	res = dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, 60 * NSEC_PER_SEC));
+	test_long("fan-out finished", res, 0);
+	test_long("fan-out items", executed, FANOUT_ITEMS);
+	printf("\t%d items in %.1f ms\n", FANOUT_ITEMS, (now() - start) * 1000.0);
+	dispatch_root_queue_get_stats(q, &after);
+	print_stats("fan-out", &after);
+
+	// more blocked items than CPUs, released by an item queued behind them
+	gate = dispatch_semaphore_create(0);
+	blockers = ncpu + 1;
+	executed = 0;
+	for (i = 0; i < blockers; i++) {
+		dispatch_group_async_f(group, q, NULL, blocker);
+	}
+	dispatch_group_async_f(group, q, NULL, opener);
+	res = dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, 60 * NSEC_PER_SEC));
+	test_long("blocked items finished", res, 0);
+	test_long("blocked items", executed, blockers + 1);
+	dispatch_root_queue_get_stats(q, &after);
+	print_stats("blocking", &after);
+
+	dispatch_release(gate);
+	dispatch_release(group);
+
+	test_stop();
+
+	return 0;
+}
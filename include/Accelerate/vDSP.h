@@ -58,6 +58,7 @@ typedef struct vDSP_DFT_SetupStruct {
     vDSP_Length transformLength;
     vDSP_DFT_Direction transformDirection;
     vDSP_DFT_TransformType transformType;
+    void* transformPlan; //Precomputed factorization and twiddle factors, owned by the setup object
 } *vDSP_DFT_Setup;
 
 //Setup object to be fed while computing the DFT/IDFT for a set of double-precision vectors
@@ -65,8 +66,28 @@ typedef struct vDSP_DFT_SetupStructD {
     vDSP_Length transformLength;
     vDSP_DFT_Direction transformDirection;
     vDSP_DFT_TransformType transformType;
+    void* transformPlan; //Precomputed factorization and twiddle factors, owned by the setup object
 } *vDSP_DFT_SetupD;
 
+//Specifies the direction of a transform computed with an FFT setup object
+typedef int FFTDirection;
+enum {
+    kFFTDirection_Forward = +1,
+    kFFTDirection_Inverse = -1
+};
+
+//Specifies the radix an FFT setup object is created for; lengths handled are 2^Log2n, 3*2^Log2n or 5*2^Log2n respectively
+typedef int FFTRadix;
+enum {
+    kFFTRadix2 = 0,
+    kFFTRadix3 = 1,
+    kFFTRadix5 = 2
+};
+
+//Setup objects holding the twiddle factors for every FFT up to the length they were created for
+typedef struct OpaqueFFTSetup* FFTSetup;
+typedef struct OpaqueFFTSetupD* FFTSetupD;
+
 ACCELERATE_EXPORT void vDSP_vabs(const float* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Length N);
 ACCELERATE_EXPORT void vDSP_vabsD(const double* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDSP_Length N);
 ACCELERATE_EXPORT void vDSP_vabsi(const int* A, vDSP_Stride IA, int* C, vDSP_Stride IC, vDSP_Length N);
@@ -205,4 +226,25 @@ ACCELERATE_EXPORT void vDSP_DFT_DestroySetupD(vDSP_DFT_SetupD __Setup);
 ACCELERATE_EXPORT void vDSP_DFT_Execute(const struct vDSP_DFT_SetupStruct *__Setup, const float *__Ir, const float *__Ii, float *__Or,
                                         float *__Oi);
 ACCELERATE_EXPORT void vDSP_DFT_ExecuteD(const struct vDSP_DFT_SetupStructD *__Setup, const double *__Ir, const double *__Ii, double *__Or,
-                                         double *__Oi);
\ No newline at end of file
+                                         double *__Oi);
+
+ACCELERATE_EXPORT FFTSetup vDSP_create_fftsetup(vDSP_Length __Log2n, FFTRadix __Radix);
+ACCELERATE_EXPORT FFTSetupD vDSP_create_fftsetupD(vDSP_Length __Log2n, FFTRadix __Radix);
+ACCELERATE_EXPORT void vDSP_destroy_fftsetup(FFTSetup __setup);
+ACCELERATE_EXPORT void vDSP_destroy_fftsetupD(FFTSetupD __setup);
+ACCELERATE_EXPORT void vDSP_fft_zip(FFTSetup __Setup, const DSPSplitComplex *__C, vDSP_Stride __IC, vDSP_Length __Log2N,
+                                    FFTDirection __Direction);
+ACCELERATE_EXPORT void vDSP_fft_zipD(FFTSetupD __Setup, const DSPDoubleSplitComplex *__C, vDSP_Stride __IC, vDSP_Length __Log2N,
+                                     FFTDirection __Direction);
+ACCELERATE_EXPORT void vDSP_fft_zop(FFTSetup __Setup, const DSPSplitComplex *__A, vDSP_Stride __IA, const DSPSplitComplex *__C,
+                                    vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction);
+ACCELERATE_EXPORT void vDSP_fft_zopD(FFTSetupD __Setup, const DSPDoubleSplitComplex *__A, vDSP_Stride __IA,
+                                     const DSPDoubleSplitComplex *__C, vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction);
+ACCELERATE_EXPORT void vDSP_fft_zrip(FFTSetup __Setup, const DSPSplitComplex *__C, vDSP_Stride __IC, vDSP_Length __Log2N,
+                                     FFTDirection __Direction);
+ACCELERATE_EXPORT void vDSP_fft_zripD(FFTSetupD __Setup, const DSPDoubleSplitComplex *__C, vDSP_Stride __IC, vDSP_Length __Log2N,
+                                      FFTDirection __Direction);
+ACCELERATE_EXPORT void vDSP_fft_zrop(FFTSetup __Setup, const DSPSplitComplex *__A, vDSP_Stride __IA, const DSPSplitComplex *__C,
+                                     vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction);
+ACCELERATE_EXPORT void vDSP_fft_zropD(FFTSetupD __Setup, const DSPDoubleSplitComplex *__A, vDSP_Stride __IA,
+                                      const DSPDoubleSplitComplex *__C, vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction);
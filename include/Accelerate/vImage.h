@@ -76,6 +76,28 @@ ACCELERATE_EXPORT vImage_Error vImageBoxConvolve_ARGB8888(const vImage_Buffer* s
                                                           const Pixel_8888 backgroundColor,
                                                           vImage_Flags flags);
 
+ACCELERATE_EXPORT vImage_Error vImageTentConvolve_ARGB8888(const vImage_Buffer* src,
+                                                           const vImage_Buffer* dest,
+                                                           void* tempBuffer,
+                                                           vImagePixelCount srcOffsetToROI_X,
+                                                           vImagePixelCount srcOffsetToROI_Y,
+                                                           uint32_t kernel_height,
+                                                           uint32_t kernel_width,
+                                                           const Pixel_8888 backgroundColor,
+                                                           vImage_Flags flags);
+
+ACCELERATE_EXPORT vImage_Error vImageConvolve_ARGB8888(const vImage_Buffer* src,
+                                                       const vImage_Buffer* dest,
+                                                       void* tempBuffer,
+                                                       vImagePixelCount srcOffsetToROI_X,
+                                                       vImagePixelCount srcOffsetToROI_Y,
+                                                       const int16_t* kernel,
+                                                       uint32_t kernel_height,
+                                                       uint32_t kernel_width,
+                                                       int32_t divisor,
+                                                       const Pixel_8888 backgroundColor,
+                                                       vImage_Flags flags);
+
 ACCELERATE_EXPORT vImage_Error vImageMatrixMultiply_ARGB8888(const vImage_Buffer* src,
                                                              const vImage_Buffer* dest,
                                                              const int16_t matrix[16],
@@ -15,6 +15,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
 #pragma once
 
 enum {
+    NSFileReadUnknownError = 256,
     NSFileReadCorruptFileError = 259,
     NSFileReadNoSuchFileError = 260,
 
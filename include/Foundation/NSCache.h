@@ -23,16 +23,16 @@
 
 FOUNDATION_EXPORT_CLASS
 @interface NSCache : NSObject
-@property (copy) NSString* name STUB_METHOD;
-- (id)objectForKey:(id)key STUB_METHOD;
-- (void)setObject:(id)obj forKey:(id)key STUB_METHOD;
-- (void)setObject:(id)obj forKey:(id)key cost:(NSUInteger)num STUB_METHOD;
-- (void)removeObjectForKey:(id)key STUB_METHOD;
-- (void)removeAllObjects STUB_METHOD;
-@property NSUInteger countLimit STUB_PROPERTY;
-@property NSUInteger totalCostLimit STUB_PROPERTY;
-@property BOOL evictsObjectsWithDiscardedContent STUB_PROPERTY;
-@property (assign) id<NSCacheDelegate> delegate STUB_PROPERTY;
+@property (copy) NSString* name;
+- (id)objectForKey:(id)key;
+- (void)setObject:(id)obj forKey:(id)key;
+- (void)setObject:(id)obj forKey:(id)key cost:(NSUInteger)num;
+- (void)removeObjectForKey:(id)key;
+- (void)removeAllObjects;
+@property NSUInteger countLimit;
+@property NSUInteger totalCostLimit;
+@property BOOL evictsObjectsWithDiscardedContent;
+@property (assign) id<NSCacheDelegate> delegate;
 @end
 
 @protocol NSCacheDelegate <NSObject>
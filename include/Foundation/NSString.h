@@ -109,6 +109,15 @@ struct _NoOwnStringType {
     uint32_t _length;
     uint32_t _encoding;
 };
+struct _CompactStringType {
+    uint8_t _hashIsCached;
+    uint8_t _isASCII;
+    uint8_t align[2];
+    uint32_t _hashCache;
+    uint32_t _length;
+    const char* _bytes;
+    struct _ConstructedStringData* _unicodeStr;
+};
 
 FOUNDATION_EXPORT_CLASS
 @interface NSString : NSObject <NSCopying, NSMutableCopying, NSSecureCoding> {
@@ -116,6 +125,7 @@ FOUNDATION_EXPORT_CLASS
     union stringData {
         struct _ConstructedStringType ConstructedString;
         struct _NoOwnStringType NoOwnString;
+        struct _CompactStringType CompactString;
     } * u;
     uint32_t strType;
 }
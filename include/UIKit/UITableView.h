@@ -123,7 +123,7 @@ UIKIT_EXPORT_CLASS
 @property (nonatomic) BOOL allowsSelectionDuringEditing STUB_PROPERTY;
 @property (nonatomic) BOOL cellLayoutMarginsFollowReadableWidth STUB_PROPERTY;
 @property (nonatomic) BOOL remembersLastFocusedIndexPath STUB_PROPERTY;
-@property (nonatomic) CGFloat estimatedRowHeight STUB_PROPERTY;
+@property (nonatomic) CGFloat estimatedRowHeight;
 @property (nonatomic) CGFloat estimatedSectionFooterHeight STUB_PROPERTY;
 @property (nonatomic) CGFloat estimatedSectionHeaderHeight STUB_PROPERTY;
 @property (nonatomic) CGFloat rowHeight;
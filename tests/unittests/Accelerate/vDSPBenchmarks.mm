@@ -0,0 +1,220 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+// Microbenchmarks for the vDSP element-wise routines. Each routine is timed with unit stride, which takes the
+// vectorized kernels, and with stride 2, which takes the generic loop. The unit-stride results are also checked against
+// the strided ones so the two paths cannot drift apart.
+
+#include "gtest-api.h"
+#import "Accelerate/Accelerate.h"
+#include <chrono>
+#include <functional>
+#include <vector>
+
+static const vDSP_Length benchmarkLength = 4099; // Not a multiple of any vector width, so the scalar tails run too.
+static const int benchmarkIterations = 200;
+
+template <typename T>
+static void fillBenchmarkInput(std::vector<T>& values, T offset) {
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<T>(sin(static_cast<double>(i) * 0.37)) * 100 + offset;
+    }
+}
+
+// Runs body(stride) benchmarkIterations times and returns nanoseconds per element.
+static double timeKernel(const std::function<void(vDSP_Stride)>& body, vDSP_Stride stride) {
+    body(stride); // Warm up, and let the kernel table get initialized outside of the timed loop.
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < benchmarkIterations; ++i) {
+        body(stride);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    return ns / (static_cast<double>(benchmarkIterations) * benchmarkLength);
+}
+
+static void reportKernel(const char* name, const std::function<void(vDSP_Stride)>& body) {
+    double unit = timeKernel(body, 1);
+    double strided = timeKernel(body, 2);
+    LOG_INFO("%-12s stride 1: %7.3f ns/element (%8.1f Melements/s), stride 2: %7.3f ns/element (%8.1f Melements/s)",
+             name,
+             unit,
+             1000.0 / unit,
+             strided,
+             1000.0 / strided);
+}
+
+template <typename T>
+static void checkUnitAgainstStrided(const std::vector<T>& unit, const std::vector<T>& strided, vDSP_Length n, const char* name) {
+    for (vDSP_Length i = 0; i < n; ++i) {
+        T expected = strided[i * 2];
+        T tolerance = static_cast<T>(0.0001) * (fabs(expected) > 1 ? static_cast<T>(fabs(expected)) : 1);
+        ASSERT_NEAR_MSG(unit[i], expected, tolerance, "TEST FAILED: %s, index %d", name, static_cast<int>(i));
+    }
+}
+
+template <typename T>
+struct BenchmarkBuffers {
+    std::vector<T> a;
+    std::vector<T> b;
+    std::vector<T> c;
+    std::vector<T> unitResult;
+
+    BenchmarkBuffers() : a(benchmarkLength * 2), b(benchmarkLength * 2), c(benchmarkLength * 2), unitResult(benchmarkLength) {
+        fillBenchmarkInput(a, static_cast<T>(0));
+        fillBenchmarkInput(b, static_cast<T>(3));
+    }
+
+    // Runs body with unit stride and with stride 2 and compares the outputs element by element.
+    void verify(const char* name, const std::function<void(const T*, const T*, T*, vDSP_Stride)>& body) {
+        body(a.data(), b.data(), unitResult.data(), 1);
+        std::vector<T> stridedA(benchmarkLength * 2), stridedB(benchmarkLength * 2);
+        for (vDSP_Length i = 0; i < benchmarkLength; ++i) {
+            stridedA[i * 2] = a[i];
+            stridedB[i * 2] = b[i];
+        }
+        body(stridedA.data(), stridedB.data(), c.data(), 2);
+        checkUnitAgainstStrided(unitResult, c, benchmarkLength, name);
+    }
+};
+
+TEST(Accelerate, vDSPBenchmarkFloat) {
+    BenchmarkBuffers<float> buffers;
+    const float* A = buffers.a.data();
+    const float* B = buffers.b.data();
+    float* C = buffers.c.data();
+    const float low = -50.0f;
+    const float high = 40.0f;
+    const float scalar = 1.5f;
+    float result = 0;
+
+    buffers.verify("vDSP_vadd", [](const float* a, const float* b, float* c, vDSP_Stride s) {
+        vDSP_vadd(a, s, b, s, c, s, benchmarkLength);
+    });
+    buffers.verify("vDSP_vmul", [](const float* a, const float* b, float* c, vDSP_Stride s) {
+        vDSP_vmul(a, s, b, s, c, s, benchmarkLength);
+    });
+    buffers.verify("vDSP_vsq", [](const float* a, const float* b, float* c, vDSP_Stride s) { vDSP_vsq(a, s, c, s, benchmarkLength); });
+    buffers.verify("vDSP_vsadd", [&](const float* a, const float* b, float* c, vDSP_Stride s) {
+        vDSP_vsadd(a, s, &scalar, c, s, benchmarkLength);
+    });
+    buffers.verify("vDSP_vsmul", [&](const float* a, const float* b, float* c, vDSP_Stride s) {
+        vDSP_vsmul(a, s, &scalar, c, s, benchmarkLength);
+    });
+    buffers.verify("vDSP_vclip", [&](const float* a, const float* b, float* c, vDSP_Stride s) {
+        vDSP_vclip(a, s, &low, &high, c, s, benchmarkLength);
+    });
+    buffers.verify("vDSP_vabs", [](const float* a, const float* b, float* c, vDSP_Stride s) { vDSP_vabs(a, s, c, s, benchmarkLength); });
+    buffers.verify("vDSP_vneg", [](const float* a, const float* b, float* c, vDSP_Stride s) { vDSP_vneg(a, s, c, s, benchmarkLength); });
+    buffers.verify("vDSP_maxv", [](const float* a, const float* b, float* c, vDSP_Stride s) { vDSP_maxv(a, s, c, benchmarkLength); });
+    buffers.verify("vDSP_measqv", [](const float* a, const float* b, float* c, vDSP_Stride s) { vDSP_measqv(a, s, c, benchmarkLength); });
+    buffers.verify("vDSP_rmsqv", [](const float* a, const float* b, float* c, vDSP_Stride s) { vDSP_rmsqv(a, s, c, benchmarkLength); });
+
+    reportKernel("vDSP_vadd", [&](vDSP_Stride s) { vDSP_vadd(A, s, B, s, C, s, benchmarkLength); });
+    reportKernel("vDSP_vmul", [&](vDSP_Stride s) { vDSP_vmul(A, s, B, s, C, s, benchmarkLength); });
+    reportKernel("vDSP_vsq", [&](vDSP_Stride s) { vDSP_vsq(A, s, C, s, benchmarkLength); });
+    reportKernel("vDSP_vsadd", [&](vDSP_Stride s) { vDSP_vsadd(A, s, &scalar, C, s, benchmarkLength); });
+    reportKernel("vDSP_vsmul", [&](vDSP_Stride s) { vDSP_vsmul(A, s, &scalar, C, s, benchmarkLength); });
+    reportKernel("vDSP_vclip", [&](vDSP_Stride s) { vDSP_vclip(A, s, &low, &high, C, s, benchmarkLength); });
+    reportKernel("vDSP_vabs", [&](vDSP_Stride s) { vDSP_vabs(A, s, C, s, benchmarkLength); });
+    reportKernel("vDSP_vneg", [&](vDSP_Stride s) { vDSP_vneg(A, s, C, s, benchmarkLength); });
+    reportKernel("vDSP_maxv", [&](vDSP_Stride s) { vDSP_maxv(A, s, &result, benchmarkLength); });
+    reportKernel("vDSP_measqv", [&](vDSP_Stride s) { vDSP_measqv(A, s, &result, benchmarkLength); });
+    reportKernel("vDSP_rmsqv", [&](vDSP_Stride s) { vDSP_rmsqv(A, s, &result, benchmarkLength); });
+}
+
+TEST(Accelerate, vDSPBenchmarkDouble) {
+    BenchmarkBuffers<double> buffers;
+    const double* A = buffers.a.data();
+    const double* B = buffers.b.data();
+    double* C = buffers.c.data();
+    const double low = -50.0;
+    const double high = 40.0;
+    const double scalar = 1.5;
+    double result = 0;
+
+    buffers.verify("vDSP_vaddD", [](const double* a, const double* b, double* c, vDSP_Stride s) {
+        vDSP_vaddD(a, s, b, s, c, s, benchmarkLength);
+    });
+    buffers.verify("vDSP_vmulD", [](const double* a, const double* b, double* c, vDSP_Stride s) {
+        vDSP_vmulD(a, s, b, s, c, s, benchmarkLength);
+    });
+    buffers.verify("vDSP_vsqD", [](const double* a, const double* b, double* c, vDSP_Stride s) { vDSP_vsqD(a, s, c, s, benchmarkLength); });
+    buffers.verify("vDSP_vsaddD", [&](const double* a, const double* b, double* c, vDSP_Stride s) {
+        vDSP_vsaddD(a, s, &scalar, c, s, benchmarkLength);
+    });
+    buffers.verify("vDSP_vsmulD", [&](const double* a, const double* b, double* c, vDSP_Stride s) {
+        vDSP_vsmulD(a, s, &scalar, c, s, benchmarkLength);
+    });
+    buffers.verify("vDSP_vclipD", [&](const double* a, const double* b, double* c, vDSP_Stride s) {
+        vDSP_vclipD(a, s, &low, &high, c, s, benchmarkLength);
+    });
+    buffers.verify("vDSP_vabsD", [](const double* a, const double* b, double* c, vDSP_Stride s) {
+        vDSP_vabsD(a, s, c, s, benchmarkLength);
+    });
+    buffers.verify("vDSP_vnegD", [](const double* a, const double* b, double* c, vDSP_Stride s) {
+        vDSP_vnegD(a, s, c, s, benchmarkLength);
+    });
+    buffers.verify("vDSP_maxvD", [](const double* a, const double* b, double* c, vDSP_Stride s) { vDSP_maxvD(a, s, c, benchmarkLength); });
+    buffers.verify("vDSP_measqvD", [](const double* a, const double* b, double* c, vDSP_Stride s) {
+        vDSP_measqvD(a, s, c, benchmarkLength);
+    });
+    buffers.verify("vDSP_rmsqvD", [](const double* a, const double* b, double* c, vDSP_Stride s) {
+        vDSP_rmsqvD(a, s, c, benchmarkLength);
+    });
+
+    reportKernel("vDSP_vaddD", [&](vDSP_Stride s) { vDSP_vaddD(A, s, B, s, C, s, benchmarkLength); });
+    reportKernel("vDSP_vmulD", [&](vDSP_Stride s) { vDSP_vmulD(A, s, B, s, C, s, benchmarkLength); });
+    reportKernel("vDSP_vsqD", [&](vDSP_Stride s) { vDSP_vsqD(A, s, C, s, benchmarkLength); });
+    reportKernel("vDSP_vsaddD", [&](vDSP_Stride s) { vDSP_vsaddD(A, s, &scalar, C, s, benchmarkLength); });
+    reportKernel("vDSP_vsmulD", [&](vDSP_Stride s) { vDSP_vsmulD(A, s, &scalar, C, s, benchmarkLength); });
+    reportKernel("vDSP_vclipD", [&](vDSP_Stride s) { vDSP_vclipD(A, s, &low, &high, C, s, benchmarkLength); });
+    reportKernel("vDSP_vabsD", [&](vDSP_Stride s) { vDSP_vabsD(A, s, C, s, benchmarkLength); });
+    reportKernel("vDSP_vnegD", [&](vDSP_Stride s) { vDSP_vnegD(A, s, C, s, benchmarkLength); });
+    reportKernel("vDSP_maxvD", [&](vDSP_Stride s) { vDSP_maxvD(A, s, &result, benchmarkLength); });
+    reportKernel("vDSP_measqvD", [&](vDSP_Stride s) { vDSP_measqvD(A, s, &result, benchmarkLength); });
+    reportKernel("vDSP_rmsqvD", [&](vDSP_Stride s) { vDSP_rmsqvD(A, s, &result, benchmarkLength); });
+}
+
+TEST(Accelerate, vDSPKernelEdgeCases) {
+    // maxv of all-negative input, and of an empty input, which vDSP defines as -INFINITY.
+    float negatives[] = { -3.0f, -7.5f, -1.25f, -9.0f, -2.0f, -4.0f, -8.0f, -6.0f, -5.0f };
+    float result = 0;
+    vDSP_maxv(negatives, 1, &result, sizeof(negatives) / sizeof(negatives[0]));
+    ASSERT_NEAR_MSG(result, -1.25f, 0.0f, "TEST FAILED: maxv of negative values");
+    vDSP_maxv(negatives, 2, &result, 4);
+    ASSERT_NEAR_MSG(result, -1.25f, 0.0f, "TEST FAILED: strided maxv of negative values");
+    vDSP_maxv(negatives, 1, &result, 0);
+    ASSERT_TRUE_MSG(isinf(result) && result < 0, "TEST FAILED: maxv of no values");
+
+    double negativesD[] = { -3.0, -7.5, -1.25, -9.0, -2.0 };
+    double resultD = 0;
+    vDSP_maxvD(negativesD, 1, &resultD, 5);
+    ASSERT_NEAR_MSG(resultD, -1.25, 0.0, "TEST FAILED: maxvD of negative values");
+
+    // Lengths on either side of every vector width, with the output overwriting the input.
+    for (vDSP_Length n = 0; n < 20; ++n) {
+        std::vector<float> values(n), expected(n);
+        for (vDSP_Length i = 0; i < n; ++i) {
+            values[i] = static_cast<float>(i) - 7.5f;
+            expected[i] = fabsf(values[i]);
+        }
+        vDSP_vabs(values.data(), 1, values.data(), 1, n);
+        for (vDSP_Length i = 0; i < n; ++i) {
+            ASSERT_NEAR_MSG(values[i], expected[i], 0.0f, "TEST FAILED: in-place vabs, length %d", static_cast<int>(n));
+        }
+    }
+}
@@ -17,6 +17,8 @@
 
 #include "gtest-api.h"
 #import "Accelerate/Accelerate.h"
+#include <chrono>
+#include <vector>
 
 // Constants defining array strides and lengths
 const vDSP_Stride strideA = 1;
@@ -1009,3 +1011,155 @@ TEST(Accelerate, vDSP_DFT_LengthCheck) {
     ASSERT_TRUE_MSG(zrop_Setup_Inverse2 == nullptr, "FAILED: vDSP_DFT_zrop_CreateSetup failed!\n");
     vDSP_DFT_DestroySetup(zrop_Setup_Inverse2);
 }
+
+//Reference O(N^2) complex DFT used to validate the FFT based implementation for lengths not covered by recorded results
+static void referenceDFT(const float* inReal, const float* inImag, float* outReal, float* outImag, int length, int direction) {
+    for (int k = 0; k < length; k++) {
+        double real = 0;
+        double imaginary = 0;
+        for (int n = 0; n < length; n++) {
+            double angle = -2 * M_PI * direction * static_cast<double>((static_cast<long long>(k) * n) % length) / length;
+            real += inReal[n] * cos(angle) - inImag[n] * sin(angle);
+            imaginary += inReal[n] * sin(angle) + inImag[n] * cos(angle);
+        }
+
+        outReal[k] = static_cast<float>(real);
+        outImag[k] = static_cast<float>(imaginary);
+    }
+}
+
+static void fillSignal(std::vector<float>& signal, float phase) {
+    for (size_t i = 0; i < signal.size(); i++) {
+        signal[i] = sinf(0.05f * i + phase) + 0.25f * cosf(0.71f * i - phase);
+    }
+}
+
+//Test for validating the complex DFT against the reference for mixed-radix lengths
+TEST(Accelerate, vDSP_DFT_ComplexToComplex_MixedRadix) {
+    const vDSP_Length lengths[] = { 16, 24, 40, 120, 480, 1024 };
+    for (vDSP_Length length : lengths) {
+        for (vDSP_DFT_Direction direction : { vDSP_DFT_FORWARD, vDSP_DFT_INVERSE }) {
+            vDSP_DFT_Setup setup = vDSP_DFT_zop_CreateSetup(NULL, length, direction);
+            ASSERT_TRUE_MSG(setup != nullptr, "FAILED: vDSP_DFT_zop_CreateSetup failed for length %lu!\n", length);
+
+            std::vector<float> inReal(length), inImag(length), outReal(length), outImag(length), expReal(length), expImag(length);
+            fillSignal(inReal, 0.0f);
+            fillSignal(inImag, 1.0f);
+
+            vDSP_DFT_Execute(setup, inReal.data(), inImag.data(), outReal.data(), outImag.data());
+            referenceDFT(inReal.data(), inImag.data(), expReal.data(), expImag.data(), length, direction);
+
+            checkArraySingle(outReal.data(), expReal.data(), length, "DFT_MixedRadix_Real");
+            checkArraySingle(outImag.data(), expImag.data(), length, "DFT_MixedRadix_Imag");
+
+            //In-place execution must produce the same result
+            vDSP_DFT_Execute(setup, inReal.data(), inImag.data(), inReal.data(), inImag.data());
+            checkArraySingle(inReal.data(), expReal.data(), length, "DFT_MixedRadix_InPlace_Real");
+            checkArraySingle(inImag.data(), expImag.data(), length, "DFT_MixedRadix_InPlace_Imag");
+
+            vDSP_DFT_DestroySetup(setup);
+        }
+    }
+}
+
+//Test for validating the split-complex FFT family against the DFT results
+TEST(Accelerate, vDSP_fft_zip_zop) {
+    const vDSP_Length log2n = 10;
+    const vDSP_Length length = 1 << log2n;
+    FFTSetup setup = vDSP_create_fftsetup(log2n, kFFTRadix2);
+    ASSERT_TRUE_MSG(setup != nullptr, "FAILED: vDSP_create_fftsetup failed!\n");
+
+    std::vector<float> inReal(length), inImag(length), expReal(length), expImag(length);
+    fillSignal(inReal, 0.5f);
+    fillSignal(inImag, 2.0f);
+    referenceDFT(inReal.data(), inImag.data(), expReal.data(), expImag.data(), length, vDSP_DFT_FORWARD);
+
+    //Out-of-place, unit stride
+    std::vector<float> outReal(length), outImag(length);
+    DSPSplitComplex input = { inReal.data(), inImag.data() };
+    DSPSplitComplex output = { outReal.data(), outImag.data() };
+    vDSP_fft_zop(setup, &input, 1, &output, 1, log2n, kFFTDirection_Forward);
+    checkArraySingle(outReal.data(), expReal.data(), length, "fft_zop_Real");
+    checkArraySingle(outImag.data(), expImag.data(), length, "fft_zop_Imag");
+
+    //In-place, stride 2
+    std::vector<float> stridedReal(2 * length), stridedImag(2 * length);
+    for (vDSP_Length i = 0; i < length; i++) {
+        stridedReal[2 * i] = inReal[i];
+        stridedImag[2 * i] = inImag[i];
+    }
+
+    DSPSplitComplex strided = { stridedReal.data(), stridedImag.data() };
+    vDSP_fft_zip(setup, &strided, 2, log2n, kFFTDirection_Forward);
+    for (vDSP_Length i = 0; i < length; i++) {
+        ASSERT_NEAR_MSG(stridedReal[2 * i], expReal[i], 0.001, "TEST FAILED: fft_zip_Real AT INDEX %lu", i);
+        ASSERT_NEAR_MSG(stridedImag[2 * i], expImag[i], 0.001, "TEST FAILED: fft_zip_Imag AT INDEX %lu", i);
+    }
+
+    vDSP_destroy_fftsetup(setup);
+}
+
+//Test for validating the packed real FFT: forward results are scaled by 2, a round trip by 2N
+TEST(Accelerate, vDSP_fft_zrip) {
+    const vDSP_Length log2n = 12;
+    const vDSP_Length length = 1 << log2n;
+    FFTSetup setup = vDSP_create_fftsetup(log2n, kFFTRadix2);
+    ASSERT_TRUE_MSG(setup != nullptr, "FAILED: vDSP_create_fftsetup failed!\n");
+
+    std::vector<float> signal(length);
+    fillSignal(signal, 0.25f);
+
+    std::vector<float> real(length / 2), imag(length / 2);
+    DSPSplitComplex packed = { real.data(), imag.data() };
+    vDSP_ctoz(reinterpret_cast<DSPComplex*>(signal.data()), 2, &packed, 1, length / 2);
+
+    //Compare against the real-to-complex DFT, which uses the same packing
+    vDSP_DFT_Setup dftSetup = vDSP_DFT_zrop_CreateSetup(NULL, length, vDSP_DFT_FORWARD);
+    ASSERT_TRUE_MSG(dftSetup != nullptr, "FAILED: vDSP_DFT_zrop_CreateSetup failed!\n");
+    std::vector<float> expReal(length / 2), expImag(length / 2);
+    vDSP_DFT_Execute(dftSetup, real.data(), imag.data(), expReal.data(), expImag.data());
+    vDSP_DFT_DestroySetup(dftSetup);
+
+    vDSP_fft_zrip(setup, &packed, 1, log2n, kFFTDirection_Forward);
+    checkArraySingle(real.data(), expReal.data(), length / 2, "fft_zrip_Real");
+    checkArraySingle(imag.data(), expImag.data(), length / 2, "fft_zrip_Imag");
+
+    vDSP_fft_zrip(setup, &packed, 1, log2n, kFFTDirection_Inverse);
+    for (vDSP_Length i = 0; i < length / 2; i++) {
+        ASSERT_NEAR_MSG(real[i] / (2 * length), signal[2 * i], 0.0001, "TEST FAILED: fft_zrip round trip AT INDEX %lu", 2 * i);
+        ASSERT_NEAR_MSG(imag[i] / (2 * length), signal[2 * i + 1], 0.0001, "TEST FAILED: fft_zrip round trip AT INDEX %lu", 2 * i + 1);
+    }
+
+    vDSP_destroy_fftsetup(setup);
+}
+
+//Benchmark of the 4096-point complex DFT against the reference O(N^2) implementation it replaced
+TEST(Accelerate, vDSP_DFT_Benchmark) {
+    const vDSP_Length length = 4096;
+    const int iterations = 200;
+
+    vDSP_DFT_Setup setup = vDSP_DFT_zop_CreateSetup(NULL, length, vDSP_DFT_FORWARD);
+    ASSERT_TRUE_MSG(setup != nullptr, "FAILED: vDSP_DFT_zop_CreateSetup failed!\n");
+
+    std::vector<float> inReal(length), inImag(length), outReal(length), outImag(length);
+    fillSignal(inReal, 0.0f);
+    fillSignal(inImag, 1.0f);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        vDSP_DFT_Execute(setup, inReal.data(), inImag.data(), outReal.data(), outImag.data());
+    }
+    auto fftTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    referenceDFT(inReal.data(), inImag.data(), outReal.data(), outImag.data(), length, vDSP_DFT_FORWARD);
+    auto referenceTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+    LOG_INFO("vDSP_DFT_Execute(%lu): %lld us per transform, reference DFT: %lld us per transform",
+             length,
+             static_cast<long long>(fftTime / iterations),
+             static_cast<long long>(referenceTime));
+    EXPECT_LT(fftTime / iterations, referenceTime);
+
+    vDSP_DFT_DestroySetup(setup);
+}
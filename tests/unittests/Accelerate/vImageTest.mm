@@ -18,6 +18,9 @@
 #include "gtest-api.h"
 #import <Foundation/Foundation.h>
 #import <Accelerate/Accelerate.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
 
 vImage_Buffer src, dest;
 vImage_Error Error;
@@ -408,4 +411,221 @@ TEST(Accelerate, MatrixMultiply) {
             }
         }
     }
-}
\ No newline at end of file
+}
+//  Brute force reference for the convolution tests below: weights(dy, dx) is applied to every tap of the window and
+//  the result is rounded once.
+template <typename Weight>
+static void referenceConvolve(const vImage_Buffer& source,
+                              const vImage_Buffer& roi,
+                              long offsetX,
+                              long offsetY,
+                              long radiusY,
+                              long radiusX,
+                              Weight weights,
+                              double divisor,
+                              const Pixel_8888 backgroundColor,
+                              vImage_Flags flags) {
+    const uint8_t* in = static_cast<const uint8_t*>(source.data);
+    uint8_t* out = static_cast<uint8_t*>(roi.data);
+    const long width = static_cast<long>(source.width);
+    const long height = static_cast<long>(source.height);
+
+    for (long i = 0; i < static_cast<long>(roi.height); ++i) {
+        for (long j = 0; j < static_cast<long>(roi.width); ++j) {
+            const long y = offsetY + i;
+            const long x = offsetX + j;
+            const uint8_t* center = in + y * source.rowBytes + x * 4;
+            uint8_t* pixel = out + i * roi.rowBytes + j * 4;
+            bool fits = y - radiusY >= 0 && y + radiusY < height && x - radiusX >= 0 && x + radiusX < width;
+            if (!fits && (flags & kvImageCopyInPlace)) {
+                memcpy(pixel, center, 4);
+                continue;
+            }
+
+            double sum[4] = { 0 };
+            double used = 0;
+            double total = 0;
+            for (long dy = -radiusY; dy <= radiusY; ++dy) {
+                for (long dx = -radiusX; dx <= radiusX; ++dx) {
+                    double w = weights(dy, dx);
+                    long sy = y + dy;
+                    long sx = x + dx;
+                    total += w;
+                    const uint8_t* sample;
+                    if (sy >= 0 && sy < height && sx >= 0 && sx < width) {
+                        sample = in + sy * source.rowBytes + sx * 4;
+                    } else if (flags & kvImageTruncateKernel) {
+                        continue;
+                    } else if (flags & kvImageBackgroundColorFill) {
+                        sample = backgroundColor;
+                    } else {
+                        sy = std::min(std::max(sy, 0L), height - 1);
+                        sx = std::min(std::max(sx, 0L), width - 1);
+                        sample = in + sy * source.rowBytes + sx * 4;
+                    }
+                    used += w;
+                    for (int c = 0; c < 4; ++c) {
+                        sum[c] += w * sample[c];
+                    }
+                }
+            }
+
+            double scale = 1.0 / divisor;
+            if ((flags & kvImageTruncateKernel) && used != 0) {
+                scale *= total / used;
+            }
+            for (int c = 0; c < 4; ++c) {
+                double value = sum[c] * scale;
+                pixel[c] = value >= 255 ? 255 : (value <= 0 ? 0 : static_cast<uint8_t>(value + 0.5));
+            }
+        }
+    }
+}
+
+static void checkImagesMatch(const std::vector<uint8_t>& expected, const std::vector<uint8_t>& actual, const char* name) {
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_NEAR_MSG(expected[i], actual[i], 1, "%s: mismatch at byte %d", name, static_cast<int>(i));
+    }
+}
+
+//  Large enough (and tall enough) that the convolutions are split into tiles on multiple threads.
+static const long largeWidth = 301;
+static const long largeHeight = 277;
+
+static std::vector<uint8_t> makeLargeImage() {
+    std::vector<uint8_t> pixels(largeWidth * largeHeight * 4);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        seed = seed * 1103515245 + 12345;
+        pixels[i] = static_cast<uint8_t>(seed >> 16);
+    }
+    return pixels;
+}
+
+TEST(Accelerate, SeparableConvolveMatchesReference) {
+    std::vector<uint8_t> pixels = makeLargeImage();
+    vImage_Buffer source = { pixels.data(), static_cast<vImagePixelCount>(largeHeight), static_cast<vImagePixelCount>(largeWidth),
+                             static_cast<size_t>(largeWidth * 4) };
+
+    const long offsetX = 3;
+    const long offsetY = 5;
+    const long roiWidth = largeWidth - 7;
+    const long roiHeight = largeHeight - 9;
+    std::vector<uint8_t> expected(roiWidth * roiHeight * 4);
+    std::vector<uint8_t> actual(roiWidth * roiHeight * 4);
+    std::vector<uint8_t> untiled(roiWidth * roiHeight * 4);
+    vImage_Buffer expectedBuffer = { expected.data(), static_cast<vImagePixelCount>(roiHeight), static_cast<vImagePixelCount>(roiWidth),
+                                     static_cast<size_t>(roiWidth * 4) };
+    vImage_Buffer actualBuffer = expectedBuffer;
+    actualBuffer.data = actual.data();
+    vImage_Buffer untiledBuffer = expectedBuffer;
+    untiledBuffer.data = untiled.data();
+
+    const vImage_Flags edgeStyles[] = { kvImageCopyInPlace, kvImageTruncateKernel, kvImageBackgroundColorFill, kvImageEdgeExtend };
+    const char* edgeNames[] = { "kvImageCopyInPlace", "kvImageTruncateKernel", "kvImageBackgroundColorFill", "kvImageEdgeExtend" };
+    const uint32_t kernelSizes[][2] = { { 1, 1 }, { 3, 7 }, { 15, 9 }, { 31, 31 } };
+
+    for (const auto& size : kernelSizes) {
+        const long radiusY = size[0] / 2;
+        const long radiusX = size[1] / 2;
+        for (int e = 0; e < 4; ++e) {
+            vImage_Flags flags = edgeStyles[e];
+
+            auto box = [](long, long) { return 1.0; };
+            double boxDivisor = static_cast<double>(size[0] * size[1]);
+            referenceConvolve(source, expectedBuffer, offsetX, offsetY, radiusY, radiusX, box, boxDivisor, background, flags);
+            Error = vImageBoxConvolve_ARGB8888(&source, &actualBuffer, NULL, offsetX, offsetY, size[0], size[1], background, flags);
+            ASSERT_EQ_MSG(kvImageNoError, Error, "vImageBoxConvolve_ARGB8888 failed with %s", edgeNames[e]);
+            checkImagesMatch(expected, actual, edgeNames[e]);
+
+            //  Single threaded, with the caller's temporary buffer
+            vImage_Error tempSize = vImageBoxConvolve_ARGB8888(&source, &untiledBuffer, NULL, offsetX, offsetY, size[0], size[1], background,
+                                                               flags | kvImageDoNotTile | kvImageGetTempBufferSize);
+            ASSERT_TRUE_MSG(tempSize > 0, "kvImageGetTempBufferSize returned %d", static_cast<int>(tempSize));
+            std::vector<uint8_t> temp(tempSize);
+            Error = vImageBoxConvolve_ARGB8888(&source, &untiledBuffer, temp.data(), offsetX, offsetY, size[0], size[1], background,
+                                               flags | kvImageDoNotTile);
+            ASSERT_EQ_MSG(kvImageNoError, Error, "untiled vImageBoxConvolve_ARGB8888 failed with %s", edgeNames[e]);
+            ASSERT_TRUE_MSG(actual == untiled, "tiled and untiled box convolutions differ with %s", edgeNames[e]);
+
+            auto tent = [radiusY, radiusX](long dy, long dx) {
+                return static_cast<double>((radiusY + 1 - std::abs(dy)) * (radiusX + 1 - std::abs(dx)));
+            };
+            double tentDivisor = static_cast<double>((radiusY + 1) * (radiusY + 1) * (radiusX + 1) * (radiusX + 1));
+            referenceConvolve(source, expectedBuffer, offsetX, offsetY, radiusY, radiusX, tent, tentDivisor, background, flags);
+            Error = vImageTentConvolve_ARGB8888(&source, &actualBuffer, NULL, offsetX, offsetY, size[0], size[1], background, flags);
+            ASSERT_EQ_MSG(kvImageNoError, Error, "vImageTentConvolve_ARGB8888 failed with %s", edgeNames[e]);
+            checkImagesMatch(expected, actual, edgeNames[e]);
+        }
+    }
+
+    //  Even kernel sizes and a missing background color are rejected
+    Error = vImageTentConvolve_ARGB8888(&source, &actualBuffer, NULL, 0, 0, 4, 3, background, kvImageEdgeExtend);
+    ASSERT_EQ_MSG(kvImageInvalidKernelSize, Error, "vImageTentConvolve_ARGB8888 accepted an even kernel");
+    Error = vImageBoxConvolve_ARGB8888(&source, &actualBuffer, NULL, 0, 0, 3, 3, NULL, kvImageBackgroundColorFill);
+    ASSERT_EQ_MSG(kvImageNullPointerArgument, Error, "vImageBoxConvolve_ARGB8888 accepted a NULL background color");
+}
+
+TEST(Accelerate, ConvolveMatchesReference) {
+    std::vector<uint8_t> pixels = makeLargeImage();
+    vImage_Buffer source = { pixels.data(), static_cast<vImagePixelCount>(largeHeight), static_cast<vImagePixelCount>(largeWidth),
+                             static_cast<size_t>(largeWidth * 4) };
+    std::vector<uint8_t> expected(pixels.size());
+    std::vector<uint8_t> actual(pixels.size());
+    vImage_Buffer expectedBuffer = source;
+    expectedBuffer.data = expected.data();
+    vImage_Buffer actualBuffer = source;
+    actualBuffer.data = actual.data();
+
+    //  A 3x5 sharpening kernel with negative taps
+    const int16_t kernel[] = { 0, -1, -1, -1, 0,
+                               -1, 2, 4, 2, -1,
+                               0, -1, -1, -1, 0 };
+    const int32_t divisor = 2;
+    auto weights = [&kernel](long dy, long dx) { return static_cast<double>(kernel[(dy + 1) * 5 + (dx + 2)]); };
+
+    const vImage_Flags edgeStyles[] = { kvImageCopyInPlace, kvImageTruncateKernel, kvImageBackgroundColorFill, kvImageEdgeExtend };
+    const char* edgeNames[] = { "kvImageCopyInPlace", "kvImageTruncateKernel", "kvImageBackgroundColorFill", "kvImageEdgeExtend" };
+    for (int e = 0; e < 4; ++e) {
+        referenceConvolve(source, expectedBuffer, 0, 0, 1, 2, weights, divisor, background, edgeStyles[e]);
+        Error = vImageConvolve_ARGB8888(&source, &actualBuffer, NULL, 0, 0, kernel, 3, 5, divisor, background, edgeStyles[e]);
+        ASSERT_EQ_MSG(kvImageNoError, Error, "vImageConvolve_ARGB8888 failed with %s", edgeNames[e]);
+        checkImagesMatch(expected, actual, edgeNames[e]);
+    }
+
+    //  kvImageLeaveAlphaUnchanged keeps the source alpha (the first channel)
+    Error = vImageConvolve_ARGB8888(&source, &actualBuffer, NULL, 0, 0, kernel, 3, 5, divisor, background,
+                                    kvImageEdgeExtend | kvImageLeaveAlphaUnchanged);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "vImageConvolve_ARGB8888 failed with kvImageLeaveAlphaUnchanged");
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        ASSERT_EQ_MSG(pixels[i], actual[i], "Alpha changed at pixel %d", static_cast<int>(i / 4));
+    }
+}
+
+TEST(Accelerate, BoxConvolveBenchmark) {
+    const long width = 1920;
+    const long height = 1080;
+    std::vector<uint8_t> pixels(width * height * 4, 128);
+    std::vector<uint8_t> blurred(pixels.size());
+    vImage_Buffer source = { pixels.data(), static_cast<vImagePixelCount>(height), static_cast<vImagePixelCount>(width),
+                             static_cast<size_t>(width * 4) };
+    vImage_Buffer destination = source;
+    destination.data = blurred.data();
+
+    const uint32_t kernelSizes[] = { 3, 31, 101 };
+    for (uint32_t size : kernelSizes) {
+        for (vImage_Flags tiling : { kvImageNoFlags, kvImageDoNotTile }) {
+            auto start = std::chrono::high_resolution_clock::now();
+            Error = vImageBoxConvolve_ARGB8888(&source, &destination, NULL, 0, 0, size, size, NULL, kvImageEdgeExtend | tiling);
+            auto end = std::chrono::high_resolution_clock::now();
+            ASSERT_EQ_MSG(kvImageNoError, Error, "vImageBoxConvolve_ARGB8888 failed");
+            LOG_INFO("vImageBoxConvolve_ARGB8888 %dx%d, %dx%d kernel%s: %lld us",
+                     static_cast<int>(width),
+                     static_cast<int>(height),
+                     size,
+                     size,
+                     tiling ? ", untiled" : "",
+                     static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()));
+        }
+    }
+}
@@ -0,0 +1,125 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#import <UIKit/UIKit.h>
+#include <TestFramework.h>
+#import <CoreFoundation/CoreFoundation.h>
+#import "CoreTextInternal.h"
+
+static CGSize suggestSize(NSAttributedString* string, CGFloat width) {
+    CTFramesetterRef framesetter = CTFramesetterCreateWithAttributedString((CFAttributedStringRef)string);
+    CGSize size = CTFramesetterSuggestFrameSizeWithConstraints(framesetter, CFRangeMake(0, 0), nullptr, CGSizeMake(width, 1000), nullptr);
+    CFRelease(framesetter);
+    return size;
+}
+
+static NSAttributedString* sampleString(NSString* text) {
+    UIFont* font = [UIFont fontWithName:@"Times New Roman" size:20];
+    return [[[NSAttributedString alloc] initWithString:text attributes:@{ NSFontAttributeName : font }] autorelease];
+}
+
+TEST(CTFramesetter, LineLayoutCacheHitsOnSameContent) {
+    _CTFramesetterResetCache();
+    NSAttributedString* string = sampleString(@"The quick brown fox jumps over the lazy dog");
+
+    CGSize first = suggestSize(string, 150);
+    CGSize second = suggestSize([[string mutableCopy] autorelease], 150);
+    ASSERT_EQ(first.width, second.width);
+    ASSERT_EQ(first.height, second.height);
+
+    _CTFramesetterCacheStatistics statistics;
+    _CTFramesetterGetCacheStatistics(&statistics);
+    ASSERT_EQ(1, statistics.misses);
+    ASSERT_EQ(1, statistics.hits);
+    ASSERT_EQ(1, statistics.count);
+
+    // A different width, or different attributes, is laid out again
+    CGSize wider = suggestSize(string, 1000);
+    ASSERT_LT(wider.height, first.height);
+
+    NSMutableAttributedString* recolored = [[string mutableCopy] autorelease];
+    [recolored addAttribute:NSForegroundColorAttributeName value:[UIColor redColor] range:NSMakeRange(0, 3)];
+    suggestSize(recolored, 150);
+
+    _CTFramesetterGetCacheStatistics(&statistics);
+    ASSERT_EQ(3, statistics.misses);
+    ASSERT_EQ(1, statistics.hits);
+}
+
+TEST(CTFramesetter, LineLayoutCacheFrameMatchesUncached) {
+    _CTFramesetterResetCache();
+    NSAttributedString* string = sampleString(@"one two three four five six seven eight nine ten");
+    CGPathRef path = CGPathCreateWithRect(CGRectMake(0, 0, 120, 500), nullptr);
+
+    CFArrayRef lines[2];
+    CGPoint origins[2][16];
+    for (int i = 0; i < 2; i++) {
+        CTFramesetterRef framesetter = CTFramesetterCreateWithAttributedString((CFAttributedStringRef)string);
+        CTFrameRef frame = CTFramesetterCreateFrame(framesetter, CFRangeMake(0, 0), path, nullptr);
+        lines[i] = (CFArrayRef)CFRetain(CTFrameGetLines(frame));
+        ASSERT_LT(CFArrayGetCount(lines[i]), 16);
+        CTFrameGetLineOrigins(frame, CFRangeMake(0, 0), origins[i]);
+        CFRelease(frame);
+        CFRelease(framesetter);
+    }
+
+    ASSERT_GT(CFArrayGetCount(lines[0]), 1);
+    ASSERT_EQ(CFArrayGetCount(lines[0]), CFArrayGetCount(lines[1]));
+    for (CFIndex i = 0; i < CFArrayGetCount(lines[0]); i++) {
+        CTLineRef cold = (CTLineRef)CFArrayGetValueAtIndex(lines[0], i);
+        CTLineRef warm = (CTLineRef)CFArrayGetValueAtIndex(lines[1], i);
+        ASSERT_EQ(CTLineGetStringRange(cold).location, CTLineGetStringRange(warm).location);
+        ASSERT_EQ(CTLineGetStringRange(cold).length, CTLineGetStringRange(warm).length);
+        ASSERT_EQ(origins[0][i].y, origins[1][i].y);
+    }
+
+    _CTFramesetterCacheStatistics statistics;
+    _CTFramesetterGetCacheStatistics(&statistics);
+    ASSERT_EQ(1, statistics.hits);
+
+    CFRelease(lines[0]);
+    CFRelease(lines[1]);
+    CGPathRelease(path);
+}
+
+TEST(CTFramesetter, LineLayoutCacheEvictsLeastRecentlyUsed) {
+    _CTFramesetterResetCache();
+    _CTFramesetterSetCacheCapacity(2);
+
+    NSAttributedString* a = sampleString(@"a");
+    NSAttributedString* b = sampleString(@"b");
+    NSAttributedString* c = sampleString(@"c");
+
+    suggestSize(a, 100);
+    suggestSize(b, 100);
+    suggestSize(a, 100);
+    suggestSize(c, 100);
+
+    _CTFramesetterCacheStatistics statistics;
+    _CTFramesetterGetCacheStatistics(&statistics);
+    ASSERT_EQ(1, statistics.evictions);
+    ASSERT_EQ(2, statistics.count);
+
+    // b was the least recently used
+    suggestSize(a, 100);
+    suggestSize(b, 100);
+    _CTFramesetterGetCacheStatistics(&statistics);
+    ASSERT_EQ(2, statistics.hits);
+    ASSERT_EQ(4, statistics.misses);
+
+    _CTFramesetterSetCacheCapacity(256);
+    _CTFramesetterResetCache();
+}
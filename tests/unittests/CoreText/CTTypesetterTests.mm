@@ -0,0 +1,107 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#import <UIKit/UIKit.h>
+#include <TestFramework.h>
+#import <CoreFoundation/CoreFoundation.h>
+#include <chrono>
+
+typedef std::chrono::high_resolution_clock BenchmarkClock;
+
+static NSAttributedString* paragraphWithFont(NSString* text, UIFont* font) {
+    return [[[NSAttributedString alloc] initWithString:text attributes:@{ NSFontAttributeName : font }] autorelease];
+}
+
+static double lineWidth(NSAttributedString* string) {
+    CTTypesetterRef ts = CTTypesetterCreateWithAttributedString((CFAttributedStringRef)string);
+    CTLineRef line = CTTypesetterCreateLineWithOffset(ts, CFRangeMake(0, [string length]), 0.0f);
+    double width = CTLineGetTypographicBounds(line, nullptr, nullptr, nullptr);
+    CFRelease(line);
+    CFRelease(ts);
+    return width;
+}
+
+TEST(CTTypesetter, AdvancesFollowFontSize) {
+    UIFont* small = [UIFont fontWithName:@"Times New Roman" size:20];
+    UIFont* large = [UIFont fontWithName:@"Times New Roman" size:40];
+
+    // Interleave the sizes so each measurement comes out of the cache warmed by the other
+    double smallWidth = lineWidth(paragraphWithFont(@"hello world", small));
+    double largeWidth = lineWidth(paragraphWithFont(@"hello world", large));
+    ASSERT_EQ(smallWidth, lineWidth(paragraphWithFont(@"hello world", small)));
+    ASSERT_EQ(largeWidth, lineWidth(paragraphWithFont(@"hello world", large)));
+    ASSERT_NEAR(smallWidth * 2, largeWidth, 1.0);
+
+    // A line spanning both fonts is as wide as its two halves
+    NSMutableAttributedString* mixed = [[paragraphWithFont(@"hello ", small) mutableCopy] autorelease];
+    [mixed appendAttributedString:paragraphWithFont(@"world", large)];
+    ASSERT_NEAR(lineWidth(paragraphWithFont(@"hello ", small)) + lineWidth(paragraphWithFont(@"world", large)), lineWidth(mixed), 0.01);
+}
+
+TEST(CTTypesetter, SuggestLineBreakWithOffset) {
+    UIFont* font = [UIFont fontWithName:@"Times New Roman" size:20];
+    NSAttributedString* string = paragraphWithFont(@"one two three four five six", font);
+    CTTypesetterRef ts = CTTypesetterCreateWithAttributedString((CFAttributedStringRef)string);
+
+    double oneTwo = lineWidth(paragraphWithFont(@"one two", font));
+    ASSERT_EQ(8, CTTypesetterSuggestLineBreakWithOffset(ts, 0, oneTwo + 1, 0.0));
+    ASSERT_EQ([string length], CTTypesetterSuggestLineBreakWithOffset(ts, 0, 10000, 0.0));
+
+    CFRelease(ts);
+}
+
+// Sizes 10k paragraphs, a few fonts and sizes between them, the way a long table view sizes its cells.
+TEST(CTTypesetter, ParagraphLayoutBenchmark) {
+    static const int paragraphCount = 10000;
+
+    NSArray* fonts = @[
+        [UIFont fontWithName:@"Times New Roman" size:14],
+        [UIFont fontWithName:@"Times New Roman" size:17],
+        [UIFont fontWithName:@"Helvetica" size:15],
+        [UIFont boldSystemFontOfSize:15],
+    ];
+
+    NSMutableArray* framesetters = [NSMutableArray arrayWithCapacity:paragraphCount];
+    for (int i = 0; i < paragraphCount; i++) {
+        NSString* text = [NSString stringWithFormat:@"Paragraph %d. The quick brown fox jumps over the lazy dog, then naps for a while "
+                                                    @"in the afternoon sun before heading home for supper at %d o'clock.",
+                                                    i,
+                                                    i % 12 + 1];
+        CTFramesetterRef framesetter =
+            CTFramesetterCreateWithAttributedString((CFAttributedStringRef)paragraphWithFont(text, fonts[i % [fonts count]]));
+        [framesetters addObject:(id)framesetter];
+        CFRelease(framesetter);
+    }
+
+    double passMs[2];
+    CGFloat totalHeight[2] = { 0, 0 };
+    for (int pass = 0; pass < 2; pass++) {
+        auto start = BenchmarkClock::now();
+        for (id framesetter in framesetters) {
+            CGSize size = CTFramesetterSuggestFrameSizeWithConstraints((CTFramesetterRef)framesetter,
+                                                                       CFRangeMake(0, 0),
+                                                                       nullptr,
+                                                                       CGSizeMake(320, CGFLOAT_MAX),
+                                                                       nullptr);
+            totalHeight[pass] += size.height;
+        }
+        passMs[pass] = std::chrono::duration<double, std::milli>(BenchmarkClock::now() - start).count();
+    }
+
+    ASSERT_EQ(totalHeight[0], totalHeight[1]);
+    LOG_INFO("First pass: %8.2f ms", passMs[0]);
+    LOG_INFO("Second pass: %8.2f ms", passMs[1]);
+}
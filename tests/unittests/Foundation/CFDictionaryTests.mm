@@ -0,0 +1,179 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <TestFramework.h>
+#import <Foundation/Foundation.h>
+#import <CoreFoundation/CoreFoundation.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+typedef std::chrono::high_resolution_clock BenchmarkClock;
+
+// Integer keys stored as pointers, with a hash that puts many keys on the same value
+static Boolean collidingEqual(const void* key1, const void* key2) {
+    return key1 == key2;
+}
+
+static CFHashCode collidingHash(const void* key) {
+    return (uintptr_t)key % 16;
+}
+
+static const CFDictionaryKeyCallBacks c_collidingKeyCallBacks = { 0, nullptr, nullptr, nullptr, collidingEqual, collidingHash };
+
+TEST(CFDictionary, CollidingKeys) {
+    CFMutableDictionaryRef dictionary = CFDictionaryCreateMutable(nullptr, 0, &c_collidingKeyCallBacks, nullptr);
+
+    for (uintptr_t i = 1; i <= 1000; i++) {
+        CFDictionarySetValue(dictionary, (const void*)i, (const void*)(i * 2));
+    }
+    ASSERT_EQ(1000, CFDictionaryGetCount(dictionary));
+
+    for (uintptr_t i = 1; i <= 1000; i += 2) {
+        CFDictionaryRemoveValue(dictionary, (const void*)i);
+    }
+    ASSERT_EQ(500, CFDictionaryGetCount(dictionary));
+
+    for (uintptr_t i = 1; i <= 1000; i++) {
+        const void* value = nullptr;
+        ASSERT_EQ(i % 2 == 0, (bool)CFDictionaryGetValueIfPresent(dictionary, (const void*)i, &value));
+        if (i % 2 == 0) {
+            ASSERT_EQ(i * 2, (uintptr_t)value);
+        }
+    }
+    ASSERT_FALSE(CFDictionaryContainsKey(dictionary, (const void*)1001));
+
+    CFDictionaryRemoveAllValues(dictionary);
+    ASSERT_EQ(0, CFDictionaryGetCount(dictionary));
+    CFDictionarySetValue(dictionary, (const void*)7, (const void*)1);
+    ASSERT_EQ(1, (uintptr_t)CFDictionaryGetValue(dictionary, (const void*)7));
+
+    CFRelease(dictionary);
+}
+
+TEST(CFDictionary, EnumeratesInInsertionOrder) {
+    NSMutableDictionary* dictionary = [NSMutableDictionary dictionary];
+    NSMutableArray* expected = [NSMutableArray array];
+    for (int i = 0; i < 100; i++) {
+        NSString* key = [NSString stringWithFormat:@"key%d", i];
+        dictionary[key] = @(i);
+        [expected addObject:key];
+    }
+
+    // Removed keys leave the order of the rest alone; replacing a value keeps the key in place; re-adding goes last
+    for (int i = 0; i < 100; i += 3) {
+        [dictionary removeObjectForKey:expected[i]];
+    }
+    dictionary[@"key1"] = @"replaced";
+    dictionary[@"key0"] = @"readded";
+
+    NSMutableArray* order = [NSMutableArray array];
+    for (int i = 0; i < 100; i++) {
+        if (i % 3 != 0) {
+            [order addObject:expected[i]];
+        }
+    }
+    [order addObject:@"key0"];
+
+    ASSERT_OBJCEQ(order, [dictionary allKeys]);
+
+    NSMutableArray* enumerated = [NSMutableArray array];
+    for (NSString* key in dictionary) {
+        [enumerated addObject:key];
+    }
+    ASSERT_OBJCEQ(order, enumerated);
+    ASSERT_OBJCEQ(@"replaced", dictionary[@"key1"]);
+
+    NSDictionary* copy = [[dictionary copy] autorelease];
+    ASSERT_OBJCEQ(order, [copy allKeys]);
+    ASSERT_OBJCEQ(dictionary, copy);
+}
+
+static std::vector<id> benchmarkKeys(bool strings, int count) {
+    std::vector<id> keys;
+    for (int i = 0; i < count; i++) {
+        keys.push_back(strings ? (id)[NSString stringWithFormat:@"com.example.key.%d", i] : (id)@(i * 7919));
+    }
+    return keys;
+}
+
+static double millisecondsSince(BenchmarkClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(BenchmarkClock::now() - start).count();
+}
+
+// Insert, look up (hits and misses), enumerate and remove. Run it at the previous revision for the numbers of the
+// hash-of-buckets storage this replaced.
+TEST(CFDictionary, Benchmark) {
+    const int sizes[] = { 16, 1000, 100000 };
+    for (bool strings : { true, false }) {
+        for (int size : sizes) {
+            @autoreleasepool {
+                std::vector<id> keys = benchmarkKeys(strings, size);
+                std::vector<id> misses = benchmarkKeys(strings, size * 2);
+                int rounds = std::max(1, 1000000 / size);
+
+                auto start = BenchmarkClock::now();
+                NSMutableDictionary* dictionary = nil;
+                for (int round = 0; round < rounds; round++) {
+                    [dictionary release];
+                    dictionary = [NSMutableDictionary new];
+                    for (id key : keys) {
+                        [dictionary setObject:key forKey:key];
+                    }
+                }
+                double insertMs = millisecondsSince(start);
+
+                int found = 0;
+                start = BenchmarkClock::now();
+                for (int round = 0; round < rounds; round++) {
+                    for (int i = 0; i < size; i++) {
+                        found += [dictionary objectForKey:keys[i]] != nil;
+                        found += [dictionary objectForKey:misses[size + i]] != nil;
+                    }
+                }
+                double lookupMs = millisecondsSince(start);
+                ASSERT_EQ(size * rounds, found);
+
+                int enumerated = 0;
+                start = BenchmarkClock::now();
+                for (int round = 0; round < rounds; round++) {
+                    for (id key in dictionary) {
+                        enumerated += key != nil;
+                    }
+                }
+                double enumerateMs = millisecondsSince(start);
+                ASSERT_EQ(size * rounds, enumerated);
+
+                start = BenchmarkClock::now();
+                for (id key : keys) {
+                    [dictionary removeObjectForKey:key];
+                }
+                double removeMs = millisecondsSince(start);
+                ASSERT_EQ(0, [dictionary count]);
+                [dictionary release];
+
+                double operations = (double)size * rounds;
+                LOG_INFO("%s keys x %6d: insert %6.1f ns, lookup %6.1f ns, enumerate %5.1f ns, remove %6.1f ns per key",
+                         strings ? "NSString" : "NSNumber",
+                         size,
+                         insertMs * 1e6 / operations,
+                         lookupMs * 1e6 / (operations * 2),
+                         enumerateMs * 1e6 / operations,
+                         removeMs * 1e6 / size);
+            }
+        }
+    }
+}
@@ -0,0 +1,256 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <TestFramework.h>
+#import <Foundation/Foundation.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+@interface NSCacheTestDelegate : NSObject <NSCacheDelegate>
+@property (retain) NSMutableArray* evicted;
+@end
+
+@implementation NSCacheTestDelegate
+- (instancetype)init {
+    if (self = [super init]) {
+        _evicted = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [_evicted release];
+    [super dealloc];
+}
+
+- (void)cache:(NSCache*)cache willEvictObject:(id)obj {
+    [_evicted addObject:obj];
+}
+@end
+
+@interface NSCacheTestContent : NSObject <NSDiscardableContent>
+@property BOOL discarded;
+@end
+
+@implementation NSCacheTestContent
+- (BOOL)beginContentAccess {
+    return !_discarded;
+}
+
+- (void)endContentAccess {
+}
+
+- (void)discardContentIfPossible {
+    _discarded = YES;
+}
+
+- (BOOL)isContentDiscarded {
+    return _discarded;
+}
+@end
+
+TEST(NSCache, SetGetRemove) {
+    NSCache* cache = [[NSCache new] autorelease];
+    cache.name = @"test";
+    ASSERT_OBJCEQ(@"test", cache.name);
+
+    [cache setObject:@"one" forKey:@1];
+    [cache setObject:@"two" forKey:@"2"];
+    ASSERT_OBJCEQ(@"one", [cache objectForKey:@1]);
+    ASSERT_OBJCEQ(@"two", [cache objectForKey:[NSMutableString stringWithString:@"2"]]);
+    ASSERT_EQ(nil, [cache objectForKey:@3]);
+
+    [cache setObject:@"uno" forKey:@1];
+    ASSERT_OBJCEQ(@"uno", [cache objectForKey:@1]);
+
+    [cache removeObjectForKey:@1];
+    ASSERT_EQ(nil, [cache objectForKey:@1]);
+
+    [cache removeAllObjects];
+    ASSERT_EQ(nil, [cache objectForKey:@"2"]);
+}
+
+TEST(NSCache, CountLimitEvictsLeastRecentlyUsed) {
+    NSCache* cache = [[NSCache new] autorelease];
+    NSCacheTestDelegate* delegate = [[NSCacheTestDelegate new] autorelease];
+    cache.delegate = delegate;
+    cache.countLimit = 3;
+
+    [cache setObject:@"a" forKey:@"a"];
+    [cache setObject:@"b" forKey:@"b"];
+    [cache setObject:@"c" forKey:@"c"];
+    ASSERT_OBJCEQ(@"a", [cache objectForKey:@"a"]);
+
+    [cache setObject:@"d" forKey:@"d"];
+    ASSERT_EQ(nil, [cache objectForKey:@"b"]);
+    ASSERT_OBJCEQ(@"a", [cache objectForKey:@"a"]);
+    ASSERT_OBJCEQ(@"c", [cache objectForKey:@"c"]);
+    ASSERT_OBJCEQ(@"d", [cache objectForKey:@"d"]);
+    ASSERT_OBJCEQ(@[ @"b" ], delegate.evicted);
+
+    // Lowering the limit evicts right away
+    cache.countLimit = 1;
+    ASSERT_EQ(nil, [cache objectForKey:@"a"]);
+    ASSERT_EQ(nil, [cache objectForKey:@"c"]);
+    ASSERT_OBJCEQ(@"d", [cache objectForKey:@"d"]);
+
+    cache.delegate = nil;
+}
+
+TEST(NSCache, EvictionFollowsLookupOrderAcrossShards) {
+    NSCache* cache = [[NSCache new] autorelease];
+    NSCacheTestDelegate* delegate = [[NSCacheTestDelegate new] autorelease];
+    cache.delegate = delegate;
+
+    // Enough keys to cover every shard several times, looked up with no insertions in between and in an order
+    // unrelated to insertion or hashing
+    static const int keyCount = 64;
+    for (int i = 0; i < keyCount; i++) {
+        [cache setObject:@(i) forKey:[NSString stringWithFormat:@"key%d", i]];
+    }
+
+    NSMutableArray* lookupOrder = [NSMutableArray array];
+    for (int i = 0; i < keyCount; i++) {
+        int key = (i * 37) % keyCount;
+        ASSERT_OBJCEQ(@(key), [cache objectForKey:[NSString stringWithFormat:@"key%d", key]]);
+        [lookupOrder addObject:@(key)];
+    }
+
+    // Objects are evicted in exactly the order they were last looked up
+    cache.countLimit = 8;
+    ASSERT_OBJCEQ([lookupOrder subarrayWithRange:NSMakeRange(0, keyCount - 8)], delegate.evicted);
+    for (NSNumber* key in [lookupOrder subarrayWithRange:NSMakeRange(keyCount - 8, 8)]) {
+        ASSERT_OBJCEQ(key, [cache objectForKey:[NSString stringWithFormat:@"key%@", key]]);
+    }
+
+    cache.delegate = nil;
+}
+
+TEST(NSCache, TotalCostLimit) {
+    NSCache* cache = [[NSCache new] autorelease];
+    cache.totalCostLimit = 100;
+
+    for (int i = 0; i < 10; i++) {
+        [cache setObject:@(i) forKey:@(i) cost:30];
+    }
+
+    int present = 0;
+    for (int i = 0; i < 10; i++) {
+        if ([cache objectForKey:@(i)]) {
+            present++;
+        }
+    }
+    ASSERT_EQ(3, present);
+    ASSERT_OBJCEQ(@9, [cache objectForKey:@9]);
+
+    // Replacing an object updates its cost
+    [cache setObject:@"big" forKey:@9 cost:100];
+    ASSERT_OBJCEQ(@"big", [cache objectForKey:@9]);
+    ASSERT_EQ(nil, [cache objectForKey:@8]);
+}
+
+TEST(NSCache, DiscardableContent) {
+    NSCache* cache = [[NSCache new] autorelease];
+    NSCacheTestContent* content = [[NSCacheTestContent new] autorelease];
+    [cache setObject:content forKey:@"content"];
+    ASSERT_EQ(content, [cache objectForKey:@"content"]);
+
+    // Objects whose content was discarded are dropped on lookup
+    content.discarded = YES;
+    ASSERT_EQ(nil, [cache objectForKey:@"content"]);
+
+    cache.evictsObjectsWithDiscardedContent = NO;
+    [cache setObject:content forKey:@"content"];
+    ASSERT_EQ(content, [cache objectForKey:@"content"]);
+
+    // Eviction asks discardable content to discard itself
+    NSCacheTestContent* evicted = [[NSCacheTestContent new] autorelease];
+    cache.countLimit = 1;
+    [cache setObject:evicted forKey:@"evicted"];
+    [cache setObject:@"newer" forKey:@"newer"];
+    ASSERT_TRUE(evicted.discarded);
+}
+
+TEST(NSCache, MemoryWarningPurges) {
+    NSCache* cache = [[NSCache new] autorelease];
+    [cache setObject:@"value" forKey:@"key"];
+
+    [[NSNotificationCenter defaultCenter] postNotificationName:@"UIApplicationDidReceiveMemoryWarningNotification" object:nil];
+    ASSERT_EQ(nil, [cache objectForKey:@"key"]);
+}
+
+// Many threads looking up a shared working set while a few threads keep inserting and the cache keeps evicting.
+TEST(NSCache, ContentionBenchmark) {
+    static const int keyCount = 4096;
+    static const int lookupsPerThread = 200000;
+
+    NSCache* cache = [[NSCache new] autorelease];
+    cache.countLimit = keyCount;
+
+    std::vector<NSNumber*> keys;
+    for (int i = 0; i < keyCount; i++) {
+        keys.push_back([NSNumber numberWithInt:i]);
+        [cache setObject:keys.back() forKey:keys.back()];
+    }
+
+    const unsigned threadCounts[] = { 1, 2, 4, 8, 16 };
+    for (unsigned readers : threadCounts) {
+        std::atomic<bool> stop{ false };
+        std::atomic<int> misses{ 0 };
+
+        std::thread writer([&]() {
+            @autoreleasepool {
+                for (int i = keyCount; !stop.load(); i++) {
+                    @autoreleasepool {
+                        NSNumber* key = [NSNumber numberWithInt:i];
+                        [cache setObject:key forKey:key];
+                    }
+                }
+            }
+        });
+
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < readers; t++) {
+            threads.emplace_back([&, t]() {
+                unsigned seed = t * 2654435761u + 1;
+                for (int i = 0; i < lookupsPerThread; i++) {
+                    @autoreleasepool {
+                        seed = seed * 1103515245u + 12345u;
+                        if ([cache objectForKey:keys[(seed >> 8) % keyCount]] == nil) {
+                            misses++;
+                        }
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        stop = true;
+        writer.join();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        LOG_INFO("%2u reader(s): %10.0f lookups/s, %5.1f%% misses",
+                 readers,
+                 readers * lookupsPerThread / seconds,
+                 100.0 * misses.load() / (readers * lookupsPerThread));
+    }
+}
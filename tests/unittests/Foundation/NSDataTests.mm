@@ -14,13 +14,17 @@
 //
 //******************************************************************************
 
+#include <windows.h>
+#include <psapi.h>
 #import <TestFramework.h>
 #import <Starboard.h>
 
+#import <Foundation/Foundation.h>
 #import <Foundation/NSString.h>
 #import <Foundation/NSData.h>
 #import <Foundation/NSMutableData.h>
 #import <Foundation/NSURL.h>
+#include <chrono>
 
 // TODO: BUG 5403859: Enable ARC on this test file once load order issue is fixed
 
@@ -267,3 +271,335 @@ TEST(NSData, MutableDataReplaceTests) {
     ASSERT_OBJCEQ_MSG(expectedHex, [originalData description], "Description must be equal");
     ASSERT_OBJCEQ_MSG(expectedHex, [mutableData description], "Description must be equal");
 }
+
+static NSString* writeTemporaryFile(NSString* name, NSData* data) {
+    NSArray* cachesPaths = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSAllDomainsMask, YES);
+    NSString* path = cachesPaths[0];
+    [[NSFileManager defaultManager] createDirectoryAtPath:path withIntermediateDirectories:YES attributes:nil error:nil];
+
+    NSString* file = [path stringByAppendingPathComponent:name];
+    [data writeToFile:file atomically:NO];
+    return file;
+}
+
+static NSData* patternData(size_t length) {
+    NSMutableData* data = [NSMutableData dataWithLength:length];
+    uint8_t* bytes = (uint8_t*)[data mutableBytes];
+    for (size_t i = 0; i < length; i++) {
+        bytes[i] = (uint8_t)(i * 31 + (i >> 12));
+    }
+    return data;
+}
+
+TEST(NSData, MappedFile) {
+    NSData* expected = patternData(256 * 1024 + 17);
+    NSString* file = writeTemporaryFile(@"mapped.bin", expected);
+
+    NSDataReadingOptions options[] = { 0, NSDataReadingMappedIfSafe, NSDataReadingMappedAlways };
+    for (NSDataReadingOptions option : options) {
+        NSData* data = [NSData dataWithContentsOfFile:file options:option error:nullptr];
+        ASSERT_OBJCEQ(expected, data);
+    }
+    ASSERT_OBJCEQ(expected, [NSData dataWithContentsOfMappedFile:file]);
+
+    // Mutable data reads the file whatever the options say, so it can be written to
+    NSMutableData* mutableData = [NSMutableData dataWithContentsOfFile:file options:NSDataReadingMappedAlways error:nullptr];
+    ASSERT_OBJCEQ(expected, mutableData);
+    ((uint8_t*)[mutableData mutableBytes])[0] ^= 0xFF;
+    [mutableData appendBytes:"x" length:1];
+    ASSERT_EQ([expected length] + 1, [mutableData length]);
+
+    // Small and empty files
+    NSString* smallFile = writeTemporaryFile(@"mappedSmall.bin", [NSData dataWithBytes:"abc" length:3]);
+    ASSERT_OBJCEQ([NSData dataWithBytes:"abc" length:3], [NSData dataWithContentsOfFile:smallFile options:NSDataReadingMappedIfSafe error:nullptr]);
+    ASSERT_OBJCEQ([NSData dataWithBytes:"abc" length:3], [NSData dataWithContentsOfMappedFile:smallFile]);
+    NSString* emptyFile = writeTemporaryFile(@"mappedEmpty.bin", [NSData data]);
+    ASSERT_EQ(0, [[NSData dataWithContentsOfMappedFile:emptyFile] length]);
+
+    NSError* error = nil;
+    ASSERT_OBJCEQ(nil, [NSData dataWithContentsOfFile:[file stringByAppendingString:@".missing"] options:NSDataReadingMappedAlways error:&error]);
+    ASSERT_OBJCNE(nil, error);
+}
+
+TEST(NSData, SubdataSharesBytes) {
+    NSData* expected = patternData(256 * 1024);
+    NSString* file = writeTemporaryFile(@"subdata.bin", expected);
+    NSRange range = NSMakeRange(4096 + 3, 100000);
+
+    NSData* slice = nil;
+    NSData* sliceOfSlice = nil;
+    @autoreleasepool {
+        NSData* sources[] = { [NSData dataWithData:expected], [NSData dataWithContentsOfMappedFile:file] };
+        for (NSData* source : sources) {
+            NSData* subdata = [source subdataWithRange:range];
+            ASSERT_EQ((const uint8_t*)[source bytes] + range.location, [subdata bytes]);
+            ASSERT_OBJCEQ([NSData dataWithBytes:(const uint8_t*)[expected bytes] + range.location length:range.length], subdata);
+        }
+
+        // Slices outlive the data they came from
+        slice = [[sources[1] subdataWithRange:range] retain];
+        sliceOfSlice = [[slice subdataWithRange:NSMakeRange(10, 20)] retain];
+    }
+    ASSERT_OBJCEQ([NSData dataWithBytes:(const uint8_t*)[expected bytes] + range.location length:range.length], slice);
+    ASSERT_EQ((const uint8_t*)[slice bytes] + 10, [sliceOfSlice bytes]);
+    [slice release];
+    ASSERT_OBJCEQ([NSData dataWithBytes:(const uint8_t*)[expected bytes] + range.location + 10 length:20], sliceOfSlice);
+    [sliceOfSlice release];
+
+    // Mutable data, and bytes the data doesn't own, are copied
+    NSMutableData* mutableData = [NSMutableData dataWithData:expected];
+    NSData* mutableSlice = [mutableData subdataWithRange:NSMakeRange(0, 16)];
+    ASSERT_NE([mutableData bytes], [mutableSlice bytes]);
+    ((uint8_t*)[mutableData mutableBytes])[0] ^= 0xFF;
+    ASSERT_EQ(((const uint8_t*)[expected bytes])[0], ((const uint8_t*)[mutableSlice bytes])[0]);
+
+    char buffer[16] = "borrowed bytes";
+    NSData* borrowed = [NSData dataWithBytesNoCopy:buffer length:sizeof(buffer) freeWhenDone:NO];
+    ASSERT_NE((const void*)buffer, [[borrowed subdataWithRange:NSMakeRange(0, 8)] bytes]);
+
+    ASSERT_EQ(0, [[expected subdataWithRange:NSMakeRange([expected length], 0)] length]);
+    EXPECT_ANY_THROW([expected subdataWithRange:NSMakeRange([expected length] - 1, 2)]);
+    EXPECT_ANY_THROW([expected subdataWithRange:NSMakeRange(NSUIntegerMax, 2)]);
+}
+
+TEST(NSData, EnumerateByteRanges) {
+    NSData* expected = patternData(128 * 1024);
+    NSData* mapped = [NSData dataWithContentsOfMappedFile:writeTemporaryFile(@"enumerate.bin", expected)];
+
+    NSData* datas[] = { expected, mapped, [mapped subdataWithRange:NSMakeRange(7, 1000)] };
+    for (NSData* data : datas) {
+        __block size_t covered = 0;
+        __block int calls = 0;
+        [data enumerateByteRangesUsingBlock:^(const void* bytes, NSRange byteRange, BOOL* stop) {
+            ASSERT_EQ(covered, byteRange.location);
+            ASSERT_EQ(0, memcmp(bytes, (const uint8_t*)[data bytes] + byteRange.location, byteRange.length));
+            covered += byteRange.length;
+            calls++;
+        }];
+        ASSERT_EQ([data length], covered);
+        ASSERT_EQ(1, calls);
+    }
+
+    __block int emptyCalls = 0;
+    [[NSData data] enumerateByteRangesUsingBlock:^(const void* bytes, NSRange byteRange, BOOL* stop) {
+        emptyCalls++;
+    }];
+    ASSERT_EQ(0, emptyCalls);
+}
+
+static size_t privateBytes() {
+    PROCESS_MEMORY_COUNTERS_EX counters = {};
+    GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&counters, sizeof(counters));
+    return counters.PrivateUsage;
+}
+
+// Loads a large asset-sized file read and mapped, then takes slices of it and reads one byte per page, the way a
+// bundle of packed resources is used. Private bytes is the memory the process can't give back to the file.
+TEST(NSData, MappedFileBenchmark) {
+    static const size_t fileLength = 128 * 1024 * 1024;
+    static const size_t sliceLength = 1024 * 1024;
+
+    NSString* file = nil;
+    @autoreleasepool {
+        file = [writeTemporaryFile(@"benchmark.bin", patternData(fileLength)) retain];
+    }
+
+    NSDataReadingOptions options[] = { 0, NSDataReadingMappedIfSafe };
+    for (NSDataReadingOptions option : options) {
+        @autoreleasepool {
+            size_t before = privateBytes();
+            auto start = std::chrono::high_resolution_clock::now();
+            NSData* data = [NSData dataWithContentsOfFile:file options:option error:nullptr];
+            double loadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            ASSERT_EQ(fileLength, [data length]);
+
+            start = std::chrono::high_resolution_clock::now();
+            unsigned checksum = 0;
+            for (size_t offset = 0; offset < fileLength; offset += sliceLength) {
+                NSData* slice = [data subdataWithRange:NSMakeRange(offset, sliceLength)];
+                const uint8_t* bytes = (const uint8_t*)[slice bytes];
+                for (size_t i = 0; i < sliceLength; i += 4096) {
+                    checksum += bytes[i];
+                }
+            }
+            double sliceMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            size_t after = privateBytes();
+
+            LOG_INFO("%-24s load %8.2f ms, slice and touch %8.2f ms, %8.1f MB private (checksum %u)",
+                     option ? "NSDataReadingMappedIfSafe" : "read",
+                     loadMs,
+                     sliceMs,
+                     (double)(after - before) / (1024 * 1024),
+                     checksum);
+        }
+    }
+
+    [[NSFileManager defaultManager] removeItemAtPath:file error:nil];
+    [file release];
+}
+
+TEST(NSData, Base64LargeData) {
+    // Long enough for every vector width, with every tail length
+    for (size_t length = 4000; length < 4003; length++) {
+        NSData* data = patternData(length);
+        NSString* encoded = [data base64EncodedStringWithOptions:0];
+        ASSERT_EQ((length + 2) / 3 * 4, [encoded length]);
+        ASSERT_OBJCEQ(data, [[[NSData alloc] initWithBase64EncodedString:encoded options:0] autorelease]);
+
+        // Each line is 76 characters but the last, and decoding needs to skip the line breaks
+        NSString* wrapped = [data base64EncodedStringWithOptions:NSDataBase64Encoding76CharacterLineLength];
+        NSArray* lines = [wrapped componentsSeparatedByString:@"\r\n"];
+        for (NSUInteger i = 0; i + 1 < [lines count]; i++) {
+            ASSERT_EQ(76, [lines[i] length]);
+        }
+        ASSERT_OBJCEQ(encoded, [lines componentsJoinedByString:@""]);
+        ASSERT_OBJCEQ(nil, [[[NSData alloc] initWithBase64EncodedString:wrapped options:0] autorelease]);
+        ASSERT_OBJCEQ(data,
+                      [[[NSData alloc] initWithBase64EncodedString:wrapped options:NSDataBase64DecodingIgnoreUnknownCharacters] autorelease]);
+
+        NSData* encodedData = [data base64EncodedDataWithOptions:NSDataBase64Encoding64CharacterLineLength];
+        ASSERT_OBJCEQ([[data base64EncodedStringWithOptions:NSDataBase64Encoding64CharacterLineLength] dataUsingEncoding:NSUTF8StringEncoding],
+                      encodedData);
+        ASSERT_OBJCEQ(data,
+                      [[[NSData alloc] initWithBase64EncodedData:encodedData options:NSDataBase64DecodingIgnoreUnknownCharacters] autorelease]);
+    }
+
+    // Characters outside the alphabet anywhere in a long string, and misplaced padding
+    NSString* encoded = [patternData(3000) base64EncodedStringWithOptions:0];
+    NSString* invalid[] = { @"%", @"é", @"=", @"-", @"_" };
+    for (NSString* character : invalid) {
+        for (NSUInteger location : { 0, 17, 1000, 3990 }) {
+            NSString* corrupted = [encoded stringByReplacingCharactersInRange:NSMakeRange(location, 1) withString:character];
+            ASSERT_OBJCEQ(nil, [[[NSData alloc] initWithBase64EncodedString:corrupted options:0] autorelease]);
+        }
+    }
+    const unichar embeddedNul[] = { 'Q', 'U', 'F', 'B', 0, 'Q', 'U', 'F', 'B' };
+    NSString* withNul = [NSString stringWithCharacters:embeddedNul length:sizeof(embeddedNul) / sizeof(embeddedNul[0])];
+    ASSERT_OBJCEQ(nil, [[[NSData alloc] initWithBase64EncodedString:withNul options:0] autorelease]);
+    ASSERT_OBJCEQ(nil, [[[NSData alloc] initWithBase64EncodedString:@"QUF" options:0] autorelease]);
+}
+
+static NSRange naiveRangeOfData(NSData* data, NSData* needle, NSDataSearchOptions options, NSRange range) {
+    const uint8_t* bytes = (const uint8_t*)[data bytes];
+    NSUInteger length = [needle length];
+    NSRange found = NSMakeRange(NSNotFound, 0);
+    if (length == 0 || length > range.length) {
+        return found;
+    }
+
+    for (NSUInteger i = range.location; i + length <= NSMaxRange(range); i++) {
+        bool anchoredOut = (options & NSDataSearchAnchored) &&
+                           ((options & NSDataSearchBackwards) ? i + length != NSMaxRange(range) : i != range.location);
+        if (!anchoredOut && memcmp(bytes + i, [needle bytes], length) == 0) {
+            found = NSMakeRange(i, length);
+            if (!(options & NSDataSearchBackwards)) {
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+TEST(NSData, RangeOfData) {
+    NSData* data = [@"abracadabra, abracadabra" dataUsingEncoding:NSUTF8StringEncoding];
+    NSData* abra = [@"abra" dataUsingEncoding:NSUTF8StringEncoding];
+    NSRange all = NSMakeRange(0, [data length]);
+
+    ASSERT_EQ(0, [data rangeOfData:abra options:0 range:all].location);
+    ASSERT_EQ(4, [data rangeOfData:abra options:0 range:all].length);
+    ASSERT_EQ(20, [data rangeOfData:abra options:NSDataSearchBackwards range:all].location);
+    ASSERT_EQ(7, [data rangeOfData:abra options:0 range:NSMakeRange(1, 23)].location);
+    ASSERT_EQ(13, [data rangeOfData:abra options:NSDataSearchBackwards range:NSMakeRange(0, 23)].location);
+    ASSERT_EQ(0, [data rangeOfData:abra options:NSDataSearchAnchored range:all].location);
+    ASSERT_EQ(NSNotFound, [data rangeOfData:abra options:NSDataSearchAnchored range:NSMakeRange(1, 23)].location);
+    ASSERT_EQ(20, [data rangeOfData:abra options:NSDataSearchAnchored | NSDataSearchBackwards range:all].location);
+    ASSERT_EQ(NSNotFound, [data rangeOfData:abra options:NSDataSearchAnchored | NSDataSearchBackwards range:NSMakeRange(0, 23)].location);
+    ASSERT_EQ(NSNotFound, [data rangeOfData:[NSData data] options:0 range:all].location);
+    ASSERT_EQ(NSNotFound, [data rangeOfData:abra options:0 range:NSMakeRange(0, 3)].location);
+
+    EXPECT_ANY_THROW([data rangeOfData:abra options:0 range:NSMakeRange(1, [data length])]);
+    EXPECT_ANY_THROW([data rangeOfData:nil options:0 range:all]);
+
+    // Random data over a small alphabet, so there are plenty of partial matches, against a plain scan
+    unsigned seed = 7;
+    auto next = [&seed]() {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 8;
+    };
+    for (int i = 0; i < 500; i++) {
+        NSMutableData* haystack = [NSMutableData dataWithLength:next() % 300];
+        for (NSUInteger j = 0; j < [haystack length]; j++) {
+            ((uint8_t*)[haystack mutableBytes])[j] = "ab\x00"[next() % 3];
+        }
+        NSMutableData* needle = [NSMutableData dataWithLength:1 + next() % 6];
+        for (NSUInteger j = 0; j < [needle length]; j++) {
+            ((uint8_t*)[needle mutableBytes])[j] = "ab\x00"[next() % 3];
+        }
+
+        NSUInteger location = [haystack length] ? next() % [haystack length] : 0;
+        NSRange range = NSMakeRange(location, next() % ([haystack length] - location + 1));
+        NSDataSearchOptions options[] = { 0, NSDataSearchBackwards, NSDataSearchAnchored, NSDataSearchAnchored | NSDataSearchBackwards };
+        for (NSDataSearchOptions option : options) {
+            NSRange expected = naiveRangeOfData(haystack, needle, option, range);
+            NSRange found = [haystack rangeOfData:needle options:option range:range];
+            ASSERT_EQ(expected.location, found.location);
+            ASSERT_EQ(expected.length, found.length);
+        }
+    }
+}
+
+// Throughput of a payload the size of a large image upload, and of searching it for a marker near the end.
+TEST(NSData, Base64AndSearchBenchmark) {
+    static const size_t length = 32 * 1024 * 1024;
+    static const int rounds = 5;
+
+    NSData* data = patternData(length);
+    NSDataBase64EncodingOptions options[] = { 0, NSDataBase64Encoding76CharacterLineLength };
+    for (NSDataBase64EncodingOptions option : options) {
+        double encodeSeconds = 0;
+        double decodeSeconds = 0;
+        for (int round = 0; round < rounds; round++) {
+            @autoreleasepool {
+                auto start = std::chrono::high_resolution_clock::now();
+                NSData* encoded = [data base64EncodedDataWithOptions:option];
+                encodeSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+                start = std::chrono::high_resolution_clock::now();
+                NSData* decoded = [[[NSData alloc] initWithBase64EncodedData:encoded options:option ? NSDataBase64DecodingIgnoreUnknownCharacters : 0] autorelease];
+                decodeSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+                ASSERT_EQ(length, [decoded length]);
+            }
+        }
+
+        LOG_INFO("base64 %-10s encode %8.1f MB/s, decode %8.1f MB/s",
+                 option ? "76/line" : "one line",
+                 length * rounds / encodeSeconds / (1024 * 1024),
+                 length * rounds / decodeSeconds / (1024 * 1024));
+    }
+
+    // Pseudo-random bytes with a boundary marker near the end, and another near the start for backwards searches
+    NSMutableData* haystack = [NSMutableData dataWithLength:length];
+    unsigned seed = 1;
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1103515245u + 12345u;
+        ((uint8_t*)[haystack mutableBytes])[i] = (uint8_t)(seed >> 16);
+    }
+    static const char forwardMarker[] = "--boundary-forwards--";
+    static const char backwardMarker[] = "--boundary-backwards--";
+    [haystack replaceBytesInRange:NSMakeRange(length - 100, strlen(forwardMarker)) withBytes:forwardMarker];
+    [haystack replaceBytesInRange:NSMakeRange(100, strlen(backwardMarker)) withBytes:backwardMarker];
+
+    NSData* markers[] = { [NSData dataWithBytes:forwardMarker length:strlen(forwardMarker)],
+                          [NSData dataWithBytes:backwardMarker length:strlen(backwardMarker)] };
+    NSDataSearchOptions searchOptions[] = { 0, NSDataSearchBackwards };
+    for (int i = 0; i < 2; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        NSRange found;
+        for (int round = 0; round < rounds; round++) {
+            found = [haystack rangeOfData:markers[i] options:searchOptions[i] range:NSMakeRange(0, length)];
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        ASSERT_EQ(i == 0 ? length - 100 : 100, found.location);
+        LOG_INFO("rangeOfData %-10s %8.1f MB/s", i == 0 ? "forwards" : "backwards", (length - 200) * rounds / seconds / (1024 * 1024));
+    }
+}
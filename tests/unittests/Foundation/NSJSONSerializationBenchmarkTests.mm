@@ -0,0 +1,129 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+// Compares NSJSONSerialization with parsing through Windows.Data.Json, which it used to convert through. The
+// Windows.Data.Json figure stops once the IJsonValue tree is built; converting that tree into Foundation objects, as the
+// old implementation did, would only add to it.
+
+#include <TestFramework.h>
+#import <Foundation/Foundation.h>
+
+#include <COMIncludes.h>
+#include <wrl\client.h>
+#include <wrl\wrappers\corewrappers.h>
+#include <windows.data.json.h>
+#include <COMIncludes_End.h>
+
+#include <chrono>
+#include <vector>
+
+using namespace ABI::Windows::Data::Json;
+using namespace Microsoft::WRL;
+using namespace Windows::Foundation;
+
+typedef std::chrono::high_resolution_clock BenchmarkClock;
+
+// An API response shaped payload: many records with repeated keys, nested arrays and a mix of value types.
+static NSData* largeJSONPayload() {
+    NSMutableArray* items = [NSMutableArray array];
+    for (int i = 0; i < 20000; i++) {
+        [items addObject:@{
+            @"id" : @(i),
+            @"title" : [NSString stringWithFormat:@"Item number %d with a reasonably long title \u00e9", i],
+            @"price" : @(i * 1.25),
+            @"available" : @(i % 3 != 0),
+            @"tags" : @[ @"alpha", @"beta", [NSString stringWithFormat:@"tag%d", i % 50] ],
+            @"owner" : @{ @"name" : [NSString stringWithFormat:@"user%d", i % 977], @"verified" : @(i % 2 == 0), @"avatar" : [NSNull null] },
+        }];
+    }
+
+    return [NSJSONSerialization dataWithJSONObject:@{ @"count" : @([items count]), @"items" : items } options:0 error:nullptr];
+}
+
+static double millisecondsSince(BenchmarkClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(BenchmarkClock::now() - start).count();
+}
+
+TEST(NSJSONSerialization, ParseBenchmark) {
+    NSData* data = largeJSONPayload();
+    LOG_INFO("Payload is %.1f MB", [data length] / (1024.0 * 1024.0));
+
+    // Windows.Data.Json: decode to UTF-16, then build an IJsonValue tree
+    auto start = BenchmarkClock::now();
+    @autoreleasepool {
+        ComPtr<IJsonValueStatics> jsonValueStatics;
+        ASSERT_TRUE(SUCCEEDED(
+            GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Data_Json_JsonValue).Get(), &jsonValueStatics)));
+
+        NSString* string = [[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] autorelease];
+        std::vector<wchar_t> characters([string length] + 1, 0);
+        [string getCharacters:reinterpret_cast<unichar*>(characters.data()) range:NSMakeRange(0, [string length])];
+
+        boolean didParse = false;
+        ComPtr<IJsonValue> result;
+        ASSERT_TRUE(SUCCEEDED(jsonValueStatics->TryParse(Wrappers::HStringReference(characters.data(), [string length]).Get(),
+                                                         &result,
+                                                         &didParse)));
+        ASSERT_TRUE(didParse);
+    }
+    double windowsMs = millisecondsSince(start);
+
+    start = BenchmarkClock::now();
+    @autoreleasepool {
+        NSDictionary* result = [NSJSONSerialization JSONObjectWithData:data options:0 error:nullptr];
+        ASSERT_EQ(20000, [[result objectForKey:@"items"] count]);
+    }
+    double dataMs = millisecondsSince(start);
+
+    start = BenchmarkClock::now();
+    @autoreleasepool {
+        NSInputStream* stream = [NSInputStream inputStreamWithData:data];
+        [stream open];
+        NSDictionary* result = [NSJSONSerialization JSONObjectWithStream:stream options:0 error:nullptr];
+        [stream close];
+        ASSERT_EQ(20000, [[result objectForKey:@"items"] count]);
+    }
+    double streamMs = millisecondsSince(start);
+
+    LOG_INFO("Windows.Data.Json parse only: %8.2f ms", windowsMs);
+    LOG_INFO("JSONObjectWithData:           %8.2f ms", dataMs);
+    LOG_INFO("JSONObjectWithStream:         %8.2f ms", streamMs);
+}
+
+TEST(NSJSONSerialization, WriteBenchmark) {
+    NSData* data = largeJSONPayload();
+    id object = [NSJSONSerialization JSONObjectWithData:data options:0 error:nullptr];
+
+    auto start = BenchmarkClock::now();
+    @autoreleasepool {
+        NSData* written = [NSJSONSerialization dataWithJSONObject:object options:0 error:nullptr];
+        ASSERT_EQ([data length], [written length]);
+    }
+    double dataMs = millisecondsSince(start);
+
+    start = BenchmarkClock::now();
+    @autoreleasepool {
+        NSOutputStream* stream = [NSOutputStream outputStreamToMemory];
+        [stream open];
+        NSInteger written = [NSJSONSerialization writeJSONObject:object toStream:stream options:0 error:nullptr];
+        [stream close];
+        ASSERT_EQ([data length], written);
+    }
+    double streamMs = millisecondsSince(start);
+
+    LOG_INFO("dataWithJSONObject:           %8.2f ms", dataMs);
+    LOG_INFO("writeJSONObject:toStream:     %8.2f ms", streamMs);
+}
@@ -164,4 +164,110 @@ TEST(Foundation, ValidJSONObjectTests) {
     ASSERT_EQ(YES, [NSJSONSerialization isValidJSONObject:testObject6]);
     ASSERT_EQ(YES, [NSJSONSerialization isValidJSONObject:testObject7]);
     ASSERT_EQ(NO, [NSJSONSerialization isValidJSONObject:testObject8]);
-}
\ No newline at end of file
+}
+
+TEST(Foundation, JSONObjectWithDataEscapesAndNumbers) {
+    NSString* json = @"{\"text\":\"caf\\u00e9 \\ud83d\\ude00 \\\"q\\\" \\\\ \\/ \\n\",\"utf8\":\"caf\u00e9\",\"numbers\":[0,-1,1.5,-2.5e3,"
+                     @"9223372036854775807,18446744073709551615],\"flags\":[true,false,null]}";
+    NSError* err = nil;
+    NSDictionary* result = [NSJSONSerialization JSONObjectWithData:[json dataUsingEncoding:NSUTF8StringEncoding] options:0 error:&err];
+
+    ASSERT_EQ(nil, err);
+    ASSERT_OBJCEQ(@"caf\u00e9 \U0001F600 \"q\" \\ / \n", [result objectForKey:@"text"]);
+    ASSERT_OBJCEQ(@"caf\u00e9", [result objectForKey:@"utf8"]);
+
+    NSArray* numbers = [result objectForKey:@"numbers"];
+    ASSERT_EQ(0, [numbers[0] intValue]);
+    ASSERT_EQ(-1, [numbers[1] intValue]);
+    ASSERT_EQ(1.5, [numbers[2] doubleValue]);
+    ASSERT_EQ(-2500.0, [numbers[3] doubleValue]);
+    ASSERT_EQ(LLONG_MAX, [numbers[4] longLongValue]);
+    ASSERT_EQ(ULLONG_MAX, [numbers[5] unsignedLongLongValue]);
+
+    NSArray* flags = [result objectForKey:@"flags"];
+    ASSERT_OBJCEQ([NSNumber numberWithBool:YES], flags[0]);
+    ASSERT_OBJCEQ([NSNumber numberWithBool:NO], flags[1]);
+    ASSERT_OBJCEQ([NSNull null], flags[2]);
+
+    // Malformed numbers, escapes and encodings
+    NSString* invalidDescription = @"Invalid JSON string.";
+    VerifyJSONObjectWithDataFails(@"[01]", 0, 3840, invalidDescription);
+    VerifyJSONObjectWithDataFails(@"[1.]", 0, 3840, invalidDescription);
+    VerifyJSONObjectWithDataFails(@"[\"\\x\"]", 0, 3840, invalidDescription);
+    VerifyJSONObjectWithDataFails(@"[1,]", 0, 3840, invalidDescription);
+    VerifyJSONObjectWithDataFails(@"[1] 2", 0, 3840, invalidDescription);
+    VerifyJSONObjectWithDataFails(@"", 0, 3840, invalidDescription);
+
+    NSData* overlong = [NSData dataWithBytes:"[\"\xC0\x80\"]" length:6];
+    ASSERT_EQ(nil, [NSJSONSerialization JSONObjectWithData:overlong options:0 error:nullptr]);
+}
+
+TEST(Foundation, JSONObjectWithDataMutability) {
+    NSData* data = [@"{\"list\":[\"a\"],\"name\":\"b\"}" dataUsingEncoding:NSUTF8StringEncoding];
+
+    NSDictionary* immutable = [NSJSONSerialization JSONObjectWithData:data options:0 error:nullptr];
+    ASSERT_FALSE([immutable isKindOfClass:[NSMutableDictionary class]]);
+    ASSERT_FALSE([[immutable objectForKey:@"list"] isKindOfClass:[NSMutableArray class]]);
+
+    NSDictionary* containers = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingMutableContainers error:nullptr];
+    ASSERT_TRUE([containers isKindOfClass:[NSMutableDictionary class]]);
+    ASSERT_TRUE([[containers objectForKey:@"list"] isKindOfClass:[NSMutableArray class]]);
+    ASSERT_FALSE([[containers objectForKey:@"name"] isKindOfClass:[NSMutableString class]]);
+
+    NSDictionary* leaves = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingMutableLeaves error:nullptr];
+    ASSERT_TRUE([[leaves objectForKey:@"name"] isKindOfClass:[NSMutableString class]]);
+}
+
+TEST(Foundation, JSONObjectWithStreamTests) {
+    NSMutableArray* records = [NSMutableArray array];
+    for (int i = 0; i < 5000; i++) {
+        [records addObject:@{ @"id" : @(i), @"name" : [NSString stringWithFormat:@"record \u00e9 %d", i], @"ok" : @(i % 2 == 0) }];
+    }
+    NSData* data = [NSJSONSerialization dataWithJSONObject:records options:0 error:nullptr];
+    ASSERT_GT([data length], 64 * 1024u);
+
+    NSInputStream* stream = [NSInputStream inputStreamWithData:data];
+    [stream open];
+    NSError* err = nil;
+    id result = [NSJSONSerialization JSONObjectWithStream:stream options:0 error:&err];
+    [stream close];
+
+    ASSERT_EQ(nil, err);
+    ASSERT_OBJCEQ(records, result);
+
+    NSInputStream* invalidStream = [NSInputStream inputStreamWithData:[@"{\"a\":" dataUsingEncoding:NSUTF8StringEncoding]];
+    [invalidStream open];
+    ASSERT_EQ(nil, [NSJSONSerialization JSONObjectWithStream:invalidStream options:0 error:&err]);
+    ASSERT_EQ(3840, [err code]);
+    [invalidStream close];
+}
+
+TEST(Foundation, WriteJSONObjectToStreamTests) {
+    id object = @{ @"text" : @"caf\u00e9 \U0001F600 \"q\"\n/", @"values" : @[ @1, @-2, @1.5, @YES, [NSNull null] ] };
+
+    NSOutputStream* stream = [NSOutputStream outputStreamToMemory];
+    [stream open];
+    NSError* err = nil;
+    NSInteger written = [NSJSONSerialization writeJSONObject:object toStream:stream options:0 error:&err];
+    NSData* streamed = [stream propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
+    [stream close];
+
+    NSData* expected = [NSJSONSerialization dataWithJSONObject:object options:0 error:nullptr];
+    ASSERT_EQ(nil, err);
+    ASSERT_EQ([expected length], written);
+    ASSERT_OBJCEQ(expected, streamed);
+    ASSERT_OBJCEQ(object, [NSJSONSerialization JSONObjectWithData:streamed options:0 error:nullptr]);
+
+    NSString* text = [[[NSString alloc] initWithData:expected encoding:NSUTF8StringEncoding] autorelease];
+    ASSERT_TRUE([text rangeOfString:@"\"caf\u00e9 \U0001F600 \\\"q\\\"\\n\\/\""].location != NSNotFound);
+    ASSERT_TRUE([text rangeOfString:@"[1,-2,1.5,true,null]"].location != NSNotFound);
+}
+
+TEST(Foundation, DataWithJSONObjectPrettyPrinted) {
+    NSData* data = [NSJSONSerialization dataWithJSONObject:@[ @{ @"a" : @1 }, @[] ] options:NSJSONWritingPrettyPrinted error:nullptr];
+    NSString* text = [[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] autorelease];
+    ASSERT_OBJCEQ(@"[\n  {\n    \"a\" : 1\n  },\n  [\n\n  ]\n]", text);
+
+    VerifyDataWithJSONObjectThrows(@[ (NSNumber*)kCFNumberNaN ]);
+    VerifyDataWithJSONObjectThrows(@{ @1 : @"non-string key" });
+}
@@ -0,0 +1,220 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <TestFramework.h>
+#import <Foundation/Foundation.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+@interface NSNotificationCenterTestObserver : NSObject
+@property (retain) NSMutableArray* received;
+@property (copy) NSString* tag;
+@end
+
+@implementation NSNotificationCenterTestObserver
+- (instancetype)initWithLog:(NSMutableArray*)log tag:(NSString*)tag {
+    if (self = [super init]) {
+        _received = [log retain];
+        _tag = [tag copy];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [_received release];
+    [_tag release];
+    [super dealloc];
+}
+
+- (void)receive:(NSNotification*)notification {
+    [_received addObject:_tag];
+}
+@end
+
+TEST(NSNotificationCenter, DeliversByNameAndSenderInRegistrationOrder) {
+    NSNotificationCenter* center = [[NSNotificationCenter new] autorelease];
+    NSMutableArray* log = [NSMutableArray array];
+    NSObject* sender = [[NSObject new] autorelease];
+    NSObject* otherSender = [[NSObject new] autorelease];
+
+    NSNotificationCenterTestObserver* anySender = [[[NSNotificationCenterTestObserver alloc] initWithLog:log tag:@"anySender"] autorelease];
+    NSNotificationCenterTestObserver* fromSender =
+        [[[NSNotificationCenterTestObserver alloc] initWithLog:log tag:@"fromSender"] autorelease];
+    NSNotificationCenterTestObserver* anyName = [[[NSNotificationCenterTestObserver alloc] initWithLog:log tag:@"anyName"] autorelease];
+    NSNotificationCenterTestObserver* other = [[[NSNotificationCenterTestObserver alloc] initWithLog:log tag:@"other"] autorelease];
+
+    [center addObserver:fromSender selector:@selector(receive:) name:@"test" object:sender];
+    [center addObserver:anyName selector:@selector(receive:) name:nil object:sender];
+    [center addObserver:anySender selector:@selector(receive:) name:@"test" object:nil];
+    [center addObserver:other selector:@selector(receive:) name:@"other" object:nil];
+
+    [center postNotificationName:[NSMutableString stringWithString:@"test"] object:sender];
+    ASSERT_OBJCEQ((@[ @"fromSender", @"anyName", @"anySender" ]), log);
+
+    [log removeAllObjects];
+    [center postNotificationName:@"test" object:otherSender];
+    ASSERT_OBJCEQ(@[ @"anySender" ], log);
+
+    [log removeAllObjects];
+    [center postNotificationName:@"other" object:sender];
+    ASSERT_OBJCEQ((@[ @"anyName", @"other" ]), log);
+
+    [center removeObserver:fromSender];
+    [center removeObserver:anyName];
+    [center removeObserver:anySender];
+    [center removeObserver:other];
+}
+
+TEST(NSNotificationCenter, RemoveObserver) {
+    NSNotificationCenter* center = [[NSNotificationCenter new] autorelease];
+    NSMutableArray* log = [NSMutableArray array];
+    NSObject* sender = [[NSObject new] autorelease];
+    NSNotificationCenterTestObserver* observer = [[[NSNotificationCenterTestObserver alloc] initWithLog:log tag:@"observer"] autorelease];
+
+    [center addObserver:observer selector:@selector(receive:) name:@"a" object:nil];
+    [center addObserver:observer selector:@selector(receive:) name:@"a" object:sender];
+    [center addObserver:observer selector:@selector(receive:) name:@"b" object:nil];
+
+    // Only the observation for that sender goes away
+    [center removeObserver:observer name:@"a" object:sender];
+    [center postNotificationName:@"a" object:sender];
+    ASSERT_EQ(1, [log count]);
+
+    [center removeObserver:observer name:@"a" object:nil];
+    [center postNotificationName:@"a" object:sender];
+    [center postNotificationName:@"b" object:sender];
+    ASSERT_EQ(2, [log count]);
+
+    [center removeObserver:observer];
+    [center postNotificationName:@"b" object:nil];
+    ASSERT_EQ(2, [log count]);
+}
+
+TEST(NSNotificationCenter, ObserversChangingTheCenterDuringPost) {
+    __block NSNotificationCenter* center = [[NSNotificationCenter new] autorelease];
+    __block int secondCalls = 0;
+    __block int addedCalls = 0;
+    __block id second = nil;
+    __block id added = nil;
+
+    id first = [center addObserverForName:@"test"
+                                   object:nil
+                                    queue:nil
+                               usingBlock:^(NSNotification* notification) {
+                                   // A later observer removed mid-post is not called; one added mid-post waits for the next post
+                                   [center removeObserver:second];
+                                   if (added == nil) {
+                                       added = [center addObserverForName:@"test"
+                                                                   object:nil
+                                                                    queue:nil
+                                                               usingBlock:^(NSNotification* notification) {
+                                                                   addedCalls++;
+                                                               }];
+                                   }
+                               }];
+    second = [center addObserverForName:@"test"
+                                 object:nil
+                                  queue:nil
+                             usingBlock:^(NSNotification* notification) {
+                                 secondCalls++;
+                             }];
+
+    [center postNotificationName:@"test" object:nil];
+    ASSERT_EQ(0, secondCalls);
+    ASSERT_EQ(0, addedCalls);
+
+    [center postNotificationName:@"test" object:nil];
+    ASSERT_EQ(1, addedCalls);
+
+    [center removeObserver:first];
+    [center removeObserver:added];
+}
+
+// Threads posting to a center with a few observers per name, while another thread keeps adding and removing observers.
+TEST(NSNotificationCenter, PostThroughputBenchmark) {
+    static const int nameCount = 64;
+    static const int observersPerName = 4;
+    static const int postsPerThread = 100000;
+
+    NSNotificationCenter* center = [[NSNotificationCenter new] autorelease];
+    std::atomic<int> delivered{ 0 };
+    std::atomic<int>* deliveredCount = &delivered;
+
+    std::vector<NSString*> names;
+    std::vector<id> observers;
+    for (int i = 0; i < nameCount; i++) {
+        names.push_back([NSString stringWithFormat:@"BenchmarkNotification%d", i]);
+        for (int j = 0; j < observersPerName; j++) {
+            observers.push_back([center addObserverForName:names.back()
+                                                    object:nil
+                                                     queue:nil
+                                                usingBlock:^(NSNotification* notification) {
+                                                    deliveredCount->fetch_add(1, std::memory_order_relaxed);
+                                                }]);
+        }
+    }
+
+    const unsigned threadCounts[] = { 1, 2, 4, 8, 16 };
+    for (unsigned posters : threadCounts) {
+        std::atomic<bool> stop{ false };
+        std::thread churn([&]() {
+            @autoreleasepool {
+                while (!stop.load()) {
+                    id observer = [center addObserverForName:names[0]
+                                                      object:nil
+                                                       queue:nil
+                                                  usingBlock:^(NSNotification* notification){
+                                                  }];
+                    [center removeObserver:observer];
+                }
+            }
+        });
+
+        delivered = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < posters; t++) {
+            threads.emplace_back([&, t]() {
+                @autoreleasepool {
+                    NSNotification* notifications[nameCount];
+                    for (int i = 0; i < nameCount; i++) {
+                        notifications[i] = [NSNotification notificationWithName:names[i] object:nil];
+                    }
+                    for (int i = 0; i < postsPerThread; i++) {
+                        [center postNotification:notifications[(i + t) % nameCount]];
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        stop = true;
+        churn.join();
+
+        ASSERT_EQ(posters * postsPerThread * observersPerName, delivered.load());
+        double seconds = std::chrono::duration<double>(end - start).count();
+        LOG_INFO("%2u poster(s): %10.0f posts/s", posters, posters * postsPerThread / seconds);
+    }
+
+    for (id observer : observers) {
+        [center removeObserver:observer];
+    }
+}
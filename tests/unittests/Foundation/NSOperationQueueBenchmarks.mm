@@ -0,0 +1,116 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+// Throughput and latency of NSOperationQueue on fan-out/fan-in graphs: each graph is a source operation, a layer of
+// operations that depend on it, and a sink that depends on the whole layer. Many graphs are in flight at once, so the
+// queue has to interleave readiness from several graphs while keeping every worker busy.
+
+#include <TestFramework.h>
+#import <Foundation/Foundation.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+typedef std::chrono::high_resolution_clock BenchmarkClock;
+
+static const int benchmarkGraphs = 256;
+static const int benchmarkFanOut = 32;
+
+// Spins for roughly the given number of iterations, standing in for the body of a small operation.
+static unsigned spinWork(unsigned iterations) {
+    volatile unsigned value = 0;
+    for (unsigned i = 0; i < iterations; i++) {
+        value = value * 31 + i;
+    }
+    return value;
+}
+
+struct GraphTimes {
+    BenchmarkClock::time_point submitted;
+    BenchmarkClock::time_point finished;
+};
+
+// Builds and runs benchmarkGraphs graphs on a queue limited to maxConcurrent, then logs operations per second and the
+// distribution of submit-to-sink latency across graphs.
+static void runFanOutFanIn(NSInteger maxConcurrent, unsigned workPerOperation) {
+    NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+    [queue setMaxConcurrentOperationCount:maxConcurrent];
+
+    auto times = std::make_shared<std::vector<GraphTimes>>(benchmarkGraphs);
+    auto executed = std::make_shared<std::atomic<int>>(0);
+
+    auto start = BenchmarkClock::now();
+    for (int graph = 0; graph < benchmarkGraphs; graph++) {
+        NSAutoreleasePool* pool = [NSAutoreleasePool new];
+
+        NSBlockOperation* source = [NSBlockOperation blockOperationWithBlock:^{
+            spinWork(workPerOperation);
+            ++*executed;
+        }];
+        NSBlockOperation* sink = [NSBlockOperation blockOperationWithBlock:^{
+            spinWork(workPerOperation);
+            ++*executed;
+            (*times)[graph].finished = BenchmarkClock::now();
+        }];
+
+        NSMutableArray* operations = [NSMutableArray arrayWithObject:source];
+        for (int i = 0; i < benchmarkFanOut; i++) {
+            NSBlockOperation* middle = [NSBlockOperation blockOperationWithBlock:^{
+                spinWork(workPerOperation);
+                ++*executed;
+            }];
+            [middle addDependency:source];
+            [sink addDependency:middle];
+            [operations addObject:middle];
+        }
+        [operations addObject:sink];
+
+        (*times)[graph].submitted = BenchmarkClock::now();
+        [queue addOperations:operations waitUntilFinished:NO];
+
+        [pool release];
+    }
+    [queue waitUntilAllOperationsAreFinished];
+    auto end = BenchmarkClock::now();
+
+    const int operationsPerGraph = benchmarkFanOut + 2;
+    ASSERT_EQ(benchmarkGraphs * operationsPerGraph, executed->load());
+
+    std::vector<double> latencies;
+    for (const GraphTimes& graph : *times) {
+        latencies.push_back(std::chrono::duration<double, std::milli>(graph.finished - graph.submitted).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    LOG_INFO("max %2d, %5u spins/op: %9.0f ops/s, graph latency p50 %7.2f ms, p99 %7.2f ms, max %7.2f ms",
+             static_cast<int>(maxConcurrent),
+             workPerOperation,
+             benchmarkGraphs * operationsPerGraph / seconds,
+             latencies[latencies.size() / 2],
+             latencies[latencies.size() * 99 / 100],
+             latencies.back());
+}
+
+TEST(Foundation, NSOperationQueueFanOutFanInBenchmark) {
+    const NSInteger limits[] = { 1, 2, 4, NSOperationQueueDefaultMaxConcurrentOperationCount };
+    for (NSInteger limit : limits) {
+        runFanOutFanIn(limit, 0);
+        runFanOutFanIn(limit, 2000);
+    }
+}
@@ -16,6 +16,8 @@
 
 #include <TestFramework.h>
 #import <Foundation/Foundation.h>
+#include <atomic>
+#include <memory>
 
 TEST(Foundation, NSOperation) {
     NSOperationQueue* queue = [[NSOperationQueue alloc] init];
@@ -54,3 +56,186 @@ TEST(Foundation, NSOperationCancellation) {
     ASSERT_FALSE([cancelledOperation isExecuting]);
     ASSERT_TRUE([cancelledOperation isCancelled]);
 }
+
+TEST(Foundation, NSOperationDependencies) {
+    NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+
+    // A diamond: first fans out to left and right, which both feed last.
+    auto step = std::make_shared<std::atomic<int>>(0);
+    __block int firstStep = -1, leftStep = -1, rightStep = -1, lastStep = -1;
+    NSBlockOperation* first = [NSBlockOperation blockOperationWithBlock:^{
+        firstStep = (*step)++;
+    }];
+    NSBlockOperation* left = [NSBlockOperation blockOperationWithBlock:^{
+        leftStep = (*step)++;
+    }];
+    NSBlockOperation* right = [NSBlockOperation blockOperationWithBlock:^{
+        rightStep = (*step)++;
+    }];
+    NSBlockOperation* last = [NSBlockOperation blockOperationWithBlock:^{
+        lastStep = (*step)++;
+    }];
+    [left addDependency:first];
+    [right addDependency:first];
+    [last addDependency:left];
+    [last addDependency:right];
+
+    // Added in reverse, so nothing runs until its dependencies have finished.
+    [queue addOperations:@[ last, right, left, first ] waitUntilFinished:YES];
+
+    ASSERT_EQ(0, firstStep);
+    ASSERT_LT(firstStep, leftStep);
+    ASSERT_LT(firstStep, rightStep);
+    ASSERT_EQ(3, lastStep);
+
+    [queue waitUntilAllOperationsAreFinished];
+    ASSERT_EQ(0u, [queue operationCount]);
+}
+
+TEST(Foundation, NSOperationDependencyOnOtherQueue) {
+    NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+    NSOperationQueue* otherQueue = [[NSOperationQueue new] autorelease];
+    [otherQueue setSuspended:YES];
+
+    auto dependencyRan = std::make_shared<std::atomic<bool>>(false);
+    NSBlockOperation* dependency = [NSBlockOperation blockOperationWithBlock:^{
+        *dependencyRan = true;
+    }];
+    __block bool sawDependency = false;
+    NSBlockOperation* dependent = [NSBlockOperation blockOperationWithBlock:^{
+        sawDependency = *dependencyRan;
+    }];
+    [dependent addDependency:dependency];
+
+    [queue addOperation:dependent];
+    [otherQueue addOperation:dependency];
+    ASSERT_EQ(1u, [queue operationCount]);
+    ASSERT_FALSE([dependent isFinished]);
+
+    [otherQueue setSuspended:NO];
+    [queue waitUntilAllOperationsAreFinished];
+    ASSERT_TRUE(sawDependency);
+}
+
+TEST(Foundation, NSOperationRemoveDependency) {
+    NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+
+    // Never queued, so only removing it lets the dependent run.
+    NSOperation* neverRuns = [[NSOperation new] autorelease];
+    NSOperation* dependent = [[NSOperation new] autorelease];
+    [dependent addDependency:neverRuns];
+
+    [queue addOperation:dependent];
+    ASSERT_FALSE([dependent isFinished]);
+
+    [dependent removeDependency:neverRuns];
+    [dependent waitUntilFinished];
+    ASSERT_TRUE([dependent isFinished]);
+    ASSERT_EQ(0u, [[dependent dependencies] count]);
+}
+
+TEST(Foundation, NSOperationCancelWaitingOperation) {
+    NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+
+    NSOperation* neverRuns = [[NSOperation new] autorelease];
+    NSOperation* dependent = [[NSOperation new] autorelease];
+    [dependent addDependency:neverRuns];
+
+    [queue addOperation:dependent];
+    [dependent cancel];
+    [queue waitUntilAllOperationsAreFinished];
+
+    ASSERT_TRUE([dependent isCancelled]);
+    ASSERT_TRUE([dependent isFinished]);
+}
+
+TEST(Foundation, NSOperationQueueMaxConcurrentOperationCount) {
+    NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+    ASSERT_EQ(NSOperationQueueDefaultMaxConcurrentOperationCount, [queue maxConcurrentOperationCount]);
+
+    [queue setMaxConcurrentOperationCount:2];
+    ASSERT_EQ(2, [queue maxConcurrentOperationCount]);
+
+    auto running = std::make_shared<std::atomic<int>>(0);
+    auto mostRunning = std::make_shared<std::atomic<int>>(0);
+    for (int i = 0; i < 64; i++) {
+        [queue addOperationWithBlock:^{
+            int now = ++*running;
+            int seen = *mostRunning;
+            while (now > seen && !mostRunning->compare_exchange_weak(seen, now)) {
+            }
+            [NSThread sleepForTimeInterval:0.001];
+            --*running;
+        }];
+    }
+    [queue waitUntilAllOperationsAreFinished];
+
+    ASSERT_LE(mostRunning->load(), 2);
+    ASSERT_EQ(0u, [queue operationCount]);
+}
+
+TEST(Foundation, NSOperationQueueSuspend) {
+    NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+    [queue setSuspended:YES];
+    ASSERT_TRUE([queue isSuspended]);
+
+    auto ran = std::make_shared<std::atomic<int>>(0);
+    for (int i = 0; i < 16; i++) {
+        [queue addOperationWithBlock:^{
+            ++*ran;
+        }];
+    }
+
+    [NSThread sleepForTimeInterval:0.05];
+    ASSERT_EQ(0, ran->load());
+    ASSERT_EQ(16u, [queue operationCount]);
+
+    [queue setSuspended:NO];
+    [queue waitUntilAllOperationsAreFinished];
+    ASSERT_EQ(16, ran->load());
+}
+
+TEST(Foundation, NSOperationQueueCurrentQueue) {
+    NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+
+    __block NSOperationQueue* current = nil;
+    [queue addOperationWithBlock:^{
+        current = [NSOperationQueue currentQueue];
+    }];
+    [queue waitUntilAllOperationsAreFinished];
+
+    ASSERT_EQ(queue, current);
+}
+
+TEST(Foundation, NSOperationManyConcurrentDependencies) {
+    NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+    NSOperationQueue* dependencyQueue = [[NSOperationQueue new] autorelease];
+
+    // The dependencies run, and finish, while the dependent is still registering with them.
+    static const int dependencyCount = 256;
+    for (int round = 0; round < 20; round++) {
+        auto finished = std::make_shared<std::atomic<int>>(0);
+        __block int finishedWhenRun = -1;
+        NSBlockOperation* dependent = [NSBlockOperation blockOperationWithBlock:^{
+            finishedWhenRun = finished->load();
+        }];
+
+        NSMutableArray* dependencies = [NSMutableArray array];
+        for (int i = 0; i < dependencyCount; i++) {
+            NSBlockOperation* dependency = [NSBlockOperation blockOperationWithBlock:^{
+            }];
+            [dependency setCompletionBlock:^{
+                ++*finished;
+            }];
+            [dependent addDependency:dependency];
+            [dependencies addObject:dependency];
+        }
+
+        [dependencyQueue addOperations:dependencies waitUntilFinished:NO];
+        [queue addOperation:dependent];
+        [dependent waitUntilFinished];
+
+        ASSERT_EQ(dependencyCount, finishedWhenRun);
+        [dependencyQueue waitUntilAllOperationsAreFinished];
+    }
+}
@@ -0,0 +1,182 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <TestFramework.h>
+#import <Foundation/Foundation.h>
+#import "NSPropertyListSerializationInternal.h"
+#include <chrono>
+
+typedef std::chrono::high_resolution_clock BenchmarkClock;
+
+static NSString* writeTemporaryFile(NSString* name, NSData* data) {
+    NSArray* cachesPaths = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSAllDomainsMask, YES);
+    NSString* path = cachesPaths[0];
+    [[NSFileManager defaultManager] createDirectoryAtPath:path withIntermediateDirectories:YES attributes:nil error:nil];
+
+    NSString* file = [path stringByAppendingPathComponent:name];
+    [data writeToFile:file atomically:NO];
+    return file;
+}
+
+static NSDictionary* samplePropertyList() {
+    return @{
+        @"CFBundleIdentifier" : @"com.example.propertylistreader",
+        @"LongDescription" : @"A string long enough to be read straight out of the property list's bytes when lazy.",
+        @"Numbers" : @[ @255, @65536, @(1LL << 40), @1.5 ],
+        @"Flags" : @{ @"Enabled" : @YES, @"Hidden" : @NO },
+        @"Blob" : [NSData dataWithBytes:"\x00\x01\x02\x03" length:4],
+        @"Nested" : @[ @{ @"Key" : @[ @"a", @"b" ] }, @[] ],
+    };
+}
+
+TEST(NSPropertyListReader, LazyReadMatchesEagerRead) {
+    NSData* data = [NSPropertyListSerialization dataFromPropertyList:samplePropertyList()
+                                                              format:NSPropertyListBinaryFormat_v1_0
+                                                    errorDescription:nil];
+    NSString* file = writeTemporaryFile(@"lazy.bplist", data);
+
+    id eager = [NSPropertyListSerialization propertyListFromData:data mutabilityOption:NSPropertyListImmutable format:nil errorDescription:nil];
+    id lazy = [NSPropertyListSerialization _propertyListWithContentsOfFile:file mutabilityOption:NSPropertyListImmutable];
+
+    ASSERT_OBJCEQ(samplePropertyList(), eager);
+    ASSERT_OBJCEQ(samplePropertyList(), lazy);
+    ASSERT_OBJCEQ(lazy, eager);
+
+    // Lazy containers have to work through the CoreFoundation calls as well
+    ASSERT_EQ([samplePropertyList() count], CFDictionaryGetCount((CFDictionaryRef)lazy));
+    ASSERT_OBJCEQ(@"com.example.propertylistreader", (id)CFDictionaryGetValue((CFDictionaryRef)lazy, @"CFBundleIdentifier"));
+    ASSERT_EQ(4, CFArrayGetCount((CFArrayRef)[lazy objectForKey:@"Numbers"]));
+    ASSERT_EQ(nil, [lazy objectForKey:@"Missing"]);
+
+    NSMutableDictionary* copy = [[lazy mutableCopy] autorelease];
+    ASSERT_OBJCEQ(samplePropertyList(), copy);
+
+    [[NSFileManager defaultManager] removeItemAtPath:file error:nil];
+}
+
+TEST(NSPropertyListReader, MutabilityOptionIsHonored) {
+    NSData* data = [NSPropertyListSerialization dataFromPropertyList:samplePropertyList()
+                                                              format:NSPropertyListBinaryFormat_v1_0
+                                                    errorDescription:nil];
+
+    id immutable = [NSPropertyListSerialization propertyListFromData:data mutabilityOption:NSPropertyListImmutable format:nil errorDescription:nil];
+    ASSERT_FALSE([immutable isKindOfClass:[NSMutableDictionary class]]);
+
+    id containers =
+        [NSPropertyListSerialization propertyListFromData:data mutabilityOption:NSPropertyListMutableContainers format:nil errorDescription:nil];
+    ASSERT_TRUE([containers isKindOfClass:[NSMutableDictionary class]]);
+    ASSERT_TRUE([[containers objectForKey:@"Numbers"] isKindOfClass:[NSMutableArray class]]);
+    ASSERT_FALSE([[containers objectForKey:@"CFBundleIdentifier"] isKindOfClass:[NSMutableString class]]);
+
+    id leaves = [NSPropertyListSerialization propertyListFromData:data
+                                                 mutabilityOption:NSPropertyListMutableContainersAndLeaves
+                                                           format:nil
+                                                 errorDescription:nil];
+    ASSERT_TRUE([[leaves objectForKey:@"CFBundleIdentifier"] isKindOfClass:[NSMutableString class]]);
+    ASSERT_OBJCEQ(samplePropertyList(), leaves);
+}
+
+TEST(NSPropertyListReader, CorruptInputIsRejected) {
+    NSData* data = [NSPropertyListSerialization dataFromPropertyList:samplePropertyList()
+                                                              format:NSPropertyListBinaryFormat_v1_0
+                                                    errorDescription:nil];
+    const size_t length = [data length];
+
+    // Too short to hold a trailer
+    NSData* truncated = [data subdataWithRange:NSMakeRange(0, 20)];
+    ASSERT_EQ(nil, [NSPropertyListSerialization propertyListFromData:truncated mutabilityOption:0 format:nil errorDescription:nil]);
+
+    // Offset table inside the header
+    NSMutableData* badTable = [[data mutableCopy] autorelease];
+    memset((uint8_t*)[badTable mutableBytes] + length - 8, 0, 8);
+    ASSERT_EQ(nil, [NSPropertyListSerialization propertyListFromData:badTable mutabilityOption:0 format:nil errorDescription:nil]);
+
+    // Offset table that points past the objects
+    NSMutableData* badOffsets = [[data mutableCopy] autorelease];
+    uint8_t* bytes = (uint8_t*)[badOffsets mutableBytes];
+    uint64_t offsetTable = 0;
+    for (int i = 0; i < 8; i++) {
+        offsetTable = (offsetTable << 8) | bytes[length - 8 + i];
+    }
+    memset(bytes + offsetTable, 0xFF, bytes[length - 32 + 6]);
+    ASSERT_EQ(nil, [NSPropertyListSerialization propertyListFromData:badOffsets mutabilityOption:0 format:nil errorDescription:nil]);
+
+    // An object count the references can't address
+    NSMutableData* badCount = [[data mutableCopy] autorelease];
+    ((uint8_t*)[badCount mutableBytes])[length - 32 + 8] = 0x7F;
+    ASSERT_EQ(nil, [NSPropertyListSerialization propertyListFromData:badCount mutabilityOption:0 format:nil errorDescription:nil]);
+}
+
+// A property list shaped like a large resource cache: many records, each a small dictionary, about 10MB in all.
+static NSData* largePropertyList() {
+    NSMutableArray* records = [NSMutableArray array];
+    NSString* padding = [@"" stringByPaddingToLength:180 withString:@"0123456789abcdef" startingAtIndex:0];
+
+    for (int i = 0; i < 40000; i++) {
+        [records addObject:@{
+            @"Name" : [NSString stringWithFormat:@"record-%d", i],
+            @"Path" : [NSString stringWithFormat:@"/resources/%d/%@", i, padding],
+            @"Size" : @(i * 37),
+            @"Tags" : @[ [NSString stringWithFormat:@"tag%d", i % 97], [NSString stringWithFormat:@"group%d", i % 13] ],
+        }];
+    }
+
+    NSDictionary* root = @{ @"CFBundleIdentifier" : @"com.example.largecache", @"Records" : records };
+    return [NSPropertyListSerialization dataFromPropertyList:root format:NSPropertyListBinaryFormat_v1_0 errorDescription:nil];
+}
+
+TEST(NSPropertyListReader, StartupBenchmark) {
+    NSData* data = largePropertyList();
+    LOG_INFO("Property list is %.1f MB", [data length] / (1024.0 * 1024.0));
+    NSString* file = writeTemporaryFile(@"large.bplist", data);
+
+    // Eager: read the whole file, then decode every object
+    auto start = BenchmarkClock::now();
+    @autoreleasepool {
+        NSData* fileData = [NSData dataWithContentsOfFile:file];
+        NSDictionary* plist =
+            [NSPropertyListSerialization propertyListFromData:fileData mutabilityOption:NSPropertyListImmutable format:nil errorDescription:nil];
+        ASSERT_OBJCEQ(@"com.example.largecache", [plist objectForKey:@"CFBundleIdentifier"]);
+    }
+    double eagerMs = std::chrono::duration<double, std::milli>(BenchmarkClock::now() - start).count();
+
+    // Lazy: map the file and decode only what is looked up, as at launch
+    start = BenchmarkClock::now();
+    @autoreleasepool {
+        NSDictionary* plist = [NSPropertyListSerialization _propertyListWithContentsOfFile:file mutabilityOption:NSPropertyListImmutable];
+        ASSERT_OBJCEQ(@"com.example.largecache", [plist objectForKey:@"CFBundleIdentifier"]);
+        ASSERT_OBJCEQ(@"record-12345", [[[plist objectForKey:@"Records"] objectAtIndex:12345] objectForKey:@"Name"]);
+    }
+    double lazyMs = std::chrono::duration<double, std::milli>(BenchmarkClock::now() - start).count();
+
+    // Lazy, then touching every record
+    start = BenchmarkClock::now();
+    @autoreleasepool {
+        NSDictionary* plist = [NSPropertyListSerialization _propertyListWithContentsOfFile:file mutabilityOption:NSPropertyListImmutable];
+        NSUInteger totalSize = 0;
+        for (NSDictionary* record in [plist objectForKey:@"Records"]) {
+            totalSize += [[record objectForKey:@"Path"] length];
+        }
+        ASSERT_NE(0, totalSize);
+    }
+    double lazyFullMs = std::chrono::duration<double, std::milli>(BenchmarkClock::now() - start).count();
+
+    LOG_INFO("Eager read: %8.2f ms", eagerMs);
+    LOG_INFO("Lazy read, two lookups: %8.2f ms", lazyMs);
+    LOG_INFO("Lazy read, full walk: %8.2f ms", lazyFullMs);
+
+    [[NSFileManager defaultManager] removeItemAtPath:file error:nil];
+}
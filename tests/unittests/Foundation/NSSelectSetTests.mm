@@ -0,0 +1,167 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <WinSock2.h>
+#include <ws2tcpip.h>
+#include <TestFramework.h>
+#import <Foundation/Foundation.h>
+#import "NSSelectSet.h"
+#include <chrono>
+#include <vector>
+
+@interface NSSelectSetTestSocket : NSObject
+@property (readonly) int descriptor;
+@end
+
+@implementation NSSelectSetTestSocket
+- (instancetype)initWithDescriptor:(int)descriptor {
+    if (self = [super init]) {
+        _descriptor = descriptor;
+    }
+    return self;
+}
+@end
+
+//  Connected loopback TCP pairs; the accepted end of each pair is what the tests wait on.
+class LoopbackPairs {
+public:
+    explicit LoopbackPairs(int count) {
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+
+        SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listener, (sockaddr*)&address, sizeof(address));
+        listen(listener, SOMAXCONN);
+        int addressLength = sizeof(address);
+        getsockname(listener, (sockaddr*)&address, &addressLength);
+
+        for (int i = 0; i < count; i++) {
+            SOCKET client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            if (client == INVALID_SOCKET || connect(client, (sockaddr*)&address, sizeof(address)) != 0) {
+                break;
+            }
+            SOCKET server = accept(listener, nullptr, nullptr);
+            clients.push_back(client);
+            servers.push_back([[NSSelectSetTestSocket alloc] initWithDescriptor:(int)server]);
+        }
+        closesocket(listener);
+    }
+
+    ~LoopbackPairs() {
+        for (size_t i = 0; i < clients.size(); i++) {
+            closesocket(clients[i]);
+            closesocket((SOCKET)[servers[i] descriptor]);
+            [servers[i] release];
+        }
+        WSACleanup();
+    }
+
+    void send(size_t index) {
+        char byte = 'x';
+        ::send(clients[index], &byte, 1, 0);
+    }
+
+    void drain(size_t index) {
+        char byte;
+        recv((SOCKET)[servers[index] descriptor], &byte, 1, 0);
+    }
+
+    std::vector<SOCKET> clients;
+    std::vector<NSSelectSetTestSocket*> servers;
+};
+
+TEST(NSSelectSet, ReportsReadyObjects) {
+    LoopbackPairs pairs(3);
+    ASSERT_EQ(3, pairs.servers.size());
+
+    NSSelectSet* selectSet = [[NSSelectSet new] autorelease];
+    for (NSSelectSetTestSocket* server : pairs.servers) {
+        [selectSet addObjectForRead:server];
+    }
+    [selectSet addObjectForWrite:pairs.servers[2]];
+    ASSERT_EQ(3, [selectSet count]);
+
+    NSSelectSet* outputSet = nil;
+    [selectSet waitForSelectWithOutputSet:&outputSet beforeDate:[NSDate date]];
+    ASSERT_FALSE([outputSet containsObjectForRead:pairs.servers[1]]);
+    ASSERT_TRUE([outputSet containsObjectForWrite:pairs.servers[2]]);
+
+    pairs.send(1);
+    [selectSet waitForSelectWithOutputSet:&outputSet beforeDate:[NSDate dateWithTimeIntervalSinceNow:5]];
+    ASSERT_FALSE([outputSet containsObjectForRead:pairs.servers[0]]);
+    ASSERT_TRUE([outputSet containsObjectForRead:pairs.servers[1]]);
+    ASSERT_FALSE([outputSet containsObjectForRead:pairs.servers[2]]);
+
+    // Registrations persist between waits until they are removed
+    [selectSet removeObjectForRead:pairs.servers[1]];
+    [selectSet removeObjectForWrite:pairs.servers[2]];
+    [selectSet waitForSelectWithOutputSet:&outputSet beforeDate:[NSDate date]];
+    ASSERT_TRUE([outputSet isEmpty]);
+    ASSERT_FALSE([selectSet containsObjectForRead:pairs.servers[1]]);
+    ASSERT_TRUE([selectSet containsObjectForRead:pairs.servers[2]]);
+
+    [selectSet removeAllObjects];
+    ASSERT_TRUE([selectSet isEmpty]);
+}
+
+// 5k idle loopback connections with a few becoming readable per wait, the shape of a busy socket server.
+TEST(NSSelectSet, ConcurrentSocketsBenchmark) {
+    static const int socketCount = 5000;
+    static const int readyPerWait = 16;
+    static const int waitCount = 500;
+
+    LoopbackPairs pairs(socketCount);
+    LOG_INFO("Connected %d loopback pairs", (int)pairs.servers.size());
+    ASSERT_GT(pairs.servers.size(), FD_SETSIZE);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    NSSelectSet* selectSet = [[NSSelectSet new] autorelease];
+    for (NSSelectSetTestSocket* server : pairs.servers) {
+        [selectSet addObjectForRead:server];
+    }
+    double registerMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    unsigned seed = 1;
+    size_t reported = 0;
+    double waitMs = 0;
+    for (int i = 0; i < waitCount; i++) {
+        std::vector<size_t> sent;
+        for (int j = 0; j < readyPerWait; j++) {
+            seed = seed * 1103515245u + 12345u;
+            sent.push_back((seed >> 8) % pairs.servers.size());
+            pairs.send(sent.back());
+        }
+
+        @autoreleasepool {
+            NSSelectSet* outputSet = nil;
+            start = std::chrono::high_resolution_clock::now();
+            [selectSet waitForSelectWithOutputSet:&outputSet beforeDate:[NSDate dateWithTimeIntervalSinceNow:5]];
+            waitMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            reported += [outputSet count];
+        }
+
+        for (size_t index : sent) {
+            pairs.drain(index);
+        }
+    }
+
+    ASSERT_GT(reported, 0);
+    LOG_INFO("Registering %d sockets: %8.2f ms", (int)pairs.servers.size(), registerMs);
+    LOG_INFO("Average wait: %8.3f ms, %.1f ready per wait", waitMs / waitCount, (double)reported / waitCount);
+}
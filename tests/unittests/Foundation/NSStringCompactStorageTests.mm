@@ -0,0 +1,203 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+// Plain immutable strings with only Latin-1 characters are stored one byte per character; mutable strings always use
+// the ICU representation. These tests mix the two, along with constant strings.
+
+#include <windows.h>
+#include <psapi.h>
+#include <TestFramework.h>
+#import <Foundation/Foundation.h>
+#include <chrono>
+#include <vector>
+
+typedef std::chrono::high_resolution_clock BenchmarkClock;
+
+static NSString* latin1String(const char* bytes) {
+    return [[[NSString alloc] initWithBytes:bytes length:strlen(bytes) encoding:NSISOLatin1StringEncoding] autorelease];
+}
+
+TEST(NSString, CompactStorageEqualityAndHash) {
+    NSArray* strings = @[
+        @"dictionaryKey",
+        [NSString stringWithUTF8String:"dictionaryKey"],
+        [NSString stringWithFormat:@"dictionary%@", @"Key"],
+        [NSMutableString stringWithString:@"dictionaryKey"],
+        [@"dictionaryKeys" substringToIndex:13],
+    ];
+
+    for (NSString* left in strings) {
+        for (NSString* right in strings) {
+            ASSERT_OBJCEQ(left, right);
+            ASSERT_TRUE([left isEqualToString:right]);
+            ASSERT_EQ([left hash], [right hash]);
+            ASSERT_EQ(NSOrderedSame, [left compare:right]);
+        }
+    }
+
+    // Same length, hashes cached on both sides, different last character
+    NSString* other = [NSString stringWithUTF8String:"dictionaryKez"];
+    [other hash];
+    [strings[1] hash];
+    ASSERT_FALSE([other isEqualToString:strings[1]]);
+    ASSERT_FALSE([strings[3] isEqual:other]);
+    ASSERT_FALSE([@"dictionaryKe" isEqualToString:strings[1]]);
+
+    ASSERT_EQ(NSOrderedAscending, [@"abc" compare:[NSString stringWithUTF8String:"abd"]]);
+    ASSERT_EQ(NSOrderedAscending, [[NSString stringWithUTF8String:"ab"] compare:@"abc"]);
+    ASSERT_EQ(NSOrderedDescending, [latin1String("ab\xe9") compare:@"abz"]);
+}
+
+TEST(NSString, CompactStorageLatin1) {
+    NSString* string = latin1String("caf\xe9");
+    NSString* decoded = [NSString stringWithUTF8String:"caf\xc3\xa9"];
+
+    ASSERT_EQ(4, [string length]);
+    ASSERT_EQ(0xE9, [string characterAtIndex:3]);
+    ASSERT_STREQ("caf\xc3\xa9", [string UTF8String]);
+    ASSERT_OBJCEQ(decoded, string);
+    ASSERT_EQ([decoded hash], [string hash]);
+
+    unichar characters[2];
+    [string getCharacters:characters range:NSMakeRange(2, 2)];
+    ASSERT_EQ('f', characters[0]);
+    ASSERT_EQ(0xE9, characters[1]);
+
+    // Operations that need ICU still see the same characters
+    ASSERT_OBJCEQ(@"CAF\u00c9", [string uppercaseString]);
+    ASSERT_EQ(3, [string rangeOfString:@"\u00e9"].location);
+
+    // Characters past Latin-1 cannot be stored compactly
+    NSString* wide = [NSString stringWithUTF8String:"caf\xc3\xa9 \xe2\x82\xac"];
+    ASSERT_EQ(6, [wide length]);
+    ASSERT_EQ(0x20AC, [wide characterAtIndex:5]);
+    ASSERT_TRUE([wide hasPrefix:string]);
+}
+
+TEST(NSString, CompactStorageMutableCopies) {
+    NSString* string = [NSString stringWithUTF8String:"key"];
+    NSMutableString* mutableString = [[string mutableCopy] autorelease];
+    [mutableString appendString:@"s \u20ac"];
+
+    ASSERT_OBJCEQ(@"key", string);
+    ASSERT_OBJCEQ(@"keys \u20ac", mutableString);
+
+    NSString* copy = [NSString stringWithString:mutableString];
+    ASSERT_OBJCEQ(mutableString, copy);
+    ASSERT_OBJCEQ(@"key", [NSString stringWithString:@"key"]);
+    ASSERT_STREQ("key", [[NSString stringWithString:string] UTF8String]);
+}
+
+// Strings over borrowed bytes take their own Unicode copy when changed and leave the borrowed bytes alone.
+TEST(NSString, NoCopyStringsConvertOnMutation) {
+    char bytes[] = "caf\xc3\xa9";
+    NSMutableString* utf8String = [[[NSMutableString alloc] initWithBytesNoCopy:bytes
+                                                                         length:strlen(bytes)
+                                                                       encoding:NSUTF8StringEncoding
+                                                                   freeWhenDone:NO] autorelease];
+    [utf8String appendString:@" au lait"];
+
+    ASSERT_OBJCEQ(@"caf\u00e9 au lait", utf8String);
+    ASSERT_STREQ("caf\xc3\xa9", bytes);
+
+    unichar characters[] = { 'k', 'e', 'y' };
+    NSMutableString* utf16String = [[[NSMutableString alloc] initWithCharactersNoCopy:characters
+                                                                                length:3
+                                                                          freeWhenDone:NO] autorelease];
+    [utf16String insertString:@"the " atIndex:0];
+    [utf16String appendString:@"s"];
+
+    ASSERT_OBJCEQ(@"the keys", utf16String);
+    ASSERT_EQ([@"the keys" hash], [utf16String hash]);
+    ASSERT_EQ('k', characters[0]);
+    ASSERT_EQ('y', characters[2]);
+}
+
+static size_t privateBytes() {
+    PROCESS_MEMORY_COUNTERS_EX counters = {};
+    GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&counters, sizeof(counters));
+    return counters.PrivateUsage;
+}
+
+static std::vector<NSString*> makeKeys(Class stringClass, int count) {
+    std::vector<NSString*> keys;
+    keys.reserve(count);
+    char buffer[64];
+    for (int i = 0; i < count; i++) {
+        sprintf_s(buffer, sizeof(buffer), "com.example.setting.%08d", i);
+        keys.push_back([[stringClass alloc] initWithUTF8String:buffer]);
+    }
+    return keys;
+}
+
+static void releaseKeys(std::vector<NSString*>& keys) {
+    for (NSString* key : keys) {
+        [key release];
+    }
+    keys.clear();
+}
+
+// Keys built the same way, as NSString (compact) and NSMutableString (ICU), to compare the two representations.
+TEST(NSString, CompactStorageKeyMemoryBenchmark) {
+    static const int keyCount = 100000;
+
+    Class classes[] = { [NSString class], [NSMutableString class] };
+    for (Class stringClass : classes) {
+        size_t before = privateBytes();
+        std::vector<NSString*> keys = makeKeys(stringClass, keyCount);
+        for (NSString* key : keys) {
+            [key hash];
+        }
+        size_t after = privateBytes();
+
+        LOG_INFO("%-16s %6.1f bytes per key", class_getName(stringClass), (double)(after - before) / keyCount);
+        releaseKeys(keys);
+    }
+}
+
+// Lookups with keys that are equal to, but not the same objects as, the ones in the dictionary, the way parsed or
+// formatted keys arrive. The dictionary copies its keys, so only the lookup side stays ICU backed for NSMutableString.
+TEST(NSString, CompactStorageDictionaryLookupBenchmark) {
+    static const int keyCount = 10000;
+    static const int rounds = 20;
+
+    Class classes[] = { [NSString class], [NSMutableString class] };
+    for (Class stringClass : classes) {
+        std::vector<NSString*> keys = makeKeys(stringClass, keyCount);
+        std::vector<NSString*> lookups = makeKeys(stringClass, keyCount);
+
+        NSMutableDictionary* dictionary = [NSMutableDictionary dictionary];
+        auto start = BenchmarkClock::now();
+        for (int i = 0; i < keyCount; i++) {
+            dictionary[keys[i]] = @(i);
+        }
+        double insertMs = std::chrono::duration<double, std::milli>(BenchmarkClock::now() - start).count();
+
+        int found = 0;
+        start = BenchmarkClock::now();
+        for (int round = 0; round < rounds; round++) {
+            for (NSString* key : lookups) {
+                found += dictionary[key] != nil;
+            }
+        }
+        double seconds = std::chrono::duration<double>(BenchmarkClock::now() - start).count();
+
+        ASSERT_EQ(keyCount * rounds, found);
+        LOG_INFO("%-16s insert %8.2f ms, %10.0f lookups/s", class_getName(stringClass), insertMs, keyCount * rounds / seconds);
+        releaseKeys(keys);
+        releaseKeys(lookups);
+    }
+}
@@ -17,7 +17,9 @@
 #import "Starboard.h"
 #include <TestFramework.h>
 #import <Foundation/Foundation.h>
+#import <chrono>
 #import <future>
+#import <vector>
 
 TEST(NSTimer, Init) {
     ASSERT_TRUE_MSG([[[NSTimer alloc] init] autorelease] != nil, "FAILED: alloc/init failed.");
@@ -262,4 +264,98 @@ TEST(NSTimer, ScheduledTimerWithTimeIntervalWithInvocation) {
     ASSERT_TRUE_MSG(![timer isValid], "FAILED: The timer should not be valid.");
     ASSERT_EQ_MSG(YES, selectorCalledAsync.get(), "FAILED: the scheduled timer did not call the method.");
     ASSERT_OBJCEQ_MSG(testDummyArg, [testObj dummyVal], "FAILED: argument was not retained.");
-}
\ No newline at end of file
+}
+@interface NSTimerTestRecorder : NSObject
+@property (retain) NSMutableArray* fired;
+@end
+
+@implementation NSTimerTestRecorder
+- (instancetype)init {
+    if (self = [super init]) {
+        _fired = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [_fired release];
+    [super dealloc];
+}
+
+- (void)record:(NSTimer*)timer {
+    [_fired addObject:[timer userInfo]];
+}
+@end
+
+static NSTimer* addRecordingTimer(NSTimerTestRecorder* recorder, NSTimeInterval delay, id tag, BOOL repeats) {
+    NSTimer* timer = [NSTimer timerWithTimeInterval:delay target:recorder selector:@selector(record:) userInfo:tag repeats:repeats];
+    [[NSRunLoop currentRunLoop] addTimer:timer forMode:NSDefaultRunLoopMode];
+    return timer;
+}
+
+TEST(NSTimer, FiresInFireDateOrder) {
+    NSTimerTestRecorder* recorder = [[NSTimerTestRecorder new] autorelease];
+
+    // Added out of order, and one moved ahead of the others after being added
+    addRecordingTimer(recorder, 0.3, @3, NO);
+    addRecordingTimer(recorder, 0.1, @1, NO);
+    NSTimer* moved = addRecordingTimer(recorder, 5.0, @0, NO);
+    addRecordingTimer(recorder, 0.2, @2, NO);
+    NSTimer* invalidated = addRecordingTimer(recorder, 0.15, @-1, NO);
+    [moved setFireDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    [invalidated invalidate];
+
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.6]];
+
+    ASSERT_OBJCEQ((@[ @0, @1, @2, @3 ]), recorder.fired);
+    ASSERT_FALSE([[NSRunLoop currentRunLoop] containsTimer:moved forMode:NSDefaultRunLoopMode]);
+}
+
+TEST(NSTimer, RemovedTimerDoesNotFire) {
+    NSTimerTestRecorder* recorder = [[NSTimerTestRecorder new] autorelease];
+    NSRunLoop* runLoop = [NSRunLoop currentRunLoop];
+
+    NSTimer* removed = addRecordingTimer(recorder, 0.05, @1, YES);
+    addRecordingTimer(recorder, 0.2, @2, NO);
+    ASSERT_TRUE([runLoop containsTimer:removed forMode:NSDefaultRunLoopMode]);
+
+    [runLoop removeTimer:removed forMode:NSDefaultRunLoopMode];
+    ASSERT_FALSE([runLoop containsTimer:removed forMode:NSDefaultRunLoopMode]);
+
+    [runLoop runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.4]];
+    ASSERT_OBJCEQ((@[ @2 ]), recorder.fired);
+}
+
+// Many repeating timers, as with per-cell countdowns, while the run loop keeps spinning.
+TEST(NSTimer, ManyTimersBenchmark) {
+    static const int timerCount = 2000;
+    NSTimerTestRecorder* recorder = [[NSTimerTestRecorder new] autorelease];
+
+    std::vector<NSTimer*> timers;
+    for (int i = 0; i < timerCount; i++) {
+        timers.push_back(addRecordingTimer(recorder, 0.5 + (i % 100) * 0.01, @(i), YES));
+    }
+
+    NSRunLoop* runLoop = [NSRunLoop currentRunLoop];
+    NSDate* end = [NSDate dateWithTimeIntervalSinceNow:2.0];
+    int iterations = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    while ([end timeIntervalSinceNow] > 0) {
+        @autoreleasepool {
+            [runLoop runMode:NSDefaultRunLoopMode beforeDate:end];
+        }
+        iterations++;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    for (NSTimer* timer : timers) {
+        [timer invalidate];
+    }
+
+    ASSERT_GE([recorder.fired count], timerCount);
+    LOG_INFO("%d timers: %lu fires in %d run loop iterations, %.2f us per iteration",
+             timerCount,
+             (unsigned long)[recorder.fired count],
+             iterations,
+             seconds * 1000000.0 / iterations);
+}
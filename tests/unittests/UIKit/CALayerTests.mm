@@ -0,0 +1,118 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <TestFramework.h>
+
+#import <QuartzCore/CALayer.h>
+#import "Starboard.h"
+#import "CALayerInternal.h"
+#import "NullCompositor.h"
+
+static const int c_branchCount = 50;
+static const int c_leafCount = 100;
+
+class CALayerPassTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        static bool initialized;
+
+        if (!initialized) {
+            SetCACompositor(new NullCompositor);
+            initialized = true;
+        }
+
+        _root = [[CALayer new] autorelease];
+        for (int i = 0; i < c_branchCount; i++) {
+            CALayer* branch = [[CALayer new] autorelease];
+            for (int j = 0; j < c_leafCount; j++) {
+                [branch addSublayer:[[CALayer new] autorelease]];
+            }
+            [_root addSublayer:branch];
+        }
+
+        //  Settle the freshly built tree so each test starts from a clean frame
+        [_root validateDisplayHierarchy];
+        [CALayer _resetPassStatistics];
+    }
+
+    virtual void TearDown() {
+        _root = nil;
+    }
+
+    CALayer* leafAt(int branch, int leaf) {
+        return [[[[_root sublayers] objectAtIndex:branch] sublayers] objectAtIndex:leaf];
+    }
+
+    StrongId<CALayer> _root;
+};
+
+TEST_F(CALayerPassTest, CleanTreeVisitsOnlyRoot) {
+    [_root validateDisplayHierarchy];
+
+    CALayerPassStatistics stats = [CALayer _passStatistics];
+    ASSERT_EQ(1u, stats.layoutNodesVisited);
+    ASSERT_EQ(0u, stats.layoutsPerformed);
+    ASSERT_EQ(1u, stats.displayNodesVisited);
+    ASSERT_EQ(0u, stats.displaysPerformed);
+}
+
+TEST_F(CALayerPassTest, SingleDirtyLayerVisitsOnlyItsPath) {
+    CALayer* leaf = leafAt(17, 42);
+    [leaf setNeedsLayout];
+    [leaf setNeedsDisplay];
+    [_root validateDisplayHierarchy];
+
+    //  The root, its branches and the dirty branch's leaves are examined once, plus the root again when the layout
+    //  pass confirms that nothing else became dirty
+    CALayerPassStatistics stats = [CALayer _passStatistics];
+    ASSERT_EQ(1u + c_branchCount + c_leafCount + 1u, stats.layoutNodesVisited);
+    ASSERT_EQ(1u, stats.layoutsPerformed);
+    ASSERT_EQ(1u + c_branchCount + c_leafCount, stats.displayNodesVisited);
+    ASSERT_EQ(1u, stats.displaysPerformed);
+
+    [CALayer _resetPassStatistics];
+    [_root validateDisplayHierarchy];
+    stats = [CALayer _passStatistics];
+    ASSERT_EQ(1u, stats.layoutNodesVisited);
+    ASSERT_EQ(0u, stats.displaysPerformed);
+}
+
+TEST_F(CALayerPassTest, DirtyLayerMovedIntoTreeIsFound) {
+    CALayer* detached = [[CALayer new] autorelease];
+    CALayer* child = [[CALayer new] autorelease];
+    [detached addSublayer:child];
+    [child setNeedsDisplay];
+
+    [leafAt(3, 7) addSublayer:detached];
+    [_root validateDisplayHierarchy];
+
+    //  The moved layer and its child were both created needing display
+    CALayerPassStatistics stats = [CALayer _passStatistics];
+    ASSERT_EQ(2u, stats.displaysPerformed);
+}
+
+TEST_F(CALayerPassTest, ReplacedLayerIsFound) {
+    CALayer* replacement = [[CALayer new] autorelease];
+    CALayer* branch = [[_root sublayers] objectAtIndex:5];
+    CALayer* oldLeaf = [[branch sublayers] objectAtIndex:9];
+
+    [branch replaceSublayer:oldLeaf with:replacement];
+    ASSERT_EQ(branch, [replacement superlayer]);
+
+    [_root validateDisplayHierarchy];
+    CALayerPassStatistics stats = [CALayer _passStatistics];
+    ASSERT_EQ(1u, stats.displaysPerformed);
+}
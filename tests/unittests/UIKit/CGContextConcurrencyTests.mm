@@ -0,0 +1,117 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+// Renders into independent bitmap contexts from several threads at once. Every thread draws the same scene, including
+// an image shared between all of them, so each result must match a render done on one thread; the throughput at each
+// thread count shows whether contexts with different destinations still serialize against each other.
+
+#include <TestFramework.h>
+#import <CoreGraphics/CoreGraphics.h>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static const size_t sceneSize = 256;
+static const int framesPerThread = 40;
+
+static CGContextRef createSceneContext() {
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(nullptr, sceneSize, sceneSize, 8, sceneSize * 4, colorSpace, kCGImageAlphaPremultipliedLast);
+    CGColorSpaceRelease(colorSpace);
+    return context;
+}
+
+static CGImageRef createSharedImage() {
+    CGContextRef context = createSceneContext();
+    CGContextSetRGBFillColor(context, 0.2f, 0.4f, 0.8f, 1.0f);
+    CGContextFillRect(context, CGRectMake(0, 0, sceneSize, sceneSize));
+    CGContextSetRGBFillColor(context, 1.0f, 1.0f, 0.0f, 0.5f);
+    CGContextFillEllipseInRect(context, CGRectMake(32, 32, sceneSize - 64, sceneSize - 64));
+    CGImageRef image = CGBitmapContextCreateImage(context);
+    CGContextRelease(context);
+    return image;
+}
+
+static void drawScene(CGContextRef context, CGImageRef sharedImage) {
+    CGContextClearRect(context, CGRectMake(0, 0, sceneSize, sceneSize));
+    CGContextDrawImage(context, CGRectMake(16, 16, sceneSize / 2, sceneSize / 2), sharedImage);
+
+    CGContextSaveGState(context);
+    CGContextTranslateCTM(context, sceneSize / 2, sceneSize / 2);
+    CGContextRotateCTM(context, 0.3f);
+    for (int i = 0; i < 16; i++) {
+        CGContextSetRGBFillColor(context, i / 16.0f, 0.5f, 1.0f - i / 16.0f, 0.6f);
+        CGContextFillRect(context, CGRectMake(i * 4.0f - 64.0f, i * 3.0f - 48.0f, 40, 24));
+    }
+    CGContextRestoreGState(context);
+
+    CGContextSetRGBStrokeColor(context, 0.0f, 0.0f, 0.0f, 1.0f);
+    CGContextSetLineWidth(context, 3.0f);
+    CGContextMoveToPoint(context, 0, 0);
+    for (int i = 1; i <= 32; i++) {
+        CGContextAddLineToPoint(context, i * 8.0f, (i % 2) ? sceneSize - 8.0f : 8.0f);
+    }
+    CGContextStrokePath(context);
+
+    CGContextSetRGBFillColor(context, 0.9f, 0.1f, 0.1f, 0.8f);
+    CGContextFillEllipseInRect(context, CGRectMake(sceneSize / 2, sceneSize / 2, sceneSize / 3, sceneSize / 4));
+}
+
+TEST(CoreGraphics, CGContextConcurrentRendering) {
+    CGImageRef sharedImage = createSharedImage();
+
+    std::vector<unsigned char> expected(sceneSize * sceneSize * 4);
+    {
+        CGContextRef context = createSceneContext();
+        drawScene(context, sharedImage);
+        memcpy(expected.data(), CGBitmapContextGetData(context), expected.size());
+        CGContextRelease(context);
+    }
+
+    const unsigned threadCounts[] = { 1, 2, 4, 8 };
+    for (unsigned threadCount : threadCounts) {
+        std::vector<char> matched(threadCount, 0);
+        std::vector<std::thread> threads;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (unsigned t = 0; t < threadCount; t++) {
+            threads.emplace_back([&, t]() {
+                @autoreleasepool {
+                    CGContextRef context = createSceneContext();
+                    for (int frame = 0; frame < framesPerThread; frame++) {
+                        drawScene(context, sharedImage);
+                    }
+                    matched[t] = memcmp(expected.data(), CGBitmapContextGetData(context), expected.size()) == 0;
+                    CGContextRelease(context);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        for (unsigned t = 0; t < threadCount; t++) {
+            ASSERT_TRUE_MSG(matched[t], "Thread %u of %u rendered a different image", t, threadCount);
+        }
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        LOG_INFO("%u thread(s): %8.1f frames/s", threadCount, threadCount * framesPerThread / seconds);
+    }
+
+    CGImageRelease(sharedImage);
+}
@@ -0,0 +1,174 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <TestFramework.h>
+
+#import <UIKit/UIKit.h>
+#import "Starboard.h"
+#import "RowHeightIndex.h"
+#import "NullCompositor.h"
+
+#include <chrono>
+
+TEST(UITableView, RowHeightIndexOffsets) {
+    RowHeightIndex heights;
+    heights.reset(5, 10.0f, true);
+
+    ASSERT_EQ(0.0f, heights.offsetOf(0));
+    ASSERT_EQ(30.0f, heights.offsetOf(3));
+    ASSERT_EQ(50.0f, heights.totalHeight());
+
+    heights.setHeight(1, 25.0f);
+    ASSERT_EQ(35.0f, heights.offsetOf(2));
+    ASSERT_EQ(65.0f, heights.totalHeight());
+
+    ASSERT_EQ(0, heights.rowAtOffset(-5.0f));
+    ASSERT_EQ(0, heights.rowAtOffset(9.9f));
+    ASSERT_EQ(1, heights.rowAtOffset(10.0f));
+    ASSERT_EQ(1, heights.rowAtOffset(34.9f));
+    ASSERT_EQ(2, heights.rowAtOffset(35.0f));
+    ASSERT_EQ(4, heights.rowAtOffset(1000.0f));
+}
+
+TEST(UITableView, RowHeightIndexEdits) {
+    RowHeightIndex heights;
+    heights.reset(4, 10.0f, false);
+    ASSERT_EQ(4, heights.unresolvedCount());
+
+    heights.insert(2, 0.0f, true);
+    heights.insert(0, 5.0f, true);
+    ASSERT_EQ(6, heights.count());
+    ASSERT_EQ(45.0f, heights.totalHeight());
+
+    //  The empty row at index 3 is never the row at an offset
+    ASSERT_EQ(2, heights.rowAtOffset(15.0f));
+    ASSERT_EQ(4, heights.rowAtOffset(25.0f));
+
+    heights.remove(1);
+    ASSERT_EQ(35.0f, heights.totalHeight());
+    ASSERT_EQ(3, heights.unresolvedCount());
+
+    heights.setHeight(0, 7.0f);
+    ASSERT_EQ(37.0f, heights.totalHeight());
+    ASSERT_TRUE(heights.isResolved(0));
+    ASSERT_FALSE(heights.isResolved(1));
+}
+
+@interface TableRowCountingSource : NSObject <UITableViewDataSource, UITableViewDelegate>
+@property (nonatomic) NSInteger rowCount;
+@property (nonatomic) NSInteger heightRequests;
+@end
+
+@implementation TableRowCountingSource
+- (NSInteger)tableView:(UITableView*)tableView numberOfRowsInSection:(NSInteger)section {
+    return _rowCount;
+}
+
+- (UITableViewCell*)tableView:(UITableView*)tableView cellForRowAtIndexPath:(NSIndexPath*)indexPath {
+    return [[[UITableViewCell alloc] initWithStyle:UITableViewCellStyleDefault reuseIdentifier:@"cell"] autorelease];
+}
+
+- (CGFloat)tableView:(UITableView*)tableView heightForRowAtIndexPath:(NSIndexPath*)indexPath {
+    _heightRequests++;
+    return 20.0f + ([indexPath row] % 3) * 10.0f;
+}
+@end
+
+class UITableViewTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        static bool initialized;
+
+        if (!initialized) {
+            SetCACompositor(new NullCompositor);
+            initialized = true;
+        }
+
+        _source = [[TableRowCountingSource new] autorelease];
+        _table = [[[UITableView alloc] initWithFrame:CGRectMake(0, 0, 320, 480) style:UITableViewStylePlain] autorelease];
+        [_table setDataSource:_source];
+        [_table setDelegate:_source];
+    }
+
+    virtual void TearDown() {
+        _table = nil;
+        _source = nil;
+    }
+
+    StrongId<TableRowCountingSource> _source;
+    StrongId<UITableView> _table;
+};
+
+TEST_F(UITableViewTest, EstimatedRowHeightsAreNotMeasuredOnReload) {
+    static const NSInteger rowCount = 100000;
+
+    [_source setRowCount:rowCount];
+    [_table setEstimatedRowHeight:30.0f];
+
+    auto start = std::chrono::high_resolution_clock::now();
+    [_table reloadData];
+    auto end = std::chrono::high_resolution_clock::now();
+    LOG_INFO("reloadData with %d estimated rows: %.2f ms", (int)rowCount, std::chrono::duration<double, std::milli>(end - start).count());
+
+    ASSERT_EQ(0, [_source heightRequests]);
+    ASSERT_EQ(rowCount, [_table numberOfRowsInSection:0]);
+    ASSERT_EQ(rowCount * 30.0f, [_table contentSize].height);
+
+    CGRect lastRect = [_table rectForRowAtIndexPath:[NSIndexPath indexPathForRow:rowCount - 1 inSection:0]];
+    ASSERT_EQ((rowCount - 1) * 30.0f, lastRect.origin.y);
+    ASSERT_EQ(30.0f, lastRect.size.height);
+
+    NSIndexPath* path = [_table indexPathForRowAtPoint:CGPointMake(10, 30.0f * 54321 + 1.0f)];
+    ASSERT_EQ(54321, [path row]);
+}
+
+TEST_F(UITableViewTest, ExactRowHeightsArePrefixSummed) {
+    [_source setRowCount:1000];
+    [_table reloadData];
+
+    ASSERT_EQ(1000, [_source heightRequests]);
+
+    //  Heights cycle through 20, 30 and 40
+    CGRect rect = [_table rectForRowAtIndexPath:[NSIndexPath indexPathForRow:301 inSection:0]];
+    ASSERT_EQ(100 * 90.0f + 20.0f, rect.origin.y);
+    ASSERT_EQ(30.0f, rect.size.height);
+
+    NSArray* rows = [_table indexPathsForRowsInRect:CGRectMake(0, 90.0f, 320, 60.0f)];
+    ASSERT_EQ(3, [rows count]);
+    ASSERT_EQ(3, [[rows objectAtIndex:0] row]);
+    ASSERT_EQ(5, [[rows lastObject] row]);
+}
+
+TEST_F(UITableViewTest, InsertAndDeleteRowsUpdateGeometry) {
+    [_source setRowCount:10];
+    [_table reloadData];
+    float height = [_table contentSize].height;
+
+    [_source setRowCount:12];
+    [_table insertRowsAtIndexPaths:@[ [NSIndexPath indexPathForRow:0 inSection:0], [NSIndexPath indexPathForRow:5 inSection:0] ]
+                  withRowAnimation:UITableViewRowAnimationNone];
+
+    //  Inserted rows are measured at their new positions: row 0 is 20 high and row 5 is 40 high
+    ASSERT_EQ(12, [_table numberOfRowsInSection:0]);
+    ASSERT_EQ(height + 60.0f, [_table contentSize].height);
+
+    [_source setRowCount:10];
+    [_table deleteRowsAtIndexPaths:@[ [NSIndexPath indexPathForRow:0 inSection:0], [NSIndexPath indexPathForRow:5 inSection:0] ]
+                  withRowAnimation:UITableViewRowAnimationNone];
+
+    ASSERT_EQ(10, [_table numberOfRowsInSection:0]);
+    ASSERT_EQ(height, [_table contentSize].height);
+}
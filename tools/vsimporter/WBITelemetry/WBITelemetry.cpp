@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <codecvt>
+#include <mutex>
 
 #include "WBITelemetry.h"
 
@@ -29,6 +30,9 @@ namespace WBITelemetry
 
     ApplicationInsights::core::TelemetryClient WBITelemetryManager::m_tc = ApplicationInsights::core::TelemetryClient(m_iKey);
 
+    // Events can come from several threads at once (xib2nib batch conversions), and the client is not thread safe.
+    static std::mutex s_clientLock;
+
     // Initialize AI with the Instrumentation Key.  Caller will provide.
     void WBITelemetryManager::InitializeAppInsights(wstring ikey)
     {
@@ -40,6 +44,7 @@ namespace WBITelemetry
     // Flush the queued events.
     void WBITelemetryManager::Flush()
     {
+        std::lock_guard<std::mutex> lock(s_clientLock);
         WBITelemetryManager::m_tc.Flush();
     }
 
@@ -47,6 +52,7 @@ namespace WBITelemetry
     void WBITelemetryManager::AITrackEvent(wstring eventMessage)
     {
         //Need to validate m_tc
+        std::lock_guard<std::mutex> lock(s_clientLock);
         WBITelemetryManager::m_tc.TrackEvent(eventMessage);
     }
 
@@ -55,6 +61,7 @@ namespace WBITelemetry
     {
         ApplicationInsights::core::wstring_wstring_map props; //typedef std::map<std::wstring, std::wstring> wstring_wstring_map;
         props.insert({ std::wstring(L"Data"), std::wstring(eventData) });
+        std::lock_guard<std::mutex> lock(s_clientLock);
         WBITelemetryManager::m_tc.TrackEvent(eventName, props);
     }
 
@@ -76,6 +83,7 @@ namespace WBITelemetry
         va_start(args, eventMessage);
         nSize = _vsnwprintf_s(buff, sizeof(buff)-1, eventMessage.c_str(), args);
 
+        std::lock_guard<std::mutex> lock(s_clientLock);
         WBITelemetryManager::m_tc.TrackEvent(buff);
 
         va_end(args);
@@ -84,12 +92,14 @@ namespace WBITelemetry
     void WBITelemetryManager::AITrackTrace(wstring traceMessage)
     {
         //Need to validate m_tc
+        std::lock_guard<std::mutex> lock(s_clientLock);
         WBITelemetryManager::m_tc.TrackTrace(traceMessage);
     }
 
     void WBITelemetryManager::AITrackMetric(wstring eventMessage, double value)
     {
         //Need to validate m_tc
+        std::lock_guard<std::mutex> lock(s_clientLock);
         WBITelemetryManager::m_tc.TrackMetric(eventMessage, value);
     }
 }
\ No newline at end of file
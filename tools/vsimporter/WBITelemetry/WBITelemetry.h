@@ -15,6 +15,19 @@
 //******************************************************************************
 #pragma once
 
+#ifndef _WIN32
+
+//  AppInsights is Windows only; elsewhere the telemetry calls compile away
+#define TELEMETRY_INIT(ikey)
+#define TELEMETRY_FLUSH()
+#define TELEMETRY_EVENT(msg)
+#define TELEMETRY_EVENT_DATA(eventName, eventData)
+#define TELEMETRY_EVENT_PARMS(msg, ...)
+#define TELEMETRY_METRIC(msg, value)
+#define TELEMETRY_TRACE(msg)
+
+#else
+
 #include "..\..\..\deps\3rdparty\AppInsights\src\core\TelemetryClient.h" //  ...\ApplicationInsights-CPP-master\src\core\TelemetryClient.h
 
 
@@ -83,3 +96,5 @@ namespace WBITelemetry
         static void AITrackMetric(wstring eventMessage, double value);
     };
 }
+
+#endif
@@ -19,6 +19,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <chrono>
 
 #include "types.h"
 #include "SplitStream.h"
@@ -71,4 +72,15 @@ private:
   static SBLog s_logger;
 };
 
+// Logs how long a phase of the import took, when it goes out of scope
+class SBPhaseTimer {
+public:
+  explicit SBPhaseTimer(const String& phase);
+  ~SBPhaseTimer();
+
+private:
+  String m_phase;
+  std::chrono::steady_clock::time_point m_start;
+};
+
 #endif /* _SBLOG_H_ */
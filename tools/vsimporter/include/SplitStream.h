@@ -18,8 +18,34 @@
 #define _SPLITSTREAM_H_
 
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
 #include <vector>
 
+class SplitStream;
+
+// Holds everything one thread writes to SplitStreams until replay() writes it out, so output from work done in
+// parallel can be written in a fixed order
+class SplitStreamCapture {
+public:
+  std::ostream& streamFor(SplitStream* target)
+  {
+    if (m_segments.empty() || m_segments.back().first != target)
+      m_segments.push_back(std::make_pair(target, std::make_shared<std::ostringstream>()));
+    return *m_segments.back().second;
+  }
+
+  inline void replay();
+
+private:
+  typedef std::vector<std::pair<SplitStream*, std::shared_ptr<std::ostringstream> > > SegmentVec;
+
+  SegmentVec m_segments;
+};
+
 class SplitStream {
 public:
   SplitStream() {}
@@ -27,8 +53,22 @@ public:
   void addStream(std::ostream& s) { m_ostreams.push_back(&s); }
   void clear() { m_ostreams.clear(); }
 
+  // While set, the calling thread's output goes to the capture instead
+  static SplitStreamCapture*& threadCapture()
+  {
+    static thread_local SplitStreamCapture* s_capture = NULL;
+    return s_capture;
+  }
+
   SplitStream& operator<<(std::ostream& (*sfun)(std::ostream&))
   {
+    if (m_ostreams.empty())
+      return *this;
+    if (threadCapture()) {
+      sfun(threadCapture()->streamFor(this));
+      return *this;
+    }
+
     for (OStreamVecIt it = m_ostreams.begin(); it != m_ostreams.end(); ++it)
       sfun(**it);
     return *this;
@@ -37,11 +77,24 @@ public:
   template <class T>
   inline SplitStream& operator<<(T val)
   {
+    if (m_ostreams.empty())
+      return *this;
+    if (threadCapture()) {
+      threadCapture()->streamFor(this) << val;
+      return *this;
+    }
+
     for (OStreamVecIt it = m_ostreams.begin(); it != m_ostreams.end(); ++it)
       **it << val;
     return *this;
   }
 
+  void write(const std::string& str)
+  {
+    for (OStreamVecIt it = m_ostreams.begin(); it != m_ostreams.end(); ++it)
+      **it << str << std::flush;
+  }
+
 private:
   typedef std::vector<std::ostream*> OStreamVec;
   typedef OStreamVec::iterator OStreamVecIt;
@@ -49,4 +102,14 @@ private:
   OStreamVec m_ostreams;
 };
 
-#endif /* _SPLITSTREAM_H_ */
\ No newline at end of file
+inline void SplitStreamCapture::replay()
+{
+  static std::mutex s_replayMutex;
+  std::lock_guard<std::mutex> lock(s_replayMutex);
+
+  for (SegmentVec::iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+    it->first->write(it->second->str());
+  m_segments.clear();
+}
+
+#endif /* _SPLITSTREAM_H_ */
@@ -27,6 +27,7 @@ public:
 
 class VariableCollection {
 public:
+  VariableCollection() : m_version(0) {}
   virtual ~VariableCollection() {}
 
   void insert(const VariableCollection& vc);
@@ -41,6 +42,15 @@ public:
   virtual bool isSet(const String& varName) const;
   virtual void getVariableSet(StringSet& ret) const = 0;
   virtual void print(const VarPrintFunc& pf) const;
+
+  // Changes with every insert or erase, so cached expansions can tell they are stale
+  unsigned long getVersion() const { return m_version; }
+
+protected:
+  void changed() { m_version++; }
+
+private:
+  unsigned long m_version;
 };
 
 #endif /* _VARIABLECOLLECTION_H_ */
\ No newline at end of file
@@ -17,6 +17,9 @@
 #ifndef _VARIABLECOLLECTIONHIERARCHY_H_
 #define _VARIABLECOLLECTIONHIERARCHY_H_
 
+#include <mutex>
+#include <unordered_map>
+
 #include "types.h"
 
 class VariableCollection;
@@ -24,6 +27,8 @@ class VarPrintFunc;
 
 class VariableCollectionHierarchy {
 public:
+  VariableCollectionHierarchy();
+
   void push_back(const VariableCollection& vc);
   void pop_back();
 
@@ -40,7 +45,27 @@ public:
   size_t size() const;
 
 private:
+  friend class XCVariableExpander;
+
+  // An expanded value, and every variable looked up while expanding it
+  struct CachedValue {
+    String value;
+    bool found;
+    StringSet dependencies;
+  };
+  typedef std::unordered_map<String, CachedValue> ValueCache;
+
+  // Expanded values, one cache per search level. Targets are generated in parallel and share their project's
+  // settings, so the caches are locked.
+  bool getCachedValue(const String& varName, size_t searchLevel, CachedValue& ret) const;
+  void cacheValue(const String& varName, size_t searchLevel, const CachedValue& value) const;
+  unsigned long getVersion() const;
+
   std::vector<const VariableCollection*> m_vcs;
+  unsigned long m_levelsVersion;
+  mutable std::vector<ValueCache> m_cache;
+  mutable unsigned long m_cacheVersion;
+  mutable std::mutex m_cacheMutex;
 };
 
 #endif /* _VARIABLECOLLECTIONHIERARCHY_H_ */
\ No newline at end of file
@@ -32,13 +32,25 @@ private:
   typedef std::map<const String, size_t> VariableMarkerMap;
   typedef std::pair<const String, size_t> VariableMarkerPair;
 
+  // A variable being expanded. Its value can be cached unless something inside it was looked up part way down the
+  // hierarchy, which happens for $(inherited) and for variables that refer to themselves.
+  struct ExpansionFrame {
+    String varName;
+    bool cacheable;
+    StringSet dependencies;
+  };
+
   XCVariableExpander(); // disallow
   size_t processPossibleVar(const String& str, size_t posn, String& ret);
   size_t processBracketedVar(const String& str, size_t posn, String& ret);
   size_t processSimpleVar(const String& str, size_t posn, String& ret);
   String getInheritedName(const String& varName);
+  void markFramesAbove(const String& varName);
+  bool dependsOnFrames(const StringSet& dependencies) const;
+  void addDependencies(const String& varName, const StringSet& dependencies);
 
   VariableMarkerMap m_varMarkers;
+  std::vector<ExpansionFrame> m_frames;
   String m_currentVar;
   const VariableCollectionHierarchy& m_vch;
   size_t m_maxSearchLevel;
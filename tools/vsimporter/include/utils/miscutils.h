@@ -17,6 +17,8 @@
 #ifndef _MISCUTILS_H_
 #define _MISCUTILS_H_
 
+#include <functional>
+
 #include "types.h"
 
 String getTime();
@@ -27,4 +29,8 @@ inline unsigned arraySize(const T (&v)[S]) { return S; }
 
 void removeDupes(StringVec& in);
 
+// Calls func for every index below count, spread over one thread per processor. Log output from each call is held
+// back and written out in index order once all calls are done, so it reads the same as a serial run.
+void parallelFor(size_t count, const std::function<void(size_t)>& func);
+
 #endif /* _MISCUTILS_H_ */
@@ -32,6 +32,7 @@ void EnvironmentVariableCollection::insert(const String& varName, const String&
 #else
   setenv(varName.c_str(), varValue.c_str(), 1);
 #endif
+  changed();
 }
 
 void EnvironmentVariableCollection::erase(const String& varName)
@@ -41,6 +42,7 @@ void EnvironmentVariableCollection::erase(const String& varName)
 #else
   unsetenv(varName.c_str());
 #endif
+  changed();
 }
 
 bool EnvironmentVariableCollection::getValue(const String& varName, String& ret) const
@@ -102,3 +102,14 @@ SplitStream& SBLog::log(SBLogLevel severity)
   out << levelLabels[severity];
   return out;
 }
+
+SBPhaseTimer::SBPhaseTimer(const String& phase)
+  : m_phase(phase),
+    m_start(std::chrono::steady_clock::now())
+{}
+
+SBPhaseTimer::~SBPhaseTimer()
+{
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+  SBLog::info() << m_phase << " took " << (long)ms << " ms" << std::endl;
+}
@@ -352,7 +352,8 @@ void SBProject::constructVCProjects(VSSolution& sln, const StringSet& slnConfigs
   const XCConfigurationList* buildConfigList = m_project->getBuildConfigurationList();
   String defaultConfig = buildConfigList->getDefaultConfigurationName();
 
-  // Create VS projects from targets
+  // Expand the templates for all targets
+  std::vector<std::pair<SBTarget*, VSTemplateProject*>> targetTemplates;
   for (auto target : m_existingTargets) {
     // Construct template name
     String templateName;
@@ -384,31 +385,44 @@ void SBProject::constructVCProjects(VSSolution& sln, const StringSet& slnConfigs
     sbAssert(projTemplates.size() == 1);
 
     for (auto projTemplate : projTemplates) {
-      // Create the project from template
-      VCProject* proj = target.second->constructVCProject(projTemplate);
-      vcProjects.insert(make_pair(target.second, proj));
+      targetTemplates.push_back(std::make_pair(target.second, projTemplate));
+    }
+  }
 
-      // Add project platforms to the solution
-      for (auto platformName : projTemplate->getPlatforms()) {
-        sln.addPlatform(platformName);
-      }
-    
-      // Add a referenced to the shared headers project to targets that compile things
-      if (productType == TargetApplication || productType == TargetStaticLib)
-      {
-        proj->addSharedProject(headerProj);
-      }
-    
-      // Add the project to the solution
-      VSBuildableSolutionProject* slnProj = sln.addProject(proj, projFolder);
-
-      // Map project configurations to solution configurations
-      for (auto slnConfig : slnConfigs) {
-        if (m_selectedConfigs.find(slnConfig) != m_selectedConfigs.end()) {
-          slnProj->mapConfiguration(slnConfig, slnConfig);
-        } else {
-          slnProj->mapConfiguration(slnConfig, defaultConfig);
-        }
+  // Create the projects from the templates. This is where most of the build settings get expanded, and targets only
+  // read the project's settings, so they are constructed in parallel.
+  std::vector<VCProject*> targetProjects(targetTemplates.size());
+  parallelFor(targetTemplates.size(), [&](size_t i) {
+    targetProjects[i] = targetTemplates[i].first->constructVCProject(targetTemplates[i].second);
+  });
+
+  for (size_t i = 0; i < targetTemplates.size(); i++) {
+    SBTarget* target = targetTemplates[i].first;
+    VSTemplateProject* projTemplate = targetTemplates[i].second;
+    TargetProductType productType = target->getProductType();
+    VCProject* proj = targetProjects[i];
+    vcProjects.insert(make_pair(target, proj));
+
+    // Add project platforms to the solution
+    for (auto platformName : projTemplate->getPlatforms()) {
+      sln.addPlatform(platformName);
+    }
+
+    // Add a referenced to the shared headers project to targets that compile things
+    if (productType == TargetApplication || productType == TargetStaticLib)
+    {
+      proj->addSharedProject(headerProj);
+    }
+
+    // Add the project to the solution
+    VSBuildableSolutionProject* slnProj = sln.addProject(proj, projFolder);
+
+    // Map project configurations to solution configurations
+    for (auto slnConfig : slnConfigs) {
+      if (m_selectedConfigs.find(slnConfig) != m_selectedConfigs.end()) {
+        slnProj->mapConfiguration(slnConfig, slnConfig);
+      } else {
+        slnProj->mapConfiguration(slnConfig, defaultConfig);
       }
     }
   }
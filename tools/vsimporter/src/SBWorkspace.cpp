@@ -366,16 +366,23 @@ void SBWorkspace::generateFiles()
 
   // Construct VS Projects
   std::multimap<SBTarget*, VCProject*> vcProjects;
-  for (auto project : m_openProjects) {
-    project.second->constructVCProjects(*sln, slnConfigs, vcProjects);
+  {
+    SBPhaseTimer timer("Constructing projects");
+    for (auto project : m_openProjects) {
+      project.second->constructVCProjects(*sln, slnConfigs, vcProjects);
+    }
   }
 
   // Resolve dependencies
-  for (auto proj : vcProjects) {
-    proj.first->resolveVCProjectDependecies(proj.second, vcProjects);
+  {
+    SBPhaseTimer timer("Resolving dependencies");
+    for (auto proj : vcProjects) {
+      proj.first->resolveVCProjectDependecies(proj.second, vcProjects);
+    }
   }
 
   // Write solution/projects to disk
   sbValidate(!vcProjects.empty(), "No valid targets to import.");
+  SBPhaseTimer timer("Writing solution and projects");
   sln->write();
 }
\ No newline at end of file
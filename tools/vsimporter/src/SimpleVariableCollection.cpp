@@ -20,15 +20,19 @@
 void SimpleVariableCollection::insert(const String& varName, const String& varValue)
 {
   m_vars[varName] = varValue;
+  changed();
 }
 
 void SimpleVariableCollection::erase(const String& varName)
 {
   m_vars.erase(varName);
+  changed();
 }
 
 String& SimpleVariableCollection::operator[](const String& varName)
 {
+  // The caller assigns through the reference
+  changed();
   return m_vars[varName];
 }
 
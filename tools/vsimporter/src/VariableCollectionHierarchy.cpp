@@ -19,6 +19,9 @@
 #include "XCVariableExpander.h"
 #include "tokenizer.h"
 
+VariableCollectionHierarchy::VariableCollectionHierarchy()
+  : m_levelsVersion(0), m_cacheVersion(0) {}
+
 String VariableCollectionHierarchy::expand(const String& str) const
 {
   XCVariableExpander varExpander(*this, size()); // XCVariableExpander uses one-based indexing
@@ -69,11 +72,57 @@ bool VariableCollectionHierarchy::getValue(const String& varName, size_t searchL
 void VariableCollectionHierarchy::push_back(const VariableCollection& vc)
 {
   m_vcs.push_back(&vc);
+  m_levelsVersion++;
 }
 
 void VariableCollectionHierarchy::pop_back()
 {
   m_vcs.pop_back();
+  m_levelsVersion++;
+}
+
+unsigned long VariableCollectionHierarchy::getVersion() const
+{
+  // Every term only ever grows, so any change to any level changes the sum
+  unsigned long version = m_levelsVersion;
+  for (size_t i = 0; i < m_vcs.size(); i++)
+    version += m_vcs[i]->getVersion();
+  return version;
+}
+
+bool VariableCollectionHierarchy::getCachedValue(const String& varName, size_t searchLevel, CachedValue& ret) const
+{
+  std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+  unsigned long version = getVersion();
+  if (version != m_cacheVersion) {
+    m_cache.clear();
+    m_cacheVersion = version;
+  }
+
+  if (searchLevel >= m_cache.size())
+    return false;
+
+  ValueCache::const_iterator it = m_cache[searchLevel].find(varName);
+  if (it == m_cache[searchLevel].end())
+    return false;
+
+  ret = it->second;
+  return true;
+}
+
+void VariableCollectionHierarchy::cacheValue(const String& varName, size_t searchLevel, const CachedValue& value) const
+{
+  std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+  // Drop values worked out against settings that have changed since
+  if (getVersion() != m_cacheVersion)
+    return;
+
+  if (searchLevel >= m_cache.size())
+    m_cache.resize(searchLevel + 1);
+
+  m_cache[searchLevel][varName] = value;
 }
 
 const VariableCollection& VariableCollectionHierarchy::operator[](size_t level) const
@@ -126,6 +126,32 @@ String XCVariableExpander::getInheritedName(const String& varName)
   return varName == "inherited" ? m_currentVar : varName;
 }
 
+void XCVariableExpander::markFramesAbove(const String& varName)
+{
+  for (size_t i = m_frames.size(); i > 0 && m_frames[i - 1].varName != varName; i--) {
+    m_frames[i - 1].cacheable = false;
+  }
+}
+
+bool XCVariableExpander::dependsOnFrames(const StringSet& dependencies) const
+{
+  for (size_t i = 0; i < m_frames.size(); i++) {
+    if (dependencies.count(m_frames[i].varName))
+      return true;
+  }
+  return false;
+}
+
+void XCVariableExpander::addDependencies(const String& varName, const StringSet& dependencies)
+{
+  if (m_frames.empty())
+    return;
+
+  StringSet& frameDependencies = m_frames.back().dependencies;
+  frameDependencies.insert(varName);
+  frameDependencies.insert(dependencies.begin(), dependencies.end());
+}
+
 void XCVariableExpander::expandString(const String& str, String& ret)
 {
   for (size_t posn = 0; posn < str.length(); posn++) {
@@ -147,6 +173,24 @@ bool XCVariableExpander::getExpandedValue(const String& varName, String& ret)
   // Get the hierarchy depth at which to start searching
   size_t& searchDepth = m_varMarkers.insert(make_pair(fixedVarName, m_maxSearchLevel)).first->second;
 
+  // A variable searched for from the top has the same value every time, until the settings change, as long as none
+  // of the variables it refers to is being expanded further out. Those are searched for below the level they were
+  // found at, which is also why nothing expanded inside such a search can be cached.
+  bool fromTop = searchDepth == m_maxSearchLevel;
+  if (fromTop) {
+    VariableCollectionHierarchy::CachedValue cached;
+    if (m_vch.getCachedValue(fixedVarName, m_maxSearchLevel, cached) && !dependsOnFrames(cached.dependencies)) {
+      addDependencies(fixedVarName, cached.dependencies);
+      ret += cached.value;
+      return cached.found;
+    }
+  } else {
+    markFramesAbove(fixedVarName);
+  }
+  addDependencies(fixedVarName, StringSet());
+  ExpansionFrame frame = { fixedVarName, fromTop, StringSet() };
+  m_frames.push_back(frame);
+
   // Save the current state
   size_t savedDepth = searchDepth;
   String savedVar = m_currentVar;
@@ -162,8 +206,20 @@ bool XCVariableExpander::getExpandedValue(const String& varName, String& ret)
   }
 
   // Expand the value
+  size_t expansionStart = ret.size();
   expandString(val, ret);
 
+  // Cache the value, and pass what it depends on to the variable it was expanded for
+  ExpansionFrame& expanded = m_frames.back();
+  if (expanded.cacheable) {
+    VariableCollectionHierarchy::CachedValue cached = { ret.substr(expansionStart), found, expanded.dependencies };
+    m_vch.cacheValue(fixedVarName, m_maxSearchLevel, cached);
+  }
+  StringSet dependencies;
+  dependencies.swap(expanded.dependencies);
+  m_frames.pop_back();
+  addDependencies(fixedVarName, dependencies);
+
   // Restore the original state
   searchDepth = savedDepth;
   m_currentVar = savedVar;
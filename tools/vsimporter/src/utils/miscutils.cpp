@@ -15,7 +15,11 @@
 //******************************************************************************
 
 #include "miscutils.h"
+#include "SBLog.h"
 #include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 String getTime()
 {
@@ -44,4 +48,35 @@ void removeDupes(StringVec& vec)
   }
 
   vec.assign(ret.begin(), ret.end());
-}
\ No newline at end of file
+}
+
+void parallelFor(size_t count, const std::function<void(size_t)>& func)
+{
+  // Already inside a parallelFor; the log is being held by the outer one
+  if (SplitStream::threadCapture()) {
+    for (size_t i = 0; i < count; i++)
+      func(i);
+    return;
+  }
+
+  std::vector<SplitStreamCapture> logs(count);
+  std::atomic<size_t> nextIndex(0);
+  auto worker = [&]() {
+    for (size_t i = nextIndex++; i < count; i = nextIndex++) {
+      SplitStream::threadCapture() = &logs[i];
+      func(i);
+      SplitStream::threadCapture() = NULL;
+    }
+  };
+
+  size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < threadCount && i < count; i++)
+    threads.push_back(std::thread(worker));
+  worker();
+  for (auto& thread : threads)
+    thread.join();
+
+  for (auto& log : logs)
+    log.replay();
+}
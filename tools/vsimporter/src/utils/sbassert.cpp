@@ -20,11 +20,19 @@
 #include "sbassert.h"
 #include "..\WBITelemetry\WBITelemetry.h"
 
+// Write out anything this thread's log output was being held for, so it is not lost on exit
+static void replayCapturedLog()
+{
+  if (SplitStream::threadCapture())
+    SplitStream::threadCapture()->replay();
+}
+
 void sbAssert(bool condition, const std::string& cause)
 {
   if (!condition) {
     if (!cause.empty())
       SBLog::error() << cause << std::endl;
+    replayCapturedLog();
     SBLog::printLocation();
 #ifdef _DEBUG
     abort();
@@ -41,6 +49,7 @@ void sbValidate(bool condition, const std::string& cause)
   if (!condition) {
     if (!cause.empty())
       SBLog::error() << cause << std::endl;
+    replayCapturedLog();
     SBLog::printLocation();
     // Due to issue 6715724, flush before exiting
     TELEMETRY_FLUSH();
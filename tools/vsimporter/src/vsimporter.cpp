@@ -294,26 +294,33 @@ int main(int argc, char* argv[])
 
   // Create a workspace
   SBWorkspace *mainWorkspace;
-  if (workspaceSet) {
-    mainWorkspace = SBWorkspace::createFromWorkspace(workspacePath);
-  } else if (projectSet) {
-    mainWorkspace = SBWorkspace::createFromProject(projectPath);
-  } else {
-    sbAssert(0); // non-reachable
+  {
+    SBPhaseTimer timer("Opening workspace");
+    if (workspaceSet) {
+      mainWorkspace = SBWorkspace::createFromWorkspace(workspacePath);
+    } else if (projectSet) {
+      mainWorkspace = SBWorkspace::createFromProject(projectPath);
+    } else {
+      sbAssert(0); // non-reachable
+    }
   }
 
   if (mode == ListMode) {
     mainWorkspace->printSummary();
   } else if (mode == GenerateMode) {
-    if (allTargets) {
-      mainWorkspace->queueAllTargets(configurations);
-    } else if (projectSet) {
-      mainWorkspace->queueTargets(targets, configurations);
-    } else if (workspaceSet) {
-      mainWorkspace->queueSchemes(schemes, configurations);
-    } else {
-      sbAssert(0); // non-reachable
+    {
+      SBPhaseTimer timer("Loading targets");
+      if (allTargets) {
+        mainWorkspace->queueAllTargets(configurations);
+      } else if (projectSet) {
+        mainWorkspace->queueTargets(targets, configurations);
+      } else if (workspaceSet) {
+        mainWorkspace->queueSchemes(schemes, configurations);
+      } else {
+        sbAssert(0); // non-reachable
+      }
     }
+    SBPhaseTimer timer("Generating files");
     mainWorkspace->generateFiles();
   } else {
     sbAssert(0); // non-reachable
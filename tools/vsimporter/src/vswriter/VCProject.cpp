@@ -19,7 +19,6 @@
 #include "VCProjectItem.h"
 #include "VSTemplateProject.h"
 #include "vshelpers.h"
-#include "sole/sole.hpp"
 #include "pugixml.hpp"
 #include "utils.h"
 #include "sbassert.h"
@@ -42,7 +41,7 @@ VCProject::VCProject(VSTemplateProject* projTemplate, const std::string& id)
   if (!id.empty())
     m_id = id;
   else
-    m_id = sole::uuid4().str();
+    m_id = generateUUID();
 
   addGlobalProperty("ProjectGuid", formatVSGUID(m_id));
 }
@@ -376,7 +375,7 @@ void VCProject::writeFilterDescriptions(pugi::xml_node& node) const
   pugi::xml_node tempNode = node.parent().append_child("Temp");
   for (auto filter : filters) {
     // Generate a unique id
-    std::string id = sole::uuid4().str();
+    std::string id = generateUUID();
 
     // Fix up the filter path to be Windows-style
     std::string winFilterPath = winPath(filter);
@@ -16,7 +16,6 @@
 
 #include "VCSharedProject.h"
 #include "VCProjectItem.h"
-#include "sole/sole.hpp"
 #include "sbassert.h"
 #include "SBLog.h"
 #include "fileutils.h"
@@ -27,7 +26,7 @@ VCSharedProject::~VCSharedProject() {}
 VCSharedProject::VCSharedProject(VSTemplateProject* projTemplate)
 : VCProject(projTemplate)
 {
-  m_sharedId = sole::uuid4().str();
+  m_sharedId = generateUUID();
 
   m_globalProps.clear();
   addGlobalProperty("ItemsProjectGuid", formatVSGUID(m_id));
@@ -15,6 +15,7 @@
 //******************************************************************************
 
 #include <fstream>
+#include <vector>
 
 #include "sbassert.h"
 #include "utils.h"
@@ -256,10 +257,16 @@ void VSSolution::write(std::ostream& out) const
   writeNestedProjects(out);
   out << "EndGlobal" << std::endl;
 
-  // Write project files
+  // Write project files. Each project writes only its own files, so they are written in parallel.
+  std::vector<const VCProject*> projects;
   for (auto project : m_buildableProjects) {
-    project.second->getProject()->write();
-    std::cout << "Generated " << project.second->getProject()->getPath() << std::endl;
+    projects.push_back(project.second->getProject());
+  }
+  parallelFor(projects.size(), [&](size_t i) {
+    projects[i]->write();
+  });
+  for (auto project : projects) {
+    std::cout << "Generated " << project->getPath() << std::endl;
   }
 
   std::cout << "Generated " << m_absFilePath << std::endl;
@@ -16,12 +16,12 @@
 
 #include "VSSolutionFolderProject.h"
 #include "VSSolution.h"
-#include "sole/sole.hpp"
+#include "vshelpers.h"
 
 VSSolutionFolderProject::VSSolutionFolderProject(const std::string& name, VSSolution& parent)
 : VSSolutionProject(parent), m_name(name)
 {
-  m_id = sole::uuid4().str();
+  m_id = generateUUID();
 }
 
 std::string VSSolutionFolderProject::getName() const
@@ -17,7 +17,7 @@
 #include "VSTemplateParameters.h"
 #include "BuildSettings.h"
 #include "utils.h"
-#include <sole/sole.hpp>
+#include "vshelpers.h"
 
 static std::string getSafeString(std::string str, char replacement)
 {
@@ -37,7 +37,7 @@ VSTemplateParameters::VSTemplateParameters()
 {
   // Set up basic parameters map
   for (unsigned i = 1; i <= 10; i++) {
-    m_params["$guid" + std::to_string(i) + "$"] = sole::uuid4().str();
+    m_params["$guid" + std::to_string(i) + "$"] = generateUUID();
   }
   m_params["$targetnametoken$"] = "$targetnametoken$";
 }
@@ -17,7 +17,9 @@
 #include "vshelpers.h"
 #include "stringutils.h"
 #include "SBLog.h"
+#include "sole/sole.hpp"
 #include <pugixml.hpp>
+#include <mutex>
 
 typedef std::string String;
 typedef std::map<std::string, std::string> StringMap;
@@ -38,6 +40,14 @@ String formatVSGUID(const String& guid)
   return String("{") + strToUpper(guid) + "}";
 }
 
+String generateUUID()
+{
+  // sole keeps its random generator in statics, and projects are generated and written in parallel
+  static std::mutex s_uuidMutex;
+  std::lock_guard<std::mutex> lock(s_uuidMutex);
+  return sole::uuid4().str();
+}
+
 pugi::xml_node appendNodeWithText(pugi::xml_node& parent, const String& nodeName, const String& nodeText, const String& nodeCond)
 {
   pugi::xml_node node = parent.append_child(nodeName.c_str());
@@ -0,0 +1,249 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include "BatchConversion.h"
+#include "OutputFile.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char* c_manifestHeader = "xib2nib-manifest 1";
+
+struct BatchEntry {
+    std::string _input, _output;
+    uint64_t _hash;
+    bool _hashed;
+    bool _skipped;
+    int _result;
+};
+
+struct ManifestEntry {
+    uint64_t _hash;
+    std::string _output;
+};
+
+typedef std::map<std::string, ManifestEntry> Manifest;
+
+//  64-bit FNV-1a over the file's bytes
+static bool HashFile(const std::string& path, uint64_t* hash) {
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (!fp) {
+        return false;
+    }
+
+    uint64_t result = 14695981039346656037ULL;
+    unsigned char buffer[64 * 1024];
+    size_t bytesRead;
+    while ((bytesRead = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        for (size_t i = 0; i < bytesRead; i++) {
+            result = (result ^ buffer[i]) * 1099511628211ULL;
+        }
+    }
+
+    bool ok = ferror(fp) == 0;
+    fclose(fp);
+    *hash = result;
+    return ok;
+}
+
+static bool PathExists(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+static bool ReadLine(FILE* fp, std::string& line) {
+    line.clear();
+    int c;
+    while ((c = fgetc(fp)) != EOF && c != '\n') {
+        line += (char)c;
+    }
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    return c != EOF || !line.empty();
+}
+
+static bool ReadList(const char* listPath, std::vector<BatchEntry>& entries) {
+    FILE* fp = fopen(listPath, "rb");
+    if (!fp) {
+        printf("Error opening %s\n", listPath);
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    bool ok = true;
+    while (ReadLine(fp, line)) {
+        lineNumber++;
+        if (line.empty()) {
+            continue;
+        }
+
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos || tab == 0 || tab == line.size() - 1) {
+            printf("%s(%d): expected <input>\\t<output>\n", listPath, lineNumber);
+            ok = false;
+            continue;
+        }
+
+        BatchEntry entry;
+        entry._input = line.substr(0, tab);
+        entry._output = line.substr(tab + 1);
+        entry._hash = 0;
+        entry._hashed = false;
+        entry._skipped = false;
+        entry._result = 0;
+        entries.push_back(entry);
+    }
+
+    fclose(fp);
+    return ok;
+}
+
+//  A missing or unreadable manifest just means everything is converted
+static void ReadManifest(const char* manifestPath, Manifest& manifest) {
+    FILE* fp = fopen(manifestPath, "rb");
+    if (!fp) {
+        return;
+    }
+
+    std::string line;
+    if (ReadLine(fp, line) && line == c_manifestHeader) {
+        while (ReadLine(fp, line)) {
+            size_t firstTab = line.find('\t');
+            size_t secondTab = (firstTab == std::string::npos) ? std::string::npos : line.find('\t', firstTab + 1);
+            if (secondTab == std::string::npos) {
+                continue;
+            }
+
+            ManifestEntry entry;
+            entry._hash = strtoull(line.substr(0, firstTab).c_str(), NULL, 16);
+            entry._output = line.substr(secondTab + 1);
+            manifest[line.substr(firstTab + 1, secondTab - firstTab - 1)] = entry;
+        }
+    }
+
+    fclose(fp);
+}
+
+static bool WriteManifest(const char* manifestPath, const Manifest& manifest) {
+    OutputFile output(manifestPath);
+    FILE* fp = output.Open();
+    if (!fp) {
+        return false;
+    }
+
+    fprintf(fp, "%s\n", c_manifestHeader);
+    for (const auto& entry : manifest) {
+        fprintf(fp, "%016llx\t%s\t%s\n", (unsigned long long)entry.second._hash, entry.first.c_str(), entry.second._output.c_str());
+    }
+
+    return output.Commit();
+}
+
+static bool IsUpToDate(const BatchEntry& entry, const Manifest& manifest) {
+    auto found = manifest.find(entry._input);
+    return entry._hashed && found != manifest.end() && found->second._hash == entry._hash && found->second._output == entry._output &&
+           PathExists(entry._output);
+}
+
+int ConvertBatch(const char* listPath, const char* manifestPath, int jobs, ConvertFileFunc convert) {
+    std::vector<BatchEntry> entries;
+    if (!ReadList(listPath, entries)) {
+        return 1;
+    }
+
+    Manifest manifest;
+    ReadManifest(manifestPath, manifest);
+
+    if (jobs <= 0) {
+        jobs = (int)std::thread::hardware_concurrency();
+    }
+    if (jobs <= 0) {
+        jobs = 1;
+    }
+    if ((size_t)jobs > entries.size()) {
+        jobs = (int)entries.size();
+    }
+
+    //  Workers take the next entry until the list runs out; each conversion runs start to finish on one thread
+    std::atomic<size_t> nextEntry(0);
+    auto worker = [&]() {
+        for (;;) {
+            size_t index = nextEntry++;
+            if (index >= entries.size()) {
+                break;
+            }
+
+            BatchEntry& entry = entries[index];
+            entry._hashed = HashFile(entry._input, &entry._hash);
+            if (IsUpToDate(entry, manifest)) {
+                entry._skipped = true;
+                continue;
+            }
+
+            entry._result = convert(entry._input.c_str(), entry._output.c_str());
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < jobs; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    int result = 0;
+    int converted = 0, skipped = 0, failed = 0;
+    for (const BatchEntry& entry : entries) {
+        if (entry._skipped) {
+            skipped++;
+        } else if (entry._result == 0 && entry._hashed) {
+            converted++;
+            ManifestEntry& manifestEntry = manifest[entry._input];
+            manifestEntry._hash = entry._hash;
+            manifestEntry._output = entry._output;
+        } else {
+            failed++;
+            manifest.erase(entry._input);
+            printf("Failed to convert %s\n", entry._input.c_str());
+            if (result == 0) {
+                result = (entry._result != 0) ? entry._result : 2;
+            }
+        }
+    }
+
+    if (!WriteManifest(manifestPath, manifest)) {
+        printf("Unable to write %s\n", manifestPath);
+        if (result == 0) {
+            result = 3;
+        }
+    }
+
+    printf("%d converted, %d up to date, %d failed\n", converted, skipped, failed);
+    return result;
+}
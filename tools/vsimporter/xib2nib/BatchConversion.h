@@ -0,0 +1,25 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#pragma once
+
+typedef int (*ConvertFileFunc)(const char* inputPath, const char* outputPath);
+
+//  Converts every input listed in listPath, one "input<TAB>output" pair per line, on up to jobs threads (0 picks one
+//  per processor). manifestPath records a content hash for each input converted successfully; an input whose hash and
+//  output match its manifest entry, and whose output still exists, is skipped. Returns 0 if every conversion succeeded,
+//  or the first non-zero result otherwise.
+int ConvertBatch(const char* listPath, const char* manifestPath, int jobs, ConvertFileFunc convert);
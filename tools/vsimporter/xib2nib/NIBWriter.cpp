@@ -18,36 +18,59 @@
 #include "XIBObjectTypes.h"
 #include "UIRuntimeOutletConnection.h"
 #include "UIRuntimeEventConnection.h"
+#include "UIRuntimeOutletCollectionConnection.h"
 #include "UIProxyObject.h"
+#include "OutputFile.h"
 #include <assert.h>
+#include <stdlib.h>
+#include <algorithm>
 #include <map>
 
-#include "..\WBITelemetry\WBITelemetry.h"
+#include "../WBITelemetry/WBITelemetry.h"
 
-int curPlaceholder = 1;
+thread_local int curPlaceholder = 1;
+
+void NIBWriter::FlushOutput()
+{
+    if ( _outputBuffered > 0 ) {
+        fwrite(_outputBuffer, 1, _outputBuffered, fpOut);
+        _outputBuffered = 0;
+    }
+}
 
 void NIBWriter::WriteInt(int val, int minlen)
 {
     int len = 0;
     while ( val >= 0x80 || len < minlen - 1 ) {
-        int outByte = val & 0x7F;
+        WriteByte(val & 0x7F);
         val >>= 7;
-        fwrite(&outByte, 1, 1, fpOut);
         len ++;
     }
 
-    val |= 0x80;
-    fwrite(&val, 1, 1, fpOut);
+    WriteByte(val | 0x80);
 }
 
 void NIBWriter::WriteByte(int byte)
 {
-    fwrite(&byte, 1, 1, fpOut);
+    if ( _outputBuffered == c_outputBufferSize ) FlushOutput();
+    _outputBuffer[_outputBuffered ++] = (unsigned char) byte;
+    _outputPos ++;
 }
 
 void NIBWriter::WriteBytes(void *bytes, int len)
 {
-    fwrite(bytes, 1, len, fpOut);
+    if ( _outputBuffered + len > c_outputBufferSize ) {
+        FlushOutput();
+        if ( len > c_outputBufferSize ) {
+            fwrite(bytes, 1, len, fpOut);
+            _outputPos += len;
+            return;
+        }
+    }
+
+    memcpy(_outputBuffer + _outputBuffered, bytes, len);
+    _outputBuffered += len;
+    _outputPos += len;
 }
 
 XIBObject* NIBWriter::AddOutputObject(XIBObject *pObj)
@@ -70,10 +93,8 @@ XIBObject* NIBWriter::AddOutputObject(XIBObject *pObj)
             pObj = GetProxyFor(pObj);
         }
     }
-    for ( size_t i = 0; i < _outputObjects.size(); i ++ ) {
-        if ( _outputObjects[i] == pObj ) {
-            return pObj;
-        }
+    if ( !_outputObjectSet.insert(pObj).second ) {
+        return pObj;
     }
 
     _outputObjects.push_back(pObj);
@@ -97,36 +118,18 @@ typedef struct
 class StringCombiner
 {
 public:
-    char **_stringTable;
-    int    _numStrings, _maxStrings;
-
-    StringCombiner()
-    {
-        _numStrings = 0;
-        _maxStrings = 32;
-        _stringTable = (char **) malloc(sizeof(char *) * _maxStrings);
-    }
+    std::vector<const char *> _stringTable;
+    std::unordered_map<std::string, int> _stringIndexes;
 
+    //  Strings are numbered in the order they're first added
     int AddString(const char *str)
     {
-        for ( int i = 0; i < _numStrings; i ++ ) {
-            if ( strcmp(_stringTable[i], str) == 0 ) {
-                return i;
-            }
-        }
-
-        if ( _numStrings + 1 > _maxStrings ) {
-            _maxStrings += 64;
-            _stringTable = (char **) realloc(_stringTable, sizeof(char *) * _maxStrings);
+        auto inserted = _stringIndexes.emplace(str, (int) _stringTable.size());
+        if ( inserted.second ) {
+            _stringTable.push_back(inserted.first->first.c_str());
         }
 
-        _stringTable[_numStrings] = (char *) malloc(strlen(str) + 1);
-        strcpy(_stringTable[_numStrings], str);
-
-        int ret = _numStrings;
-        _numStrings ++;
-
-        return ret;
+        return inserted.first->second;
     }
 };
 
@@ -138,6 +141,9 @@ NIBWriter::NIBWriter(FILE *out)
     _connections = NULL;
     _visibleWindows = NULL;
     fpOut = out;
+    _outputBuffer = NULL;
+    _outputBuffered = 0;
+    _outputPos = 0;
 }
 
 NIBWriter::NIBWriter(FILE *out, XIBDictionary *externalReferences, XIBObject *base)
@@ -148,6 +154,9 @@ NIBWriter::NIBWriter(FILE *out, XIBDictionary *externalReferences, XIBObject *ba
     _connections = NULL;
     _visibleWindows = NULL;
     fpOut = out;
+    _outputBuffer = NULL;
+    _outputBuffered = 0;
+    _outputPos = 0;
 
     curPlaceholder = 1;
     _baseObject = base;
@@ -162,7 +171,100 @@ NIBWriter::NIBWriter(FILE *out, XIBDictionary *externalReferences, XIBObject *ba
 void NIBWriter::ExportObject(XIBObject *obj)
 {
     _topObjects->AddMember(NULL, obj);
-    _allUIObjects->AddMember(NULL, obj);
+    AddUIObject(obj);
+}
+
+//  Same as _allUIObjects->AddMember(NULL, obj), without searching the whole list for obj each time
+void NIBWriter::AddUIObject(XIBObject *obj)
+{
+    if ( _uiObjectSet.insert(obj).second ) {
+        _allUIObjects->AppendMember(NULL, obj);
+    }
+}
+
+//  Connections are always new objects, so there's nothing to search for
+void NIBWriter::AddConnection(XIBObject *connection)
+{
+    _connections->AppendMember(NULL, connection);
+}
+
+struct ConnectionSortEntry
+{
+    XIBMember *_member;
+    bool _isEvent;
+    const char *_label;
+};
+
+static bool MemberNameIs(XIBMember *member, const char *name)
+{
+    if ( member->_name == NULL || name == NULL ) return member->_name == name;
+    return strcmp(member->_name, name) == 0;
+}
+
+//  Sorts the members named sortedName the way Interface Builder orders connection records. Only neighbouring
+//  connections of the same class, or an outlet followed by an event, ever trade places, so the list falls into
+//  independent runs: a run of event and outlet connections gets its events first, each group ordered by label, and
+//  a run of any other connection class is ordered by label. Equal labels keep their order.
+void NIBWriter::SortConnections(memberList &members, const char *sortedName, const char *eventClassName,
+                                const char *outletClassName, ConnectionLabelFunc getLabel)
+{
+    std::vector<ConnectionSortEntry> run;
+
+    size_t start = 0;
+    while ( start < members.size() ) {
+        if ( !MemberNameIs(members[start], sortedName) ) {
+            start ++;
+            continue;
+        }
+
+        const char *runClassName = members[start]->_obj->_className;
+        bool isConnectionRun = strcmp(runClassName, eventClassName) == 0 || strcmp(runClassName, outletClassName) == 0;
+
+        run.clear();
+        size_t end = start;
+        while ( end < members.size() && MemberNameIs(members[end], sortedName) ) {
+            const char *className = members[end]->_obj->_className;
+            bool isEvent = strcmp(className, eventClassName) == 0;
+
+            if ( isConnectionRun ) {
+                if ( !isEvent && strcmp(className, outletClassName) != 0 ) break;
+            } else {
+                if ( strcmp(className, runClassName) != 0 ) break;
+            }
+
+            ConnectionSortEntry entry = { members[end], isEvent, NULL };
+            run.push_back(entry);
+            end ++;
+        }
+
+        if ( run.size() > 1 ) {
+            for ( size_t i = 0; i < run.size(); i ++ ) {
+                run[i]._label = getLabel(run[i]._member->_obj);
+            }
+
+            std::stable_sort(run.begin(), run.end(), [](const ConnectionSortEntry &a, const ConnectionSortEntry &b) {
+                if ( a._isEvent != b._isEvent ) return a._isEvent;
+                return strcmp(a._label, b._label) < 0;
+            });
+
+            for ( size_t i = 0; i < run.size(); i ++ ) {
+                members[start + i] = run[i]._member;
+            }
+        }
+
+        start = end;
+    }
+}
+
+static const char *RuntimeConnectionLabel(XIBObject *connection)
+{
+    if ( strcmp(connection->_className, "UIRuntimeEventConnection") == 0 ) {
+        return ((UIRuntimeEventConnection *) connection)->_label;
+    } else if ( strcmp(connection->_className, "UIRuntimeOutletCollectionConnection") == 0 ) {
+        return ((UIRuntimeOutletCollectionConnection *) connection)->_label;
+    }
+
+    return ((UIRuntimeOutletConnection *) connection)->_label;
 }
 
 void NIBWriter::WriteObjects()
@@ -179,53 +281,8 @@ void NIBWriter::WriteObjects()
     nibRoot->AddMember("UINibKeyValuePairsKey", new XIBArray());
 
     AddOutputObject(nibRoot);
-    //  Sort connection records alphabetically using stable, uh, bubble sort
-    for ( ;; ) {
-        bool didSwap = false;
-
-        for ( memberList::iterator cur = _connections->_outputMembers.begin(); cur != _connections->_outputMembers.end(); cur ++ ) {
-            if ( (cur + 1) == _connections->_outputMembers.end() ) break;
-            XIBMember *curMember = (*cur);
-            XIBMember *nextMember = (*(cur + 1));
-
-            if ( strcmp(curMember->_name, "UINibEncoderEmptyKey") != 0 ) continue;
-
-            //  Event connections first
-            if ( strcmp(curMember->_obj->_className, "UIRuntimeOutletConnection") == 0 &&
-                 strcmp(nextMember->_obj->_className, "UIRuntimeEventConnection") == 0 ) {
-                *cur = nextMember;
-                *(cur + 1) = curMember;
-                didSwap = true;
-                continue;
-            }
-
-            if ( strcmp(curMember->_obj->_className, nextMember->_obj->_className) == 0 ) {
-                const char *label1, *label2;
-
-                if ( strcmp(curMember->_obj->_className, "UIRuntimeEventConnection") == 0 ) {
-                    UIRuntimeEventConnection *conn1 = (UIRuntimeEventConnection *) curMember->_obj;
-                    UIRuntimeEventConnection *conn2 = (UIRuntimeEventConnection *) nextMember->_obj;
-
-                    label1 = conn1->_label;
-                    label2 = conn2->_label;
-                } else {
-                    UIRuntimeOutletConnection *conn1 = (UIRuntimeOutletConnection *) curMember->_obj;
-                    UIRuntimeOutletConnection *conn2 = (UIRuntimeOutletConnection *) nextMember->_obj;
-
-                    label1 = conn1->_label;
-                    label2 = conn2->_label;
-                }
-
-                if ( strcmp(label1, label2) > 0 ) {
-                    *cur = nextMember;
-                    *(cur + 1) = curMember;
-                    didSwap = true;
-                }
-            }
-        }
-
-        if ( !didSwap ) break;
-    }
+    SortConnections(_connections->_outputMembers, "UINibEncoderEmptyKey", "UIRuntimeEventConnection",
+                    "UIRuntimeOutletConnection", RuntimeConnectionLabel);
 
     WriteData();
 }
@@ -238,14 +295,14 @@ void NIBWriter::AddOutletConnection(XIBObject *src, XIBObject *dst, char *propNa
     newConn->_destination = dst;
     newConn->_label = strdup(propName);
 
-    _connections->AddMember(NULL, newConn);
+    AddConnection(newConn);
 }
 
 XIBObject *NIBWriter::AddProxy(char *propName)
 {
     UIProxyObject *newProxy = new UIProxyObject();
     newProxy->_identifier = strdup(propName);
-    _allUIObjects->AddMember(NULL, newProxy);
+    AddUIObject(newProxy);
     _topObjects->AddMember(NULL, newProxy);
 
     ProxiedObject *newProxiedObj = new ProxiedObject();
@@ -253,17 +310,16 @@ XIBObject *NIBWriter::AddProxy(char *propName)
     newProxiedObj->_proxyObj = newProxy;
     newProxiedObj->_name = newProxy->_identifier;
     _proxies.push_back(newProxiedObj);
+    _proxiesByName.emplace(newProxiedObj->_name, newProxy);
 
     return newProxy;
 }
 
 XIBObject *NIBWriter::FindProxy(char *propName)
 {
-    for ( proxyList::iterator cur = _proxies.begin(); cur != _proxies.end(); cur ++ ) {
-        ProxiedObject *curProxy = *cur;
-        if ( strcmp(curProxy->_name, propName) == 0 ) {
-            return curProxy->_proxyObj;
-        }
+    auto found = _proxiesByName.find(propName);
+    if ( found != _proxiesByName.end() ) {
+        return found->second;
     }
 
     return NULL;
@@ -271,13 +327,10 @@ XIBObject *NIBWriter::FindProxy(char *propName)
 
 XIBObject *NIBWriter::GetProxyFor(XIBObject *obj)
 {
-    //  Go through current proxies
-    for ( proxyList::iterator cur = _proxies.begin(); cur != _proxies.end(); cur ++ ) {
-        ProxiedObject *curObj = *cur;
-
-        if ( curObj->_obj == obj ) {
-            return curObj->_proxyObj;
-        }
+    //  Check the current proxies
+    auto found = _proxiesByObject.find(obj);
+    if ( found != _proxiesByObject.end() ) {
+        return found->second;
     }
 
     UIProxyObject *newProxy = new UIProxyObject();
@@ -286,7 +339,7 @@ XIBObject *NIBWriter::GetProxyFor(XIBObject *obj)
     if ( curPlaceholder == 2 ) curPlaceholder ++;
     sprintf(szName, "UpstreamPlaceholder-%d", curPlaceholder ++);
     newProxy->_identifier = strdup(szName);
-    _allUIObjects->AddMember(NULL, newProxy);
+    AddUIObject(newProxy);
     _topObjects->AddMember(NULL, newProxy);
 
     ProxiedObject *newProxiedObj = new ProxiedObject();
@@ -294,6 +347,8 @@ XIBObject *NIBWriter::GetProxyFor(XIBObject *obj)
     newProxiedObj->_proxyObj = newProxy;
     newProxiedObj->_name = newProxy->_identifier;
     _proxies.push_back(newProxiedObj);
+    _proxiesByObject.emplace(obj, newProxy);
+    _proxiesByName.emplace(newProxiedObj->_name, newProxy);
 
     XIBObjectString *key = new XIBObjectString(strdup(szName));
     _externalReferencesDictionary->AddObjectForKey(key, obj);
@@ -301,7 +356,7 @@ XIBObject *NIBWriter::GetProxyFor(XIBObject *obj)
     return newProxy;
 }
 
-std::map<std::string, std::string> _g_exportedControllers;
+thread_local std::map<std::string, std::string> _g_exportedControllers;
 
 void NIBWriter::ExportController(const char *controllerId)
 {
@@ -320,7 +375,8 @@ void NIBWriter::ExportController(const char *controllerId)
     XIBArray *objects = (XIBArray *) controller->_parent;
 
     printf("Writing %s\n", GetOutputFilename(szFilename).c_str());
-    FILE *fpOut = fopen(GetOutputFilename(szFilename).c_str(), "wb");
+    OutputFile output(GetOutputFilename(szFilename));
+    FILE *fpOut = output.Open();
 
     NIBWriter *writer = new NIBWriter(fpOut, NULL, NULL);
 
@@ -342,50 +398,54 @@ void NIBWriter::ExportController(const char *controllerId)
 
     writer->WriteObjects();
 
-    fclose(fpOut);
+    output.Commit();
 }
 
 void NIBWriter::WriteData()
 {
-    fwrite("NIBArchive", 10, 1, fpOut);
-    int headerPos = ftell(fpOut);
+    _outputBuffer = (unsigned char *) malloc(c_outputBufferSize);
+    _outputBuffered = 0;
+    _outputPos = ftell(fpOut);
+
+    WriteBytes((void *) "NIBArchive", 10);
+    long headerPos = _outputPos;
 
     NIBHeader header = { 0 };
-    fwrite(&header, sizeof(header), 1, fpOut);
+    WriteBytes(&header, sizeof(header));
 
 
     //  Write out class names
     StringCombiner classNames;
-    header._classNamesOffset = ftell(fpOut);
+    header._classNamesOffset = _outputPos;
 
     for ( int i = 0; i < _outputObjects.size(); i ++ ) {
         XIBObject *pObject = _outputObjects[i];
         if (pObject->_outputClassName == NULL) {
-            printf("Unable to find class mapping for required object <%s>\n", pObject->_node.name());
             TELEMETRY_EVENT_DATA(L"MissingClassMapping", pObject->_node.name());
-            TELEMETRY_FLUSH();
-            exit(-1);
+            free(_outputBuffer);
+            _outputBuffer = NULL;
+            throw NIBWriterError(std::string("Unable to find class mapping for required object <") + pObject->_node.name() + ">");
         }
         pObject->_outputClassNameIdx = classNames.AddString(pObject->_outputClassName);
         pObject->_outputObjectIdx = i;
     }
 
-    for ( int i = 0; i < classNames._numStrings; i ++ ) {
-        char *pName = classNames._stringTable[i];
+    for ( size_t i = 0; i < classNames._stringTable.size(); i ++ ) {
+        const char *pName = classNames._stringTable[i];
         int len = strlen(pName) + 1;
         WriteInt(len, 2);
         if ( len == 0x1b ) {
             int filler = 6;
-            fwrite(&filler, 1, 4, fpOut);
+            WriteBytes(&filler, 4);
         }
-        fwrite(pName, 1, len, fpOut);
+        WriteBytes((void *) pName, len);
 
         header._numClassNames ++;
     }
 
     //  Write out key names
     StringCombiner keyNames;
-    header._keyNamesOffset = ftell(fpOut);
+    header._keyNamesOffset = _outputPos;
     for ( int i = 0; i < _outputObjects.size(); i ++ ) {
         XIBObject *pObject = _outputObjects[i];
 
@@ -394,17 +454,17 @@ void NIBWriter::WriteData()
         }
     }
 
-    for ( int i = 0; i < keyNames._numStrings; i ++ ) {
-        char *pName = keyNames._stringTable[i];
+    for ( size_t i = 0; i < keyNames._stringTable.size(); i ++ ) {
+        const char *pName = keyNames._stringTable[i];
         int len = strlen(pName) + 1;
         WriteInt(len, 1);
-        fwrite(pName, 1, len, fpOut);
+        WriteBytes((void *) pName, len);
 
         header._numKeyNames ++;
     }
 
     //  Write out items
-    header._itemsOffset = ftell(fpOut);
+    header._itemsOffset = _outputPos;
     for ( int i = 0; i < _outputObjects.size(); i ++ ) {
         XIBObject *pObject = _outputObjects[i];
 
@@ -429,7 +489,7 @@ void NIBWriter::WriteData()
     }
 
     //  Write out objects
-    header._objectsOffset = ftell(fpOut);
+    header._objectsOffset = _outputPos;
     for ( int i = 0; i < _outputObjects.size(); i ++ ) {
         XIBObject *pObject = _outputObjects[i];
 
@@ -445,7 +505,11 @@ void NIBWriter::WriteData()
         header._numObjects ++;
     }
 
+    FlushOutput();
+    free(_outputBuffer);
+    _outputBuffer = NULL;
+
+    //  The offsets are known now; go back and fill in the header
     fseek(fpOut, headerPos, SEEK_SET);
     fwrite(&header, sizeof(header), 1, fpOut);
 }
-
@@ -18,6 +18,10 @@
 #define __NIBWRITER_H
 
 #include <stdio.h>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include "XIBObject.h"
 
 #define NIBOBJ_INT8     0x00
@@ -32,6 +36,14 @@
 #define NIBOBJ_NULL     0x09
 #define NIBOBJ_UID      0x0A
 
+//  Thrown when a document cannot be written as a nib; the conversion of that document is abandoned, and its partly
+//  written outputs are removed as they unwind
+class NIBWriterError : public std::runtime_error {
+public:
+    explicit NIBWriterError(const std::string& what) : std::runtime_error(what) {
+    }
+};
+
 class ProxiedObject
 {
 public:
@@ -42,13 +54,28 @@ public:
 typedef std::vector<ProxiedObject *> proxyList;
 class XIBDictionary;
 
+typedef const char *(*ConnectionLabelFunc)(XIBObject *connection);
+
 class NIBWriter
 {
 private:
     xibList _outputObjects; 
+    std::unordered_set<XIBObject *> _outputObjectSet;
+    std::unordered_set<XIBObject *> _uiObjectSet;
     proxyList _proxies;
+    std::unordered_map<XIBObject *, XIBObject *> _proxiesByObject;
+    std::unordered_map<std::string, XIBObject *> _proxiesByName;
     FILE *fpOut;
 
+    //  WriteData stages its output here and hands it to fpOut in large writes; _outputPos is the file offset of the
+    //  next byte written
+    static const int c_outputBufferSize = 64 * 1024;
+    unsigned char *_outputBuffer;
+    int _outputBuffered;
+    long _outputPos;
+
+    void FlushOutput();
+
 public:
     XIBObject *_allUIObjects;
     XIBObject *_connections;
@@ -63,7 +90,11 @@ public:
     NIBWriter(FILE *out, XIBDictionary *externalRefsDict, XIBObject *base);
 
     static void ExportController(const char *controllerId);
+    static void SortConnections(memberList &members, const char *sortedName, const char *eventClassName,
+                                const char *outletClassName, ConnectionLabelFunc getLabel);
     void ExportObject(XIBObject *obj);
+    void AddUIObject(XIBObject *obj);
+    void AddConnection(XIBObject *connection);
     void WriteObjects();
     XIBObject *AddOutputObject(XIBObject *pObj);
     void WriteData();
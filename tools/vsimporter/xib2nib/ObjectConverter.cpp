@@ -65,7 +65,7 @@
 #include "UISwipeGestureRecognizer.h"
 #include <assert.h>
 
-#include "..\WBITelemetry\WBITelemetry.h"
+#include "../WBITelemetry/WBITelemetry.h"
 
 #define IS_CONVERTER(newinst, classnamevar, name, type) \
     if (strcmp(classnamevar, name) == 0) {              \
@@ -266,7 +266,7 @@ void ObjectConverterSwapper::InitFromStory(XIBObject* obj) {
 
 void ObjectConverterSwapper::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj) {
     if (!_ignoreUIObject)
-        writer->_allUIObjects->AddMember(NULL, this);
+        writer->AddUIObject(this);
     ObjectConverter::ConvertStaticMappings(writer, obj);
 
     if (obj->_swappedClassName) {
@@ -286,7 +286,7 @@ void ObjectConverterSwapper::ConvertStaticMappings(NIBWriter* writer, XIBObject*
                 newOutlet->_label = cur->_label;
                 newOutlet->_source = cur->_source;
                 newOutlet->_destination = cur->_destination;
-                writer->_connections->AddMember(NULL, newOutlet);
+                writer->AddConnection(newOutlet);
                 writer->AddOutputObject(newOutlet);
             } else if (strcmp(curObj->_outputClassName, "UIRuntimeEventConnection") == 0) {
                 UIRuntimeEventConnection* cur = (UIRuntimeEventConnection*)curObj;
@@ -296,7 +296,7 @@ void ObjectConverterSwapper::ConvertStaticMappings(NIBWriter* writer, XIBObject*
                 newOutlet->_source = cur->_source;
                 newOutlet->_destination = cur->_destination;
                 newOutlet->_eventMask = cur->_eventMask;
-                writer->_connections->AddMember(NULL, newOutlet);
+                writer->AddConnection(newOutlet);
                 writer->AddOutputObject(newOutlet);
             } else if (strcmp(curObj->_outputClassName, "UIRuntimeOutletCollectionConnection") == 0) {
                 UIRuntimeOutletCollectionConnection* cur = (UIRuntimeOutletCollectionConnection*)curObj;
@@ -305,7 +305,7 @@ void ObjectConverterSwapper::ConvertStaticMappings(NIBWriter* writer, XIBObject*
                 newOutlet->_label = cur->_label;
                 newOutlet->_source = cur->_source;
                 newOutlet->_destination = cur->_destination;
-                writer->_connections->AddMember(NULL, newOutlet);
+                writer->AddConnection(newOutlet);
                 writer->AddOutputObject(newOutlet);
             } else {
                 assert(0);
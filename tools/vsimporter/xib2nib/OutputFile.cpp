@@ -0,0 +1,59 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include "OutputFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+OutputFile::OutputFile(const std::string& path) : _path(path), _tempPath(path + ".partial"), _fp(NULL), _committed(false) {
+}
+
+OutputFile::~OutputFile() {
+    if (_fp) {
+        fclose(_fp);
+    }
+    if (!_committed) {
+        remove(_tempPath.c_str());
+    }
+}
+
+FILE* OutputFile::Open() {
+    _fp = fopen(_tempPath.c_str(), "wb");
+    return _fp;
+}
+
+const std::string& OutputFile::TempPath() const {
+    return _tempPath;
+}
+
+bool OutputFile::Commit() {
+    if (_fp) {
+        bool closed = fclose(_fp) == 0;
+        _fp = NULL;
+        if (!closed) {
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    _committed = MoveFileExA(_tempPath.c_str(), _path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    _committed = rename(_tempPath.c_str(), _path.c_str()) == 0;
+#endif
+    return _committed;
+}
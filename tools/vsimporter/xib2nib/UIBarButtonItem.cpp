@@ -111,7 +111,7 @@ void UIBarButtonItem::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj) {
                 newEvent->_label = "perform:";
                 newEvent->_source = this;
                 newEvent->_destination = segue;
-                writer->_connections->AddMember(NULL, newEvent);
+                writer->AddConnection(newEvent);
                 writer->AddOutputObject(newEvent);
 
                 // AddOutputMember(writer, "UIOutlet", refObj);
@@ -290,7 +290,7 @@ void UIButton::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj) {
                 newEvent->_source = this;
                 newEvent->_destination = segue;
                 newEvent->_eventMask = 0x40;
-                writer->_connections->AddMember(NULL, newEvent);
+                writer->AddConnection(newEvent);
                 writer->AddOutputObject(newEvent);
             }
         }
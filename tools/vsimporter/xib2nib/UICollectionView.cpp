@@ -36,7 +36,7 @@ void UICollectionView::InitFromStory(XIBObject *obj)
 
 void UICollectionView::ConvertStaticMappings(NIBWriter *writer, XIBObject *obj)
 {
-    writer->_allUIObjects->AddMember(NULL, this);
+    writer->AddUIObject(this);
     UIView::ConvertStaticMappings(writer, obj);
 }
 
@@ -41,7 +41,7 @@ void UICollectionReusableView::Awaken()
 
 void UICollectionReusableView::ConvertStaticMappings(NIBWriter *writer, XIBObject *obj)
 {
-    writer->_allUIObjects->AddMember(NULL, this);
+    writer->AddUIObject(this);
 
     UIView::ConvertStaticMappings(writer, obj);
 }
@@ -84,7 +84,7 @@ void UICollectionViewCell::Awaken()
 
 void UICollectionViewCell::ConvertStaticMappings(NIBWriter *writer, XIBObject *obj)
 {
-    writer->_allUIObjects->AddMember(NULL, this);
+    writer->AddUIObject(this);
     if (_contentView) {
         _contentView->setFrame(getFrame());
         _contentView->_opaque = true;
@@ -92,7 +92,7 @@ void UICollectionViewCell::ConvertStaticMappings(NIBWriter *writer, XIBObject *o
         for (int i = 0; i < count; i++) {
             UIView *curObj = (UIView *)_contentView->_subviews->objectAtIndex(i);
             //curObj->_bounds.height  = _contentView->_bounds.height;
-            writer->_allUIObjects->AddMember(NULL, curObj);
+            writer->AddUIObject(curObj);
         }
         _contentView->_ignoreUIObject = true;
     }
@@ -50,7 +50,7 @@ void UIProxyObject::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj) {
                 newOutlet->_label = cur->_label;
                 newOutlet->_source = cur->_source;
                 newOutlet->_destination = cur->_destination;
-                writer->_connections->AddMember(NULL, newOutlet);
+                writer->AddConnection(newOutlet);
                 writer->AddOutputObject(newOutlet);
             } else if (strcmp(curObj->_outputClassName, "UIRuntimeEventConnection") == 0) {
                 UIRuntimeEventConnection* cur = (UIRuntimeEventConnection*)curObj;
@@ -60,14 +60,14 @@ void UIProxyObject::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj) {
                 newOutlet->_source = cur->_source;
                 newOutlet->_destination = cur->_destination;
                 newOutlet->_eventMask = cur->_eventMask;
-                writer->_connections->AddMember(NULL, newOutlet);
+                writer->AddConnection(newOutlet);
                 writer->AddOutputObject(newOutlet);
             } else {
                 assert(0);
             }
         }
     }
-    writer->_allUIObjects->AddMember(NULL, obj);
+    writer->AddUIObject(obj);
 
     AddString(writer, "UIProxiedObjectIdentifier", _identifier);
     ObjectConverter::ConvertStaticMappings(writer, obj);
@@ -61,7 +61,7 @@ void UITableViewCell::Awaken() {
 }
 
 void UITableViewCell::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj) {
-    writer->_allUIObjects->AddMember(NULL, this);
+    writer->AddUIObject(this);
     if (_contentView) {
         _contentView->setFrame(getFrame());
         _contentView->_opaque = true;
@@ -69,7 +69,7 @@ void UITableViewCell::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj) {
         for (int i = 0; i < count; i++) {
             UIView* curObj = (UIView*)_contentView->_subviews->objectAtIndex(i);
             // curObj->_bounds.height  = _contentView->_bounds.height;
-            writer->_allUIObjects->AddMember(NULL, curObj);
+            writer->AddUIObject(curObj);
         }
         _contentView->_ignoreUIObject = true;
     }
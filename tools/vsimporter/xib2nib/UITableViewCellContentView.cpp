@@ -41,7 +41,7 @@ void UITableViewCellContentView::Awaken()
 
 void UITableViewCellContentView::ConvertStaticMappings(NIBWriter *writer, XIBObject *obj)
 {
-    writer->_allUIObjects->AddMember(NULL, this);
+    writer->AddUIObject(this);
 
     UIView::ConvertStaticMappings(writer, obj);
 }
@@ -38,6 +38,6 @@ public:
     UITextView();
     virtual void InitFromXIB(XIBObject *obj);
     virtual void ConvertStaticMappings(NIBWriter *writer, XIBObject *obj);
-    virtual void UITextView::InitFromStory(XIBObject *obj);
+    virtual void InitFromStory(XIBObject *obj);
 };
 
@@ -243,7 +243,7 @@ void UIView::InitFromStory(XIBObject* obj) {
 
 void UIView::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj) {
     if (!_ignoreUIObject)
-        writer->_allUIObjects->AddMember(NULL, this);
+        writer->AddUIObject(this);
 
     if (_connections) {
         for (int i = 0; i < _connections->count(); i++) {
@@ -255,7 +255,7 @@ void UIView::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj) {
                 newOutlet->_label = cur->_label;
                 newOutlet->_source = cur->_source;
                 newOutlet->_destination = cur->_destination;
-                writer->_connections->AddMember(NULL, newOutlet);
+                writer->AddConnection(newOutlet);
                 writer->AddOutputObject(newOutlet);
             }
         }
@@ -266,7 +266,7 @@ void UIView::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj) {
         for (int i = 0; i < count; i++) {
             XIBObject* curObj = _subviews->objectAtIndex(i);
             if (!curObj->_ignoreUIObject)
-                writer->_allUIObjects->AddMember(NULL, curObj);
+                writer->AddUIObject(curObj);
         }
     }
 
@@ -18,6 +18,7 @@
 #include "UIStoryboardSegue.h"
 #include "UINavigationItem.h"
 #include "UITabBarItem.h"
+#include "OutputFile.h"
 #include <assert.h>
 
 static PropertyMapper propertyMappings[] = {
@@ -130,7 +131,8 @@ void UIViewController::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj)
             char szOutputName[255];
             sprintf(szOutputName, "%s.nib", szNibName);
             printf("Writing %s\n", GetOutputFilename(szOutputName).c_str());
-            FILE* fpOut = fopen(GetOutputFilename(szOutputName).c_str(), "wb");
+            OutputFile output(GetOutputFilename(szOutputName));
+            FILE* fpOut = output.Open();
 
             NIBWriter* viewWriter = new NIBWriter(fpOut, externalObjects, _view);
             viewWriter->ExportObject(_view);
@@ -144,7 +146,7 @@ void UIViewController::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj)
             viewWriter->AddOutletConnection(ownerProxy, _view, "view");
 
             viewWriter->WriteObjects();
-            fclose(fpOut);
+            output.Commit();
 
             if (externalObjects->_members.size() > 1)
                 AddOutputMember(writer, "UIExternalObjectsTableForViewLoading", externalObjects);
@@ -17,6 +17,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <string>
+#include <unordered_map>
 #include "XIBObject.h"
 #include "NIBWriter.h"
 #include "XIBObjectTypes.h"
@@ -66,7 +68,12 @@ XIBMember::XIBMember() {
     _obj = NULL;
 }
 
-xibList XIBObject::_allObjs;
+thread_local xibList XIBObject::_allObjs;
+
+//  findReference's index of _allObjs by id. Objects are added as they're first looked past, and the earliest object
+//  with a given id wins, the same as searching _allObjs in order.
+static thread_local std::unordered_map<std::string, XIBObject*> _objsById;
+static thread_local size_t _numIndexedObjs = 0;
 
 void XIBObject::AddOutputMember(NIBWriter* writer, const char* keyName, XIBObject* obj) {
     XIBMember* pNewMember = new XIBMember();
@@ -344,6 +351,10 @@ void XIBObject::AddMember(const char* keyName, XIBObject* member) {
         }
     }
 
+    AppendMember(keyName, member);
+}
+
+void XIBObject::AppendMember(const char* keyName, XIBObject* member) {
     XIBMember* newMember = new XIBMember();
     newMember->_name = keyName;
     newMember->_obj = member;
@@ -531,18 +542,31 @@ void XIBObject::ResolveReferences() {
 }
 
 XIBObject* XIBObject::findReference(const char* id) {
-    xibList::iterator cur = _allObjs.begin();
+    if (id == NULL)
+        return NULL;
 
-    for (; cur != _allObjs.end(); cur++) {
-        if ((*cur)->_id == NULL)
-            continue;
-        if (strcmp((*cur)->_id, id) == 0)
-            return (*cur);
+    for (; _numIndexedObjs < _allObjs.size(); _numIndexedObjs++) {
+        XIBObject* cur = _allObjs[_numIndexedObjs];
+        if (cur->_id != NULL) {
+            _objsById.emplace(cur->_id, cur);
+        }
     }
 
+    auto found = _objsById.find(id);
+    if (found != _objsById.end())
+        return found->second;
+
     return NULL;
 }
 
+//  Forgets every object scanned so far, so another document can be converted in the same process
+void XIBObject::ResetAllObjects() {
+    _allObjs.clear();
+    _objsById.clear();
+    _numIndexedObjs = 0;
+    _handledNodes.clear();
+}
+
 void XIBObject::ParseAllXIBMembers() {
     xibList::iterator cur = _allObjs.begin();
 
@@ -600,7 +624,7 @@ void XIBObject::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj) {
 void XIBObject::Awaken() {
 }
 
-std::unordered_set<size_t> XIBObject::_handledNodes;
+thread_local std::unordered_set<size_t> XIBObject::_handledNodes;
 
 void XIBObject::setNodeHandled(pugi::xml_node node) {
     _handledNodes.insert(node.hash_value());
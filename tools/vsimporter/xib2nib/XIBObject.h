@@ -73,7 +73,8 @@ public:
     XIBObject* _parent;
     xibList _variations;
 
-    static xibList _allObjs;
+    //  Conversion state is per thread, so a batch can convert several documents at once
+    static thread_local xibList _allObjs;
     bool _ignoreUIObject;
 
 public:
@@ -87,6 +88,7 @@ public:
     void ScanXIBNode(pugi::xml_node node);
     void ScanStoryObjects(pugi::xml_node node);
     void AddMember(const char* keyName, XIBObject* member);
+    void AppendMember(const char* keyName, XIBObject* member);
     void AddOutputMember(NIBWriter* writer, const char* keyName, XIBObject* obj);
 
     virtual void InitFromXIB(XIBObject* obj);
@@ -113,6 +115,7 @@ public:
     void ResolveReferences();
 
     static XIBObject* findReference(const char* id);
+    static void ResetAllObjects();
     static void ParseAllXIBMembers();
     static void ParseAllStoryMembers();
 
@@ -131,7 +134,7 @@ public:
     void AddInt(NIBWriter* writer, char* pPropName, int val);
     void AddBool(NIBWriter* writer, char* pPropName, bool val);
 
-    static std::unordered_set<size_t> _handledNodes;
+    static thread_local std::unordered_set<size_t> _handledNodes;
     static void setNodeHandled(pugi::xml_node node);
     static void setAttrHandled(pugi::xml_attribute attr);
     static void setMemberHandled(XIBObject* member);
@@ -0,0 +1,218 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+// Times storyboard conversion over generated storyboards of increasing size.
+//
+// Usage: Xib2NibBenchmark <outputdir> [objectcount ...]
+//
+// Each size is converted twice: split into scenes of 100 rows, with a segue from the initial scene to every other one,
+// and as a single scene. A scene's view holds rows of a label and a button; the view controller has an outlet to each
+// label and each button sends an action to the view controller, so every nib written has a long connection list and
+// a proxy for its owner.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#define mkdir(path, mode) _mkdir(path)
+#endif
+
+#include "../XIBObject.h"
+#include "../XIBObjectTypes.h"
+#include "../NIBWriter.h"
+
+typedef std::chrono::high_resolution_clock BenchmarkClock;
+
+static const int c_rowsPerScene = 100;
+static const int c_oneScene = 0;
+
+// Storyboard objects per row: a container view, its subviews array, label, button, the button's connections array and
+// action, and the view controller's outlet to the label
+static const int c_objectsPerRow = 7;
+
+static std::string _outputDirectory;
+std::string GetOutputFilename(const char* filename) {
+    return _outputDirectory + "/" + filename;
+}
+
+extern thread_local std::map<std::string, std::string> _g_exportedControllers;
+
+static void AppendScene(std::string& xml, int scene, int rows, int sceneCount) {
+    char buffer[512];
+
+    snprintf(buffer,
+             sizeof(buffer),
+             "<scene sceneID=\"scene-%d\"><objects><viewController id=\"vc-%d\" sceneMemberID=\"viewController\">"
+             "<view key=\"view\" contentMode=\"scaleToFill\" id=\"view-%d\">"
+             "<rect key=\"frame\" x=\"0.0\" y=\"0.0\" width=\"320\" height=\"568\"/><subviews>",
+             scene,
+             scene,
+             scene);
+    xml += buffer;
+
+    for (int row = 0; row < rows; row++) {
+        snprintf(buffer,
+                 sizeof(buffer),
+                 "<view contentMode=\"scaleToFill\" id=\"row-%d-%d\"><rect key=\"frame\" x=\"0.0\" y=\"%d\" width=\"320\" height=\"44\"/>"
+                 "<subviews><label text=\"Row %d\" id=\"label-%d-%d\"/>"
+                 "<button buttonType=\"roundedRect\" id=\"button-%d-%d\"><connections>"
+                 "<action selector=\"tapRow%d:\" destination=\"vc-%d\" eventType=\"touchUpInside\" id=\"action-%d-%d\"/>"
+                 "</connections></button></subviews></view>",
+                 scene,
+                 row,
+                 row * 44,
+                 row,
+                 scene,
+                 row,
+                 scene,
+                 row,
+                 row,
+                 scene,
+                 scene,
+                 row);
+        xml += buffer;
+    }
+
+    //  The initial scene leads to all of the others
+    if (scene == 0) {
+        for (int destination = 1; destination < sceneCount; destination++) {
+            snprintf(buffer,
+                     sizeof(buffer),
+                     "<button buttonType=\"roundedRect\" id=\"open-%d\"><connections>"
+                     "<segue destination=\"vc-%d\" kind=\"push\" identifier=\"open-%d\" id=\"segue-%d\"/>"
+                     "</connections></button>",
+                     destination,
+                     destination,
+                     destination,
+                     destination);
+            xml += buffer;
+        }
+    }
+
+    xml += "</subviews></view><connections>";
+    for (int row = 0; row < rows; row++) {
+        snprintf(buffer,
+                 sizeof(buffer),
+                 "<outlet property=\"rowLabel%d\" destination=\"label-%d-%d\" id=\"outlet-%d-%d\"/>",
+                 row,
+                 scene,
+                 row,
+                 scene,
+                 row);
+        xml += buffer;
+    }
+    xml += "</connections></viewController></objects></scene>";
+}
+
+static std::string GenerateStoryboard(int objectCount, int rowsPerScene) {
+    int rows = (objectCount + c_objectsPerRow - 1) / c_objectsPerRow;
+    if (rowsPerScene == c_oneScene) {
+        rowsPerScene = rows;
+    }
+    int sceneCount = (rows + rowsPerScene - 1) / rowsPerScene;
+
+    std::string xml =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n"
+        "<document type=\"com.apple.InterfaceBuilder3.CocoaTouch.Storyboard.XIB\" version=\"3.0\" initialViewController=\"vc-0\">"
+        "<scenes>";
+    for (int scene = 0; scene < sceneCount; scene++) {
+        int sceneRows = rows - scene * rowsPerScene;
+        AppendScene(xml, scene, sceneRows < rowsPerScene ? sceneRows : rowsPerScene, sceneCount);
+    }
+    xml += "</scenes></document>\n";
+
+    return xml;
+}
+
+static double MillisecondsSince(BenchmarkClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(BenchmarkClock::now() - start).count();
+}
+
+// Mirrors ConvertStoryboard in xib2nib.cpp, less the document coverage report and Info.plist
+static void ConvertGeneratedStoryboard(int objectCount, int rowsPerScene) {
+    std::string xml = GenerateStoryboard(objectCount, rowsPerScene);
+
+    auto start = BenchmarkClock::now();
+    pugi::xml_document doc;
+    if (!doc.load_buffer(xml.data(), xml.size())) {
+        printf("Unable to parse the generated storyboard\n");
+        exit(2);
+    }
+
+    pugi::xml_node rootNode = doc.first_child();
+    for (pugi::xml_node curNode = rootNode; curNode; curNode = curNode.next_sibling()) {
+        if (curNode.type() == pugi::xml_node_type::node_element) {
+            XIBArray* root = new XIBArray();
+            root->ScanStoryObjects(curNode);
+        }
+    }
+    XIBObject::ParseAllStoryMembers();
+    double parseMs = MillisecondsSince(start);
+    size_t scannedObjects = XIBObject::_allObjs.size();
+
+    start = BenchmarkClock::now();
+    NIBWriter::ExportController(rootNode.attribute("initialViewController").value());
+    double writeMs = MillisecondsSince(start);
+
+    printf("%6d objects (%6d scanned) %-15s: parse %9.1f ms, write %9.1f ms, %3d nibs\n",
+           objectCount,
+           (int)scannedObjects,
+           rowsPerScene == c_oneScene ? "in one scene" : "in many scenes",
+           parseMs,
+           writeMs,
+           (int)_g_exportedControllers.size() * 2);
+    fflush(stdout);
+
+    XIBObject::ResetAllObjects();
+    _g_exportedControllers.clear();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printf("Usage: Xib2NibBenchmark <outputdir> [objectcount ...]\n");
+        return 1;
+    }
+
+    _outputDirectory = argv[1];
+    struct stat st = { 0 };
+    if (stat(argv[1], &st) != 0 && mkdir(argv[1], 0777) != 0) {
+        printf("Unable to create directory %s err=%d\n", argv[1], errno);
+        return 1;
+    }
+
+    std::vector<int> objectCounts = { 1000, 10000, 50000 };
+    if (argc > 2) {
+        objectCounts.clear();
+        for (int i = 2; i < argc; i++) {
+            objectCounts.push_back(atoi(argv[i]));
+        }
+    }
+
+    for (int objectCount : objectCounts) {
+        ConvertGeneratedStoryboard(objectCount, c_rowsPerScene);
+        ConvertGeneratedStoryboard(objectCount, c_oneScene);
+    }
+
+    return 0;
+}
@@ -30,17 +30,19 @@
 #include "XIBDocument.h"
 #include "NIBWriter.h"
 #include "Plist.hpp"
+#include "OutputFile.h"
+#include "BatchConversion.h"
 
-#include "..\WBITelemetry\WBITelemetry.h"
+#include "../WBITelemetry/WBITelemetry.h"
 
-static char _g_outputDirectory[4096];
+static thread_local std::string _g_outputDirectory;
 std::string GetOutputFilename(const char* filename) {
-    std::string ret = std::string(_g_outputDirectory) + "\\" + std::string(filename);
+    std::string ret = _g_outputDirectory + "\\" + std::string(filename);
 
     return ret;
 }
 
-extern std::map<std::string, std::string> _g_exportedControllers;
+extern thread_local std::map<std::string, std::string> _g_exportedControllers;
 
 void ConvertStoryboard(pugi::xml_document& doc) {
     pugi::xml_node curNode = doc.first_child();
@@ -73,8 +75,10 @@ void ConvertStoryboard(pugi::xml_document& doc) {
     }
     viewControllerInfo[std::string("UIViewControllerIdentifiersToNibNames")] = viewControllerMappings;
 
+    OutputFile infoPlist(GetOutputFilename("Info.plist"));
     printf("Writing %s\n", GetOutputFilename("Info.plist").c_str());
-    Plist::writePlistBinary(GetOutputFilename("Info.plist").c_str(), viewControllerInfo);
+    Plist::writePlistBinary(infoPlist.TempPath().c_str(), viewControllerInfo);
+    infoPlist.Commit();
 }
 
 void ConvertXIB3ToNib(FILE* fpOut, pugi::xml_document& doc) {
@@ -99,6 +103,11 @@ void ConvertXIB3ToNib(FILE* fpOut, pugi::xml_document& doc) {
         writer->WriteObjects();
     }
 }
+
+static const char* XIBConnectionLabel(XIBObject* connection) {
+    return connection->FindMember("label")->stringValue();
+}
+
 void ConvertXIBToNib(FILE* fpOut, pugi::xml_document& doc) {
     pugi::xml_node dataNode = doc.first_element_by_path("/archive/data");
 
@@ -166,43 +175,9 @@ void ConvertXIBToNib(FILE* fpOut, pugi::xml_document& doc) {
         }
     }
 
-    //  Sort connection records alphabetically using stable, uh, bubble sort
-    for (;;) {
-        bool didSwap = false;
-
-        for (memberList::iterator cur = connections->_members.begin(); cur != connections->_members.end(); cur++) {
-            if ((cur + 1) == connections->_members.end())
-                break;
-            XIBMember* curMember = (*cur);
-            XIBMember* nextMember = (*(cur + 1));
-
-            if (curMember->_name != NULL)
-                continue;
-
-            //  Event connections first
-            if (strcmp(curMember->_obj->_className, "IBCocoaTouchOutletConnection") == 0 &&
-                strcmp(nextMember->_obj->_className, "IBCocoaTouchEventConnection") == 0) {
-                *cur = nextMember;
-                *(cur + 1) = curMember;
-                didSwap = true;
-                continue;
-            }
-
-            if (strcmp(curMember->_obj->_className, nextMember->_obj->_className) == 0) {
-                const char* label1 = curMember->_obj->FindMember("label")->stringValue();
-                const char* label2 = nextMember->_obj->FindMember("label")->stringValue();
-
-                if (strcmp(label1, label2) > 0) {
-                    *cur = nextMember;
-                    *(cur + 1) = curMember;
-                    didSwap = true;
-                }
-            }
-        }
-
-        if (!didSwap)
-            break;
-    }
+    //  Sort connection records alphabetically
+    NIBWriter::SortConnections(
+        connections->_members, NULL, "IBCocoaTouchEventConnection", "IBCocoaTouchOutletConnection", XIBConnectionLabel);
 
     //  Construct root object
     XIBObject* rootObjects = root->FindMember("IBDocument.RootObjects");
@@ -230,84 +205,117 @@ void ConvertXIBToNib(FILE* fpOut, pugi::xml_document& doc) {
     writer->WriteData();
 }
 
-int main(int argc, char* argv[]) {
-#if 0
-    argv[1] = "input.xib";
-    argv[2] = "output.nib";
-    argc = 3;
-#endif
-
-    TELEMETRY_INIT(L"AIF-47606e3a-4264-4368-8f7f-ed6ec3366dca");
-
-    std::tr2::sys::path fName(argv[1]);
-
-    TELEMETRY_EVENT_DATA(L"Xib2NibStart", fName.filename());
-
+//  Converts one .xib or .storyboard, returning the exit code xib2nib uses for it
+static int ConvertFile(const char* inputPath, const char* outputPath) {
     pugi::xml_document doc;
-    pugi::xml_parse_result result = doc.load_file(argv[1]);
+    pugi::xml_parse_result result = doc.load_file(inputPath);
     if (!result) {
-        printf("Error opening %s\n", argv[1]);
-        TELEMETRY_FLUSH();
-        exit(2);
-        return -1;
+        printf("Error opening %s\n", inputPath);
+        return 2;
     }
 
     pugi::xml_node rootNode = doc.first_child();
     const char* type = getNodeAttrib(rootNode, "type");
     if (!type) {
         printf("Unable to find input type\n");
-        TELEMETRY_FLUSH();
-        exit(3);
-        return -1;
+        return 3;
     }
-    if (strcmp(rootNode.name(), "document") == 0 && strcmp(type, "com.apple.InterfaceBuilder3.CocoaTouch.Storyboard.XIB") == 0) {
-        if (argc < 3) {
-            printf("Usage: xib2nib input.storyboard <outputdir>\n");
-            TELEMETRY_FLUSH();
-            exit(1);
-            return -1;
-        }
 
-        struct stat st = { 0 };
-        stat(argv[2], &st);
-        if (!(((st.st_mode) & S_IFMT) == S_IFDIR) && _mkdir(argv[2]) != 0) {
-            printf("Unable to create directory %s err=%d\n", argv[2], errno);
-            return -1;
-        }
-        strcpy(_g_outputDirectory, argv[2]);
-        ConvertStoryboard(doc);
-    } else if (strstr(type, ".XIB") != NULL) {
-        if (argc < 3) {
-            printf("Usage: xib2nib input.xib output.nib\n");
-            TELEMETRY_FLUSH();
-            exit(1);
-            return -1;
-        }
+    //  A document that cannot be written fails on its own; outputs it had started are removed as the conversion
+    //  unwinds, and a batch carries on with its other inputs
+    int ret = 0;
+    try {
+        if (strcmp(rootNode.name(), "document") == 0 && strcmp(type, "com.apple.InterfaceBuilder3.CocoaTouch.Storyboard.XIB") == 0) {
+            struct stat st = { 0 };
+            stat(outputPath, &st);
+            if (!(((st.st_mode) & S_IFMT) == S_IFDIR) && _mkdir(outputPath) != 0) {
+                printf("Unable to create directory %s err=%d\n", outputPath, errno);
+                return -1;
+            }
+            _g_outputDirectory = outputPath;
+            ConvertStoryboard(doc);
+        } else if (strstr(type, ".XIB") != NULL) {
+            OutputFile output(outputPath);
+            FILE* fpOut = output.Open();
+            if (!fpOut) {
+                printf("Error opening %s\n", outputPath);
+                return 3;
+            }
 
-        FILE* fpOut = fopen(argv[2], "wb");
-        if (!fpOut) {
-            printf("Error opening %s\n", argv[2]);
-            TELEMETRY_FLUSH();
-            exit(3);
-            return -1;
+            if (strcmp(rootNode.name(), "document") == 0) {
+                ConvertXIB3ToNib(fpOut, doc);
+            } else {
+                ConvertXIBToNib(fpOut, doc);
+            }
+            output.Commit();
+        } else {
+            printf("Unable to determine input type type=\"%s\"\n", type);
+            ret = 4;
         }
+    } catch (const NIBWriterError& e) {
+        printf("%s\n", e.what());
+        ret = -1;
+    }
+
+    //  The next document on this thread starts from a clean slate
+    XIBObject::ResetAllObjects();
+    _g_exportedControllers.clear();
+    return ret;
+}
+
+static int ConvertBatchFromArgs(int argc, char* argv[]) {
+    const char* listPath = argv[2];
+    std::string manifestPath = std::string(listPath) + ".manifest";
+    int jobs = 0;
 
-        if (strcmp(rootNode.name(), "document") == 0) {
-            ConvertXIB3ToNib(fpOut, doc);
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--manifest") == 0 && i + 1 < argc) {
+            manifestPath = argv[++i];
         } else {
-            ConvertXIBToNib(fpOut, doc);
+            printf("Unknown option %s\n", argv[i]);
+            return 1;
         }
-        fclose(fpOut);
-    } else {
-        printf("Unable to determine input type type=\"%s\"\n", type);
-        TELEMETRY_FLUSH();
-        exit(4);
+    }
+
+    return ConvertBatch(listPath, manifestPath.c_str(), jobs, ConvertFile);
+}
+
+int main(int argc, char* argv[]) {
+#if 0
+    argv[1] = "input.xib";
+    argv[2] = "output.nib";
+    argc = 3;
+#endif
+
+    if (argc < 3) {
+        printf("Usage: xib2nib input.xib output.nib\n");
+        printf("       xib2nib input.storyboard <outputdir>\n");
+        printf("       xib2nib --batch <listfile> [--jobs <count>] [--manifest <file>]\n");
+        printf("\n");
+        printf("A batch list has one \"input<TAB>output\" pair per line. Inputs whose contents are unchanged since they\n");
+        printf("were last converted, according to the manifest (default <listfile>.manifest), are skipped.\n");
+        exit(1);
         return -1;
     }
 
-    TELEMETRY_EVENT_DATA(L"Xib2NibFinish", fName.filename());
+    TELEMETRY_INIT(L"AIF-47606e3a-4264-4368-8f7f-ed6ec3366dca");
+
+    std::tr2::sys::path fName(argv[1]);
+    bool batch = strcmp(argv[1], "--batch") == 0;
+    if (batch) {
+        fName = argv[2];
+    }
+
+    TELEMETRY_EVENT_DATA(batch ? L"Xib2NibBatchStart" : L"Xib2NibStart", fName.filename());
+
+    int ret = batch ? ConvertBatchFromArgs(argc, argv) : ConvertFile(argv[1], argv[2]);
+    if (ret == 0) {
+        TELEMETRY_EVENT_DATA(batch ? L"Xib2NibBatchFinish" : L"Xib2NibFinish", fName.filename());
+    }
 
     TELEMETRY_FLUSH();
 
-    exit(0);
+    exit(ret);
 }